@@ -19,6 +19,8 @@ typedef Uint32 (*AG_TimerFn)(struct ag_timer *_Nonnull, AG_Event *_Nonnull);
 typedef struct ag_timer_pvt {
 	AG_TAILQ_ENTRY(ag_timer) timers;
 	AG_TAILQ_ENTRY(ag_timer) change;
+	int heapIdx;			/* Index in software timer heap (or -1) */
+	Uint32 _pad;
 } AG_TimerPvt;
 
 typedef struct ag_timer {
@@ -37,6 +39,11 @@ typedef struct ag_timer {
 	char name[AG_TIMER_NAME_MAX];	/* Name string (optional) */
 } AG_Timer;
 
+#ifndef AG_TIMER_HEAP_INIT
+#define AG_TIMER_HEAP_INIT 32		/* Initial size of software timer heap */
+#endif
+#define AG_TIMEOUT_NONE 0xffffffff	/* No scheduled timer (AG_NextTimeout) */
+
 typedef struct ag_time_ops {
 	const char *_Nonnull name;
 
@@ -70,7 +77,7 @@ void AG_SetTimeOps(const AG_TimeOps *_Nullable);
 #ifdef AG_TIMERS
 /*
  * Managed timers which can be owned by objects and mapped to either
- * kernel/hardware timers, or entries in a software timing wheel.
+ * kernel/hardware timers, or entries in a software timer heap.
  */
 extern struct ag_objectq       agTimerObjQ;
 extern Uint                    agTimerCount;
@@ -94,6 +101,7 @@ int  AG_TimerIsRunning(void *_Nullable, AG_Timer *_Nonnull)
                       _Pure_Attribute;
 Uint32 AG_ExecTimer(AG_Timer *_Nonnull);
 void AG_ProcessTimeouts(Uint32);
+Uint32 AG_NextTimeout(Uint32) _Pure_Attribute_If_Unthreaded;
 
 # ifdef AG_LEGACY
 #  define AG_Timeout AG_Timer
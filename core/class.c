@@ -99,7 +99,7 @@ AG_InitClassTbl(void)
 	agObjectClass.pvt.libs[0] = '\0';
 #endif
 	/* Initialize the class table. */
-	agClassTbl = AG_TblNew(AG_OBJECT_CLASSTBLSIZE, 0);
+	agClassTbl = AG_TblNew(AG_OBJECT_CLASSTBLSIZE, AG_TBL_OPENADDR);
 
 	/* AG_Object -> agObjectClass */
 	AG_InitPointer(&V, &agObjectClass);
@@ -199,6 +199,8 @@ AG_InitCore(const char *progname, Uint flags)
 #ifdef AG_TIMERS
 	AG_InitTimers();
 #endif
+	/* Initialize the AG_Perf(3) counters. */
+	AG_InitPerf();
 
 #ifdef AG_SERIALIZATION
 	/* Initialize the AG_DataSource(3) interface. */
@@ -257,6 +259,7 @@ AG_Destroy(void)
 #ifdef AG_TIMERS
 	AG_DestroyTimers();
 #endif
+	AG_DestroyPerf();
 	AG_DestroyClassTbl();
 
 #ifdef AG_THREADS
@@ -28,6 +28,7 @@
 #include <agar/core/object.h>
 #include <agar/core/text.h>
 #include <agar/core/tbl.h>
+#include <agar/core/perf.h>
 #include <agar/core/config.h>
 #include <agar/core/file.h>
 #include <agar/core/dir.h>
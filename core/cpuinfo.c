@@ -24,11 +24,17 @@
  */
 
 /*
- * Obtain information about architecture extensions.
+ * Obtain information about architecture extensions and the number of
+ * processors, and run jobs concurrently over the available processors.
  */
 
 #include <agar/core/core.h>
 
+#include <agar/config/_mk_have_unistd_h.h>
+#ifdef _MK_HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+
 #if defined(__APPLE__) || defined(__MACOSX__)
 # include <AvailabilityMacros.h>
 # if defined(__ppc__) && !defined(MAC_OS_X_VERSION_10_4)
@@ -104,7 +110,7 @@ X86_GetCPUID(int fn)
 		".byte 0x0f, 0xa2\n"
 		"xchg %%esi, %%ebx\n"
 		: "=a" (regs.a), "=S" (regs.b), "=c" (regs.c), "=d" (regs.d)
-		: "0" (fn));
+		: "0" (fn), "2" (0));
 
 #elif defined(__x86_64__)
 	__asm(
@@ -112,10 +118,26 @@ X86_GetCPUID(int fn)
 		".byte 0x0f, 0xa2\n"
 		"xchg %%rsi, %%rbx\n"
 		: "=a" (regs.a), "=S" (regs.b), "=c" (regs.c), "=d" (regs.d)
-		: "0" (fn));
+		: "0" (fn), "2" (0));
 #endif
 	return (regs);
 }
+
+/*
+ * Return the low word of extended control register XCR0 (the state
+ * components enabled by the OS). Only valid if CPUID reports OSXSAVE.
+ */
+static Uint32
+X86_GetXCR0(void)
+{
+	Uint32 lo, hi;
+
+	__asm(
+		".byte 0x0f, 0x01, 0xd0\n"		/* XGETBV */
+		: "=a" (lo), "=d" (hi)
+		: "c" (0));
+	return (lo);
+}
 #endif /* __GNUC__ && (__i386__ || __x86_64__) */
 
 #if defined(__i386__) || defined(i386) || defined(__x86_64__)
@@ -289,6 +311,15 @@ AG_GetCPUInfo(AG_CPUInfo *_Nonnull cpu)
 		if (rExt.c & 0x00000200) cpu->ext |= AG_EXT_SSSE3;
 		if (rExt.c & 0x00080000) cpu->ext |= AG_EXT_SSE41;
 		if (rExt.c & 0x00100000) cpu->ext |= AG_EXT_SSE42;
+
+		/* AVX needs OSXSAVE and the OS saving the XMM and YMM state. */
+		if ((rExt.c & 0x18000000) == 0x18000000 &&
+		    (X86_GetXCR0() & 0x6) == 0x6)
+			cpu->ext |= AG_EXT_AVX;
+	}
+	if (maxFns >= 7 && (cpu->ext & AG_EXT_AVX)) {
+		rExt = X86_GetCPUID(7);
+		if (rExt.b & 0x00000020) cpu->ext |= AG_EXT_AVX2;
 	}
 #endif /* i386 or x86_64 */
 
@@ -323,3 +354,61 @@ AG_GetCPUInfo(AG_CPUInfo *_Nonnull cpu)
 	}
 #endif
 }
+
+/* Return the number of processors available, or 1 if unknown. */
+Uint
+AG_GetProcessorCount(void)
+{
+	static Uint nCPU = 0;
+
+	if (nCPU == 0) {
+#if defined(_MK_HAVE_UNISTD_H) && defined(_SC_NPROCESSORS_ONLN)
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+		nCPU = (n > 0) ? (Uint)n : 1;
+#else
+		nCPU = 1;
+#endif
+	}
+	return (nCPU);
+}
+
+/*
+ * Invoke fn() on each of the nJobs elements of the jobs array (of elements
+ * of jobSize bytes each). The calling thread runs the first job and one
+ * thread is created for each of the others. Jobs for which a thread cannot
+ * be created (or past AG_JOBS_MAX) are run in the calling thread. Return
+ * once all jobs have completed.
+ */
+void
+AG_RunJobs(void *_Nullable (*fn)(void *_Nonnull), void *jobs, AG_Size jobSize,
+    Uint nJobs)
+{
+	Uint8 *job = jobs;
+#ifdef AG_THREADS
+	AG_Thread th[AG_JOBS_MAX];
+	int started[AG_JOBS_MAX];
+	void *rv;
+#endif
+	Uint i;
+
+#ifdef AG_THREADS
+	for (i = 1; i < nJobs && i < AG_JOBS_MAX; i++) {
+		started[i] = (AG_ThreadTryCreate(&th[i], fn,
+		                                 &job[i*jobSize]) == 0);
+	}
+	if (nJobs > 0) {
+		fn(&job[0]);
+	}
+	for (i = 1; i < nJobs; i++) {
+		if (i < AG_JOBS_MAX && started[i]) {
+			AG_ThreadJoin(th[i], &rv);
+		} else {
+			fn(&job[i*jobSize]);
+		}
+	}
+#else
+	for (i = 0; i < nJobs; i++)
+		fn(&job[i*jobSize]);
+#endif
+}
@@ -39,15 +39,20 @@ typedef struct ag_cpuinfo {
 #define AG_EXT_SSSE3		0x01000000 /* SSSE3 Extensions */
 #define AG_EXT_SSE41		0x02000000 /* SSE4.1 extensions */
 #define AG_EXT_SSE42		0x04000000 /* SSE4.2 extensions */
-
-	/* TODO: AVX */
+#define AG_EXT_AVX		0x08000000 /* AVX extensions (OS-enabled) */
+#define AG_EXT_AVX2		0x10000000 /* AVX2 extensions (OS-enabled) */
 
 	Uint32 icon;                         /* Graphical Icon (Unicode) */
 } AG_CPUInfo;
 
+#define AG_JOBS_MAX 32			/* Threads per AG_RunJobs() call */
+
 __BEGIN_DECLS
 extern AG_CPUInfo agCPU;
 void AG_GetCPUInfo(AG_CPUInfo *_Nonnull);
+Uint AG_GetProcessorCount(void);
+void AG_RunJobs(void *_Nullable (*_Nonnull)(void *_Nonnull), void *_Nonnull,
+                AG_Size, Uint);
 __END_DECLS
 
 #include <agar/core/close.h>
@@ -48,6 +48,7 @@
 #endif
 #if defined(HAVE_TIMERFD)
 # include <sys/timerfd.h>
+# include <fcntl.h>
 # include <errno.h>
 #endif
 #if defined(HAVE_SELECT)
@@ -66,6 +67,20 @@ AG_EventSource *_Nullable agEventSource = NULL;	/* Event source (thread-local) *
 AG_ThreadKey agEventSourceKey;
 #endif
 
+#if defined(HAVE_TIMERFD) && !defined(HAVE_KQUEUE) && \
+    defined(AG_TIMERS) && defined(AG_THREADS)
+# define USE_SOFT_TIMER_PIPE
+/*
+ * With software timers, AG_EventSinkTIMERFD() sleeps until the next timer
+ * expiration. If another thread schedules a timer to expire sooner, it wakes
+ * the sleeping event loop up by writing to this pipe.
+ */
+static int agSoftTimerPipe[2] = { -1, -1 };
+static int agSoftTimerSleeping = 0;	/* Event loop is sleeping */
+static Uint32 agSoftTimerWake = 0;	/* Wakeup time (if not indefinite) */
+static int agSoftTimerWakeNone = 0;	/* Sleeping indefinitely */
+#endif
+
 #ifdef HAVE_KQUEUE
 
 /* Size of kqueue input event buffer (in kevents). */
@@ -147,12 +162,170 @@ InitEvent(AG_Event *_Nonnull ev, AG_Object *_Nullable ob)
 	ev->argc0 = 1;
 	InitPointerArg(&ev->argv[0], ob);
 	InitDebugName (&ev->argv[0], "self");
+	ev->hash = 0;
+	ev->hashNext = NULL;
 #ifdef AG_DEBUG
 	ev->events.tqe_next = NULL;
 	ev->events.tqe_prev = NULL;
 #endif
 }
 
+/* Return the hash of an event name (FNV-1a). */
+Uint32
+AG_EventHashName(const char *name)
+{
+	const Uchar *c;
+	Uint32 h = 2166136261U;
+
+	for (c = (const Uchar *)name; *c != '\0'; c++) {
+		h ^= (Uint32)*c;
+		h *= 16777619U;
+	}
+	return (h);
+}
+
+/* Append an event handler to the tail of its bucket in the index. */
+static void
+IndexInsert(AG_EventIndex *_Nonnull idx, AG_Event *_Nonnull ev)
+{
+	AG_Event **pEv = &idx->buckets[ev->hash & (idx->nBuckets - 1)];
+
+	while (*pEv != NULL) {
+		pEv = &(*pEv)->hashNext;
+	}
+	ev->hashNext = NULL;
+	*pEv = ev;
+	idx->nEvents++;
+}
+
+/*
+ * (Re)build the event handler index of an object with the given number
+ * of buckets. On allocation failure, return -1 and leave the existing index
+ * (or absence thereof) untouched.
+ */
+static int
+IndexBuild(AG_Object *_Nonnull ob, Uint nBuckets)
+{
+	AG_EventIndex *idx;
+	AG_Event **bucketsNew, *ev;
+	Uint i;
+
+	if ((bucketsNew = TryMalloc(nBuckets*sizeof(AG_Event *))) == NULL) {
+		return (-1);
+	}
+	for (i = 0; i < nBuckets; i++) {
+		bucketsNew[i] = NULL;
+	}
+	if ((idx = ob->evIndex) == NULL) {
+		if ((idx = TryMalloc(sizeof(AG_EventIndex))) == NULL) {
+			free(bucketsNew);
+			return (-1);
+		}
+		ob->evIndex = idx;
+	} else {
+		free(idx->buckets);
+	}
+	idx->buckets = bucketsNew;
+	idx->nBuckets = nBuckets;
+	idx->nEvents = 0;
+	TAILQ_FOREACH(ev, &ob->events, events)
+		IndexInsert(idx, ev);
+
+	return (0);
+}
+
+/*
+ * Register a newly inserted event handler (already in the TAILQ) with the
+ * hashed index, creating or growing the index as needed.
+ */
+static void
+IndexAttach(AG_Object *_Nonnull ob, AG_Event *_Nonnull ev)
+{
+	AG_EventIndex *idx = ob->evIndex;
+
+	if (idx == NULL) {
+		AG_Event *evOther;
+		Uint n = 0;
+
+		TAILQ_FOREACH(evOther, &ob->events, events) {
+			if (++n >= AG_EVENT_INDEX_MIN)
+				break;
+		}
+		if (n >= AG_EVENT_INDEX_MIN) {
+			(void)IndexBuild(ob, AG_EVENT_INDEX_MIN << 1);
+		}
+		return;
+	}
+	if (idx->nEvents >= (idx->nBuckets << 1) &&
+	    IndexBuild(ob, idx->nBuckets << 2) == 0)
+		return;                         /* Rebuilt (includes ev) */
+
+	IndexInsert(idx, ev);
+}
+
+/* Remove an event handler from the hashed index (if any). */
+static void
+IndexDetach(AG_Object *_Nonnull ob, AG_Event *_Nonnull ev)
+{
+	AG_EventIndex *idx = ob->evIndex;
+	AG_Event **pEv;
+
+	if (idx == NULL) {
+		return;
+	}
+	for (pEv = &idx->buckets[ev->hash & (idx->nBuckets - 1)];
+	     *pEv != NULL;
+	     pEv = &(*pEv)->hashNext) {
+		if (*pEv == ev) {
+			*pEv = ev->hashNext;
+			ev->hashNext = NULL;
+			idx->nEvents--;
+			break;
+		}
+	}
+}
+
+/* Release the hashed event handler index of an object. */
+void
+AG_EventIndexFree(AG_Object *ob)
+{
+	if (ob->evIndex != NULL) {
+		free(ob->evIndex->buckets);
+		free(ob->evIndex);
+		ob->evIndex = NULL;
+	}
+}
+
+/*
+ * Return the first (or next after evPrev) event handler of ob matching
+ * the given name and hash. The object must be locked.
+ */
+static __inline__ AG_Event *_Nullable
+FindHandler(AG_Object *_Nonnull ob, AG_Event *_Nullable evPrev,
+    const char *_Nonnull name, Uint32 h)
+{
+	AG_Event *ev;
+
+	if (ob->evIndex != NULL) {
+		AG_EventIndex *idx = ob->evIndex;
+
+		ev = (evPrev != NULL) ? evPrev->hashNext :
+		                        idx->buckets[h & (idx->nBuckets - 1)];
+		for (; ev != NULL; ev = ev->hashNext) {
+			if (ev->hash == h && strcmp(ev->name, name) == 0)
+				return (ev);
+		}
+	} else {
+		ev = (evPrev != NULL) ? TAILQ_NEXT(evPrev, events) :
+		                        TAILQ_FIRST(&ob->events);
+		for (; ev != TAILQ_END(&ob->events); ev = TAILQ_NEXT(ev, events)) {
+			if (ev->hash == h && strcmp(ev->name, name) == 0)
+				return (ev);
+		}
+	}
+	return (NULL);
+}
+
 /* Initialize an AG_Event structure. */
 void
 AG_EventInit(AG_Event *_Nonnull ev)
@@ -222,6 +395,8 @@ AG_EventCopy(AG_Event *dst, const AG_Event *src)
 	for (i = 0; i < src->argc; i++) {
 		AG_CopyVariable(&dst->argv[i], &src->argv[i]);
 	}
+	dst->hash = src->hash;
+	dst->hashNext = NULL;
 	dst->events.tqe_next = NULL;
 	dst->events.tqe_prev = NULL;
 }
@@ -238,13 +413,8 @@ AG_SetEvent(void *p, const char *name, AG_EventFn fn, const char *fmt, ...)
 
 	AG_ObjectLock(ob);
 
-	if (name != NULL) {
-		TAILQ_FOREACH(ev, &ob->events, events)
-			if (strcmp(ev->name, name) == 0)
-				break;
-	} else {
-		ev = NULL;
-	}
+	ev = (name != NULL) ? FindHandler(ob, NULL, name,
+	                                  AG_EventHashName(name)) : NULL;
 	if (ev == NULL) {
 		ev = Malloc(sizeof(AG_Event));
 		InitEvent(ev, ob);
@@ -254,7 +424,9 @@ AG_SetEvent(void *p, const char *name, AG_EventFn fn, const char *fmt, ...)
 		} else {
 			ev->name[0] = '\0';
 		}
+		ev->hash = AG_EventHashName(ev->name);
 		TAILQ_INSERT_TAIL(&ob->events, ev, events);
+		IndexAttach(ob, ev);
 	} else {
 		ev->argc = 1;
 		ev->argc0 = 1;
@@ -284,7 +456,7 @@ AG_Event *
 AG_AddEvent(void *p, const char *name, AG_EventFn fn, const char *fmt, ...)
 {
 	AG_Object *ob = p;
-	AG_Event *ev, *evOther;
+	AG_Event *ev;
 
 	AG_ObjectLock(ob);
 
@@ -292,15 +464,12 @@ AG_AddEvent(void *p, const char *name, AG_EventFn fn, const char *fmt, ...)
 	InitEvent(ev, ob);
 
 	if (name != NULL) {
-		TAILQ_FOREACH(evOther, &ob->events, events) {
-			if (strcmp(evOther->name, name) == 0)
-				break;
-		}
 		if (Strlcpy(ev->name, name, sizeof(ev->name)) >= sizeof(ev->name))
 			AG_FatalError("Event name too big");
 	} else {
 		ev->name[0] = '\0';
 	}
+	ev->hash = AG_EventHashName(ev->name);
 
 	ev->fn = fn;
 
@@ -314,6 +483,7 @@ AG_AddEvent(void *p, const char *name, AG_EventFn fn, const char *fmt, ...)
 	ev->argc0 = ev->argc;
 
 	TAILQ_INSERT_TAIL(&ob->events, ev, events);
+	IndexAttach(ob, ev);
 	AG_ObjectUnlock(ob);
 	return (ev);
 }
@@ -326,13 +496,10 @@ AG_UnsetEvent(void *p, const char *name)
 	AG_Event *ev;
 
 	AG_ObjectLock(ob);
-	TAILQ_FOREACH(ev, &ob->events, events) {
-		if (strcmp(name, ev->name) == 0)
-			break;
-	}
-	if (ev == NULL) {
+	if ((ev = FindHandler(ob, NULL, name, AG_EventHashName(name))) == NULL) {
 		goto out;
 	}
+	IndexDetach(ob, ev);
 	TAILQ_REMOVE(&ob->events, ev, events);
 	free(ev);
 out:
@@ -346,6 +513,7 @@ AG_UnsetEventByPtr(void *p, AG_Event *ev)
 	AG_Object *ob = p;
 
 	AG_ObjectLock(ob);
+	IndexDetach(ob, ev);
 	TAILQ_REMOVE(&ob->events, ev, events);
 	AG_ObjectUnlock(ob);
 
@@ -360,10 +528,7 @@ AG_FindEventHandler(void *p, const char *name)
 	AG_Event *ev;
 	
 	AG_ObjectLock(ob);
-	TAILQ_FOREACH(ev, &ob->events, events) {
-		if (strcmp(name, ev->name) == 0)
-			break;
-	}
+	ev = FindHandler(ob, NULL, name, AG_EventHashName(name));
 	AG_ObjectUnlock(ob);
 	return (ev);
 }
@@ -383,10 +548,7 @@ EventTimeout(AG_Timer *_Nonnull to, AG_Event *_Nonnull event)
 	Debug(obj, "Event <%s> timeout (%u ticks)\n", eventName,
 	    (Uint)to->ival);
 # endif
-	TAILQ_FOREACH(ev, &obj->events, events) {
-		if (strcmp(eventName, ev->name) == 0)
-			break;
-	}
+	ev = FindHandler(obj, NULL, eventName, AG_EventHashName(eventName));
 	if (ev == NULL) {
 		return (0);
 	}
@@ -449,12 +611,16 @@ AG_PostEventByPtr(void *pObj, AG_Event *ev, const char *fmt, ...)
  * Post an event (by name) to an object. If fmt is given, append the
  * given arguments (specified in the same format as AG_SetEvent(3)),
  * to the end of the argument vector.
+ *
+ * The next handler is looked up only once a handler has returned, so a
+ * handler may delete other handlers for the same event (but not itself).
  */
 void
 AG_PostEvent(void *pObj, const char *evname, const char *fmt, ...)
 {
 	AG_Object *obj = pObj;
 	AG_Event *ev;
+	Uint32 h;
 	va_list ap;
 
 #ifdef AG_DEBUG
@@ -463,10 +629,11 @@ AG_PostEvent(void *pObj, const char *evname, const char *fmt, ...)
 #ifdef DEBUG_EVENTS
 	Debug(obj, "PostEvent <%s>\n", evname);
 #endif
+	h = AG_EventHashName(evname);
 	AG_ObjectLock(obj);
-	TAILQ_FOREACH(ev, &obj->events, events) {
-		if (strcmp(evname, ev->name) != 0)
-			continue;
+	for (ev = FindHandler(obj, NULL, evname, h);
+	     ev != NULL;
+	     ev = FindHandler(obj, ev, evname, h)) {
 #if AG_MODEL == AG_SMALL
 		{
 			AG_Event *evTmp = Malloc(sizeof(AG_Event));
@@ -517,21 +684,24 @@ AG_EventGetArgs(AG_Event *ev, const char *fmt, va_list ap)
 
 /*
  * Forward an event to an object. The original arguments are copied
- * as is, except for Pointer 0 (SELF) which becomes pObj.
+ * as is, except for Pointer 0 (SELF) which becomes pObj. As with
+ * AG_PostEvent(), a handler may delete other handlers for the event.
  */
 void
 AG_ForwardEvent(void *pObj, const AG_Event *event)
 {
 	AG_Object *obj = pObj;
 	AG_Event *ev;
+	Uint32 h;
 
 #ifdef DEBUG_EVENTS
 	Debug(obj, "Event <%s> forwarded\n", event->name);
 #endif
+	h = AG_EventHashName(event->name);
 	AG_ObjectLock(obj);
-	TAILQ_FOREACH(ev, &obj->events, events) {
-		if (strcmp(event->name, ev->name) != 0)
-			continue;
+	for (ev = FindHandler(obj, NULL, event->name, h);
+	     ev != NULL;
+	     ev = FindHandler(obj, ev, event->name, h)) {
 #if AG_MODEL == AG_SMALL
 		{
 			AG_Event *evTmp = Malloc(sizeof(AG_Event));
@@ -682,7 +852,11 @@ CreateEventSource(void)
 # endif
 # ifdef AG_TIMERS
 	if (agSoftTimers) {			/* Force soft timers */
+#  ifdef USE_SOFT_TIMER_PIPE
+		src->addTimerFn = AG_AddSoftTimerTIMERFD;
+#  else
 		src->addTimerFn = NULL;
+#  endif
 		src->delTimerFn = NULL;
 		src->caps[AG_SINK_TIMER] = 0;
 	}
@@ -742,6 +916,9 @@ DestroyEventSource(void *_Nullable pEventSource)
 int
 AG_InitEventSubsystem(Uint flags)
 {
+#ifdef USE_SOFT_TIMER_PIPE
+	int i;
+#endif
 	/* Initialize the main thread's event source. */
 	agEventSource = NULL;
 #ifdef AG_THREADS
@@ -751,6 +928,18 @@ AG_InitEventSubsystem(Uint flags)
 	if ((agEventSource = AG_GetEventSource()) == NULL) {
 		return (-1);
 	}
+#ifdef USE_SOFT_TIMER_PIPE
+	if (!agEventSource->caps[AG_SINK_TIMER]) {
+		if (pipe(agSoftTimerPipe) == -1) {
+			AG_SetError("pipe: %s", AG_Strerror(errno));
+			return (-1);
+		}
+		for (i = 0; i < 2; i++) {
+			fcntl(agSoftTimerPipe[i], F_SETFL, O_NONBLOCK);
+			fcntl(agSoftTimerPipe[i], F_SETFD, FD_CLOEXEC);
+		}
+	}
+#endif
 	return (0);
 }
 
@@ -761,6 +950,14 @@ AG_DestroyEventSubsystem(void)
 		DestroyEventSource(agEventSource);
 		agEventSource = NULL;
 	}
+#ifdef USE_SOFT_TIMER_PIPE
+	if (agSoftTimerPipe[0] != -1) {
+		close(agSoftTimerPipe[0]);
+		close(agSoftTimerPipe[1]);
+		agSoftTimerPipe[0] = -1;
+		agSoftTimerPipe[1] = -1;
+	}
+#endif
 }
 
 /* Return the calling thread's effective event source. */
@@ -1102,6 +1299,7 @@ AG_EventSinkKQUEUE(void)
 	AG_EventSourceKQUEUE *kq = (AG_EventSourceKQUEUE *)agEventSource;
 	int rv, i;
 	struct timespec timeo, *pTimeo;
+	Uint64 t0;
 
 restart:
 	if (!TAILQ_EMPTY(&agEventSource->spinners)) {
@@ -1120,8 +1318,10 @@ restart:
 		    chg->udata);
 	}
 #  endif
+	t0 = AG_PerfBegin();
 	rv = kevent(kq->fd, kq->changes, kq->nChanges, kq->events,
 	            AG_KQ_EVBUFSIZE, pTimeo);
+	AG_PerfEnd(AG_PERF_EVENT_WAIT, t0);
 	if (rv < 0) {
 		if (errno == EINTR) {
 			goto restart;
@@ -1133,6 +1333,7 @@ restart:
 
 #  ifdef AG_TIMERS
 	/* 1. Process timer expirations. */
+	t0 = 0;
 	AG_LockTiming();
 	for (i = 0; i < rv; i++) {
 		struct kevent *kev = &kq->events[i];
@@ -1152,6 +1353,10 @@ restart:
 		    (to = (AG_Timer *)kev->udata) == NULL) {
 			continue;
 		}
+		if (t0 == 0) {
+			t0 = AG_PerfBegin();
+		}
+		AG_PerfCount(AG_PERF_TIMERS_FIRED);
 		rvt = to->fn(to, &to->fnEvent);
 		if (rvt > 0) {				/* Restart timer */
 			struct kevent *kev;
@@ -1189,6 +1394,7 @@ restart:
 			agTimerCount--;
 		}
 	}
+	AG_PerfEnd(AG_PERF_TIMERS, t0);
 	AG_UnlockTiming();
 #  endif /* AG_TIMERS */
 
@@ -1312,6 +1518,11 @@ AG_EventSinkTIMERFD(void)
 	AG_Object *ob, *obNext;
 	AG_Timer *to, *toNext;
 	struct timeval timeo, *pTimeo;
+	Uint64 t0;
+#  ifdef AG_TIMERS
+	const int softTimers = !agEventSource->caps[AG_SINK_TIMER];
+	Uint32 dt;
+#  endif
 
 restart:
 	nFds = 0;
@@ -1332,12 +1543,20 @@ restart:
 		}
 	}
 #  ifdef AG_TIMERS
-	TAILQ_FOREACH(ob, &agTimerObjQ, tobjs) {
-		TAILQ_FOREACH(to, &ob->timers, pvt.timers) {
-			FD_SET(to->id, &rdFds);
-			if (to->id > nFds) { nFds = to->id; }
+	if (!softTimers) {
+		TAILQ_FOREACH(ob, &agTimerObjQ, tobjs) {
+			TAILQ_FOREACH(to, &ob->timers, pvt.timers) {
+				FD_SET(to->id, &rdFds);
+				if (to->id > nFds) { nFds = to->id; }
+			}
 		}
 	}
+#   ifdef USE_SOFT_TIMER_PIPE
+	if (softTimers) {			/* Wakeup pipe */
+		FD_SET(agSoftTimerPipe[0], &rdFds);
+		if (agSoftTimerPipe[0] > nFds) { nFds = agSoftTimerPipe[0]; }
+	}
+#   endif
 #  endif
 	if (!TAILQ_EMPTY(&agEventSource->spinners)) {
 		timeo.tv_sec = 0;
@@ -1345,8 +1564,38 @@ restart:
 		pTimeo = &timeo;
 	} else {
 		pTimeo = NULL;
+#  ifdef AG_TIMERS
+		if (softTimers) {
+			Uint32 t;
+
+			/* Sleep until the next software timer expires. */
+			AG_LockTiming();
+			t = AG_GetTicks();
+			dt = AG_NextTimeout(t);
+#   ifdef USE_SOFT_TIMER_PIPE
+			agSoftTimerSleeping = 1;
+			agSoftTimerWake = t + dt;
+			agSoftTimerWakeNone = (dt == AG_TIMEOUT_NONE);
+#   endif
+			AG_UnlockTiming();
+			if (dt != AG_TIMEOUT_NONE) {
+				timeo.tv_sec = dt/1000;
+				timeo.tv_usec = (dt % 1000)*1000;
+				pTimeo = &timeo;
+			}
+		}
+#  endif
 	}
+	t0 = AG_PerfBegin();
 	rv = select(nFds+1, &rdFds, &wrFds, NULL, pTimeo);
+	AG_PerfEnd(AG_PERF_EVENT_WAIT, t0);
+#  ifdef USE_SOFT_TIMER_PIPE
+	if (softTimers) {
+		AG_LockTiming();
+		agSoftTimerSleeping = 0;
+		AG_UnlockTiming();
+	}
+#  endif
 	if (rv == -1) {
 		if (errno == EINTR) {
 			goto restart;
@@ -1357,6 +1606,19 @@ restart:
 
 #  ifdef AG_TIMERS
 	/* 1. Process timer expirations. */
+	if (softTimers) {
+#   ifdef USE_SOFT_TIMER_PIPE
+		if (FD_ISSET(agSoftTimerPipe[0], &rdFds)) {
+			char buf[64];
+
+			while (read(agSoftTimerPipe[0], buf, sizeof(buf)) > 0)
+				;;
+		}
+#   endif
+		AG_ProcessTimeouts(AG_GetTicks());
+		goto process_io;
+	}
+	t0 = 0;
 	AG_LockTiming();
 	for (ob = TAILQ_FIRST(&agTimerObjQ);
 	     ob != TAILQ_END(&agTimerObjQ);
@@ -1373,6 +1635,10 @@ restart:
 			if (!FD_ISSET(to->id, &rdFds)) {
 				continue;
 			}
+			if (t0 == 0) {
+				t0 = AG_PerfBegin();
+			}
+			AG_PerfCount(AG_PERF_TIMERS_FIRED);
 			rvt = to->fn(to, &to->fnEvent);
 			if (rvt > 0) {
 				its.it_value.tv_sec = rvt/1000;
@@ -1391,7 +1657,9 @@ restart:
 		}
 		AG_ObjectUnlock(ob);
 	}
+	AG_PerfEnd(AG_PERF_TIMERS, t0);
 	AG_UnlockTiming();
+process_io:
 #  endif /* AG_TIMERS */
 	
 	/* 2. Process I/O events. */
@@ -1454,6 +1722,25 @@ AG_DelTimerTIMERFD(AG_Timer *to)
 #  endif
 	close(to->id);
 }
+
+#   ifdef USE_SOFT_TIMER_PIPE
+/*
+ * A software timer was added or restarted (called with the timing lock
+ * held). If it expires before the sleeping event loop would wake up, wake
+ * it up so it can recompute its timeout.
+ */
+int
+AG_AddSoftTimerTIMERFD(AG_Timer *to, Uint32 ival, int newTimer)
+{
+	if (agSoftTimerSleeping &&
+	    (agSoftTimerWakeNone || (int)(to->tSched - agSoftTimerWake) < 0)) {
+		agSoftTimerSleeping = 0;
+		if (write(agSoftTimerPipe[1], "", 1) == -1 && errno != EAGAIN)
+			Verbose("write: %s\n", AG_Strerror(errno));
+	}
+	return (0);
+}
+#   endif /* USE_SOFT_TIMER_PIPE */
 #  endif /* AG_TIMERS */
 # endif /* HAVE_TIMERFD */
 
@@ -1470,17 +1757,17 @@ AG_EventSinkTIMEDSELECT(void)
 	fd_set rdFds, wrFds;
 	int i, nFds, rv;
 	AG_EventSink *es;
-#  ifdef AG_TIMERS
-	AG_Object *ob, *obNext;
-	AG_Timer *to, *toNext;
 	struct timeval timeo, *pTimeo;
-	Uint32 t, tSoonest;
+	Uint64 t0;
+#  ifdef AG_TIMERS
+	Uint32 dt;
 #  endif
 
 restart:
 	nFds = 0;
 	FD_ZERO(&rdFds);
 	FD_ZERO(&wrFds);
+	pTimeo = &timeo;
 	TAILQ_FOREACH(es, &agEventSource->sinks, sinks) {
 		switch (es->type) {
 		case AG_SINK_READ:
@@ -1498,24 +1785,24 @@ restart:
 		timeo.tv_sec = 0;
 		timeo.tv_usec = 0;
 	} else {
+		/* Sleep until the next timer expires. */
 		AG_LockTiming();
-		t = AG_GetTicks();
-		tSoonest = 0xfffffffe;
-		TAILQ_FOREACH(ob, &agTimerObjQ, tobjs) {
-			TAILQ_FOREACH(to, &ob->timers, pvt.timers) {
-				if ((to->tSched - t) < tSoonest)
-					tSoonest = (to->tSched - t);
-			}
-		}
-		timeo.tv_sec = tSoonest/1000;
-		timeo.tv_usec = (tSoonest % 1000)*1000;
+		dt = AG_NextTimeout(AG_GetTicks());
 		AG_UnlockTiming();
+		if (dt == AG_TIMEOUT_NONE) {
+			pTimeo = NULL;
+		} else {
+			timeo.tv_sec = dt/1000;
+			timeo.tv_usec = (dt % 1000)*1000;
+		}
 	}
 #  else /* !AG_TIMERS */
 	timeo.tv_sec = 0;
 	timeo.tv_usec = 0;
 #  endif /* AG_TIMERS */
-	rv = select(nFds+1, &rdFds, &wrFds, NULL, &timeo);
+	t0 = AG_PerfBegin();
+	rv = select(nFds+1, &rdFds, &wrFds, NULL, pTimeo);
+	AG_PerfEnd(AG_PERF_EVENT_WAIT, t0);
 	if (rv == -1) {
 		if (errno == EINTR) {
 			goto restart;
@@ -1526,7 +1813,7 @@ restart:
 #  ifdef AG_TIMERS
 	AG_LockTiming();
 	/* 1. Process timer expirations. */
-	AG_ProcessTimeouts(t);
+	AG_ProcessTimeouts(AG_GetTicks());
 #  endif
 	if (rv > 0) {
 		/* 2. Process I/O events */
@@ -1565,6 +1852,7 @@ AG_EventSinkSELECT(void)
 	int nFds, rv;
 	AG_EventSink *es;
 	struct timeval timeo;
+	Uint64 t0;
 
 	nFds = 0;
 	FD_ZERO(&rdFds);
@@ -1588,7 +1876,9 @@ AG_EventSinkSELECT(void)
 restart:
 	timeo.tv_sec = 0;
 	timeo.tv_usec = 0;
+	t0 = AG_PerfBegin();
 	rv = select(nFds+1, &rdFds, &wrFds, NULL, &timeo);
+	AG_PerfEnd(AG_PERF_EVENT_WAIT, t0);
 	if (rv == -1) {
 		if (errno == EINTR) {
 			goto restart;
@@ -1624,7 +1914,9 @@ restart:
 	AG_UnlockTiming();
 #  endif
 	if (TAILQ_EMPTY(&agEventSource->spinners)) {
+		t0 = AG_PerfBegin();
 		AG_Delay(1);
+		AG_PerfEnd(AG_PERF_EVENT_WAIT, t0);
 	}
 	return (0);
 }
@@ -1637,10 +1929,14 @@ restart:
 int
 AG_EventSinkSPINNER(void)
 {
+	Uint64 t0;
+
 # ifdef AG_TIMERS
 	AG_ProcessTimeouts(AG_GetTicks());
 # endif
+	t0 = AG_PerfBegin();
 	AG_Delay(1);
+	AG_PerfEnd(AG_PERF_EVENT_WAIT, t0);
 	return (0);
 }
 
@@ -87,9 +87,30 @@ typedef struct ag_event {
 	int   argc, argc0;			/* Argument count & offset */
 #endif
 	AG_Variable argv[AG_EVENT_ARGS_MAX];	/* Argument values */
+	Uint32 hash;				/* Hash of name (cached) */
+	Uint32 _pad;
+	struct ag_event *_Nullable hashNext;	/* Next in AG_EventIndex bucket */
 	AG_TAILQ_ENTRY(ag_event) events;	/* Entry in Object */
 } AG_Event, AG_Function;
 
+/*
+ * Hashed index of the event handlers of an AG_Object. Allocated once the
+ * handler count reaches AG_EVENT_INDEX_MIN. Bucket chains preserve the
+ * insertion order of the handlers (as found in the TAILQ).
+ */
+#ifndef AG_EVENT_INDEX_MIN
+# if AG_MODEL == AG_SMALL
+#  define AG_EVENT_INDEX_MIN 16
+# else
+#  define AG_EVENT_INDEX_MIN 8
+# endif
+#endif
+typedef struct ag_event_index {
+	Uint nBuckets;				/* Bucket count (power of 2) */
+	Uint nEvents;				/* Total handlers */
+	AG_Event *_Nullable *_Nonnull buckets;	/* Bucket chains */
+} AG_EventIndex;
+
 #define AGEVENT(ev)    ((struct ag_event *)(ev))
 #define AGFUNCTION(ev) ((struct ag_event *)(ev))
 
@@ -395,6 +416,8 @@ void AG_EventGetArgs(AG_Event *_Nonnull, const char *_Nullable, va_list);
 void AG_ForwardEvent(void *_Nonnull, const AG_Event *_Nonnull);
 
 AG_Event *_Nullable AG_FindEventHandler(void *_Nonnull, const char *_Nonnull);
+Uint32              AG_EventHashName(const char *_Nonnull) _Pure_Attribute;
+void                AG_EventIndexFree(struct ag_object *_Nonnull);
 
 #ifdef AG_TIMERS
 int AG_SchedEvent(void *_Nonnull, Uint32, const char *_Nullable,
@@ -424,6 +447,7 @@ int                      AG_AddTimerKQUEUE(struct ag_timer *_Nonnull, Uint32, in
 void                     AG_DelTimerKQUEUE(struct ag_timer *_Nonnull);
 int                      AG_AddTimerTIMERFD(struct ag_timer *_Nonnull, Uint32, int);
 void                     AG_DelTimerTIMERFD(struct ag_timer *_Nonnull);
+int                      AG_AddSoftTimerTIMERFD(struct ag_timer *_Nonnull, Uint32, int);
 # endif
 int                      AG_EventSinkKQUEUE(void);
 int                      AG_EventSinkTIMERFD(void);
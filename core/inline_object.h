@@ -267,14 +267,7 @@ int
 ag_defined(void *pObj, const char *name)
 #endif
 {
-	AG_Object *obj = AGOBJECT(pObj);
-	AG_Variable *V;
-
-	AG_TAILQ_FOREACH(V, &obj->vars, vars) {
-		if (strcmp(name, V->name) == 0)
-			return (1);
-	}
-	return (0);
+	return (AG_LookupVariable(pObj, name) != NULL);
 }
 
 /*
@@ -290,17 +283,12 @@ AG_Variable *
 ag_fetch_variable(void *pObj, const char *name, enum ag_variable_type type)
 #endif
 {
-	AG_Object *obj = (AG_Object *)pObj;
 	AG_Variable *V;
 
-	AG_TAILQ_FOREACH(V, &obj->vars, vars) {
-		if (strcmp(V->name, name) == 0)
-			break;
-	}
-	if (V == NULL) {
+	if ((V = AG_LookupVariable(pObj, name)) == NULL) {
 		V = AG_Malloc(sizeof(AG_Variable));
 		AG_InitVariable(V, type, name);
-		AG_TAILQ_INSERT_TAIL(&obj->vars, V, vars);
+		AG_InsertVariable(pObj, V);
 	}
 	return (V);
 }
@@ -354,14 +342,9 @@ AG_Variable *
 ag_access_variable(void *pObj, const char *name)
 #endif
 {
-	AG_Object *obj = AGOBJECT(pObj);
 	AG_Variable *V, *Vtgt;
 
-	AG_TAILQ_FOREACH(V, &obj->vars, vars) {
-		if (strcmp(name, V->name) == 0)
-			break;
-	}
-	if (V == NULL) {
+	if ((V = AG_LookupVariable(pObj, name)) == NULL) {
 		return (NULL);
 	}
 	AG_LockVariable(V);
@@ -1,6 +1,9 @@
 /*	Public domain	*/
 
-/* General hash function */
+/*
+ * General hash function. Returns a bucket index, or the full hash (FNV-1a)
+ * in the case of OPENADDR tables.
+ */
 #ifdef AG_INLINE_HEADER
 static __inline__ Uint _Pure_Attribute
 AG_TblHash(AG_Tbl *_Nonnull tbl, const char *_Nonnull key)
@@ -12,6 +15,16 @@ ag_tbl_hash(AG_Tbl *tbl, const char *key)
 	Uint h;
 	Uchar *p;
 
+	if (tbl->flags & AG_TBL_OPENADDR) {
+		Uint32 h32 = 2166136261U;
+
+		for (p = (Uchar *)key; *p != '\0'; p++) {
+			h32 ^= *p;
+			h32 *= 16777619U;
+		}
+		h = (Uint)h32;
+		return (h > AG_TBL_SLOT_DELETED) ? h : h+2;
+	}
 	for (h = 0, p = (Uchar *)key; *p != '\0'; p++) {
 		h = 31*h + *p;
 	}
@@ -89,10 +89,14 @@ AG_ObjectInit(void *pObj, void *pClass)
 	AG_MutexInitRecursive(&ob->lock);
 	
 	TAILQ_INIT(&ob->events);
+	ob->evIndex = NULL;
 #ifdef AG_TIMERS
 	TAILQ_INIT(&ob->timers);
 #endif
 	TAILQ_INIT(&ob->vars);
+	ob->varIndex = NULL;
+	ob->nVars = 0;
+	ob->varGen = 0;
 	TAILQ_INIT(&ob->children);
 
 	if (AG_ObjectGetInheritHier(ob, &hier, &nHier) != 0) {
@@ -765,6 +769,9 @@ AG_ObjectFreeVariables(void *pObj)
 		free(V);
 	}
 	TAILQ_INIT(&ob->vars);
+	AG_VariableIndexFree(ob);
+	ob->nVars = 0;
+	ob->varGen++;
 	AG_ObjectUnlock(ob);
 }
 
@@ -782,6 +789,7 @@ AG_ObjectFreeEvents(AG_Object *ob)
 		free(ev);
 	}
 	TAILQ_INIT(&ob->events);
+	AG_EventIndexFree(ob);
 	AG_ObjectUnlock(ob);
 }
 
@@ -854,12 +862,14 @@ AG_ObjectDestroy(void *p)
 		AG_FreeVariable(V);
 		free(V);
 	}
+	AG_VariableIndexFree(ob);
 	for (ev = TAILQ_FIRST(&ob->events);
 	     ev != TAILQ_END(&ob->events);
 	     ev = evNext) {
 		evNext = TAILQ_NEXT(ev, events);
 		free(ev);
 	}
+	AG_EventIndexFree(ob);
 
 	/* Release the object's locking device. */
 	AG_MutexDestroy(&ob->lock);
@@ -160,10 +160,14 @@ typedef struct ag_object {
 	AG_ObjectClass *_Nonnull cls;     /* Class description */
 
 	AG_TAILQ_HEAD_(ag_event) events;  /* Event handlers */
+	AG_EventIndex *_Nullable evIndex; /* Event handlers (hashed index) */
 #ifdef AG_TIMERS
 	AG_TAILQ_HEAD_(ag_timer) timers;  /* Running timers */
 #endif
 	AG_TAILQ_HEAD_(ag_variable) vars; /* Named variables / bindings */
+	struct ag_tbl *_Nullable varIndex; /* Variables (hashed index) */
+	Uint nVars;                       /* Variable count */
+	Uint varGen;                      /* Incremented on variable deletion */
 	struct ag_objectq children;       /* Child objects */
 	AG_TAILQ_ENTRY(ag_object) cobjs;  /* Entry in parent */
 	void *_Nullable parent;           /* Parent in VFS (NULL = is root) */
@@ -0,0 +1,554 @@
+/*
+ * Copyright (c) 2026 Julien Nadeau Carriere <vedge@csoft.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Performance counters and timing histograms (see AG_Perf(3)).
+ *
+ * Samples are recorded without locking (concurrent updates from different
+ * threads may occasionally be lost). Keyed tables are accessed under
+ * agPerfLock, since AG_PerfForget() may move or free their entries.
+ */
+
+#include <agar/config/have_clock_gettime.h>
+#include <agar/config/have_gettimeofday.h>
+
+#include <agar/core/core.h>
+
+#if defined(_WIN32)
+# include <agar/core/queue_close.h>			/* Conflicts */
+# ifdef _XBOX
+#  include <xtl.h>
+# else
+#  include <windows.h>
+# endif
+# include <agar/core/queue_close.h>			/* Conflicts */
+# include <agar/core/queue.h>
+#elif defined(HAVE_CLOCK_GETTIME)
+# include <time.h>
+#elif defined(HAVE_GETTIMEOFDAY)
+# include <sys/time.h>
+#endif
+
+#include <string.h>
+#include <stdarg.h>
+
+AG_Perf agPerf;
+#ifdef AG_THREADS
+_Nonnull_Mutex AG_Mutex agPerfLock;
+#endif
+
+static const char *agPerfHistNames[] = {
+	"event_wait",
+	"timers",
+	"frame",
+	"window_draw",
+	"texture_upload"
+};
+static const char *agPerfCounterNames[] = {
+	"frames",
+	"timers_fired",
+	"glyph_hits",
+	"glyph_misses",
+	"texture_uploads",
+	"texture_bytes"
+};
+static const char *agPerfKeyedNames[] = {
+	"windows",
+	"widget_classes"
+};
+
+#ifdef _WIN32
+static LARGE_INTEGER perfFreq;
+#endif
+
+void
+AG_InitPerf(void)
+{
+	memset(&agPerf, 0, sizeof(AG_Perf));
+#ifdef AG_THREADS
+	AG_MutexInitRecursive(&agPerfLock);
+#endif
+#ifdef _WIN32
+	QueryPerformanceFrequency(&perfFreq);
+#endif
+	AG_PerfReset();
+	agPerf.enabled = 1;
+}
+
+void
+AG_DestroyPerf(void)
+{
+	int i, j;
+
+	agPerf.enabled = 0;
+	for (i = 0; i < AG_PERF_KEYED_LAST; i++) {
+		AG_PerfKeyed *kt = &agPerf.keyed[i];
+
+		for (j = 0; j < AG_PERF_KEYED_MAX; j++) {
+			Free(kt->ents[j]);
+			kt->ents[j] = NULL;
+		}
+		kt->nEnts = 0;
+	}
+#ifdef AG_THREADS
+	AG_MutexDestroy(&agPerfLock);
+#endif
+}
+
+/*
+ * Return the value of a monotonic clock in nanoseconds. The origin is
+ * arbitrary, but the value is never 0.
+ */
+Uint64
+AG_PerfTime(void)
+{
+#if defined(_WIN32)
+	LARGE_INTEGER t;
+
+	QueryPerformanceCounter(&t);
+	if (perfFreq.QuadPart == 0) {
+		return (1);
+	}
+	return (Uint64)(t.QuadPart / perfFreq.QuadPart) * 1000000000 +
+	       (Uint64)(t.QuadPart % perfFreq.QuadPart) * 1000000000 /
+	       perfFreq.QuadPart + 1;
+#elif defined(HAVE_CLOCK_GETTIME)
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (Uint64)ts.tv_sec * 1000000000 + (Uint64)ts.tv_nsec + 1;
+#elif defined(HAVE_GETTIMEOFDAY)
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return (Uint64)tv.tv_sec * 1000000000 + (Uint64)tv.tv_usec * 1000 + 1;
+#else
+	return (Uint64)AG_GetTicks() * 1000000 + 1;
+#endif
+}
+
+/* Enable or disable the collection of timings. */
+void
+AG_PerfSetEnabled(int enable)
+{
+	agPerf.enabled = enable;
+}
+
+static void
+ResetHist(AG_PerfHist *_Nonnull h)
+{
+	h->n = 0;
+	h->tSum = 0;
+	h->tMin = 0;
+	h->tMax = 0;
+	memset(h->bins, 0, sizeof(h->bins));
+}
+
+/*
+ * Clear all counters and histograms. Entries of keyed tables are retained
+ * (with their statistics cleared).
+ */
+void
+AG_PerfReset(void)
+{
+	int i, j;
+
+	AG_MutexLock(&agPerfLock);
+	memset(agPerf.counters, 0, sizeof(agPerf.counters));
+	for (i = 0; i < AG_PERF_HIST_LAST; i++) {
+		ResetHist(&agPerf.hists[i]);
+	}
+	for (i = 0; i < AG_PERF_KEYED_LAST; i++) {
+		AG_PerfKeyed *kt = &agPerf.keyed[i];
+
+		for (j = 0; j < AG_PERF_KEYED_MAX; j++) {
+			if (kt->ents[j] != NULL)
+				ResetHist(kt->ents[j]);
+		}
+		kt->nDropped = 0;
+	}
+	agPerf.tReset = AG_PerfTime();
+	AG_MutexUnlock(&agPerfLock);
+}
+
+/* Record a sample of dt nanoseconds into a histogram. */
+void
+AG_PerfHistAdd(AG_PerfHist *h, Uint64 dt)
+{
+	Uint64 v = dt >> 10;
+	int i = 0;
+
+	while (v != 0 && i < AG_PERF_NBINS-1) {
+		v >>= 1;
+		i++;
+	}
+	h->bins[i]++;
+	if (h->n == 0 || dt < h->tMin) { h->tMin = dt; }
+	if (dt > h->tMax)              { h->tMax = dt; }
+	h->n++;
+	h->tSum += dt;
+}
+
+/*
+ * Return an upper bound (in ns) of the given percentile of the samples in h.
+ * The estimate is the upper bound of the bin containing the percentile
+ * (clamped to the longest sample).
+ */
+Uint64
+AG_PerfHistPercentile(const AG_PerfHist *h, int pct)
+{
+	Uint64 nTgt, nSum = 0;
+	int i;
+
+	if (h->n == 0) {
+		return (0);
+	}
+	nTgt = (h->n * (Uint64)pct + 99) / 100;
+	if (nTgt == 0) {
+		nTgt = 1;
+	}
+	for (i = 0; i < AG_PERF_NBINS-1; i++) {
+		nSum += h->bins[i];
+		if (nSum >= nTgt)
+			return AG_MIN(AG_PerfBinMax(i), h->tMax);
+	}
+	return (h->tMax);
+}
+
+/*
+ * Complete a timing started with AG_PerfBegin() and record the sample into
+ * the given histogram. If t0 is 0 (timings disabled), this is a no-op.
+ */
+void
+AG_PerfEnd(enum ag_perf_hist_id id, Uint64 t0)
+{
+	if (t0 == 0) {
+		return;
+	}
+	AG_PerfHistAdd(&agPerf.hists[id], AG_PerfTime() - t0);
+}
+
+static __inline__ Uint
+KeyHash(const void *_Nonnull key)
+{
+	return (Uint)(((AG_Size)key >> 4) * 2654435761UL) &
+	       (AG_PERF_KEYED_MAX - 1);
+}
+
+/*
+ * Look up the histogram for key, creating it if necessary.
+ * The agPerfLock must be held.
+ */
+static AG_PerfHist *_Nullable
+KeyedLookup(AG_PerfKeyed *_Nonnull kt, const void *_Nonnull key,
+    const char *_Nonnull name)
+{
+	AG_PerfHist *h;
+	Uint i;
+
+	for (i = KeyHash(key); ; i = (i+1) & (AG_PERF_KEYED_MAX-1)) {
+		if ((h = kt->ents[i]) == NULL) {
+			break;
+		}
+		if (h->key == key)
+			return (h);
+	}
+	if (kt->nEnts+1 > AG_PERF_KEYED_MAX*3/4 ||
+	    (h = TryMalloc(sizeof(AG_PerfHist))) == NULL) {
+		kt->nDropped++;
+		return (NULL);
+	}
+	h->key = key;
+	Strlcpy(h->name, name, sizeof(h->name));
+	ResetHist(h);
+	kt->ents[i] = h;
+	kt->nEnts++;
+	return (h);
+}
+
+/*
+ * Record a sample of dt ns into the histogram of the given keyed table
+ * associated with key. The name is copied when the entry is first created.
+ */
+void
+AG_PerfKeyedAdd(enum ag_perf_keyed_id id, const void *key, const char *name,
+    Uint64 dt)
+{
+	AG_PerfHist *h;
+
+	AG_MutexLock(&agPerfLock);
+	if ((h = KeyedLookup(&agPerf.keyed[id], key, name)) != NULL) {
+		AG_PerfHistAdd(h, dt);
+	}
+	AG_MutexUnlock(&agPerfLock);
+}
+
+/*
+ * Complete a timing started with AG_PerfBegin() and record the sample into
+ * the histogram of the given keyed table associated with key.
+ */
+void
+AG_PerfEndKeyed(enum ag_perf_keyed_id id, const void *key, const char *name,
+    Uint64 t0)
+{
+	if (t0 == 0) {
+		return;
+	}
+	AG_PerfKeyedAdd(id, key, name, AG_PerfTime() - t0);
+}
+
+/*
+ * Remove the entry associated with key from a keyed table. This must be
+ * called before the object used as key is freed, since its address may be
+ * reused by an unrelated object.
+ */
+void
+AG_PerfForget(enum ag_perf_keyed_id id, const void *key)
+{
+	AG_PerfKeyed *kt = &agPerf.keyed[id];
+	AG_PerfHist *h;
+	Uint i, j, k;
+
+	AG_MutexLock(&agPerfLock);
+	for (i = KeyHash(key); ; i = (i+1) & (AG_PERF_KEYED_MAX-1)) {
+		if ((h = kt->ents[i]) == NULL) {
+			goto out;
+		}
+		if (h->key == key)
+			break;
+	}
+	free(h);
+	kt->ents[i] = NULL;
+	kt->nEnts--;
+
+	/*
+	 * Move back into the hole any entry of the following probe sequence
+	 * whose home slot k is not cyclically within (i,j].
+	 */
+	for (j = (i+1) & (AG_PERF_KEYED_MAX-1);
+	     (h = kt->ents[j]) != NULL;
+	     j = (j+1) & (AG_PERF_KEYED_MAX-1)) {
+		k = KeyHash(h->key);
+		if ((j > i && (k <= i || k > j)) ||
+		    (j < i && (k <= i && k > j))) {
+			kt->ents[i] = h;
+			kt->ents[j] = NULL;
+			i = j;
+		}
+	}
+out:
+	AG_MutexUnlock(&agPerfLock);
+}
+
+/* Return the name of a histogram, counter or keyed table (as in JSON). */
+const char *
+AG_PerfHistName(enum ag_perf_hist_id id)
+{
+	return (agPerfHistNames[id]);
+}
+const char *
+AG_PerfCounterName(enum ag_perf_counter_id id)
+{
+	return (agPerfCounterNames[id]);
+}
+const char *
+AG_PerfKeyedName(enum ag_perf_keyed_id id)
+{
+	return (agPerfKeyedNames[id]);
+}
+
+#ifdef AG_SERIALIZATION
+
+typedef struct perf_json {
+	AG_DataSource *_Nonnull ds;
+	int rv;					/* Error status */
+	Uint32 _pad;
+} PerfJSON;
+
+static void JsonPrintf(PerfJSON *_Nonnull, const char *_Nonnull, ...)
+                      FORMAT_ATTRIBUTE(printf,2,3);
+
+static void
+JsonPrintf(PerfJSON *_Nonnull js, const char *fmt, ...)
+{
+	char buf[512];
+	va_list ap;
+
+	if (js->rv != 0) {
+		return;
+	}
+	va_start(ap, fmt);
+	Vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+	js->rv = AG_Write(js->ds, buf, strlen(buf));
+}
+
+/* Write s as a quoted JSON string. */
+static void
+JsonString(PerfJSON *_Nonnull js, const char *_Nonnull s)
+{
+	char buf[AG_PERF_NAME_MAX*6 + 3], *d = buf;
+	const char *c;
+
+	*d++ = '"';
+	for (c = s; *c != '\0'; c++) {
+		if (*c == '"' || *c == '\\') {
+			*d++ = '\\';
+			*d++ = *c;
+		} else if ((Uchar)*c < 0x20) {
+			Snprintf(d, 7, "\\u%04x", (Uint)(Uchar)*c);
+			d += 6;
+		} else {
+			*d++ = *c;
+		}
+	}
+	*d++ = '"';
+	*d = '\0';
+	JsonPrintf(js, "%s", buf);
+}
+
+static void
+JsonHist(PerfJSON *_Nonnull js, const AG_PerfHist *_Nonnull h)
+{
+	int i;
+
+	JsonPrintf(js,
+	    "\"count\": %llu, \"sum_ns\": %llu, "
+	    "\"min_ns\": %llu, \"max_ns\": %llu, "
+	    "\"p50_ns\": %llu, \"p95_ns\": %llu, \"p99_ns\": %llu, \"bins\": [",
+	    (unsigned long long)h->n,
+	    (unsigned long long)h->tSum,
+	    (unsigned long long)h->tMin,
+	    (unsigned long long)h->tMax,
+	    (unsigned long long)AG_PerfHistPercentile(h, 50),
+	    (unsigned long long)AG_PerfHistPercentile(h, 95),
+	    (unsigned long long)AG_PerfHistPercentile(h, 99));
+	for (i = 0; i < AG_PERF_NBINS; i++) {
+		JsonPrintf(js, (i < AG_PERF_NBINS-1) ? "%llu," : "%llu]",
+		    (unsigned long long)h->bins[i]);
+	}
+}
+
+/*
+ * Write the current counters and histograms as a JSON object to ds.
+ * Histogram bin i counts samples shorter than 2^(i+10) ns (and longer
+ * than the limit of bin i-1); the last bin has no upper bound.
+ */
+int
+AG_PerfWriteJSON(AG_DataSource *ds)
+{
+	PerfJSON js;
+	int i, j, nEnts;
+
+	js.ds = ds;
+	js.rv = 0;
+
+	AG_MutexLock(&agPerfLock);
+	JsonPrintf(&js, "{\n  \"version\": 1,\n  \"enabled\": %s,\n"
+	                "  \"elapsed_ns\": %llu,\n  \"bin_base_ns\": 1024,\n"
+	                "  \"counters\": {\n",
+	    agPerf.enabled ? "true" : "false",
+	    (unsigned long long)(AG_PerfTime() - agPerf.tReset));
+	for (i = 0; i < AG_PERF_COUNTER_LAST; i++) {
+		JsonPrintf(&js, "    \"%s\": %llu%s\n", agPerfCounterNames[i],
+		    (unsigned long long)agPerf.counters[i],
+		    (i < AG_PERF_COUNTER_LAST-1) ? "," : "");
+	}
+	JsonPrintf(&js, "  },\n  \"histograms\": {\n");
+	for (i = 0; i < AG_PERF_HIST_LAST; i++) {
+		JsonPrintf(&js, "    \"%s\": {", agPerfHistNames[i]);
+		JsonHist(&js, &agPerf.hists[i]);
+		JsonPrintf(&js, "}%s\n", (i < AG_PERF_HIST_LAST-1) ? "," : "");
+	}
+	JsonPrintf(&js, "  }");
+	for (i = 0; i < AG_PERF_KEYED_LAST; i++) {
+		const AG_PerfKeyed *kt = &agPerf.keyed[i];
+
+		JsonPrintf(&js, ",\n  \"%s\": [", agPerfKeyedNames[i]);
+		for (j = 0, nEnts = 0; j < AG_PERF_KEYED_MAX; j++) {
+			const AG_PerfHist *h = kt->ents[j];
+
+			if (h == NULL || h->n == 0) {
+				continue;
+			}
+			JsonPrintf(&js, "%s\n    {\"name\": ",
+			    (nEnts++ > 0) ? "," : "");
+			JsonString(&js, h->name);
+			JsonPrintf(&js, ", ");
+			JsonHist(&js, h);
+			JsonPrintf(&js, "}");
+		}
+		JsonPrintf(&js, (nEnts > 0) ? "\n  ]" : "]");
+		JsonPrintf(&js, ",\n  \"%s_dropped\": %u", agPerfKeyedNames[i],
+		    kt->nDropped);
+	}
+	JsonPrintf(&js, "\n}\n");
+	AG_MutexUnlock(&agPerfLock);
+	return (js.rv);
+}
+
+/* Write the current counters and histograms as JSON to a file. */
+int
+AG_PerfSaveJSON(const char *path)
+{
+	AG_DataSource *ds;
+	int rv;
+
+	if ((ds = AG_OpenFile(path, "wb")) == NULL) {
+		return (-1);
+	}
+	rv = AG_PerfWriteJSON(ds);
+	AG_CloseFile(ds);
+	return (rv);
+}
+
+/*
+ * Return the current counters and histograms as a newly-allocated,
+ * NUL-terminated JSON string.
+ */
+char *
+AG_PerfExportJSON(void)
+{
+	AG_DataSource *ds;
+	AG_CoreSource *cs;
+	char *s;
+
+	if ((ds = AG_OpenAutoCore()) == NULL) {
+		return (NULL);
+	}
+	if (AG_PerfWriteJSON(ds) == -1 ||
+	    AG_Write(ds, "", 1) == -1) {
+		AG_CloseAutoCore(ds);
+		return (NULL);
+	}
+	cs = AG_CORE_SOURCE(ds);
+	if ((s = TryMalloc(cs->size)) != NULL) {
+		memcpy(s, cs->data, cs->size);
+	}
+	AG_CloseAutoCore(ds);
+	return (s);
+}
+
+#endif /* AG_SERIALIZATION */
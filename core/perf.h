@@ -0,0 +1,118 @@
+/*	Public domain	*/
+/*
+ * Low-overhead performance counters and timing histograms.
+ */
+
+#ifndef _AGAR_CORE_PERF_H_
+#define _AGAR_CORE_PERF_H_
+#include <agar/core/begin.h>
+
+#ifndef AG_PERF_NBINS
+#define AG_PERF_NBINS 24		/* Histogram bins (<1us to >4s) */
+#endif
+#ifndef AG_PERF_NAME_MAX
+#define AG_PERF_NAME_MAX 32		/* Display name of keyed histograms */
+#endif
+#ifndef AG_PERF_KEYED_MAX
+#define AG_PERF_KEYED_MAX 256		/* Slots per keyed table (power of 2) */
+#endif
+
+/* Timing histograms. */
+enum ag_perf_hist_id {
+	AG_PERF_EVENT_WAIT,		/* Blocked waiting for events */
+	AG_PERF_TIMERS,			/* Processing expired timers */
+	AG_PERF_FRAME,			/* Rendering all queued windows */
+	AG_PERF_WINDOW_DRAW,		/* Rendering a window */
+	AG_PERF_TEXTURE_UPLOAD,		/* Uploading or updating a texture */
+	AG_PERF_HIST_LAST
+};
+
+/* Event counters. */
+enum ag_perf_counter_id {
+	AG_PERF_FRAMES,			/* Frames rendered */
+	AG_PERF_TIMERS_FIRED,		/* Timer callbacks invoked */
+	AG_PERF_GLYPH_HITS,		/* Glyph cache hits */
+	AG_PERF_GLYPH_MISSES,		/* Glyph cache misses */
+	AG_PERF_TEXTURE_UPLOADS,	/* Texture uploads and updates */
+	AG_PERF_TEXTURE_BYTES,		/* Bytes of texture data uploaded */
+	AG_PERF_COUNTER_LAST
+};
+
+/* Tables of timing histograms keyed by pointer. */
+enum ag_perf_keyed_id {
+	AG_PERF_BY_WINDOW,		/* Rendering time per window */
+	AG_PERF_BY_WIDGET_CLASS,	/* Draw time per widget class */
+	AG_PERF_KEYED_LAST
+};
+
+typedef struct ag_perf_hist {
+	const void *_Nullable key;	/* Key (in keyed tables) */
+	char name[AG_PERF_NAME_MAX];	/* Display name (in keyed tables) */
+	Uint64 n;			/* Number of samples */
+	Uint64 tSum;			/* Sum of samples (ns) */
+	Uint64 tMin, tMax;		/* Shortest and longest sample (ns) */
+	Uint64 bins[AG_PERF_NBINS];	/* Sample counts (see AG_PerfBinMax) */
+} AG_PerfHist;
+
+typedef struct ag_perf_keyed {
+	AG_PerfHist *_Nullable ents[AG_PERF_KEYED_MAX];	/* Open addressing */
+	Uint nEnts;					/* Entry count */
+	Uint nDropped;					/* Samples lost (full) */
+} AG_PerfKeyed;
+
+typedef struct ag_perf {
+	int enabled;				/* Collect timings */
+	Uint32 _pad;
+	Uint64 tReset;				/* Time of last reset (ns) */
+	Uint64 counters[AG_PERF_COUNTER_LAST];
+	AG_PerfHist hists[AG_PERF_HIST_LAST];
+	AG_PerfKeyed keyed[AG_PERF_KEYED_LAST];
+} AG_Perf;
+
+/* Upper bound (exclusive, in ns) of the samples counted in bin i. */
+#define AG_PerfBinMax(i) (((Uint64)1) << ((i)+10))
+
+/* Increment an event counter. */
+#define AG_PerfCount(c)		(agPerf.counters[(c)]++)
+#define AG_PerfCountN(c,n)	(agPerf.counters[(c)] += (Uint64)(n))
+
+/* Start timing. Returns 0 if AG_Perf is disabled. */
+#define AG_PerfBegin()		(agPerf.enabled ? AG_PerfTime() : (Uint64)0)
+
+__BEGIN_DECLS
+extern AG_Perf agPerf;
+#ifdef AG_THREADS
+extern _Nonnull_Mutex AG_Mutex agPerfLock;
+#endif
+
+void   AG_InitPerf(void);
+void   AG_DestroyPerf(void);
+
+Uint64 AG_PerfTime(void);
+void   AG_PerfSetEnabled(int);
+void   AG_PerfReset(void);
+
+void   AG_PerfEnd(enum ag_perf_hist_id, Uint64);
+void   AG_PerfEndKeyed(enum ag_perf_keyed_id, const void *_Nonnull,
+                       const char *_Nonnull, Uint64);
+void   AG_PerfKeyedAdd(enum ag_perf_keyed_id, const void *_Nonnull,
+                       const char *_Nonnull, Uint64);
+void   AG_PerfForget(enum ag_perf_keyed_id, const void *_Nonnull);
+void   AG_PerfHistAdd(AG_PerfHist *_Nonnull, Uint64);
+Uint64 AG_PerfHistPercentile(const AG_PerfHist *_Nonnull, int)
+                            _Pure_Attribute;
+
+const char *_Nonnull AG_PerfHistName(enum ag_perf_hist_id) _Const_Attribute;
+const char *_Nonnull AG_PerfCounterName(enum ag_perf_counter_id)
+                                       _Const_Attribute;
+const char *_Nonnull AG_PerfKeyedName(enum ag_perf_keyed_id) _Const_Attribute;
+
+#ifdef AG_SERIALIZATION
+int             AG_PerfWriteJSON(AG_DataSource *_Nonnull);
+int             AG_PerfSaveJSON(const char *_Nonnull);
+char *_Nullable AG_PerfExportJSON(void) _Warn_Unused_Result;
+#endif
+__END_DECLS
+
+#include <agar/core/close.h>
+#endif /* _AGAR_CORE_PERF_H_ */
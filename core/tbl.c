@@ -25,6 +25,13 @@
 
 /*
  * Implementation of a generic hash table of AG_Variable(3) items.
+ *
+ * By default, the table has a fixed number of buckets (each bucket being
+ * an array of entries). With AG_TBL_OPENADDR, entries are stored in a
+ * single array of slots using open addressing with linear probing, and
+ * the full hash of each entry is cached in a separate array (so probing
+ * only needs to compare keys on hash match). The slot array is resized
+ * automatically to keep the load factor under 3/4.
  */
 
 #include <agar/core/core.h>
@@ -44,13 +51,33 @@ AG_TblNew(Uint nBuckets, Uint flags)
 	return (t);
 }
 
-/* Initialize a table structure. */
+/*
+ * Initialize a table structure. With AG_TBL_OPENADDR, nBuckets is the
+ * initial number of slots (rounded up to a power of two).
+ */
 void
 AG_TblInit(AG_Tbl *tbl, Uint nBuckets, Uint flags)
 {
 	Uint i;
 
 	tbl->flags = flags;
+	tbl->hashes = NULL;
+	tbl->ents = NULL;
+	tbl->nEnts = 0;
+	tbl->nDeleted = 0;
+
+	if (flags & AG_TBL_OPENADDR) {
+		Uint nSlots;
+
+		for (nSlots = AG_TBL_OPENADDR_MIN; nSlots < nBuckets; nSlots <<= 1)
+			;;
+		tbl->nBuckets = nSlots;
+		tbl->buckets = NULL;
+		tbl->hashes = Malloc(nSlots*sizeof(Uint32));
+		tbl->ents = Malloc(nSlots*sizeof(AG_TblEnt));
+		memset(tbl->hashes, 0, nSlots*sizeof(Uint32));
+		return;
+	}
 	tbl->nBuckets = nBuckets;
 	tbl->buckets = Malloc(nBuckets*sizeof(AG_TblBucket));
 
@@ -68,6 +95,17 @@ AG_TblDestroy(AG_Tbl *t)
 {
 	Uint i, j;
 
+	if (t->flags & AG_TBL_OPENADDR) {
+		for (i = 0; i < t->nBuckets; i++) {
+			if (t->hashes[i] > AG_TBL_SLOT_DELETED) {
+				free(t->ents[i].key);
+				AG_FreeVariable(&t->ents[i].V);
+			}
+		}
+		free(t->hashes);
+		free(t->ents);
+		return;
+	}
 	for (i = 0; i < t->nBuckets; i++) {
 		AG_TblBucket *buck = &t->buckets[i];
 
@@ -81,13 +119,133 @@ AG_TblDestroy(AG_Tbl *t)
 	free(t->buckets);
 }
 
+/*
+ * Return the slot index of the entry matching the given key and hash in
+ * an OPENADDR table, or -1 if there is no such entry.
+ */
+static __inline__ int
+OpenAddrFind(const AG_Tbl *_Nonnull tbl, Uint32 h, const char *_Nonnull key)
+{
+	const Uint mask = tbl->nBuckets - 1;
+	Uint i;
+
+	for (i = h & mask; ; i = (i+1) & mask) {
+		const Uint32 hSlot = tbl->hashes[i];
+
+		if (hSlot == AG_TBL_SLOT_EMPTY) {
+			return (-1);
+		}
+		if (hSlot == h && strcmp(tbl->ents[i].key, key) == 0)
+			return (int)i;
+	}
+}
+
+/*
+ * Resize the slot array of an OPENADDR table, discarding deleted slots.
+ * Entries are moved, so any pointer to an entry is invalidated.
+ */
+static int
+OpenAddrResize(AG_Tbl *_Nonnull tbl, Uint nSlotsNew)
+{
+	const Uint mask = nSlotsNew - 1;
+	Uint32 *hashesNew;
+	AG_TblEnt *entsNew;
+	Uint i, j;
+
+	if ((hashesNew = TryMalloc(nSlotsNew*sizeof(Uint32))) == NULL) {
+		return (-1);
+	}
+	if ((entsNew = TryMalloc(nSlotsNew*sizeof(AG_TblEnt))) == NULL) {
+		free(hashesNew);
+		return (-1);
+	}
+	memset(hashesNew, 0, nSlotsNew*sizeof(Uint32));
+
+	for (i = 0; i < tbl->nBuckets; i++) {
+		const Uint32 h = tbl->hashes[i];
+
+		if (h <= AG_TBL_SLOT_DELETED) {
+			continue;
+		}
+		for (j = h & mask;
+		     hashesNew[j] != AG_TBL_SLOT_EMPTY;
+		     j = (j+1) & mask)
+			;;
+		hashesNew[j] = h;
+		memcpy(&entsNew[j], &tbl->ents[i], sizeof(AG_TblEnt));
+	}
+	free(tbl->hashes);
+	free(tbl->ents);
+	tbl->hashes = hashesNew;
+	tbl->ents = entsNew;
+	tbl->nBuckets = nSlotsNew;
+	tbl->nDeleted = 0;
+	return (0);
+}
+
+/* Insert a new entry into an OPENADDR table. */
+static int
+OpenAddrInsert(AG_Tbl *_Nonnull tbl, Uint32 h, const char *_Nonnull key,
+    const AG_Variable *_Nonnull V)
+{
+	Uint mask, i;
+	int iFree = -1;
+	char *keyDup;
+
+	if ((tbl->nEnts + tbl->nDeleted + 1)*4 > tbl->nBuckets*3) {
+		/* Grow, or only discard deleted slots if they are many. */
+		if (OpenAddrResize(tbl, ((tbl->nEnts + 1)*2 > tbl->nBuckets) ?
+		                        (tbl->nBuckets << 1) :
+		                        tbl->nBuckets) == -1)
+			return (-1);
+	}
+	mask = tbl->nBuckets - 1;
+	for (i = h & mask; ; i = (i+1) & mask) {
+		const Uint32 hSlot = tbl->hashes[i];
+
+		if (hSlot == AG_TBL_SLOT_EMPTY) {
+			break;
+		}
+		if (hSlot == AG_TBL_SLOT_DELETED) {
+			if (iFree == -1) { iFree = (int)i; }
+			continue;
+		}
+		if (hSlot == h && !(tbl->flags & AG_TBL_DUPLICATES) &&
+		    strcmp(tbl->ents[i].key, key) == 0) {
+			AG_SetErrorV("E27", "Table entry exists");
+			return (-1);
+		}
+	}
+	if ((keyDup = TryStrdup(key)) == NULL) {
+		return (-1);
+	}
+	if (iFree != -1) {
+		i = (Uint)iFree;
+		tbl->nDeleted--;
+	}
+	tbl->hashes[i] = h;
+	tbl->ents[i].key = keyDup;
+	AG_CopyVariable(&tbl->ents[i].V, V);
+	tbl->nEnts++;
+	return (0);
+}
+
 /* Look up a named table entry. */
 AG_Variable *
 AG_TblLookupHash(AG_Tbl *tbl, Uint h, const char *key)
 {
-	AG_TblBucket *buck = &tbl->buckets[h];
+	AG_TblBucket *buck;
 	Uint i;
 
+	if (tbl->flags & AG_TBL_OPENADDR) {
+		int iSlot;
+
+		if ((iSlot = OpenAddrFind(tbl, (Uint32)h, key)) == -1) {
+			return (NULL);
+		}
+		return (&tbl->ents[iSlot].V);
+	}
+	buck = &tbl->buckets[h];
 	for (i = 0; i < buck->nEnts; i++) {
 		if (strcmp(buck->keys[i], key) == 0)
 			break;
@@ -102,9 +260,13 @@ AG_TblLookupHash(AG_Tbl *tbl, Uint h, const char *key)
 int
 AG_TblExistsHash(AG_Tbl *tbl, Uint h, const char *key)
 {
-	AG_TblBucket *buck = &tbl->buckets[h];
+	AG_TblBucket *buck;
 	Uint i;
 	
+	if (tbl->flags & AG_TBL_OPENADDR) {
+		return (OpenAddrFind(tbl, (Uint32)h, key) != -1);
+	}
+	buck = &tbl->buckets[h];
 	for (i = 0; i < buck->nEnts; i++) {
 		if (strcmp(buck->keys[i], key) == 0)
 			return (1);
@@ -119,11 +281,15 @@ AG_TblExistsHash(AG_Tbl *tbl, Uint h, const char *key)
 int
 AG_TblInsertHash(AG_Tbl *tbl, Uint h, const char *key, const AG_Variable *V)
 {
-	AG_TblBucket *buck = &tbl->buckets[h];
+	AG_TblBucket *buck;
 	AG_Variable *entsNew;
 	char **keysNew;
 	Uint i;
 
+	if (tbl->flags & AG_TBL_OPENADDR) {
+		return OpenAddrInsert(tbl, (Uint32)h, key, V);
+	}
+	buck = &tbl->buckets[h];
 	for (i = 0; i < buck->nEnts; i++) {
 		if (strcmp(buck->keys[i], key) == 0)
 			break;
@@ -154,9 +320,24 @@ AG_TblInsertHash(AG_Tbl *tbl, Uint h, const char *key, const AG_Variable *V)
 int
 AG_TblDeleteHash(AG_Tbl *tbl, Uint h, const char *key)
 {
-	AG_TblBucket *buck = &tbl->buckets[h];
+	AG_TblBucket *buck;
 	Uint i;
 
+	if (tbl->flags & AG_TBL_OPENADDR) {
+		int iSlot;
+
+		if ((iSlot = OpenAddrFind(tbl, (Uint32)h, key)) == -1) {
+			AG_SetErrorV("E28", "No such table entry");
+			return (-1);
+		}
+		free(tbl->ents[iSlot].key);
+		AG_FreeVariable(&tbl->ents[iSlot].V);
+		tbl->hashes[iSlot] = AG_TBL_SLOT_DELETED;
+		tbl->nEnts--;
+		tbl->nDeleted++;
+		return (0);
+	}
+	buck = &tbl->buckets[h];
 	for (i = 0; i < buck->nEnts; i++) {
 		if (strcmp(buck->keys[i], key) == 0)
 			break;
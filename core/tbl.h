@@ -14,14 +14,34 @@ typedef struct ag_tbl_bucket {
 	Uint32 _pad;
 } AG_TblBucket;
 
+/* Entry in an open-addressing table. */
+typedef struct ag_tbl_ent {
+	char *_Nonnull key;
+	AG_Variable V;
+} AG_TblEnt;
+
 typedef struct ag_tbl {
 	Uint flags;
 #define AG_TBL_DUPLICATES	0x01	/* Allow duplicate entries */
+#define AG_TBL_OPENADDR		0x02	/* Open addressing (auto-resizing) */
+
+	Uint                   nBuckets;	/* Bucket (or slot) count */
+	AG_TblBucket *_Nullable buckets;	/* Hash buckets */
 
-	Uint                  nBuckets;		/* Bucket count */
-	AG_TblBucket *_Nonnull buckets;		/* Hash buckets */
+	Uint32 *_Nullable    hashes;		/* Cached hashes (OPENADDR) */
+	AG_TblEnt *_Nullable ents;		/* Entries (OPENADDR) */
+	Uint                 nEnts;		/* Entry count (OPENADDR) */
+	Uint                 nDeleted;		/* Deleted slots (OPENADDR) */
 } AG_Tbl;
 
+#ifndef AG_TBL_OPENADDR_MIN
+#define AG_TBL_OPENADDR_MIN 8		/* Minimum slot count (power of 2) */
+#endif
+
+/* Reserved values in the hashes[] array of OPENADDR tables. */
+#define AG_TBL_SLOT_EMPTY	0
+#define AG_TBL_SLOT_DELETED	1
+
 __BEGIN_DECLS
 AG_Tbl *_Nonnull AG_TblNew(Uint, Uint);
 void             AG_TblInit(AG_Tbl *_Nonnull, Uint, Uint);
@@ -35,12 +55,23 @@ int                    AG_TblInsertHash(AG_Tbl *_Nonnull, Uint, const char *_Non
                                         const AG_Variable *_Nonnull);
 int                    AG_TblDeleteHash(AG_Tbl *_Nonnull, Uint, const char *_Nonnull);
 
-/* Iterate over each entry. */
+/*
+ * Iterate over each entry. With OPENADDR tables, it is safe to delete the
+ * current entry while iterating (but not to insert new entries).
+ */
+#define AG_TBL_NENTS(tbl,i)						\
+	(((tbl)->flags & AG_TBL_OPENADDR) ?				\
+	 ((tbl)->hashes[i] > AG_TBL_SLOT_DELETED) :			\
+	 (tbl)->buckets[i].nEnts)
+#define AG_TBL_ENT(tbl,i,j)						\
+	(((tbl)->flags & AG_TBL_OPENADDR) ?				\
+	 &(tbl)->ents[i].V :						\
+	 &(tbl)->buckets[i].ents[j])
 #define AG_TBL_FOREACH(var, i,j, tbl)					\
 	for ((i) = 0; ((i) < (tbl)->nBuckets); (i)++)			\
 		for ((j) = 0;						\
-		    ((j) < (tbl)->buckets[i].nEnts) &&			\
-		     ((var) = &(tbl)->buckets[i].ents[j]);		\
+		    ((j) < AG_TBL_NENTS((tbl),(i))) &&			\
+		     ((var) = AG_TBL_ENT((tbl),(i),(j)));		\
 		     (j)++)
 /*
  * Inlinables
@@ -37,6 +37,14 @@ AG_Object agTimerMgr;
 AG_Mutex agTimerLock;
 #endif
 
+/*
+ * Binary min-heap of running software timers (ordered by tSched), used
+ * when the event source does not provide timers (or AG_SOFT_TIMERS is set).
+ */
+static AG_Timer *_Nonnull *_Nullable agTimerHeap = NULL;
+static Uint agTimerHeapCount = 0;
+static Uint agTimerHeapMax = 0;
+
 void
 AG_InitTimers(void)
 {
@@ -50,6 +58,116 @@ AG_DestroyTimers(void)
 {
 	AG_ObjectDestroy(&agTimerMgr);
 	AG_MutexDestroy(&agTimerLock);
+
+	Free(agTimerHeap);
+	agTimerHeap = NULL;
+	agTimerHeapCount = 0;
+	agTimerHeapMax = 0;
+}
+
+/* Compare two scheduled expiration times (wraparound-safe). */
+#define TIMER_BEFORE(a,b) ((int)((a)->tSched - (b)->tSched) < 0)
+
+/* Move the timer at heap index i up to its position. */
+static void
+HeapUp(Uint i)
+{
+	AG_Timer *to = agTimerHeap[i];
+
+	while (i > 0) {
+		const Uint iParent = (i-1) >> 1;
+		AG_Timer *toParent = agTimerHeap[iParent];
+
+		if (!TIMER_BEFORE(to, toParent)) {
+			break;
+		}
+		agTimerHeap[i] = toParent;
+		toParent->pvt.heapIdx = (int)i;
+		i = iParent;
+	}
+	agTimerHeap[i] = to;
+	to->pvt.heapIdx = (int)i;
+}
+
+/* Move the timer at heap index i down to its position. */
+static void
+HeapDown(Uint i)
+{
+	AG_Timer *to = agTimerHeap[i];
+	const Uint n = agTimerHeapCount;
+
+	for (;;) {
+		Uint iChild = (i << 1) + 1;
+		AG_Timer *toChild;
+
+		if (iChild >= n) {
+			break;
+		}
+		if (iChild+1 < n &&
+		    TIMER_BEFORE(agTimerHeap[iChild+1], agTimerHeap[iChild])) {
+			iChild++;
+		}
+		toChild = agTimerHeap[iChild];
+		if (!TIMER_BEFORE(toChild, to)) {
+			break;
+		}
+		agTimerHeap[i] = toChild;
+		toChild->pvt.heapIdx = (int)i;
+		i = iChild;
+	}
+	agTimerHeap[i] = to;
+	to->pvt.heapIdx = (int)i;
+}
+
+/* Insert a timer into the software timer heap. */
+static int
+HeapInsert(AG_Timer *_Nonnull to)
+{
+	if (agTimerHeapCount+1 > agTimerHeapMax) {
+		Uint maxNew = (agTimerHeapMax > 0) ? (agTimerHeapMax << 1) :
+		                                     AG_TIMER_HEAP_INIT;
+		AG_Timer **heapNew;
+
+		if ((heapNew = TryRealloc(agTimerHeap,
+		    maxNew*sizeof(AG_Timer *))) == NULL) {
+			return (-1);
+		}
+		agTimerHeap = heapNew;
+		agTimerHeapMax = maxNew;
+	}
+	agTimerHeap[agTimerHeapCount] = to;
+	HeapUp(agTimerHeapCount++);
+	return (0);
+}
+
+/* Remove a timer from the software timer heap. */
+static void
+HeapRemove(AG_Timer *_Nonnull to)
+{
+	const Uint i = (Uint)to->pvt.heapIdx;
+	AG_Timer *toLast;
+
+#ifdef AG_DEBUG
+	if (to->pvt.heapIdx < 0 || i >= agTimerHeapCount ||
+	    agTimerHeap[i] != to)
+		AG_FatalError("Timer heap inconsistency");
+#endif
+	to->pvt.heapIdx = -1;
+	toLast = agTimerHeap[--agTimerHeapCount];
+	if (toLast != to) {
+		agTimerHeap[i] = toLast;
+		toLast->pvt.heapIdx = (int)i;
+		HeapUp(i);
+		HeapDown((Uint)toLast->pvt.heapIdx);
+	}
+}
+
+/* Restore the heap property after a change in the tSched of a timer. */
+static __inline__ void
+HeapUpdate(AG_Timer *_Nonnull to)
+{
+	HeapUp((Uint)to->pvt.heapIdx);
+	HeapDown((Uint)to->pvt.heapIdx);
 }
 
 /*
@@ -102,7 +220,6 @@ AG_AddTimer(void *p, AG_Timer *to, Uint32 ival, AG_TimerFn fn,
 {
 	AG_EventSource *src = AG_GetEventSource();
 	AG_Object *ob = (p != NULL) ? OBJECT(p) : &agTimerMgr;
-	AG_Timer *toOther;
 	int newTimer = 0;
 	AG_Event *ev;
 	
@@ -120,31 +237,23 @@ AG_AddTimer(void *p, AG_Timer *to, Uint32 ival, AG_TimerFn fn,
 		} else if (to->obj != ob) {
 			AG_FatalError("to->obj != ob");
 		}
-	} else {				/* Ordered timing wheel */
+	} else {				/* Software timer heap */
+		to->tSched = AG_GetTicks()+ival;
 		if (to->obj == NULL) {
+			if (HeapInsert(to) == -1) {
+				AG_UnlockTimers(ob);
+				return (-1);
+			}
+			if (TAILQ_EMPTY(&ob->timers)) {
+				TAILQ_INSERT_TAIL(&agTimerObjQ, ob, tobjs);
+			}
+			TAILQ_INSERT_TAIL(&ob->timers, to, pvt.timers);
 			newTimer = 1;
 			to->obj = ob;
 		} else if (to->obj != ob) {
 			AG_FatalError("to->obj != ob");
-		}
-		if (TAILQ_EMPTY(&ob->timers)) {
-			TAILQ_INSERT_TAIL(&agTimerObjQ, ob, tobjs);
-		}
-		to->tSched = AG_GetTicks()+ival;
-reinsert:
-		TAILQ_FOREACH(toOther, &ob->timers, pvt.timers) {
-			if (toOther == to) {
-				newTimer = 0;
-				TAILQ_REMOVE(&ob->timers, to, pvt.timers);
-				goto reinsert;
-			}
-			if (to->tSched < toOther->tSched) {
-				TAILQ_INSERT_BEFORE(toOther, to, pvt.timers);
-				break;
-			}
-		}
-		if (toOther == TAILQ_END(&ob->timers)) {
-			TAILQ_INSERT_TAIL(&ob->timers, to, pvt.timers);
+		} else {
+			HeapUpdate(to);
 		}
 		to->ival = ival;
 		to->id = 0;				/* Not needed */
@@ -171,6 +280,9 @@ reinsert:
 	return (0);
 fail:
 	to->obj = NULL;
+	if (to->pvt.heapIdx != -1) {
+		HeapRemove(to);
+	}
 	TAILQ_REMOVE(&ob->timers, to, pvt.timers);
 	if (TAILQ_EMPTY(&ob->timers)) { TAILQ_REMOVE(&agTimerObjQ, ob, tobjs); }
 	AG_UnlockTimers(ob);
@@ -193,6 +305,7 @@ AG_InitTimer(AG_Timer *to, const char *name, Uint flags)
 	}
 	to->id = -1;
 	to->obj = NULL;
+	to->pvt.heapIdx = -1;
 	to->flags = flags;
 	to->ival = 0;
 	to->tSched = 0;
@@ -208,27 +321,19 @@ AG_ResetTimer(void *p, AG_Timer *to, Uint32 ival)
 {
 	AG_EventSource *src = AG_GetEventSource();
 	AG_Object *ob = (p != NULL) ? OBJECT(p) : &agTimerMgr;
-	AG_Timer *toOther;
 	int rv = 0;
 	
 	AG_LockTimers(ob);
+	if (!src->caps[AG_SINK_TIMER]) {	/* Software timer heap */
+		to->tSched = AG_GetTicks()+ival;
+		if (to->pvt.heapIdx != -1)
+			HeapUpdate(to);
+	}
 	if (src->addTimerFn != NULL &&
 	    src->addTimerFn(to, ival, 0) == -1) {
 		rv = -1;
 		goto out;
 	}
-	if (!src->caps[AG_SINK_TIMER]) {	/* Ordered timing wheel */
-		to->tSched = AG_GetTicks()+ival;
-		TAILQ_REMOVE(&ob->timers, to, pvt.timers);
-		TAILQ_FOREACH(toOther, &ob->timers, pvt.timers) {
-			if (to->tSched < toOther->tSched) {
-				TAILQ_INSERT_BEFORE(toOther, to, pvt.timers);
-				break;
-			}
-		}
-		if (toOther == TAILQ_END(&ob->timers))
-			TAILQ_INSERT_TAIL(&ob->timers, to, pvt.timers);
-	}
 	to->ival = ival;
 out:
 	AG_UnlockTimers(ob);
@@ -241,20 +346,18 @@ AG_DelTimer(void *p, AG_Timer *to)
 {
 	AG_EventSource *src = AG_GetEventSource();
 	AG_Object *ob = (p != NULL) ? OBJECT(p) : &agTimerMgr;
-	AG_Timer *toOther;
 
 	AG_LockTimers(ob);
 	
-	TAILQ_FOREACH(toOther, &ob->timers, pvt.timers) {
-		if (toOther == to)
-			break;
-	}
-	if (toOther == NULL) 		/* Timer is not active */
+	if (to->obj != ob) 		/* Timer is not active */
 		goto out;
 
 	if (src->delTimerFn != NULL) {
 		src->delTimerFn(to);
 	}
+	if (to->pvt.heapIdx != -1) {
+		HeapRemove(to);
+	}
 	to->id = -1;
 	to->obj = NULL;
 
@@ -294,13 +397,8 @@ int
 AG_TimerIsRunning(void *p, AG_Timer *to)
 {
 	AG_Object *ob = (p != NULL) ? OBJECT(p) : &agTimerMgr;
-	AG_Timer *toRunning;
 
-	TAILQ_FOREACH(toRunning, &ob->timers, pvt.timers) {
-		if (toRunning == to)
-			break;
-	}
-	return (toRunning != NULL);
+	return (to->obj == ob);
 }
 
 /* Invoke a timer callback routine artificially. */
@@ -320,42 +418,61 @@ AG_ExecTimer(AG_Timer *to)
  * as a time source. This is used on platforms where system timers are not
  * available and delay loops are the only option.
  *
+ * Expired timers are popped from the software timer heap, so the cost is
+ * proportional to the number of expired timers (not the number of timers).
+ *
  * Applications calling this routine explicitely must pass AG_SOFT_TIMERS to
  * AG_InitCore().
  */
 void
 AG_ProcessTimeouts(Uint32 t)
 {
-	AG_Timer *to, *toNext;
-	AG_Object *ob, *obNext;
+	AG_Timer *to;
+	AG_Object *ob;
+	Uint64 t0 = 0;
 	Uint32 rv;
 
 	AG_LockTiming();
-
-	for (ob = TAILQ_FIRST(&agTimerObjQ);
-	     ob != TAILQ_END(&agTimerObjQ);
-	     ob = obNext) {
-		obNext = TAILQ_NEXT(ob, tobjs);
+	while (agTimerHeapCount > 0) {
+		to = agTimerHeap[0];
+		if ((int)(to->tSched - t) > 0) {
+			break;
+		}
+		if (t0 == 0) {
+			t0 = AG_PerfBegin();
+		}
+		AG_PerfCount(AG_PERF_TIMERS_FIRED);
+		ob = to->obj;
 		AG_ObjectLock(ob);
-rescan:
-		for (to = TAILQ_FIRST(&ob->timers);
-		     to != TAILQ_END(&ob->timers);
-		     to = toNext) {
-			toNext = TAILQ_NEXT(to, pvt.timers);
-
-			if ((int)(to->tSched - t) > 0) {
-				continue;
-			}
-			rv = to->fn(to, &to->fnEvent);
-			if (rv > 0) {				/* Restart */
-				(void)AG_ResetTimer(ob, to, rv);
-				goto rescan;
-			} else {				/* Cancel */
-				AG_DelTimer(ob, to);
-			}
+		rv = to->fn(to, &to->fnEvent);
+		if (rv > 0) {				/* Restart */
+			(void)AG_ResetTimer(ob, to, rv);
+		} else {				/* Cancel */
+			AG_DelTimer(ob, to);
 		}
 		AG_ObjectUnlock(ob);
 	}
+	AG_PerfEnd(AG_PERF_TIMERS, t0);
 	AG_UnlockTiming();
 }
+
+/*
+ * Return the number of ticks from t until the next software timer expires,
+ * 0 if a timer has already expired, or AG_TIMEOUT_NONE if there are no
+ * running software timers. The caller should use AG_LockTiming().
+ */
+Uint32
+AG_NextTimeout(Uint32 t)
+{
+	AG_Timer *to;
+
+	if (agTimerHeapCount == 0) {
+		return (AG_TIMEOUT_NONE);
+	}
+	to = agTimerHeap[0];
+	if ((int)(to->tSched - t) <= 0) {
+		return (0);
+	}
+	return (to->tSched - t);
+}
 #endif /* AG_TIMERS */
@@ -312,15 +312,239 @@ AG_Unset(void *pObj, const char *name)
 #ifdef AG_DEBUG
 	Debug2(obj, "Unset \"" AGSI_YEL "%s" AGSI_RST "\"\n", name);
 #endif
+	if ((V = AG_LookupVariable(obj, name)) != NULL) {
+		AG_RemoveVariable(obj, V);
+		AG_FreeVariable(V);
+		free(V);
+	}
+}
+
+/*
+ * Build the hashed variable index of an object. The index is an
+ * auto-resizing AG_Tbl(3) mapping variable names to AG_Variable pointers.
+ */
+static void
+BuildVariableIndex(AG_Object *_Nonnull obj)
+{
+	AG_Tbl *tbl;
+	AG_Variable *V;
+
+	tbl = AG_TblNew(obj->nVars << 1, AG_TBL_OPENADDR);
 	TAILQ_FOREACH(V, &obj->vars, vars) {
-		if (strcmp(V->name, name) == 0) {
-			TAILQ_REMOVE(&obj->vars, V, vars);
-			AG_FreeVariable(V);
-			free(V);
+		if (AG_TblInsertPointer(tbl, V->name, V) != 0)
+			AG_FatalError(NULL);
+	}
+	obj->varIndex = tbl;
+}
+
+/*
+ * Look up an object variable by name (without dereferencing).
+ * The object must be locked.
+ */
+AG_Variable *
+AG_LookupVariable(void *pObj, const char *name)
+{
+	AG_Object *obj = pObj;
+	AG_Variable *V;
+
+	if (obj->varIndex != NULL) {
+		void *p;
+
+		if (AG_TblLookupPointer(obj->varIndex, name, &p) == 0) {
+			return (AG_Variable *)p;
+		}
+		return (NULL);
+	}
+	TAILQ_FOREACH(V, &obj->vars, vars) {
+		if (strcmp(V->name, name) == 0)
 			break;
+	}
+	return (V);
+}
+
+/*
+ * Attach a newly-initialized variable to an object. The name must not be
+ * in use. The index is created once AG_OBJECT_VAR_INDEX_MIN is exceeded.
+ * The object must be locked.
+ */
+void
+AG_InsertVariable(void *pObj, AG_Variable *V)
+{
+	AG_Object *obj = pObj;
+
+	TAILQ_INSERT_TAIL(&obj->vars, V, vars);
+	obj->nVars++;
+
+	if (obj->varIndex == NULL) {
+		if (obj->nVars > AG_OBJECT_VAR_INDEX_MIN)
+			BuildVariableIndex(obj);
+	} else {
+		if (AG_TblInsertPointer(obj->varIndex, V->name, V) != 0)
+			AG_FatalError(NULL);
+	}
+}
+
+/*
+ * Detach a variable from an object (without freeing it). Invalidates any
+ * AG_VariableHandle(3) resolved against the object. The object must be locked.
+ */
+void
+AG_RemoveVariable(void *pObj, AG_Variable *V)
+{
+	AG_Object *obj = pObj;
+
+	if (obj->varIndex != NULL) {
+		AG_TblDelete(obj->varIndex, V->name);
+	}
+	TAILQ_REMOVE(&obj->vars, V, vars);
+	obj->nVars--;
+	obj->varGen++;
+}
+
+/* Release the hashed variable index of an object (if any). */
+void
+AG_VariableIndexFree(void *pObj)
+{
+	AG_Object *obj = pObj;
+
+	if (obj->varIndex != NULL) {
+		AG_TblDestroy(obj->varIndex);
+		free(obj->varIndex);
+		obj->varIndex = NULL;
+	}
+}
+
+/*
+ * Initialize a handle on the named variable of an object. The variable
+ * need not exist yet; it is resolved on first access.
+ */
+void
+AG_InitVariableHandle(AG_VariableHandle *h, void *obj, const char *name)
+{
+	h->obj = obj;
+	h->var = NULL;
+	h->gen = 0;
+	Strlcpy(h->name, name, sizeof(h->name));
+}
+
+/*
+ * Return the variable referenced by a handle, resolving it again only if
+ * variables were removed from the object since the last access. As with
+ * AG_AccessVariable(), references are followed and the variable is returned
+ * locked. Returns NULL if the variable is undefined. The object must be
+ * locked.
+ */
+AG_Variable *
+AG_AccessVariableHandle(AG_VariableHandle *h)
+{
+	AG_Object *obj = h->obj;
+	AG_Variable *V, *Vtgt;
+
+	if (h->var == NULL || h->gen != obj->varGen) {
+		if ((h->var = AG_LookupVariable(obj, h->name)) == NULL) {
+			return (NULL);
+		}
+		h->gen = obj->varGen;
+	}
+	V = h->var;
+	if (V->type == AG_VARIABLE_P_VARIABLE) {
+		if ((Vtgt = AG_AccessVariable(V->data.p, V->info.varName)) == NULL) {
+			AG_FatalError(NULL);
 		}
+		return (Vtgt);
 	}
+	AG_LockVariable(V);
+	return (V);
+}
+
+/* Body of AG_GetFooH() routines. */
+#undef  FN_VARIABLE_GET_H
+#define FN_VARIABLE_GET_H(_memb,_type)				\
+	AG_Object *obj = h->obj;				\
+	AG_Variable *V;						\
+	_type rv;						\
+								\
+	AG_ObjectLock(obj);					\
+	if ((V = AG_AccessVariableHandle(h)) == NULL) {		\
+		AG_FatalErrorV("E20", "No such variable");	\
+	}							\
+	if (agVariableTypes[V->type].indirLvl > 0) {		\
+		rv = *(_type *)V->data.p;			\
+	} else {						\
+		rv = V->data._memb;				\
+	}							\
+	AG_UnlockVariable(V);					\
+	AG_ObjectUnlock(obj);					\
+	return (rv)
+
+/*
+ * Body of AG_SetFooH() routines. If the variable is undefined, fall back
+ * to AG_SetFoo() and resolve the handle on the next access.
+ */
+#undef  FN_VARIABLE_SET_H
+#define FN_VARIABLE_SET_H(_memb,_type,_setfn)			\
+	AG_Object *obj = h->obj;				\
+	AG_Variable *V;						\
+								\
+	AG_ObjectLock(obj);					\
+	if ((V = AG_AccessVariableHandle(h)) == NULL) {		\
+		_setfn(obj, h->name, v);			\
+		AG_ObjectUnlock(obj);				\
+		return;						\
+	}							\
+	if (agVariableTypes[V->type].indirLvl > 0) {		\
+		*(_type *)V->data.p = v;			\
+	} else {						\
+		V->data._memb = v;				\
+	}							\
+	AG_UnlockVariable(V);					\
+	AG_ObjectUnlock(obj)
+
+/*
+ * Handle-based accessors.
+ */
+Uint
+AG_GetUintH(AG_VariableHandle *h)
+{
+	FN_VARIABLE_GET_H(u, Uint);
+}
+void
+AG_SetUintH(AG_VariableHandle *h, Uint v)
+{
+	FN_VARIABLE_SET_H(u, Uint, AG_SetUint);
+}
+int
+AG_GetIntH(AG_VariableHandle *h)
+{
+	FN_VARIABLE_GET_H(i, int);
+}
+void
+AG_SetIntH(AG_VariableHandle *h, int v)
+{
+	FN_VARIABLE_SET_H(i, int, AG_SetInt);
 }
+#ifdef AG_HAVE_FLOAT
+float
+AG_GetFloatH(AG_VariableHandle *h)
+{
+	FN_VARIABLE_GET_H(flt, float);
+}
+void
+AG_SetFloatH(AG_VariableHandle *h, float v)
+{
+	FN_VARIABLE_SET_H(flt, float, AG_SetFloat);
+}
+double
+AG_GetDoubleH(AG_VariableHandle *h)
+{
+	FN_VARIABLE_GET_H(dbl, double);
+}
+void
+AG_SetDoubleH(AG_VariableHandle *h, double v)
+{
+	FN_VARIABLE_SET_H(dbl, double, AG_SetDouble);
+}
+#endif /* AG_HAVE_FLOAT */
 
 /* Generate "bound" event if BOUND_EVENTS flag is set */
 #undef  FN_POST_BOUND_EVENT
@@ -1362,14 +1586,10 @@ AG_SetString(void *pObj, const char *name, const char *s)
 	Debug2(obj, "Set \"" AGSI_YEL "%s" AGSI_RST "\" -> \""
 	    AGSI_BOLD "%s" AGSI_RST "\"\n", name, s);
 #endif
-	TAILQ_FOREACH(V, &obj->vars, vars) {
-		if (strcmp(V->name, name) == 0)
-			break;
-	}
-	if (V == NULL) {
+	if ((V = AG_LookupVariable(obj, name)) == NULL) {
 		V = Malloc(sizeof(AG_Variable));
 		AG_InitVariable(V, AG_VARIABLE_STRING, name);
-		TAILQ_INSERT_TAIL(&obj->vars, V, vars);
+		AG_InsertVariable(obj, V);
 
 		V->info.size = 0;				/* Allocated */
 		V->data.s = Strdup(s);
@@ -198,6 +198,30 @@ typedef struct ag_flag_descr_ro {
 	const char *_Nonnull descr;	/* Description (UTF-8) */
 } AG_FlagDescrRO;
 
+/*
+ * Handle on a named object variable. The name is resolved once and the
+ * handle is re-resolved only if variables have been deleted from the object
+ * since (see AG_InitVariableHandle(3)).
+ */
+typedef struct ag_variable_handle {
+	void *_Nonnull obj;                  /* Parent object */
+	struct ag_variable *_Nullable var;   /* Resolved variable (or NULL) */
+	Uint gen;                            /* Object variable generation */
+	char name[AG_VARIABLE_NAME_MAX];     /* Variable name */
+} AG_VariableHandle;
+
+/*
+ * Build a hashed index of an object's variables once its variable
+ * count exceeds this threshold.
+ */
+#ifndef AG_OBJECT_VAR_INDEX_MIN
+# if AG_MODEL == AG_SMALL
+#  define AG_OBJECT_VAR_INDEX_MIN 32
+# else
+#  define AG_OBJECT_VAR_INDEX_MIN 16
+# endif
+#endif
+
 __BEGIN_DECLS
 extern const AG_VariableTypeInfo agVariableTypes[];
 
@@ -220,6 +244,26 @@ int  AG_CompareVariables(const AG_Variable *_Nonnull,
                         _Pure_Attribute;
 void AG_Unset(void *_Nonnull, const char *_Nonnull);
 
+AG_Variable *_Nullable AG_LookupVariable(void *_Nonnull, const char *_Nonnull)
+                                        _Pure_Attribute_If_Unthreaded;
+void                   AG_InsertVariable(void *_Nonnull, AG_Variable *_Nonnull);
+void                   AG_RemoveVariable(void *_Nonnull, AG_Variable *_Nonnull);
+void                   AG_VariableIndexFree(void *_Nonnull);
+
+void                   AG_InitVariableHandle(AG_VariableHandle *_Nonnull,
+                                             void *_Nonnull, const char *_Nonnull);
+AG_Variable *_Nullable AG_AccessVariableHandle(AG_VariableHandle *_Nonnull);
+Uint                   AG_GetUintH(AG_VariableHandle *_Nonnull);
+void                   AG_SetUintH(AG_VariableHandle *_Nonnull, Uint);
+int                    AG_GetIntH(AG_VariableHandle *_Nonnull);
+void                   AG_SetIntH(AG_VariableHandle *_Nonnull, int);
+#ifdef AG_HAVE_FLOAT
+float                  AG_GetFloatH(AG_VariableHandle *_Nonnull);
+void                   AG_SetFloatH(AG_VariableHandle *_Nonnull, float);
+double                 AG_GetDoubleH(AG_VariableHandle *_Nonnull);
+void                   AG_SetDoubleH(AG_VariableHandle *_Nonnull, double);
+#endif
+
 /*
  * UINT: Natural unsigned integer
  */
@@ -46,7 +46,28 @@
 #include <errno.h>
 #include <ctype.h>
 
-static AG_ConsoleLine *AppendMultiLine(AG_Console *_Nonnull, const char *_Nonnull);
+#include <agar/config/_mk_have_sys_stat_h.h>
+#include <agar/config/_mk_have_unistd_h.h>
+#if !defined(_WIN32) && defined(_MK_HAVE_SYS_STAT_H) && \
+     defined(_MK_HAVE_UNISTD_H)
+# define USE_MMAP
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <unistd.h>
+# include <agar/config/have_sse2.h>
+# ifdef HAVE_SSE2
+#  include <emmintrin.h>
+# endif
+#endif
+
+static AG_ConsoleLine *_Nonnull AppendMultiLine(AG_Console *_Nonnull,
+                                                const char *_Nonnull);
+#ifdef USE_MMAP
+static const char *_Nullable MapLineText(AG_ConsoleFile *_Nonnull, Uint,
+                                         AG_Size *_Nonnull);
+static void DrawMapped(AG_Console *_Nonnull, AG_Rect *_Nonnull, int, int);
+static void MapCacheClear(AG_Console *_Nonnull, AG_ConsoleFile *_Nonnull);
+#endif
 
 AG_Console *
 AG_ConsoleNew(void *parent, Uint flags)
@@ -64,30 +85,233 @@ AG_ConsoleNew(void *parent, Uint flags)
 	return (cons);
 }
 
-static __inline__ void
-AdjustXoffs(AG_Console *_Nonnull cons)
+/* Return the line at index i (0 = oldest) in the ring buffer. */
+static __inline__ AG_ConsoleLine *_Nonnull
+GetLine(const AG_Console *_Nonnull cons, Uint i)
+{
+	Uint j = cons->lineHead + i;
+
+	if (j >= cons->lineCap) {
+		j -= cons->lineCap;
+	}
+	return (cons->lines[j]);
+}
+
+/* Number of lines displayed (from the mapped file or the ring buffer). */
+#define NLINES(cons) \
+	(((cons)->mapFile != NULL) ? (cons)->mapFile->nLines : (cons)->nLines)
+
+#define CHUNK_HDR      ((sizeof(AG_ConsoleChunk) + 7) & ~((AG_Size)7))
+#define CHUNK_DATA(ch) ((char *)(ch) + CHUNK_HDR)
+
+/* Append a new chunk to the arena (reusing the spare chunk if possible). */
+static AG_ConsoleChunk *_Nonnull
+NewChunk(AG_Console *_Nonnull cons, AG_Size size)
+{
+	AG_ConsoleChunk *ch;
+
+	if (size <= AG_CONSOLE_CHUNK_SIZE && cons->chunkSpare != NULL) {
+		ch = cons->chunkSpare;
+		cons->chunkSpare = NULL;
+	} else {
+		if (size < AG_CONSOLE_CHUNK_SIZE) {
+			size = AG_CONSOLE_CHUNK_SIZE;
+		}
+		ch = Malloc(CHUNK_HDR + size);
+		ch->size = size;
+	}
+	ch->next = NULL;
+	ch->used = 0;
+	ch->nLines = 0;
+
+	if (cons->chunkTail != NULL) {
+		cons->chunkTail->next = ch;
+	} else {
+		cons->chunkHead = ch;
+	}
+	cons->chunkTail = ch;
+	return (ch);
+}
+
+/* Free an arena chunk (or keep it as the spare chunk). */
+static void
+FreeChunk(AG_Console *_Nonnull cons, AG_ConsoleChunk *_Nonnull ch)
+{
+	if (ch->size == AG_CONSOLE_CHUNK_SIZE && cons->chunkSpare == NULL) {
+		cons->chunkSpare = ch;
+	} else {
+		free(ch);
+	}
+}
+
+/*
+ * Allocate a new line (and a copy of its text) from the arena.
+ * The line is not yet inserted into the ring buffer.
+ */
+static AG_ConsoleLine *_Nonnull
+AllocLine(AG_Console *_Nonnull cons, const char *_Nonnull s, AG_Size len)
+{
+	const AG_Size size = (sizeof(AG_ConsoleLine) + len + 1 + 7) &
+	                     ~((AG_Size)7);
+	AG_ConsoleChunk *ch = cons->chunkTail;
+	AG_ConsoleLine *ln;
+
+	if (ch == NULL || ch->used + size > ch->size) {
+		ch = NewChunk(cons, size);
+	}
+	ln = (AG_ConsoleLine *)(CHUNK_DATA(ch) + ch->used);
+	ch->used += size;
+	ch->nLines++;
+
+	ln->text = (char *)&ln[1];
+	memcpy(ln->text, s, len);
+	ln->text[len] = '\0';
+	ln->len = len;
+	ln->surface[0] = -1;
+	ln->surface[1] = -1;
+	AG_ColorNone(&ln->c);			/* Inherit default */
+	ln->p = NULL;
+	ln->cons = cons;
+	ln->parent = NULL;		/* Top level / standalone by default */
+	ln->chunk = ch;
+	ln->flags = 0;
+	return (ln);
+}
+
+/* Release the cached surfaces of a line. */
+static void
+UnmapLine(AG_Console *_Nonnull cons, AG_ConsoleLine *_Nonnull ln)
 {
 	Uint i;
-	const int wCons = WIDTH(cons);
-	const int wBar = WIDTH(cons->vBar) + WIDGET(cons)->paddingLeft;
-
-	for (i = 0, cons->wMax = 0;
-	     i < cons->nLines;
-	     i++) {
-		const AG_ConsoleLine *ln = cons->lines[i];
-		int w;
-
-		if (ln->surface[0] != -1) {
-			w = WSURFACE(cons,ln->surface[0])->w;
-		} else if (ln->surface[1] != -1) {
-			w = WSURFACE(cons,ln->surface[1])->w;
-		} else {
-			AG_TextSize(ln->text, &w, NULL);
+
+	if (ln->surface[0] == -1 && ln->surface[1] == -1) {
+		return;
+	}
+	for (i = 0; i < 2; i++) {
+		if (ln->surface[i] != -1) {
+			AG_WidgetUnmapSurface(cons, ln->surface[i]);
+			ln->surface[i] = -1;
+		}
+	}
+	for (i = 0; i < cons->nMapped; i++) {
+		if (cons->mapped[i] == ln) {
+			cons->mapped[i] = cons->mapped[--cons->nMapped];
+			break;
+		}
+	}
+}
+
+/* Release a line which has been removed from the ring buffer. */
+static void
+FreeLine(AG_Console *_Nonnull cons, AG_ConsoleLine *_Nonnull ln)
+{
+	AG_ConsoleChunk *ch = ln->chunk;
+
+	UnmapLine(cons, ln);
+
+	if (ln->flags & AG_CONSOLE_LINE_HEAP_TEXT)
+		free(ln->text);
+
+	if (--ch->nLines > 0) {
+		return;
+	}
+	if (ch == cons->chunkTail) {
+		ch->used = 0;
+		return;
+	}
+	while ((ch = cons->chunkHead) != cons->chunkTail && ch->nLines == 0) {
+		cons->chunkHead = ch->next;
+		FreeChunk(cons, ch);
+	}
+}
+
+/* Reallocate the ring buffer to the given size, unwrapping it. */
+static void
+ResizeRing(AG_Console *_Nonnull cons, Uint cap)
+{
+	AG_ConsoleLine **linesNew;
+	Uint i;
+
+	linesNew = Malloc(cap * sizeof(AG_ConsoleLine *));
+	for (i = 0; i < cons->nLines; i++) {
+		linesNew[i] = GetLine(cons, i);
+	}
+	Free(cons->lines);
+	cons->lines = linesNew;
+	cons->lineCap = cap;
+	cons->lineHead = 0;
+}
+
+/* Remove the oldest line from the ring buffer. */
+static void
+ShiftLine(AG_Console *_Nonnull cons)
+{
+	AG_ConsoleLine *ln = cons->lines[cons->lineHead];
+	Uint i;
+
+	if (++cons->lineHead == cons->lineCap) {
+		cons->lineHead = 0;
+	}
+	cons->nLines--;
+
+	for (i = 0; i < cons->nLines; i++) {      /* Orphan any child lines */
+		AG_ConsoleLine *lnChild = GetLine(cons, i);
+
+		if (lnChild->parent != ln) {
+			break;
+		}
+		if (lnChild->c.a == 0) {
+			memcpy(&lnChild->c, &ln->c, sizeof(AG_Color));
+		}
+		lnChild->parent = NULL;
+	}
+
+	if (cons->mapFile == NULL) {
+		if (cons->pos > 0) {
+			cons->pos--;
+		} else if (cons->pos == 0) {
+			cons->pos = -1;
+			cons->sel = 0;
+		}
+		if (cons->rOffs > 0)
+			cons->rOffs--;
+	}
+	FreeLine(cons, ln);
+}
+
+/*
+ * Insert a line at the end of the ring buffer. If the line limit has been
+ * reached, discard the oldest line(s), except for the nKeep most recent ones.
+ */
+static void
+PushLine(AG_Console *_Nonnull cons, AG_ConsoleLine *_Nonnull ln, Uint nKeep)
+{
+	Uint j;
+
+	if (cons->maxLines > 0) {
+		while (cons->nLines >= cons->maxLines && cons->nLines > nKeep)
+			ShiftLine(cons);
+	}
+	if (cons->nLines == cons->lineCap) {
+		Uint capNew = (cons->lineCap > 0) ? (cons->lineCap << 1) : 64;
+
+		if (cons->maxLines > 0 && capNew > cons->maxLines) {
+			capNew = MAX(cons->maxLines, cons->nLines + 1);
 		}
-		w += wBar + WIDGET(cons)->paddingRight;
-		if (w > cons->wMax)
-			cons->wMax = w;
+		ResizeRing(cons, capNew);
 	}
+	if ((j = cons->lineHead + cons->nLines) >= cons->lineCap) {
+		j -= cons->lineCap;
+	}
+	cons->lines[j] = ln;
+	cons->nLines++;
+}
+
+static __inline__ void
+AdjustXoffs(AG_Console *_Nonnull cons)
+{
+	const int wCons = WIDTH(cons);
+
 	if ((cons->wMax - wCons - cons->xOffs) < 0)
 		cons->xOffs = MAX(0, cons->wMax - wCons);
 }
@@ -95,7 +319,7 @@ AdjustXoffs(AG_Console *_Nonnull cons)
 static __inline__ void
 ClampVisible(AG_Console *_Nonnull cons)
 {
-	const int v = (int)cons->nLines - (int)cons->rVisible;
+	const int v = (int)NLINES(cons) - (int)cons->rVisible;
 
 	cons->rOffs = MAX(0,v);
 }
@@ -171,7 +395,7 @@ ScrollDown(AG_Event *_Nonnull event)
 		ScrollRight(event);
 		return;
 	}
-	maxOffs = (cons->nLines - cons->rVisible);
+	maxOffs = (NLINES(cons) - cons->rVisible);
 	if (maxOffs < 0) {
 		return;
 	}
@@ -199,7 +423,7 @@ static void
 PageDown(AG_Event *_Nonnull event)
 {
 	AG_Console *cons = AG_CONSOLE_SELF();
-	const int maxOffs = (cons->nLines - cons->rVisible);
+	const int maxOffs = (NLINES(cons) - cons->rVisible);
 	int newOffs;
 
 	if (maxOffs < 0) {
@@ -229,7 +453,7 @@ GoToBottom(AG_Event *_Nonnull event)
 	AG_Console *cons = AG_CONSOLE_SELF();
 	int newOffs;
 
-	newOffs = cons->nLines - cons->rVisible;
+	newOffs = NLINES(cons) - cons->rVisible;
 	if (newOffs < 0) { newOffs = 0; }
 	cons->rOffs = (Uint)newOffs;
 	AG_Redraw(cons);
@@ -239,16 +463,17 @@ GoToBottom(AG_Event *_Nonnull event)
 static void
 MapLine(AG_Console *_Nonnull cons, int yMouse, int *_Nonnull nLine)
 {
+	const Uint nLines = NLINES(cons);
 	Uint sel;
 
 	if (yMouse < WIDGET(cons)->paddingTop) {
 		*nLine = cons->rOffs;
 	} else if (yMouse > WIDGET(cons)->h) {
-		*nLine = (int)cons->nLines - 1;
+		*nLine = (int)nLines - 1;
 	} else {
 		sel = (yMouse - WIDGET(cons)->paddingTop) / cons->lineskip;
-		if ((cons->rOffs + sel) >= cons->nLines) {
-			*nLine = (int)cons->nLines - 1;
+		if ((cons->rOffs + sel) >= nLines) {
+			*nLine = (int)nLines - 1;
 		} else {
 			*nLine = (int)(cons->rOffs + sel);
 		}
@@ -256,93 +481,114 @@ MapLine(AG_Console *_Nonnull cons, int yMouse, int *_Nonnull nLine)
 }
 
 /*
- * Join currently selected lines into a single C string using a given
- * type of newline character or sequence.
+ * Return the text of the line at index i (not necessarily NUL-terminated)
+ * and its length in bytes. Return NULL if the line of a mapped file could
+ * not be read (the file was truncated).
  */
-char *
-AG_ConsoleExportText(const AG_Console *cons, enum ag_newline_type nl)
+static const char *_Nullable
+LineText(const AG_Console *_Nonnull cons, Uint i, AG_Size *_Nonnull len)
+{
+	const AG_ConsoleLine *ln;
+
+#ifdef USE_MMAP
+	if (cons->mapFile != NULL)
+		return MapLineText(cons->mapFile, i, len);
+#endif
+	ln = GetLine(cons, i);
+	*len = ln->len;
+	return (ln->text);
+}
+
+/* Join the lines from index i1 to i2 (inclusive). */
+static char *_Nullable
+ExportLines(const AG_Console *_Nonnull cons, Uint i1, Uint i2,
+    enum ag_newline_type nl)
 {
 	const AG_NewlineFormat *newline;
 	char *s, *ps;
-	AG_Size sizeReq, newlineLen;
-	const int pos = cons->pos;
-	const int sel = cons->sel;
-	int i;
+	AG_Size sizeReq, newlineLen, len;
+	Uint i;
 
-	AG_OBJECT_ISA(cons, "AG_Widget:AG_Console:*");
-	if (pos == -1)
-		return (NULL);
 #ifdef AG_DEBUG
 	if (nl >= AG_NEWLINE_LAST) { AG_FatalError("newline arg"); }
 #endif
 	newline = &agNewlineFormats[nl];
 	newlineLen = newline->len;
-
-	for (i=0, sizeReq=1; i < cons->nLines; i++) {
-		const AG_ConsoleLine *ln = cons->lines[i];
-
-		if (((i == pos) ||
-		     (sel > 0 && i > pos && i <= pos+sel+1) ||
-		     (sel < 0 && i < pos && i >= pos+sel-1))) {
-			sizeReq += ln->len + newlineLen;
+	for (i = i1, sizeReq = 1; i <= i2; i++) {
+		if (LineText(cons, i, &len) == NULL) {
+			goto truncated;
 		}
+		sizeReq += len + newlineLen;
 	}
 	if ((s = TryMalloc(sizeReq)) == NULL) {
 		return (NULL);
 	}
 	ps = &s[0];
 	*ps = '\0';
-	for (i=0; i < cons->nLines; i++) {
-		const AG_ConsoleLine *ln = cons->lines[i];
+	for (i = i1; i <= i2; i++) {
+		const char *text;
 
-		if ((i == pos) ||
-		     (sel > 0 && i > pos && i <= pos+sel+1) ||
-		     (sel < 0 && i < pos && i >= pos+sel-1)) {
-
-			memcpy(ps, ln->text, ln->len);
-			memcpy(&ps[ln->len], newline->s, newlineLen+1);
-			ps += ln->len + newlineLen;
+		if ((text = LineText(cons, i, &len)) == NULL ||
+		    ps + len + newlineLen >= &s[sizeReq]) {
+			free(s);
+			goto truncated;
 		}
+		memcpy(ps, text, len);
+		memcpy(&ps[len], newline->s, newlineLen+1);
+		ps += len+newlineLen;
 	}
 	return (s);
+truncated:
+	AG_SetError("%s: File was truncated", cons->mapFile->label);
+	return (NULL);
 }
 
 /*
- * Join entire buffer contents into a single C string using a given
+ * Join currently selected lines into a single C string using a given
  * type of newline character or sequence.
  */
 char *
-AG_ConsoleExportBuffer(const AG_Console *cons, enum ag_newline_type nl)
+AG_ConsoleExportText(const AG_Console *cons, enum ag_newline_type nl)
 {
-	const AG_NewlineFormat *newline;
-	char *s, *ps;
-	AG_Size sizeReq, newlineLen;
-	int i;
+	const int nLines = (int)NLINES(cons);
+	const int pos = cons->pos;
+	const int sel = cons->sel;
+	int i1, i2;
 
 	AG_OBJECT_ISA(cons, "AG_Widget:AG_Console:*");
-#ifdef AG_DEBUG
-	if (nl >= AG_NEWLINE_LAST) { AG_FatalError("newline arg"); }
-#endif
-	newline = &agNewlineFormats[nl];
-	newlineLen = newline->len;
+	if (pos == -1)
+		return (NULL);
 
-	for (i=0, sizeReq=1; i < cons->nLines; i++) {
-		sizeReq += cons->lines[i]->len + newlineLen;
+	if (sel > 0) {
+		i1 = pos;
+		i2 = pos+sel+1;
+	} else if (sel < 0) {
+		i1 = pos+sel-1;
+		i2 = pos;
+	} else {
+		i1 = i2 = pos;
 	}
-	if ((s = TryMalloc(sizeReq)) == NULL) {
-		return (NULL);
+	if (i1 < 0) { i1 = 0; }
+	if (i2 > nLines-1) { i2 = nLines-1; }
+	if (i1 > i2) {
+		return (TryStrdup(""));
 	}
-	ps = &s[0];
-	*ps = '\0';
-	for (i = 0; i < cons->nLines; i++) {
-		const AG_ConsoleLine *ln = cons->lines[i];
-		const AG_Size len = ln->len; // strlen(ln->text);
+	return ExportLines(cons, (Uint)i1, (Uint)i2, nl);
+}
 
-		memcpy(ps, ln->text, len);
-		memcpy(&ps[len], newline->s, newlineLen+1);
-		ps += len+newlineLen;
+/*
+ * Join entire buffer contents into a single C string using a given
+ * type of newline character or sequence.
+ */
+char *
+AG_ConsoleExportBuffer(const AG_Console *cons, enum ag_newline_type nl)
+{
+	AG_OBJECT_ISA(cons, "AG_Widget:AG_Console:*");
+
+	if (NLINES(cons) == 0) {
+		return (TryStrdup(""));
 	}
-	return (s);
+	return ExportLines(cons, 0, NLINES(cons) - 1, nl);
 }
 
 static void
@@ -491,7 +737,7 @@ MenuSelectAll(AG_Event *_Nonnull event)
 	AG_Console *cons = AG_CONSOLE_PTR(1);
 
 	cons->pos = 0;
-	cons->sel = cons->nLines-1;
+	cons->sel = NLINES(cons) - 1;
 	AG_Redraw(cons);
 }
 
@@ -528,7 +774,7 @@ BeginSelect(AG_Event *_Nonnull event)
 	if (cons->pm)
 		AG_PopupHide(cons->pm);
 
-	if (cons->nLines > 0) {
+	if (NLINES(cons) > 0) {
 		MapLine(cons, y, &cons->pos);
 		cons->sel = 0;
 		AG_Redraw(cons);
@@ -537,7 +783,7 @@ BeginSelect(AG_Event *_Nonnull event)
 
 	if (cons->flags & AG_CONSOLE_BEGIN_SELECT) {
 		cons->pos = 0;
-		cons->sel = cons->nLines-1;
+		cons->sel = NLINES(cons) - 1;
 		cons->flags &= ~(AG_CONSOLE_SELECTING);
 	} else {
 		cons->flags |= AG_CONSOLE_BEGIN_SELECT;
@@ -613,13 +859,13 @@ MouseMotion(void *obj, int x, int y, int dx, int dy)
 		cons->rOffs--;
 		AG_Redraw(cons);
 	} else if (y > HEIGHT(cons) &&
-	          (cons->rOffs + cons->rVisible) < cons->nLines) {
+	          (cons->rOffs + cons->rVisible) < NLINES(cons)) {
 		cons->rOffs++;
 		AG_Redraw(cons);
 	}
-	if (y > 0 && cons->nLines > 0) {
+	if (y > 0 && NLINES(cons) > 0) {
 		MapLine(cons, y, &newPos);
-		if (newPos < cons->nLines) {
+		if (newPos < NLINES(cons)) {
 			if ((newSel = newPos - cons->pos) != cons->sel) {
 				if (cons->pos + newSel == 0) {
 					cons->sel = newSel+1;
@@ -669,23 +915,20 @@ static void
 StyleChanged(AG_Event *_Nonnull event)
 {
 	AG_Console *cons = AG_CONSOLE_SELF();
-	Uint i;
-	int j;
 
 	cons->lineskip = WFONT(cons)->lineskip + WIDGET(cons)->spacingVert;
 /*	cons->rOffs = 0; */
 	ComputeVisible(cons);
 
-	for (i = 0; i < cons->nLines; i++) {
-		AG_ConsoleLine *ln = cons->lines[i];
-
-		for (j = 0; j < 2; j++) {
-			if (ln->surface[j] != -1) {
-				AG_WidgetUnmapSurface(cons, ln->surface[j]);
-				ln->surface[j] = -1;
-			}
-		}
+	while (cons->nMapped > 0) {
+		UnmapLine(cons, cons->mapped[0]);
 	}
+#ifdef USE_MMAP
+	if (cons->mapFile != NULL) {
+		MapCacheClear(cons, cons->mapFile);
+	}
+#endif
+	cons->wMax = 0;				/* Measured again by Draw() */
 }
 
 static void
@@ -702,6 +945,9 @@ Init(void *_Nonnull obj)
 	cons->lineScrollAmount = 5;
 	cons->lineskip = 0;
 	cons->nLines = 0;
+	cons->lineHead = 0;
+	cons->lineCap = 0;
+	cons->maxLines = 0;
 	cons->wMax = 0;
 	cons->rOffs = 0;
 	cons->rVisible = 0;
@@ -714,6 +960,13 @@ Init(void *_Nonnull obj)
 	cons->r.h = 0;
 	cons->scrollTo = NULL;
 	TAILQ_INIT(&cons->files);
+	cons->chunkHead = NULL;
+	cons->chunkTail = NULL;
+	cons->chunkSpare = NULL;
+	cons->mapped = NULL;
+	cons->nMapped = 0;
+	cons->maxMapped = 0;
+	cons->mapFile = NULL;
 
 	AG_InitTimer(&cons->beginSelectTo, "beginSel", 0);
 
@@ -821,8 +1074,10 @@ Draw(void *_Nonnull p)
 	const AG_Color *cBg = &WCOLOR(cons, BG_COLOR);
 	const AG_Color *cSel = &WCOLOR(cons, SELECTION_COLOR);
 	const AG_Color *cText = &WCOLOR(cons, TEXT_COLOR);
+	const int wPad = WIDTH(cons->vBar) + WIDGET(cons)->paddingLeft +
+	                 WIDGET(cons)->paddingRight;
 	AG_Rect r;
-	Uint lnIdx;
+	Uint lnIdx, i;
 	int pos, sel;
 
 	if (cBg->a > 0) {
@@ -833,7 +1088,7 @@ Draw(void *_Nonnull p)
 		AG_DrawRectFilled(cons, &r, cBg);
 	}
 
-	if (cons->nLines == 0)
+	if (NLINES(cons) == 0)
 		goto out;
 
 	if (cons->scrollTo != NULL) {
@@ -849,10 +1104,15 @@ Draw(void *_Nonnull p)
 	pos = cons->pos;
 	sel = cons->sel;
 
+#ifdef USE_MMAP
+	if (cons->mapFile != NULL) {
+		DrawMapped(cons, &r, pos, sel);
+	} else
+#endif
 	for (lnIdx = cons->rOffs;
 	     lnIdx < cons->nLines && r.y < WIDGET(cons)->h;
 	     lnIdx++) {
-		AG_ConsoleLine *ln = cons->lines[lnIdx];
+		AG_ConsoleLine *ln = GetLine(cons, lnIdx);
 		AG_Surface *S;
 		int isSel;
 
@@ -887,10 +1147,23 @@ Draw(void *_Nonnull p)
 				r.y += cons->lineskip;
 				continue;
 			}
+			if (ln->surface[!isSel] == -1) {
+				if (cons->nMapped == cons->maxMapped) {
+					cons->maxMapped += 32;
+					cons->mapped = Realloc(cons->mapped,
+					    cons->maxMapped *
+					    sizeof(AG_ConsoleLine *));
+				}
+				cons->mapped[cons->nMapped++] = ln;
+			}
 			ln->surface[isSel] = AG_WidgetMapSurface(cons, S);
 		} else {
 			S = WSURFACE(cons, ln->surface[isSel]);
 		}
+		ln->flags |= AG_CONSOLE_LINE_DRAWN;
+
+		if (S->w + wPad > cons->wMax)
+			cons->wMax = S->w + wPad;
 
 		/*
 		 * Blit rendered label -> display.
@@ -909,6 +1182,18 @@ Draw(void *_Nonnull p)
 		r.y += cons->lineskip;
 	}
 	AG_PopClipRect(cons);
+
+	/* Release the surfaces of the lines which are no longer visible. */
+	for (i = 0; i < cons->nMapped; ) {
+		AG_ConsoleLine *ln = cons->mapped[i];
+
+		if (ln->flags & AG_CONSOLE_LINE_DRAWN) {
+			ln->flags &= ~(AG_CONSOLE_LINE_DRAWN);
+			i++;
+		} else {
+			UnmapLine(cons, ln);
+		}
+	}
 out:
 	AG_WidgetDraw(cons->vBar);
 	AG_WidgetDraw(cons->hBar);
@@ -917,22 +1202,31 @@ out:
 static void
 FreeLines(AG_Console *_Nonnull cons)
 {
+	AG_ConsoleChunk *ch, *chNext;
 	Uint i;
 
+	while (cons->nMapped > 0) {
+		UnmapLine(cons, cons->mapped[0]);
+	}
 	for (i = 0; i < cons->nLines; i++) {
-		AG_ConsoleLine *ln = cons->lines[i];
-		int j;
+		AG_ConsoleLine *ln = GetLine(cons, i);
 
-		for (j = 0; j < 2; j++) {
-			if (ln->surface[j] != -1)
-				AG_WidgetUnmapSurface(cons, ln->surface[j]);
-		}
-		free(ln->text);
-		free(ln);
+		if (ln->flags & AG_CONSOLE_LINE_HEAP_TEXT)
+			free(ln->text);
 	}
+	for (ch = cons->chunkHead; ch != NULL; ch = chNext) {
+		chNext = ch->next;
+		FreeChunk(cons, ch);
+	}
+	cons->chunkHead = NULL;
+	cons->chunkTail = NULL;
+
 	Free(cons->lines);
 	cons->lines = NULL;
 	cons->nLines = 0;
+	cons->lineHead = 0;
+	cons->lineCap = 0;
+	cons->wMax = 0;
 }
 
 static void
@@ -944,6 +1238,13 @@ Destroy(void *_Nonnull p)
 		AG_PopupDestroy(cons->pm);
 	}
 	FreeLines(cons);
+	Free(cons->chunkSpare);
+	Free(cons->mapped);
+#ifdef USE_MMAP
+	if (cons->mapFile != NULL) {
+		AG_ConsoleClose(cons, cons->mapFile);
+	}
+#endif
 }
 
 #ifdef AG_LEGACY
@@ -955,121 +1256,205 @@ AG_ConsoleSetPadding(AG_Console *cons, int padding)
 }
 #endif /* AG_LEGACY */
 
-/* Append a line to the console; backend to AG_ConsoleMsg(). */
-AG_ConsoleLine *
-AG_ConsoleAppendLine(AG_Console *cons, const char *s)
+/* Allocate a line and append it to the ring buffer. */
+static __inline__ AG_ConsoleLine *_Nonnull
+AppendLine(AG_Console *_Nonnull cons, const char *_Nonnull s, AG_Size len)
 {
 	AG_ConsoleLine *ln;
 
-	AG_OBJECT_ISA(cons, "AG_Widget:AG_Console:*");
-	AG_ObjectLock(cons);
+	ln = AllocLine(cons, s, len);
+	PushLine(cons, ln, 0);
+	return (ln);
+}
 
-	if (s && (strchr(s, agNewlineFormats[AG_NEWLINE_NATIVE].s[0]))) {
-		ln = AppendMultiLine(cons, s);
-	} else {
-		ln = Malloc(sizeof(AG_ConsoleLine));
-
-		/* top level / standalone line by default */
-		ln->parent = NULL;
-
-		if (s && strlen(s) == 0) {
-			/* zero length strings */
-			ln->text = Strdup(s);
-			ln->len = 0;
-		} else if (s != NULL) {
-			ln->text = Strdup(s);
-			ln->len = strlen(s);
-		} else {
-			ln->text = NULL;
-			ln->len = 0;
-		}
+/*
+ * Append a line, or a group of lines if the string contains newlines
+ * (in which case the first line is returned).
+ */
+static AG_ConsoleLine *_Nonnull
+AppendString(AG_Console *_Nonnull cons, const char *_Nonnull s)
+{
+	if (strchr(s, agNewlineFormats[AG_NEWLINE_NATIVE].s[0]) != NULL) {
+		return AppendMultiLine(cons, s);
 	}
+	return AppendLine(cons, s, strlen(s));
+}
 
-	cons->lines = Realloc(cons->lines, (cons->nLines+1) *
-	                                   sizeof(AG_ConsoleLine *));
-	cons->lines[cons->nLines++] = ln;
-
-	ln->cons = cons;
-	ln->p = NULL;
-	ln->surface[0] = -1;
-	ln->surface[1] = -1;
-	AG_ColorNone(&ln->c);			/* Inherit default */
-
-	if ((cons->flags & AG_CONSOLE_NOAUTOSCROLL) == 0)
+/* Scroll to the end (unless disabled) and request a redraw. */
+static __inline__ void
+Appended(AG_Console *_Nonnull cons)
+{
+	if ((cons->flags & AG_CONSOLE_NOAUTOSCROLL) == 0 &&
+	    cons->mapFile == NULL) {
 		cons->scrollTo = &cons->nLines;
-
+	}
 	AG_Redraw(cons);
-	AG_ObjectUnlock(cons);
-	return (ln);
 }
 
 /* Append a line to the console; backend to AG_ConsoleMsg(). */
-static AG_ConsoleLine *
-AppendMultiLine(AG_Console *cons, const char *s)
+AG_ConsoleLine *
+AG_ConsoleAppendLine(AG_Console *cons, const char *s)
 {
-	const AG_NewlineFormat *newline = &agNewlineFormats[AG_NEWLINE_NATIVE];
 	AG_ConsoleLine *ln;
-	char *tok = NULL, *dup, *pDup;
-	int first = 1;
-
-	ln = Malloc(sizeof(AG_ConsoleLine));
 
-	/* top level / standalone line by default */
-	ln->parent = NULL;
-
-	dup = pDup = Strdup(s);
+	AG_OBJECT_ISA(cons, "AG_Widget:AG_Console:*");
+	AG_ObjectLock(cons);
 
-	while ((tok = Strsep(&dup, newline->s)) != NULL) {
-		if (newline->len == 2 && tok[0] != '\0') { 	/* XXX */
-			tok[strlen(tok)-1] = '\0';
-		}	
-		if (first == 1) {
-			first = 0;
+	ln = AppendString(cons, (s != NULL) ? s : "");
+	Appended(cons);
 
-			/* populate this line with the first slice */
-			ln->text = Strdup(tok);
-			ln->len = strlen(tok);
-		} else {
-			/* create a child line */
-			(AG_ConsoleAppendLine(cons, tok))->parent = ln;
-		}
-	}
-	free(pDup);
-	/* we only return the parent, but that's ok since the children take
-	 * it's style */
+	AG_ObjectUnlock(cons);
 	return (ln);
-
 }
 
-/* Append a message to the console (format string). */
-AG_ConsoleLine *
-AG_ConsoleMsg(AG_Console *cons, const char *fmt, ...)
+/* Append an array of lines to the console. */
+void
+AG_ConsoleAppendLines(AG_Console *cons, const char *const *lines, Uint n)
 {
-	AG_ConsoleLine *ln;
-	va_list args;
-	AG_Size len;
+	Uint i;
 
 	AG_OBJECT_ISA(cons, "AG_Widget:AG_Console:*");
 	AG_ObjectLock(cons);
 
-	if ((ln = AG_ConsoleAppendLine(cons, NULL)) == NULL) {
-		goto fail;
-	}
-	va_start(args, fmt);
-	AG_Vasprintf(&ln->text, fmt, args);
-	va_end(args);
-
-	len = ln->len = strlen(ln->text);
-	if (len > 1 && ln->text[len-1] == '\n') {
-		ln->text[len-1] = '\0';
-		ln->len--;
+	for (i = 0; i < n; i++) {
+		AppendString(cons, lines[i]);
 	}
+	Appended(cons);
 
 	AG_ObjectUnlock(cons);
-	return (ln);
-fail:
+}
+
+/*
+ * Split a buffer into lines and append them to the console. A trailing
+ * newline does not produce an empty line.
+ */
+static void
+AppendBuffer(AG_Console *_Nonnull cons, const char *_Nonnull buf, AG_Size len,
+    const AG_NewlineFormat *_Nonnull newline, int skipEmpty)
+{
+	const char nl = newline->s[newline->len - 1];
+	const char *p = buf, *pEnd = &buf[len];
+
+	while (p < pEnd) {
+		const char *pNl;
+		AG_Size lineLen;
+
+		if ((pNl = memchr(p, nl, pEnd - p)) == NULL) {
+			pNl = pEnd;
+		}
+		lineLen = pNl - p;
+		if (newline->len == 2 && lineLen > 0 &&
+		    p[lineLen - 1] == newline->s[0]) {
+			lineLen--;
+		}
+		if (lineLen > 0 || !skipEmpty) {
+			AppendLine(cons, p, lineLen);
+		}
+		p = pNl + 1;
+	}
+}
+
+/* Append the lines of a text buffer (which need not be NUL-terminated). */
+void
+AG_ConsoleAppendBuffer(AG_Console *cons, const char *buf, AG_Size len,
+    enum ag_newline_type nl)
+{
+	AG_OBJECT_ISA(cons, "AG_Widget:AG_Console:*");
+#ifdef AG_DEBUG
+	if (nl >= AG_NEWLINE_LAST) { AG_FatalError("newline arg"); }
+#endif
+	AG_ObjectLock(cons);
+
+	AppendBuffer(cons, buf, len, &agNewlineFormats[nl], 0);
+	Appended(cons);
+
+	AG_ObjectUnlock(cons);
+}
+
+/*
+ * Set the maximum number of lines to keep (0 = no limit). Once the limit
+ * is reached, appending a line discards the oldest one.
+ */
+void
+AG_ConsoleSetMaxLines(AG_Console *cons, Uint maxLines)
+{
+	AG_OBJECT_ISA(cons, "AG_Widget:AG_Console:*");
+	AG_ObjectLock(cons);
+
+	cons->maxLines = maxLines;
+	if (maxLines > 0) {
+		while (cons->nLines > maxLines) {
+			ShiftLine(cons);
+		}
+		if (cons->lineCap > maxLines)
+			ResizeRing(cons, maxLines);
+	}
+	ClampVisible(cons);
+	AG_Redraw(cons);
+
 	AG_ObjectUnlock(cons);
-	return (NULL);
+}
+
+/* Append a group of lines from a string containing newlines. */
+static AG_ConsoleLine *
+AppendMultiLine(AG_Console *cons, const char *s)
+{
+	const AG_NewlineFormat *newline = &agNewlineFormats[AG_NEWLINE_NATIVE];
+	AG_ConsoleLine *ln = NULL, *lnChild;
+	const char *p = s;
+	Uint nLines = 0;
+
+	for (;;) {
+		const char *pNl = strstr(p, newline->s);
+		const AG_Size len = (pNl != NULL) ? (AG_Size)(pNl - p) : strlen(p);
+
+		if (ln == NULL) {
+			ln = AllocLine(cons, p, len);   /* Parent (first) line */
+			PushLine(cons, ln, 0);
+		} else {
+			lnChild = AllocLine(cons, p, len);
+			PushLine(cons, lnChild, nLines);
+			lnChild->parent = ln;
+		}
+		nLines++;
+		if (pNl == NULL) {
+			break;
+		}
+		p = pNl + newline->len;
+	}
+	/*
+	 * We only return the parent, but that's ok since the children
+	 * take its style.
+	 */
+	return (ln);
+}
+
+/* Append a message to the console (format string). */
+AG_ConsoleLine *
+AG_ConsoleMsg(AG_Console *cons, const char *fmt, ...)
+{
+	AG_ConsoleLine *ln;
+	va_list args;
+	char *s;
+	AG_Size len;
+
+	AG_OBJECT_ISA(cons, "AG_Widget:AG_Console:*");
+
+	va_start(args, fmt);
+	AG_Vasprintf(&s, fmt, args);
+	va_end(args);
+
+	len = strlen(s);
+	if (len > 1 && s[len-1] == '\n')
+		len--;
+
+	AG_ObjectLock(cons);
+	ln = AppendLine(cons, s, len);
+	Appended(cons);
+	AG_ObjectUnlock(cons);
+
+	free(s);
+	return (ln);
 }
 
 /* Append a message to the console (C string). */
@@ -1082,9 +1467,7 @@ AG_ConsoleMsgS(AG_Console *cons, const char *s)
 	AG_OBJECT_ISA(cons, "AG_Widget:AG_Console:*");
 	AG_ObjectLock(cons);
 
-	if ((ln = AG_ConsoleAppendLine(cons, s)) == NULL) {
-		goto fail;
-	}
+	ln = AG_ConsoleAppendLine(cons, s);
 	len = ln->len;
 	if (len > 1 && ln->text[len-1] == '\n') {
 		ln->text[len-1] = '\0';
@@ -1093,9 +1476,6 @@ AG_ConsoleMsgS(AG_Console *cons, const char *s)
 
 	AG_ObjectUnlock(cons);
 	return (ln);
-fail:
-	AG_ObjectUnlock(cons);
-	return (NULL);
 }
 
 /*
@@ -1177,14 +1557,7 @@ AG_ConsoleBinary(AG_Console *cons, const void *data, AG_Size size,
 static void
 InvalidateCachedLabel(AG_Console *cons, AG_ConsoleLine *ln)
 {
-	int i;
-
-	for (i = 0; i < 2; i++) {
-		if (ln->surface[i] != -1) {
-			AG_WidgetUnmapSurface(cons, ln->surface[i]);
-			ln->surface[i] = -1;
-		}
-	}
+	UnmapLine(cons, ln);
 	AG_Redraw(cons);
 }
 
@@ -1194,12 +1567,22 @@ AG_ConsoleMsgEdit(AG_ConsoleLine *ln, const char *s)
 {
 	AG_Console *cons = ln->cons;
 
+	AG_Size len;
+
 	AG_OBJECT_ISA(cons, "AG_Widget:AG_Console:*");
 	AG_ObjectLock(cons);
 
-	free(ln->text);
-	ln->text = Strdup(s);
-	ln->len = strlen(s);
+	len = strlen(s);
+	if (ln->flags & AG_CONSOLE_LINE_HEAP_TEXT) {
+		free(ln->text);
+		ln->text = Strdup(s);
+	} else if (len <= ln->len) {
+		memcpy(ln->text, s, len+1);             /* Fits in the arena */
+	} else {
+		ln->text = Strdup(s);
+		ln->flags |= AG_CONSOLE_LINE_HEAP_TEXT;
+	}
+	ln->len = len;
 
 	InvalidateCachedLabel(cons, ln);
 	AG_ObjectUnlock(cons);
@@ -1218,9 +1601,18 @@ AG_ConsoleMsgCatS(AG_ConsoleLine *ln, const char *s)
 	AG_ObjectLock(cons);
 
 	newLen = ln->len + sLen + 1;
-	ln->text = Realloc(ln->text, newLen);
+	if (ln->flags & AG_CONSOLE_LINE_HEAP_TEXT) {
+		ln->text = Realloc(ln->text, newLen);
+	} else {
+		char *textNew;
+
+		textNew = Malloc(newLen);
+		memcpy(textNew, ln->text, ln->len + 1);
+		ln->text = textNew;
+		ln->flags |= AG_CONSOLE_LINE_HEAP_TEXT;
+	}
+	memcpy(&ln->text[ln->len], s, sLen + 1);
 	ln->len = newLen-1;
-	Strlcat(ln->text, s, newLen);
 
 	InvalidateCachedLabel(cons, ln);
 	AG_ObjectUnlock(cons);
@@ -1279,7 +1671,7 @@ ConsoleReadFile(AG_EventSink *_Nonnull es, AG_Event *_Nonnull event)
 	AG_Console *cons = AG_CONSOLE_PTR(1);
 	AG_ConsoleFile *cf = AG_PTR(2);
 	FILE *f = cf->pFILE;
-	char *buf, *pLine, *line;
+	char *buf;
 #if AG_MODEL == AG_LARGE
 	const AG_Size bufferMax = AG_BUFFER_MAX*8;
 #else
@@ -1320,32 +1712,10 @@ ConsoleReadFile(AG_EventSink *_Nonnull es, AG_Event *_Nonnull event)
 		if (cf->flags & AG_CONSOLE_FILE_BINARY) {
 			AG_ConsoleBinary(cons, buf, nRead, cf->label, NULL);
 		} else {
-			const char *newline_s = cf->newline->s;
-			char sep[2];
-
-			switch (cf->newline->len) {
-			case 1:
-				for (pLine = buf;
-				     (line = AG_Strsep(&pLine, newline_s)) != NULL; ) {
-				     	if (line[0] == '\0') {
-						continue;
-					}
-					AG_ConsoleMsgS(cons, line);
-				}
-				break;
-			case 2:
-				sep[0] = newline_s[0];		/* Cheat */
-				sep[1] = '\0';
-				for (pLine = buf;
-				     (line = AG_Strsep(&pLine, sep)) != NULL; ) {
-					if (line[0] == '\0') {
-						continue;
-					}
-					line[strlen(line)-1] = '\0';
-					AG_ConsoleMsgS(cons, line);
-				}
-				break;
-			}
+			AG_ObjectLock(cons);
+			AppendBuffer(cons, buf, nRead, cf->newline, 1);
+			Appended(cons);
+			AG_ObjectUnlock(cons);
 		}
 	}
 out:
@@ -1353,6 +1723,437 @@ out:
 	return (0);
 }
 
+#ifdef USE_MMAP
+/*
+ * Mapped files (AG_CONSOLE_FILE_MMAP).
+ *
+ * Rather than copying the file into console lines, we build an index of
+ * the offset of every AG_CONSOLE_FILE_STRIDE'th line. The index is built
+ * incrementally from a timer (which also picks up any data appended to the
+ * file). Only the visible lines are read and rendered.
+ *
+ * The file is read with pread(2) into a bounded buffer and not accessed
+ * through an actual memory mapping, since a concurrent truncation (e.g., a
+ * log rotated with copytruncate) would raise SIGBUS on access to the pages
+ * past the new end of file.
+ */
+
+/* Bytes to index per timer tick. */
+#define MAP_SCAN_MAX (16*1024*1024)
+
+/* Size of the read buffer. */
+#define MAP_BLOCK_SIZE (64*1024)
+
+/* Record the newline at offset offs. */
+static __inline__ void
+MapNewline(AG_ConsoleFile *_Nonnull cf, AG_Size offs)
+{
+	if ((++cf->nNewlines % AG_CONSOLE_FILE_STRIDE) != 0) {
+		return;
+	}
+	if (cf->nIndex == cf->maxIndex) {
+		cf->maxIndex = (cf->maxIndex > 0) ? (cf->maxIndex << 1) : 1024;
+		cf->index = Realloc(cf->index, cf->maxIndex * sizeof(AG_Size));
+	}
+	cf->index[cf->nIndex++] = offs + 1;
+}
+
+#ifdef HAVE_SSE2
+static __inline__ Uint
+Popcount16(Uint x)
+{
+	x = x - ((x >> 1) & 0x5555);
+	x = (x & 0x3333) + ((x >> 2) & 0x3333);
+	x = (x + (x >> 4)) & 0x0f0f;
+	return ((x + (x >> 8)) & 0x1f);
+}
+#endif
+
+/*
+ * Read up to len bytes of the file at offset offs into the read buffer.
+ * Return the number of bytes read, or 0 on end of file or error.
+ */
+static AG_Size
+MapRead(AG_ConsoleFile *_Nonnull cf, AG_Size offs, AG_Size len)
+{
+	ssize_t rv;
+
+	if (len > MAP_BLOCK_SIZE) {
+		len = MAP_BLOCK_SIZE;
+	}
+	do {
+		rv = pread(cf->fd, cf->block, (size_t)len, (off_t)offs);
+	} while (rv == -1 && errno == EINTR);
+
+	return (rv > 0) ? (AG_Size)rv : 0;
+}
+
+/* Index the newlines in a block of len bytes read at offset offs. */
+static void
+MapScanBlock(AG_ConsoleFile *_Nonnull cf, const char *_Nonnull blk,
+    AG_Size len, AG_Size offs)
+{
+	const char nl = cf->newline->s[cf->newline->len - 1];
+	AG_Size i = 0;
+#ifdef HAVE_SSE2
+	const __m128i vNl = _mm_set1_epi8(nl);
+
+	/*
+	 * Compare 16 bytes at a time. Unless the block completes a stride,
+	 * we only need the number of newlines it contains.
+	 */
+	for (; i+16 <= len; i += 16) {
+		const __m128i v = _mm_loadu_si128((const __m128i *)&blk[i]);
+		Uint mask, n, bit;
+
+		mask = (Uint)_mm_movemask_epi8(_mm_cmpeq_epi8(v, vNl));
+		if (mask == 0) {
+			continue;
+		}
+		n = Popcount16(mask);
+		if ((cf->nNewlines % AG_CONSOLE_FILE_STRIDE) + n <
+		    AG_CONSOLE_FILE_STRIDE) {
+			cf->nNewlines += n;
+			continue;
+		}
+		for (bit = 0; mask != 0; bit++, mask >>= 1) {
+			if (mask & 1)
+				MapNewline(cf, offs + i + bit);
+		}
+	}
+#endif /* HAVE_SSE2 */
+	for (; i < len; i++) {
+		if (blk[i] == nl)
+			MapNewline(cf, offs + i);
+	}
+}
+
+/*
+ * Index the range [cf->scanned, end) of the file. Stop early if the file
+ * has become shorter (the next size check will discard the index).
+ */
+static void
+MapScan(AG_ConsoleFile *_Nonnull cf, AG_Size end)
+{
+	const char nl = cf->newline->s[cf->newline->len - 1];
+	AG_Size len;
+
+	while (cf->scanned < end &&
+	       (len = MapRead(cf, cf->scanned, end - cf->scanned)) > 0) {
+		MapScanBlock(cf, cf->block, len, cf->scanned);
+		cf->scanned += len;
+
+		/* A trailing partial line is also displayed. */
+		cf->nLines = cf->nNewlines;
+		if (cf->block[len-1] != nl)
+			cf->nLines++;
+	}
+}
+
+/* Append len bytes to the line buffer of cf, at offset n. */
+static void
+MapLineAppend(AG_ConsoleFile *_Nonnull cf, AG_Size n,
+    const char *_Nonnull p, AG_Size len)
+{
+	if (n + len + 1 > cf->lineSize) {
+		cf->lineSize = n + len + 1;
+		cf->line = Realloc(cf->line, cf->lineSize);
+	}
+	memcpy(&cf->line[n], p, len);
+}
+
+/*
+ * Read line i (excluding the newline) into the line buffer of cf and return
+ * a pointer to its NUL-terminated text and its length in bytes. Return NULL
+ * if the indexed range no longer matches the file (the file was truncated,
+ * possibly regrown since).
+ */
+static const char *_Nullable
+MapLineText(AG_ConsoleFile *_Nonnull cf, Uint i, AG_Size *_Nonnull len)
+{
+	const char nl = cf->newline->s[cf->newline->len - 1];
+	AG_Size offs, n = 0, nRead;
+	Uint j = i % AG_CONSOLE_FILE_STRIDE;           /* Newlines to skip */
+
+	offs = (i >= AG_CONSOLE_FILE_STRIDE) ?
+	       cf->index[i/AG_CONSOLE_FILE_STRIDE - 1] : 0;
+
+	for (; offs < cf->scanned; offs += nRead) {
+		const char *p, *pEnd, *pNl;
+
+		if ((nRead = MapRead(cf, offs, cf->scanned - offs)) == 0) {
+			return (NULL);
+		}
+		p = cf->block;
+		pEnd = &cf->block[nRead];
+		while (j > 0 && (p = memchr(p, nl, pEnd - p)) != NULL) {
+			p++;
+			j--;
+		}
+		if (p == NULL) {
+			continue;
+		}
+		if ((pNl = memchr(p, nl, pEnd - p)) != NULL) {
+			MapLineAppend(cf, n, p, pNl - p);
+			n += pNl - p;
+			break;
+		}
+		MapLineAppend(cf, n, p, pEnd - p);
+		n += pEnd - p;
+	}
+	if (j > 0) {
+		return (NULL);                                /* Stale index */
+	}
+	if (cf->line == NULL) {
+		MapLineAppend(cf, 0, "", 0);
+	}
+	if (cf->newline->len == 2 && n > 0 && cf->line[n-1] == cf->newline->s[0])
+		n--;
+
+	cf->line[n] = '\0';
+	*len = n;
+	return (cf->line);
+}
+
+/* Release cached line surfaces. */
+static void
+MapCacheClear(AG_Console *_Nonnull cons, AG_ConsoleFile *_Nonnull cf)
+{
+	int i, j;
+
+	for (i = 0; i < AG_CONSOLE_FILE_CACHE; i++) {
+		AG_ConsoleFileEnt *ent = &cf->cache[i];
+
+		for (j = 0; j < 2; j++) {
+			if (ent->surface[j] != -1) {
+				AG_WidgetUnmapSurface(cons, ent->surface[j]);
+				ent->surface[j] = -1;
+			}
+		}
+	}
+}
+
+/* Release the cached surfaces of line i (if any). */
+static void
+MapCacheInvalidate(AG_Console *_Nonnull cons, AG_ConsoleFile *_Nonnull cf,
+    Uint i)
+{
+	AG_ConsoleFileEnt *ent = &cf->cache[i % AG_CONSOLE_FILE_CACHE];
+	int j;
+
+	if (ent->line != i) {
+		return;
+	}
+	for (j = 0; j < 2; j++) {
+		if (ent->surface[j] != -1) {
+			AG_WidgetUnmapSurface(cons, ent->surface[j]);
+			ent->surface[j] = -1;
+		}
+	}
+}
+
+/* Discard the index and reset the view (the file was truncated). */
+static void
+MapReset(AG_Console *_Nonnull cons, AG_ConsoleFile *_Nonnull cf)
+{
+	cf->scanned = 0;
+	cf->nIndex = 0;
+	cf->nNewlines = 0;
+	cf->nLines = 0;
+	MapCacheClear(cons, cf);
+	cons->rOffs = 0;
+	cons->pos = -1;
+	cons->sel = 0;
+	AG_Redraw(cons);
+}
+
+/*
+ * Index the file and follow any changes in its size. If it was truncated
+ * below the indexed range, discard the index and start over.
+ */
+static Uint32
+MapScanTimeout(AG_Timer *_Nonnull to, AG_Event *_Nonnull event)
+{
+	AG_Console *cons = AGCONSOLE(to->obj);
+	AG_ConsoleFile *cf = AG_PTR(1);
+	const Uint nLinesPrev = cf->nLines;
+	struct stat sb;
+	AG_Size end;
+
+	if (fstat(cf->fd, &sb) == 0) {
+		cf->size = (AG_Size)sb.st_size;
+		if (cf->size < cf->scanned)
+			MapReset(cons, cf);
+	}
+	if (cf->scanned >= cf->size) {
+		return (250);                                  /* Idle */
+	}
+	if (cf->nLines > cf->nNewlines) {
+		MapCacheInvalidate(cons, cf, cf->nLines - 1);  /* Partial line */
+	}
+	end = cf->size;
+	if (end - cf->scanned > MAP_SCAN_MAX) {
+		end = cf->scanned + MAP_SCAN_MAX;
+	}
+	MapScan(cf, end);
+	cf->offs = (AG_Offset)cf->scanned;
+
+	if (cf->nLines != nLinesPrev &&
+	    (cons->flags & AG_CONSOLE_NOAUTOSCROLL) == 0) {
+		cons->scrollTo = &cf->nLines;
+	}
+	AG_Redraw(cons);
+	return (cf->scanned < cf->size) ? 1 : 250;
+}
+
+/* Draw the visible lines of a mapped file. */
+static void
+DrawMapped(AG_Console *_Nonnull cons, AG_Rect *_Nonnull r, int pos, int sel)
+{
+	AG_ConsoleFile *cf = cons->mapFile;
+	const AG_Color *cBg = &WCOLOR(cons, BG_COLOR);
+	const AG_Color *cSel = &WCOLOR(cons, SELECTION_COLOR);
+	const AG_Color *cText = (cf->color != NULL) ? cf->color :
+	                        &WCOLOR(cons, TEXT_COLOR);
+	const int wPad = WIDTH(cons->vBar) + WIDGET(cons)->paddingLeft +
+	                 WIDGET(cons)->paddingRight;
+	Uint lnIdx;
+
+	for (lnIdx = cons->rOffs;
+	     lnIdx < cf->nLines && r->y < WIDGET(cons)->h;
+	     lnIdx++, r->y += cons->lineskip) {
+		AG_ConsoleFileEnt *ent = &cf->cache[lnIdx % AG_CONSOLE_FILE_CACHE];
+		const char *text;
+		AG_Surface *S;
+		AG_Size len;
+		int isSel, j;
+
+		if ((pos != -1) &&
+		    ((lnIdx == pos) ||
+		     ((sel > 0 && lnIdx > pos && lnIdx <= pos+sel+1) ||
+		      (sel < 0 && lnIdx < pos && lnIdx >= pos+sel-1)))) {
+			isSel = 1;
+		} else {
+			isSel = 0;
+		}
+		if (ent->line != lnIdx) {              /* Evict previous line */
+			for (j = 0; j < 2; j++) {
+				if (ent->surface[j] != -1) {
+					AG_WidgetUnmapSurface(cons,
+					    ent->surface[j]);
+					ent->surface[j] = -1;
+				}
+			}
+			ent->line = lnIdx;
+		}
+		if (ent->surface[isSel] == -1) {
+			if ((text = MapLineText(cf, lnIdx, &len)) == NULL) {
+				MapReset(cons, cf);  /* Truncated since indexed */
+				return;
+			}
+			if (len == 0) {
+				continue;
+			}
+			AG_TextColor(cText);
+			AG_TextBGColor(isSel ? cSel : cBg);
+			if ((S = AG_TextRender(text)) == NULL) {
+				continue;
+			}
+			if (S->w == 0 || S->h == 0) {
+				AG_SurfaceFree(S);
+				continue;
+			}
+			ent->surface[isSel] = AG_WidgetMapSurface(cons, S);
+		} else {
+			S = WSURFACE(cons, ent->surface[isSel]);
+		}
+		AG_WidgetBlitSurface(cons, ent->surface[isSel], r->x, r->y);
+
+		if (S->w + wPad > cons->wMax)
+			cons->wMax = S->w + wPad;
+	}
+}
+
+/* Begin displaying a file from a memory mapping. */
+static AG_ConsoleFile *_Nullable
+OpenMapped(AG_Console *_Nonnull cons, const char *_Nonnull lbl, int fd,
+    void *_Nullable pFILE, enum ag_newline_type newline, Uint flags)
+{
+	AG_ConsoleFile *cf;
+	int i;
+
+	if (flags & AG_CONSOLE_FILE_BINARY) {
+		AG_SetErrorS("MMAP mode does not support BINARY");
+		return (NULL);
+	}
+	if (cons->mapFile != NULL) {
+		AG_SetError("%s is already mapped", cons->mapFile->label);
+		return (NULL);
+	}
+	if ((cf = TryMalloc(sizeof(AG_ConsoleFile))) == NULL) {
+		return (NULL);
+	}
+	memset(cf, 0, sizeof(AG_ConsoleFile));
+	cf->flags = flags;
+	if ((cf->label = TryStrdup(lbl)) == NULL) {
+		free(cf);
+		return (NULL);
+	}
+	if ((cf->block = TryMalloc(MAP_BLOCK_SIZE)) == NULL) {
+		free(cf->label);
+		free(cf);
+		return (NULL);
+	}
+	cf->fd = fd;
+	cf->pFILE = pFILE;
+#ifdef AG_DEBUG
+	if (newline >= AG_NEWLINE_LAST) { AG_FatalError("newline arg"); }
+#endif
+	cf->newline = &agNewlineFormats[newline];
+	for (i = 0; i < AG_CONSOLE_FILE_CACHE; i++) {
+		cf->cache[i].line = 0;
+		cf->cache[i].surface[0] = -1;
+		cf->cache[i].surface[1] = -1;
+	}
+	AG_InitTimer(&cf->toScan, "mapScan", 0);
+
+	AG_ObjectLock(cons);
+	TAILQ_INSERT_TAIL(&cons->files, cf, files);
+	cons->mapFile = cf;
+	cons->rOffs = 0;
+	cons->xOffs = 0;
+	cons->wMax = 0;
+	cons->pos = -1;
+	cons->sel = 0;
+	AG_BindUint(cons->vBar, "max", &cf->nLines);
+	AG_AddTimer(cons, &cf->toScan, 1, MapScanTimeout, "%p", cf);
+	AG_Redraw(cons);
+	AG_ObjectUnlock(cons);
+	return (cf);
+}
+
+/* Stop displaying a mapped file and return to the message buffer. */
+static void
+CloseMapped(AG_Console *_Nonnull cons, AG_ConsoleFile *_Nonnull cf)
+{
+	AG_DelTimer(cons, &cf->toScan);
+	MapCacheClear(cons, cf);
+	Free(cf->index);
+	Free(cf->block);
+	Free(cf->line);
+
+	if (cons->mapFile == cf) {
+		cons->mapFile = NULL;
+		AG_BindUint(cons->vBar, "max", &cons->nLines);
+		cons->pos = -1;
+		cons->sel = 0;
+		cons->wMax = 0;
+		ClampVisible(cons);
+		AG_Redraw(cons);
+	}
+}
+#endif /* USE_MMAP */
+
 /*
  * Read, dump and follow a file.
  *
@@ -1366,22 +2167,24 @@ AG_ConsoleFile *
 AG_ConsoleOpenFD(AG_Console *cons, const char *lbl, int fd,
     enum ag_newline_type newline, Uint flags)
 {
-	AG_ConsoleFile *mon;
 	FILE *f;
 
 	AG_OBJECT_ISA(cons, "AG_Widget:AG_Console:*");
 
-	if ((f = fdopen(fd, "r")) == NULL) {
-		AG_SetErrorS("fdopen");
+	if (flags & AG_CONSOLE_FILE_MMAP) {
+#ifdef USE_MMAP
+		return OpenMapped(cons, lbl ? lbl : "fd", fd, NULL, newline,
+		    flags);
+#else
+		AG_SetErrorS("AG_CONSOLE_FILE_MMAP is not supported");
 		return (NULL);
+#endif
 	}
-	if ((mon = AG_ConsoleOpenStream(cons, lbl ? lbl : "fd", NULL,
-	    newline, flags)) == NULL) {
+	if ((f = fdopen(fd, "r")) == NULL) {
+		AG_SetErrorS("fdopen");
 		return (NULL);
 	}
-	mon->pFILE = fdopen(fd, "r");
-	mon->fd = fd;
-	return (mon);
+	return AG_ConsoleOpenStream(cons, lbl ? lbl : "fd", f, newline, flags);
 }
 AG_ConsoleFile *
 AG_ConsoleOpenFile(AG_Console *cons, const char *lbl, const char *file,
@@ -1395,6 +2198,21 @@ AG_ConsoleOpenFile(AG_Console *cons, const char *lbl, const char *file,
 		AG_SetError(_("Could not open %s"), file);
 		return (NULL);
 	}
+	if (flags & AG_CONSOLE_FILE_MMAP) {
+#ifdef USE_MMAP
+		AG_ConsoleFile *cf;
+
+		if ((cf = OpenMapped(cons, lbl ? lbl : AG_ShortFilename(file),
+		    fileno(f), f, newline, flags)) == NULL) {
+			fclose(f);
+		}
+		return (cf);
+#else
+		AG_SetErrorS("AG_CONSOLE_FILE_MMAP is not supported");
+		fclose(f);
+		return (NULL);
+#endif
+	}
 	return AG_ConsoleOpenStream(cons,
 	    lbl ? lbl : AG_ShortFilename(file),
 	    (void *)f,
@@ -1438,7 +2256,11 @@ void
 AG_ConsoleClose(AG_Console *cons, AG_ConsoleFile *cf)
 {
 	AG_OBJECT_ISA(cons, "AG_Widget:AG_Console:*");
-
+	AG_ObjectLock(cons);
+#ifdef USE_MMAP
+	if (cf->flags & AG_CONSOLE_FILE_MMAP)
+		CloseMapped(cons, cf);
+#endif
 	if ((cf->flags & AG_CONSOLE_FILE_LEAVE_OPEN) == 0) {
 		if (cf->pFILE != NULL) {
 			fclose((FILE *)cf->pFILE);
@@ -1450,6 +2272,7 @@ AG_ConsoleClose(AG_Console *cons, AG_ConsoleFile *cf)
 		}
 	}
 	TAILQ_REMOVE(&cons->files, cf, files);
+	AG_ObjectUnlock(cons);
 	Free(cf->label);
 	free(cf);
 }
@@ -22,12 +22,48 @@ typedef struct ag_console_line {
 	void *_Nullable p;                        /* User pointer */
 	struct ag_console *_Nonnull cons;         /* Back pointer to console */
 	struct ag_console_line *_Nullable parent; /* Parent line for multi-line groups */
+	struct ag_console_chunk *_Nonnull chunk;  /* Arena chunk holding the line */
+	Uint flags;
+#define AG_CONSOLE_LINE_HEAP_TEXT 0x01  /* Text was reallocated off the arena */
+#define AG_CONSOLE_LINE_DRAWN     0x02  /* Drawn in the current frame */
+	Uint32 _pad;
 } AG_ConsoleLine;
 
+/*
+ * Arena chunk. Lines (and their text) are allocated sequentially from a
+ * FIFO of chunks, which are released as the oldest lines are discarded.
+ */
+typedef struct ag_console_chunk {
+	struct ag_console_chunk *_Nullable next;  /* Next (more recent) chunk */
+	AG_Size size;                             /* Size of data area */
+	AG_Size used;                             /* Bytes allocated */
+	Uint nLines;                              /* Live lines in chunk */
+	Uint32 _pad;
+	/* Followed by data */
+} AG_ConsoleChunk;
+
+#ifndef AG_CONSOLE_CHUNK_SIZE
+#define AG_CONSOLE_CHUNK_SIZE 65536
+#endif
+
+#ifndef AG_CONSOLE_FILE_STRIDE
+#define AG_CONSOLE_FILE_STRIDE 64	/* Lines per index entry (MMAP mode) */
+#endif
+#ifndef AG_CONSOLE_FILE_CACHE
+#define AG_CONSOLE_FILE_CACHE 128	/* Rendered line cache (MMAP mode) */
+#endif
+
+/* Cached rendering of a line of a mapped file. */
+typedef struct ag_console_file_ent {
+	Uint line;                      /* Line number */
+	int surface[2];                 /* Cached surfaces (or -1) */
+} AG_ConsoleFileEnt;
+
 typedef struct ag_console_file {
 	Uint flags;
 #define AG_CONSOLE_FILE_BINARY     0x01  /* Display binary in hex dump format */
 #define AG_CONSOLE_FILE_LEAVE_OPEN 0x02  /* Don't close FILE* or fd on detach */
+#define AG_CONSOLE_FILE_MMAP       0x04  /* Display in place (don't copy) */
 	int fd;				 /* File descriptor */
 	char *_Nullable label;		 /* Label (e.g., filename or id) */
 	void *pFILE;			 /* FILE * pointer */
@@ -36,6 +72,19 @@ typedef struct ag_console_file {
 	AG_Color *_Nullable color;	 /* Alternate color */
 	const AG_NewlineFormat *newline; /* Newline encoding */
 	AG_TAILQ_ENTRY(ag_console_file) files;
+
+	/* For AG_CONSOLE_FILE_MMAP */
+	AG_Size size;			 /* Last known file size */
+	AG_Size scanned;		 /* Bytes indexed so far */
+	AG_Size *_Nullable index;	 /* Offset of every STRIDE'th line */
+	Uint nIndex, maxIndex;
+	Uint nNewlines;			 /* Newlines found so far */
+	Uint nLines;			 /* Displayable lines */
+	char *_Nullable block;		 /* Read buffer */
+	char *_Nullable line;		 /* Text of the last line read */
+	AG_Size lineSize;
+	AG_Timer toScan;		 /* Indexing and tailing timer */
+	AG_ConsoleFileEnt cache[AG_CONSOLE_FILE_CACHE];
 } AG_ConsoleFile;
 
 typedef struct ag_console {
@@ -53,8 +102,11 @@ typedef struct ag_console {
 	int lineskip;                            /* Space between lines */
 	int xOffs;                               /* Horiz display offset (px) */
 
-	AG_ConsoleLine *_Nullable *_Nonnull lines;  /* Lines in buffer */
+	AG_ConsoleLine *_Nullable *_Nonnull lines;  /* Lines (ring buffer) */
 	Uint                               nLines;  /* Line count */
+	Uint                            lineHead;   /* Index of oldest line */
+	Uint                            lineCap;    /* Allocated ring size */
+	Uint                            maxLines;   /* Line limit (0 = none) */
 
 	int wMax;                                /* Width of widest line (px) */
 	Uint rOffs;                              /* Row display offset */
@@ -68,6 +120,14 @@ typedef struct ag_console {
 	struct ag_popup_menu *_Nullable pm;      /* Active popup menu */
 	AG_Timer beginSelectTo;	                 /* Timer for double-click */
 	AG_TAILQ_HEAD_(ag_console_file) files;   /* Files being monitored */
+
+	AG_ConsoleChunk *_Nullable chunkHead;    /* Oldest arena chunk */
+	AG_ConsoleChunk *_Nullable chunkTail;    /* Current arena chunk */
+	AG_ConsoleChunk *_Nullable chunkSpare;   /* Recycled arena chunk */
+	AG_ConsoleLine *_Nullable *_Nullable mapped; /* Lines with cached surfaces */
+	Uint nMapped;
+	Uint maxMapped;
+	AG_ConsoleFile *_Nullable mapFile;       /* Displayed mapped file */
 } AG_Console;
 
 #define AGCONSOLE(obj)            ((AG_Console *)(obj))
@@ -79,6 +139,10 @@ typedef struct ag_console {
 #define AG_CONST_CONSOLE_PTR(n)   AGCCONSOLE( AG_CONST_OBJECT((n),"AG_Widget:AG_Console:*") )
 #define AG_CONST_CONSOLE_NAMED(n) AGCCONSOLE( AG_CONST_OBJECT_NAMED((n),"AG_Widget:AG_Console:*") )
 
+/* Return the line at index i (0 = oldest). */
+#define AG_ConsoleGetLine(cons,i) \
+	((cons)->lines[((cons)->lineHead + (i)) % (cons)->lineCap])
+
 __BEGIN_DECLS
 extern AG_WidgetClass agConsoleClass;
 
@@ -86,6 +150,11 @@ AG_Console *_Nonnull AG_ConsoleNew(void *_Nullable, Uint);
 
 AG_ConsoleLine *_Nonnull AG_ConsoleAppendLine(AG_Console *_Nonnull,
                                               const char *_Nullable);
+void AG_ConsoleAppendLines(AG_Console *_Nonnull,
+                           const char *_Nonnull const *_Nonnull, Uint);
+void AG_ConsoleAppendBuffer(AG_Console *_Nonnull, const char *_Nonnull,
+                            AG_Size, enum ag_newline_type);
+void AG_ConsoleSetMaxLines(AG_Console *_Nonnull, Uint);
 AG_ConsoleLine *_Nonnull AG_ConsoleMsgS(AG_Console *_Nonnull, const char *_Nonnull);
 AG_ConsoleLine *_Nonnull AG_ConsoleMsg(AG_Console *_Nonnull, const char *_Nonnull, ...)
                                       FORMAT_ATTRIBUTE(printf,2,3);
@@ -64,6 +64,7 @@ static const struct dev_tool_ent {
 	{ N_("Registered classes"),	AG_DEV_ClassInfo },
 	{ N_("Loaded fonts"),		AG_DEV_FontInfo },
 #ifdef AG_ENABLE_STRING
+	{ N_("Performance Monitor"),	AG_DEV_PerfMonitor },
 	{ N_("Timer Inspector"),	AG_DEV_TimerInspector },
 #endif
 #ifdef AG_UNICODE
@@ -69,6 +69,8 @@ AG_FlagDescrRO agArchExtnNames[] = {
 	{ AG_EXT_SSE4A,          _("SSE4a Extensions") },
 	{ AG_EXT_SSE41,            "SSE41" },
 	{ AG_EXT_SSE42,            "SSE42" },
+	{ AG_EXT_AVX,              "AVX" },
+	{ AG_EXT_AVX2,             "AVX2" },
 	{ AG_EXT_SSE5A,          _("SSE5a Extensions") },
 	{ AG_EXT_SSE_MISALIGNED, _("Misaligned SSE Mode") },
 	{ AG_EXT_LONG_MODE,      _("Long Mode") },
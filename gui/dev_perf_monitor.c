@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2026 Julien Nadeau Carriere <vedge@csoft.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Performance monitor tool. This displays the counters and timing
+ * histograms collected by AG_Perf(3).
+ */
+
+#include <agar/core/core.h>
+#if defined(AG_WIDGETS) && defined(AG_TIMERS) && defined(AG_ENABLE_STRING)
+
+#include <agar/gui/window.h>
+#include <agar/gui/treetbl.h>
+#include <agar/gui/button.h>
+#include <agar/gui/checkbox.h>
+#include <agar/gui/box.h>
+#include <agar/gui/file_dlg.h>
+
+enum {
+	ROW_TIMINGS = 1,
+	ROW_WINDOWS,
+	ROW_WIDGET_CLASSES,
+	ROW_FIRST_HIST = 100
+};
+
+/* Add a row displaying the statistics of a histogram. */
+static void
+AddHistRow(AG_Treetbl *_Nonnull tt, AG_TreetblRow *_Nonnull parent, int id,
+    const char *_Nonnull name, const AG_PerfHist *_Nonnull h)
+{
+	AG_TreetblAddRow(tt, parent, id, "%s,%s,%s,%s,%s,%s",
+	    0, name,
+	    1, AG_PrintfN(0, "%llu", (unsigned long long)h->n),
+	    2, AG_PrintfN(1, "%.1f", (h->n > 0) ?
+	                  (double)h->tSum / (double)h->n / 1000.0 : 0.0),
+	    3, AG_PrintfN(2, "%.1f",
+	                  (double)AG_PerfHistPercentile(h, 50) / 1000.0),
+	    4, AG_PrintfN(3, "%.1f",
+	                  (double)AG_PerfHistPercentile(h, 95) / 1000.0),
+	    5, AG_PrintfN(4, "%.1f", (double)h->tMax / 1000.0));
+}
+
+static Uint32
+RefreshTableTimeout(AG_Timer *_Nonnull refreshTo, AG_Event *_Nonnull event)
+{
+	AG_Treetbl *tt = AG_TREETBL_SELF();
+	AG_Label *lbl = AG_LABEL_PTR(1);
+	const int *pauseFlag = (const int *)AG_PTR(2);
+	const Uint64 *C = agPerf.counters;
+	AG_TreetblRow *row;
+	double elapsed;
+	int i, j, id;
+
+	if (*pauseFlag) {
+		goto out;
+	}
+	elapsed = (double)(AG_PerfTime() - agPerf.tReset) / 1e9;
+	AG_LabelText(lbl,
+	    _("Frames: %llu (%.1f fps)\n"
+	      "Timers fired: %llu\n"
+	      "Glyph cache: %llu hits, %llu misses\n"
+	      "Texture uploads: %llu (%llu KiB)"),
+	    (unsigned long long)C[AG_PERF_FRAMES],
+	    (elapsed > 0.0) ? (double)C[AG_PERF_FRAMES] / elapsed : 0.0,
+	    (unsigned long long)C[AG_PERF_TIMERS_FIRED],
+	    (unsigned long long)C[AG_PERF_GLYPH_HITS],
+	    (unsigned long long)C[AG_PERF_GLYPH_MISSES],
+	    (unsigned long long)C[AG_PERF_TEXTURE_UPLOADS],
+	    (unsigned long long)(C[AG_PERF_TEXTURE_BYTES] >> 10));
+
+	AG_TreetblClearRows(tt);
+
+	id = ROW_FIRST_HIST;
+	row = AG_TreetblAddRow(tt, NULL, ROW_TIMINGS, "%s", 0, _("Timings"));
+	AG_TreetblExpandRow(tt, row);
+	for (i = 0; i < AG_PERF_HIST_LAST; i++)
+		AddHistRow(tt, row, id++, AG_PerfHistName(i), &agPerf.hists[i]);
+
+	AG_MutexLock(&agPerfLock);
+	for (i = 0; i < AG_PERF_KEYED_LAST; i++) {
+		const AG_PerfKeyed *kt = &agPerf.keyed[i];
+
+		row = AG_TreetblAddRow(tt, NULL,
+		    (i == AG_PERF_BY_WINDOW) ? ROW_WINDOWS : ROW_WIDGET_CLASSES,
+		    "%s",
+		    0, (i == AG_PERF_BY_WINDOW) ? _("Windows") :
+		                                  _("Widget classes"));
+		AG_TreetblExpandRow(tt, row);
+		for (j = 0; j < AG_PERF_KEYED_MAX; j++) {
+			const AG_PerfHist *h = kt->ents[j];
+
+			if (h != NULL && h->n > 0)
+				AddHistRow(tt, row, id++, h->name, h);
+		}
+	}
+	AG_MutexUnlock(&agPerfLock);
+out:
+	return (refreshTo->ival);
+}
+
+static void
+ResetPerf(AG_Event *_Nonnull event)
+{
+	AG_PerfReset();
+}
+
+#ifdef AG_SERIALIZATION
+static void
+SaveJSON(AG_Event *_Nonnull event)
+{
+	const char *path = AG_STRING(1);
+
+	if (AG_PerfSaveJSON(path) == -1)
+		AG_TextMsgFromError();
+}
+
+static void
+ExportJSON(AG_Event *_Nonnull event)
+{
+	AG_Window *win;
+	AG_FileDlg *fd;
+
+	if ((win = AG_WindowNew(0)) == NULL) {
+		return;
+	}
+	AG_WindowSetCaptionS(win, _("Export performance data to..."));
+	fd = AG_FileDlgNewMRU(win, "perf-export",
+	                      AG_FILEDLG_CLOSEWIN | AG_FILEDLG_SAVE |
+	                      AG_FILEDLG_EXPAND);
+	AG_FileDlgAddType(fd, _("JSON"), "*.json", SaveJSON, NULL);
+	AG_FileDlgSetFilenameS(fd, "perf.json");
+	AG_WindowShow(win);
+}
+#endif /* AG_SERIALIZATION */
+
+static void
+CloseWindow(AG_Event *_Nonnull event)
+{
+	AG_Window *win = AG_WINDOW_SELF();
+
+	AG_ObjectDetach(win);
+}
+
+AG_Window *
+AG_DEV_PerfMonitor(void)
+{
+	static int pauseFlag = 0;
+	AG_Window *win;
+	AG_Treetbl *tt;
+	AG_Label *lbl;
+	AG_Box *hBox;
+	AG_Timer *to;
+
+	if ((win = AG_WindowNewNamedS(0, "DEV_PerfMonitor")) == NULL) {
+		return (NULL);
+	}
+	AG_WindowSetCaptionS(win, _("Performance Monitor"));
+
+	hBox = AG_BoxNewHoriz(win, AG_BOX_HFILL);
+	{
+		AG_CheckboxNewInt(hBox, 0, _("Enabled"), &agPerf.enabled);
+		AG_ButtonNewInt(hBox, AG_BUTTON_STICKY, _("Pause"),
+		    &pauseFlag);
+		AG_ButtonNewFn(hBox, 0, _("Reset"), ResetPerf, NULL);
+#ifdef AG_SERIALIZATION
+		AG_ButtonNewFn(hBox, 0, _("Export JSON..."), ExportJSON, NULL);
+#endif
+	}
+
+	lbl = AG_LabelNew(win, AG_LABEL_HFILL, _("Frames: ...\n\n\n"));
+
+	tt = AG_TreetblNew(win, AG_TREETBL_EXPAND, NULL, NULL);
+	AG_TreetblSizeHint(tt, 120, 30);
+	AG_TreetblAddCol(tt, 0, "<XXXXXXXXXXXXXXXXXX>", _("Name"));
+	AG_TreetblAddCol(tt, 1, "<XXXXXXXX>", _("Count"));
+	AG_TreetblAddCol(tt, 2, "<XXXXXXX>", _("Mean (us)"));
+	AG_TreetblAddCol(tt, 3, "<XXXXXXX>", _("p50 (us)"));
+	AG_TreetblAddCol(tt, 4, "<XXXXXXX>", _("p95 (us)"));
+	AG_TreetblAddCol(tt, 5, "<XXXXXXX>", _("Max (us)"));
+
+	to = AG_AddTimerAuto(tt, 500, RefreshTableTimeout, "%p,%p", lbl,
+	    &pauseFlag);
+	if (to != NULL)
+		Strlcpy(to->name, "perfMonitor", sizeof(to->name));
+
+	AG_SetEvent(win, "window-close", CloseWindow, "%p", tt);
+	return (win);
+}
+
+#endif /* AG_WIDGETS and AG_TIMERS and AG_ENABLE_STRING */
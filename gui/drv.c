@@ -65,6 +65,7 @@ extern AG_DriverClass agDriverWGL;
 extern AG_DriverClass agDriverCocoa;
 #endif
 extern AG_DriverClass agDriverDUMMY;
+extern AG_DriverClass agDriverHEADLESS;
 
 AG_Object       agDrivers;			/* Drivers VFS */
 AG_DriverClass *agDriverOps = NULL;		/* Current driver class */
@@ -93,6 +94,7 @@ AG_DriverClass *agDriverList[] = {
 	&agDriverSDLFB,
 #endif
 	&agDriverDUMMY,
+	&agDriverHEADLESS,	/* Never auto-selected (after dummy) */
 	NULL
 };
 
@@ -345,7 +347,6 @@ static void
 Init(void *_Nonnull obj)
 {
 	AG_Driver *drv = obj;
-	Uint i;
 
 	drv->id = 0;
 	drv->flags = 0;
@@ -364,10 +365,8 @@ Init(void *_Nonnull obj)
 	drv->mouse = NULL;
 	drv->joys = NULL;
 	drv->nJoys = 0;
-	drv->glyphCache = Malloc(AG_GLYPH_NBUCKETS*sizeof(AG_GlyphCache));
-	for (i = 0; i < AG_GLYPH_NBUCKETS; i++) {
-		SLIST_INIT(&drv->glyphCache[i].glyphs);
-	}
+	drv->glyphCache = Malloc(sizeof(AG_GlyphCache));
+	AG_TextInitGlyphCache(drv->glyphCache);
 	drv->gl = NULL;
 	drv->activeCursor = NULL;
 	TAILQ_INIT(&drv->cursors);
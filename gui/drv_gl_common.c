@@ -175,8 +175,7 @@ AG_GL_DestroyContext(void *obj)
 {
 	AG_Driver *drv = obj;
 	AG_GL_Context *gl = drv->gl;
-	AG_Glyph *glyph;
-	int i;
+	AG_GlyphPage *pg;
 
 #if defined(AG_DEBUG) && defined(GL_DEBUG_OUTPUT)
 	if (agGLdebugOutput)
@@ -187,21 +186,22 @@ AG_GL_DestroyContext(void *obj)
 	Debug(drv, "GL Context Destroy\n");
 #endif
 
-	/* Invalidate any cached glyph renderings. */
-	for (i = 0; i < AG_GLYPH_NBUCKETS; i++) {
-		SLIST_FOREACH(glyph, &drv->glyphCache[i].glyphs, glyphs) {
-			if (glyph->texture != 0) {
+	/* Invalidate the textures of the glyph atlas. */
+	TAILQ_FOREACH(pg, &drv->glyphCache->pages, pages) {
+		if (pg->texture != 0) {
 #ifdef DEBUG_GL
-				Debug(drv, "GL delete glyph #%d\n", glyph->texture);
+			Debug(drv, "GL delete glyph page #%d\n", pg->texture);
 #endif
-				glDeleteTextures(1, (GLuint *)&glyph->texture);
-				glyph->texture = 0;
-			}
+			glDeleteTextures(1, (GLuint *)&pg->texture);
+			pg->texture = 0;
 		}
+		pg->flags |= AG_GLYPH_PAGE_DIRTY;
 	}
 	
 	if (gl->nTextureGC > 0) {
 #ifdef DEBUG_GL
+		int i;
+
 		for (i = 0; i < gl->nTextureGC; i++)
 			Debug(drv, "GL delete texture #%d\n", gl->textureGC[i]);
 #endif
@@ -401,6 +401,7 @@ PowOf2i(int i)
 void
 AG_GL_StdUploadTexture(void *obj, Uint *rv, AG_Surface *S, AG_TexCoord *tc)
 {
+	const Uint64 t0 = AG_PerfBegin();
 	AG_Surface *GS;
 	GLuint texture;
 #ifdef ENABLE_GL_NO_NPOT
@@ -447,10 +448,14 @@ AG_GL_StdUploadTexture(void *obj, Uint *rv, AG_Surface *S, AG_TexCoord *tc)
 
 	glBindTexture(GL_TEXTURE_2D, 0);
 
+	AG_PerfCount(AG_PERF_TEXTURE_UPLOADS);
+	AG_PerfCountN(AG_PERF_TEXTURE_BYTES, GS->h * GS->pitch);
+
 	if (GS != S)
 		AG_SurfaceFree(GS);
 
 	*rv = (Uint)texture;
+	AG_PerfEnd(AG_PERF_TEXTURE_UPLOAD, t0);
 }
 
 /*
@@ -462,6 +467,7 @@ AG_GL_StdUploadTexture(void *obj, Uint *rv, AG_Surface *S, AG_TexCoord *tc)
 void
 AG_GL_StdUpdateTexture(void *obj, Uint texture, AG_Surface *S, AG_TexCoord *tc)
 {
+	const Uint64 t0 = AG_PerfBegin();
 	AG_Surface *GS;
 #ifdef ENABLE_GL_NO_NPOT
 	const int w = (agGLuseNPOT) ? S->w : PowOf2i(S->w);
@@ -505,8 +511,13 @@ AG_GL_StdUpdateTexture(void *obj, Uint texture, AG_Surface *S, AG_TexCoord *tc)
 	    AG_GL_SurfaceType(GS), GS->pixels);
 	glBindTexture(GL_TEXTURE_2D, 0);
 
+	AG_PerfCount(AG_PERF_TEXTURE_UPLOADS);
+	AG_PerfCountN(AG_PERF_TEXTURE_BYTES, GS->h * GS->pitch);
+
 	if (GS != S)
 		AG_SurfaceFree(GS);
+
+	AG_PerfEnd(AG_PERF_TEXTURE_UPLOAD, t0);
 }
 
 /*
@@ -1418,29 +1429,63 @@ AG_GL_DrawRectBlended(void *obj, const AG_Rect *r, const AG_Color *c,
 		AGDRIVER_CLASS(obj)->popBlendingMode(obj);
 }
 
-/* Prepare for rendering an AG_Text(3) glyph. */
+/*
+ * Prepare for rendering an AG_Text(3) glyph. Upload (or update) the texture
+ * of its atlas page if new glyphs were added to it.
+ */
 void
-AG_GL_UpdateGlyph(void *obj, AG_Glyph *gl)
+AG_GL_UpdateGlyph(void *obj, AG_Glyph *G)
 {
 	AG_Driver *drv = (AG_Driver *)obj;
+	AG_GlyphPage *pg = G->page;
 
 	AG_OBJECT_ISA(drv, "AG_Driver:*");
 
-	AGDRIVER_CLASS(drv)->uploadTexture(drv,
-	    &gl->texture, gl->su, &gl->texcoords);
+	if (!(pg->flags & AG_GLYPH_PAGE_DIRTY)) {
+		return;
+	}
+	pg->flags &= ~(AG_GLYPH_PAGE_DIRTY);
+
+	if (pg->texture == 0) {
+		AGDRIVER_CLASS(drv)->uploadTexture(drv, &pg->texture, pg->S,
+		    &pg->texcoords);
+	} else {
+		AGDRIVER_CLASS(drv)->updateTexture(drv, pg->texture, pg->S,
+		    &pg->texcoords);
+	}
 }
 
-/* Render an AG_Text(3) glyph at x,y. */
+/*
+ * Render an AG_Text(3) glyph at x,y. Coverage masks are colorized with the
+ * glyph's FG color (GL_MODULATE).
+ */
 void
 AG_GL_DrawGlyph(void *obj, const AG_Glyph *G, int x, int y)
 {
-	glBindTexture(GL_TEXTURE_2D, G->texture);
+	const AG_TexCoord tc = G->texcoords;
+	const AG_Color *c = &G->color;
+	const int w = G->su->w;
+	const int h = G->su->h;
+
+	if (G->colorBG.a > AG_TRANSPARENT) {
+		AG_Rect r;
+
+		r.x = x;
+		r.y = y;
+		r.w = w;
+		r.h = h;
+		AG_GL_DrawRectBlended(obj, &r, &G->colorBG,
+		    AG_ALPHA_SRC, AG_ALPHA_ONE_MINUS_SRC);
+	}
+	AGDRIVER_CLASS(obj)->pushBlendingMode(obj, AG_ALPHA_SRC,
+	                                           AG_ALPHA_ONE_MINUS_SRC);
+	if (!(G->flags & AG_GLYPH_COLORED)) {
+		glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+		GL_Color4uH(c->r, c->g, c->b, c->a);
+	}
+	glBindTexture(GL_TEXTURE_2D, G->page->texture);
 	glBegin(GL_POLYGON);
 	{
-		const AG_TexCoord tc = G->texcoords;
-		const int w = G->su->w;
-		const int h = G->su->h;
-
 		glTexCoord2f(tc.x, tc.y);  glVertex2i(x,   y);
 		glTexCoord2f(tc.w, tc.y);  glVertex2i(x+w, y);
 		glTexCoord2f(tc.w, tc.h);  glVertex2i(x+w, y+h);
@@ -1448,6 +1493,10 @@ AG_GL_DrawGlyph(void *obj, const AG_Glyph *G, int x, int y)
 	}
 	glEnd();
 	glBindTexture(GL_TEXTURE_2D, 0);
+	if (!(G->flags & AG_GLYPH_COLORED)) {
+		glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	}
+	AGDRIVER_CLASS(obj)->popBlendingMode(obj);
 }
 
 /* Upload a texture. */
@@ -0,0 +1,1645 @@
+/*
+ * Copyright (c) 2026 Julien Nadeau Carriere <vedge@csoft.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Headless single-window driver. Rasterizes everything in software into
+ * an offscreen 32-bit AG_Surface(3), which can be captured or dumped to
+ * image files after every frame. Requires no display server.
+ */
+
+#include <agar/core/core.h>
+#include <agar/gui/gui.h>
+#include <agar/gui/drv.h>
+#include <agar/gui/text.h>
+#include <agar/gui/window.h>
+#include <agar/gui/cursors.h>
+
+#include <stdlib.h>
+
+typedef struct ag_driver_headless {
+	struct ag_driver_sw _inherit;	/* AG_Driver -> AG_DriverSw */
+
+	AG_Surface *_Nullable S;	/* Framebuffer surface */
+	Uint flags;
+#define HEADLESS_EXT_SURFACE 0x01	/* Framebuffer is not ours */
+
+	Uint nFrame;			/* Frames rendered so far */
+
+	AG_ClipRect *_Nullable clipRects;	/* Clipping rectangle stack */
+	Uint                  nClipRects;
+
+	Uint           nPolyInts;
+	int *_Nullable  polyInts;	/* Sorted intersections for drawPolygon */
+
+	char *_Nullable outPrefix;	/* Frame dump filename (before number) */
+	char *_Nullable outSuffix;	/* Frame dump filename (after number) */
+	int             outDigits;	/* Frame number width (-1 = no number) */
+	Uint32 _pad;
+} AG_DriverHEADLESS;
+
+AG_DriverSwClass agDriverHEADLESS;
+
+static int nDrivers = 0;			/* Opened driver instances */
+static AG_EventSink *_Nullable hlEventSpinner = NULL;
+static AG_EventSink *_Nullable hlEventEpilogue = NULL;
+
+#define HEADLESS_WIDTH_DEFAULT  640
+#define HEADLESS_HEIGHT_DEFAULT 480
+
+/* Address of the 32-bit pixel at x,y in the framebuffer. */
+#define HL_PIXEL(S,x,y) \
+	((Uint32 *)((S)->pixels + (y)*(S)->pitch + ((x) << 2)))
+
+static void HEADLESS_DrawRectFilled(void *_Nonnull, const AG_Rect *_Nonnull,
+                                    const AG_Color *_Nonnull);
+static void HEADLESS_PushClipRect(void *_Nonnull, const AG_Rect *_Nonnull);
+static void HEADLESS_PopClipRect(void *_Nonnull);
+static int CompareInts(const void *_Nonnull, const void *_Nonnull);
+
+static void
+Init(void *_Nonnull obj)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	hl->S = NULL;
+	hl->flags = 0;
+	hl->nFrame = 0;
+	hl->clipRects = NULL;
+	hl->nClipRects = 0;
+	hl->nPolyInts = 0;
+	hl->polyInts = NULL;
+	hl->outPrefix = NULL;
+	hl->outSuffix = NULL;
+	hl->outDigits = -1;
+}
+
+static void
+Destroy(void *_Nonnull obj)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	if (hl->S != NULL && !(hl->flags & HEADLESS_EXT_SURFACE)) {
+		AG_SurfaceFree(hl->S);
+	}
+	Free(hl->clipRects);
+	Free(hl->polyInts);
+	Free(hl->outPrefix);
+	Free(hl->outSuffix);
+}
+
+/*
+ * Parse the "out" option. The filename may contain a single "%u" (or
+ * "%0Nu") conversion, which is substituted by the frame number.
+ */
+static int
+ParseOutPattern(AG_DriverHEADLESS *_Nonnull hl, const char *_Nonnull s)
+{
+	const char *c, *sEnd;
+	int digits = 0;
+
+	if ((c = strchr(s, '%')) == NULL) {
+		hl->outPrefix = Strdup(s);
+		hl->outSuffix = Strdup("");
+		hl->outDigits = -1;
+		return (0);
+	}
+	for (sEnd = &c[1]; *sEnd >= '0' && *sEnd <= '9'; sEnd++) {
+		digits = digits*10 + (*sEnd - '0');
+	}
+	if (*sEnd != 'u' || strchr(&sEnd[1], '%') != NULL || digits > 32) {
+		AG_SetError(_("Bad output filename pattern: \"%s\""), s);
+		return (-1);
+	}
+	hl->outPrefix = Strdup(s);
+	hl->outPrefix[c - s] = '\0';
+	hl->outSuffix = Strdup(&sEnd[1]);
+	hl->outDigits = digits;
+	return (0);
+}
+
+/*
+ * Generic driver operations
+ */
+
+#ifdef AG_EVENT_LOOP
+static int
+HEADLESS_EventSink(AG_EventSink *_Nonnull es, AG_Event *_Nonnull event)
+{
+	/* There is no input device to poll. */
+	AG_Delay(1);
+	return (0);
+}
+
+static int
+HEADLESS_EventEpilogue(AG_EventSink *_Nonnull es, AG_Event *_Nonnull event)
+{
+	AG_WindowDrawQueued();
+	AG_WindowProcessQueued();
+	return (0);
+}
+#endif /* AG_EVENT_LOOP */
+
+static int
+HEADLESS_Open(void *_Nonnull obj, const char *_Nullable spec)
+{
+	AG_Driver *drv = obj;
+	AG_DriverSw *dsw = obj;
+	AG_DriverHEADLESS *hl = obj;
+
+	if (nDrivers != 0) {
+		AG_SetError("Multiple headless displays are not supported");
+		return (-1);
+	}
+	if (AG_Defined(drv, "out") &&
+	    ParseOutPattern(hl, AG_GetStringP(drv,"out")) == -1)
+		return (-1);
+
+	if ((drv->mouse = AG_MouseNew(hl, "Headless mouse")) == NULL ||
+	    (drv->kbd = AG_KeyboardNew(hl, "Headless keyboard")) == NULL)
+		goto fail;
+
+	/* Redraw as soon as a window is dirty unless fpsMax is given. */
+	dsw->rNom = 0;
+	if (AG_Defined(drv, "fpsMax")) {
+		char buf[16], *ep;
+		float v;
+
+		AG_GetString(drv, "fpsMax", buf, sizeof(buf));
+		v = (float)strtod(buf, &ep);
+		if (*ep == '\0' && v > 0.0f)
+			dsw->rNom = (Uint)(1000.0f/v);
+	}
+	if (AG_Defined(drv, "bgColor")) {
+		AG_ColorFromString(&dsw->bgColor,
+		    AG_GetStringP(drv,"bgColor"),
+		    NULL);
+	}
+#ifdef AG_EVENT_LOOP
+	if ((hlEventSpinner = AG_AddEventSpinner(HEADLESS_EventSink, "%p", drv)) == NULL ||
+	    (hlEventEpilogue = AG_AddEventEpilogue(HEADLESS_EventEpilogue, NULL)) == NULL)
+		goto fail;
+#endif
+	nDrivers = 1;
+	return (0);
+fail:
+#ifdef AG_EVENT_LOOP
+	if (hlEventSpinner != NULL) { AG_DelEventSpinner(hlEventSpinner); hlEventSpinner = NULL; }
+	if (hlEventEpilogue != NULL) { AG_DelEventEpilogue(hlEventEpilogue); hlEventEpilogue = NULL; }
+#endif
+	if (drv->kbd != NULL) { AG_ObjectDelete(drv->kbd); drv->kbd = NULL; }
+	if (drv->mouse != NULL) { AG_ObjectDelete(drv->mouse); drv->mouse = NULL; }
+	return (-1);
+}
+
+static void
+HEADLESS_Close(void *_Nonnull obj)
+{
+	AG_Driver *drv = obj;
+
+#ifdef AG_DEBUG
+	if (nDrivers != 1) { AG_FatalError("Driver close without open"); }
+#endif
+#ifdef AG_EVENT_LOOP
+	AG_DelEventSpinner(hlEventSpinner); hlEventSpinner = NULL;
+	AG_DelEventEpilogue(hlEventEpilogue); hlEventEpilogue = NULL;
+#endif
+	AG_FreeCursors(drv);
+
+	AG_ObjectDelete(drv->kbd); drv->kbd = NULL;
+	AG_ObjectDelete(drv->mouse); drv->mouse = NULL;
+
+	nDrivers = 0;
+}
+
+static int
+HEADLESS_GetDisplaySize(Uint *_Nonnull w, Uint *_Nonnull h)
+{
+	if (agDriverSw != NULL &&
+	    AGDRIVER_CLASS(agDriverSw) == (AG_DriverClass *)&agDriverHEADLESS) {
+		*w = agDriverSw->w;
+		*h = agDriverSw->h;
+	} else {
+		*w = HEADLESS_WIDTH_DEFAULT;
+		*h = HEADLESS_HEIGHT_DEFAULT;
+	}
+	return (0);
+}
+
+static int
+HEADLESS_PendingEvents(void *_Nonnull obj)
+{
+	return (0);
+}
+
+static int
+HEADLESS_GetNextEvent(void *_Nullable obj, AG_DriverEvent *_Nonnull dev)
+{
+	return (0);
+}
+
+/*
+ * There are no input devices, but the application may still post
+ * display-level events (e.g., to simulate a resize).
+ */
+static int
+HEADLESS_ProcessEvent(void *_Nullable obj, AG_DriverEvent *_Nonnull dev)
+{
+	AG_DriverSw *dsw = obj;
+	int rv = 1;
+
+	AG_LockVFS(&agDrivers);
+	switch (dev->type) {
+	case AG_DRIVER_VIDEORESIZE:
+		if (AG_ResizeDisplay(dev->videoresize.w, dev->videoresize.h) == -1) {
+			Verbose("ResizeDisplay: %s\n", AG_GetError());
+		}
+		break;
+	case AG_DRIVER_EXPOSE:
+		if (dsw != NULL) {
+			dsw->flags |= AG_DRIVER_SW_REDRAW;
+		}
+		break;
+	case AG_DRIVER_CLOSE:
+		AG_UnlockVFS(&agDrivers);
+		AG_Terminate(0);
+		/* NOTREACHED */
+		return (rv);
+	default:
+		rv = 0;
+		break;
+	}
+	AG_UnlockVFS(&agDrivers);
+	return (rv);
+}
+
+static void
+HEADLESS_BeginRendering(void *_Nonnull obj)
+{
+	/* Nothing to do */
+}
+
+static void
+HEADLESS_RenderWindow(struct ag_window *_Nonnull win)
+{
+	AG_Driver *drv = WIDGET(win)->drv;
+	AG_Rect rd;
+
+	if (win->pvt.partial) {		/* Redraw the damaged area only */
+		rd.x = win->pvt.rDamage.x1;
+		rd.y = win->pvt.rDamage.y1;
+		rd.w = win->pvt.rDamage.w;
+		rd.h = win->pvt.rDamage.h;
+		HEADLESS_PushClipRect(drv, &rd);
+		AG_WidgetDraw(win);
+		HEADLESS_PopClipRect(drv);
+	} else {
+		AG_WidgetDraw(win);
+	}
+}
+
+/* Write the current frame to the file named by the "out" option. */
+static void
+DumpFrame(AG_DriverHEADLESS *_Nonnull hl)
+{
+	char path[AG_PATHNAME_MAX];
+
+	if (hl->outDigits == -1) {
+		Strlcpy(path, hl->outPrefix, sizeof(path));
+	} else {
+		Snprintf(path, sizeof(path), "%s%0*u%s", hl->outPrefix,
+		    hl->outDigits, hl->nFrame, hl->outSuffix);
+	}
+	if (AG_SurfaceExportFile(hl->S, path) == -1) {
+		Verbose("%s: %s (disabling frame output)\n", OBJECT(hl)->name,
+		    AG_GetError());
+		Free(hl->outPrefix);
+		hl->outPrefix = NULL;
+	}
+}
+
+static void
+HEADLESS_EndRendering(void *_Nonnull obj)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+#ifdef AG_DEBUG
+	if (hl->nClipRects != 1)
+		AG_FatalError("Inconsistent PushClipRect() / PopClipRect()");
+#endif
+	if (hl->outPrefix != NULL) {
+		DumpFrame(hl);
+	}
+	hl->nFrame++;
+}
+
+/* Fill the intersection of r and the clipping rectangle with px. */
+static void
+FillRect32(AG_Surface *_Nonnull S, const AG_Rect *_Nonnull r, Uint32 px)
+{
+	const AG_Rect *rc = &S->clipRect;
+	int x1 = MAX(r->x, rc->x);
+	int y1 = MAX(r->y, rc->y);
+	int x2 = MIN(r->x + r->w, rc->x + rc->w);
+	int y2 = MIN(r->y + r->h, rc->y + rc->h);
+	int x, y;
+
+	if (x2 <= x1 || y2 <= y1) {
+		return;
+	}
+	for (y = y1; y < y2; y++) {
+		Uint32 *p = HL_PIXEL(S, x1, y);
+
+		for (x = x1; x < x2; x++)
+			*p++ = px;
+	}
+}
+
+static void
+HEADLESS_FillRect(void *_Nonnull obj, const AG_Rect *_Nonnull r,
+    const AG_Color *_Nonnull c)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	FillRect32(hl->S, r, (Uint32)AG_MapPixel(&hl->S->format, c));
+}
+
+static void
+HEADLESS_UpdateTexture(void *_Nonnull obj, Uint texture, AG_Surface *_Nonnull S,
+    AG_TexCoord *_Nullable tc)
+{
+	/* No-op */
+}
+
+static void
+HEADLESS_DeleteTexture(void *_Nonnull obj, Uint texture)
+{
+	/* No-op */
+}
+
+static int
+HEADLESS_SetRefreshRate(void *_Nonnull obj, int fps)
+{
+	AG_DriverSw *dsw = obj;
+
+	if (fps < 1) {
+		AG_SetError("Invalid refresh rate");
+		return (-1);
+	}
+	dsw->rNom = 1000/fps;
+	return (0);
+}
+
+/*
+ * Clipping and blending control (rendering context)
+ */
+
+static void
+HEADLESS_PushClipRect(void *_Nonnull obj, const AG_Rect *_Nonnull r)
+{
+	AG_DriverHEADLESS *hl = obj;
+	AG_ClipRect *cr, *crPrev;
+
+	hl->clipRects = Realloc(hl->clipRects, (hl->nClipRects+1) *
+	                                       sizeof(AG_ClipRect));
+	crPrev = &hl->clipRects[hl->nClipRects-1];
+	cr = &hl->clipRects[hl->nClipRects++];
+
+	AG_RectIntersect(&cr->r, &crPrev->r, r);
+	hl->S->clipRect = cr->r;
+}
+
+static void
+HEADLESS_PopClipRect(void *_Nonnull obj)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+#ifdef AG_DEBUG
+	if (hl->nClipRects <= 1)
+		AG_FatalError("PopClipRect() without PushClipRect()");
+#endif
+	hl->S->clipRect = hl->clipRects[--hl->nClipRects - 1].r;
+}
+
+static void
+HEADLESS_PushBlendingMode(void *_Nonnull obj, AG_AlphaFn fnSrc,
+    AG_AlphaFn fnDst)
+{
+	/* No-op (handle blending on a per-blit basis) */
+}
+
+static void
+HEADLESS_PopBlendingMode(void *_Nonnull obj)
+{
+	/* No-op (handle blending on a per-blit basis) */
+}
+
+/*
+ * Cursor operations. There is no pointer to display, but the stock
+ * cursors must exist for AG_MouseCursorUpdate().
+ */
+
+static AG_Cursor *
+HEADLESS_CreateCursor(void *_Nonnull obj, Uint w, Uint h,
+    const Uint8 *_Nonnull data, const Uint8 *_Nonnull mask, int xHot, int yHot)
+{
+	AG_Cursor *ac;
+	const Uint size = w*h;
+
+	if ((ac = TryMalloc(sizeof(AG_Cursor))) == NULL) {
+		return (NULL);
+	}
+	AG_CursorInit(ac);
+	if ((ac->data = TryMalloc(size)) == NULL) {
+		free(ac);
+		return (NULL);
+	}
+	if ((ac->mask = TryMalloc(size)) == NULL) {
+		free(ac->data);
+		free(ac);
+		return (NULL);
+	}
+	memcpy(ac->data, data, size);
+	memcpy(ac->mask, mask, size);
+	ac->w = w;
+	ac->h = h;
+	ac->xHot = xHot;
+	ac->yHot = yHot;
+	return (ac);
+}
+
+static void
+HEADLESS_FreeCursor(void *_Nonnull obj, AG_Cursor *_Nonnull ac)
+{
+	AG_Driver *drv = obj;
+
+	if (ac == drv->activeCursor) {
+		drv->activeCursor = NULL;
+	}
+	Free(ac->data);
+	Free(ac->mask);
+	free(ac);
+}
+
+static int
+HEADLESS_SetCursor(void *_Nonnull obj, AG_Cursor *_Nonnull ac)
+{
+	AGDRIVER(obj)->activeCursor = ac;
+	return (0);
+}
+
+static void
+HEADLESS_UnsetCursor(void *_Nonnull obj)
+{
+	AG_Driver *drv = obj;
+
+	drv->activeCursor = TAILQ_FIRST(&drv->cursors);
+}
+
+static int
+HEADLESS_GetCursorVisibility(void *_Nonnull obj)
+{
+	return (0);
+}
+
+static void
+HEADLESS_SetCursorVisibility(void *_Nonnull obj, int flag)
+{
+	/* No-op */
+}
+
+static void
+InitDefaultCursor(AG_Driver *_Nonnull drv)
+{
+	AG_Cursor *ac;
+
+	ac = Malloc(sizeof(AG_Cursor));
+	AG_CursorInit(ac);
+	TAILQ_INSERT_HEAD(&drv->cursors, ac, cursors);
+	drv->nCursors++;
+	drv->activeCursor = ac;
+}
+
+/*
+ * Surface operations (rendering context)
+ */
+
+static void
+HEADLESS_BlitSurface(void *_Nonnull obj, AG_Widget *_Nonnull wid,
+    AG_Surface *_Nonnull S, int x, int y)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	AG_SurfaceBlit(S, NULL, hl->S, x,y);
+}
+
+static void
+HEADLESS_BlitSurfaceFrom(void *_Nonnull obj, AG_Widget *_Nonnull wid,
+    int s, const AG_Rect *_Nullable rSrc, int x, int y)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	AG_SurfaceBlit(wid->surfaces[s], rSrc, hl->S, x,y);
+}
+
+#ifdef HAVE_OPENGL
+static void
+HEADLESS_BlitSurfaceGL(void *_Nonnull obj, AG_Widget *_Nonnull wid,
+    AG_Surface *_Nonnull S, float w, float h)
+{
+	/* Not applicable */
+}
+
+static void
+HEADLESS_BlitSurfaceFromGL(void *_Nonnull obj, AG_Widget *_Nonnull wid,
+    int s, float w, float h)
+{
+	/* Not applicable */
+}
+
+static void
+HEADLESS_BlitSurfaceFlippedGL(void *_Nonnull obj, AG_Widget *_Nonnull wid,
+    int s, float w, float h)
+{
+	/* Not applicable */
+}
+#endif /* HAVE_OPENGL */
+
+static int
+HEADLESS_RenderToSurface(void *_Nonnull obj, AG_Widget *_Nonnull wid,
+    AG_Surface *_Nonnull *_Nullable pS)
+{
+	AG_DriverHEADLESS *hl = obj;
+	AG_Surface *S;
+	AG_Rect r;
+	int visiblePrev;
+
+	AG_BeginRendering(hl);
+	visiblePrev = wid->window->visible;
+	wid->window->visible = 1;
+	AG_WindowDraw(wid->window);
+	wid->window->visible = visiblePrev;
+	AG_EndRendering(hl);
+
+	if ((S = AG_SurfaceNew(&hl->S->format, wid->w, wid->h, 0)) == NULL) {
+		return (-1);
+	}
+	r.x = wid->rView.x1;
+	r.y = wid->rView.y1;
+	r.w = wid->w;
+	r.h = wid->h;
+	AG_SurfaceBlit(hl->S, &r, S, 0,0);
+	*pS = S;
+	return (0);
+}
+
+/*
+ * Rendering operations (rendering context)
+ */
+
+/* Clipping test against the active clipping rectangle. */
+static __inline__ int
+ClippedPixel(const AG_Surface *_Nonnull S, int x, int y)
+{
+	return (x <  S->clipRect.x || x >= S->clipRect.x + S->clipRect.w ||
+	        y <  S->clipRect.y || y >= S->clipRect.y + S->clipRect.h);
+}
+
+static void
+HEADLESS_PutPixel32(void *_Nonnull obj, int x, int y, Uint32 px)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	if (ClippedPixel(hl->S, x,y)) {
+		return;
+	}
+	*HL_PIXEL(hl->S, x,y) = px;
+}
+
+static void
+HEADLESS_PutPixel(void *_Nonnull obj, int x, int y, const AG_Color *_Nonnull c)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	HEADLESS_PutPixel32(obj, x,y, (Uint32)AG_MapPixel(&hl->S->format, c));
+}
+
+static void
+HEADLESS_PutPixelRGB8(void *_Nonnull obj, int x, int y,
+    Uint8 r, Uint8 g, Uint8 b)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	HEADLESS_PutPixel32(obj, x,y, (Uint32)AG_MapPixel_RGB8(&hl->S->format, r,g,b));
+}
+
+#if AG_MODEL == AG_LARGE
+static void
+HEADLESS_PutPixel64(void *_Nonnull obj, int x, int y, Uint64 px)
+{
+	AG_Driver *drv = obj;
+	AG_DriverHEADLESS *hl = obj;
+	Uint16 r,g,b;
+
+	AG_GetColor64_RGB16(px, drv->videoFmt, &r,&g,&b);
+	HEADLESS_PutPixel32(obj, x,y,
+	    (Uint32)AG_MapPixel_RGB16(&hl->S->format, r,g,b));
+}
+
+static void
+HEADLESS_PutPixelRGB16(void *_Nonnull obj, int x, int y,
+    Uint16 r, Uint16 g, Uint16 b)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	HEADLESS_PutPixel32(obj, x,y,
+	    (Uint32)AG_MapPixel_RGB16(&hl->S->format, r,g,b));
+}
+#endif /* AG_LARGE */
+
+static void
+HEADLESS_BlendPixel(void *_Nonnull obj, int x, int y,
+    const AG_Color *_Nonnull c, AG_AlphaFn fnSrc, AG_AlphaFn fnDst)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	if (ClippedPixel(hl->S, x,y)) {
+		return;
+	}
+	AG_SurfaceBlend_At(hl->S, (Uint8 *)HL_PIXEL(hl->S, x,y), c, fnSrc);
+}
+
+/*
+ * Bresenham line from x1,y1 to x2,y2. Pixel n along the line is only
+ * drawn if bit (n % 16) of the stipple mask is set.
+ */
+static void
+DrawLine32(void *_Nonnull obj, int x1, int y1, int x2, int y2, Uint32 c,
+    Uint16 mask)
+{
+	int dx = abs(x2 - x1), sx = (x1 < x2) ? 1 : -1;
+	int dy = -abs(y2 - y1), sy = (y1 < y2) ? 1 : -1;
+	int err = dx + dy, e2;
+	Uint n;
+
+	for (n = 0; ; n++) {
+		if (mask & (1 << (n & 15))) {
+			HEADLESS_PutPixel32(obj, x1,y1, c);
+		}
+		if (x1 == x2 && y1 == y2) {
+			break;
+		}
+		e2 = err << 1;
+		if (e2 >= dy) { err += dy; x1 += sx; }
+		if (e2 <= dx) { err += dx; y1 += sy; }
+	}
+}
+
+static void
+HEADLESS_DrawLine(void *_Nonnull obj, int x1, int y1, int x2, int y2,
+    const AG_Color *_Nonnull c)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	DrawLine32(obj, x1,y1, x2,y2, (Uint32)AG_MapPixel(&hl->S->format, c), 0xffff);
+}
+
+static void
+HEADLESS_DrawLineH(void *_Nonnull obj, int x1, int x2, int y,
+    const AG_Color *_Nonnull c)
+{
+	AG_DriverHEADLESS *hl = obj;
+	AG_Rect r;
+
+	if (x1 > x2) {
+		r.x = x2;
+		r.w = x1 - x2 + 1;
+	} else {
+		r.x = x1;
+		r.w = x2 - x1 + 1;
+	}
+	r.y = y;
+	r.h = 1;
+	FillRect32(hl->S, &r, (Uint32)AG_MapPixel(&hl->S->format, c));
+}
+
+static void
+HEADLESS_DrawLineV(void *_Nonnull obj, int x, int y1, int y2,
+    const AG_Color *_Nonnull c)
+{
+	AG_DriverHEADLESS *hl = obj;
+	AG_Rect r;
+
+	if (y1 > y2) {
+		r.y = y2;
+		r.h = y1 - y2 + 1;
+	} else {
+		r.y = y1;
+		r.h = y2 - y1 + 1;
+	}
+	r.x = x;
+	r.w = 1;
+	FillRect32(hl->S, &r, (Uint32)AG_MapPixel(&hl->S->format, c));
+}
+
+static void
+HEADLESS_DrawLineBlended(void *_Nonnull obj, int x1, int y1, int x2, int y2,
+    const AG_Color *_Nonnull c, AG_AlphaFn fnSrc, AG_AlphaFn fnDst)
+{
+	int dx = abs(x2 - x1), sx = (x1 < x2) ? 1 : -1;
+	int dy = -abs(y2 - y1), sy = (y1 < y2) ? 1 : -1;
+	int err = dx + dy, e2;
+
+	for (;;) {
+		HEADLESS_BlendPixel(obj, x1,y1, c, fnSrc, fnDst);
+		if (x1 == x2 && y1 == y2) {
+			break;
+		}
+		e2 = err << 1;
+		if (e2 >= dy) { err += dy; x1 += sx; }
+		if (e2 <= dx) { err += dx; y1 += sy; }
+	}
+}
+
+/*
+ * Approximate a wide line by parallel lines offset along the minor axis.
+ */
+static void
+DrawLineWide32(void *_Nonnull obj, int x1, int y1, int x2, int y2, Uint32 c,
+    float width, Uint16 mask)
+{
+	const int w = (int)(width + 0.5f);
+	int i;
+
+	if (w <= 1) {
+		DrawLine32(obj, x1,y1, x2,y2, c, mask);
+		return;
+	}
+	if (abs(x2 - x1) >= abs(y2 - y1)) {
+		for (i = -((w - 1) >> 1); i <= (w >> 1); i++)
+			DrawLine32(obj, x1, y1+i, x2, y2+i, c, mask);
+	} else {
+		for (i = -((w - 1) >> 1); i <= (w >> 1); i++)
+			DrawLine32(obj, x1+i, y1, x2+i, y2, c, mask);
+	}
+}
+
+static void
+HEADLESS_DrawLineW(void *_Nonnull obj, int x1, int y1, int x2, int y2,
+    const AG_Color *_Nonnull c, float width)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	DrawLineWide32(obj, x1,y1, x2,y2, (Uint32)AG_MapPixel(&hl->S->format, c),
+	    width, 0xffff);
+}
+
+static void
+HEADLESS_DrawLineW_Sti16(void *_Nonnull obj, int x1, int y1, int x2, int y2,
+    const AG_Color *_Nonnull c, float width, Uint16 mask)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	DrawLineWide32(obj, x1,y1, x2,y2, (Uint32)AG_MapPixel(&hl->S->format, c),
+	    width, mask);
+}
+
+/*
+ * Fill a polygon using scanline intersections. If a 32x32 stipple
+ * pattern is given, only draw the pixels whose bit is set.
+ */
+static void
+DrawPolygon32(AG_DriverHEADLESS *_Nonnull hl, const AG_Pt *_Nonnull pts,
+    Uint nPts, Uint32 c, const Uint8 *_Nullable stipple)
+{
+	int y, x1, y1, x2, y2;
+	int miny, maxy;
+	int i, i1, i2;
+	Uint nPolyInts;
+
+	if (nPts < 3) {
+		return;
+	}
+	if (nPts > hl->nPolyInts) {
+		hl->polyInts = Realloc(hl->polyInts, nPts*sizeof(int));
+		hl->nPolyInts = nPts;
+	}
+
+	miny = maxy = pts[0].y;
+	for (i = 1; i < nPts; i++) {
+		if (pts[i].y < miny) {
+			miny = pts[i].y;
+		} else if (pts[i].y > maxy) {
+			maxy = pts[i].y;
+		}
+	}
+	miny = MAX(miny, hl->S->clipRect.y);
+	maxy = MIN(maxy, hl->S->clipRect.y + hl->S->clipRect.h - 1);
+
+	for (y = miny; y <= maxy; y++) {
+		nPolyInts = 0;
+		for (i = 0; i < nPts; i++) {
+			if (i == 0) {
+				i1 = nPts - 1;
+				i2 = 0;
+			} else {
+				i1 = i - 1;
+				i2 = i;
+			}
+			y1 = pts[i1].y;
+			y2 = pts[i2].y;
+			if (y1 < y2) {
+				x1 = pts[i1].x;
+				x2 = pts[i2].x;
+			} else if (y1 > y2) {
+				x2 = pts[i1].x;
+				y2 = pts[i1].y;
+				x1 = pts[i2].x;
+				y1 = pts[i2].y;
+			} else {
+				continue;
+			}
+			if (((y >= y1) && (y < y2)) ||
+			    ((y == maxy) && (y > y1) && (y <= y2))) {
+				hl->polyInts[nPolyInts++] =
+				    (((y - y1) << 16) / (y2 - y1)) *
+				     (x2 - x1) + (x1 << 16);
+			}
+		}
+		qsort(hl->polyInts, nPolyInts, sizeof(int), CompareInts);
+
+		for (i = 0; i+1 < nPolyInts; i += 2) {
+			int xa, xb, x;
+
+			xa = hl->polyInts[i] + 1;
+			xa = (xa >> 16) + ((xa & 0x8000) >> 15);
+			xb = hl->polyInts[i+1] - 1;
+			xb = (xb >> 16) + ((xb & 0x8000) >> 15);
+			if (stipple == NULL) {
+				AG_Rect r;
+
+				r.x = xa;
+				r.y = y;
+				r.w = xb - xa + 1;
+				r.h = 1;
+				FillRect32(hl->S, &r, c);
+				continue;
+			}
+			for (x = xa; x <= xb; x++) {
+				const Uint8 bits = stipple[((y & 31) << 2) +
+				                           ((x & 31) >> 3)];
+
+				if (bits & (0x80 >> (x & 7)))
+					HEADLESS_PutPixel32(hl, x,y, c);
+			}
+		}
+	}
+}
+
+static int
+CompareInts(const void *_Nonnull p1, const void *_Nonnull p2)
+{
+	return (*(const int *)p1 - *(const int *)p2);
+}
+
+static void
+HEADLESS_DrawTriangle(void *_Nonnull obj, const AG_Pt *_Nonnull v1,
+    const AG_Pt *_Nonnull v2, const AG_Pt *_Nonnull v3,
+    const AG_Color *_Nonnull c)
+{
+	AG_DriverHEADLESS *hl = obj;
+	AG_Pt pts[3];
+
+	pts[0] = *v1;
+	pts[1] = *v2;
+	pts[2] = *v3;
+	DrawPolygon32(hl, pts, 3, (Uint32)AG_MapPixel(&hl->S->format, c), NULL);
+}
+
+static void
+HEADLESS_DrawPolygon(void *_Nonnull obj, const AG_Pt *_Nonnull pts, Uint nPts,
+    const AG_Color *_Nonnull c)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	DrawPolygon32(hl, pts, nPts, (Uint32)AG_MapPixel(&hl->S->format, c), NULL);
+}
+
+static void
+HEADLESS_DrawPolygon_Sti32(void *_Nonnull obj, const AG_Pt *_Nonnull pts,
+    Uint nPts, const AG_Color *_Nonnull c, const Uint8 *_Nonnull stipple)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	DrawPolygon32(hl, pts, nPts, (Uint32)AG_MapPixel(&hl->S->format, c), stipple);
+}
+
+static void
+HEADLESS_DrawArrow(void *_Nonnull obj, Uint8 angle, int x0, int y0, int h,
+    const AG_Color *_Nonnull c)
+{
+	AG_DriverHEADLESS *hl = obj;
+	const Uint32 px = (Uint32)AG_MapPixel(&hl->S->format, c);
+	const int x1 = x0 - (h >> 1) + 1, x2 = x1 + h-2;
+	const int y1 = y0 - (h >> 1) + 1, y2 = y1 + h-2;
+	int x, y, s = 0;
+
+#ifdef AG_DEBUG
+	if (angle >= 4) { AG_FatalError("Bad angle"); }
+#endif
+	switch (angle) {
+	case 0:						/* Up */
+		for (y = y1; y < y2; y++, s++)
+			for (x = x0-s; x <= x0+s; x++)
+				HEADLESS_PutPixel32(obj, x,y, px);
+		break;
+	case 1:						/* Right */
+		for (x = x2; x > x1; x--, s++)
+			for (y = y0-s; y <= y0+s; y++)
+				HEADLESS_PutPixel32(obj, x,y, px);
+		break;
+	case 2:						/* Down */
+		for (y = y2; y > y1; y--, s++)
+			for (x = x0-s; x <= x0+s; x++)
+				HEADLESS_PutPixel32(obj, x,y, px);
+		break;
+	case 3:						/* Left */
+		for (x = x1; x < x2; x++, s++)
+			for (y = y0-s; y <= y0+s; y++)
+				HEADLESS_PutPixel32(obj, x,y, px);
+		break;
+	}
+}
+
+static void
+HEADLESS_DrawBoxRoundedTop(void *_Nonnull obj, const AG_Rect *_Nonnull r,
+    int z, int rad, const AG_Color *_Nonnull c1, const AG_Color *_Nonnull c2,
+    const AG_Color *_Nonnull c3)
+{
+	AG_DriverHEADLESS *hl = obj;
+	const AG_PixelFormat *pf = &hl->S->format;
+	AG_Rect rd;
+	int rx = r->x;
+	int ry = r->y;
+	int rw = r->w;
+	int rh = r->h;
+	int x2 = rx + rad;
+	int x3 = rx - rad + rw - 1;
+	int y2 = ry + rad;
+	int v, e, u;
+	int x, y, i;
+	Uint32 c[3];
+
+	c[0] = (Uint32)AG_MapPixel(pf, c1);
+	c[1] = (Uint32)AG_MapPixel(pf, c2);
+	c[2] = (Uint32)AG_MapPixel(pf, c3);
+
+	rd.x = x2;					/* Center rect */
+	rd.y = ry;
+	rd.w = rw - (rad << 1);
+	rd.h = rh;
+	FillRect32(hl->S, &rd, c[0]);
+	rd.x = rx;					/* Left rect */
+	rd.y = y2;
+	rd.w = rad;
+	rd.h = rh - rad;
+	FillRect32(hl->S, &rd, c[0]);
+	rd.x = rx + rw - rad;				/* Right rect */
+	FillRect32(hl->S, &rd, c[0]);
+
+	/* Left and right lines */
+	HEADLESS_DrawLineV(obj, rx,      y2, ry+rh, c2);
+	HEADLESS_DrawLineV(obj, rx+rw-1, y2, ry+rh, c3);
+
+	/* Top left and top right rounded edges */
+	v = (rad << 1) - 1;
+	e = 0;
+	u = 0;
+	x = 0;
+	y = rad;
+	while (x <= y) {
+		HEADLESS_PutPixel32(obj, x2-x, y2-y, c[1]);
+		HEADLESS_PutPixel32(obj, x2-y, y2-x, c[1]);
+		HEADLESS_PutPixel32(obj, x3+x, y2-y, c[2]);
+		HEADLESS_PutPixel32(obj, x3+y, y2-x, c[2]);
+		for (i = 0; i < x; i++) {
+			HEADLESS_PutPixel32(obj, x2-i, y2-y, c[0]);
+			HEADLESS_PutPixel32(obj, x3+i, y2-y, c[0]);
+		}
+		for (i = 0; i < y; i++) {
+			HEADLESS_PutPixel32(obj, x2-i, y2-x, c[0]);
+			HEADLESS_PutPixel32(obj, x3+i, y2-x, c[0]);
+		}
+		e += u;
+		u += 2;
+		if (v < (e << 1)) {
+			y--;
+			e -= v;
+			v -= 2;
+		}
+		x++;
+	}
+}
+
+static void
+HEADLESS_DrawBoxRounded(void *_Nonnull obj, const AG_Rect *_Nonnull r, int z,
+    int rad, const AG_Color *_Nonnull c1, const AG_Color *_Nonnull c2,
+    const AG_Color *_Nonnull c3)
+{
+	AG_DriverHEADLESS *hl = obj;
+	const AG_PixelFormat *pf = &hl->S->format;
+	AG_Rect rd;
+	Uint32 c[3];
+	int v, e, u;
+	int x, y, i;
+	int rx = r->x, ry = r->y;
+	int rw = r->w, rh = r->h;
+	int w1 = rw - 1;
+	int x2, y2, x3, y3, rad2, rad_2;
+
+	if (rw < 4 || rh < 4) {
+		return;
+	}
+	if ((rad << 1) > rw || (rad << 1) > rh) {
+		rad = MIN(rw >> 1, rh >> 1);
+	}
+	x2 = rx + rad;
+	y2 = ry + rad;
+	x3 = rx - rad + w1;
+	y3 = ry + rh - rad;
+	rad2 = (rad << 1);
+	rad_2 = (rad >> 1);
+
+	c[0] = (Uint32)AG_MapPixel(pf, c1);
+	c[1] = (Uint32)AG_MapPixel(pf, c2);
+	c[2] = (Uint32)AG_MapPixel(pf, c3);
+
+	rd.x = x2;					/* Center, top and bottom */
+	rd.y = ry;
+	rd.w = rw - rad2;
+	rd.h = rh;
+	FillRect32(hl->S, &rd, c[0]);
+	rd.x = rx;					/* Left */
+	rd.y = y2;
+	rd.w = rad;
+	rd.h = rh - rad2;
+	FillRect32(hl->S, &rd, c[0]);
+	rd.x = rx + rw - rad;				/* Right */
+	FillRect32(hl->S, &rd, c[0]);
+
+	/* Rounded edges */
+	v = (rad << 1) - 1;
+	e = 0;
+	u = 0;
+	x = 0;
+	y = rad;
+	while (x <= y) {
+		HEADLESS_PutPixel32(obj, x2-x, y2-y, c[1]);
+		HEADLESS_PutPixel32(obj, x2-y, y2-x, c[1]);
+		HEADLESS_PutPixel32(obj, x3+x, y2-y, c[2]);
+		HEADLESS_PutPixel32(obj, x3+y, y2-x, c[2]);
+
+		HEADLESS_PutPixel32(obj, x2-x, y3+y, c[1]);
+		HEADLESS_PutPixel32(obj, x2-y, y3+x, c[1]);
+		HEADLESS_PutPixel32(obj, x3+x, y3+y, c[2]);
+		HEADLESS_PutPixel32(obj, x3+y, y3+x, c[2]);
+
+		for (i = 0; i < x; i++) {
+			HEADLESS_PutPixel32(obj, x2-i, y2-y, c[0]);
+			HEADLESS_PutPixel32(obj, x3+i, y2-y, c[0]);
+			HEADLESS_PutPixel32(obj, x2-i, y3+y, c[0]);
+			HEADLESS_PutPixel32(obj, x3+i, y3+y, c[0]);
+		}
+		for (i = 0; i < y; i++) {
+			HEADLESS_PutPixel32(obj, x2-i, y2-x, c[0]);
+			HEADLESS_PutPixel32(obj, x3+i, y2-x, c[0]);
+			HEADLESS_PutPixel32(obj, x2-i, y3+x, c[0]);
+			HEADLESS_PutPixel32(obj, x3+i, y3+x, c[0]);
+		}
+		e += u;
+		u += 2;
+		if (v < (e << 1)) {
+			y--;
+			e -= v;
+			v -= 2;
+		}
+		x++;
+	}
+
+	/* Contour lines */
+	HEADLESS_DrawLineH(obj, rx+rad_2, rx+rw-rad_2, ry,      c2);
+	HEADLESS_DrawLineH(obj, rx+rad_2, rx+rw-rad_2, ry+rh-1, c3);
+	HEADLESS_DrawLineV(obj, rx,       y2,          y3,      c2);
+	HEADLESS_DrawLineV(obj, rx+w1,    y2,          y3,      c3);
+}
+
+static void
+HEADLESS_DrawCircle(void *_Nonnull obj, int x1, int y1, int radius,
+    const AG_Color *_Nonnull C)
+{
+	AG_DriverHEADLESS *hl = obj;
+	const Uint32 c = (Uint32)AG_MapPixel(&hl->S->format, C);
+	int v = (radius << 1) - 1;
+	int e = 0, u = 1;
+	int x = 0, y = radius;
+
+	while (x < y) {
+		HEADLESS_PutPixel32(obj, x1+x, y1+y, c);
+		HEADLESS_PutPixel32(obj, x1+x, y1-y, c);
+		HEADLESS_PutPixel32(obj, x1-x, y1+y, c);
+		HEADLESS_PutPixel32(obj, x1-x, y1-y, c);
+		e += u;
+		u += 2;
+		if (v < (e << 1)) {
+			y--;
+			e -= v;
+			v -= 2;
+		}
+		x++;
+		HEADLESS_PutPixel32(obj, x1+y, y1+x, c);
+		HEADLESS_PutPixel32(obj, x1+y, y1-x, c);
+		HEADLESS_PutPixel32(obj, x1-y, y1+x, c);
+		HEADLESS_PutPixel32(obj, x1-y, y1-x, c);
+	}
+	HEADLESS_PutPixel32(obj, x1-radius, y1, c);
+	HEADLESS_PutPixel32(obj, x1+radius, y1, c);
+}
+
+static void
+HEADLESS_DrawCircleFilled(void *_Nonnull obj, int x1, int y1, int radius,
+    const AG_Color *_Nonnull c)
+{
+	int v = (radius << 1) - 1;
+	int e = 0, u = 1;
+	int x = 0, y = radius;
+
+	while (x < y) {
+		HEADLESS_DrawLineV(obj, x1+x, y1+y, y1-y, c);
+		HEADLESS_DrawLineV(obj, x1-x, y1+y, y1-y, c);
+		e += u;
+		u += 2;
+		if (v < (e << 1)) {
+			y--;
+			e -= v;
+			v -= 2;
+		}
+		x++;
+		HEADLESS_DrawLineV(obj, x1+y, y1+x, y1-x, c);
+		HEADLESS_DrawLineV(obj, x1-y, y1+x, y1-x, c);
+	}
+}
+
+static void
+HEADLESS_DrawRectFilled(void *_Nonnull obj, const AG_Rect *_Nonnull r,
+    const AG_Color *_Nonnull c)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	FillRect32(hl->S, r, (Uint32)AG_MapPixel(&hl->S->format, c));
+}
+
+static void
+HEADLESS_DrawRectBlended(void *_Nonnull obj, const AG_Rect *_Nonnull r,
+    const AG_Color *_Nonnull c, AG_AlphaFn fnSrc, AG_AlphaFn fnDst)
+{
+	AG_DriverHEADLESS *hl = obj;
+	AG_Surface *S = hl->S;
+	const AG_Rect *rc = &S->clipRect;
+	int x1 = MAX(r->x, rc->x);
+	int y1 = MAX(r->y, rc->y);
+	int x2 = MIN(r->x + r->w, rc->x + rc->w);
+	int y2 = MIN(r->y + r->h, rc->y + rc->h);
+	int x, y;
+
+	for (y = y1; y < y2; y++) {
+		Uint8 *p = (Uint8 *)HL_PIXEL(S, x1, y);
+
+		for (x = x1; x < x2; x++, p += 4)
+			AG_SurfaceBlend_At(S, p, c, fnSrc);
+	}
+}
+
+static void
+HEADLESS_DrawRectDithered(void *_Nonnull obj, const AG_Rect *_Nonnull r,
+    const AG_Color *_Nonnull C)
+{
+	AG_DriverHEADLESS *hl = obj;
+	const Uint32 c = (Uint32)AG_MapPixel(&hl->S->format, C);
+	int x2 = r->x + r->w - 2;
+	int y2 = r->y + r->h - 2;
+	int x, y, flag = 0;
+
+	for (y = r->y; y < y2; y++) {
+		flag = !flag;
+		for (x = r->x+1+flag; x < x2; x += 2)
+			HEADLESS_PutPixel32(obj, x,y, c);
+	}
+}
+
+static void
+HEADLESS_UpdateGlyph(void *_Nonnull obj, AG_Glyph *_Nonnull G)
+{
+	/* Nothing to do */
+}
+
+/*
+ * Render an AG_Text(3) glyph at x,y. Fill the background (if any) and
+ * blend the FG color according to the glyph's coverage mask.
+ */
+static void
+HEADLESS_DrawGlyph(void *_Nonnull obj, const AG_Glyph *_Nonnull G, int x, int y)
+{
+	AG_DriverHEADLESS *hl = obj;
+	AG_Surface *D = hl->S;
+	const AG_Surface *S = G->su;
+	const AG_Rect *rc = &D->clipRect;
+	const AG_Component aFg = G->color.a;
+	const Uint32 pxFg = (Uint32)AG_MapPixel(&D->format, &G->color);
+	AG_Color c = G->color;
+	int sx1, sy1, sx2, sy2, sx, sy;
+
+	if (G->colorBG.a > AG_TRANSPARENT) {
+		AG_Rect r;
+
+		r.x = x;
+		r.y = y;
+		r.w = S->w;
+		r.h = S->h;
+		if (G->colorBG.a == AG_OPAQUE) {
+			HEADLESS_DrawRectFilled(obj, &r, &G->colorBG);
+		} else {
+			HEADLESS_DrawRectBlended(obj, &r, &G->colorBG,
+			    AG_ALPHA_SRC, AG_ALPHA_ONE_MINUS_SRC);
+		}
+	}
+	if (G->flags & AG_GLYPH_COLORED) {
+		AG_SurfaceBlit(S, NULL, D, x,y);
+		return;
+	}
+	sx1 = MAX(0, rc->x - x);
+	sy1 = MAX(0, rc->y - y);
+	sx2 = MIN((int)S->w, rc->x + rc->w - x);
+	sy2 = MIN((int)S->h, rc->y + rc->h - y);
+
+	for (sy = sy1; sy < sy2; sy++) {
+		const Uint8 *pSrc = S->pixels + sy*S->pitch +
+		                    sx1*S->format.BytesPerPixel;
+		Uint8 *pDst = (Uint8 *)HL_PIXEL(D, x+sx1, y+sy);
+
+		for (sx = sx1; sx < sx2; sx++) {
+			AG_Color cMask;
+
+			AG_GetColor(&cMask, AG_SurfaceGet_At(S,pSrc), &S->format);
+			pSrc += S->format.BytesPerPixel;
+			if (cMask.a != AG_TRANSPARENT) {
+				c.a = AG_GlyphAlpha(cMask.a, aFg);
+				if (c.a == AG_OPAQUE) {
+					*(Uint32 *)pDst = pxFg;
+				} else {
+					AG_SurfaceBlend_At(D, pDst, &c,
+					    AG_ALPHA_SRC);
+				}
+			}
+			pDst += 4;
+		}
+	}
+}
+
+/*
+ * Single-display specific operations.
+ */
+
+/* Initialize the clipping rectangle stack. */
+static int
+InitClipRects(AG_DriverHEADLESS *_Nonnull hl, int wView, int hView)
+{
+	AG_ClipRect *cr;
+
+	/* Rectangle 0 always covers the whole view. */
+	if (hl->clipRects == NULL &&
+	    (hl->clipRects = TryMalloc(sizeof(AG_ClipRect))) == NULL) {
+		return (-1);
+	}
+	cr = &hl->clipRects[0];
+	cr->r.x = 0;
+	cr->r.y = 0;
+	cr->r.w = wView;
+	cr->r.h = hView;
+	hl->nClipRects = 1;
+	hl->S->clipRect = cr->r;
+	return (0);
+}
+
+/* Check that an application-supplied surface can be rendered to. */
+static int
+ValidSurface(const AG_Surface *_Nonnull S)
+{
+	if (S->format.mode != AG_SURFACE_PACKED ||
+	    S->format.BytesPerPixel != 4) {
+		AG_SetErrorS("Display surface must be 32-bit packed");
+		return (0);
+	}
+	return (1);
+}
+
+/* Set the driver video format from the framebuffer surface. */
+static int
+SetVideoFormat(AG_DriverHEADLESS *_Nonnull hl)
+{
+	AG_Driver *drv = AGDRIVER(hl);
+	AG_DriverSw *dsw = AGDRIVER_SW(hl);
+
+	if (drv->videoFmt != NULL) {
+		AG_PixelFormatFree(drv->videoFmt);
+		free(drv->videoFmt);
+	}
+	if ((drv->videoFmt = AG_PixelFormatDup(&hl->S->format)) == NULL) {
+		return (-1);
+	}
+	dsw->w = hl->S->w;
+	dsw->h = hl->S->h;
+	dsw->depth = (Uint)hl->S->format.BitsPerPixel;
+	return (0);
+}
+
+/* Read a "width" or "height" option, or return the default. */
+static Uint
+GetDimensionOption(AG_Driver *_Nonnull drv, const char *_Nonnull key, Uint def)
+{
+	char buf[16];
+	long v;
+
+	if (!AG_Defined(drv, key)) {
+		return (def);
+	}
+	AG_GetString(drv, key, buf, sizeof(buf));
+	v = strtol(buf, NULL, 10);
+	return (v >= 16 && v <= 16384) ? (Uint)v : def;
+}
+
+static int
+HEADLESS_OpenVideo(void *_Nonnull obj, Uint w, Uint h, int depth, Uint flags)
+{
+	AG_Driver *drv = obj;
+	AG_DriverSw *dsw = obj;
+	AG_DriverHEADLESS *hl = obj;
+	AG_PixelFormat pf;
+
+	if (flags & AG_VIDEO_OVERLAY)
+		dsw->flags |= AG_DRIVER_SW_OVERLAY;
+	if (flags & AG_VIDEO_BGPOPUPMENU)
+		dsw->flags |= AG_DRIVER_SW_BGPOPUP;
+
+	if (w == 0) { w = GetDimensionOption(drv, "width", HEADLESS_WIDTH_DEFAULT); }
+	if (h == 0) { h = GetDimensionOption(drv, "height", HEADLESS_HEIGHT_DEFAULT); }
+	if (depth != 0 && depth != 32)
+		Verbose(_("HEADLESS: Ignoring depth %d (using 32 bpp)\n"), depth);
+
+	/* The framebuffer is always 32-bit packed RGB. */
+#if AG_BYTEORDER == AG_BIG_ENDIAN
+	AG_PixelFormatRGB(&pf, 32, 0xff000000, 0x00ff0000, 0x0000ff00);
+#else
+	AG_PixelFormatRGB(&pf, 32, 0x000000ff, 0x0000ff00, 0x00ff0000);
+#endif
+	if ((hl->S = AG_SurfaceNew(&pf, w,h, 0)) == NULL) {
+		return (-1);
+	}
+	hl->flags &= ~(HEADLESS_EXT_SURFACE);
+	Verbose(_("HEADLESS: New display (%ux%u, 32 bpp)\n"), w, h);
+
+	if (SetVideoFormat(hl) == -1 ||
+	    InitClipRects(hl, w, h) == -1)
+		goto fail;
+
+	InitDefaultCursor(drv);
+	AG_InitStockCursors(drv);
+
+	FillRect32(hl->S, &hl->clipRects[0].r,
+	    (Uint32)AG_MapPixel(&hl->S->format, &dsw->bgColor));
+	return (0);
+fail:
+	AG_SurfaceFree(hl->S);
+	hl->S = NULL;
+	return (-1);
+}
+
+/* Render to an existing 32-bit AG_Surface(3) owned by the caller. */
+static int
+HEADLESS_OpenVideoContext(void *_Nonnull obj, void *_Nonnull ctx, Uint flags)
+{
+	AG_Driver *drv = obj;
+	AG_DriverSw *dsw = obj;
+	AG_DriverHEADLESS *hl = obj;
+	AG_Surface *S = ctx;
+
+	if (!ValidSurface(S)) {
+		return (-1);
+	}
+	if (flags & AG_VIDEO_OVERLAY)
+		dsw->flags |= AG_DRIVER_SW_OVERLAY;
+	if (flags & AG_VIDEO_BGPOPUPMENU)
+		dsw->flags |= AG_DRIVER_SW_BGPOPUP;
+
+	hl->S = S;
+	hl->flags |= HEADLESS_EXT_SURFACE;
+
+	if (SetVideoFormat(hl) == -1 ||
+	    InitClipRects(hl, S->w, S->h) == -1) {
+		hl->S = NULL;
+		return (-1);
+	}
+	InitDefaultCursor(drv);
+	AG_InitStockCursors(drv);
+	return (0);
+}
+
+static int
+HEADLESS_SetVideoContext(void *_Nonnull obj, void *_Nonnull ctx)
+{
+	AG_DriverHEADLESS *hl = obj;
+	AG_Surface *S = ctx;
+
+	if (!ValidSurface(S)) {
+		return (-1);
+	}
+	if (hl->S != NULL && !(hl->flags & HEADLESS_EXT_SURFACE)) {
+		AG_SurfaceFree(hl->S);
+	}
+	hl->S = S;
+	hl->flags |= HEADLESS_EXT_SURFACE;
+	if (SetVideoFormat(hl) == -1) {
+		return (-1);
+	}
+	return InitClipRects(hl, S->w, S->h);
+}
+
+static void
+HEADLESS_CloseVideo(void *_Nonnull obj)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	if (hl->S != NULL && !(hl->flags & HEADLESS_EXT_SURFACE)) {
+		AG_SurfaceFree(hl->S);
+	}
+	hl->S = NULL;
+}
+
+static int
+HEADLESS_VideoResize(void *_Nonnull obj, Uint w, Uint h)
+{
+	AG_DriverSw *dsw = obj;
+	AG_DriverHEADLESS *hl = obj;
+
+	if (hl->flags & HEADLESS_EXT_SURFACE) {
+		AG_SetErrorS("Cannot resize an external display surface");
+		return (-1);
+	}
+	if (AG_SurfaceResize(hl->S, w,h) == -1) {
+		return (-1);
+	}
+	dsw->w = w;
+	dsw->h = h;
+	InitClipRects(hl, w, h);
+
+	if (!(dsw->flags & AG_DRIVER_SW_OVERLAY)) {
+		FillRect32(hl->S, &hl->clipRects[0].r,
+		    (Uint32)AG_MapPixel(&hl->S->format, &dsw->bgColor));
+	}
+	return (0);
+}
+
+static AG_Surface *
+HEADLESS_VideoCapture(void *_Nonnull obj)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	return AG_SurfaceDup(hl->S);
+}
+
+static void
+HEADLESS_VideoClear(void *_Nonnull obj, const AG_Color *_Nonnull c)
+{
+	AG_DriverHEADLESS *hl = obj;
+
+	FillRect32(hl->S, &hl->clipRects[0].r,
+	    (Uint32)AG_MapPixel(&hl->S->format, c));
+}
+
+AG_DriverSwClass agDriverHEADLESS = {
+	{
+		{
+			"AG_Driver:AG_DriverSw:AG_DriverHEADLESS",
+			sizeof(AG_DriverHEADLESS),
+			{ 1,7 },
+			Init,
+			NULL,		/* reset */
+			Destroy,
+			NULL,		/* load */
+			NULL,		/* save */
+			NULL,		/* edit */
+		},
+		"headless",
+		AG_FRAMEBUFFER,
+		AG_WM_SINGLE,
+		0,
+		HEADLESS_Open,
+		HEADLESS_Close,
+		HEADLESS_GetDisplaySize,
+		NULL,				/* beginEventProcessing */
+		HEADLESS_PendingEvents,
+		HEADLESS_GetNextEvent,
+		HEADLESS_ProcessEvent,
+		NULL,				/* genericEventLoop */
+		NULL,				/* endEventProcessing */
+		NULL,				/* terminate */
+		HEADLESS_BeginRendering,
+		HEADLESS_RenderWindow,
+		HEADLESS_EndRendering,
+		HEADLESS_FillRect,
+		NULL,				/* updateRegion */
+		NULL,				/* uploadTexture */
+		HEADLESS_UpdateTexture,
+		HEADLESS_DeleteTexture,
+		HEADLESS_SetRefreshRate,
+		HEADLESS_PushClipRect,
+		HEADLESS_PopClipRect,
+		HEADLESS_PushBlendingMode,
+		HEADLESS_PopBlendingMode,
+		HEADLESS_CreateCursor,
+		HEADLESS_FreeCursor,
+		HEADLESS_SetCursor,
+		HEADLESS_UnsetCursor,
+		HEADLESS_GetCursorVisibility,
+		HEADLESS_SetCursorVisibility,
+		HEADLESS_BlitSurface,
+		HEADLESS_BlitSurfaceFrom,
+#ifdef HAVE_OPENGL
+		HEADLESS_BlitSurfaceGL,
+		HEADLESS_BlitSurfaceFromGL,
+		HEADLESS_BlitSurfaceFlippedGL,
+#endif
+		NULL,				/* backupSurfaces */
+		NULL,				/* restoreSurfaces */
+		HEADLESS_RenderToSurface,
+		HEADLESS_PutPixel,
+		HEADLESS_PutPixel32,
+		HEADLESS_PutPixelRGB8,
+#if AG_MODEL == AG_LARGE
+		HEADLESS_PutPixel64,
+		HEADLESS_PutPixelRGB16,
+#endif
+		HEADLESS_BlendPixel,
+		HEADLESS_DrawLine,
+		HEADLESS_DrawLineH,
+		HEADLESS_DrawLineV,
+		HEADLESS_DrawLineBlended,
+		HEADLESS_DrawLineW,
+		HEADLESS_DrawLineW_Sti16,
+		HEADLESS_DrawTriangle,
+		HEADLESS_DrawPolygon,
+		HEADLESS_DrawPolygon_Sti32,
+		HEADLESS_DrawArrow,
+		HEADLESS_DrawBoxRounded,
+		HEADLESS_DrawBoxRoundedTop,
+		HEADLESS_DrawCircle,
+		HEADLESS_DrawCircleFilled,
+		HEADLESS_DrawRectFilled,
+		HEADLESS_DrawRectBlended,
+		HEADLESS_DrawRectDithered,
+		HEADLESS_UpdateGlyph,
+		HEADLESS_DrawGlyph,
+		NULL,				/* deleteList */
+		NULL,				/* getClipboardText */
+		NULL,				/* setClipboardText */
+		NULL				/* setMouseAutoCapture */
+	},
+	0,
+	HEADLESS_OpenVideo,
+	HEADLESS_OpenVideoContext,
+	HEADLESS_SetVideoContext,
+	HEADLESS_CloseVideo,
+	HEADLESS_VideoResize,
+	HEADLESS_VideoCapture,
+	HEADLESS_VideoClear
+};
@@ -59,6 +59,8 @@ static AG_EventSink *_Nullable sfbEventEpilogue = NULL;
 static void SDLFB_DrawRectFilled(void *_Nonnull, const AG_Rect *_Nonnull,
                                  const AG_Color *_Nonnull);
 static void SDLFB_UpdateRegion(void *_Nonnull, const AG_Rect *_Nonnull);
+static void SDLFB_PushClipRect(void *_Nonnull, const AG_Rect *_Nonnull);
+static void SDLFB_PopClipRect(void *_Nonnull);
 static int CompareInts(const void *_Nonnull, const void *_Nonnull);
 
 static void
@@ -178,16 +180,25 @@ SDLFB_BeginRendering(void *_Nonnull obj)
 static void
 SDLFB_RenderWindow(struct ag_window *_Nonnull win)
 {
+	AG_Driver *drv = WIDGET(win)->drv;
 	AG_Rect rd;
 
-	AG_WidgetDraw(win);
-
-	rd.x = WIDGET(win)->x;
-	rd.y = WIDGET(win)->y;
-	rd.w = WIDTH(win);
-	rd.h = HEIGHT(win);
-
-	SDLFB_UpdateRegion(WIDGET(win)->drv, &rd);
+	if (win->pvt.partial) {		/* Redraw the damaged area only */
+		rd.x = win->pvt.rDamage.x1;
+		rd.y = win->pvt.rDamage.y1;
+		rd.w = win->pvt.rDamage.w;
+		rd.h = win->pvt.rDamage.h;
+		SDLFB_PushClipRect(drv, &rd);
+		AG_WidgetDraw(win);
+		SDLFB_PopClipRect(drv);
+	} else {
+		AG_WidgetDraw(win);
+		rd.x = WIDGET(win)->x;
+		rd.y = WIDGET(win)->y;
+		rd.w = WIDTH(win);
+		rd.h = HEIGHT(win);
+	}
+	SDLFB_UpdateRegion(drv, &rd);
 }
 
 static void
@@ -237,7 +248,6 @@ SDLFB_UpdateRegion(void *_Nonnull obj, const AG_Rect *_Nonnull rRegion)
 
 	AG_RectToRect2(&r, rRegion);
 
-	/* TODO Compute intersections? */
 	if (r.x1 < 0) { r.x1 = 0; }
 	if (r.y1 < 0) { r.y1 = 0; }
 	if (r.x2 > w) { r.x2 = w; r.w = r.x2-r.x1; }
@@ -245,6 +255,12 @@ SDLFB_UpdateRegion(void *_Nonnull obj, const AG_Rect *_Nonnull rRegion)
 	if (r.w < 0)  { r.x1 = 0; r.x2 = r.w = w; }
 	if (r.h < 0)  { r.y1 = 0; r.y2 = r.h = h; }
 
+	for (n = 0; n < sfb->nDirty; n++) {   /* Already covered by a rect? */
+		rSDL = &sfb->dirty[n];
+		if (r.x1 >= rSDL->x && r.x2 <= rSDL->x + rSDL->w &&
+		    r.y1 >= rSDL->y && r.y2 <= rSDL->y + rSDL->h)
+			return;
+	}
 	n = sfb->nDirty++;
 	if (n+1 > sfb->maxDirty) {
 		sfb->maxDirty *= 2;
@@ -1515,12 +1531,57 @@ SDLFB_UpdateGlyph(void *_Nonnull drv, AG_Glyph *_Nonnull G)
 	/* Nothing to do */
 }
 
+/*
+ * Render an AG_Text(3) glyph at x,y. Fill the background (if any) and
+ * blend the FG color according to the glyph's coverage mask.
+ */
 static void
 SDLFB_DrawGlyph(void *_Nonnull drv, const AG_Glyph *_Nonnull G, int x, int y)
 {
 	AG_DriverSDLFB *sfb = drv;
-	
-	AG_SDL_BlitSurface(G->su, NULL, sfb->s, x,y);
+	const AG_Surface *S = G->su;
+	const AG_Component aFg = G->color.a;
+	AG_Color c = G->color;
+	Uint sx, sy;
+
+	if (G->colorBG.a > AG_TRANSPARENT) {
+		AG_Rect r;
+
+		r.x = x;
+		r.y = y;
+		r.w = S->w;
+		r.h = S->h;
+		if (G->colorBG.a == AG_OPAQUE) {
+			SDLFB_DrawRectFilled(drv, &r, &G->colorBG);
+		} else {
+			SDLFB_DrawRectBlended(drv, &r, &G->colorBG,
+			    AG_ALPHA_SRC, AG_ALPHA_ONE_MINUS_SRC);
+		}
+	}
+	if (G->flags & AG_GLYPH_COLORED) {
+		AG_SDL_BlitSurface(G->su, NULL, sfb->s, x,y);
+		return;
+	}
+	for (sy = 0; sy < S->h; sy++) {
+		const Uint8 *pSrc = S->pixels + sy*S->pitch;
+
+		for (sx = 0; sx < S->w; sx++) {
+			AG_Color cMask;
+
+			AG_GetColor(&cMask, AG_SurfaceGet_At(S,pSrc), &S->format);
+			pSrc += S->format.BytesPerPixel;
+			if (cMask.a == AG_TRANSPARENT) {
+				continue;
+			}
+			c.a = AG_GlyphAlpha(cMask.a, aFg);
+			if (c.a == AG_OPAQUE) {
+				SDLFB_PutPixel(drv, x+sx, y+sy, &c);
+			} else {
+				SDLFB_BlendPixel(drv, x+sx, y+sy, &c,
+				    AG_ALPHA_SRC, AG_ALPHA_ONE_MINUS_SRC);
+			}
+		}
+	}
 }
 
 /* Initialize the clipping rectangle stack. */
@@ -48,8 +48,6 @@
 #include <agar/gui/icons.h>
 #include <agar/gui/gui_math.h>
 
-#include <agar/core/crc32.h>
-
 #include <string.h>
 #include <stdarg.h>
 #include <ctype.h>
@@ -64,38 +62,130 @@ static Uint32 AutocompleteTimeout(AG_Timer *_Nonnull, AG_Event *_Nonnull);
 /* #define DEBUG_CLIPBOARD */
 /* #define DEBUG_UNDO */
 
+/* Discard the line index (to be rebuilt on the next Draw). */
+static __inline__ void
+IndexInvalidate(AG_Editable *_Nonnull ed)
+{
+	ed->idx.n = 0;
+	ed->idx.gap = 0;
+}
+
 /*
- * Return a new working buffer. The variable is returned locked; the caller
- * should invoke ReleaseBuffer() after use.
+ * Return a hash of the len bytes at s. Under Shared Access, we keep the
+ * hash of the bound text rather than a copy of it.
  */
-static __inline__ AG_EditableBuffer *_Nullable
-GetBuffer(AG_Editable *_Nonnull ed)
+static Uint64
+SharedHash(const char *_Nonnull s, AG_Size len)
 {
-	AG_EditableBuffer *buf;
+	Uint64 h0 = (Uint64)len, h1 = 1, h2 = 2, h3 = 3, w[4];
+	AG_Size i;
 
-	if (ed->flags & AG_EDITABLE_EXCL) {
-		buf = &ed->sBuf;
-	} else {
-		if ((buf = TryMalloc(sizeof(AG_EditableBuffer))) == NULL) {
-			return (NULL);
-		}
-		buf->s = NULL;
-		buf->len = 0;
-		buf->maxLen = 0;
+	for (i = 0; i+32 <= len; i += 32) {            /* Four independent lanes */
+		memcpy(w, &s[i], sizeof(w));
+		h0 = (h0 ^ w[0]) * 0x9e3779b97f4a7c15ULL;  h0 ^= h0 >> 29;
+		h1 = (h1 ^ w[1]) * 0x9e3779b97f4a7c15ULL;  h1 ^= h1 >> 29;
+		h2 = (h2 ^ w[2]) * 0x9e3779b97f4a7c15ULL;  h2 ^= h2 >> 29;
+		h3 = (h3 ^ w[3]) * 0x9e3779b97f4a7c15ULL;  h3 ^= h3 >> 29;
+	}
+	for (; i < len; i++) {
+		h0 = (h0 ^ (Uint8)s[i]) * 0x9e3779b97f4a7c15ULL;
 	}
+	return (h0 ^ (h1 * 0xff51afd7ed558ccdULL) ^
+	             (h2 * 0xc4ceb9fe1a85ec53ULL) ^ (h3 * 0x94d049bb133111ebULL));
+}
+
+/*
+ * Under Shared Access, return 1 if the bound text differs from the text
+ * imported into the working buffer (or if the binding itself has changed).
+ * Check the binding and the length first. Changes which preserve the length
+ * are only detected if verify is set (i.e., once per Draw and whenever the
+ * application calls AG_EditableGetBuffer()).
+ */
+static int
+SharedChanged(const AG_Editable *_Nonnull ed, const void *_Nonnull p,
+    const char *_Nullable s, int verify)
+{
+	AG_Size len;
+
+	if (ed->pShared != p) {
+		return (1);
+	}
+	if (s == NULL) {
+		s = "";
+	}
+	if ((len = strlen(s)) != ed->lenShared) {
+		return (1);
+	}
+	return (verify && SharedHash(s, len) != ed->hashShared);
+}
+
+/* Record the bound text as of the last import or commit. */
+static void
+SharedUpdate(AG_Editable *_Nonnull ed, const void *_Nonnull p,
+    const char *_Nullable s)
+{
+	if (s == NULL) {
+		s = "";
+	}
+	ed->pShared = p;
+	ed->lenShared = strlen(s);
+	ed->hashShared = SharedHash(s, ed->lenShared);
+}
+
+/* Clear a working buffer. */
+static __inline__ void
+ClearBuffer(AG_EditableBuffer *_Nonnull buf)
+{
+	AG_Free(buf->s);
+	buf->s = NULL;
+	buf->len = 0;
+	buf->maxLen = 0;
+}
+
+/* Clear the persistent working buffer and its line index. */
+static void
+InvalidateBuffer(AG_Editable *_Nonnull ed)
+{
+	ClearBuffer(&ed->sBuf);
+	ed->pShared = NULL;
+	ed->lenConv = 0;
+	IndexInvalidate(ed);
+}
+
+/*
+ * Return the working buffer. The variable is returned locked; the caller
+ * should invoke ReleaseBuffer() after use.
+ *
+ * The working buffer persists across calls. Under Exclusive Access, it is
+ * imported only once. Under Shared Access, it is re-imported only if the
+ * bound text has been changed externally (in which case the Undo/Redo
+ * history is no longer applicable and is cleared). See SharedChanged()
+ * for the meaning of verify.
+ */
+static AG_EditableBuffer *_Nullable
+GetBufferVerify(AG_Editable *_Nonnull ed, int verify)
+{
+	AG_EditableBuffer *buf = &ed->sBuf;
+	const int excl = (ed->flags & AG_EDITABLE_EXCL);
 
 #ifdef AG_UNICODE
 	if (AG_Defined(ed, "text")) {                    /* AG_TextElement(3) */
 		AG_TextElement *txt;
+		const AG_TextEnt *te;
 
 		buf->var = AG_GetVariable(ed, "text", (void *)&txt);
 		buf->reallocable = 1;
 
 		AG_MutexLock(&txt->lock);
+		te = &txt->ent[ed->lang];
 
-		if ((ed->flags & AG_EDITABLE_EXCL) == 0 || buf->s == NULL) {
-			const AG_TextEnt *te = &txt->ent[ed->lang];
-
+		if (buf->s == NULL ||
+		    (!excl && SharedChanged(ed, te, te->buf, verify))) {
+			if (buf->s != NULL && ed->nUndo + ed->nRedo > 0) {
+				AG_EditableClearHistory(ed);
+			}
+			ClearBuffer(buf);
+			IndexInvalidate(ed);
 			if (te->buf != NULL) {
 				buf->s = AG_ImportUnicode("UTF-8", te->buf,
 				                          &buf->len,
@@ -105,13 +195,16 @@ GetBuffer(AG_Editable *_Nonnull ed)
 					buf->s[0] = (AG_Char)'\0';
 				}
 				buf->len = 0;
+				buf->maxLen = sizeof(AG_Char);
 			}
 			if (buf->s == NULL) {
 				AG_MutexUnlock(&txt->lock);
 				AG_UnlockVariable(buf->var);
 				buf->var = NULL;
-				goto fail;
+				return (NULL);
 			}
+			if (!excl)
+				SharedUpdate(ed, te, te->buf);
 		}
 	} else
 #endif /* AG_UNICODE */
@@ -121,7 +214,14 @@ GetBuffer(AG_Editable *_Nonnull ed)
 		buf->var = AG_GetVariable(ed, "string", (void *)&s);
 		buf->reallocable = 0;
 
-		if ((ed->flags & AG_EDITABLE_EXCL) == 0 || buf->s == NULL) {
+		if (buf->s == NULL ||
+		    (!excl && SharedChanged(ed, s, s, verify))) {
+			if (buf->s != NULL && ed->nUndo + ed->nRedo > 0) {
+				AG_EditableClearHistory(ed);
+			}
+			ClearBuffer(buf);
+			IndexInvalidate(ed);
+			ed->lenConv = 0;
 #ifdef AG_UNICODE
 			buf->s = AG_ImportUnicode(ed->encoding, s, &buf->len,
 			                          &buf->maxLen);
@@ -131,24 +231,20 @@ GetBuffer(AG_Editable *_Nonnull ed)
 #endif
 			if (buf->s == NULL) {
 				AG_UnlockVariable(buf->var);
-				goto fail;
+				buf->var = NULL;
+				return (NULL);
 			}
+			if (!excl)
+				SharedUpdate(ed, s, s);
 		}
 	}
 	return (buf);
-fail:
-	if ((ed->flags & AG_EDITABLE_EXCL) == 0) { free(buf); }
-	return (NULL);
 }
 
-/* Clear a working buffer. */
-static __inline__ void
-ClearBuffer(AG_EditableBuffer *_Nonnull buf)
+static __inline__ AG_EditableBuffer *_Nullable
+GetBuffer(AG_Editable *_Nonnull ed)
 {
-	AG_Free(buf->s);
-	buf->s = NULL;
-	buf->len = 0;
-	buf->maxLen = 0;
+	return GetBufferVerify(ed, 0);
 }
 
 /* Commit changes to the working buffer. */
@@ -170,16 +266,27 @@ CommitBuffer(AG_Editable *_Nonnull ed, AG_EditableBuffer *_Nonnull buf)
 		if (AG_ExportUnicode(ed->encoding, te->buf, buf->s,
 		                     te->maxLen + 1) == -1)
 			goto fail;
+
+		if (!(ed->flags & AG_EDITABLE_EXCL))
+			SharedUpdate(ed, te, te->buf);
 	} else {                                                /* "C" string */
 		if (AG_ExportUnicode(ed->encoding,
 		                     buf->var->data.s, buf->s,
 				     buf->var->info.size) == -1)
 			goto fail;
+
+		ed->lenConv = strlen(buf->var->data.s);
+
+		if (!(ed->flags & AG_EDITABLE_EXCL))
+			SharedUpdate(ed, buf->var->data.s, buf->var->data.s);
 	}
 #else  /* !AG_UNICODE */
 
 	Strlcpy(buf->var->data.s, (const char *)buf->s, buf->var->info.size);
 
+	if (!(ed->flags & AG_EDITABLE_EXCL))
+		SharedUpdate(ed, buf->var->data.s, buf->var->data.s);
+
 #endif /* !AG_UNICODE */
 
 	ed->flags |= AG_EDITABLE_MARKPREF;
@@ -203,10 +310,6 @@ ReleaseBuffer(AG_Editable *_Nonnull ed, AG_EditableBuffer *_Nonnull buf)
 		AG_UnlockVariable(buf->var);
 		buf->var = NULL;
 	}
-	if (!(ed->flags & AG_EDITABLE_EXCL)) {
-		ClearBuffer(buf);
-		Free(buf);
-	}
 }
 
 /* Allocate and return a new buffer handle in a locked condition */
@@ -218,19 +321,26 @@ AG_EditableGetBuffer(AG_Editable *ed)
 	AG_OBJECT_ISA(ed, "AG_Widget:AG_Editable:*");
 	AG_ObjectLock(ed);
 
-	if ((buf = GetBuffer(ed)) == NULL) {
+	if ((buf = GetBufferVerify(ed, 1)) == NULL) {
 		AG_ObjectUnlock(ed);
 	}
 	return (buf);
 }
 
-/* Clear a working buffer. */
+/*
+ * Clear a working buffer. The text will be re-imported from the binding
+ * on the next access.
+ */
 void
 AG_EditableClearBuffer(AG_Editable *ed, AG_EditableBuffer *buf)
 {
 	AG_OBJECT_ISA(ed, "AG_Widget:AG_Editable:*");
 
-	ClearBuffer(buf);
+	if (buf == &ed->sBuf) {
+		InvalidateBuffer(ed);
+	} else {
+		ClearBuffer(buf);
+	}
 }
 
 /* Increase the working buffer size to accomodate new characters. */
@@ -246,36 +356,51 @@ AG_EditableGrowBuffer(AG_Editable *ed, AG_EditableBuffer *buf, AG_Char *ins,
 
 	newLen = (buf->len + nIns + 1)*sizeof(AG_Char);
 
+	if (!buf->reallocable) {              /* Check the bound buffer size */
 #ifdef AG_UNICODE
-	if (strcmp(ed->encoding, "UTF-8") == 0) {
-		AG_Size sLen, insLen;
-
-		if (AG_LengthUTF8FromUCS4(buf->s, &sLen) == -1 ||
-		    AG_LengthUTF8FromUCS4(ins, &insLen) == -1) {
-			return (-1);
+		if (strcmp(ed->encoding, "UTF-8") == 0) {
+			AG_Size sLen, insLen;
+
+			/*
+			 * lenConv is an upper bound on the exported length of
+			 * the buffer (exact as of the last commit and increased
+			 * by every insertion since). Count only if it won't do.
+			 */
+			if (AG_LengthUTF8FromUCS4(ins, &insLen) == -1) {
+				return (-1);
+			}
+			if (ed->lenConv == 0 ||
+			    ed->lenConv + insLen + 1 > buf->var->info.size) {
+				if (AG_LengthUTF8FromUCS4(buf->s, &sLen) == -1)
+					return (-1);
+			} else {
+				sLen = ed->lenConv;
+			}
+			convLen = sLen + insLen + 1;
+			if (convLen <= buf->var->info.size)
+				ed->lenConv = sLen + insLen;
+		} else if (strcmp(ed->encoding, "US-ASCII") == 0) {
+			convLen = buf->len + nIns + 1;
+		} else {
+			/* TODO Proper estimates for other charsets */
+			convLen = newLen;
 		}
-		convLen = sLen + insLen + 1;
-	} else if (strcmp(ed->encoding, "US-ASCII") == 0) {
-		convLen = AG_LengthUCS4(buf->s) + nIns + 1;
-	} else {
-		/* TODO Proper estimates for other charsets */
-		convLen = newLen;
-	}
 #else /* !AG_UNICODE */
-	if (strcmp(ed->encoding, "US-ASCII") == 0) {
-		convLen = strlen((const char *)buf->s) + nIns + 1;
-	} else {
-		convLen = newLen;
-	}
+		if (strcmp(ed->encoding, "US-ASCII") == 0) {
+			convLen = buf->len + nIns + 1;
+		} else {
+			convLen = newLen;
+		}
 #endif /* AG_UNICODE */
-
-	if (!buf->reallocable) {
 		if (convLen > buf->var->info.size) {
 			AG_SetError("%u > %u bytes", (Uint)convLen, (Uint)buf->var->info.size);
 			return (-1);
 		}
 	}
 	if (newLen > buf->maxLen) {
+		if (newLen < (buf->maxLen << 1))      /* Amortize reallocations */
+			newLen = (buf->maxLen << 1);
+
 		if ((sNew = TryRealloc(buf->s, newLen)) == NULL) {
 			return (-1);
 		}
@@ -386,6 +511,7 @@ AG_EditableSetLang(AG_Editable *ed, enum ag_language lang)
 	AG_ObjectLock(ed);
 
 	ed->lang = (lang < AG_LANG_LAST) ? lang : AG_LANG_NONE;
+	InvalidateBuffer(ed);
 	ed->pos = 0;
 	ed->selStart = 0;
 	ed->selEnd = 0;
@@ -434,14 +560,12 @@ AG_EditableSetWordWrap(AG_Editable *ed, int enable)
  * Disabled mode may still access its contents for reading.
  *
  * In Shared Access mode (the default), every interaction and operation must
- * acquire an internal working buffer (which involves allocations and UTF-8
- * conversions). Checksums must be calculated in order for Undo/Redo to work
- * safely against potentially-changing buffer, and the Editable must be
- * redrawn periodically.
+ * compare the bound text against the contents of the persistent working
+ * buffer, re-importing it (and clearing the Undo/Redo history) if it has
+ * been changed externally. The Editable must also be redrawn periodically.
  *
- * Exclusive Access mode allows Editable to operate more efficiently through
- * the use of a persistent working buffer, which avoids the need for regular
- * redrawing, allocations, UTF-8 conversions and checksumming.
+ * Exclusive Access mode allows Editable to operate more efficiently, since
+ * it avoids the need for regular redrawing and comparisons.
  */
 void
 AG_EditableSetExcl(AG_Editable *ed, int enable)
@@ -454,14 +578,14 @@ AG_EditableSetExcl(AG_Editable *ed, int enable)
 			ed->flags |= AG_EDITABLE_EXCL;
 			AG_RedrawOnTick(ed, -1);
 			AG_EditableClearHistory(ed);
-			ClearBuffer(&ed->sBuf);
+			InvalidateBuffer(ed);
 		}
 	} else {
 		if (ed->flags & AG_EDITABLE_EXCL) {
 			ed->flags &= ~(AG_EDITABLE_EXCL);
 			AG_RedrawOnTick(ed, 1000);
 			AG_EditableClearHistory(ed);
-			ClearBuffer(&ed->sBuf);
+			InvalidateBuffer(ed);
 		}
 	}
 	AG_ObjectUnlock(ed);
@@ -727,6 +851,7 @@ OnFontChange(AG_Event *_Nonnull event)
 	ed->fontMaxHeight = height;
 	ed->lineSkip = lineskip;
 	ed->yVis = HEIGHT(ed) / lineskip;
+	IndexInvalidate(ed);
 
 	if (ed->suPlaceholder != -1) {
 		AG_WidgetUnmapSurface(ed, ed->suPlaceholder);
@@ -767,10 +892,385 @@ WrapAtChar(AG_Editable *_Nonnull ed, int x, AG_Char *_Nonnull s,
 	return (0);
 }
 
+/* Editable flags which affect the layout of the line index. */
+#define INDEX_FLAGS (AG_EDITABLE_WORDWRAP | AG_EDITABLE_PASSWORD | \
+                     AG_EDITABLE_UPPERCASE | AG_EDITABLE_LOWERCASE)
+
+/* Return a pointer to line i of the line index. */
+static __inline__ AG_EditableLine *_Nonnull
+IndexLine(const AG_EditableIndex *_Nonnull idx, Uint i)
+{
+	return &idx->lines[(i < idx->gap) ? i : i + (idx->nMax - idx->n)];
+}
+
+/* Return the position of the first character of line i. */
+static __inline__ int
+IndexPos(const AG_EditableIndex *_Nonnull idx, Uint i)
+{
+	const AG_EditableLine *L = IndexLine(idx, i);
+
+	return (i < idx->gap) ? L->pos : (int)idx->len - L->pos;
+}
+
+/* Return the line containing the given character position. */
+static Uint
+IndexFind(const AG_EditableIndex *_Nonnull idx, int pos)
+{
+	Uint lo = 0, hi = idx->n - 1;
+
+	while (lo < hi) {
+		const Uint mid = (lo + hi + 1) >> 1;
+
+		if (IndexPos(idx, mid) <= pos) {
+			lo = mid;
+		} else {
+			hi = mid - 1;
+		}
+	}
+	return (lo);
+}
+
+/* Move the gap in the line index before line g. */
+static void
+IndexMoveGap(AG_EditableIndex *_Nonnull idx, Uint g)
+{
+	const Uint nGap = idx->nMax - idx->n;
+	const int len = (int)idx->len;
+	AG_EditableLine *lines = idx->lines;
+
+	while (idx->gap > g) {
+		idx->gap--;
+		lines[idx->gap + nGap] = lines[idx->gap];
+		lines[idx->gap + nGap].pos = len - lines[idx->gap].pos;
+	}
+	while (idx->gap < g) {
+		lines[idx->gap] = lines[idx->gap + nGap];
+		lines[idx->gap].pos = len - lines[idx->gap + nGap].pos;
+		idx->gap++;
+	}
+}
+
+/* Insert a line (with an absolute position) at the gap. */
+static int
+IndexPush(AG_EditableIndex *_Nonnull idx, const AG_EditableLine *_Nonnull L)
+{
+	if (idx->n == idx->nMax) {
+		const Uint nAfter = idx->n - idx->gap;
+		const Uint nMaxNew = (idx->nMax > 0) ? (idx->nMax << 1) : 64;
+		AG_EditableLine *linesNew;
+
+		linesNew = TryRealloc(idx->lines, nMaxNew*sizeof(AG_EditableLine));
+		if (linesNew == NULL) {
+			return (-1);
+		}
+		memmove(&linesNew[nMaxNew - nAfter], &linesNew[idx->gap],
+		    nAfter*sizeof(AG_EditableLine));
+		idx->lines = linesNew;
+		idx->nMax = nMaxNew;
+	}
+	idx->lines[idx->gap++] = *L;
+	idx->n++;
+	if (idx->wMax != -1 && L->w > idx->wMax) {
+		idx->wMax = L->w;
+	}
+	return (0);
+}
+
+/* Remove the first line following the gap. */
+static __inline__ void
+IndexDrop(AG_EditableIndex *_Nonnull idx)
+{
+	if (IndexLine(idx, idx->gap)->w >= idx->wMax) {
+		idx->wMax = -1;
+	}
+	idx->n--;
+}
+
+/* Return the width of the widest line. */
+static int
+IndexWidth(AG_EditableIndex *_Nonnull idx)
+{
+	Uint i;
+
+	if (idx->n == 1) {
+		return IndexLine(idx, 0)->w;
+	}
+	if (idx->wMax == -1) {
+		idx->wMax = 10;
+		for (i = 0; i < idx->n; i++)
+			idx->wMax = MAX(idx->wMax, IndexLine(idx,i)->w);
+	}
+	return (idx->wMax);
+}
+
+/* Return 1 if the line index is out of date with respect to ed. */
+static __inline__ int
+IndexStale(AG_Editable *_Nonnull ed)
+{
+	const AG_EditableIndex *idx = &ed->idx;
+
+	return (idx->n == 0 ||
+	        idx->font != WFONT(ed) ||
+	        idx->flags != (ed->flags & INDEX_FLAGS) ||
+	        ((ed->flags & AG_EDITABLE_WORDWRAP) && idx->wWrap != WIDTH(ed)));
+}
+
+/*
+ * Lay out the visual line starting at L->pos with the ANSI SGR colors in L,
+ * measuring its width into L->w. Return the position of the next line
+ * (and its initial colors into Lnext), or -1 if L is the last line.
+ */
+static int
+LayoutLine(AG_Editable *_Nonnull ed, const AG_EditableBuffer *_Nonnull buf,
+    AG_EditableLine *_Nonnull L, AG_EditableLine *_Nonnull Lnext)
+{
+	const AG_TextState *ts = AG_TEXT_STATE_CUR();
+	AG_Driver *drv = WIDGET(ed)->drv;
+	AG_Font *font = WFONT(ed);
+	const AG_Color *cFg = &WCOLOR(ed, TEXT_COLOR);
+	const AG_Color *cBg = &ts->colorBG;
+	const Uint flags = ed->flags;
+	const int len = (int)buf->len;
+	int i, x = WIDGET(ed)->paddingLeft, next = -1;
+
+	Lnext->flags = L->flags;
+	Lnext->cFg = L->cFg;
+	Lnext->cBg = L->cBg;
+
+	for (i = L->pos; i < len; i++) {
+		AG_Char c = buf->s[i];
+
+		if (i > L->pos && WrapAtChar(ed, x, &buf->s[i], font, cBg, cFg)) {
+			next = i;
+			break;
+		}
+		if (c == '\n') {
+			x += 10;
+			next = i+1;
+			break;
+		} else if (c == '\t') {
+			x += agTextTabWidth;
+			continue;
+		} else if (c == 0x1b &&
+		    buf->s[i+1] >= 0x40 &&
+		    buf->s[i+1] <= 0x5f &&
+		    buf->s[i+2] != '\0') {
+			AG_TextANSI ansi;
+
+			if (AG_TextParseANSI(ts, &ansi, &buf->s[i+1]) == 0) {
+				if (ansi.ctrl == AG_ANSI_CSI_SGR) {
+					switch (ansi.sgr) {
+					case AG_SGR_RESET:
+					case AG_SGR_NO_FG_NO_BG:
+						Lnext->flags &= ~(AG_EDITABLE_LINE_FG |
+						                  AG_EDITABLE_LINE_BG);
+						break;
+					case AG_SGR_FG:
+						Lnext->flags |= AG_EDITABLE_LINE_FG;
+						Lnext->cFg = ansi.color;
+						break;
+					case AG_SGR_BG:
+						Lnext->flags |= AG_EDITABLE_LINE_BG;
+						Lnext->cBg = ansi.color;
+						break;
+					default:
+						break;
+					}
+				}
+				i += ansi.len;
+				continue;
+			}
+		}
+		if      (flags & AG_EDITABLE_PASSWORD)  { c = '*'; }
+		else if (flags & AG_EDITABLE_UPPERCASE) { c = toupper(c); }
+		else if (flags & AG_EDITABLE_LOWERCASE) { c = tolower(c); }
+
+		x += AG_TextRenderGlyph(drv, font, cBg, cFg, c)->advance;
+	}
+	L->w = x;
+	return (next);
+}
+
+/* Lay out the entire buffer into a new line index. */
+static int
+IndexBuild(AG_Editable *_Nonnull ed, const AG_EditableBuffer *_Nonnull buf)
+{
+	AG_EditableIndex *idx = &ed->idx;
+	AG_EditableLine L, Lnext;
+	int next;
+
+	idx->n = 0;
+	idx->gap = 0;
+	idx->wMax = 10;
+	idx->len = buf->len;
+	idx->font = WFONT(ed);
+	idx->wWrap = WIDTH(ed);
+	idx->flags = (ed->flags & INDEX_FLAGS);
+
+	memset(&L, 0, sizeof(L));
+	for (;;) {
+		next = LayoutLine(ed, buf, &L, &Lnext);
+		if (IndexPush(idx, &L) == -1) {
+			IndexInvalidate(ed);
+			return (-1);
+		}
+		if (next == -1) {
+			break;
+		}
+		L = Lnext;
+		L.pos = next;
+	}
+	return (0);
+}
+
+/* Make sure that the line index is up to date. */
+static int
+IndexUpdate(AG_Editable *_Nonnull ed, const AG_EditableBuffer *_Nonnull buf)
+{
+	if (WIDGET(ed)->drv == NULL) {
+		return (-1);
+	}
+	if (!IndexStale(ed) && ed->idx.len == buf->len) {
+		return (0);
+	}
+	return IndexBuild(ed, buf);
+}
+
+/*
+ * Update the line index following the replacement of nDel characters at
+ * pos by nIns new characters. Only the lines from the edit up to the point
+ * where the new layout converges with the old one are laid out again.
+ */
+static void
+IndexEdit(AG_Editable *_Nonnull ed, const AG_EditableBuffer *_Nonnull buf,
+    int pos, int nDel, int nIns)
+{
+	AG_EditableIndex *idx = &ed->idx;
+	AG_EditableLine L, Lnext, *Lt;
+	const int posEnd = pos + nIns;
+	Uint i;
+	int next, t;
+
+	if (idx->n == 0) {
+		return;
+	}
+	if (WIDGET(ed)->drv == NULL || IndexStale(ed) ||
+	    idx->len + nIns - nDel != buf->len) {
+		IndexInvalidate(ed);
+		return;
+	}
+	i = IndexFind(idx, pos);
+	if (i > 0 && (ed->flags & AG_EDITABLE_WORDWRAP))
+		i--;                       /* Following word may now fit above */
+
+	IndexMoveGap(idx, i);
+	L = *IndexLine(idx, i);
+	L.pos = (int)idx->len - L.pos;
+	IndexDrop(idx);
+	idx->len = buf->len;
+
+	for (;;) {
+		next = LayoutLine(ed, buf, &L, &Lnext);
+		if (IndexPush(idx, &L) == -1) {
+			IndexInvalidate(ed);
+			return;
+		}
+		if (next == -1) {
+			while (idx->n > idx->gap) {
+				IndexDrop(idx);
+			}
+			break;
+		}
+		for (Lt = NULL, t = 0; idx->n > idx->gap; ) {
+			Lt = IndexLine(idx, idx->gap);
+			t = (int)idx->len - Lt->pos;
+			if (t <= posEnd || t < next) {
+				IndexDrop(idx);                      /* Stale */
+				Lt = NULL;
+			} else {
+				break;
+			}
+		}
+		if (Lt != NULL && t == next && Lt->flags == Lnext.flags &&
+		    (!(Lt->flags & AG_EDITABLE_LINE_FG) ||
+		     AG_ColorCompare(&Lt->cFg, &Lnext.cFg) == 0) &&
+		    (!(Lt->flags & AG_EDITABLE_LINE_BG) ||
+		     AG_ColorCompare(&Lt->cBg, &Lnext.cBg) == 0))
+			break;                                  /* Converged */
+
+		L = Lnext;
+		L.pos = next;
+	}
+}
+
+/*
+ * Return the x coordinate (in pixels) of character position pos within the
+ * visual line starting at lineStart.
+ */
+static int
+IndexMeasure(AG_Editable *_Nonnull ed, const AG_EditableBuffer *_Nonnull buf,
+    int lineStart, int pos)
+{
+	const AG_TextState *ts = AG_TEXT_STATE_CUR();
+	AG_Driver *drv = WIDGET(ed)->drv;
+	AG_Font *font = WFONT(ed);
+	const AG_Color *cFg = &WCOLOR(ed, TEXT_COLOR);
+	const Uint flags = ed->flags;
+	int i, x = WIDGET(ed)->paddingLeft;
+
+	for (i = lineStart; i < pos; i++) {
+		AG_Char c = buf->s[i];
+
+		if (c == '\n') {
+			break;
+		} else if (c == '\t') {
+			x += agTextTabWidth;
+			continue;
+		} else if (c == 0x1b &&
+		    buf->s[i+1] >= 0x40 &&
+		    buf->s[i+1] <= 0x5f &&
+		    buf->s[i+2] != '\0') {
+			AG_TextANSI ansi;
+
+			if (AG_TextParseANSI(ts, &ansi, &buf->s[i+1]) == 0) {
+				i += ansi.len;
+				continue;
+			}
+		}
+		if      (flags & AG_EDITABLE_PASSWORD)  { c = '*'; }
+		else if (flags & AG_EDITABLE_UPPERCASE) { c = toupper(c); }
+		else if (flags & AG_EDITABLE_LOWERCASE) { c = tolower(c); }
+
+		x += AG_TextRenderGlyph(drv, font, &ts->colorBG, cFg, c)->advance;
+	}
+	return (x);
+}
+
+/*
+ * Return the coordinates (x in pixels, line number) of the given character
+ * position. A position at a word wrap is displayed at the end of the
+ * preceding line.
+ */
+static void
+IndexLocate(AG_Editable *_Nonnull ed, const AG_EditableBuffer *_Nonnull buf,
+    int pos, int *_Nonnull x, int *_Nonnull line)
+{
+	const AG_EditableIndex *idx = &ed->idx;
+	Uint i;
+	int lineStart;
+
+	i = IndexFind(idx, pos);
+	lineStart = IndexPos(idx, i);
+	if (i > 0 && lineStart == pos && buf->s[pos-1] != '\n') {
+		lineStart = IndexPos(idx, --i);
+	}
+	*x = IndexMeasure(ed, buf, lineStart, pos);
+	*line = (int)i;
+}
+
 /*
  * Map mouse coordinates to a character position within the buffer.
  */
-#define ON_LINE(my,y)     ((my) >= (y) && (my) <= (y)+ed->lineSkip)
 #define ON_CHAR(mx,x,adv) ((mx) >= (x) && (mx) <= (x)+(adv))
 int
 AG_EditableMapPosition(AG_Editable *ed, AG_EditableBuffer *buf, int mx, int my,
@@ -780,7 +1280,8 @@ AG_EditableMapPosition(AG_Editable *ed, AG_EditableBuffer *buf, int mx, int my,
 	AG_Driver *drv = WIDGET(ed)->drv;
 	AG_Font *font = WFONT(ed);
 	AG_TextANSI ansi;
-	int i, x, y, yMouse;
+	Uint line;
+	int i, x, yMouse, lineStart, lineEnd;
 	
 	AG_OBJECT_ISA(ed, "AG_Widget:AG_Editable:*");
 	AG_ObjectLock(ed);
@@ -789,32 +1290,33 @@ AG_EditableMapPosition(AG_Editable *ed, AG_EditableBuffer *buf, int mx, int my,
 		*pos = 0;
 		goto out;
 	}
-	for (i=0, x=0, y=0; i < buf->len; i++) {
+	if (IndexUpdate(ed, buf) == -1) {
+		*pos = buf->len;
+		goto out;
+	}
+	line = (Uint)(yMouse / ed->lineSkip);
+	if (line > 0 && (yMouse % ed->lineSkip) == 0) {
+		line--;                           /* Boundary belongs above */
+	}
+	if (line >= ed->idx.n) {
+		*pos = buf->len;
+		goto out;
+	}
+	lineStart = IndexPos(&ed->idx, line);
+	lineEnd = (line+1 < ed->idx.n) ? IndexPos(&ed->idx, line+1) :
+	                                 (int)buf->len;
+	if (mx <= 0) {
+		*pos = lineStart;
+		goto out;
+	}
+	for (i = lineStart, x = 0; i < lineEnd; i++) {
 		const AG_Char ch = buf->s[i];
 
-		if (mx <= 0 && ON_LINE(yMouse,y)) {
+		if (ch == '\n') {
 			*pos = i;
 			goto out;
-		}
-		if (WrapAtChar(ed, x, &buf->s[i], font, &ts->colorBG, &ts->color)) {
-			if (ON_LINE(yMouse,y) && mx > x) {
-				*pos = i;
-				goto out;
-			}
-			y += ed->lineSkip;
-			x = 0;
-		}
-		if (ch == '\n') {
-			if (ON_LINE(yMouse,y) && mx > x) {
-				*pos = i;
-				goto out;
-			}
-			y += ed->lineSkip;
-			x = 0;
-			continue;
 		} else if (ch == '\t') {
-			if (ON_LINE(yMouse,y) &&
-			    mx >= x && mx <= x+agTextTabWidth) {
+			if (mx >= x && mx <= x+agTextTabWidth) {
 				*pos = (mx < x + (agTextTabWidth >> 1)) ? i : i+1;
 				goto out;
 			}
@@ -842,8 +1344,7 @@ AG_EditableMapPosition(AG_Editable *ed, AG_EditableBuffer *buf, int mx, int my,
 					/* TODO blank box advance */
 					continue;
 				}
-				if (ON_LINE(yMouse, y) &&
-				    ON_CHAR(mx, x, Gft->advance)) {
+				if (ON_CHAR(mx, x, Gft->advance)) {
 					*pos = (mx < x + (Gft->advance >> 1)) ?
 					       i : i+1;
 					if (buf->s[*pos]   == 0x1b &&
@@ -867,8 +1368,7 @@ AG_EditableMapPosition(AG_Editable *ed, AG_EditableBuffer *buf, int mx, int my,
 				G = AG_TextRenderGlyph(drv, font,
 				    &ts->colorBG, &ts->color, ch);
 
-				if (ON_LINE(yMouse,y) &&
-				    mx >= x &&
+				if (mx >= x &&
 				    mx <= x + G->su->w) {
 					*pos = i;
 					if (buf->s[*pos]   == 0x1b &&
@@ -889,12 +1389,11 @@ AG_EditableMapPosition(AG_Editable *ed, AG_EditableBuffer *buf, int mx, int my,
 			break;
 		}
 	}
-	*pos = buf->len;
+	*pos = lineEnd;                    /* Past the end of the line */
 out:
 	AG_ObjectUnlock(ed);
 	return (0);
 }
-#undef ON_LINE
 #undef ON_CHAR
 
 /* Move cursor to the given position in pixels. */
@@ -993,12 +1492,15 @@ Draw(void *_Nonnull obj)
 	const int selStart = ed->selStart;
 	const int selEnd = ed->selEnd;
 	const int paddingLeft = WIDGET(ed)->paddingLeft;
-	int i, dx,dy, x,y, yCurs=0, selected=0;
+	const int paddingTop = WIDGET(ed)->paddingTop;
+	AG_EditableIndex *idx = &ed->idx;
+	Uint line;
+	int i, dx,dy, x,y, yCurs=0, selected;
 
 	if (cEditableBg->a > 0)
 		AG_DrawRectFilled(ed, &WIDGET(ed)->r, cEditableBg);
 
-	if ((buf = GetBuffer(ed)) == NULL) {
+	if ((buf = GetBufferVerify(ed, 1)) == NULL) {
 		return;
 	}
 	AG_EditableValidateSelection(ed, buf);
@@ -1024,127 +1526,119 @@ Draw(void *_Nonnull obj)
 		AG_WidgetBlitFrom(ed, ed->suPlaceholder, NULL, 0,0);
 	}
 
-	x = paddingLeft;
-	y = WIDGET(ed)->paddingTop - ed->y*lineSkip;
-	ed->xMax = 10;
-	ed->yMax = 1;
-	for (i = 0; i <= buf->len; i++) {
-		AG_Glyph *G;
-		AG_Char c = buf->s[i];
-		AG_Rect r;
+	if (IndexUpdate(ed, buf) == -1)
+		goto out;
 
-		if (i == pos) {                                /* At cursor */
-			ed->xCurs = x;
-			if (flags & AG_EDITABLE_MARKPREF) {
-				ed->flags &= ~(AG_EDITABLE_MARKPREF);
-				ed->xCursPref = x;
-			}
-			ed->yCurs = y/lineSkip + ed->y;
-			yCurs = y;
-		}
-		if (selEnd > selStart) {
-			if (i >= selStart && i < selEnd) {
-				if (!selected) {
-					selected = 1;
-					ed->xSelStart = x;
-					ed->ySelStart = y/lineSkip + ed->y;
+	/*
+	 * Locate the cursor and selection through the line index, and draw
+	 * only the visible lines.
+	 */
+	IndexLocate(ed, buf, pos, &ed->xCurs, &ed->yCurs);
+	if (flags & AG_EDITABLE_MARKPREF) {
+		ed->flags &= ~(AG_EDITABLE_MARKPREF);
+		ed->xCursPref = ed->xCurs;
+	}
+	yCurs = paddingTop + (ed->yCurs - ed->y)*lineSkip;
+	if (selEnd > selStart) {
+		IndexLocate(ed, buf, selStart, &ed->xSelStart, &ed->ySelStart);
+		IndexLocate(ed, buf, selEnd, &ed->xSelEnd, &ed->ySelEnd);
+	}
+	ed->xMax = IndexWidth(idx);
+	ed->yMax = (int)idx->n;
+
+	for (line = (ed->y > 0) ? ed->y : 0; line < idx->n; line++) {
+		const AG_EditableLine *L = IndexLine(idx, line);
+		const int lineEnd = (line+1 < idx->n) ? IndexPos(idx, line+1) :
+		                                        (int)buf->len;
+
+		y = paddingTop + ((int)line - ed->y)*lineSkip;
+		dy = WIDGET(ed)->rView.y1 + y;
+		if (dy >= clipY2) {
+			break;
+		}
+		if (dy < clipY1) {
+			continue;
+		}
+		cFg = (L->flags & AG_EDITABLE_LINE_FG) ? L->cFg : ts->color;
+		cBg = (L->flags & AG_EDITABLE_LINE_BG) ? L->cBg : ts->colorBG;
+		x = paddingLeft;
+
+		for (i = IndexPos(idx, line); i < lineEnd; i++) {
+			AG_Glyph *G;
+			AG_Char c = buf->s[i];
+			AG_Rect r;
+
+			selected = (selEnd > selStart &&
+			            i >= selStart && i < selEnd);
+			if (c == '\n') {
+				if (selected) {
+					AG_DrawLineV(ed, 1, y + lineSkip,
+					    y + (lineSkip << 1), cSel);
 				}
-			} else {
+				break;
+			} else if (c == '\t') {
 				if (selected) {
-					selected = 0;
-					ed->xSelEnd = x;
-					ed->ySelEnd = y/lineSkip + ed->y;
+					r.x = x - ed->x;
+					r.y = y;
+					r.w = agTextTabWidth + 1;
+					r.h = lineSkip + 1;
+					AG_DrawRectFilled(ed, &r, cSel);
+				}
+				x += agTextTabWidth;
+				continue;
+			} else if (c == 0x1b &&
+			    buf->s[i+1] >= 0x40 &&
+			    buf->s[i+1] <= 0x5f &&
+			    buf->s[i+2] != '\0') {
+				AG_TextANSI ansi;
+
+				if (AG_TextParseANSI(ts, &ansi, &buf->s[i+1]) == 0) {
+					if (ansi.ctrl == AG_ANSI_CSI_SGR) {
+						switch (ansi.sgr) {
+						case AG_SGR_RESET:
+						case AG_SGR_NO_FG_NO_BG:
+							cFg = ts->color;
+							cBg = ts->colorBG;
+							break;
+						case AG_SGR_FG:
+							cFg = ansi.color;
+							break;
+						case AG_SGR_BG:
+							cBg = ansi.color;
+							break;
+						default:
+							break;
+						}
+					}
+					i += ansi.len;
+					continue;
 				}
 			}
-		}
-		if (i == buf->len || c == '\0')
-			break;
 
-		if (WrapAtChar(ed, x, &buf->s[i], font, &cBg, &cFg)) {
-			y += lineSkip;
-			ed->xMax = MAX(ed->xMax, x);
-			ed->yMax++;
-			x = paddingLeft;
-		}
-		if (c == '\n') {
-			y += lineSkip;
-			if (selected) {
-				AG_DrawLineV(ed, 1, y, y+lineSkip, cSel);
+			if      (flags & AG_EDITABLE_PASSWORD)  { c = '*'; }
+			else if (flags & AG_EDITABLE_UPPERCASE) { c = toupper(c); }
+			else if (flags & AG_EDITABLE_LOWERCASE) { c = tolower(c); }
+
+			G = AG_TextRenderGlyph(drv, font, &cBg, &cFg, c);
+			dx = WIDGET(ed)->rView.x1 + x - ed->x;
+
+			if (dx < clipX1 || dx >= clipX2) {         /* Outside */
+				x += G->advance;
+				continue;
 			}
-			ed->xMax = MAX(ed->xMax, x+10);
-			ed->yMax++;
-			x = paddingLeft;
-			continue;
-		} else if (c == '\t') {
 			if (selected) {
 				r.x = x - ed->x;
-				r.y = y;
-				r.w = agTextTabWidth + 1;
-				r.h = lineSkip + 1;
+				r.y = y + 1;
+				r.w = G->su->w + 1;
+				r.h = G->su->h - 1;
 				AG_DrawRectFilled(ed, &r, cSel);
 			}
-			x += agTextTabWidth;
-			continue;
-		} else if (c == 0x1b &&
-		    buf->s[i+1] >= 0x40 &&
-		    buf->s[i+1] <= 0x5f &&
-		    buf->s[i+2] != '\0') {
-			AG_TextANSI ansi;
-			
-			if (AG_TextParseANSI(ts, &ansi, &buf->s[i+1]) == 0) {
-				if (ansi.ctrl == AG_ANSI_CSI_SGR) {
-					switch (ansi.sgr) {
-					case AG_SGR_RESET:
-					case AG_SGR_NO_FG_NO_BG:
-						cFg = ts->color;
-						cBg = ts->colorBG;
-						break;
-					case AG_SGR_FG:
-						cFg = ansi.color;
-						break;
-					case AG_SGR_BG:
-						cBg = ansi.color;
-						break;
-					case AG_SGR_BOLD:
-						break;
-					case AG_SGR_UNDERLINE:
-						break;
-					default:
-						break;
-					}
-				}
-				i += ansi.len;
-				continue;
-			}
-		}
-
-		if      (flags & AG_EDITABLE_PASSWORD)  { c = '*'; }
-		else if (flags & AG_EDITABLE_UPPERCASE) { c = toupper(c); }
-		else if (flags & AG_EDITABLE_LOWERCASE) { c = tolower(c); }
 
-		G = AG_TextRenderGlyph(drv, font, &cBg, &cFg, c);
-		dx = WIDGET(ed)->rView.x1 + x - ed->x;
-		dy = WIDGET(ed)->rView.y1 + y;
+			drvOps->drawGlyph(drv, G, dx,dy);
 
-		if (dx < clipX1 || dx >= clipX2 ||               /* Outside */
-		    dy < clipY1 || dy >= clipY2) {
 			x += G->advance;
-			continue;
 		}
-		if (selected) {
-			r.x = x - ed->x;
-			r.y = y + 1;
-			r.w = G->su->w + 1;
-			r.h = G->su->h - 1;
-			AG_DrawRectFilled(ed, &r, cSel);
-		}
-
-		drvOps->drawGlyph(drv, G, dx,dy);
-
-		x += G->advance;
 	}
-	if (ed->yMax == 1)
-		ed->xMax = x;
 	
 	/*
 	 * Draw the cursor.
@@ -1173,7 +1667,7 @@ Draw(void *_Nonnull obj)
 			ed->x = xScrollTo - WIDTH(ed) + 10;
 		}
 		ed->xScrollTo = NULL;
-		WIDGET(ed)->window->dirty = 1;
+		AG_Redraw(ed);
 	}
 	if (ed->yScrollTo != NULL) {                    /* Y scroll request */
 		const int yScrollTo = *ed->yScrollTo;
@@ -1188,7 +1682,7 @@ Draw(void *_Nonnull obj)
 				ed->y--;
 		}
 		ed->yScrollTo = NULL;
-		WIDGET(ed)->window->dirty = 1;
+		AG_Redraw(ed);
 	}
 	if (ed->xScrollPx != 0) {             /* X scroll request in pixels */
 		if (ed->xCurs < ed->x - ed->xScrollPx ||
@@ -1196,9 +1690,9 @@ Draw(void *_Nonnull obj)
 			ed->x += ed->xScrollPx;
 		}
 		ed->xScrollPx = 0;
-		WIDGET(ed)->window->dirty = 1;
+		AG_Redraw(ed);
 	}
-
+out:
 	AG_PopClipRect(ed);
 	AG_PopBlendingMode(ed);
 
@@ -1861,9 +2355,9 @@ AG_EditableClearHistory(AG_Editable *ed)
  * Create a new revision.
  * 
  * This function must be called *before* any modifications are made to
- * the buffer. Under Shared Access, a checksum of the buffer contents is
- * generated and recorded in the Undo/Redo stack. If any external changes
- * are detected then the Undo/Redo stack is invalidated.
+ * the buffer. Under Shared Access, if any external changes are detected
+ * (when the working buffer is acquired) then the Undo/Redo stack is
+ * invalidated.
  */
 AG_EditableRevision *
 AG_EditableBeginRevision(AG_Editable *ed, AG_EditableBuffer *buf)
@@ -1920,20 +2414,13 @@ AG_EditableCommitRevision(AG_Editable *ed, AG_EditableBuffer *buf)
 	if (rev->nCharsAdded == 0 && rev->nCharsRemoved == 0) {
 		ed->nUndo--;                                  /* No changes */
 	} else {
-		if (!(ed->flags & AG_EDITABLE_EXCL)) {
-			rev->crc32 = AG_GetCRC32(buf->s, (buf->len << 2));
-			rev->lenBuffer = buf->len;
+		rev->lenBuffer = buf->len;
 #ifdef DEBUG_UNDO
-			Debug(ed, "COMMIT Undo Rev#%d (crc=%x, lenBuffer=%u)\n",
-			    ed->nUndo - 1, rev->crc32, rev->lenBuffer);
+		Debug(ed, "COMMIT Undo Rev#%d (lenBuffer=%u)\n",
+		    ed->nUndo - 1, rev->lenBuffer);
 #endif
-		}
-#ifdef DEBUG_UNDO
-		else {
-			Debug(ed, "COMMIT Undo Rev#%d\n", ed->nUndo - 1);
-		}
-#endif
-
+		IndexEdit(ed, buf, rev->posStart, rev->nCharsRemoved,
+		    rev->nCharsAdded);
 	}
 }
 
@@ -1963,11 +2450,7 @@ AG_EditableRevert(AG_Editable *ed, AG_EditableBuffer *buf,
 		revUR->s = Malloc((nCharsAdded + 1)*sizeof(AG_Char));
 		memcpy(revUR->s, &buf->s[posStart], nCharsAdded*sizeof(AG_Char));
 		revUR->s[nCharsAdded] = '\0';
-
-		if (!(ed->flags & AG_EDITABLE_EXCL)) {
-			revUR->lenBuffer = rev->lenBuffer;
-			revUR->crc32 = rev->crc32;
-		}
+		revUR->lenBuffer = rev->lenBuffer;
 
 		if (posStart == (len - 1)) {
 			buf->s[len - nCharsAdded] = '\0';
@@ -1977,6 +2460,7 @@ AG_EditableRevert(AG_Editable *ed, AG_EditableBuffer *buf,
 		}
 		buf->len -= nCharsAdded;
 		ed->pos = posStart;
+		IndexEdit(ed, buf, posStart, nCharsAdded, 0);
 	} else if (nCharsRemoved > 0) {
 		if (AG_EditableGrowBuffer(ed, buf, rev->s, nCharsRemoved) == -1) {
 			Verbose("AG_EditableGrowBuffer: %s\n", AG_GetError());
@@ -1986,11 +2470,7 @@ AG_EditableRevert(AG_Editable *ed, AG_EditableBuffer *buf,
 		revUR->posStart = posStart;
 		revUR->posEnd = posEnd;
 		revUR->nCharsAdded = nCharsRemoved;
-
-		if (!(ed->flags & AG_EDITABLE_EXCL)) {
-			revUR->lenBuffer = rev->lenBuffer;
-			revUR->crc32 = rev->crc32;
-		}
+		revUR->lenBuffer = rev->lenBuffer;
 
 		if (posStart < len) {
 			memmove(&buf->s[posStart + nCharsRemoved],
@@ -2001,6 +2481,7 @@ AG_EditableRevert(AG_Editable *ed, AG_EditableBuffer *buf,
 		buf->len += nCharsRemoved;
 		buf->s[buf->len] = '\0';
 		ed->pos = posStart + nCharsRemoved;
+		IndexEdit(ed, buf, posStart, 0, nCharsRemoved);
 	}
 	ed->xScrollTo = &ed->xCurs;
 	ed->yScrollTo = &ed->yCurs;
@@ -2020,21 +2501,11 @@ AG_EditableUndo(AG_Editable *ed, AG_EditableBuffer *buf)
 #endif
 	revUndo = &ed->undo[ed->nUndo - 1];
 
-	if (!(ed->flags & AG_EDITABLE_EXCL)) {
-		Uint32 crc;
-
-		crc = AG_GetCRC32(buf->s, (buf->len << 2));
-		if (revUndo->lenBuffer != buf->len ||
-		    revUndo->crc32 != crc) {
-			Debug(ed,
-			    "Buffer changed externally (len %u->%lu, crc %x->%x). "
-			    "Clearing history.\n",
-			    revUndo->lenBuffer, (Ulong)buf->len,
-			    revUndo->crc32, crc);
-
-			AG_EditableClearHistory(ed);
-			return;
-		}
+	if (revUndo->lenBuffer != buf->len) {
+		Debug(ed, "Buffer length mismatch (%u->%lu). Clearing history.\n",
+		    revUndo->lenBuffer, (Ulong)buf->len);
+		AG_EditableClearHistory(ed);
+		return;
 	}
 
 	/* Record changes made by AG_EditableRevert() onto the Redo stack. */
@@ -2604,12 +3075,12 @@ PollHistoryBuffer(AG_Event *_Nonnull event)
 	for (i = 0; i < ed->nUndo; i++) {
 		rev = &ed->undo[i];
 		it = AG_TlistAdd(tl, agIconDown.s,
-		    _("%s" "Undo Level %d ([%d,%d] +%d -%d) crc(%x,%d)"),
+		    _("%s" "Undo Level %d ([%d,%d] +%d -%d) len(%d)"),
 		    (i == ed->nUndo - 1) ? ">" : "",
 		    i,
 		    rev->posStart, rev->posEnd,
 		    rev->nCharsAdded, rev->nCharsRemoved,
-		    rev->crc32, rev->lenBuffer);
+		    rev->lenBuffer);
 		it->depth = 0;
 		it->p1 = rev;
 	}
@@ -2621,12 +3092,12 @@ PollHistoryBuffer(AG_Event *_Nonnull event)
 	for (i = 0; i < ed->nRedo; i++) {
 		rev = &ed->redo[i];
 		it = AG_TlistAdd(tl, agIconUp.s,
-		    _("%s" "Redo Level %d ([%d,%d] +%d -%d) crc(%x,%d)"),
+		    _("%s" "Redo Level %d ([%d,%d] +%d -%d) len(%d)"),
 		    (i == ed->nRedo - 1) ? ">" : "",
 		    i,
 		    rev->posStart, rev->posEnd,
 		    rev->nCharsAdded, rev->nCharsRemoved,
-		    rev->crc32, rev->lenBuffer);
+		    rev->lenBuffer);
 		it->depth = 0;
 		it->p1 = rev;
 	}
@@ -2651,7 +3122,7 @@ MenuHistoryBuffer(AG_Event *_Nonnull event)
 
 	tl = AG_TlistNew(win, AG_TLIST_POLL | AG_TLIST_EXPAND);
 	AG_TlistSetRefresh(tl, 125);
-	AG_TlistSizeHint(tl, "<Undo Level 8888 ([8888,8888] +88 -88) crc(88888888)>", 25);
+	AG_TlistSizeHint(tl, "<Undo Level 8888 ([8888,8888] +88 -88) len(88888888)>", 25);
 	AG_SetEvent(tl, "tlist-poll", PollHistoryBuffer,"%p",ed);
 
 	AG_WindowSetCaption(win, _("%s - History Buffer"), OBJECT(ed)->name);
@@ -3023,7 +3494,10 @@ AG_EditableSetString(AG_Editable *ed, const char *text)
 		buf->s = sNew;
 		ed->pos = 0;
 		buf->len = 0;
+		buf->maxLen = sizeof(AG_Char);
 	}
+	IndexInvalidate(ed);
+	ed->lenConv = 0;
 	ed->selStart = 0;
 	ed->selEnd = 0;
 	CommitBuffer(ed, buf);
@@ -3145,7 +3619,9 @@ AG_EditableCatStringS(AG_Editable *ed, const char *s)
 		}
 		memcpy(&buf->s[buf->len], ucs, ucsLen*sizeof(AG_Char));
 		buf->len += ucsLen;
+		buf->s[buf->len] = '\0';
 		ed->pos += ucsLen;
+		IndexEdit(ed, buf, (int)(buf->len - ucsLen), 0, (int)ucsLen);
 		CommitBuffer(ed, buf);
 		ReleaseBuffer(ed, buf);
 		free(ucs);
@@ -3243,6 +3719,7 @@ OnBindingChange(AG_Event *_Nonnull event)
 	const AG_Variable *binding = AG_PTR(1);
 
 	AG_EditableClearHistory(ed);
+	InvalidateBuffer(ed);
 
 	/*
 	 * "string" and "text" bindings are mutually exclusive.
@@ -3318,6 +3795,11 @@ Init(void *_Nonnull obj)
 	ed->nRedo = 0;
 	ed->undo = Malloc(sizeof(AG_EditableRevision));
 	ed->redo = Malloc(sizeof(AG_EditableRevision));
+	memset(&ed->idx, 0, sizeof(AG_EditableIndex));
+	ed->pShared = NULL;
+	ed->lenShared = 0;
+	ed->hashShared = 0;
+	ed->lenConv = 0;
 
 	AG_AddEvent(ed, "font-changed", OnFontChange, NULL);
 	AG_AddEvent(ed, "widget-hidden", OnHide, NULL);
@@ -3343,8 +3825,8 @@ Destroy(void *_Nonnull obj)
 	if (ed->pm != NULL) {
 		AG_PopupDestroy(ed->pm);
 	}
-	if (ed->flags & AG_EDITABLE_EXCL)
-		Free(ed->sBuf.s);
+	Free(ed->sBuf.s);
+	Free(ed->idx.lines);
 
 	for (i = 0; i < ed->nUndo; i++) {
 		FreeRevision(&ed->undo[i]);
@@ -27,10 +27,39 @@ typedef struct ag_editable_buffer {
 	Uint32 _pad;
 } AG_EditableBuffer;
 
+/* Visual line (after word wrapping) in the line index */
+typedef struct ag_editable_line {
+	int pos;                         /* First char (or offset from end) */
+	int w;                           /* Width in pixels */
+	Uint flags;
+#define AG_EDITABLE_LINE_FG 0x01         /* cFg set by ANSI SGR */
+#define AG_EDITABLE_LINE_BG 0x02         /* cBg set by ANSI SGR */
+	Uint32 _pad;
+	AG_Color cFg;                    /* Foreground color at start of line */
+	AG_Color cBg;                    /* Background color at start of line */
+} AG_EditableLine;
+
+/*
+ * Index of the visual lines of the working buffer. Lines before the gap
+ * hold absolute positions and lines after the gap hold offsets from the
+ * end of the buffer, so that an edit only touches the lines near the gap.
+ */
+typedef struct ag_editable_index {
+	AG_EditableLine *_Nullable lines; /* Lines (with gap) */
+	Uint n;                           /* Number of lines (0 = invalid) */
+	Uint nMax;                        /* Allocated lines */
+	Uint gap;                         /* Index of gap */
+	int wMax;                         /* Widest line (or -1 = unknown) */
+	AG_Size len;                      /* Buffer length at last update */
+	AG_Font *_Nullable font;          /* Font used for layout */
+	int wWrap;                        /* Width used for word wrapping */
+	Uint flags;                       /* Editable flags used for layout */
+} AG_EditableIndex;
+
 /* Recorded modification for Undo/Redo */
 typedef struct ag_editable_revision {
 	Uint lenBuffer;                  /* Length of buffer (for Shared Access) */
-	Uint32 crc32;                    /* CRC32 of buffer (for Shared Access) */
+	Uint32 crc32;                    /* Unused */
 	int posStart;                    /* Start position (char index) */
 	int posEnd;                      /* End position (char index) */
 	int nCharsAdded;       	         /* Number of characters added */
@@ -105,7 +134,7 @@ typedef struct ag_editable {
 	int yVis;                            /* Maximum visible area (lines) */
 	int posKbdSel;                       /* Start of keyboard selection */
 	Uint32 _pad;
-	AG_EditableBuffer sBuf;              /* Working buffer (for Exclusive Access) */
+	AG_EditableBuffer sBuf;              /* Persistent working buffer */
 	AG_Rect r;                           /* Clipping rectangle */
 	AG_CursorArea *_Nullable ca;         /* Text cursor-change area */
 	enum ag_language lang;               /* Selected language (for AG_Text) */
@@ -126,6 +155,11 @@ typedef struct ag_editable {
 	Uint nRedo;                          /* Redo stack size */
 	AG_EditableRevision *_Nonnull undo;  /* Undo stack (History Buffer) */
 	AG_EditableRevision *_Nonnull redo;  /* Redo stack */
+	AG_EditableIndex idx;                /* Line index of sBuf */
+	const void *_Nullable pShared;       /* Last imported binding */
+	AG_Size lenShared;                   /* Length of last imported text */
+	Uint64 hashShared;                   /* Hash of last imported text */
+	AG_Size lenConv;                     /* Bound on exported length (or 0) */
 } AG_Editable;
 
 #define AGEDITABLE(obj)            ((AG_Editable *)(obj))
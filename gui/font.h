@@ -79,27 +79,63 @@ typedef struct ag_font_style_sort {
 } AG_FontStyleSort;
 
 /*
- * Cached rendering of a glyph of a given font and BG/FG color. This cache is
+ * Cached rendering of a glyph of a given font. Glyphs are rasterized once
+ * (white on transparent, so the alpha channel holds the coverage) into a
+ * shared atlas page, and colorized by the driver at draw time. This cache is
  * used by widgets which require per-glyph metrics such as AG_Editable(3).
- * For drivers which support hardware textures, the rendered glyph may be
- * associated with a generated texture and texture coordinates.
  */
 typedef struct ag_glyph {
 	struct ag_font *_Nonnull font;   /* Font face */
-	AG_Color colorBG;                /* Background color */
-	AG_Color color;                  /* Foreground color */
-	AG_Surface *_Nonnull su;         /* Rendered surface */
+	AG_Color colorBG;                /* Background color (for drawGlyph) */
+	AG_Color color;                  /* Foreground color (for drawGlyph) */
+	AG_Surface *_Nonnull su;         /* Rendering (view into atlas page) */
+	struct ag_glyph_page *_Nonnull page; /* Atlas page */
 	AG_Char ch;                      /* Native character */
 	int advance;                     /* Advance (px) */
-	Uint texture;                    /* Mapped texture (driver-specific) */
-	AG_TexCoord texcoords;           /* Mapped texture coordinates */
+	Uint flags;
+#define AG_GLYPH_COLORED 0x01            /* Pre-colored (not a coverage mask) */
+	int x, y;                        /* Position in atlas page */
+	AG_TexCoord texcoords;           /* Texture coordinates in atlas page */
 	Uint32 _pad1;
-	AG_SLIST_ENTRY(ag_glyph) glyphs; /* Entry in glyph cache */
+	AG_SLIST_ENTRY(ag_glyph) glyphs; /* Entry in glyph cache bucket */
+	AG_SLIST_ENTRY(ag_glyph) pglyphs; /* Entry in atlas page */
 } AG_Glyph;
 
+/* Atlas page size in pixels (must be a power of 2). */
+#ifndef AG_GLYPH_PAGE_SIZE
+#define AG_GLYPH_PAGE_SIZE 256
+#endif
+
+/* Default memory budget for the atlas pages of a glyph cache (bytes). */
+#ifndef AG_GLYPH_CACHE_BUDGET
+#define AG_GLYPH_CACHE_BUDGET (AG_MODEL * 0x10000)
+#endif
+
+/* Page of a glyph atlas. Glyphs are packed in horizontal shelves. */
+typedef struct ag_glyph_page {
+	AG_Surface *_Nonnull S;          /* Page surface */
+	Uint flags;
+#define AG_GLYPH_PAGE_DIRTY 0x01         /* Texture needs update */
+	Uint texture;                    /* Mapped texture (driver-specific) */
+	AG_TexCoord texcoords;           /* Mapped texture coordinates */
+	int xShelf, yShelf;              /* Insertion point (current shelf) */
+	int hShelf;                      /* Height of current shelf */
+	Uint nGlyphs;                    /* Number of glyphs in page */
+	AG_SLIST_HEAD_(ag_glyph) glyphs; /* Glyphs in page */
+	AG_TAILQ_ENTRY(ag_glyph_page) pages; /* Entry in LRU list */
+} AG_GlyphPage;
+
 /* Cache of rendered glyphs. Typically managed by an AG_Driver(3). */
 typedef struct ag_glyph_cache {
-	AG_SLIST_HEAD_(ag_glyph) glyphs; /* Cached glyph list */
+	AG_SLIST_HEAD_(ag_glyph) buckets[AG_GLYPH_NBUCKETS]; /* By font+char */
+	AG_TAILQ_HEAD(ag_glyph_pageq, ag_glyph_page) pages; /* Atlas pages (MRU first) */
+	AG_Size budget;                  /* Memory budget for pages (bytes) */
+	AG_Size size;                    /* Memory used by pages (bytes) */
+	Uint nPages;                     /* Number of atlas pages */
+	Uint nGlyphs;                    /* Number of cached glyphs */
+	Ulong nHits;                     /* Lookups found in cache */
+	Ulong nMisses;                   /* Lookups requiring rendering */
+	Ulong nEvictions;                /* Glyphs evicted to honor budget */
 } AG_GlyphCache;
 
 /* Loaded font */
@@ -208,6 +244,17 @@ int     AG_FontGetFamilyStyles(AG_Font *_Nonnull);
 AG_Size AG_FontGetStyleName(char *_Nonnull, AG_Size, Uint);
 Uint    AG_FontGetStyleByName(const char *_Nonnull);
 
+/*
+ * Return the alpha of a glyph pixel, given the coverage of its mask and the
+ * alpha of the foreground color. The product is computed in 32 bits so that
+ * opaque coverage of an opaque color yields exactly AG_OPAQUE.
+ */
+static __inline__ AG_Component
+AG_GlyphAlpha(AG_Component mask, AG_Component fg)
+{
+	return (AG_Component)(((Uint32)mask * (Uint32)fg) / AG_OPAQUE);
+}
+
 #ifdef AG_LEGACY
 #define AG_UnusedFont(font) /* unused */
 #endif
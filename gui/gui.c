@@ -231,6 +231,8 @@ AG_InitGUIGlobals(void)
 	AG_InitGlobalKeys();
 	AG_EditableInitClipboards();
 
+	AG_SurfaceInitKernels();
+
 	if ((agSurfaceFmt = TryMalloc(sizeof(AG_PixelFormat))) == NULL) {
 		return (-1);
 	}
@@ -307,6 +309,7 @@ AG_DestroyGUIGlobals(void)
 #ifndef __APPLE__ /* XXX mutex issue */
 	AG_ObjectDestroy(&agDrivers);
 #endif
+	AG_SurfaceScaleCacheClear();
 
 	AG_PixelFormatFree(agSurfaceFmt);
 	free(agSurfaceFmt);
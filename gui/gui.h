@@ -80,6 +80,7 @@ struct ag_window *_Nullable AG_DEV_Browser(void *_Nonnull);
 struct ag_window *_Nullable AG_DEV_ClassInfo(void);
 struct ag_window *_Nullable AG_DEV_FontInfo(void);
 #  ifdef AG_ENABLE_STRING
+struct ag_window *_Nullable AG_DEV_PerfMonitor(void);
 struct ag_window *_Nullable AG_DEV_TimerInspector(void);
 #  endif
 # endif
@@ -282,7 +282,6 @@ PostMouseButtonDown(AG_Window *_Nonnull win, AG_Widget *_Nonnull wid,
     int x, int y, AG_MouseButton button)
 {
 	AG_Widget *chld;
-	AG_Event *ev;
 	
 	AG_ObjectLock(wid);
 
@@ -303,11 +302,7 @@ PostMouseButtonDown(AG_Window *_Nonnull win, AG_Widget *_Nonnull wid,
 	            x - wid->rView.x1,
 	            y - wid->rView.y1);
 	} else {
-		TAILQ_FOREACH(ev, &OBJECT(wid)->events, events) {
-			if (strcmp(ev->name, "mouse-button-down") == 0)
-				break;
-		}
-		if (ev != NULL)
+		if (AG_FindEventHandler(wid, "mouse-button-down") != NULL)
 			AG_PostEvent(wid, "mouse-button-down",
 			    "%i(button),%i(x),%i(y)",
 			    (int)button,
@@ -112,7 +112,7 @@ AG_PixmapFromSurfaceScaled(void *parent, Uint flags, const AG_Surface *su,
 	AG_ObjectAttach(parent, px);
 
 	if (su != NULL) {
-		if ((suScaled = AG_SurfaceScale(su, w,h, 0)) == NULL) {
+		if ((suScaled = AG_SurfaceScale(su, w,h, AG_SCALE_BILINEAR)) == NULL) {
 			AG_FatalError(NULL);
 		}
 		AG_WidgetMapSurface(px, suScaled);
@@ -235,7 +235,7 @@ AG_PixmapAddSurfaceScaled(AG_Pixmap *px, const AG_Surface *Sorig,
 	AG_Surface *S = NULL;
 	int name;
 	
-	if ((S = AG_SurfaceScale(Sorig, w,h, 0)) == NULL)
+	if ((S = AG_SurfaceScale(Sorig, w,h, AG_SCALE_BILINEAR)) == NULL)
 		return (-1);
 
 	AG_OBJECT_ISA(px, "AG_Widget:AG_Pixmap:*");
@@ -396,7 +396,8 @@ UpdateScaled(AG_Pixmap *_Nonnull px)
 		goto fail;
 
 	Sorig = WSURFACE(px, px->n);
-	if ((S = AG_SurfaceScale(Sorig, WIDTH(px),HEIGHT(px), 0)) == NULL) {
+	if ((S = AG_SurfaceScale(Sorig, WIDTH(px),HEIGHT(px),
+	    AG_SCALE_BILINEAR)) == NULL) {
 		goto fail;
 	}
 	if (px->sScaled == -1) {
@@ -30,6 +30,7 @@
 #include <agar/core/core.h>
 #include <agar/core/config.h>
 #include <agar/gui/widget.h>
+#include <agar/gui/text.h>
 #include <agar/gui/style_data.h>
 
 #include <ctype.h>
@@ -47,6 +48,11 @@ void
 AG_InitStyleSheet(AG_StyleSheet *css)
 {
 	TAILQ_INIT(&css->blks);
+	css->classes = NULL;
+	css->nClasses = 0;
+	css->maxClasses = 0;
+	css->computed = NULL;
+	css->nComputed = 0;
 }
 
 void
@@ -65,9 +71,77 @@ AG_DestroyStyleSheet(AG_StyleSheet *css)
 			entNext = TAILQ_NEXT(ent, ents);
 			free(ent);
 		}
+		Free(blk->index);
 		free(blk);
 	}
 	TAILQ_INIT(&css->blks);
+
+	AG_StyleSheetClearComputed(css);
+	Free(css->computed);
+	css->computed = NULL;
+	Free(css->classes);
+	css->classes = NULL;
+	css->nClasses = 0;
+	css->maxClasses = 0;
+}
+
+/* Case-insensitive FNV-1a hash of an attribute name. */
+static __inline__ Uint32
+HashKey(const char *_Nonnull key)
+{
+	Uint32 h = 2166136261u;
+	const char *c;
+
+	for (c = key; *c != '\0'; c++) {
+		h ^= (Uint32)tolower((int)(unsigned char)*c);
+		h *= 16777619u;
+	}
+	return (h);
+}
+
+/* Hash of an object class pointer. */
+static __inline__ Uint32
+HashClass(const AG_ObjectClass *_Nonnull cls)
+{
+	AG_Size v = (AG_Size)cls;
+
+	v ^= (v >> 16);
+	return ((Uint32)v * 2654435761u);
+}
+
+/*
+ * Index the entries of a block by key hash. Where a key is repeated, the
+ * first entry takes precedence.
+ */
+static int
+CompileBlock(AG_StyleBlock *_Nonnull blk)
+{
+	AG_StyleEntry *ent;
+	Uint size, mask;
+
+	for (size = 8; size < (blk->nEnts << 1); size <<= 1)
+		;;
+	if ((blk->index = TryMalloc(size * sizeof(AG_StyleEntry *))) == NULL) {
+		return (-1);
+	}
+	memset(blk->index, 0, size * sizeof(AG_StyleEntry *));
+	blk->indexSize = size;
+	mask = size - 1;
+
+	TAILQ_FOREACH(ent, &blk->ents, ents) {
+		Uint i;
+
+		for (i = ent->hash & mask;
+		     blk->index[i] != NULL;
+		     i = (i+1) & mask) {
+			if (blk->index[i]->hash == ent->hash &&
+			    Strcasecmp(blk->index[i]->key, ent->key) == 0)
+				break;
+		}
+		if (blk->index[i] == NULL)
+			blk->index[i] = ent;
+	}
+	return (0);
 }
 
 /*
@@ -174,12 +248,18 @@ AG_LoadStyleSheet(void *obj, const char *path)
 			}
 			Strlcpy(cssBlk->match, c, sizeof(cssBlk->match));
 			TAILQ_INIT(&cssBlk->ents);
+			cssBlk->index = NULL;
+			cssBlk->indexSize = 0;
+			cssBlk->nEnts = 0;
 			continue;
 		} else if (strchr(c, '}') != NULL) {
 			if (cssBlk == NULL) {
 				AG_SetError(_("Unmatched block terminator `}'"));
 				goto fail_parse;
 			}
+			if (CompileBlock(cssBlk) == -1) {
+				goto fail_parse;
+			}
 			TAILQ_INSERT_TAIL(&css->blks, cssBlk, blks);
 			cssBlk = NULL;
 			continue;
@@ -211,6 +291,8 @@ AG_LoadStyleSheet(void *obj, const char *path)
 		}
 		Strlcpy(cssEnt->key, cKey, sizeof(cssEnt->key));
 		Strlcpy(cssEnt->value, cVal, sizeof(cssEnt->value));
+		cssEnt->hash = HashKey(cssEnt->key);
+		cssEnt->_pad = 0;
 		if ((cEp = strchr(cssEnt->value, ';')) != NULL) {
 			*cEp = '\0';
 		}
@@ -225,6 +307,7 @@ AG_LoadStyleSheet(void *obj, const char *path)
 		    cssEnt->key, cssEnt->value);
 #endif
 		TAILQ_INSERT_TAIL(&cssBlk->ents, cssEnt, ents);
+		cssBlk->nEnts++;
 	}
 
 	free(buf);
@@ -242,52 +325,195 @@ fail_parse:
 	return (NULL);
 }
 
-/* Lookup a style sheet entry. */
-int
-AG_LookupStyleSheet(AG_StyleSheet *_Nonnull css, void *_Nonnull obj,
-    const char *_Nonnull key, char *_Nonnull *_Nonnull rv)
+/*
+ * Find the block applicable to an object class. Match an exact class ID,
+ * then a general class hierarchy pattern and then a short class name.
+ */
+static AG_StyleBlock *_Nullable
+MatchClass(AG_StyleSheet *_Nonnull css, void *_Nonnull obj)
 {
 	AG_ObjectClass **hier;
 	AG_StyleBlock *blk;
-	AG_StyleEntry *ent;
 	int nHier;
 
 	if (AG_ObjectGetInheritHier(obj, &hier, &nHier) != 0)
-		return (0);
+		return (NULL);
 
-	/* Match an exact class ID */
 	TAILQ_FOREACH(blk, &css->blks, blks) {
 		if (Strcasecmp(blk->match, AGOBJECT_CLASS(obj)->hier) == 0)
 			break;
 	}
 	if (blk == NULL) {
-		/* Match a general class hierarchy pattern */
 		TAILQ_FOREACH(blk, &css->blks, blks) {
 			if (AG_OfClass(obj, blk->match))
 				break;
 		}
 		if (blk == NULL) {
-			/* Match a short class name */
 			TAILQ_FOREACH(blk, &css->blks, blks) {
 				if (Strcasecmp(hier[nHier-1]->name, blk->match) == 0)
 					break;
 			}
- 			if (blk == NULL)
-				goto fail;
 		}
 	}
-	TAILQ_FOREACH(ent, &blk->ents, ents) {
-		if (Strcasecmp(ent->key, key) == 0) {
+	free(hier);
+	return (blk);
+}
+
+/* Return the block for the class of obj, compiling the class index as needed. */
+static AG_StyleBlock *_Nullable
+LookupClass(AG_StyleSheet *_Nonnull css, void *_Nonnull obj)
+{
+	const AG_ObjectClass *cls = AGOBJECT_CLASS(obj);
+	AG_StyleClassEnt *ce;
+	Uint i, mask;
+
+	if (css->maxClasses > 0) {
+		mask = css->maxClasses - 1;
+		for (i = HashClass(cls) & mask;
+		     css->classes[i].cls != NULL;
+		     i = (i+1) & mask) {
+			if (css->classes[i].cls == cls)
+				return (css->classes[i].blk);
+		}
+	}
+	if ((css->nClasses+1) << 1 > css->maxClasses) {     /* Grow the index */
+		AG_StyleClassEnt *classesNew;
+		Uint maxNew = (css->maxClasses > 0) ? css->maxClasses << 1 : 64;
+		Uint j;
+
+		classesNew = TryMalloc(maxNew * sizeof(AG_StyleClassEnt));
+		if (classesNew == NULL) {
+			return MatchClass(css, obj);
+		}
+		memset(classesNew, 0, maxNew * sizeof(AG_StyleClassEnt));
+		mask = maxNew - 1;
+		for (j = 0; j < css->maxClasses; j++) {
+			const AG_StyleClassEnt *ceOld = &css->classes[j];
+
+			if (ceOld->cls == NULL) {
+				continue;
+			}
+			for (i = HashClass(ceOld->cls) & mask;
+			     classesNew[i].cls != NULL;
+			     i = (i+1) & mask)
+				;;
+			classesNew[i] = *ceOld;
+		}
+		Free(css->classes);
+		css->classes = classesNew;
+		css->maxClasses = maxNew;
+	}
+	mask = css->maxClasses - 1;
+	for (i = HashClass(cls) & mask;
+	     css->classes[i].cls != NULL;
+	     i = (i+1) & mask)
+		;;
+	ce = &css->classes[i];
+	ce->cls = cls;
+	ce->blk = MatchClass(css, obj);
+	css->nClasses++;
+	return (ce->blk);
+}
+
+/* Lookup a style sheet entry. */
+int
+AG_LookupStyleSheet(AG_StyleSheet *_Nonnull css, void *_Nonnull obj,
+    const char *_Nonnull key, char *_Nonnull *_Nonnull rv)
+{
+	AG_StyleBlock *blk;
+	AG_StyleEntry *ent;
+	Uint32 hash;
+	Uint i, mask;
+	int found = 0;
+
+	AG_MutexLock(&agTextLock);
+
+	if ((blk = LookupClass(css, obj)) == NULL ||
+	    blk->indexSize == 0) {
+		goto out;
+	}
+	hash = HashKey(key);
+	mask = blk->indexSize - 1;
+	for (i = hash & mask;
+	     (ent = blk->index[i]) != NULL;
+	     i = (i+1) & mask) {
+		if (ent->hash == hash && Strcasecmp(ent->key, key) == 0) {
 			*rv = ent->value;
+			found = 1;
 			break;
 		}
 	}
-	if (ent == NULL) {
-		goto fail;
+out:
+	AG_MutexUnlock(&agTextLock);
+	return (found);
+}
+
+/*
+ * Return the first cached computed style in the hash bucket of the given
+ * hash (following entries are linked through next). The caller must compare
+ * the entries against its own key and should use agTextLock.
+ */
+AG_StyleComputed *
+AG_StyleSheetGetComputed(AG_StyleSheet *css, Uint32 hash)
+{
+	AG_StyleComputed *sc;
+
+	if (css->computed == NULL) {
+		return (NULL);
 	}
-	free(hier);
-	return (1);
-fail:
-	free(hier);
-	return (0);
+	for (sc = css->computed[hash % AG_STYLE_COMPUTED_BUCKETS];
+	     sc != NULL;
+	     sc = sc->next) {
+		if (sc->hash == hash)
+			break;
+	}
+	return (sc);
+}
+
+/*
+ * Insert a computed style into the cache. The stylesheet takes ownership
+ * of the (malloc'd) entry. If the cache is full, the existing entries are
+ * discarded first.
+ */
+void
+AG_StyleSheetAddComputed(AG_StyleSheet *css, AG_StyleComputed *scNew)
+{
+	AG_StyleComputed **bucket;
+
+	if (css->computed == NULL) {
+		css->computed = TryMalloc(AG_STYLE_COMPUTED_BUCKETS *
+		                          sizeof(AG_StyleComputed *));
+		if (css->computed == NULL) {
+			free(scNew);
+			return;
+		}
+		memset(css->computed, 0, AG_STYLE_COMPUTED_BUCKETS *
+		                         sizeof(AG_StyleComputed *));
+	} else if (css->nComputed >= AG_STYLE_COMPUTED_MAX) {
+		AG_StyleSheetClearComputed(css);
+	}
+	bucket = &css->computed[scNew->hash % AG_STYLE_COMPUTED_BUCKETS];
+	scNew->next = *bucket;
+	*bucket = scNew;
+	css->nComputed++;
+}
+
+/* Discard all cached computed styles. */
+void
+AG_StyleSheetClearComputed(AG_StyleSheet *css)
+{
+	AG_StyleComputed *sc, *scNext;
+	int i;
+
+	if (css->computed == NULL) {
+		return;
+	}
+	for (i = 0; i < AG_STYLE_COMPUTED_BUCKETS; i++) {
+		for (sc = css->computed[i]; sc != NULL; sc = scNext) {
+			scNext = sc->next;
+			free(sc);
+		}
+		css->computed[i] = NULL;
+	}
+	css->nComputed = 0;
 }
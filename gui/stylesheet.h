@@ -7,21 +7,54 @@
 #ifndef AG_STYLE_VALUE_MAX
 #define AG_STYLE_VALUE_MAX (AG_MODEL*2 + 4)
 #endif
+#ifndef AG_STYLE_COMPUTED_BUCKETS
+#define AG_STYLE_COMPUTED_BUCKETS 256	/* Computed style hash buckets */
+#endif
+#ifndef AG_STYLE_COMPUTED_MAX
+#define AG_STYLE_COMPUTED_MAX 1024	/* Computed styles cached per sheet */
+#endif
 
 typedef struct ag_style_entry {
 	char key[AG_VARIABLE_NAME_MAX];			/* Target parameter */
 	char value[AG_STYLE_VALUE_MAX];			/* Set value */
+	Uint32 hash;					/* Hash of key */
+	Uint32 _pad;
 	AG_TAILQ_ENTRY(ag_style_entry) ents;
 } AG_StyleEntry;
 
 typedef struct ag_style_block {
 	char match[64];					/* Pattern */
 	AG_TAILQ_HEAD_(ag_style_entry) ents;		/* Entries in block */
+	AG_StyleEntry *_Nullable *_Nullable index;	/* Entries by key hash */
+	Uint indexSize;					/* Slots (power of 2) */
+	Uint nEnts;					/* Entry count */
 	AG_TAILQ_ENTRY(ag_style_block) blks;
 } AG_StyleBlock;
 
+/* Block matching a given object class (compiled on first use). */
+typedef struct ag_style_class_ent {
+	const AG_ObjectClass *_Nullable cls;		/* Object class */
+	AG_StyleBlock *_Nullable blk;			/* Matching block */
+} AG_StyleClassEnt;
+
+/*
+ * Header of a cached computed style. The style compiler of AG_Widget(3)
+ * extends this structure with the inherited and resulting attributes.
+ */
+typedef struct ag_style_computed {
+	struct ag_style_computed *_Nullable next;	/* In hash bucket */
+	const AG_ObjectClass *_Nonnull cls;		/* Widget class */
+	Uint32 hash;					/* Of class and inputs */
+	Uint32 _pad;
+} AG_StyleComputed;
+
 typedef struct ag_style_sheet {
 	AG_TAILQ_HEAD_(ag_style_block) blks;		/* By widget class */
+	AG_StyleClassEnt *_Nullable classes;		/* Blocks by class */
+	Uint nClasses, maxClasses;
+	AG_StyleComputed *_Nullable *_Nullable computed; /* Computed styles */
+	Uint nComputed;
+	Uint32 _pad;
 } AG_StyleSheet;
 
 /* Built-in Agar stylesheet */
@@ -49,6 +82,12 @@ int                      AG_LookupStyleSheet(AG_StyleSheet *_Nonnull,
                                              void *_Nonnull,
 					     const char *_Nonnull,
 					     char *_Nonnull *_Nonnull);
+
+AG_StyleComputed *_Nullable AG_StyleSheetGetComputed(AG_StyleSheet *_Nonnull,
+                                                     Uint32);
+void                        AG_StyleSheetAddComputed(AG_StyleSheet *_Nonnull,
+                                                     AG_StyleComputed *_Nonnull);
+void                        AG_StyleSheetClearComputed(AG_StyleSheet *_Nonnull);
 __END_DECLS
 
 #include <agar/gui/close.h>
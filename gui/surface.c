@@ -71,6 +71,16 @@ enum ag_grayscale_mode agGrayscaleMode = AG_GRAYSCALE_BT709;
 /* Import agExpandByte8[] lookup table (expand partial bytes to 0..255) */
 #include "expand_byte8.h"
 
+/* Surface rows may be accessed as arrays of Uint32 by the pixel kernels. */
+#define ALIGNED32(S) ((S)->format.BitsPerPixel == 32 &&                 \
+                      ((AG_Size)(S)->pixels & 3) == 0 &&               \
+                      ((S)->pitch & 3) == 0)
+
+static int GetConvert32(const AG_Surface *_Nonnull, const AG_Surface *_Nonnull,
+                        Sint8 *_Nonnull, Uint32 *_Nonnull, int *_Nonnull);
+static int LowerBlit32(const AG_Surface *_Nonnull, const AG_Rect *_Nonnull,
+                       AG_Surface *_Nonnull, const AG_Rect *_Nonnull);
+
 /*
  * Compute right shifts to extract RGBA components, as well as the
  * number of bits lost by packing components into our native fields
@@ -667,8 +677,15 @@ AG_SurfaceSetPixels(AG_Surface *S, const AG_Color *c)
 		Debug(NULL, "Surface <%p>: SetPixels(%x%x%x%x)\n", S,
 		    c->r, c->g, c->b, c->a);
 #endif
-	/* TODO optimized cases */
 	px = AG_MapPixel(&S->format, c);
+	if (ALIGNED32(S)) {
+		for (y = 0; y < S->h; y++) {
+			agSurfaceKernels->fill32(
+			    (Uint32 *)(S->pixels + y*S->pitch), S->w,
+			    (Uint32)px);
+		}
+		return;
+	}
 	for (y = 0; y < S->h; y++) {
 		for (x = 0; x < S->w; x++)
 			AG_SurfacePut(S, x,y, px);
@@ -726,7 +743,9 @@ AG_SurfaceCopy(AG_Surface *D, const AG_Surface *S)
 {
 	const Uint w = MIN(S->w, D->w);   /* Width to copy */
 	const Uint h = MIN(S->h, D->h);   /* Height to copy */
-	int x, y;
+	Sint8 map[4];
+	Uint32 set;
+	int x, y, aByte;
 
 #ifdef DEBUG_SURFACE
 	if (S->flags & AG_SURFACE_TRACE) {
@@ -764,13 +783,23 @@ AG_SurfaceCopy(AG_Surface *D, const AG_Surface *S)
 			pSrc += pitch + Spadding;
 			pDst += pitch + Dpadding;
 		}
+	} else if (GetConvert32(S, D, map, &set, &aByte) == 0) {  /* Kernel */
+#ifdef DEBUG_SURFACE
+		if (S->flags & AG_SURFACE_TRACE)
+			Debug(NULL, "Surface <%p>: Convert32 Copy\n", S);
+#endif
+		for (y = 0; y < h; y++) {
+			agSurfaceKernels->convert32(
+			    (Uint32 *)(D->pixels + y*D->pitch),
+			    (const Uint32 *)(S->pixels + y*S->pitch), w,
+			    map, set);
+		}
 	} else {                                                 /* Pixelwise */
 		Uint8 *pSrc, *pDst;
 #ifdef DEBUG_SURFACE
 		if (S->flags & AG_SURFACE_TRACE)
 			Debug(NULL, "Surface <%p>: Pixelwise Copy\n", S);
 #endif
-		/* TODO optimized conversion cases */
 		pSrc = S->pixels;
 		pDst = D->pixels;
 		for (y = 0; y < h; y++) {
@@ -795,6 +824,109 @@ AG_SurfaceCopy(AG_Surface *D, const AG_Surface *S)
 		AG_SurfaceSetPalette(D, S->format.palette);
 }
 
+/*
+ * If S and D are packed 32-bit surfaces usable with AG_SurfaceKernels, return
+ * the component map and constant bits for converting pixels from S to D, as
+ * well as the byte position of the alpha component of D (or -1).
+ */
+static int
+GetConvert32(const AG_Surface *S, const AG_Surface *D, Sint8 *map,
+    Uint32 *set, int *aByte)
+{
+	Sint8 iS[4], iD[4];
+	int i;
+
+	if (!ALIGNED32(S) || !ALIGNED32(D) ||
+	    AG_PixelFormatBytes32(&S->format, iS) == -1 ||
+	    AG_PixelFormatBytes32(&D->format, iD) == -1) {
+		return (-1);
+	}
+	map[0] = map[1] = map[2] = map[3] = -1;
+	*set = 0;
+	for (i = 0; i < 4; i++) {
+		if (iD[i] == -1) {
+			continue;
+		}
+		if (iS[i] == -1) {
+			*set |= 0xffU << (iD[i] << 3);        /* Opaque */
+		} else {
+			map[iD[i]] = iS[i];
+		}
+	}
+	*aByte = iD[3];
+	return (0);
+}
+
+/*
+ * Lower blit between packed 32-bit surfaces using the AG_SurfaceKernels.
+ * Return -1 if the blit must be performed pixelwise.
+ */
+static int
+LowerBlit32(const AG_Surface *S, const AG_Rect *rSrc, AG_Surface *D,
+    const AG_Rect *rDst)
+{
+	const AG_SurfaceKernels *K = agSurfaceKernels;
+	Uint32 buf[256];
+	Uint32 set;
+	Sint8 map[4];
+	Uint8 aMax = 0xff;
+	const int w = rDst->w;
+	int x, y, aByte, same, blend;
+
+	if (GetConvert32(S, D, map, &set, &aByte) == -1) {
+		return (-1);
+	}
+	same = (AG_PixelFormatCompare(&S->format, &D->format) == 0);
+
+	if (S->flags & AG_SURFACE_COLORKEY) {
+		if (S->alpha < AG_OPAQUE || S->format.Amask != 0 || !same) {
+			return (-1);
+		}
+		for (y = 0; y < rDst->h; y++) {
+			K->colorkey32(
+			    (Uint32 *)(D->pixels + (rDst->y + y)*D->pitch) +
+			    rDst->x,
+			    (const Uint32 *)(S->pixels + (rSrc->y + y)*S->pitch) +
+			    rSrc->x,
+			    w, (Uint32)S->colorkey);
+		}
+		return (0);
+	}
+	if (S->alpha < AG_OPAQUE) {
+		aMax = AG_Hto8(S->alpha);
+		blend = 1;
+	} else {
+		blend = (S->format.Amask != 0);
+	}
+	if (blend && (aByte == -1 || (D->flags & AG_SURFACE_COLORKEY)))
+		return (-1);
+
+	for (y = 0; y < rDst->h; y++) {
+		const Uint32 *pSrc = (const Uint32 *)(S->pixels +
+		                     (rSrc->y + y)*S->pitch) + rSrc->x;
+		Uint32 *pDst = (Uint32 *)(D->pixels +
+		               (rDst->y + y)*D->pitch) + rDst->x;
+
+		if (!blend) {
+			if (same) {
+				K->copy32(pDst, pSrc, w);
+			} else {
+				K->convert32(pDst, pSrc, w, map, set);
+			}
+		} else if (same && S->format.Amask != 0) {
+			K->blend32(pDst, pSrc, w, aByte, aMax);
+		} else {
+			for (x = 0; x < w; x += 256) {
+				const Uint n = MIN(w - x, 256);
+
+				K->convert32(buf, &pSrc[x], n, map, set);
+				K->blend32(&pDst[x], buf, n, aByte, aMax);
+			}
+		}
+	}
+	return (0);
+}
+
 /* General lower blit with non-opaque per-surface alpha and colorkey. */
 void
 AG_LowerBlit_AlCo(const AG_Surface *S, const AG_Rect *rSrc, AG_Surface *D,
@@ -848,6 +980,9 @@ AG_LowerBlit_Al(const AG_Surface *S, const AG_Rect *rSrc, AG_Surface *D,
 	Uint8 *pDst;
 	int x, y;
 
+	if (LowerBlit32(S, rSrc, D, rDst) == 0)
+		return;
+
 	for (y = 0; y < rDst->h; y++) {
 		pSrc = S->pixels + ((rSrc->y + y) * S->pitch) +
 		                    (rSrc->x * S->format.BytesPerPixel);
@@ -889,6 +1024,9 @@ AG_LowerBlit_Co(const AG_Surface *S, const AG_Rect *rSrc, AG_Surface *D,
 	if (S->flags & AG_SURFACE_TRACE)
 		Debug(NULL, "Surface <%p>: Blit with Colorkey only\n", S);
 #endif
+	if (LowerBlit32(S, rSrc, D, rDst) == 0) {
+		return;
+	}
 	for (y = 0; y < h; y++) {
 		pSrc = S->pixels + ((rSrc->y + y) * S->pitch) +
 		                    (rSrc->x * S->format.BytesPerPixel);
@@ -916,7 +1054,7 @@ AG_LowerBlit_Co(const AG_Surface *S, const AG_Rect *rSrc, AG_Surface *D,
 			}
 next_pixel:
 			pSrc += S->format.BytesPerPixel;
-			pDst += S->format.BytesPerPixel;
+			pDst += D->format.BytesPerPixel;
 		}
 		pSrc += S->padding;
 		pDst += D->padding;
@@ -1012,6 +1150,9 @@ AG_SurfaceBlit(const AG_Surface *S, const AG_Rect *srcRect, AG_Surface *D,
 		AG_LowerBlit_Co(S, &rSrc, D, &rDst);
 		return;
 	}
+	if (LowerBlit32(S, &rSrc, D, &rDst) == 0)
+		return;
+
 
 	if (S->format.Amask != 0) {
 		/*
@@ -1130,6 +1271,9 @@ AG_SurfaceFree(AG_Surface *S)
 	if (S->flags & AG_SURFACE_TRACE)
 		Debug(NULL, "Surface <%p>: Free (flags=0x%x)\n", S, S->flags);
 #endif
+	if (S->flags & AG_SURFACE_SCALE_CACHED) {
+		AG_SurfaceScaleCacheInvalidate(S);
+	}
 	AG_PixelFormatFree(&S->format);
 
 	if (S->flags & AG_SURFACE_ANIMATED) {
@@ -1160,51 +1304,6 @@ AG_SurfaceFree(AG_Surface *S)
 		free(S);
 }
 
-/*
- * Scale a surface to size w x h.
- * TODO optimized cases; filtering
- * TODO integer-only version
- */
-AG_Surface *
-AG_SurfaceScale(const AG_Surface *S, Uint w, Uint h, Uint flags)
-{
-	AG_Surface *D;
-	float xf,yf;
-	int x,y;
-
-#ifdef DEBUG_SURFACE
-	if (S->flags & AG_SURFACE_TRACE)
-		Debug(NULL, "Surface <%p>: Resize(%ux%u->%ux%u, 0x%x)\n",
-		    S, S->w, S->h, w,h, flags);
-#endif
-	if (S->format.mode == AG_SURFACE_INDEXED &&
-	    S->format.BitsPerPixel < 8 &&
-	    S->w < S->format.BitsPerPixel)
-		AG_FatalError("(1,2,4)bpp surfaces must be "
-		              "at least >=(8,4,2) pixels wide");
-
-	D = AG_SurfaceNew(&S->format, w,h, S->flags & AG_SAVED_SURFACE_FLAGS);
-	D->colorkey = S->colorkey;
-	D->alpha = S->alpha;
-
-	if (S->w == w && S->h == h) {			/* Simple copy */
-		AG_SurfaceCopy(D, S);
-		return (D);
-	}
-
-	xf = (float)(S->w - 1) / (float)(D->w - 1);
-	yf = (float)(S->h - 1) / (float)(D->h - 1);
-
-	for (y = 0; y < D->h; y++) {
-		for (x = 0; x < D->w; x++) {
-			AG_SurfacePut(D, x,y, AG_SurfaceGet(S, 
-			    (int)((float)x * xf),
-			    (int)((float)y * yf)));
-		}
-	}
-	return (D);
-}
-
 /* Fill a rectangle with pixels of a given color. */
 void
 AG_FillRect(AG_Surface *S, const AG_Rect *rDst, const AG_Color *c)
@@ -1214,8 +1313,6 @@ AG_FillRect(AG_Surface *S, const AG_Rect *rDst, const AG_Color *c)
 	int x,y;
 
 	if (rDst != NULL) {
-		const int cx = S->clipRect.x, cx2 = S->clipRect.x+S->clipRect.w;
-		const int cy = S->clipRect.y, cy2 = S->clipRect.y+S->clipRect.h;
 #ifdef DEBUG_SURFACE
 		if (S->flags & AG_SURFACE_TRACE)
 			Debug(NULL, "Surface <%p>: "
@@ -1223,11 +1320,8 @@ AG_FillRect(AG_Surface *S, const AG_Rect *rDst, const AG_Color *c)
 			    S, rDst->w, rDst->h, rDst->x, rDst->y,
 			    c->r, c->g, c->b, c->a);
 #endif
-		r = *rDst;
-		if (r.x < cx)       { r.x = cx; }
-		if (r.y < cy)       { r.y = cy; }
-		if (r.x+r.w >= cx2) { r.w = cx2-r.x; }
-		if (r.y+r.h >= cy2) { r.h = cy2-r.y; }
+		if (!AG_RectIntersect(&r, rDst, &S->clipRect))
+			return;
 	} else {
 #ifdef DEBUG_SURFACE
 		if (S->flags & AG_SURFACE_TRACE)
@@ -1238,9 +1332,16 @@ AG_FillRect(AG_Surface *S, const AG_Rect *rDst, const AG_Color *c)
 	}
 	px = AG_MapPixel(&S->format, c);
 
-	/* XXX TODO optimized cases */
-	for (y = r.y; y < r.h; y++)
-		for (x = r.x; x < r.w; x++)
+	if (ALIGNED32(S)) {
+		for (y = r.y; y < r.y + r.h; y++) {
+			agSurfaceKernels->fill32(
+			    (Uint32 *)(S->pixels + y*S->pitch) + r.x, r.w,
+			    (Uint32)px);
+		}
+		return;
+	}
+	for (y = r.y; y < r.y + r.h; y++)
+		for (x = r.x; x < r.x + r.w; x++)
 			AG_SurfacePut(S, x, y, px);
 }
 
@@ -1344,6 +1445,18 @@ AG_SurfacePut8(AG_Surface *_Nonnull S, int x, int y, Uint8 px)
  * Functions for mapping RGBA components to encoded pixel data.
  */
 
+/*
+ * Scale an 8- or 16-bit component to the width of a packed field. The
+ * component losses are relative to AG_COMPONENT_BITS.
+ */
+#if AG_MODEL == AG_LARGE
+# define PACK_COMPONENT8(c, loss)  (((((Uint32)(c)) << 8) | (c)) >> (loss))
+# define PACK_COMPONENT16(c, loss) (((Uint32)(c)) >> (loss))
+#else
+# define PACK_COMPONENT8(c, loss)  (((Uint32)(c)) >> (loss))
+# define PACK_COMPONENT16(c, loss) (((Uint32)AG_16to8(c)) >> (loss))
+#endif
+
 /* Map 8-bit RGB components to an opaque 32-bit pixel. */
 Uint32
 AG_MapPixel32_RGB8(const AG_PixelFormat *pf, Uint8 r, Uint8 g, Uint8 b)
@@ -1351,10 +1464,11 @@ AG_MapPixel32_RGB8(const AG_PixelFormat *pf, Uint8 r, Uint8 g, Uint8 b)
 	switch (pf->mode) {
 	case AG_SURFACE_PACKED:
 	default:
-		return (r    >> pf->Rloss) << pf->Rshift |
-		       (g    >> pf->Gloss) << pf->Gshift |
-		       (b    >> pf->Bloss) << pf->Bshift |
-		      ((0xff >> pf->Aloss) << pf->Ashift & (Uint32)pf->Amask);
+		return PACK_COMPONENT8(r,    pf->Rloss) << pf->Rshift |
+		       PACK_COMPONENT8(g,    pf->Gloss) << pf->Gshift |
+		       PACK_COMPONENT8(b,    pf->Bloss) << pf->Bshift |
+		      (PACK_COMPONENT8(0xff, pf->Aloss) << pf->Ashift &
+		       (Uint32)pf->Amask);
 	case AG_SURFACE_INDEXED:
 		return AG_MapPixelIndexed(pf,
 		    AG_8toH(r),
@@ -1377,10 +1491,11 @@ AG_MapPixel32_RGBA8(const AG_PixelFormat *pf, Uint8 r, Uint8 g, Uint8 b, Uint8 a
 	switch (pf->mode) {
 	case AG_SURFACE_PACKED:
 	default:
-		return (r >> pf->Rloss) << pf->Rshift |
-		       (g >> pf->Gloss) << pf->Gshift |
-		       (b >> pf->Bloss) << pf->Bshift |
-		      ((a >> pf->Aloss) << pf->Ashift & (Uint32)pf->Amask);
+		return PACK_COMPONENT8(r, pf->Rloss) << pf->Rshift |
+		       PACK_COMPONENT8(g, pf->Gloss) << pf->Gshift |
+		       PACK_COMPONENT8(b, pf->Bloss) << pf->Bshift |
+		      (PACK_COMPONENT8(a, pf->Aloss) << pf->Ashift &
+		       (Uint32)pf->Amask);
 	case AG_SURFACE_INDEXED:
 		return AG_MapPixelIndexed(pf,
 		    AG_8toH(r),
@@ -1403,10 +1518,11 @@ AG_MapPixel32_RGB16(const AG_PixelFormat *pf, Uint16 r, Uint16 g, Uint16 b)
 	switch (pf->mode) {
 	case AG_SURFACE_PACKED:
 	default:
-		return (AG_16to8(r) >> pf->Rloss) << pf->Rshift |
-		       (AG_16to8(g) >> pf->Gloss) << pf->Gshift |
-		       (AG_16to8(b) >> pf->Bloss) << pf->Bshift |
-		      ((0xff        >> pf->Aloss) << pf->Ashift & (Uint32)pf->Amask);
+		return PACK_COMPONENT16(r,      pf->Rloss) << pf->Rshift |
+		       PACK_COMPONENT16(g,      pf->Gloss) << pf->Gshift |
+		       PACK_COMPONENT16(b,      pf->Bloss) << pf->Bshift |
+		      (PACK_COMPONENT16(0xffff, pf->Aloss) << pf->Ashift &
+		       (Uint32)pf->Amask);
 	case AG_SURFACE_INDEXED:
 		return AG_MapPixelIndexed(pf,
 		    AG_16toH(r),
@@ -1430,10 +1546,11 @@ AG_MapPixel32_RGBA16(const AG_PixelFormat *pf, Uint16 r, Uint16 g, Uint16 b,
 	switch (pf->mode) {
 	case AG_SURFACE_PACKED:
 	default:
-		return (AG_16to8(r) >> pf->Rloss) << pf->Rshift |
-		       (AG_16to8(g) >> pf->Gloss) << pf->Gshift |
-		       (AG_16to8(b) >> pf->Bloss) << pf->Bshift |
-		      ((AG_16to8(a) >> pf->Aloss) << pf->Ashift & (Uint32)pf->Amask);
+		return PACK_COMPONENT16(r, pf->Rloss) << pf->Rshift |
+		       PACK_COMPONENT16(g, pf->Gloss) << pf->Gshift |
+		       PACK_COMPONENT16(b, pf->Bloss) << pf->Bshift |
+		      (PACK_COMPONENT16(a, pf->Aloss) << pf->Ashift &
+		       (Uint32)pf->Amask);
 	case AG_SURFACE_INDEXED:
 		return AG_MapPixelIndexed(pf, r,g,b,a);
 	case AG_SURFACE_GRAYSCALE:
@@ -1498,6 +1615,9 @@ AG_MapPixel64_RGBA8(const AG_PixelFormat *pf, Uint8 r, Uint8 g, Uint8 b,
 
 #endif /* AG_LARGE */
 
+#undef PACK_COMPONENT8
+#undef PACK_COMPONENT16
+
 /*
  * Functions for extracting RGBA components from encoded pixel data.
  */
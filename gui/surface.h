@@ -146,6 +146,7 @@ typedef struct ag_surface {
 #define AG_SURFACE_EXT_PIXELS  0x20     /* Pixels are allocated externally */
 #define AG_SURFACE_ANIMATED    0x40     /* Is an animation */
 #define AG_SURFACE_TRACE       0x80     /* Enable debugging */
+#define AG_SURFACE_SCALE_CACHED 0x100   /* Has entries in scale cache */
 #define AG_SAVED_SURFACE_FLAGS (AG_SURFACE_COLORKEY | AG_SURFACE_ANIMATED)
 	Uint w, h;                         /* Dimensions in pixels */
 	Uint pitch;                        /* Scanline byte length */
@@ -195,6 +196,42 @@ typedef enum ag_alpha_func {
 	AG_ALPHA_LAST
 } AG_AlphaFn;
 
+/*
+ * Kernels for packed 32-bit surfaces with byte-aligned 8-bit components.
+ * Component positions are byte indices into native Uint32 pixel values.
+ */
+typedef struct ag_surface_kernels {
+	const char *_Nonnull name;	/* Name ("scalar", "sse2", "avx2") */
+	Uint32 ext;			/* Required AG_CPUInfo(3) extensions */
+
+	/* Fill n pixels with a value. */
+	void (*_Nonnull fill32)(Uint32 *_Nonnull, Uint, Uint32);
+	/* Copy n pixels. */
+	void (*_Nonnull copy32)(Uint32 *_Nonnull, const Uint32 *_Nonnull, Uint);
+	/* Blend n pixels with AG_ALPHA_OVERLAY (alpha byte, max alpha). */
+	void (*_Nonnull blend32)(Uint32 *_Nonnull, const Uint32 *_Nonnull,
+	                         Uint, int, Uint8);
+	/* Copy n pixels, skipping those equal to a colorkey. */
+	void (*_Nonnull colorkey32)(Uint32 *_Nonnull, const Uint32 *_Nonnull,
+	                            Uint, Uint32);
+	/* Convert n pixels (source byte of each target byte, bits to set). */
+	void (*_Nonnull convert32)(Uint32 *_Nonnull, const Uint32 *_Nonnull,
+	                           Uint, const Sint8 *_Nonnull, Uint32);
+} AG_SurfaceKernels;
+
+/* Flags for AG_SurfaceScale() */
+#define AG_SCALE_NEAREST      0x00      /* Nearest neighbor (default) */
+#define AG_SCALE_BOX          0x01      /* Box filter (area average) */
+#define AG_SCALE_BILINEAR     0x02      /* Bilinear (triangle) filter */
+#define AG_SCALE_LANCZOS3     0x03      /* Lanczos filter (3 lobes) */
+#define AG_SCALE_FILTER       0x0f      /* Filter mask */
+#define AG_SCALE_CACHE        0x10      /* Use the cache of scaled surfaces */
+#define AG_SCALE_NO_THREADS   0x20      /* Don't split work between threads */
+
+#ifndef AG_SCALE_CACHE_MAX
+#define AG_SCALE_CACHE_MAX    (4*1024*1024) /* Scale cache size (bytes) */
+#endif
+
 /* Flags for AG_SurfaceExportBMP () */
 #define AG_EXPORT_BMP_NO_32BIT 0x01     /* Don't export a 32-bit BMP even when
                                            surface has an alpha channel */
@@ -214,6 +251,7 @@ extern const char *_Nonnull agAlphaFuncNames[];   /* AG_AlphaFunc modes */
 
 extern AG_PixelFormat *_Nullable agSurfaceFmt;  /* Standard surface format */
 extern AG_GrayscaleMode agGrayscaleMode;        /* Standard grayscale/RGB map */
+extern const AG_SurfaceKernels *_Nonnull agSurfaceKernels; /* Pixel kernels */
 
 void AG_PixelFormatIndexed(AG_PixelFormat *_Nonnull, int);
 void AG_PixelFormatGrayscale(AG_PixelFormat *_Nonnull, int);
@@ -223,6 +261,10 @@ void AG_PixelFormatRGBA(AG_PixelFormat *_Nonnull, int,
 
 AG_PixelFormat *_Nullable AG_PixelFormatDup(const AG_PixelFormat *_Nonnull)
                                            _Warn_Unused_Result;
+int AG_PixelFormatBytes32(const AG_PixelFormat *_Nonnull, Sint8 *_Nonnull);
+
+void                               AG_SurfaceInitKernels(void);
+const AG_SurfaceKernels *_Nullable AG_SurfaceGetKernels(const char *_Nonnull);
 
 void AG_SurfaceInit(AG_Surface *_Nonnull, const AG_PixelFormat *_Nullable,
                     Uint,Uint, Uint);
@@ -295,6 +337,10 @@ AG_Surface *_Nonnull AG_SurfaceConvert(const AG_Surface *_Nonnull,
 AG_Surface *_Nonnull AG_SurfaceScale(const AG_Surface *_Nonnull,
                                      Uint,Uint, Uint)
 				    _Warn_Unused_Result;
+void AG_SurfaceScaleCacheInvalidate(const AG_Surface *_Nonnull);
+void AG_SurfaceScaleCacheClear(void);
+void AG_SurfaceScaleCacheStats(Uint *_Nullable, AG_Size *_Nullable,
+                               Uint *_Nullable, Uint *_Nullable);
 
 int  AG_SurfaceResize(AG_Surface *_Nonnull, Uint, Uint);
 void AG_SurfaceCopy(AG_Surface *_Nonnull, const AG_Surface *_Nonnull);
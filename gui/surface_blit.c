@@ -0,0 +1,595 @@
+/*
+ * Copyright (c) 2026 Julien Nadeau Carriere <vedge@csoft.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Pixel kernels for packed 32-bit surfaces with byte-aligned 8-bit components
+ * (RGBA, BGRA, ARGB and so on). These implement the inner loops of
+ * AG_FillRect(), AG_SurfaceCopy() and AG_SurfaceBlit(). A portable version
+ * is always available; SSE2 and AVX2 versions are selected at runtime from
+ * the architecture extensions reported by AG_GetCPUInfo(3).
+ *
+ * Pixels are handled as native Uint32 values. Component positions are byte
+ * indices into that value (the shift of the component divided by 8).
+ */
+
+#include <agar/core/core.h>
+#include <agar/gui/surface.h>
+
+#include <string.h>
+
+#include <agar/config/have_sse2.h>
+#if defined(HAVE_SSE2) && defined(__GNUC__) && \
+   (defined(__x86_64__) || defined(__i386__))
+# define USE_SSE2
+# if defined(__clang__) || (__GNUC__ > 4) || \
+    (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#  define USE_AVX2
+# endif
+# include <immintrin.h>
+#endif
+
+/*
+ * Blend one 8-bit component: d + (s - d)*a/255, correctly rounded.
+ * The intermediate value never exceeds 16 bits.
+ */
+#define BLEND_COMPONENT(s, d, a) \
+	((((s)*(a) + (d)*(255 - (a)) + 128) + \
+	  (((s)*(a) + (d)*(255 - (a)) + 128) >> 8)) >> 8)
+
+/*
+ * Portable kernels.
+ */
+
+static void
+Fill32_Scalar(Uint32 *_Nonnull dst, Uint n, Uint32 px)
+{
+	Uint i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = px;
+}
+
+static void
+Copy32_Scalar(Uint32 *_Nonnull dst, const Uint32 *_Nonnull src, Uint n)
+{
+	memmove(dst, src, n * sizeof(Uint32));
+}
+
+static __inline__ Uint32
+BlendPixel32(Uint32 s, Uint32 d, int aByte, Uint aMax)
+{
+	const int aShift = aByte << 3;
+	Uint a = (s >> aShift) & 0xff;
+	Uint32 rv = 0;
+	int i;
+
+	if (a > aMax) {
+		a = aMax;
+	}
+	for (i = 0; i < 32; i += 8) {
+		const Uint sc = (s >> i) & 0xff;
+		const Uint dc = (d >> i) & 0xff;
+		Uint c;
+
+		if (i == aShift) {
+			c = dc + a;                    /* AG_ALPHA_OVERLAY */
+			if (c > 0xff)
+				c = 0xff;
+		} else {
+			c = BLEND_COMPONENT(sc, dc, a);
+		}
+		rv |= (Uint32)c << i;
+	}
+	return (rv);
+}
+
+static void
+Blend32_Scalar(Uint32 *_Nonnull dst, const Uint32 *_Nonnull src, Uint n,
+    int aByte, Uint8 aMax)
+{
+	Uint i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = BlendPixel32(src[i], dst[i], aByte, aMax);
+}
+
+static void
+Colorkey32_Scalar(Uint32 *_Nonnull dst, const Uint32 *_Nonnull src, Uint n,
+    Uint32 key)
+{
+	Uint i;
+
+	for (i = 0; i < n; i++) {
+		if (src[i] != key)
+			dst[i] = src[i];
+	}
+}
+
+static __inline__ Uint32
+ConvertPixel32(Uint32 s, const Sint8 *_Nonnull map, Uint32 set)
+{
+	Uint32 rv = set;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		if (map[i] >= 0)
+			rv |= ((s >> (map[i] << 3)) & 0xff) << (i << 3);
+	}
+	return (rv);
+}
+
+static void
+Convert32_Scalar(Uint32 *_Nonnull dst, const Uint32 *_Nonnull src, Uint n,
+    const Sint8 *_Nonnull map, Uint32 set)
+{
+	Uint i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = ConvertPixel32(src[i], map, set);
+}
+
+static const AG_SurfaceKernels kernelsScalar = {
+	"scalar",
+	0,
+	Fill32_Scalar,
+	Copy32_Scalar,
+	Blend32_Scalar,
+	Colorkey32_Scalar,
+	Convert32_Scalar
+};
+
+const AG_SurfaceKernels *agSurfaceKernels = &kernelsScalar;  /* In use */
+
+#ifdef USE_SSE2
+/*
+ * SSE2 kernels (4 pixels per iteration).
+ */
+
+__attribute__((target("sse2")))
+static void
+Fill32_SSE2(Uint32 *_Nonnull dst, Uint n, Uint32 px)
+{
+	const __m128i v = _mm_set1_epi32((int)px);
+	Uint i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+		_mm_storeu_si128((__m128i *)&dst[i],    v);
+		_mm_storeu_si128((__m128i *)&dst[i+4],  v);
+		_mm_storeu_si128((__m128i *)&dst[i+8],  v);
+		_mm_storeu_si128((__m128i *)&dst[i+12], v);
+	}
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_si128((__m128i *)&dst[i], v);
+	}
+	for (; i < n; i++)
+		dst[i] = px;
+}
+
+__attribute__((target("sse2")))
+static void
+Copy32_SSE2(Uint32 *_Nonnull dst, const Uint32 *_Nonnull src, Uint n)
+{
+	Uint i = 0;
+
+	if (dst > src && dst < src + n) {        /* Overlapping forward */
+		memmove(dst, src, n * sizeof(Uint32));
+		return;
+	}
+	for (; i + 16 <= n; i += 16) {
+		const __m128i a = _mm_loadu_si128((const __m128i *)&src[i]);
+		const __m128i b = _mm_loadu_si128((const __m128i *)&src[i+4]);
+		const __m128i c = _mm_loadu_si128((const __m128i *)&src[i+8]);
+		const __m128i d = _mm_loadu_si128((const __m128i *)&src[i+12]);
+
+		_mm_storeu_si128((__m128i *)&dst[i],    a);
+		_mm_storeu_si128((__m128i *)&dst[i+4],  b);
+		_mm_storeu_si128((__m128i *)&dst[i+8],  c);
+		_mm_storeu_si128((__m128i *)&dst[i+12], d);
+	}
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_si128((__m128i *)&dst[i],
+		    _mm_loadu_si128((const __m128i *)&src[i]));
+	}
+	for (; i < n; i++)
+		dst[i] = src[i];
+}
+
+/*
+ * Blend two 16-bit unpacked pixels of s over d with the per-component
+ * alphas in a16 (see BLEND_COMPONENT).
+ */
+__attribute__((target("sse2")))
+static __inline__ __m128i
+Blend16_SSE2(__m128i s, __m128i d, __m128i a16)
+{
+	const __m128i c255 = _mm_set1_epi16(255);
+	const __m128i c128 = _mm_set1_epi16(128);
+	__m128i t;
+
+	t = _mm_add_epi16(_mm_mullo_epi16(s, a16),
+	                  _mm_mullo_epi16(d, _mm_sub_epi16(c255, a16)));
+	t = _mm_add_epi16(t, c128);
+	t = _mm_add_epi16(t, _mm_srli_epi16(t, 8));
+	return _mm_srli_epi16(t, 8);
+}
+
+__attribute__((target("sse2")))
+static void
+Blend32_SSE2(Uint32 *_Nonnull dst, const Uint32 *_Nonnull src, Uint n,
+    int aByte, Uint8 aMax)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i aMask = _mm_set1_epi32((int)(0xffU << (aByte << 3)));
+	const __m128i aShift = _mm_cvtsi32_si128(aByte << 3);
+	const __m128i vMax = _mm_set1_epi32(aMax);
+	const __m128i lo8 = _mm_set1_epi32(0xff);
+	Uint i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)&src[i]);
+		const __m128i d = _mm_loadu_si128((const __m128i *)&dst[i]);
+		__m128i a, aa, rLo, rHi, rv, dA;
+
+		a = _mm_and_si128(_mm_srl_epi32(s, aShift), lo8);
+		a = _mm_min_epi16(a, vMax);
+		aa = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+
+		rLo = Blend16_SSE2(_mm_unpacklo_epi8(s, zero),
+		                   _mm_unpacklo_epi8(d, zero),
+		                   _mm_unpacklo_epi32(aa, aa));
+		rHi = Blend16_SSE2(_mm_unpackhi_epi8(s, zero),
+		                   _mm_unpackhi_epi8(d, zero),
+		                   _mm_unpackhi_epi32(aa, aa));
+		rv = _mm_packus_epi16(rLo, rHi);
+
+		dA = _mm_adds_epu8(d, _mm_sll_epi32(a, aShift));
+		rv = _mm_or_si128(_mm_andnot_si128(aMask, rv),
+		                  _mm_and_si128(aMask, dA));
+		_mm_storeu_si128((__m128i *)&dst[i], rv);
+	}
+	for (; i < n; i++)
+		dst[i] = BlendPixel32(src[i], dst[i], aByte, aMax);
+}
+
+__attribute__((target("sse2")))
+static void
+Colorkey32_SSE2(Uint32 *_Nonnull dst, const Uint32 *_Nonnull src, Uint n,
+    Uint32 key)
+{
+	const __m128i vKey = _mm_set1_epi32((int)key);
+	Uint i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)&src[i]);
+		const __m128i d = _mm_loadu_si128((const __m128i *)&dst[i]);
+		const __m128i m = _mm_cmpeq_epi32(s, vKey);
+
+		_mm_storeu_si128((__m128i *)&dst[i],
+		    _mm_or_si128(_mm_and_si128(m, d), _mm_andnot_si128(m, s)));
+	}
+	for (; i < n; i++) {
+		if (src[i] != key)
+			dst[i] = src[i];
+	}
+}
+
+__attribute__((target("sse2")))
+static void
+Convert32_SSE2(Uint32 *_Nonnull dst, const Uint32 *_Nonnull src, Uint n,
+    const Sint8 *_Nonnull map, Uint32 set)
+{
+	const __m128i lo8 = _mm_set1_epi32(0xff);
+	const __m128i vSet = _mm_set1_epi32((int)set);
+	__m128i sIn[4], sOut[4];
+	int j, nMap = 0;
+	Uint i = 0;
+
+	for (j = 0; j < 4; j++) {
+		if (map[j] < 0) {
+			continue;
+		}
+		sIn[nMap] = _mm_cvtsi32_si128(map[j] << 3);
+		sOut[nMap] = _mm_cvtsi32_si128(j << 3);
+		nMap++;
+	}
+	for (; i + 4 <= n; i += 4) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)&src[i]);
+		__m128i rv = vSet;
+
+		for (j = 0; j < nMap; j++) {
+			rv = _mm_or_si128(rv, _mm_sll_epi32(
+			    _mm_and_si128(_mm_srl_epi32(s, sIn[j]), lo8),
+			    sOut[j]));
+		}
+		_mm_storeu_si128((__m128i *)&dst[i], rv);
+	}
+	for (; i < n; i++)
+		dst[i] = ConvertPixel32(src[i], map, set);
+}
+
+static const AG_SurfaceKernels kernelsSSE2 = {
+	"sse2",
+	AG_EXT_SSE2,
+	Fill32_SSE2,
+	Copy32_SSE2,
+	Blend32_SSE2,
+	Colorkey32_SSE2,
+	Convert32_SSE2
+};
+#endif /* USE_SSE2 */
+
+#ifdef USE_AVX2
+/*
+ * AVX2 kernels (8 pixels per iteration).
+ */
+
+__attribute__((target("avx2")))
+static void
+Fill32_AVX2(Uint32 *_Nonnull dst, Uint n, Uint32 px)
+{
+	const __m256i v = _mm256_set1_epi32((int)px);
+	Uint i = 0;
+
+	for (; i + 32 <= n; i += 32) {
+		_mm256_storeu_si256((__m256i *)&dst[i],    v);
+		_mm256_storeu_si256((__m256i *)&dst[i+8],  v);
+		_mm256_storeu_si256((__m256i *)&dst[i+16], v);
+		_mm256_storeu_si256((__m256i *)&dst[i+24], v);
+	}
+	for (; i + 8 <= n; i += 8) {
+		_mm256_storeu_si256((__m256i *)&dst[i], v);
+	}
+	for (; i < n; i++)
+		dst[i] = px;
+}
+
+__attribute__((target("avx2")))
+static void
+Copy32_AVX2(Uint32 *_Nonnull dst, const Uint32 *_Nonnull src, Uint n)
+{
+	Uint i = 0;
+
+	if (dst > src && dst < src + n) {        /* Overlapping forward */
+		memmove(dst, src, n * sizeof(Uint32));
+		return;
+	}
+	for (; i + 32 <= n; i += 32) {
+		const __m256i a = _mm256_loadu_si256((const __m256i *)&src[i]);
+		const __m256i b = _mm256_loadu_si256((const __m256i *)&src[i+8]);
+		const __m256i c = _mm256_loadu_si256((const __m256i *)&src[i+16]);
+		const __m256i d = _mm256_loadu_si256((const __m256i *)&src[i+24]);
+
+		_mm256_storeu_si256((__m256i *)&dst[i],    a);
+		_mm256_storeu_si256((__m256i *)&dst[i+8],  b);
+		_mm256_storeu_si256((__m256i *)&dst[i+16], c);
+		_mm256_storeu_si256((__m256i *)&dst[i+24], d);
+	}
+	for (; i + 8 <= n; i += 8) {
+		_mm256_storeu_si256((__m256i *)&dst[i],
+		    _mm256_loadu_si256((const __m256i *)&src[i]));
+	}
+	for (; i < n; i++)
+		dst[i] = src[i];
+}
+
+__attribute__((target("avx2")))
+static __inline__ __m256i
+Blend16_AVX2(__m256i s, __m256i d, __m256i a16)
+{
+	const __m256i c255 = _mm256_set1_epi16(255);
+	const __m256i c128 = _mm256_set1_epi16(128);
+	__m256i t;
+
+	t = _mm256_add_epi16(_mm256_mullo_epi16(s, a16),
+	    _mm256_mullo_epi16(d, _mm256_sub_epi16(c255, a16)));
+	t = _mm256_add_epi16(t, c128);
+	t = _mm256_add_epi16(t, _mm256_srli_epi16(t, 8));
+	return _mm256_srli_epi16(t, 8);
+}
+
+__attribute__((target("avx2")))
+static void
+Blend32_AVX2(Uint32 *_Nonnull dst, const Uint32 *_Nonnull src, Uint n,
+    int aByte, Uint8 aMax)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i aMask = _mm256_set1_epi32((int)(0xffU << (aByte << 3)));
+	const __m128i aShift = _mm_cvtsi32_si128(aByte << 3);
+	const __m256i vMax = _mm256_set1_epi32(aMax);
+	const __m256i lo8 = _mm256_set1_epi32(0xff);
+	Uint i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		const __m256i s = _mm256_loadu_si256((const __m256i *)&src[i]);
+		const __m256i d = _mm256_loadu_si256((const __m256i *)&dst[i]);
+		__m256i a, aa, rLo, rHi, rv, dA;
+
+		a = _mm256_and_si256(_mm256_srl_epi32(s, aShift), lo8);
+		a = _mm256_min_epu32(a, vMax);
+		aa = _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+
+		rLo = Blend16_AVX2(_mm256_unpacklo_epi8(s, zero),
+		                   _mm256_unpacklo_epi8(d, zero),
+		                   _mm256_unpacklo_epi32(aa, aa));
+		rHi = Blend16_AVX2(_mm256_unpackhi_epi8(s, zero),
+		                   _mm256_unpackhi_epi8(d, zero),
+		                   _mm256_unpackhi_epi32(aa, aa));
+		rv = _mm256_packus_epi16(rLo, rHi);
+
+		dA = _mm256_adds_epu8(d, _mm256_sll_epi32(a, aShift));
+		rv = _mm256_blendv_epi8(rv, dA, aMask);
+		_mm256_storeu_si256((__m256i *)&dst[i], rv);
+	}
+	for (; i < n; i++)
+		dst[i] = BlendPixel32(src[i], dst[i], aByte, aMax);
+}
+
+__attribute__((target("avx2")))
+static void
+Colorkey32_AVX2(Uint32 *_Nonnull dst, const Uint32 *_Nonnull src, Uint n,
+    Uint32 key)
+{
+	const __m256i vKey = _mm256_set1_epi32((int)key);
+	Uint i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		const __m256i s = _mm256_loadu_si256((const __m256i *)&src[i]);
+		const __m256i d = _mm256_loadu_si256((const __m256i *)&dst[i]);
+
+		_mm256_storeu_si256((__m256i *)&dst[i],
+		    _mm256_blendv_epi8(s, d, _mm256_cmpeq_epi32(s, vKey)));
+	}
+	for (; i < n; i++) {
+		if (src[i] != key)
+			dst[i] = src[i];
+	}
+}
+
+__attribute__((target("avx2")))
+static void
+Convert32_AVX2(Uint32 *_Nonnull dst, const Uint32 *_Nonnull src, Uint n,
+    const Sint8 *_Nonnull map, Uint32 set)
+{
+	const __m256i vSet = _mm256_set1_epi32((int)set);
+	__m256i vShuf;
+	char shuf[32];
+	Uint i = 0;
+	int j;
+
+	/* VPSHUFB pattern (byte index within each 128-bit lane, or zero). */
+	for (j = 0; j < 32; j++) {
+		const int m = map[j & 3];
+
+		shuf[j] = (m < 0) ? (char)0x80 : (char)((j & 12) + m);
+	}
+	vShuf = _mm256_loadu_si256((const __m256i *)shuf);
+
+	for (; i + 8 <= n; i += 8) {
+		const __m256i s = _mm256_loadu_si256((const __m256i *)&src[i]);
+
+		_mm256_storeu_si256((__m256i *)&dst[i],
+		    _mm256_or_si256(_mm256_shuffle_epi8(s, vShuf), vSet));
+	}
+	for (; i < n; i++)
+		dst[i] = ConvertPixel32(src[i], map, set);
+}
+
+static const AG_SurfaceKernels kernelsAVX2 = {
+	"avx2",
+	AG_EXT_AVX2,
+	Fill32_AVX2,
+	Copy32_AVX2,
+	Blend32_AVX2,
+	Colorkey32_AVX2,
+	Convert32_AVX2
+};
+#endif /* USE_AVX2 */
+
+/* Kernel sets in order of preference. */
+static const AG_SurfaceKernels *_Nonnull kernelSets[] = {
+#ifdef USE_AVX2
+	&kernelsAVX2,
+#endif
+#ifdef USE_SSE2
+	&kernelsSSE2,
+#endif
+	&kernelsScalar
+};
+static const int nKernelSets = sizeof(kernelSets) / sizeof(kernelSets[0]);
+
+/*
+ * Return the kernel set of the given name ("scalar", "sse2" or "avx2"), or
+ * NULL if it was not compiled in or is not supported by the processor.
+ */
+const AG_SurfaceKernels *
+AG_SurfaceGetKernels(const char *name)
+{
+	int i;
+
+	for (i = 0; i < nKernelSets; i++) {
+		const AG_SurfaceKernels *K = kernelSets[i];
+
+		if (strcmp(K->name, name) == 0 &&
+		    (K->ext & agCPU.ext) == K->ext)
+			return (K);
+	}
+	return (NULL);
+}
+
+/*
+ * Select the fastest kernel set supported by the processor. The choice may
+ * be overridden with the AG_SURFACE_KERNELS environment variable.
+ */
+void
+AG_SurfaceInitKernels(void)
+{
+	const char *s;
+	int i;
+
+	if ((s = getenv("AG_SURFACE_KERNELS")) != NULL &&
+	    (agSurfaceKernels = AG_SurfaceGetKernels(s)) != NULL) {
+		return;
+	}
+	for (i = 0; i < nKernelSets; i++) {
+		const AG_SurfaceKernels *K = kernelSets[i];
+
+		if ((K->ext & agCPU.ext) == K->ext) {
+			agSurfaceKernels = K;
+			break;
+		}
+	}
+}
+
+/*
+ * Return the byte positions of the R, G, B and A components if pf is a packed
+ * 32-bit format with byte-aligned 8-bit components (A is -1 if there is no
+ * alpha channel). Return -1 if the format cannot be used with the kernels.
+ */
+int
+AG_PixelFormatBytes32(const AG_PixelFormat *pf, Sint8 *idx)
+{
+	const AG_Pixel masks[4] = { pf->Rmask, pf->Gmask, pf->Bmask, pf->Amask };
+	const int shifts[4] = { pf->Rshift, pf->Gshift, pf->Bshift, pf->Ashift };
+	Uint used = 0;
+	int i;
+
+	if (pf->mode != AG_SURFACE_PACKED || pf->BitsPerPixel != 32) {
+		return (-1);
+	}
+	for (i = 0; i < 4; i++) {
+		if (i == 3 && masks[i] == 0) {
+			idx[i] = -1;
+			break;
+		}
+		if ((shifts[i] & 7) != 0 ||
+		    masks[i] != ((AG_Pixel)0xff << shifts[i]) ||
+		    (used & (1 << (shifts[i] >> 3)))) {
+			return (-1);
+		}
+		idx[i] = (Sint8)(shifts[i] >> 3);
+		used |= (1 << idx[i]);
+	}
+	return (0);
+}
@@ -0,0 +1,692 @@
+/*
+ * Copyright (c) 2026 Julien Nadeau Carriere <vedge@csoft.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Surface scaling. Filtered modes are computed in two separable passes
+ * (horizontal, then vertical) over rows of premultiplied float RGBA. Each
+ * pass splits its rows between worker threads for large surfaces. Scaled
+ * copies of icons may be kept in a small LRU cache (AG_SCALE_CACHE).
+ */
+
+#include <agar/core/core.h>
+#include <agar/gui/surface.h>
+#include <agar/gui/gui_math.h>
+
+#include <string.h>
+
+#define SCALE_PARALLEL_MIN  (128*128)   /* Output pixels to go parallel */
+#define SCALE_ROWS_MIN      16          /* Rows per worker thread */
+#define SCALE_THREADS_MAX   16          /* Worker threads per pass */
+#define SCALE_CACHE_BUCKETS 64          /* Scaled surface cache buckets */
+
+/* Filter taps contributing to one output column or row. */
+typedef struct scale_contrib {
+	int first;                      /* First source index */
+	int n;                          /* Number of taps */
+	const float *_Nonnull w;        /* Normalized weights */
+} ScaleContrib;
+
+/* A range of rows processed by one thread. */
+typedef struct scale_job {
+	const AG_Surface *_Nonnull S;   /* Source surface */
+	AG_Surface *_Nonnull D;         /* Target surface */
+	const ScaleContrib *_Nonnull xc; /* Horizontal taps (D->w entries) */
+	const ScaleContrib *_Nonnull yc; /* Vertical taps (D->h entries) */
+	float *_Nonnull T;              /* Horizontally scaled rows */
+	float *_Nonnull buf;            /* Row buffer (MAX(S->w,D->w)*4) */
+	int pass;                       /* 0 = Horizontal, 1 = Vertical */
+	int y1, y2;                     /* Row range */
+	int fast;                       /* Packed 32-bit (see idx) */
+	Sint8 idx[4];                   /* Component byte positions */
+} ScaleJob;
+
+/* Cached scaled surface. */
+typedef struct scale_cache_ent {
+	const AG_Surface *_Nonnull src;         /* Source surface */
+	Uint srcW, srcH;                        /* Source size at insertion */
+	Uint w, h;                              /* Scaled size */
+	Uint filter;                            /* AG_SCALE_FILTER bits */
+	AG_Surface *_Nonnull su;                /* Scaled surface */
+	AG_Size size;                           /* Pixel data size */
+	struct scale_cache_ent *_Nullable next; /* In bucket */
+	AG_TAILQ_ENTRY(scale_cache_ent) lru;    /* In LRU list */
+} ScaleCacheEnt;
+
+static struct {
+	ScaleCacheEnt *_Nullable buckets[SCALE_CACHE_BUCKETS];
+	AG_Size size;                           /* Total pixel data */
+	Uint n;                                 /* Entry count */
+	Uint nHits, nMisses;                    /* Statistics */
+} scaleCache = { { NULL }, 0, 0, 0, 0 };
+
+/* Cache entries, most recently used first. */
+static AG_TAILQ_HEAD(scale_cache_lru, scale_cache_ent) scaleCacheLRU =
+    AG_TAILQ_HEAD_INITIALIZER(scaleCacheLRU);
+
+static AG_Mutex scaleCacheLock = AG_MUTEX_INITIALIZER;
+
+/*
+ * Filter kernels over the distance x (in source pixels at 1:1 scale).
+ */
+static float
+FilterBox(float x)
+{
+	return (x >= -0.5f && x < 0.5f) ? 1.0f : 0.0f;
+}
+
+static float
+FilterTriangle(float x)
+{
+	if (x < 0.0f) { x = -x; }
+	return (x < 1.0f) ? (1.0f - x) : 0.0f;
+}
+
+#ifdef HAVE_MATH
+static float
+Sinc(float x)
+{
+	if (x == 0.0f) {
+		return (1.0f);
+	}
+	x *= (float)AG_PI;
+	return (float)Sin(x) / x;
+}
+
+static float
+FilterLanczos3(float x)
+{
+	return (x > -3.0f && x < 3.0f) ? Sinc(x) * Sinc(x / 3.0f) : 0.0f;
+}
+#endif /* HAVE_MATH */
+
+/*
+ * Compute the filter taps mapping srcLen source pixels to dstLen output
+ * pixels. When reducing, the filter is stretched to cover the footprint of
+ * the output pixel. Return a single allocation holding the ScaleContrib
+ * array followed by the weights.
+ */
+static ScaleContrib *_Nullable
+ComputeContribs(Uint srcLen, Uint dstLen, Uint filter)
+{
+	float (*fn)(float);
+	float support, scale, fscale;
+	ScaleContrib *C;
+	float *w;
+	int i, nMax;
+
+	switch (filter) {
+	case AG_SCALE_BOX:
+		fn = FilterBox;
+		support = 0.5f;
+		break;
+#ifdef HAVE_MATH
+	case AG_SCALE_LANCZOS3:
+		fn = FilterLanczos3;
+		support = 3.0f;
+		break;
+#endif
+	case AG_SCALE_BILINEAR:
+	default:
+		fn = FilterTriangle;
+		support = 1.0f;
+		break;
+	}
+	scale = (float)srcLen / (float)dstLen;
+	fscale = (scale > 1.0f) ? scale : 1.0f;
+	support *= fscale;
+	nMax = (int)(support*2.0f) + 3;
+
+	C = TryMalloc(dstLen*sizeof(ScaleContrib) + dstLen*nMax*sizeof(float));
+	if (C == NULL) {
+		return (NULL);
+	}
+	w = (float *)&C[dstLen];
+
+	for (i = 0; i < (int)dstLen; i++) {
+		const float center = ((float)i + 0.5f) * scale;
+		int x1 = (int)(center - support + 0.5f);
+		int x2 = (int)(center + support + 0.5f);
+		float sum = 0.0f;
+		int j;
+
+		if (x1 < 0) { x1 = 0; }
+		if (x2 > (int)srcLen) { x2 = (int)srcLen; }
+		if (x2 - x1 > nMax) { x2 = x1 + nMax; }
+
+		for (j = x1; j < x2; j++) {
+			const float wt = fn(((float)j - center + 0.5f) / fscale);
+
+			w[j - x1] = wt;
+			sum += wt;
+		}
+		if (sum != 0.0f) {
+			for (j = 0; j < x2 - x1; j++)
+				w[j] /= sum;
+		} else {                                   /* Nearest */
+			x1 = (int)center;
+			if (x1 >= (int)srcLen) { x1 = (int)srcLen - 1; }
+			x2 = x1 + 1;
+			w[0] = 1.0f;
+		}
+		C[i].first = x1;
+		C[i].n = x2 - x1;
+		C[i].w = w;
+		w += nMax;
+	}
+	return (C);
+}
+
+/* Load a source row as premultiplied RGBA floats (0.0 - 1.0). */
+static void
+LoadRow(const ScaleJob *_Nonnull job, int y, float *_Nonnull dst)
+{
+	const AG_Surface *S = job->S;
+	const Uint8 *p = S->pixels + y*S->pitch;
+	int x;
+
+	if (job->fast) {
+		const Uint32 *px32 = (const Uint32 *)p;
+		const int sR = job->idx[0] << 3;
+		const int sG = job->idx[1] << 3;
+		const int sB = job->idx[2] << 3;
+		const int sA = job->idx[3] << 3;
+		const int hasAlpha = (job->idx[3] != -1);
+
+		for (x = 0; x < S->w; x++) {
+			const Uint32 px = px32[x];
+			const float a = hasAlpha ?
+			                (float)((px >> sA) & 0xff) / 255.0f : 1.0f;
+
+			dst[0] = (float)((px >> sR) & 0xff) / 255.0f * a;
+			dst[1] = (float)((px >> sG) & 0xff) / 255.0f * a;
+			dst[2] = (float)((px >> sB) & 0xff) / 255.0f * a;
+			dst[3] = a;
+			dst += 4;
+		}
+	} else {
+		for (x = 0; x < S->w; x++) {
+			AG_Color c;
+			float a;
+
+			AG_GetColor(&c, AG_SurfaceGet_At(S, p), &S->format);
+			a = (float)c.a / AG_COLOR_LASTF;
+			dst[0] = (float)c.r / AG_COLOR_LASTF * a;
+			dst[1] = (float)c.g / AG_COLOR_LASTF * a;
+			dst[2] = (float)c.b / AG_COLOR_LASTF * a;
+			dst[3] = a;
+			dst += 4;
+			p += S->format.BytesPerPixel;
+		}
+	}
+}
+
+static __inline__ float
+Clamp01(float v)
+{
+	return (v < 0.0f) ? 0.0f : (v > 1.0f) ? 1.0f : v;
+}
+
+/* Write a row of premultiplied RGBA floats to the target surface. */
+static void
+StoreRow(const ScaleJob *_Nonnull job, int y, const float *_Nonnull src)
+{
+	AG_Surface *D = job->D;
+	Uint8 *p = D->pixels + y*D->pitch;
+	int x;
+
+	for (x = 0; x < D->w; x++) {
+		const float a = Clamp01(src[3]);
+		const float k = (a > 0.0f) ? 1.0f / a : 0.0f;
+		const float r = Clamp01(src[0] * k);
+		const float g = Clamp01(src[1] * k);
+		const float b = Clamp01(src[2] * k);
+
+		if (job->fast) {
+			Uint32 px;
+
+			px = (Uint32)(r*255.0f + 0.5f) << (job->idx[0] << 3) |
+			     (Uint32)(g*255.0f + 0.5f) << (job->idx[1] << 3) |
+			     (Uint32)(b*255.0f + 0.5f) << (job->idx[2] << 3);
+			if (job->idx[3] != -1) {
+				px |= (Uint32)(a*255.0f + 0.5f) <<
+				      (job->idx[3] << 3);
+			}
+			((Uint32 *)p)[x] = px;
+		} else {
+			AG_Color c;
+
+			c.r = (AG_Component)(r*AG_COLOR_LASTF + 0.5f);
+			c.g = (AG_Component)(g*AG_COLOR_LASTF + 0.5f);
+			c.b = (AG_Component)(b*AG_COLOR_LASTF + 0.5f);
+			c.a = (AG_Component)(a*AG_COLOR_LASTF + 0.5f);
+			AG_SurfacePut_At(D, p, AG_MapPixel(&D->format, &c));
+			p += D->format.BytesPerPixel;
+		}
+		src += 4;
+	}
+}
+
+/* Horizontal pass: scale source rows y1..y2 into T. */
+static void
+ScaleRowsHoriz(ScaleJob *_Nonnull job)
+{
+	const int wOut = job->D->w;
+	int y, x, j;
+
+	for (y = job->y1; y < job->y2; y++) {
+		float *out = &job->T[(AG_Size)y * wOut * 4];
+
+		LoadRow(job, y, job->buf);
+
+		for (x = 0; x < wOut; x++) {
+			const ScaleContrib *c = &job->xc[x];
+			const float *in = &job->buf[c->first << 2];
+			float r = 0.0f, g = 0.0f, b = 0.0f, a = 0.0f;
+
+			for (j = 0; j < c->n; j++) {
+				const float wt = c->w[j];
+
+				r += in[0] * wt;
+				g += in[1] * wt;
+				b += in[2] * wt;
+				a += in[3] * wt;
+				in += 4;
+			}
+			out[0] = r;
+			out[1] = g;
+			out[2] = b;
+			out[3] = a;
+			out += 4;
+		}
+	}
+}
+
+/* Vertical pass: combine rows of T into target rows y1..y2. */
+static void
+ScaleRowsVert(ScaleJob *_Nonnull job)
+{
+	const int n = job->D->w * 4;
+	float *acc = job->buf;
+	int y, i, j;
+
+	for (y = job->y1; y < job->y2; y++) {
+		const ScaleContrib *c = &job->yc[y];
+
+		memset(acc, 0, n*sizeof(float));
+		for (j = 0; j < c->n; j++) {
+			const float *in = &job->T[(AG_Size)(c->first + j) * n];
+			const float wt = c->w[j];
+
+			for (i = 0; i < n; i++)
+				acc[i] += in[i] * wt;
+		}
+		StoreRow(job, y, acc);
+	}
+}
+
+static void *_Nullable
+ScaleWorker(void *_Nonnull arg)
+{
+	ScaleJob *job = arg;
+
+	if (job->pass == 0) {
+		ScaleRowsHoriz(job);
+	} else {
+		ScaleRowsVert(job);
+	}
+	return (NULL);
+}
+
+/*
+ * Run one pass over nRows rows, splitting them between nJobs threads
+ * (the calling thread processes the first range).
+ */
+static void
+RunPass(ScaleJob *_Nonnull jobs, int nJobs, int pass, int nRows)
+{
+	int i;
+
+	for (i = 0; i < nJobs; i++) {
+		jobs[i].pass = pass;
+		jobs[i].y1 = nRows * i / nJobs;
+		jobs[i].y2 = nRows * (i+1) / nJobs;
+	}
+	AG_RunJobs(ScaleWorker, jobs, sizeof(ScaleJob), (Uint)nJobs);
+}
+
+/* Scale S into D with a separable filter. */
+static int
+ScaleFiltered(const AG_Surface *_Nonnull S, AG_Surface *_Nonnull D, Uint flags)
+{
+	const Uint filter = (flags & AG_SCALE_FILTER);
+	const AG_Size rowLen = MAX(S->w, D->w) * 4 * sizeof(float);
+	ScaleJob jobs[SCALE_THREADS_MAX];
+	ScaleContrib *xc, *yc;
+	Sint8 idx[4];
+	float *T;
+	int i, nJobs = 1, fast;
+
+	if ((xc = ComputeContribs(S->w, D->w, filter)) == NULL) {
+		return (-1);
+	}
+	if ((yc = ComputeContribs(S->h, D->h, filter)) == NULL) {
+		goto fail_xc;
+	}
+	if ((T = TryMalloc((AG_Size)S->h * D->w * 4 * sizeof(float))) == NULL)
+		goto fail_yc;
+
+	fast = (AG_PixelFormatBytes32(&S->format, idx) == 0 &&
+	        ((AG_Size)S->pixels & 3) == 0 && (S->pitch & 3) == 0 &&
+	        ((AG_Size)D->pixels & 3) == 0 && (D->pitch & 3) == 0);
+
+#ifdef AG_THREADS
+	if (!(flags & AG_SCALE_NO_THREADS) &&
+	    (AG_Size)D->w * D->h >= SCALE_PARALLEL_MIN) {
+		nJobs = MIN((int)AG_GetProcessorCount(), SCALE_THREADS_MAX);
+		nJobs = MIN(nJobs, (int)MIN(S->h, D->h) / SCALE_ROWS_MIN);
+		if (nJobs < 1)
+			nJobs = 1;
+	}
+#endif
+	for (i = 0; i < nJobs; i++) {
+		ScaleJob *job = &jobs[i];
+
+		if ((job->buf = TryMalloc(rowLen)) == NULL) {
+			while (--i >= 0) {
+				free(jobs[i].buf);
+			}
+			goto fail_T;
+		}
+		job->S = S;
+		job->D = D;
+		job->xc = xc;
+		job->yc = yc;
+		job->T = T;
+		job->fast = fast;
+		memcpy(job->idx, idx, sizeof(idx));
+	}
+
+	RunPass(jobs, nJobs, 0, S->h);
+	RunPass(jobs, nJobs, 1, D->h);
+
+	for (i = 0; i < nJobs; i++) {
+		free(jobs[i].buf);
+	}
+	free(T);
+	free(yc);
+	free(xc);
+	return (0);
+fail_T:
+	free(T);
+fail_yc:
+	free(yc);
+fail_xc:
+	free(xc);
+	return (-1);
+}
+
+/* Nearest-neighbor scaling. */
+static void
+ScaleNearest(const AG_Surface *_Nonnull S, AG_Surface *_Nonnull D)
+{
+	const float xf = (D->w > 1) ? (float)(S->w - 1) / (float)(D->w - 1) : 0.0f;
+	const float yf = (D->h > 1) ? (float)(S->h - 1) / (float)(D->h - 1) : 0.0f;
+	int x, y;
+
+	if (S->format.BytesPerPixel == 4 && S->format.BitsPerPixel == 32 &&
+	    ((AG_Size)S->pixels & 3) == 0 && (S->pitch & 3) == 0 &&
+	    ((AG_Size)D->pixels & 3) == 0 && (D->pitch & 3) == 0) {
+		int *xs;
+
+		if ((xs = TryMalloc(D->w * sizeof(int))) != NULL) {
+			for (x = 0; x < D->w; x++) {
+				xs[x] = (int)((float)x * xf);
+			}
+			for (y = 0; y < D->h; y++) {
+				const Uint32 *pSrc = (const Uint32 *)(S->pixels +
+				    (int)((float)y * yf) * S->pitch);
+				Uint32 *pDst = (Uint32 *)(D->pixels + y*D->pitch);
+
+				for (x = 0; x < D->w; x++)
+					pDst[x] = pSrc[xs[x]];
+			}
+			free(xs);
+			return;
+		}
+	}
+	for (y = 0; y < D->h; y++) {
+		for (x = 0; x < D->w; x++) {
+			AG_SurfacePut(D, x,y, AG_SurfaceGet(S,
+			    (int)((float)x * xf),
+			    (int)((float)y * yf)));
+		}
+	}
+}
+
+static __inline__ Uint
+CacheHash(const AG_Surface *_Nonnull S)
+{
+	return (Uint)(((AG_Size)S >> 4) % SCALE_CACHE_BUCKETS);
+}
+
+/* Remove a cache entry. The cache must be locked. */
+static void
+CacheRemove(ScaleCacheEnt *_Nonnull ent)
+{
+	ScaleCacheEnt **pp = &scaleCache.buckets[CacheHash(ent->src)];
+
+	while (*pp != ent) {
+		pp = &(*pp)->next;
+	}
+	*pp = ent->next;
+	AG_TAILQ_REMOVE(&scaleCacheLRU, ent, lru);
+	scaleCache.size -= ent->size;
+	scaleCache.n--;
+	AG_SurfaceFree(ent->su);
+	free(ent);
+}
+
+/* Look up a scaled copy of S. The cache must be locked. */
+static ScaleCacheEnt *_Nullable
+CacheLookup(const AG_Surface *_Nonnull S, Uint w, Uint h, Uint filter)
+{
+	ScaleCacheEnt *ent;
+
+	for (ent = scaleCache.buckets[CacheHash(S)]; ent != NULL;
+	     ent = ent->next) {
+		if (ent->src == S && ent->w == w && ent->h == h &&
+		    ent->filter == filter)
+			break;
+	}
+	if (ent == NULL) {
+		return (NULL);
+	}
+	if (ent->srcW != S->w || ent->srcH != S->h) {     /* Resized */
+		CacheRemove(ent);
+		return (NULL);
+	}
+	if (ent != AG_TAILQ_FIRST(&scaleCacheLRU)) {
+		AG_TAILQ_REMOVE(&scaleCacheLRU, ent, lru);
+		AG_TAILQ_INSERT_HEAD(&scaleCacheLRU, ent, lru);
+	}
+	return (ent);
+}
+
+/* Insert a scaled copy of S (evicting least recently used entries). */
+static void
+CacheInsert(const AG_Surface *_Nonnull S, const AG_Surface *_Nonnull D,
+    Uint filter)
+{
+	const AG_Size size = (AG_Size)D->h * D->pitch;
+	ScaleCacheEnt *ent;
+	Uint h;
+
+	if (size > AG_SCALE_CACHE_MAX / 4 ||
+	    (S->flags & AG_SURFACE_ANIMATED)) {
+		return;
+	}
+	if ((ent = TryMalloc(sizeof(ScaleCacheEnt))) == NULL) {
+		return;
+	}
+	AG_MutexLock(&scaleCacheLock);
+	if (CacheLookup(S, D->w, D->h, filter) != NULL) {  /* Lost a race */
+		AG_MutexUnlock(&scaleCacheLock);
+		free(ent);
+		return;
+	}
+	while (scaleCache.size + size > AG_SCALE_CACHE_MAX &&
+	       !AG_TAILQ_EMPTY(&scaleCacheLRU)) {
+		CacheRemove(AG_TAILQ_LAST(&scaleCacheLRU, scale_cache_lru));
+	}
+	ent->src = S;
+	ent->srcW = S->w;
+	ent->srcH = S->h;
+	ent->w = D->w;
+	ent->h = D->h;
+	ent->filter = filter;
+	ent->su = AG_SurfaceDup(D);
+	ent->size = size;
+	h = CacheHash(S);
+	ent->next = scaleCache.buckets[h];
+	scaleCache.buckets[h] = ent;
+	AG_TAILQ_INSERT_HEAD(&scaleCacheLRU, ent, lru);
+	scaleCache.size += size;
+	scaleCache.n++;
+
+	/* Have AG_SurfaceFree() invalidate the entries of S. */
+	((AG_Surface *)S)->flags |= AG_SURFACE_SCALE_CACHED;
+	AG_MutexUnlock(&scaleCacheLock);
+}
+
+/*
+ * Drop any cached scaled copies of S. This must be called after the pixels
+ * of a surface used with AG_SCALE_CACHE are modified (AG_SurfaceFree() calls
+ * it automatically).
+ */
+void
+AG_SurfaceScaleCacheInvalidate(const AG_Surface *S)
+{
+	ScaleCacheEnt *ent, *entNext;
+
+	AG_MutexLock(&scaleCacheLock);
+	for (ent = scaleCache.buckets[CacheHash(S)]; ent != NULL;
+	     ent = entNext) {
+		entNext = ent->next;
+		if (ent->src == S)
+			CacheRemove(ent);
+	}
+	AG_MutexUnlock(&scaleCacheLock);
+}
+
+/* Free all cached scaled surfaces. */
+void
+AG_SurfaceScaleCacheClear(void)
+{
+	AG_MutexLock(&scaleCacheLock);
+	while (!AG_TAILQ_EMPTY(&scaleCacheLRU)) {
+		CacheRemove(AG_TAILQ_FIRST(&scaleCacheLRU));
+	}
+	scaleCache.nHits = 0;
+	scaleCache.nMisses = 0;
+	AG_MutexUnlock(&scaleCacheLock);
+}
+
+/* Return cache statistics (any argument may be NULL). */
+void
+AG_SurfaceScaleCacheStats(Uint *nEnts, AG_Size *size, Uint *nHits,
+    Uint *nMisses)
+{
+	AG_MutexLock(&scaleCacheLock);
+	if (nEnts != NULL)   { *nEnts = scaleCache.n; }
+	if (size != NULL)    { *size = scaleCache.size; }
+	if (nHits != NULL)   { *nHits = scaleCache.nHits; }
+	if (nMisses != NULL) { *nMisses = scaleCache.nMisses; }
+	AG_MutexUnlock(&scaleCacheLock);
+}
+
+/*
+ * Scale a surface to size w x h. The filter is one of AG_SCALE_NEAREST,
+ * AG_SCALE_BOX, AG_SCALE_BILINEAR or AG_SCALE_LANCZOS3. Indexed and
+ * colorkeyed surfaces are always scaled with AG_SCALE_NEAREST, as are
+ * all surfaces if the filter's temporary buffers cannot be allocated.
+ */
+AG_Surface *
+AG_SurfaceScale(const AG_Surface *S, Uint w, Uint h, Uint flags)
+{
+	AG_Surface *D;
+	Uint filter = (flags & AG_SCALE_FILTER);
+
+#ifdef DEBUG_SURFACE
+	if (S->flags & AG_SURFACE_TRACE)
+		Debug(NULL, "Surface <%p>: Resize(%ux%u->%ux%u, 0x%x)\n",
+		    S, S->w, S->h, w,h, flags);
+#endif
+	if (S->format.mode == AG_SURFACE_INDEXED &&
+	    S->format.BitsPerPixel < 8 &&
+	    S->w < S->format.BitsPerPixel)
+		AG_FatalError("(1,2,4)bpp surfaces must be "
+		              "at least >=(8,4,2) pixels wide");
+
+	if (S->format.mode == AG_SURFACE_INDEXED ||
+	    (S->flags & AG_SURFACE_COLORKEY) ||
+	    S->w == 0 || S->h == 0)
+		filter = AG_SCALE_NEAREST;
+
+	if (flags & AG_SCALE_CACHE) {
+		ScaleCacheEnt *ent;
+
+		AG_MutexLock(&scaleCacheLock);
+		if ((ent = CacheLookup(S, w, h, filter)) != NULL) {
+			D = AG_SurfaceDup(ent->su);
+			D->colorkey = S->colorkey;
+			D->alpha = S->alpha;
+			scaleCache.nHits++;
+			AG_MutexUnlock(&scaleCacheLock);
+			return (D);
+		}
+		scaleCache.nMisses++;
+		AG_MutexUnlock(&scaleCacheLock);
+	}
+
+	D = AG_SurfaceNew(&S->format, w,h, S->flags & AG_SAVED_SURFACE_FLAGS);
+	D->colorkey = S->colorkey;
+	D->alpha = S->alpha;
+
+	if (S->w == w && S->h == h) {			/* Simple copy */
+		AG_SurfaceCopy(D, S);
+		return (D);
+	}
+	if (w == 0 || h == 0) {
+		return (D);
+	}
+	if (filter == AG_SCALE_NEAREST ||
+	    ScaleFiltered(S, D, flags) == -1) {         /* Or out of memory */
+		ScaleNearest(S, D);
+	}
+	if (flags & AG_SCALE_CACHE) {
+		CacheInsert(S, D, filter);
+	}
+	return (D);
+}
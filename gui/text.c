@@ -338,25 +338,110 @@ AG_PopTextState(void)
 	--agTextStateCur;
 }
 
-/* Clear the glyph cache. */
+/* Initialize a glyph cache. */
 void
-AG_TextClearGlyphCache(AG_Driver *drv)
+AG_TextInitGlyphCache(AG_GlyphCache *gc)
 {
 	int i;
-	AG_Glyph *G, *Gnext;
 
 	for (i = 0; i < AG_GLYPH_NBUCKETS; i++) {
-		for (G = SLIST_FIRST(&drv->glyphCache[i].glyphs);
-		     G != SLIST_END(&drv->glyphCache[i].glyphs);
-		     G = Gnext) {
-			Gnext = SLIST_NEXT(G, glyphs);
-			AG_SurfaceFree(G->su);
-			free(G);
-		}
-		SLIST_INIT(&drv->glyphCache[i].glyphs);
+		SLIST_INIT(&gc->buckets[i]);
+	}
+	TAILQ_INIT(&gc->pages);
+	gc->budget = AG_GLYPH_CACHE_BUDGET;
+	gc->size = 0;
+	gc->nPages = 0;
+	gc->nGlyphs = 0;
+	gc->nHits = 0;
+	gc->nMisses = 0;
+	gc->nEvictions = 0;
+}
+
+static __inline__ Uint
+GlyphHash(const AG_Font *_Nonnull font, AG_Char ch)
+{
+	return (Uint)(((AG_Size)font >> 4) ^ ((Uint)ch * 2654435761U)) %
+	       AG_GLYPH_NBUCKETS;
+}
+
+/* Remove a glyph from its cache bucket and free it. */
+static void
+FreeGlyph(AG_GlyphCache *_Nonnull gc, AG_Glyph *_Nonnull G)
+{
+	SLIST_REMOVE(&gc->buckets[GlyphHash(G->font, G->ch)], G, ag_glyph,
+	    glyphs);
+	AG_SurfaceFree(G->su);
+	free(G);
+	gc->nGlyphs--;
+}
+
+/* Free an atlas page and all the glyphs it contains. */
+static void
+FreeGlyphPage(AG_Driver *_Nonnull drv, AG_GlyphPage *_Nonnull pg)
+{
+	AG_GlyphCache *gc = drv->glyphCache;
+	AG_Glyph *G, *Gnext;
+
+	for (G = SLIST_FIRST(&pg->glyphs);
+	     G != SLIST_END(&pg->glyphs);
+	     G = Gnext) {
+		Gnext = SLIST_NEXT(G, pglyphs);
+		FreeGlyph(gc, G);
+	}
+	if (pg->texture != 0) {
+		AGDRIVER_CLASS(drv)->deleteTexture(drv, pg->texture);
+	}
+	TAILQ_REMOVE(&gc->pages, pg, pages);
+	gc->size -= pg->S->h * pg->S->pitch;
+	gc->nPages--;
+	AG_SurfaceFree(pg->S);
+	free(pg);
+}
+
+/* Evict the least recently used atlas page. */
+static void
+EvictGlyphPage(AG_Driver *_Nonnull drv)
+{
+	AG_GlyphCache *gc = drv->glyphCache;
+	AG_GlyphPage *pg;
+
+	if ((pg = TAILQ_LAST(&gc->pages, ag_glyph_pageq)) != NULL) {
+		gc->nEvictions += pg->nGlyphs;
+		FreeGlyphPage(drv, pg);
+	}
+}
+
+/*
+ * Clear the glyph cache. Textures associated with atlas pages are not
+ * deleted (the caller is expected to have invalidated the GL context).
+ */
+void
+AG_TextClearGlyphCache(AG_Driver *drv)
+{
+	AG_GlyphCache *gc = drv->glyphCache;
+	AG_GlyphPage *pg;
+
+	while ((pg = TAILQ_FIRST(&gc->pages)) != NULL) {
+		pg->texture = 0;
+		FreeGlyphPage(drv, pg);
 	}
 }
 
+/*
+ * Set the memory budget (in bytes) of the glyph atlas of a driver. Evict
+ * least recently used pages until the cache fits. At least one page is
+ * always allowed regardless of the budget.
+ */
+void
+AG_TextSetGlyphCacheBudget(AG_Driver *drv, AG_Size budget)
+{
+	AG_GlyphCache *gc = drv->glyphCache;
+
+	gc->budget = budget;
+	while (gc->size > budget && gc->nPages > 1)
+		EvictGlyphPage(drv);
+}
+
 static __inline__ void
 InitMetrics(AG_TextMetrics *_Nonnull Tm)
 {
@@ -1200,52 +1285,172 @@ AG_TextExportUnicode_StripANSI(const char *encoding, char *dst, const AG_Char *u
 	}
 }
 
+/*
+ * Allocate a w x h area (plus a 1-pixel gutter) in a page of the atlas,
+ * creating or evicting pages as needed to stay under the memory budget.
+ */
+static AG_GlyphPage *_Nonnull
+AllocGlyphArea(AG_Driver *_Nonnull drv, int w, int h, int *_Nonnull x,
+    int *_Nonnull y)
+{
+	AG_GlyphCache *gc = drv->glyphCache;
+	AG_GlyphPage *pg;
+	AG_Size pgSize;
+	int wPage = AG_GLYPH_PAGE_SIZE, hPage = AG_GLYPH_PAGE_SIZE;
+
+	w++;
+	h++;
+	for (;;) {
+		TAILQ_FOREACH(pg, &gc->pages, pages) {
+			const int wPg = (int)pg->S->w;
+			const int hPg = (int)pg->S->h;
+
+			if (pg->xShelf + w <= wPg &&
+			    pg->yShelf + h <= hPg) {          /* Current shelf */
+				*x = pg->xShelf;
+				*y = pg->yShelf;
+				pg->xShelf += w;
+				if (h > pg->hShelf) { pg->hShelf = h; }
+				return (pg);
+			}
+			if (w <= wPg &&
+			    pg->yShelf + pg->hShelf + h <= hPg) {   /* New shelf */
+				pg->yShelf += pg->hShelf;
+				pg->xShelf = w;
+				pg->hShelf = h;
+				*x = 0;
+				*y = pg->yShelf;
+				return (pg);
+			}
+		}
+		while (wPage < w) { wPage <<= 1; }         /* Oversized glyph */
+		while (hPage < h) { hPage <<= 1; }
+		pgSize = (AG_Size)wPage * hPage * agSurfaceFmt->BytesPerPixel;
+		if (gc->nPages == 0 || gc->size + pgSize <= gc->budget) {
+			break;
+		}
+		EvictGlyphPage(drv);
+	}
+
+	pg = Malloc(sizeof(AG_GlyphPage));
+	pg->S = AG_SurfaceNew(agSurfaceFmt, wPage, hPage, 0);
+	memset(pg->S->pixels, 0, pg->S->h * pg->S->pitch);
+	pg->flags = 0;
+	pg->texture = 0;
+	pg->texcoords.x = 0.0f;
+	pg->texcoords.y = 0.0f;
+	pg->texcoords.w = 1.0f;
+	pg->texcoords.h = 1.0f;
+	pg->xShelf = w;
+	pg->yShelf = 0;
+	pg->hShelf = h;
+	pg->nGlyphs = 0;
+	SLIST_INIT(&pg->glyphs);
+	TAILQ_INSERT_HEAD(&gc->pages, pg, pages);
+	gc->size += pg->S->h * pg->S->pitch;
+	gc->nPages++;
+	*x = 0;
+	*y = 0;
+	return (pg);
+}
+
 static AG_Glyph *_Nonnull
 TextRenderGlyph_Miss(AG_Driver *_Nonnull drv, AG_Font *_Nonnull font,
-    const AG_Color *_Nonnull cBg, const AG_Color *_Nonnull cFg, AG_Char ch)
+    AG_Char ch)
 {
+	AG_Color cBg, cFg;
+	AG_GlyphPage *pg;
+	AG_Surface *S, *Sv;
 	AG_Glyph *G;
 	AG_Char s[2];
+	int x, y;
+
+	cBg.r = 0;                                       /* Transparent */
+	cBg.g = 0;
+	cBg.b = 0;
+	cBg.a = AG_TRANSPARENT;
+	cFg.r = AG_COLOR_LAST;                           /* Opaque white */
+	cFg.g = AG_COLOR_LAST;
+	cFg.b = AG_COLOR_LAST;
+	cFg.a = AG_OPAQUE;
+	s[0] = ch;
+	s[1] = '\0';
+	S = AG_TextRenderInternal(s, font, &cBg, &cFg);  /* Render glyph mask */
+
+	pg = AllocGlyphArea(drv, S->w, S->h, &x, &y);
+
+	/* Create a view of the allocated area, and copy the rendering. */
+	Sv = AG_SurfaceNew(&pg->S->format, S->w, S->h, AG_SURFACE_EXT_PIXELS);
+	Sv->pixels = pg->S->pixels + y*pg->S->pitch +
+	             x*pg->S->format.BytesPerPixel;
+	Sv->pitch = pg->S->pitch;
+	Sv->padding = pg->S->pitch - S->w*pg->S->format.BytesPerPixel;
+	memcpy(Sv->guides, S->guides, sizeof(S->guides));
+	AG_SurfaceCopy(Sv, S);
+	AG_SurfaceFree(S);
 
 	G = Malloc(sizeof(AG_Glyph));
-	G->font = (AG_Font *)font;
-	G->colorBG = *cBg;
-	G->color = *cFg;
+	G->font = font;
+	G->su = Sv;
+	G->page = pg;
 	G->ch = ch;
-	s[0] = ch;
-	s[1] = '\0';
-	G->su = AG_TextRenderInternal(s, font, cBg,cFg);    /* Render glyph */
+	G->flags = (font->spec.type == AG_FONT_BITMAP) ? AG_GLYPH_COLORED : 0;
+	G->x = x;
+	G->y = y;
+	G->texcoords.x = pg->texcoords.w * (float)x / (float)pg->S->w;
+	G->texcoords.y = pg->texcoords.h * (float)y / (float)pg->S->h;
+	G->texcoords.w = pg->texcoords.w * (float)(x + Sv->w) / (float)pg->S->w;
+	G->texcoords.h = pg->texcoords.h * (float)(y + Sv->h) / (float)pg->S->h;
 	AGFONT_OPS(font)->get_glyph_metrics(font, G);    /* Get the advance */
-	AGDRIVER_CLASS(drv)->updateGlyph(drv, G);   /* Prepare GPU transfer */
+
+	SLIST_INSERT_HEAD(&pg->glyphs, G, pglyphs);
+	pg->nGlyphs++;
+	pg->flags |= AG_GLYPH_PAGE_DIRTY;
 	return (G);
 }
 
 /*
- * Render character ch using the given font and BG/FG colors. Cache the
- * result in the per-driver glyph cache. The glyph cache is stored in
- * AG_Driver(3) instances because glyph renderings may be associated with
+ * Return the cached rendering of character ch in the given font, rendering
+ * it into the per-driver glyph atlas on a miss. The glyph cache is stored in
+ * AG_Driver(3) instances because atlas pages may be associated with
  * driver-specific hardware textures.
  *
+ * Glyphs are cached by font and character only. The BG and FG colors are
+ * recorded in the returned glyph and applied by the driver's drawGlyph().
+ * The returned pointer is valid until the next AG_TextRenderGlyph() call
+ * (which may evict its atlas page).
+ *
  * Must be called from GUI rendering context.
  */
 AG_Glyph *
 AG_TextRenderGlyph(AG_Driver *drv, AG_Font *font,
     const AG_Color *cBg, const AG_Color *cFg, AG_Char ch)
 {
+	AG_GlyphCache *gc = drv->glyphCache;
 	AG_Glyph *G;
-	const Uint h = (Uint)(ch % AG_GLYPH_NBUCKETS);
+	const Uint h = GlyphHash(font, ch);
 
-	SLIST_FOREACH(G, &drv->glyphCache[h].glyphs, glyphs) {
-		if (ch == G->ch &&
-		    font == G->font &&
-		    AG_ColorCompare(cBg, &G->colorBG) == 0 &&
-		    AG_ColorCompare(cFg, &G->color) == 0)
+	SLIST_FOREACH(G, &gc->buckets[h], glyphs) {
+		if (ch == G->ch && font == G->font)
 			break;
 	}
-	if (G == NULL) {
-		G = TextRenderGlyph_Miss(drv, font, cBg, cFg, ch);
-		SLIST_INSERT_HEAD(&drv->glyphCache[h].glyphs, G, glyphs);
+	if (G != NULL) {
+		gc->nHits++;
+		AG_PerfCount(AG_PERF_GLYPH_HITS);
+		if (G->page != TAILQ_FIRST(&gc->pages)) {   /* Mark recently used */
+			TAILQ_REMOVE(&gc->pages, G->page, pages);
+			TAILQ_INSERT_HEAD(&gc->pages, G->page, pages);
+		}
+	} else {
+		gc->nMisses++;
+		AG_PerfCount(AG_PERF_GLYPH_MISSES);
+		G = TextRenderGlyph_Miss(drv, font, ch);
+		SLIST_INSERT_HEAD(&gc->buckets[h], G, glyphs);
+		gc->nGlyphs++;
 	}
+	G->colorBG = *cBg;
+	G->color = *cFg;
+	AGDRIVER_CLASS(drv)->updateGlyph(drv, G);
 	return (G);
 }
 
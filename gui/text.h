@@ -268,7 +268,9 @@ AG_Font *_Nullable AG_TextFontPts(float);
 AG_Font *_Nullable AG_TextFontPct(int);
 AG_Font *_Nullable AG_TextFontPctFlags(int, Uint);
 void               AG_PopTextState(void);
+void               AG_TextInitGlyphCache(AG_GlyphCache *_Nonnull);
 void               AG_TextClearGlyphCache(AG_Driver *_Nonnull);
+void               AG_TextSetGlyphCacheBudget(AG_Driver *_Nonnull, AG_Size);
 
 void AG_TextSize(const char *_Nullable, int *_Nullable, int *_Nullable);
 void AG_TextSizeMulti(const char *_Nonnull, int *_Nonnull, int *_Nonnull,
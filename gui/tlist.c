@@ -41,6 +41,14 @@
 #ifndef AG_TLIST_EXP_LEVELS_INIT
 #define AG_TLIST_EXP_LEVELS_INIT 8  /* Initial tree-expansion state buffer size */
 #endif
+#ifndef AG_TLIST_INDEX_INIT
+#define AG_TLIST_INDEX_INIT 64      /* Initial item index size (VIRTUAL mode) */
+#endif
+#ifndef AG_TLIST_SAVED_INIT
+#define AG_TLIST_SAVED_INIT 16      /* Initial saved item state buffer size */
+#endif
+
+static void InitItem(AG_TlistItem *_Nonnull, const AG_Surface *_Nullable);
 
 AG_Tlist *
 AG_TlistNew(void *parent, Uint flags)
@@ -161,6 +169,15 @@ SelectionVisible(AG_Tlist *_Nonnull tl)
 	yLast = HEIGHT(tl)-item_h;
 	rOffs = tl->rOffs;
 
+	if ((tl->flags & AG_TLIST_STALE_INDEX) == 0) {   /* Use the index */
+		for (i = rOffs; i < tl->nIndex && y <= yLast; i++) {
+			if (tl->vIndex[i]->selected) {
+				return (1);
+			}
+			y += item_h;
+		}
+		return (0);
+	}
 	TAILQ_FOREACH(it, &tl->items, items) {
 		if (i++ < rOffs)
 			continue;
@@ -491,14 +508,14 @@ Destroy(void *_Nonnull p)
 	AG_TlistItem *it, *nit;
 	AG_TlistPopup *tp, *ntp;
 
-	for (it = TAILQ_FIRST(&tl->selitems);
-	     it != TAILQ_END(&tl->selitems);
+	for (it = TAILQ_FIRST(&tl->items);
+	     it != TAILQ_END(&tl->items);
 	     it = nit) {
-		nit = TAILQ_NEXT(it, selitems);
+		nit = TAILQ_NEXT(it, items);
 		FreeItem(tl, it);
 	}
-	for (it = TAILQ_FIRST(&tl->items);
-	     it != TAILQ_END(&tl->items);
+	for (it = TAILQ_FIRST(&tl->pool);
+	     it != TAILQ_END(&tl->pool);
 	     it = nit) {
 		nit = TAILQ_NEXT(it, items);
 		FreeItem(tl, it);
@@ -511,6 +528,9 @@ Destroy(void *_Nonnull p)
 		free(tp);
 	}
 	free(tl->expLevels);
+	Free(tl->vIndex);
+	Free(tl->saved);
+	Free(tl->savedTbl);
 }
 
 static void
@@ -602,28 +622,294 @@ DrawExpandCollapse(AG_Tlist *_Nonnull tl, AG_TlistItem *_Nonnull it,
 	}
 }
 
+/* Render the label surface of an item (in the given state). */
+static int
+RenderItemLabel(AG_Tlist *_Nonnull tl, AG_TlistItem *_Nonnull it,
+    int disabledItem, const AG_Color *_Nonnull cSel)
+{
+	AG_Surface *S, *Stext;
+	const AG_Color *cItemBg = (disabledItem) ?
+	                          &WCOLOR_DISABLED(tl,BG_COLOR) :
+	                          &WCOLOR_DEFAULT(tl,BG_COLOR);
+	const int hItem = tl->item_h;
+	const int hItem_2 = (hItem >> 1);
+	const int spacingHoriz = WIDGET(tl)->spacingHoriz;
+	int x = 0, wReq, yAligned;
+
+	if (it->color != NULL) {                               /* Alt color */
+		AG_TextColor(it->color);
+	} else {
+		AG_TextColor(disabledItem ?
+		    &WCOLOR_DISABLED(tl,TEXT_COLOR) :
+		    &WCOLOR_DEFAULT(tl,TEXT_COLOR));
+	}
+	if (it->font != NULL) {                                 /* Alt font */
+		AG_PushTextState();
+		AG_TextFont(it->font);
+		Stext = AG_TextRender(it->text);
+		AG_PopTextState();
+	} else {
+		Stext = AG_TextRender(it->text);
+	}
+
+	wReq = Stext->w;
+
+	if (it->iconsrc)
+		wReq += tl->icon_w + spacingHoriz;
+
+	S = AG_SurfaceStdRGB(wReq, hItem);
+#ifdef AG_DEBUG
+	/* Make it easier to inspect guides in Debugger. */
+	S->guides[0] = Stext->guides[0];
+#endif
+	AG_FillRect(S, NULL, it->selected ? cSel : cItemBg);
+
+	if (it->iconsrc != NULL) {
+		const AG_Surface *Sicon = it->iconsrc;
+
+		if (Sicon->w > hItem || Sicon->h > hItem) {
+			AG_Surface *SiconPr;
+
+			SiconPr = AG_SurfaceScale(Sicon, tl->icon_w, hItem,
+			    AG_SCALE_BILINEAR | AG_SCALE_CACHE);
+			if (SiconPr != NULL) {
+				yAligned = hItem_2 - (SiconPr->h >> 1);
+				if (yAligned < 0)
+					yAligned = 0;
+
+				AG_SurfaceBlit(SiconPr, NULL, S, x,yAligned);
+				AG_SurfaceFree(SiconPr);
+			}
+			x += hItem + spacingHoriz;
+		} else {
+			yAligned = hItem_2 - (Sicon->h >> 1);
+			if (yAligned < 0)
+				yAligned = 0;
+
+			AG_SurfaceBlit(Sicon, NULL, S, x,yAligned);
+
+			x += Sicon->w + spacingHoriz;
+		}
+	}
+
+	yAligned = (Stext->guides[0] >> 1) - hItem_2;
+	if (yAligned < 0) {
+		yAligned = 0;
+	}
+	yAligned += WIDGET(tl)->paddingTop;
+	if (yAligned < 0)
+		yAligned = 0;
+
+	AG_SurfaceBlit(Stext, NULL, S, x, yAligned);
+	AG_SurfaceFree(Stext);
+
+	return AG_WidgetMapSurface(tl, S);
+}
+
+/*
+ * Draw a single item at y (and the tree lines leading to it).
+ * Return 1 if the item is selected.
+ */
+static int
+DrawItem(AG_Tlist *_Nonnull tl, AG_TlistItem *_Nonnull it,
+    const AG_TlistItem *_Nullable itNext, int y)
+{
+	const int paddingLeft = WIDGET(tl)->paddingLeft;
+	const int hItem = tl->item_h;
+	const int hItem_2 = (hItem >> 1);
+	const AG_Color *cLine = &WCOLOR(tl,LINE_COLOR);
+	const AG_Color *cBg = &WCOLOR(tl,BG_COLOR);
+	AG_Color *cSel;
+	int *lbl, disabledItem, j;
+
+	disabledItem = ((WIDGET(tl)->flags & AG_WIDGET_DISABLED) ||
+	                (it->flags & AG_TLIST_ITEM_DISABLED));
+	if (disabledItem) {
+		lbl = &it->label[0];
+		cSel = &WCOLOR_DISABLED(tl,SELECTION_COLOR);
+	} else {
+		lbl = (it->selected) ? &it->label[2] : &it->label[1];
+		cSel = &WCOLOR_DEFAULT(tl,SELECTION_COLOR);
+	}
+	if (*lbl == -1)                                /* Render item label */
+		*lbl = RenderItemLabel(tl, it, disabledItem, cSel);
+
+	AG_WidgetBlitSurface(tl, *lbl,
+	    paddingLeft + ((it->depth + 1)*hItem),
+	    y);
+
+	if (it->selected) {           /* Fill in remaining BG to match label */
+		AG_Rect rs;
+
+		rs.x = paddingLeft + (it->depth + 1)*hItem +
+		       WSURFACE(tl,*lbl)->w;
+		rs.y = y;
+		rs.w = WIDTH(tl) - rs.x - WIDTH(tl->sbar);
+		rs.h = hItem + 1;
+		if (rs.w > 0) {
+			AG_DrawRect(tl, &rs, cSel);
+		}
+		rs.x = 0;
+		rs.w = paddingLeft + (it->depth + 1)*hItem + 1;
+		AG_DrawRect(tl, &rs, cSel);
+	}
+
+	/*
+	 * Tree lines (forward).
+	 */
+	if (it->depth > 0) {
+		for (j = 0; j < it->depth - 1; j++) {
+			if (!tl->expLevels[j]) {
+				continue;
+			}
+			AG_DrawLineV(tl,
+			    (j * hItem) + hItem_2,                     /* x */
+			    y,                                        /* y1 */
+			    y+hItem,                                  /* y2 */
+			    cLine);
+		}
+		if (itNext == NULL || itNext->depth < it->depth) {
+			AG_DrawLineV(tl,
+			    (it->depth - 1)*hItem + hItem_2,           /* x */
+			    y,                                        /* y1 */
+			    y + hItem_2,                              /* y2 */
+			    cLine);
+		} else {
+			AG_DrawLineV(tl,
+			    (it->depth - 1)*hItem + hItem_2,           /* x */
+			    y,                                        /* y1 */
+			    y + hItem,                                /* y2 */
+			    cLine);
+		}
+	}
+
+	/*
+	 * Tree lines (backtracking).
+	 */
+	if (itNext != NULL) {
+		if (itNext->depth > it->depth) {
+			SetExpansionLevel(tl, it->depth, y+hItem_2+1);
+		} else if (itNext->depth < it->depth) {
+			if ((it->depth - itNext->depth) > 1) {
+				for (j = itNext->depth;          /* Backtrack */
+				     j < it->depth - 1;
+				     j++) {
+					AG_DrawLineV(tl,
+					    j*hItem + hItem_2,           /* x */
+					    tl->expLevels[j+1],         /* y1 */
+					    y + hItem,                  /* y2 */
+					    cBg);
+				}
+			}
+			SetExpansionLevel(tl, it->depth, 0);
+		}
+	}
+
+	AG_DrawLineH(tl,
+	    ((it->depth - 1) * hItem) + (hItem >> 1),               /* x1 */
+	    (    (it->depth) * hItem) + (hItem >> 1),               /* x2 */
+	    y + (hItem >> 1),                                       /* y */
+	    cLine);
+
+	if (it->flags & AG_TLIST_HAS_CHILDREN) {
+		DrawExpandCollapse(tl,it,
+		    (it->depth * hItem),
+		    y);
+	}
+
+	AG_DrawLineH(tl, 0, (tl->r.w - 2), y + hItem,
+	    &tl->cBgLine[WIDGET(tl)->state]);
+
+	return (!disabledItem && it->selected);
+}
+
+/*
+ * Rebuild the item index of a VIRTUAL list, and release the labels of
+ * all items outside of the range of rows [first,last).
+ */
+static void
+UpdateIndex(AG_Tlist *_Nonnull tl, int first, int last)
+{
+	AG_TlistItem *it;
+	int i = 0;
+
+	if (tl->nItems > tl->maxIndex) {
+		tl->maxIndex = MAX(tl->nItems, tl->maxIndex << 1);
+		tl->vIndex = Realloc(tl->vIndex,
+		    tl->maxIndex * sizeof(AG_TlistItem *));
+	}
+	TAILQ_FOREACH(it, &tl->items, items) {
+		if (i < first || i >= last) {
+			InvalidateLabels(tl, it);
+		}
+		tl->vIndex[i++] = it;
+	}
+	tl->nIndex = i;
+	tl->flags &= ~(AG_TLIST_STALE_INDEX);
+}
+
+/*
+ * Draw the visible rows of a VIRTUAL list. The rows are found through the
+ * index, so the cost depends on the number of visible rows only (except when
+ * the index needs to be rebuilt after changes to the list). Labels of items
+ * leaving the view are released, labels of other items are preserved until
+ * the next style change. Return 1 if a selected item was drawn.
+ */
+static int
+DrawVirtual(AG_Tlist *_Nonnull tl)
+{
+	const int hItem = tl->item_h;
+	const int nRows = (HEIGHT(tl) + hItem - 1) / hItem;
+	AG_TlistItem *it;
+	int i, j, first, last, selSeen = 0, y;
+
+	first = MAX(0, tl->rOffs);
+	last = MIN(first + nRows, tl->nItems);
+
+	if (tl->flags & AG_TLIST_STALE_INDEX) {
+		UpdateIndex(tl, first, last);
+	} else {
+		for (i = tl->vFirst; i < tl->vLast && i < tl->nIndex; i++) {
+			if (i < first || i >= last)
+				InvalidateLabels(tl, tl->vIndex[i]);
+		}
+	}
+	if (last > tl->nIndex) {
+		last = tl->nIndex;
+	}
+	tl->vFirst = first;
+	tl->vLast = last;
+
+	if (first < last) {             /* Expanded levels above the view */
+		it = tl->vIndex[first];
+		for (j = 0; j < it->depth; j++)
+			SetExpansionLevel(tl, j, 1);
+	}
+	for (i = first, y = 0; i < last; i++, y += hItem) {
+		it = tl->vIndex[i];
+		selSeen |= DrawItem(tl, it,
+		    (i+1 < tl->nIndex) ? tl->vIndex[i+1] : NULL, y);
+	}
+	return (selSeen);
+}
+
 static void
 Draw(void *_Nonnull obj)
 {
 	AG_Tlist *tl = obj;
 	AG_TlistItem *it;
 	const int h = HEIGHT(tl);
-	const int paddingTop   = WIDGET(tl)->paddingTop;
-	const int paddingLeft  = WIDGET(tl)->paddingLeft;
-	const int spacingHoriz = WIDGET(tl)->spacingHoriz;
 	const int hItem = tl->item_h;
 	const int hItem_2 = (hItem >> 1);
 	const int rOffs = tl->rOffs;
-	const int disabled = (WIDGET(tl)->flags & AG_WIDGET_DISABLED);
-	const AG_Color *cLine   = &WCOLOR(tl,LINE_COLOR);
-	const AG_Color *cBg     = &WCOLOR(tl,BG_COLOR);
-	const AG_Color *cBgLine = &tl->cBgLine[WIDGET(tl)->state];
+	const AG_Color *cBg = &WCOLOR(tl,BG_COLOR);
 	AG_Rect r = tl->r;
-	int y, i=0, j, selSeen=0, selPos=1, yLast;
-
-	TAILQ_FOREACH(it, &tl->items, items)
-		InvalidateLabels(tl, it);
+	int y, i=0, j, selSeen=0, selPos=1;
 
+	if (!(tl->flags & AG_TLIST_VIRTUAL)) {
+		TAILQ_FOREACH(it, &tl->items, items)
+			InvalidateLabels(tl, it);
+	}
 	UpdatePolled(tl);
 
 	memset(tl->expLevels, 0, tl->nExpLevels * sizeof(int));
@@ -636,12 +922,22 @@ Draw(void *_Nonnull obj)
 	r.h--;
 	AG_PushClipRect(tl, &r);
 
+	if (tl->flags & AG_TLIST_VIRTUAL) {
+		selSeen = DrawVirtual(tl);
+		if (!selSeen && (tl->flags & AG_TLIST_SCROLLTOSEL)) {
+			for (i = 0; i < rOffs && i < tl->nIndex; i++) {
+				if (tl->vIndex[i]->selected) {
+					selPos = -1;
+					break;
+				}
+			}
+		}
+		goto out;
+	}
+
 	y = 0;
-	yLast = h;
 	TAILQ_FOREACH(it, &tl->items, items) {
 		const AG_TlistItem *itNext = TAILQ_NEXT(it,items);
-		AG_Color *cSel;
-		int *lbl, disabledItem;
 
 		if (i++ < rOffs) {
 			if (it->selected)
@@ -656,7 +952,7 @@ Draw(void *_Nonnull obj)
 			}
 			continue;                                /* Clipped */
 		}
-		if (y >= yLast) {                               /* Overflow */
+		if (y >= h) {                                   /* Overflow */
 			if (itNext == NULL) {
 				break;                       /* End of list */
 			}
@@ -681,189 +977,12 @@ Draw(void *_Nonnull obj)
 			y += hItem;
 			continue;                                /* Clipped */
 		}
-
-		disabledItem = (disabled || (it->flags & AG_TLIST_ITEM_DISABLED));
-		if (disabledItem) {
-			lbl = &it->label[0];
-			cSel = &WCOLOR_DISABLED(tl,SELECTION_COLOR);
-		} else {
-			if (it->selected) {
-				lbl = &it->label[2];
-				selSeen = 1;
-			} else {
-				lbl = &it->label[1];
-			}
-			cSel = &WCOLOR_DEFAULT(tl,SELECTION_COLOR);
+		if (DrawItem(tl, it, itNext, y)) {
+			selSeen = 1;
 		}
-
-		if (*lbl == -1) {                      /* Render item label */
-			AG_Surface *S, *Stext;
-			AG_Color *cItemBg = (disabledItem) ?
-			                    &WCOLOR_DISABLED(tl,BG_COLOR) :
-			                    &WCOLOR_DEFAULT(tl,BG_COLOR);
-			int x = 0, wReq, yAligned;
-		
-			if (it->color != NULL) {               /* Alt color */
-				AG_TextColor(it->color);
-			} else {
-				AG_TextColor(disabledItem ?
-				    &WCOLOR_DISABLED(tl,TEXT_COLOR) :
-				    &WCOLOR_DEFAULT(tl,TEXT_COLOR));
-			}
-			if (it->font != NULL) {                 /* Alt font */
-				AG_PushTextState();
-				AG_TextFont(it->font);
-				Stext = AG_TextRender(it->text);
-				AG_PopTextState();
-			} else {
-				Stext = AG_TextRender(it->text);
-			}
-
-			wReq = Stext->w;
-
-			if (it->iconsrc)
-				wReq += tl->icon_w + spacingHoriz;
-
-			S = AG_SurfaceStdRGB(wReq, hItem);
-#ifdef AG_DEBUG
-			/* Make it easier to inspect guides in Debugger. */
-			S->guides[0] = Stext->guides[0];
-#endif
-			AG_FillRect(S, NULL, it->selected ? cSel : cItemBg);
-
-			if (it->iconsrc != NULL) {
-				const AG_Surface *Sicon = it->iconsrc;
-
-				if (Sicon->w > hItem || Sicon->h > hItem) {
-					AG_Surface *SiconPr;
-
-					SiconPr = AG_SurfaceScale(Sicon,
-					    tl->icon_w, hItem, 0);
-					if (SiconPr != NULL) {
-						yAligned = hItem_2 -
-						           (SiconPr->h >> 1);
-						if (yAligned < 0)
-							yAligned = 0;
-
-						AG_SurfaceBlit(SiconPr, NULL,
-						    S, x,yAligned);
-						AG_SurfaceFree(SiconPr);
-					}
-					x += hItem + spacingHoriz;
-				} else {
-					yAligned = hItem_2 - (Sicon->h >> 1);
-					if (yAligned < 0)
-						yAligned = 0;
-
-					AG_SurfaceBlit(Sicon, NULL, S,
-					    x,yAligned);
-
-					x += Sicon->w + spacingHoriz;
-				}
-			}
-
-			yAligned = (Stext->guides[0] >> 1) - hItem_2;
-			if (yAligned < 0) {
-				yAligned = 0;
-			}
-			yAligned += paddingTop;
-			if (yAligned < 0)
-				yAligned = 0;
-
-			AG_SurfaceBlit(Stext, NULL, S, x, yAligned);
-			AG_SurfaceFree(Stext);
-
-			*lbl = AG_WidgetMapSurface(tl, S);
-		}
-
-		AG_WidgetBlitSurface(tl, *lbl,
-		    paddingLeft + ((it->depth + 1)*hItem),
-		    y);
-
-		if (it->selected) {   /* Fill in remaining BG to match label */
-			AG_Rect rs;
-
-			rs.x = paddingLeft + (it->depth + 1)*hItem +
-			       WSURFACE(tl,*lbl)->w;
-			rs.y = y;
-			rs.w = WIDTH(tl) - rs.x - WIDTH(tl->sbar);
-			rs.h = hItem + 1;
-			if (rs.w > 0) {
-				AG_DrawRect(tl, &rs, cSel);
-			}
-			rs.x = 0;
-			rs.w = paddingLeft + (it->depth + 1)*hItem + 1;
-			AG_DrawRect(tl, &rs, cSel);
-		}
-
-		/*
-		 * Tree lines (forward).
-		 */
-		if (it->depth > 0) {
-			for (j = 0; j < it->depth - 1; j++) {
-				if (!tl->expLevels[j]) {
-					continue;
-				}
-				AG_DrawLineV(tl,
-				    (j * hItem) + hItem_2,             /* x */
-				    y,                                /* y1 */
-				    y+hItem,                          /* y2 */
-				    cLine);
-			}
-			if (itNext == NULL || itNext->depth < it->depth) {
-				AG_DrawLineV(tl,
-				    (it->depth - 1)*hItem + hItem_2,   /* x */
-				    y,                                /* y1 */
-				    y + hItem_2,                      /* y2 */
-				    cLine);
-			} else {
-				AG_DrawLineV(tl,
-				    (it->depth - 1)*hItem + hItem_2,   /* x */
-				    y,                                /* y1 */
-				    y + hItem,                        /* y2 */
-				    cLine);
-			}
-		}
-
-		/*
-		 * Tree lines (backtracking).
-		 */
-		if (itNext != NULL) {
-			if (itNext->depth > it->depth) {
-				SetExpansionLevel(tl, it->depth, y+hItem_2+1);
-			} else if (itNext->depth < it->depth) {
-				if ((it->depth - itNext->depth) > 1) {
-					for (j = itNext->depth;  /* Backtrack */
-					     j < it->depth - 1;
-					     j++) {
-						AG_DrawLineV(tl,
-						    j*hItem + hItem_2,   /* x */
-						    tl->expLevels[j+1], /* y1 */
-						    y + hItem,          /* y2 */
-						    cBg);
-					}
-				}
-				SetExpansionLevel(tl, it->depth, 0);
-			}
-		}
-
-		AG_DrawLineH(tl,
-		    ((it->depth - 1) * hItem) + (hItem >> 1),       /* x1 */
-		    (    (it->depth) * hItem) + (hItem >> 1),       /* x2 */
-		    y + (hItem >> 1),                               /* y */
-		    cLine);
-
-		if (it->flags & AG_TLIST_HAS_CHILDREN) {
-			DrawExpandCollapse(tl,it,
-			    (it->depth * hItem),
-			    y);
-		}
-
 		y += hItem;
-
-		AG_DrawLineH(tl, 0, (tl->r.w - 2), y, cBgLine);
 	}
-
+out:
 	if (!selSeen && (tl->flags & AG_TLIST_SCROLLTOSEL)) {
 		if (selPos == -1) {
 			tl->rOffs--;
@@ -885,6 +1004,7 @@ AG_TlistDel(AG_Tlist *tl, AG_TlistItem *it)
 
 	TAILQ_REMOVE(&tl->items, it, items);
 	tl->nItems--;
+	tl->flags |= AG_TLIST_STALE_INDEX;
 	FreeItem(tl, it);
 
 	/* Update the scrollbar range and offset accordingly. */
@@ -917,28 +1037,98 @@ restart:							/* XXX */
 	AG_ObjectUnlock(tl);
 }
 
-/* Clear the items on the list, save the selections if polling. */
+/* Build the hash index of the saved items. */
+static void
+IndexSavedItems(AG_Tlist *_Nonnull tl)
+{
+	Uint i, j, mask;
+
+	if (tl->nSavedTbl < (tl->nSaved << 1)) {
+		while (tl->nSavedTbl < (tl->nSaved << 1)) {
+			tl->nSavedTbl = MAX(AG_TLIST_SAVED_INIT,
+			                    tl->nSavedTbl << 1);
+		}
+		Free(tl->savedTbl);
+		tl->savedTbl = Malloc(tl->nSavedTbl * sizeof(Uint));
+	}
+	memset(tl->savedTbl, 0, tl->nSavedTbl * sizeof(Uint));
+	mask = tl->nSavedTbl - 1;
+
+	for (i = 0; i < tl->nSaved; i++) {
+		j = tl->hash_fn(&tl->saved[i]) & mask;
+		while (tl->savedTbl[j] != 0) {              /* Linear probing */
+			j = (j + 1) & mask;
+		}
+		tl->savedTbl[j] = i+1;
+	}
+}
+
+/*
+ * Return the saved state of an item (or NULL). Use the hash index if a
+ * hash function is set, otherwise compare against every saved item.
+ */
+static AG_TlistItem *_Nullable
+FindSavedItem(AG_Tlist *_Nonnull tl, const AG_TlistItem *_Nonnull it)
+{
+	AG_TlistItem *sit;
+	Uint i, j, mask;
+
+	if (tl->nSaved == 0) {
+		return (NULL);
+	}
+	if (tl->hash_fn != NULL) {
+		mask = tl->nSavedTbl - 1;
+		for (j = tl->hash_fn(it) & mask;
+		     (i = tl->savedTbl[j]) != 0;
+		     j = (j + 1) & mask) {
+			sit = &tl->saved[i-1];
+			if (tl->compare_fn(sit, it))
+				return (sit);
+		}
+		return (NULL);
+	}
+	for (i = 0; i < tl->nSaved; i++) {
+		sit = &tl->saved[i];
+		if (tl->compare_fn(sit, it))
+			return (sit);
+	}
+	return (NULL);
+}
+
+/*
+ * Clear the items on the list. Save the state of selected items and items
+ * with children (for AG_TlistEnd()), and recycle the items for reuse by
+ * subsequent AG_TlistAdd*() calls.
+ */
 void
 AG_TlistBegin(AG_Tlist *tl)
 {
-	AG_TlistItem *it, *nit;
+	AG_TlistItem *it;
 	
 	AG_OBJECT_ISA(tl, "AG_Widget:AG_Tlist:*");
 	AG_ObjectLock(tl);
 
-	for (it = TAILQ_FIRST(&tl->items);
-	     it != TAILQ_END(&tl->items);
-	     it = nit) {
-		nit = TAILQ_NEXT(it, items);
-		if ((!(tl->flags & AG_TLIST_NOSELSTATE) && it->selected) ||
+	tl->nSaved = 0;
+	while ((it = TAILQ_FIRST(&tl->items)) != NULL) {
+		if ((!(tl->flags & AG_TLIST_STATELESS) && it->selected) ||
 		      (it->flags & AG_TLIST_HAS_CHILDREN)) {
-			TAILQ_INSERT_HEAD(&tl->selitems, it, selitems);
-		} else {
-			FreeItem(tl, it);
+			if (tl->nSaved+1 > tl->maxSaved) {
+				tl->maxSaved = MAX(AG_TLIST_SAVED_INIT,
+				                   tl->maxSaved << 1);
+				tl->saved = Realloc(tl->saved, tl->maxSaved *
+				                    sizeof(AG_TlistItem));
+			}
+			memcpy(&tl->saved[tl->nSaved++], it,
+			    sizeof(AG_TlistItem));
 		}
+		TAILQ_REMOVE(&tl->items, it, items);
+		TAILQ_INSERT_TAIL(&tl->pool, it, items);
 	}
-	TAILQ_INIT(&tl->items);
 	tl->nItems = 0;
+	tl->flags |= AG_TLIST_STALE_INDEX;
+
+	if (tl->hash_fn != NULL && tl->nSaved > 0)
+		IndexSavedItems(tl);
 
 	AG_Redraw(tl);
 	AG_ObjectUnlock(tl);
@@ -988,7 +1178,56 @@ AG_TlistComparePtrsAndCats(const AG_TlistItem *a, const AG_TlistItem *b)
 		 (strcmp(a->cat, b->cat) == 0)));
 }
 
-/* Set an alternate compare function for items. */
+/* Hash the pointer p1 of an item (for use with AG_TlistComparePtrs()). */
+Uint
+AG_TlistHashPtrs(const AG_TlistItem *it)
+{
+	Ulong h = ((Ulong)it->p1) >> 3;
+
+	h ^= (h >> 16);
+	h *= 0x45d9f3bUL;
+	h ^= (h >> 16);
+	return (Uint)h;
+}
+
+/* Hash the text of an item (for use with AG_TlistCompareStrings()). */
+Uint
+AG_TlistHashStrings(const AG_TlistItem *it)
+{
+	const Uchar *c;
+	Uint32 h = 2166136261U;                                   /* FNV-1a */
+
+	for (c = (const Uchar *)it->text; *c != '\0'; c++) {
+		h ^= *c;
+		h *= 16777619U;
+	}
+	return (Uint)h;
+}
+
+/*
+ * Hash the pointer p1 and category cat of an item (for use with
+ * AG_TlistComparePtrsAndCats()).
+ */
+Uint
+AG_TlistHashPtrsAndCats(const AG_TlistItem *it)
+{
+	const Uchar *c;
+	Uint32 h = (Uint32)AG_TlistHashPtrs(it);
+
+	if (it->cat != NULL) {
+		for (c = (const Uchar *)it->cat; *c != '\0'; c++) {
+			h ^= *c;
+			h *= 16777619U;
+		}
+	}
+	return (Uint)h;
+}
+
+/*
+ * Set an alternate compare function for items. If fn is one of the stock
+ * compare functions, also set the matching hash function. Otherwise, clear
+ * the hash function (AG_TlistSetHashFn() may be used to set a new one).
+ */
 AG_TlistCompareFn
 AG_TlistSetCompareFn(AG_Tlist *tl,
     int (*fn)(const AG_TlistItem *_Nonnull, const AG_TlistItem *_Nonnull))
@@ -1001,29 +1240,63 @@ AG_TlistSetCompareFn(AG_Tlist *tl,
 	fnOrig = tl->compare_fn;
 	tl->compare_fn = fn;
 
+	if (fn == AG_TlistComparePtrs) {
+		tl->hash_fn = AG_TlistHashPtrs;
+	} else if (fn == AG_TlistComparePtrsAndCats) {
+		tl->hash_fn = AG_TlistHashPtrsAndCats;
+	} else if (fn == AG_TlistCompareStrings) {
+		tl->hash_fn = AG_TlistHashStrings;
+	} else {
+		tl->hash_fn = NULL;
+	}
+	tl->nSaved = 0;
+
 	AG_ObjectUnlock(tl);
 
 	return (fnOrig);
 }
 
-/* Restore previous item selection state. */
+/*
+ * Set a hash function for items, consistent with the compare function
+ * (items which compare as equal must have equal hashes). This allows
+ * AG_TlistEnd() to restore the saved state of items in linear time.
+ * If fn is NULL, saved items are compared against every item.
+ */
+AG_TlistHashFn
+AG_TlistSetHashFn(AG_Tlist *tl, AG_TlistHashFn fn)
+{
+	AG_TlistHashFn fnOrig;
+
+	AG_OBJECT_ISA(tl, "AG_Widget:AG_Tlist:*");
+	AG_ObjectLock(tl);
+
+	fnOrig = tl->hash_fn;
+	tl->hash_fn = fn;
+	tl->nSaved = 0;
+
+	AG_ObjectUnlock(tl);
+
+	return (fnOrig);
+}
+
+/*
+ * Restore the saved selection and expansion state of items, and free any
+ * recycled items which were not reused.
+ */
 void
 AG_TlistEnd(AG_Tlist *tl)
 {
-	AG_TlistItem *sit, *cit, *nsit;
+	AG_TlistItem *sit, *cit;
 
 	AG_OBJECT_ISA(tl, "AG_Widget:AG_Tlist:*");
 	AG_ObjectLock(tl);
 
-	for (sit = TAILQ_FIRST(&tl->selitems);
-	     sit != TAILQ_END(&tl->selitems);
-	     sit = nsit) {
-		nsit = TAILQ_NEXT(sit, selitems);
+	if (tl->nSaved > 0) {
 		TAILQ_FOREACH(cit, &tl->items, items) {
-			if (!tl->compare_fn(sit, cit)) {
+			if ((sit = FindSavedItem(tl, cit)) == NULL) {
 				continue;
 			}
-			if (!(tl->flags & AG_TLIST_NOSELSTATE)) {
+			if (!(tl->flags & AG_TLIST_STATELESS)) {
 				cit->selected = sit->selected;
 			}
 			if (sit->flags & AG_TLIST_ITEM_EXPANDED) {
@@ -1032,9 +1305,12 @@ AG_TlistEnd(AG_Tlist *tl)
 				cit->flags &= ~(AG_TLIST_ITEM_EXPANDED);
 			}
 		}
-		FreeItem(tl, sit);
+		tl->nSaved = 0;
+	}
+	while ((cit = TAILQ_FIRST(&tl->pool)) != NULL) {
+		TAILQ_REMOVE(&tl->pool, cit, items);
+		FreeItem(tl, cit);
 	}
-	TAILQ_INIT(&tl->selitems);
 
 	AG_ObjectUnlock(tl);
 }
@@ -1054,11 +1330,7 @@ AG_TlistVisibleChildren(AG_Tlist *tl, AG_TlistItem *it)
 	if ((it->flags & AG_TLIST_HAS_CHILDREN) == 0) {
 		return (0);
 	}
-	AG_TAILQ_FOREACH(itSaved, &tl->selitems, selitems) {
-		if (tl->compare_fn(itSaved, it))
-			break;
-	}
-	if (itSaved == NULL) {
+	if ((itSaved = FindSavedItem(tl, it)) == NULL) {
 		return (tl->flags & AG_TLIST_EXPAND_NODES);  /* Default state */
 	}
 	return (itSaved->flags & AG_TLIST_ITEM_EXPANDED);      /* Saved state */
@@ -1076,6 +1348,41 @@ AG_TlistRefresh(AG_Tlist *_Nonnull tl)
 	AG_ObjectUnlock(tl);
 }
 
+/*
+ * Return a new item with the given icon and text. Reuse an item recycled
+ * by AG_TlistBegin() if one is available. The label surfaces of a recycled
+ * item are preserved if its text is unchanged (and there are no icons,
+ * alternate colors or fonts involved).
+ */
+static AG_TlistItem *_Nonnull
+NewItem(AG_Tlist *_Nonnull tl, const AG_Surface *_Nullable icon,
+    const char *_Nonnull text)
+{
+	AG_TlistItem *it;
+
+	AG_ObjectLock(tl);
+	if ((it = TAILQ_FIRST(&tl->pool)) != NULL) {
+		TAILQ_REMOVE(&tl->pool, it, items);
+		if (icon != NULL || it->iconsrc != NULL ||
+		    it->color != NULL || it->font != NULL ||
+		    strcmp(it->text, text) != 0) {
+			InvalidateLabels(tl, it);
+		}
+		if (it->iconsrc != NULL) {
+			AG_SurfaceFree(it->iconsrc);
+		}
+		if (it->color != NULL) {
+			free(it->color);
+		}
+		InitItem(it, icon);
+	} else {
+		it = AG_TlistItemNew(icon);
+	}
+	Strlcpy(it->text, text, sizeof(it->text));
+	AG_ObjectUnlock(tl);
+	return (it);
+}
+
 static __inline__ void
 InsertItemHead(AG_Tlist *_Nonnull tl, AG_TlistItem *_Nonnull it)
 {
@@ -1083,6 +1390,7 @@ InsertItemHead(AG_Tlist *_Nonnull tl, AG_TlistItem *_Nonnull it)
 
 	TAILQ_INSERT_HEAD(&tl->items, it, items);
 	tl->nItems++;
+	tl->flags |= AG_TLIST_STALE_INDEX;
 
 	AG_Redraw(tl);
 	AG_ObjectUnlock(tl);
@@ -1096,6 +1404,15 @@ InsertItemTail(AG_Tlist *_Nonnull tl, AG_TlistItem *_Nonnull it)
 	TAILQ_INSERT_TAIL(&tl->items, it, items);
 	tl->nItems++;
 
+	if ((tl->flags & AG_TLIST_STALE_INDEX) == 0) {  /* Append to index */
+		if (tl->nIndex+1 > tl->maxIndex) {
+			tl->maxIndex = MAX(AG_TLIST_INDEX_INIT, tl->maxIndex << 1);
+			tl->vIndex = Realloc(tl->vIndex,
+			    tl->maxIndex * sizeof(AG_TlistItem *));
+		}
+		tl->vIndex[tl->nIndex++] = it;
+	}
+
 	AG_Redraw(tl);
 	AG_ObjectUnlock(tl);
 }
@@ -1109,9 +1426,8 @@ AG_TlistAddPtr(AG_Tlist *tl, const AG_Surface *icon, const char *text,
 
 	AG_OBJECT_ISA(tl, "AG_Widget:AG_Tlist:*");
 
-	it = AG_TlistItemNew(icon);
+	it = NewItem(tl, icon, text);
 	it->p1 = p1;
-	Strlcpy(it->text, text, sizeof(it->text));
 
 	InsertItemTail(tl, it);
 	return (it);
@@ -1122,15 +1438,16 @@ AG_TlistItem *_Nonnull
 AG_TlistAdd(AG_Tlist *tl, const AG_Surface *icon, const char *fmt, ...)
 {
 	AG_TlistItem *it;
+	char text[AG_TLIST_LABEL_MAX];
 	va_list args;
 
 	AG_OBJECT_ISA(tl, "AG_Widget:AG_Tlist:*");
 	
-	it = AG_TlistItemNew(icon);
-	it->p1 = it->text;
 	va_start(args, fmt);
-	Vsnprintf(it->text, sizeof(it->text), fmt, args);
+	Vsnprintf(text, sizeof(text), fmt, args);
 	va_end(args);
+	it = NewItem(tl, icon, text);
+	it->p1 = it->text;
 
 	InsertItemTail(tl, it);
 	return (it);
@@ -1144,9 +1461,8 @@ AG_TlistAddS(AG_Tlist *tl, const AG_Surface *icon, const char *text)
 
 	AG_OBJECT_ISA(tl, "AG_Widget:AG_Tlist:*");
 
-	it = AG_TlistItemNew(icon);
+	it = NewItem(tl, icon, text);
 	it->p1 = it->text;
-	Strlcpy(it->text, text, sizeof(it->text));
 
 	InsertItemTail(tl, it);
 	return (it);
@@ -1157,15 +1473,16 @@ AG_TlistItem *
 AG_TlistAddHead(AG_Tlist *tl, const AG_Surface *icon, const char *fmt, ...)
 {
 	AG_TlistItem *it;
+	char text[AG_TLIST_LABEL_MAX];
 	va_list args;
 
 	AG_OBJECT_ISA(tl, "AG_Widget:AG_Tlist:*");
 	
-	it = AG_TlistItemNew(icon);
-	it->p1 = it->text;
 	va_start(args, fmt);
-	Vsnprintf(it->text, sizeof(it->text), fmt, args);
+	Vsnprintf(text, sizeof(text), fmt, args);
 	va_end(args);
+	it = NewItem(tl, icon, text);
+	it->p1 = it->text;
 
 	InsertItemHead(tl, it);
 	return (it);
@@ -1179,9 +1496,8 @@ AG_TlistAddHeadS(AG_Tlist *tl, const AG_Surface *icon, const char *text)
 
 	AG_OBJECT_ISA(tl, "AG_Widget:AG_Tlist:*");
 
-	it = AG_TlistItemNew(icon);
+	it = NewItem(tl, icon, text);
 	it->p1 = it->text;
-	Strlcpy(it->text, text, sizeof(it->text));
 
 	InsertItemHead(tl, it);
 	return (it);
@@ -1196,9 +1512,8 @@ AG_TlistAddPtrHead(AG_Tlist *tl, const AG_Surface *icon, const char *text,
 
 	AG_OBJECT_ISA(tl, "AG_Widget:AG_Tlist:*");
 
-	it = AG_TlistItemNew(icon);
+	it = NewItem(tl, icon, text);
 	it->p1 = p1;
-	Strlcpy(it->text, text, sizeof(it->text));
 
 	InsertItemHead(tl, it);
 	return (it);
@@ -1213,6 +1528,7 @@ AG_TlistMoveToHead(AG_Tlist *tl, AG_TlistItem *it)
 
 	TAILQ_REMOVE(&tl->items, it, items);
 	TAILQ_INSERT_HEAD(&tl->items, it, items);
+	tl->flags |= AG_TLIST_STALE_INDEX;
 
 	AG_Redraw(tl);
 	AG_ObjectUnlock(tl);
@@ -1227,6 +1543,7 @@ AG_TlistMoveToTail(AG_Tlist *tl, AG_TlistItem *it)
 
 	TAILQ_REMOVE(&tl->items, it, items);
 	TAILQ_INSERT_TAIL(&tl->items, it, items);
+	tl->flags |= AG_TLIST_STALE_INDEX;
 
 	AG_Redraw(tl);
 	AG_ObjectUnlock(tl);
@@ -1245,6 +1562,14 @@ AG_TlistItemNew(const AG_Surface *icon)
 	it->label[0] = -1;
 	it->label[1] = -1;
 	it->label[2] = -1;
+	InitItem(it, icon);
+	return (it);
+}
+
+/* Initialize the fields of an item (except for the label surfaces). */
+static void
+InitItem(AG_TlistItem *_Nonnull it, const AG_Surface *_Nullable icon)
+{
 	it->v = -1;
 	it->cat = "";
 	it->iconsrc = (icon) ? AG_SurfaceDup(icon) : NULL;
@@ -1258,8 +1583,6 @@ AG_TlistItemNew(const AG_Surface *icon)
 	it->scale = 1.0f;
 	it->text[0] = '\0';
 	it->u = 0;
-
-	return (it);
 }
 
 /* Set the graphical icon to display along with an item. */
@@ -1799,12 +2122,24 @@ Init(void *_Nonnull obj)
 	tl->pollDelay = 1000;
 	tl->rOffs = 0;
 	tl->dblClicked = NULL;
+	tl->vIndex = NULL;
+	tl->nIndex = 0;
+	tl->maxIndex = 0;
+	tl->vFirst = 0;
+	tl->vLast = 0;
 	TAILQ_INIT(&tl->items);
 	TAILQ_INIT(&tl->selitems);
 	tl->nItems = 0;
 	tl->nVisible = 0;
 	TAILQ_INIT(&tl->popups);
 	tl->compare_fn = AG_TlistComparePtrs;
+	tl->hash_fn = AG_TlistHashPtrs;
+	TAILQ_INIT(&tl->pool);
+	tl->saved = NULL;
+	tl->nSaved = 0;
+	tl->maxSaved = 0;
+	tl->savedTbl = NULL;
+	tl->nSavedTbl = 0;
 	tl->popupEv = NULL;
 	tl->changedEv = NULL;
 	tl->dblClickEv = NULL;
@@ -1846,6 +2181,12 @@ AG_TlistFindByIndex(AG_Tlist *tl, int index)
 	AG_OBJECT_ISA(tl, "AG_Widget:AG_Tlist:*");
 	AG_ObjectLock(tl);
 
+	if ((tl->flags & AG_TLIST_STALE_INDEX) == 0) {   /* Use the index */
+		it = (index > 0 && index <= tl->nIndex) ?
+		     tl->vIndex[index-1] : NULL;
+		AG_ObjectUnlock(tl);
+		return (it);
+	}
 	TAILQ_FOREACH(it, &tl->items, items) {
 		if (++i == index) {
 			AG_ObjectUnlock(tl);
@@ -2179,6 +2520,8 @@ AG_TlistSort(AG_Tlist *tl)
 	for (i = 0; i < tl->nItems; i++)
 		TAILQ_INSERT_TAIL(&tl->items, items[i], items);
 
+	tl->flags |= AG_TLIST_STALE_INDEX;
+
 	AG_Redraw(tl);
 	AG_ObjectUnlock(tl);
 
@@ -2215,6 +2558,8 @@ AG_TlistSortByInt(AG_Tlist *tl)
 	for (i = 0; i < tl->nItems; i++)
 		TAILQ_INSERT_TAIL(&tl->items, items[i], items);
 
+	tl->flags |= AG_TLIST_STALE_INDEX;
+
 	AG_Redraw(tl);
 	AG_ObjectUnlock(tl);
 
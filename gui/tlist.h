@@ -62,6 +62,7 @@ typedef AG_TAILQ_HEAD(ag_tlist_itemq, ag_tlist_item) AG_TlistItemQ;
 
 typedef int (*AG_TlistCompareFn)(const AG_TlistItem *_Nonnull,
 	                         const AG_TlistItem *_Nonnull);
+typedef Uint (*AG_TlistHashFn)(const AG_TlistItem *_Nonnull);
 
 /* Tree/list widget */
 typedef struct ag_tlist {
@@ -80,6 +81,8 @@ typedef struct ag_tlist {
 #define AG_TLIST_REFRESH       0x0400      /* Repopulate now (polled mode) */
 #define AG_TLIST_EXPAND_NODES  0x0800      /* Expand node items (items with children) by default */
 #define AG_TLIST_NO_KEYREPEAT  0x1000      /* Disable keyrepeat behavior */
+#define AG_TLIST_VIRTUAL       0x2000      /* Draw visible rows only (indexed) */
+#define AG_TLIST_STALE_INDEX   0x4000      /* Item index needs rebuild (read-only) */
 #define AG_TLIST_EXPAND        (AG_TLIST_HFILL | AG_TLIST_VFILL)
 
 	int item_h;                     /* Item height */
@@ -93,12 +96,13 @@ typedef struct ag_tlist {
 	int rOffs;                      /* Row display offset */
 	void *_Nullable dblClicked;     /* For double click test */
 	AG_TlistItemQ items;            /* Current Items */
-	AG_TlistItemQ selitems;         /* Saved item state */
+	AG_TlistItemQ selitems;         /* Saved item state (unused) */
 	int nItems;                     /* Number of items total */
 	int nVisible;                   /* Number of items on screen */
 	AG_Scrollbar *_Nonnull sbar;    /* Vertical scrollbar */
 	AG_TAILQ_HEAD_(ag_tlist_popup) popups; /* Popup menus */
 	AG_TlistCompareFn compare_fn;   /* Item-item comparison function */
+	AG_TlistHashFn hash_fn;         /* Item hash function (or NULL) */
 	AG_Event *_Nullable popupEv;    /* Popup menu hook */
 	AG_Event *_Nullable changedEv;  /* Selection change hook */
 	AG_Event *_Nullable dblClickEv; /* Double click hook */
@@ -109,6 +113,16 @@ typedef struct ag_tlist {
 	AG_Timer dblClickTo;            /* Timer for detecting double clicks */
 	AG_Timer ctrlMoveTo;            /* Timer for controller-driven move */
 	AG_Color cBgLine[AG_WIDGET_NSTATES];  /* Background line color */
+	AG_TlistItem *_Nullable *_Nullable vIndex; /* Items by row index */
+	int nIndex;                     /* Items in index */
+	int maxIndex;                   /* Allocated index size */
+	int vFirst, vLast;              /* Rows with cached labels (VIRTUAL) */
+	AG_TlistItemQ pool;             /* Recycled items (AG_TlistBegin()) */
+	AG_TlistItem *_Nullable saved;  /* Saved item state (AG_TlistBegin()) */
+	Uint nSaved;                    /* Saved items */
+	Uint maxSaved;                  /* Allocated saved[] size */
+	Uint *_Nullable savedTbl;       /* Hash index into saved[] (or NULL) */
+	Uint nSavedTbl;                 /* Size of savedTbl (power of 2) */
 } AG_Tlist;
 
 #define AGTLIST(obj)            ((AG_Tlist *)(obj))
@@ -241,6 +255,7 @@ void AG_TlistSetChangedFn(AG_Tlist *_Nonnull, _Nonnull AG_EventFn,
                           const char *_Nullable, ...);
 
 AG_TlistCompareFn AG_TlistSetCompareFn(AG_Tlist *_Nonnull, AG_TlistCompareFn);
+AG_TlistHashFn    AG_TlistSetHashFn(AG_Tlist *_Nonnull, AG_TlistHashFn);
 
 int  AG_TlistCompareInts(const AG_TlistItem *_Nonnull, const AG_TlistItem *_Nonnull)
                          _Pure_Attribute;
@@ -257,6 +272,10 @@ int  AG_TlistComparePtrsAndCats(const AG_TlistItem *_Nonnull,
                                 const AG_TlistItem *_Nonnull)
                                 _Pure_Attribute;
 
+Uint AG_TlistHashPtrs(const AG_TlistItem *_Nonnull) _Pure_Attribute;
+Uint AG_TlistHashPtrsAndCats(const AG_TlistItem *_Nonnull) _Pure_Attribute;
+Uint AG_TlistHashStrings(const AG_TlistItem *_Nonnull) _Pure_Attribute;
+
 void AG_TlistSort(AG_Tlist *_Nonnull);
 void AG_TlistSortByInt(AG_Tlist *_Nonnull);
 void AG_TlistRefresh(AG_Tlist *_Nonnull);
@@ -201,6 +201,14 @@ AG_Widget *_Nullable agStyleEditorTgt = NULL;
 # endif
 #endif /* DEBUG_FOCUS */
 
+/*
+ * Total draw time of the children of each AG_WidgetDraw() call in progress,
+ * used to record the self time of widget classes (rendering context only).
+ */
+#define AG_WIDGET_DRAW_DEPTH_MAX 64
+static Uint64 agDrawChildTime[AG_WIDGET_DRAW_DEPTH_MAX];
+static int    agDrawDepth = 0;
+
 static void FocusWidget(AG_Widget *_Nonnull);
 static void UnfocusWidget(AG_Widget *_Nonnull);
 static void Apply_Font_Size(float *_Nonnull, float, const char *_Nonnull);
@@ -424,10 +432,7 @@ RedrawOnTickTimeout(AG_Timer *_Nonnull to, AG_Event *_Nonnull event)
 {
 	AG_Widget *wid = AG_WIDGET_SELF();
 
-	if (wid->window) {
-		AG_OBJECT_ISA(wid->window, "AG_Widget:AG_Window:*");
-		wid->window->dirty = 1;
-	}
+	AG_Redraw(wid);
 	return (to->ival);
 }
 
@@ -442,10 +447,7 @@ RedrawOnChangeTimeout(AG_Timer *_Nonnull to, AG_Event *_Nonnull event)
 	V = AG_GetVariable(wid, rt->name, &p);
 	AG_DerefVariable(&Vd, V);
 	if (!rt->VlastInited || AG_CompareVariables(&Vd, &rt->Vlast) != 0) {
-		if (wid->window) {
-			AG_OBJECT_ISA(wid->window, "AG_Widget:AG_Window:*");
-			wid->window->dirty = 1;
-		}
+		AG_Redraw(wid);
 		AG_CopyVariable(&rt->Vlast, &Vd);
 		rt->VlastInited = 1;
 	}
@@ -1647,9 +1649,8 @@ void
 AG_WidgetUpdateCoords(void *obj, int x, int y)
 {
 	AG_Widget *wid = obj, *chld;
-#ifdef HAVE_OPENGL
 	const AG_Rect2 rPrev = wid->rView;
-#endif
+
 	wid->flags &= ~(AG_WIDGET_UPDATE_WINDOW);
 
 	if (wid->drv && AGDRIVER_MULTIPLE(wid->drv) &&
@@ -1671,10 +1672,13 @@ AG_WidgetUpdateCoords(void *obj, int x, int y)
 	wid->rSens.x2 = x + wid->w;
 	wid->rSens.y2 = y + wid->h;
 
+	if (AG_RectCompare2(&wid->rView, &rPrev) != 0) {
 #ifdef HAVE_OPENGL
-	if (AG_RectCompare2(&wid->rView, &rPrev) != 0)
 		wid->flags |= AG_WIDGET_GL_RESHAPE;
 #endif
+		if (wid->window != NULL)     /* Damage tracking is unreliable */
+			wid->window->dirty = AG_WINDOW_DIRTY;
+	}
 	OBJECT_FOREACH_CHILD(chld, wid, ag_widget)               /* Recurse */
 		AG_WidgetUpdateCoords(chld,
 		    wid->rView.x1 + chld->x,
@@ -1973,6 +1977,8 @@ void
 AG_WidgetDraw(void *p)
 {
 	AG_Widget *wid = p;
+	AG_Rect2 rClip;
+	Uint64 t0;
 	Uint flags;
 	int useText;
 
@@ -1984,6 +1990,17 @@ AG_WidgetDraw(void *p)
 	    (flags & (AG_WIDGET_HIDE | AG_WIDGET_UNDERSIZE)))
 		goto out;
 
+	if (wid->window != NULL && wid->window->pvt.partial &&
+	    !AG_RectIntersect2(&rClip, &wid->rView,
+	                       &wid->window->pvt.rDamage))
+		goto out;                           /* Outside of damaged area */
+
+	t0 = AG_PerfBegin();
+	if (agDrawDepth < AG_WIDGET_DRAW_DEPTH_MAX) {
+		agDrawChildTime[agDrawDepth] = 0;
+	}
+	agDrawDepth++;
+
 	if (flags & AG_WIDGET_DISABLED)       { wid->state = AG_DISABLED_STATE; }
 	else if (flags & AG_WIDGET_MOUSEOVER) { wid->state = AG_HOVER_STATE;    }
 	else if (flags & AG_WIDGET_FOCUSED)   { wid->state = AG_FOCUSED_STATE;  }
@@ -2020,6 +2037,16 @@ AG_WidgetDraw(void *p)
 	if (useText) {
 		AG_PopTextState();
 	}
+	if (--agDrawDepth < AG_WIDGET_DRAW_DEPTH_MAX && t0 != 0) {
+		const Uint64 dt = AG_PerfTime() - t0;
+		const Uint64 dtChildren = agDrawChildTime[agDrawDepth];
+
+		AG_PerfKeyedAdd(AG_PERF_BY_WIDGET_CLASS, OBJECT(wid)->cls,
+		    OBJECT(wid)->cls->name,
+		    (dt > dtChildren) ? dt - dtChildren : 0);
+		if (agDrawDepth > 0)
+			agDrawChildTime[agDrawDepth-1] += dt;
+	}
 out:
 	AG_ObjectUnlock(wid);
 }
@@ -2186,25 +2213,105 @@ AG_WidgetReplaceSurface(void *obj, int id, AG_Surface *S)
 	AG_ObjectUnlock(wid);
 }
 
+/*
+ * Computed style of widgets without per-instance style attributes, cached
+ * in the AG_StyleSheet by widget class and inherited attributes. Identical
+ * widgets under identical parents share one entry.
+ */
+typedef struct ag_widget_style {
+	AG_StyleComputed _inherit;		/* AG_StyleComputed -> */
+	char parentFace[AG_STYLE_VALUE_MAX];	/* Inherited font face */
+	float parentFontSize;			/* Inherited font size */
+	Uint parentFontFlags;			/* Inherited font flags */
+	AG_WidgetPalette parentPal;		/* Inherited palette */
+	char fontFace[AG_STYLE_VALUE_MAX];	/* Computed font face */
+	float fontSize;				/* Computed font size */
+	Uint fontFlags;				/* Computed font flags */
+	const char *_Nullable padding;		/* From the stylesheet */
+	const char *_Nullable margin;
+	const char *_Nullable spacing;
+	AG_WidgetPalette pal;			/* Computed palette */
+	AG_Font *_Nullable font;		/* Resolved font (USE_TEXT) */
+} AG_WidgetStyle;
+
+/* Hash the attributes inherited by the children of a widget. */
+static Uint32
+HashStyleInputs(const char *_Nonnull face, float fontSize, Uint fontFlags,
+    const AG_WidgetPalette *_Nonnull pal)
+{
+	const Uint8 *p = (const Uint8 *)pal;
+	Uint32 h = 2166136261u;
+	const char *c;
+	Uint32 v;
+	AG_Size i;
+
+	for (c = face; *c != '\0'; c++) {
+		h = (h ^ (Uint8)*c) * 16777619u;
+	}
+	memcpy(&v, &fontSize, sizeof(v));
+	h = (h ^ v) * 16777619u;
+	h = (h ^ (Uint32)fontFlags) * 16777619u;
+	for (i = 0; i < sizeof(AG_WidgetPalette); i++) {
+		h = (h ^ p[i]) * 16777619u;
+	}
+	return (h);
+}
+
+/*
+ * Return 1 if the widget has per-instance (AG_SetStyle()-set) attributes,
+ * in which case its computed style cannot be shared.
+ */
+static int
+HasInstanceStyle(AG_Widget *_Nonnull wid)
+{
+	AG_Variable *V;
+	const char **attr;
+	int rv = 0;
+
+	AG_ObjectLock(wid);
+	TAILQ_FOREACH(V, &OBJECT(wid)->vars, vars) {
+		for (attr = &agStyleAttributes[0]; *attr != NULL; attr++) {
+			const AG_Size len = strlen(*attr);
+
+			if (strncmp(V->name, *attr, len) == 0 &&
+			    (V->name[len] == '\0' || V->name[len] == '#')) {
+				rv = 1;
+				goto out;
+			}
+		}
+	}
+out:
+	AG_ObjectUnlock(wid);
+	return (rv);
+}
+
 /*
  * Compile style attributes of a widget and its children. Generate color
  * palette and load any required fonts in the process.
  *
  * Per-instance (AG_SetStyle()-set) attributes have precedence over those
  * of the AG_StyleSheet(3). By default, attributes are inherited from parent.
+ * The agTextLock must be held.
  */
 static void
 CompileStyleRecursive(AG_Widget *_Nonnull wid, const char *_Nonnull parentFace,
-    float parentFontSize, Uint parentFontFlags, const AG_WidgetPalette *parentPalette)
+    float parentFontSize, Uint parentFontFlags, const AG_WidgetPalette *parentPalette,
+    Uint32 parentHash)
 {
 	AG_StyleSheet *css = &agDefaultCSS;
+	const AG_ObjectClass *cls = OBJECT(wid)->cls;
+	AG_WidgetPalette palNew;
+	AG_WidgetStyle *ws = NULL;
+	AG_Font *fontNew = NULL;
+	const char *padding = NULL, *margin = NULL, *spacing = NULL;
 	char *fontFace, *cssData;
 	AG_Widget *chld;
 	AG_Variable *V;
 	AG_Object *po;
 	float fontSize;
 	Uint fontFlags = parentFontFlags;
-	int i, j, paletteChanged=0;
+	Uint32 hash = 0, childHash;
+	int i, j, cacheable;
 	
 	AG_OBJECT_ISA(wid, "AG_Widget:*");
 
@@ -2217,6 +2324,38 @@ CompileStyleRecursive(AG_Widget *_Nonnull wid, const char *_Nonnull parentFace,
 		}
 	}
 
+	cacheable = (strlen(parentFace) < sizeof(ws->parentFace) &&
+	             !HasInstanceStyle(wid));
+	if (cacheable) {
+		AG_StyleComputed *sc;
+
+		hash = (parentHash ^ (Uint32)(AG_Size)cls) * 16777619u;
+		for (sc = AG_StyleSheetGetComputed(css, hash);
+		     sc != NULL;
+		     sc = sc->next) {
+			ws = (AG_WidgetStyle *)sc;
+			if (sc->hash == hash && sc->cls == cls &&
+			    ws->parentFontSize == parentFontSize &&
+			    ws->parentFontFlags == parentFontFlags &&
+			    strcmp(ws->parentFace, parentFace) == 0 &&
+			    memcmp(&ws->parentPal, parentPalette,
+			           sizeof(AG_WidgetPalette)) == 0) {
+				break;
+			}
+		}
+		ws = (sc != NULL) ? (AG_WidgetStyle *)sc : NULL;
+	}
+	if (ws != NULL) {                                  /* Cached style */
+		fontFace = Strdup(ws->fontFace);
+		fontSize = ws->fontSize;
+		fontFlags = ws->fontFlags;
+		padding = ws->padding;
+		margin = ws->margin;
+		spacing = ws->spacing;
+		memcpy(&palNew, &ws->pal, sizeof(AG_WidgetPalette));
+		goto apply;
+	}
+
 	/*
 	 * Font face (fontconfig name, base of filename in `font-path', or
 	 * underscore prefix for memory builts-in such as "_agFontAlgue").
@@ -2292,19 +2431,19 @@ CompileStyleRecursive(AG_Widget *_Nonnull wid, const char *_Nonnull parentFace,
 		Apply_Padding(wid, V->data.s);
 		AG_UnlockVariable(V);
 	} else if (AG_LookupStyleSheet(css, wid, "padding", &cssData)) {
-		Apply_Padding(wid, cssData);
+		padding = cssData;
 	}
 	if ((V = AG_AccessVariable(wid, "margin")) != NULL) {
 		Apply_Margin(wid, V->data.s);
 		AG_UnlockVariable(V);
 	} else if (AG_LookupStyleSheet(css, wid, "margin", &cssData)) {
-		Apply_Margin(wid, cssData);
+		margin = cssData;
 	}
 	if ((V = AG_AccessVariable(wid, "spacing")) != NULL) {
 		Apply_Spacing(wid, V->data.s);
 		AG_UnlockVariable(V);
 	} else if (AG_LookupStyleSheet(css, wid, "spacing", &cssData)) {
-		Apply_Spacing(wid, cssData);
+		spacing = cssData;
 	}
 	
 	/* Color palette */
@@ -2313,7 +2452,7 @@ CompileStyleRecursive(AG_Widget *_Nonnull wid, const char *_Nonnull parentFace,
 			char nameFull[AG_VARIABLE_NAME_MAX];
 			const AG_Color *cParent = &parentPalette->c[i][j];
 			const char *name = agStyleAttributes[j];
-			AG_Color cNew;
+			AG_Color *cNew = &palNew.c[i][j];
 
 			Strlcpy(nameFull, name, sizeof(nameFull));
 			if (i != 0)
@@ -2325,56 +2464,96 @@ CompileStyleRecursive(AG_Widget *_Nonnull wid, const char *_Nonnull parentFace,
 			if (((V = AG_AccessVariable(wid, nameFull)) != NULL ||
 			     (V = AG_AccessVariable(wid, name)) != NULL) &&
 			      V->data.s[0] != '\0') {
-				AG_ColorFromString(&cNew, V->data.s, cParent);
+				AG_ColorFromString(cNew, V->data.s, cParent);
 				AG_UnlockVariable(V);
 			} else if ((AG_LookupStyleSheet(css, wid, nameFull, &cssData) ||
 			            AG_LookupStyleSheet(css, wid, name, &cssData)) &&
 			           cssData[0] != '\0') {
-				AG_ColorFromString(&cNew, cssData, cParent);
+				AG_ColorFromString(cNew, cssData, cParent);
 			} else {
-				cNew = *cParent;
-			}
-			if (AG_ColorCompare(&cNew, &wid->pal.c[i][j]) != 0) {
-				wid->pal.c[i][j] = cNew;
-				paletteChanged = 1;
+				*cNew = *cParent;
 			}
 		}
 	}
-	if (paletteChanged)
-		AG_PostEvent(wid, "palette-changed", NULL);
-
+	if (cacheable && strlen(fontFace) < sizeof(ws->fontFace) &&
+	    (ws = TryMalloc(sizeof(AG_WidgetStyle))) != NULL) {
+		memset(ws, 0, sizeof(AG_WidgetStyle));
+		ws->_inherit.cls = cls;
+		ws->_inherit.hash = hash;
+		Strlcpy(ws->parentFace, parentFace, sizeof(ws->parentFace));
+		ws->parentFontSize = parentFontSize;
+		ws->parentFontFlags = parentFontFlags;
+		memcpy(&ws->parentPal, parentPalette, sizeof(AG_WidgetPalette));
+		Strlcpy(ws->fontFace, fontFace, sizeof(ws->fontFace));
+		ws->fontSize = fontSize;
+		ws->fontFlags = fontFlags;
+		ws->padding = padding;
+		ws->margin = margin;
+		ws->spacing = spacing;
+		memcpy(&ws->pal, &palNew, sizeof(AG_WidgetPalette));
+		AG_StyleSheetAddComputed(css, &ws->_inherit);
+	}
+apply:
+	/*
+	 * Resolve the font first, since the event handlers invoked below
+	 * may compile styles and invalidate the cached entry.
+	 */
 	if (wid->flags & AG_WIDGET_USE_TEXT) {    /* Load any fonts required */
-		char *pFace = fontFace, *tok;
-		AG_Font *fontNew = NULL;
+		if (ws != NULL && ws->font != NULL) {
+			char *c;
 
-		while ((tok = AG_Strsep(&pFace, ",")) != NULL) {
-			if ((fontNew = AG_FetchFont(fontFace, fontSize,
-			                            fontFlags)) != NULL)
-				break;
-		}
-		if (fontNew == NULL) {
-			fontNew = AG_FetchFont(NULL, fontSize, fontFlags);
-			if (fontNew == NULL)
-				AG_Debug(wid, "FetchFont: %s\n", AG_GetError());
+			fontNew = ws->font;
+			if ((c = strchr(fontFace, ',')) != NULL)
+				*c = '\0';
+		} else {
+			char *pFace = fontFace, *tok;
+
+			while ((tok = AG_Strsep(&pFace, ",")) != NULL) {
+				if ((fontNew = AG_FetchFont(fontFace, fontSize,
+				                            fontFlags)) != NULL)
+					break;
+			}
+			if (fontNew == NULL) {
+				fontNew = AG_FetchFont(NULL, fontSize, fontFlags);
+				if (fontNew == NULL)
+					AG_Debug(wid, "FetchFont: %s\n",
+					    AG_GetError());
+			}
+			if (ws != NULL)
+				ws->font = fontNew;
 		}
-		if (fontNew && wid->font != fontNew) {
-			AG_OBJECT_ISA(fontNew, "AG_Font:*");
+	}
 
-			wid->font = fontNew;
+	if (padding != NULL) { Apply_Padding(wid, padding); }
+	if (margin != NULL)  { Apply_Margin(wid, margin); }
+	if (spacing != NULL) { Apply_Spacing(wid, spacing); }
 
-			AG_PushTextState();
-			AG_TextFont(wid->font);
-			AG_PostEvent(wid, "font-changed", NULL);
-			AG_PopTextState();
+	if (memcmp(&wid->pal, &palNew, sizeof(AG_WidgetPalette)) != 0) {
+		memcpy(&wid->pal, &palNew, sizeof(AG_WidgetPalette));
+		AG_PostEvent(wid, "palette-changed", NULL);
+	}
 
-			AG_Redraw(wid);
-		}
+	if (fontNew != NULL && wid->font != fontNew) {
+		AG_OBJECT_ISA(fontNew, "AG_Font:*");
+
+		wid->font = fontNew;
+
+		AG_PushTextState();
+		AG_TextFont(wid->font);
+		AG_PostEvent(wid, "font-changed", NULL);
+		AG_PopTextState();
+
+		AG_Redraw(wid);
 	}
 
-	OBJECT_FOREACH_CHILD(chld, wid, ag_widget) {
-		CompileStyleRecursive(chld,
-		    fontFace, fontSize, fontFlags,
+	if (!TAILQ_EMPTY(&OBJECT(wid)->children)) {
+		childHash = HashStyleInputs(fontFace, fontSize, fontFlags,
 		    &wid->pal);
+		OBJECT_FOREACH_CHILD(chld, wid, ag_widget) {
+			CompileStyleRecursive(chld,
+			    fontFace, fontSize, fontFlags,
+			    &wid->pal, childHash);
+		}
 	}
 	free(fontFace);
 }
@@ -2577,13 +2756,19 @@ AG_WidgetCompileStyle(void *obj)
 		    OBJECT(parentFont)->name,	/* "font-family" */
 		    parentFont->spec.size,	/* "font-size" */
 		    parentFont->flags,		/* "font-{style,weight,stretch}" */
-		    &parent->pal);		/* and the color palette */
+		    &parent->pal,		/* and the color palette */
+		    HashStyleInputs(OBJECT(parentFont)->name,
+		                    parentFont->spec.size, parentFont->flags,
+		                    &parent->pal));
 	} else {
 		CompileStyleRecursive(wid,
 		    OBJECT(agDefaultFont)->name,
 		    agDefaultFont->spec.size,
 		    agDefaultFont->flags,
-		    &agDefaultPalette);
+		    &agDefaultPalette,
+		    HashStyleInputs(OBJECT(agDefaultFont)->name,
+		                    agDefaultFont->spec.size,
+		                    agDefaultFont->flags, &agDefaultPalette));
 	}
 
 	AG_MutexUnlock(&agTextLock);
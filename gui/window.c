@@ -941,6 +941,8 @@ OnDetach(AG_Event *_Nonnull event)
 	if (win == agDebuggerTgtWindow)
 		AG_GuiDebuggerDetachWindow();
 #endif
+	AG_PerfForget(AG_PERF_BY_WINDOW, win);      /* Address may be reused */
+
 	/*
 	 * Forward the "detached" event to child objects. The "detached"
 	 * handler of the AG_Widget class is expected to forward the event
@@ -1122,6 +1124,98 @@ out:
 	AG_UnlockVFS(&agDrivers);
 }
 
+/* Expand rd to include the area of r. */
+static __inline__ void
+RectUnion2(AG_Rect2 *_Nonnull rd, const AG_Rect2 *_Nonnull r)
+{
+	if (r->w <= 0 || r->h <= 0) {
+		return;
+	}
+	if (rd->w <= 0 || rd->h <= 0) {
+		*rd = *r;
+		return;
+	}
+	if (r->x1 < rd->x1) { rd->x1 = r->x1; }
+	if (r->y1 < rd->y1) { rd->y1 = r->y1; }
+	if (r->x2 > rd->x2) { rd->x2 = r->x2; }
+	if (r->y2 > rd->y2) { rd->y2 = r->y2; }
+	rd->w = rd->x2 - rd->x1;
+	rd->h = rd->y2 - rd->y1;
+}
+
+/*
+ * Render a window and record its rendering time in AG_Perf(3) (per window,
+ * under its caption or name).
+ */
+static void
+RenderWindowTimed(AG_Driver *_Nonnull drv, AG_Window *_Nonnull win)
+{
+	const Uint64 t0 = AG_PerfBegin();
+
+	AGDRIVER_CLASS(drv)->renderWindow(win);
+
+	if (t0 != 0) {
+		AG_PerfEnd(AG_PERF_WINDOW_DRAW, t0);
+		AG_PerfEndKeyed(AG_PERF_BY_WINDOW, win,
+		    (win->caption[0] != '\0') ? win->caption : OBJECT(win)->name,
+		    t0);
+	}
+}
+
+/* Record the rendering time of a frame in AG_Perf(3). */
+static __inline__ void
+EndFrameTimed(Uint64 t0)
+{
+	AG_PerfCount(AG_PERF_FRAMES);
+	AG_PerfEnd(AG_PERF_FRAME, t0);
+}
+
+/*
+ * Redraw only the damaged areas of the windows of a single-window driver.
+ * The damage rectangles of all dirty windows are merged, and every visible
+ * window overlapping the result is redrawn (in stacking order) with drawing
+ * clipped to the damaged area. Widgets outside of it are skipped.
+ *
+ * Return 0 without drawing anything if any window needs a full redraw.
+ */
+static int
+RenderDamaged(AG_Driver *_Nonnull drv)
+{
+	AG_Window *win;
+	AG_Rect2 rDamage;
+	Uint64 t0;
+
+	memset(&rDamage, 0, sizeof(AG_Rect2));
+	AG_FOREACH_WINDOW(win, drv) {
+		if (!win->visible || !win->dirty) {
+			continue;
+		}
+		if (win->dirty != AG_WINDOW_DIRTY_DAMAGE) {
+			return (0);
+		}
+		RectUnion2(&rDamage, &win->pvt.rDamage);
+	}
+	t0 = AG_PerfBegin();
+	AG_BeginRendering(drv);
+	AG_FOREACH_WINDOW(win, drv) {
+		if (!win->visible) {
+			continue;
+		}
+		AG_ObjectLock(win);
+		if (AG_RectIntersect2(&win->pvt.rDamage, &rDamage,
+		    &WIDGET(win)->rView)) {
+			win->pvt.partial = 1;
+			RenderWindowTimed(drv, win);
+			win->pvt.partial = 0;
+		}
+		win->dirty = 0;
+		AG_ObjectUnlock(win);
+	}
+	AG_EndRendering(drv);
+	EndFrameTimed(t0);
+	return (1);
+}
+
 /*
  * Render all windows that need to be redrawn. This is typically invoked
  * by the main event loop after all events have been processed.
@@ -1131,6 +1225,7 @@ AG_WindowDrawQueued(void)
 {
 	AG_Driver *drv;
 	AG_Window *win;
+	Uint64 t0;
 
 	AG_LockVFS(&agDrivers);
 
@@ -1142,9 +1237,11 @@ AG_WindowDrawQueued(void)
 					continue;
 				}
 				AG_ObjectLock(win);
+				t0 = AG_PerfBegin();
 				AG_BeginRendering(drv);
-				AGDRIVER_CLASS(drv)->renderWindow(win);
+				RenderWindowTimed(drv, win);
 				AG_EndRendering(drv);
+				EndFrameTimed(t0);
 				win->dirty = 0;
 				AG_ObjectUnlock(win);
 			}
@@ -1170,18 +1267,25 @@ AG_WindowDrawQueued(void)
 						if (win->visible && win->dirty)
 							break;
 				}
+				if (!doRedraw && win != NULL &&
+				    !(AGDRIVER_CLASS(drv)->flags & AG_DRIVER_OPENGL) &&
+				    RenderDamaged(drv)) {
+					break;
+				}
 				if (doRedraw || win != NULL) {
+					t0 = AG_PerfBegin();
 					AG_BeginRendering(drv);
 					AG_FOREACH_WINDOW(win, drv) {
 						if (!win->visible) {
 							continue;
 						}
 						AG_ObjectLock(win);
-						AGDRIVER_CLASS(drv)->renderWindow(win);
+						RenderWindowTimed(drv, win);
 						win->dirty = 0;
 						AG_ObjectUnlock(win);
 					}
 					AG_EndRendering(drv);
+					EndFrameTimed(t0);
 				}
 			}
 			break;
@@ -2884,7 +2988,10 @@ AG_WindowSetGeometryMax(AG_Window *_Nonnull win)
 	AG_WindowSetGeometry(win, 0, 0, wMax, hMax);
 }
 
-/* Request widget redraw. */
+/*
+ * Request widget redraw. The view area of the widget is added to the
+ * damaged area of its parent window.
+ */
 void
 AG_Redraw(void *_Nonnull obj)
 {
@@ -2898,7 +3005,21 @@ AG_Redraw(void *_Nonnull obj)
 #endif
 	if ((win = WIDGET(obj)->window) != NULL) {
 		AG_OBJECT_ISA(win, "AG_Widget:AG_Window:*");
-		win->dirty = 1;
+		if (win->flags & AG_WINDOW_NODAMAGE) {
+			win->dirty = AG_WINDOW_DIRTY;
+			return;
+		}
+		switch (win->dirty) {
+		case 0:
+			win->pvt.rDamage = WIDGET(obj)->rView;
+			win->dirty = AG_WINDOW_DIRTY_DAMAGE;
+			break;
+		case AG_WINDOW_DIRTY_DAMAGE:
+			RectUnion2(&win->pvt.rDamage, &WIDGET(obj)->rView);
+			break;
+		default:
+			break;			/* Entire window is already dirty */
+		}
 	}
 }
 
@@ -3051,6 +3172,9 @@ Init(void *_Nonnull obj)
 	for (i = 0; i < 5; i++)
 		win->pvt.caResize[i] = NULL;
 
+	memset(&win->pvt.rDamage, 0, sizeof(AG_Rect2));
+	win->pvt.partial = 0;
+
 	AG_SetEvent(win, "window-gainfocus", OnGainFocus, NULL);
 	AG_SetEvent(win, "window-lostfocus", OnLostFocus, NULL);
 
@@ -74,6 +74,9 @@ typedef struct ag_window_pvt {
 	AG_WindowFadeCtx *fade;               /* Fadein/fadeout context */
 	AG_CursorAreaQ cursorAreas;           /* Cursor-change areas */
 	AG_CursorArea *_Nullable caResize[5]; /* Window-resize areas */
+	AG_Rect2 rDamage;                     /* Damaged area (DIRTY_DAMAGE) */
+	int partial;                          /* Partial redraw in progress */
+	Uint32 _pad;
 } AG_WindowPvt;
 
 /* Window instance */
@@ -109,6 +112,7 @@ typedef struct ag_window {
 #define AG_WINDOW_FADEIN        0x08000000 /* Fade-in (compositing WMs) */
 #define AG_WINDOW_FADEOUT       0x10000000 /* Fade-out (compositing WMs) */
 #define AG_WINDOW_USE_TEXT      0x20000000 /* At least one widget has USE_TEXT */
+#define AG_WINDOW_NODAMAGE      0x40000000 /* Disable damage tracking */
 
 #define AG_WINDOW_NORESIZE     (AG_WINDOW_NOHRESIZE | AG_WINDOW_NOVRESIZE)
 #define AG_WINDOW_NOBUTTONS    (AG_WINDOW_NOCLOSE | AG_WINDOW_NOMINIMIZE | \
@@ -118,6 +122,8 @@ typedef struct ag_window {
 	char caption[AG_WINDOW_CAPTION_MAX];	/* Window caption */
 	int visible;				/* Window is visible */
 	int dirty;				/* Window needs redraw */
+#define AG_WINDOW_DIRTY        1		/* Redraw the entire window */
+#define AG_WINDOW_DIRTY_DAMAGE 2		/* Redraw pvt.rDamage only */
 	enum ag_window_alignment alignment;	/* Initial position */
 
 	struct ag_titlebar *_Nullable tbar;	/* Titlebar (or NULL) */
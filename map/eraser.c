@@ -44,10 +44,14 @@ EraseSelection(MAP_Tool *_Nonnull tool, AG_KeySym key, int state, void *_Nullabl
 
 	for (y = 0; y < map->h; y++) {
 		for (x = 0; x < map->w; x++) {
-			MAP_Node *node = &map->map[y][x];
+			MAP_Node *node;
 			MAP_Item *mi;
 			Uint i;
 
+			if (MAP_ChunkIsVacant(map, MAP_CHUNK_INDEX(map, x,y)))
+				continue;
+			node = MAP_GetNode(map, x,y);
+
 			TAILQ_FOREACH(mi, &node->items, items) {
 				if (mi->layer != map->layerCur) {
 					continue;
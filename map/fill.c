@@ -107,8 +107,9 @@ Effect(void *_Nonnull obj, MAP_Node *_Nonnull node)
 		count = 0;
 		for (y = dy; y < dy+dh; y++) {
 			for (x = dx; x < dx+dw; x++) {
-				MAP_Node *nodeSrc = &mapCopy->map[sy][sx];
-				MAP_Node *node = &map->map[y][x];
+				const MAP_Node *nodeSrc = MAP_GetConstNode(mapCopy,
+				                                           sx,sy);
+				MAP_Node *node = MAP_GetNode(map, x,y);
 				MAP_Item *mi;
 
 				MAP_NodeRevision(map, x,y, map->undo, map->nUndo);
@@ -141,7 +142,7 @@ Effect(void *_Nonnull obj, MAP_Node *_Nonnull node)
 		tile = it->p1;
 		for (y = dy; y < dy+dh; y++) {
 			for (x = dx; x < dx+dw; x++) {
-				MAP_Node *node = &map->map[y][x];
+				MAP_Node *node = MAP_GetNode(map, x,y);
 				MAP_Tile *mt;
 
 				MAP_NodeRevision(map, x,y, map->undo, map->nUndo);
@@ -195,7 +196,8 @@ Effect(void *_Nonnull obj, MAP_Node *_Nonnull node)
 		for (y = dy; y < dy+dh; y++) {
 			for (x = dx; x < dx+dw; x++) {
 				MAP_NodeRevision(map, x,y, map->undo, map->nUndo);
-				MAP_NodeClear(map, &map->map[y][x], map->layerCur);
+				MAP_NodeClear(map, MAP_GetNode(map, x,y),
+				    map->layerCur);
 			}
 		}
 		MAP_ViewStatus(mv, _("Cleared (%dx%d) nodes at "
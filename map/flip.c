@@ -87,7 +87,7 @@ MouseButtonDown(void *_Nonnull obj, int xMap, int yMap, int b)
 
 	for (y = ySel; y < ySel+h; y++) {
 		for (x = xSel ; x < xSel+w; x++) {
-			MAP_Node *node = &map->map[y][x];
+			MAP_Node *node = MAP_GetNode(map, x,y);
 			MAP_Item *mi;
 
 			MAP_NodeRevision(map, x,y, map->undo, map->nUndo);
@@ -166,7 +166,7 @@ MouseMotion(void *_Nonnull p, int x, int y, int xrel, int yrel)
 		if (mv->cx == -1 || mv->cy == -1) {
 			return (0);
 		}
-		node = &m->map[mv->cy][mv->cx];
+		node = MAP_GetNode(m, mv->cx, mv->cy);
 #ifdef AG_DEBUG
 		if ((node->flags & MAP_NODE_VALID) == 0)
 			AG_FatalError("Invalid node");
@@ -199,7 +199,7 @@ MouseButtonDown(void *_Nonnull obj, int x, int y, int button)
 		AG_SetErrorS("Library object is not a map object");
 		goto fail;
 	}
-	node = &map->map[mv->cy][mv->cx];
+	node = MAP_GetNode(map, mv->cx, mv->cy);
 	if ((node->flags & MAP_NODE_VALID) == 0) {
 		AG_SetErrorS("Invalid node");
 		goto fail;
@@ -132,6 +132,8 @@ MAP_ItemInit(void *obj, enum map_item_type type)
 	mi->type = type;
 	mi->flags = MAP_ITEM_VALID;
 	mi->layer = 0;
+	mi->z = 0.0f;
+	mi->h = 0.0f;
 	mi->p = NULL;
 	RG_TransformChainInit(&mi->transforms);
 
@@ -194,68 +196,6 @@ MAP_ItemAttrColor(Uint flag, int state, AG_Color *c)
 	}
 }
 
-/*
- * Allocate and initialize the two-dimensional array of MAP_Node's
- * to (w x h) nodes.
- */
-int
-MAP_AllocNodes(MAP *map, Uint w, Uint h)
-{
-	Uint x, y;
-	MAP_Node **mapNew;
-	
-	if (w > MAP_WIDTH_MAX || h > MAP_HEIGHT_MAX) {
-		AG_SetError(_("%ux%u nodes exceed the limit of %ux%u."),
-		    w,h, MAP_WIDTH_MAX, MAP_HEIGHT_MAX);
-		return (-1);
-	}
-
-	if ((mapNew = TryMalloc(h * sizeof(MAP_Node *))) == NULL) {
-		return (-1);
-	}
-	for (y = 0; y < h; y++) {
-		if ((mapNew[y] = TryMalloc(w * sizeof(MAP_Node))) == NULL) {
-			for (--y; y >= 0; y--) {
-				free(mapNew[y]);
-			}
-			free(mapNew);
-			return (-1);
-		}
-	}
-	for (y = 0; y < h; y++) {
-		for (x = 0; x < w; x++)
-			MAP_NodeInit(&mapNew[y][x]);
-	}
-
-	AG_ObjectLock(map);
-	map->map = mapNew;
-	map->w = w;
-	map->h = h;
-	AG_ObjectUnlock(map);
-
-	return (0);
-}
-
-/* Release the node map. */
-void
-MAP_FreeNodes(MAP *map)
-{
-	Uint x,y;
-	MAP_Node *node;
-
-	if (map->map != NULL) {
-		for (y = 0; y < map->h; y++) {
-			for (x = 0; x < map->w; x++) {
-				node = &map->map[y][x];
-				MAP_NodeDestroy(map, node);
-			}
-			free(map->map[y]);
-		}
-		free(map->map);
-		map->map = NULL;
-	}
-}
-
 static void
 FreeLayers(MAP *_Nonnull map)
 {
@@ -293,9 +233,12 @@ MAP_Resize(MAP *map, Uint w, Uint h)
 		goto fail;
 	}
 	for (y = 0; y < map->h && y < h; y++) {
-		for (x = 0; x < map->w && x < w; x++)
-			MAP_NodeCopy(&mapTmp, &mapTmp.map[y][x], -1,
-			             &map->map[y][x], -1);
+		for (x = 0; x < map->w && x < w; x++) {
+			if (MAP_ChunkIsVacant(map, MAP_CHUNK_INDEX(map, x,y)))
+				continue;
+			MAP_NodeCopy(&mapTmp, MAP_GetNode(&mapTmp, x,y), -1,
+			             MAP_GetConstNode(map, x,y), -1);
+		}
 	}
 
 	/* Resize the map and restore the original nodes. */
@@ -304,9 +247,13 @@ MAP_Resize(MAP *map, Uint w, Uint h)
 		goto fail;
 	}
 	for (y = 0; y < mapTmp.h && y < map->h; y++) {
-		for (x = 0; x < mapTmp.w && x < map->w; x++)
-			MAP_NodeCopy(map, &map->map[y][x], -1,
-			             &mapTmp.map[y][x], -1);
+		for (x = 0; x < mapTmp.w && x < map->w; x++) {
+			if (MAP_ChunkIsVacant(&mapTmp,
+			    MAP_CHUNK_INDEX(&mapTmp, x,y)))
+				continue;
+			MAP_NodeCopy(map, MAP_GetNode(map, x,y), -1,
+			             MAP_GetConstNode(&mapTmp, x,y), -1);
+		}
 	}
 
 	/* Clamp the origin point. */
@@ -445,7 +392,14 @@ Init(void *_Nonnull obj)
 	map->xOrigin = 0;
 	map->yOrigin = 0;
 	map->layerOrigin = 0;
-	map->map = NULL;
+	map->chunks = NULL;
+	map->wChunks = 0;
+	map->hChunks = 0;
+	map->nResident = 0;
+	map->nResidentMax = 0;
+	map->tick = 0;
+	map->pager = NULL;
+	TAILQ_INIT(&map->resident);
 	map->layers = Malloc(sizeof(MAP_Layer));
 	map->nLayers = 1;
 	map->cameras = Malloc(sizeof(MAP_Camera));
@@ -864,8 +818,7 @@ Reset(void *_Nonnull obj)
 {
 	MAP *map = obj;
 
-	if (map->map != NULL)
-		MAP_FreeNodes(map);
+	MAP_FreeNodes(map);
 	if (map->layers != NULL)
 		FreeLayers(map);
 	if (map->cameras != NULL)
@@ -914,27 +867,24 @@ MAP_ItemLoad(MAP *map, MAP_Node *node, AG_DataSource *ds)
 	if ((mi = TryMalloc(miClass->size)) == NULL) {
 		return (-1);
 	}
-	if (miClass->init != NULL) {
-		miClass->init(mi);
-	}
+	MAP_ItemInit(mi, type);
 	mi->flags = flags;
 	mi->layer = layer;
 	mi->z = z;
 	mi->h = h;
 
+	if (RG_TransformChainLoad(ds, &mi->transforms) == -1) {
+		goto fail;
+	}
 	if (miClass->load != NULL) {
 		if (miClass->load(map, mi, ds) == -1)
-			return (-1);
+			goto fail;
 	}
-	if (RG_TransformChainLoad(ds, &mi->transforms) == -1)
-		goto fail;
-
+	TAILQ_INSERT_TAIL(&node->items, mi, items);
 	return (0);
 fail:
-	if (mi != NULL) {
-		MAP_ItemDestroy(map, mi);
-		free(mi);
-	}
+	MAP_ItemDestroy(map, mi);
+	free(mi);
 	return (-1);
 }
 
@@ -1021,7 +971,7 @@ Load(void *_Nonnull obj, AG_DataSource *_Nonnull ds,
 {
 	MAP *map = obj;
 	Uint32 w, h, origin_x, origin_y;
-	Uint i, x, y;
+	Uint i;
 	
 	map->flags = (Uint)AG_ReadUint32(ds) & MAP_SAVED_FLAGS;
 	w = AG_ReadUint32(ds);
@@ -1102,7 +1052,7 @@ Load(void *_Nonnull obj, AG_DataSource *_Nonnull ds,
 
 	/* Map objects */
 	map->nObjs = (Uint)AG_ReadUint32(ds);
-	if ((map->objs = TryRealloc(map->objs, map->nObjs *
+	if ((map->objs = TryRealloc(map->objs, (map->nObjs + 1) *
 	                            sizeof(MAP_Object *))) == NULL) {
 		return (-1);
 	}
@@ -1144,13 +1094,7 @@ Load(void *_Nonnull obj, AG_DataSource *_Nonnull ds,
 	if (MAP_AllocNodes(map, map->w, map->h) == -1) {
 		return (-1);
 	}
-	for (y = 0; y < map->h; y++) {
-		for (x = 0; x < map->w; x++) {
-			if (MAP_NodeLoad(map, ds, &map->map[y][x]) == -1)
-				return (-1);
-		}
-	}
-	return (0);
+	return MAP_LoadNodes(map, ds, ver);
 }
 
 /* Save a map item. The parent map must be locked. */
@@ -1172,7 +1116,7 @@ MAP_ItemSave(MAP *map, MAP_Item *mi, AG_DataSource *ds)
 }
 
 void
-MAP_NodeSave(MAP *map, AG_DataSource *ds, MAP_Node *node)
+MAP_NodeSave(MAP *map, AG_DataSource *ds, const MAP_Node *node)
 {
 	MAP_Item *mi;
 	AG_Offset nItemsOffs;
@@ -1208,7 +1152,7 @@ static int
 Save(void *_Nonnull obj, AG_DataSource *_Nonnull ds)
 {
 	MAP *map = obj;
-	Uint i, x,y;
+	Uint i;
 	
 	AG_WriteUint32(ds, (Uint32)(map->flags & MAP_SAVED_FLAGS));
 	AG_WriteUint32(ds, (Uint32)map->w);
@@ -1284,16 +1228,12 @@ Save(void *_Nonnull obj, AG_DataSource *_Nonnull ds)
 	}
 
 	/* Populated nodes */
-	for (y = 0; y < map->h; y++) {
-		for (x = 0; x < map->w; x++)
-			MAP_NodeSave(map, ds, &map->map[y][x]);
-	}
-	return (0);
+	return MAP_SaveNodes(map, ds);
 }
 
 static MAP_Item *_Nullable
-LocateItem(MAP *_Nonnull map, MAP_Node *_Nonnull node, int xOffs, int yOffs,
-    int xd, int yd, int ncam)
+LocateItem(MAP *_Nonnull map, const MAP_Node *_Nonnull node, int xOffs,
+    int yOffs, int xd, int yd, int ncam)
 {
 	AG_Rect rExt;
 	MAP_Item *mi;
@@ -1333,51 +1273,51 @@ MAP_ItemLocate(MAP *map, int xMap, int yMap, int ncam)
 	xOffs = xMap % tileSz;
 	yOffs = yMap % tileSz;
 
-	if ((mi = LocateItem(map, &map->map[y][x], xOffs,yOffs, 0,0, ncam))
-	    != NULL) {
+	if ((mi = LocateItem(map, MAP_GetConstNode(map, x,y), xOffs,yOffs,
+	    0,0, ncam)) != NULL) {
 		return (mi);
 	}
 
 	if (y+1 < map->h) {
-		if ((mi = LocateItem(map, &map->map[y+1][x], xOffs, yOffs,
-		    0, -cam->tilesz, ncam)) != NULL)
+		if ((mi = LocateItem(map, MAP_GetConstNode(map, x,y+1),
+		    xOffs, yOffs, 0, -cam->tilesz, ncam)) != NULL)
 			return (mi);
 	}
 	if (y-1 >= 0) {
-		if ((mi = LocateItem(map, &map->map[y-1][x], xOffs, yOffs,
-		    0, +cam->tilesz, ncam)) != NULL)
+		if ((mi = LocateItem(map, MAP_GetConstNode(map, x,y-1),
+		    xOffs, yOffs, 0, +cam->tilesz, ncam)) != NULL)
 			return (mi);
 	}
 	if (x+1 < (int)map->w) {
-		if ((mi = LocateItem(map, &map->map[y][x+1], xOffs, yOffs,
-		    -cam->tilesz, 0, ncam)) != NULL)
+		if ((mi = LocateItem(map, MAP_GetConstNode(map, x+1,y),
+		    xOffs, yOffs, -cam->tilesz, 0, ncam)) != NULL)
 			return (mi);
 	}
 	if (x-1 >= 0) {
-		if ((mi = LocateItem(map, &map->map[y][x-1], xOffs, yOffs,
-		    +cam->tilesz, 0, ncam)) != NULL)
+		if ((mi = LocateItem(map, MAP_GetConstNode(map, x-1,y),
+		    xOffs, yOffs, +cam->tilesz, 0, ncam)) != NULL)
 			return (mi);
 	}
 
 	/* Check diagonal nodes. */
 	if (x+1 < map->w && y+1 < map->h) {
-		if ((mi = LocateItem(map, &map->map[y+1][x+1], xOffs, yOffs,
-		    -cam->tilesz, -cam->tilesz, ncam)) != NULL)
+		if ((mi = LocateItem(map, MAP_GetConstNode(map, x+1,y+1),
+		    xOffs, yOffs, -cam->tilesz, -cam->tilesz, ncam)) != NULL)
 			return (mi);
 	}
 	if (x-1 >= 0 && y-1 >= 0) {
-		if ((mi = LocateItem(map, &map->map[y-1][x-1], xOffs, yOffs,
-		    +cam->tilesz, +cam->tilesz, ncam)) != NULL)
+		if ((mi = LocateItem(map, MAP_GetConstNode(map, x-1,y-1),
+		    xOffs, yOffs, +cam->tilesz, +cam->tilesz, ncam)) != NULL)
 			return (mi);
 	}
 	if (x-1 >= 0 && y+1 < map->h) {
-		if ((mi = LocateItem(map, &map->map[y+1][x-1], xOffs, yOffs,
-		    +cam->tilesz, -cam->tilesz, ncam)) != NULL)
+		if ((mi = LocateItem(map, MAP_GetConstNode(map, x-1,y+1),
+		    xOffs, yOffs, +cam->tilesz, -cam->tilesz, ncam)) != NULL)
 			return (mi);
 	}
 	if (x+1 < map->w && y-1 >= 0) {
-		if ((mi = LocateItem(map, &map->map[y-1][x+1], xOffs, yOffs,
-		    -cam->tilesz, +cam->tilesz, ncam)) != NULL)
+		if ((mi = LocateItem(map, MAP_GetConstNode(map, x+1,y-1),
+		    xOffs, yOffs, -cam->tilesz, +cam->tilesz, ncam)) != NULL)
 			return (mi);
 	}
 	return (NULL);
@@ -1470,8 +1410,8 @@ MAP_UndoRevision(MAP *map, MAP_Revision *rev, MAP_Revision *undoRedo,
 		switch (chg->type) {
 		case MAP_CHANGE_NODECHG:
 		{
-			MAP_Node *node = &map->map[chg->mm_nodechg.y]
-			                          [chg->mm_nodechg.x];
+			MAP_Node *node = MAP_GetNode(map, chg->mm_nodechg.x,
+			                                  chg->mm_nodechg.y);
 
 			Debug(map, "Undo(#%d): Reverting node at "
 			           "[" AGSI_BOLD "%d,%d" AGSI_RST "]\n",
@@ -1563,7 +1503,8 @@ MAP_Redo(MAP *map)
 void
 MAP_NodeRevision(MAP *map, int x, int y, MAP_Revision *undoRedo, Uint nUndoRedo)
 {
-	MAP_Node *node = &map->map[y][x], *nodeSave;
+	const MAP_Node *node = MAP_GetConstNode(map, x,y);
+	MAP_Node *nodeSave;
 	MAP_Revision *rev;
 	MAP_Change *chg;
 	MAP_Item *mi;
@@ -1638,7 +1579,7 @@ AG_GenerateMapFromSurface(AG_Gfx *gfx, AG_Surface *sprite)
 			Uint32 sckflags = sprite->flags & (AG_SRCCOLORKEY);
 			Uint8 salpha = sprite->format->alpha;
 			Uint32 scolorkey = sprite->format->colorkey;
-			MAP_Node *node = &fragmap->map[my][mx];
+			MAP_Node *node = MAP_GetNode(fragmap, mx,my);
 			Uint32 nsprite;
 			int fw = MAP_TILESZ_DEF;
 			int fh = MAP_TILESZ_DEF;
@@ -2193,9 +2134,13 @@ DeleteLayer(AG_Event *_Nonnull event)
 
 	for (y = 0; y < map->h; y++) {
 		for (x = 0; x < map->w; x++) {
-			MAP_Node *node = &map->map[y][x];
+			MAP_Node *node;
 			MAP_Item *mi;
 
+			if (MAP_ChunkIsVacant(map, MAP_CHUNK_INDEX(map, x,y)))
+				continue;
+			node = MAP_GetNode(map, x,y);
+
 			MAP_NodeClear(map, node, layer);
 
 			TAILQ_FOREACH(mi, &node->items, items) {
@@ -2225,9 +2170,13 @@ ClearLayer(AG_Event *_Nonnull event)
 		if (&map->layers[layer] == pLayer)
 			break;
 	}
-	for (y = 0; y < map->h; y++)
-		for (x = 0; x < map->w; x++)
-			MAP_NodeClear(map, &map->map[y][x], layer);
+	for (y = 0; y < map->h; y++) {
+		for (x = 0; x < map->w; x++) {
+			if (MAP_ChunkIsVacant(map, MAP_CHUNK_INDEX(map, x,y)))
+				continue;
+			MAP_NodeClear(map, MAP_GetNode(map, x,y), layer);
+		}
+	}
 }
 
 /* Move a layer (and its associated items) up or down the stack. */
@@ -2264,10 +2213,14 @@ MoveLayer(AG_Event *_Nonnull event)
 
 	for (y = 0; y < map->h; y++) {
 		for (x = 0; x < map->w; x++) {
-			MAP_Node *node = &map->map[y][x];
+			MAP_Node *node;
 			MAP_Item *mi;
 			Uint i;
 
+			if (MAP_ChunkIsVacant(map, MAP_CHUNK_INDEX(map, x,y)))
+				continue;
+			node = MAP_GetNode(map, x,y);
+
 			TAILQ_FOREACH(mi, &node->items, items) {
 				if (mi->layer == l1) {
 					mi->layer = l2;
@@ -2374,12 +2327,25 @@ RemoveAllRefsToTileset(AG_Event *_Nonnull event)
 
 	for (y = 0; y < map->h; y++) {
 		for (x = 0; x < map->w; x++) {
-			MAP_Node *node = &map->map[y][x];
+			MAP_Node *node;
 			MAP_Item *mi, *miNext;
 
-			for (mi = TAILQ_FIRST(&node->items);
-			     mi != TAILQ_END(&node->items);
-			     mi = miNext) {
+			if (MAP_ChunkIsVacant(map, MAP_CHUNK_INDEX(map, x,y)))
+				continue;
+
+			/* Don't dirty chunks which have nothing to remove. */
+			TAILQ_FOREACH(mi, &MAP_GetConstNode(map, x,y)->items,
+			    items) {
+				if (mi->type == MAP_ITEM_TILE &&
+				    MAPTILE(mi)->obj == ts)
+					break;
+			}
+			if (mi == NULL) {
+				continue;
+			}
+			node = MAP_GetNode(map, x,y);
+
+			for (; mi != TAILQ_END(&node->items); mi = miNext) {
 				miNext = TAILQ_NEXT(mi, items);
 				if (mi->type == MAP_ITEM_TILE &&
 				    MAPTILE(mi)->obj == ts)
@@ -2402,13 +2368,28 @@ RemoveAllRefsToTile(AG_Event *_Nonnull event)
 
 	for (y = 0; y < map->h; y++) {
 		for (x = 0; x < map->w; x++) {
-			MAP_Node *node = &map->map[y][x];
+			MAP_Node *node;
 			MAP_Item *mi, *miNext;
 			RG_Tile *ntile;
 
-			for (mi = TAILQ_FIRST(&node->items);
-			     mi != TAILQ_END(&node->items);
-			     mi = miNext) {
+			if (MAP_ChunkIsVacant(map, MAP_CHUNK_INDEX(map, x,y)))
+				continue;
+
+			TAILQ_FOREACH(mi, &MAP_GetConstNode(map, x,y)->items,
+			    items) {
+				if (mi->type == MAP_ITEM_TILE &&
+				    RG_LookupTile(MAPTILE(mi)->obj,
+				                  MAPTILE(mi)->id,
+						  &ntile) == 0 &&
+				    (ntile == tile))
+					break;
+			}
+			if (mi == NULL) {
+				continue;
+			}
+			node = MAP_GetNode(map, x,y);
+
+			for (; mi != TAILQ_END(&node->items); mi = miNext) {
 				miNext = TAILQ_NEXT(mi, items);
 
 				if (mi->type == MAP_ITEM_TILE &&
@@ -2576,6 +2557,7 @@ OpenMapAGM(AG_Event *event)
 		return;
 	}
 	map->pLibs = mapParent->pLibs;			/* Inherit pLibs */
+	MAP_SetPaging(map, MAP_CHUNKS_RESIDENT_DEF);	/* Page in nodes */
 
 	if (AG_ObjectLoadFromFile(map, path) == -1) {
 		AG_TextError("%s: %s", path, AG_GetError());
@@ -2883,7 +2865,7 @@ Edit(void *_Nonnull obj)
 AG_ObjectClass mapClass = {
 	"MAP",
 	sizeof(MAP),
-	{ 12, 1 },
+	{ 12, 2 },
 	Init,
 	Reset,
 	Destroy,
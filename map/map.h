@@ -24,6 +24,22 @@
 #define MAP_NODE_ITEMS_MAX  32767
 #define MAP_OBJECT_ID_MAX   0x7fffff
 
+#ifndef MAP_CHUNK_SHIFT
+#define MAP_CHUNK_SHIFT     5		/* 32x32 nodes per chunk */
+#endif
+#define MAP_CHUNK_SIZE      (1 << MAP_CHUNK_SHIFT)
+#define MAP_CHUNK_MASK      (MAP_CHUNK_SIZE - 1)
+#define MAP_CHUNK_NODES     (MAP_CHUNK_SIZE * MAP_CHUNK_SIZE)
+#define MAP_CHUNK_INDEX(map,x,y) \
+	((Uint)((y) >> MAP_CHUNK_SHIFT) * (map)->wChunks + \
+	 (Uint)((x) >> MAP_CHUNK_SHIFT))
+#ifndef MAP_CHUNKS_RESIDENT_DEF
+#define MAP_CHUNKS_RESIDENT_DEF 256	/* Default paging budget (chunks) */
+#endif
+#ifndef MAP_PREFETCH_MAX
+#define MAP_PREFETCH_MAX    64		/* Maximum prefetched chunks */
+#endif
+
 #include <agar/map/begin.h>
 
 struct map;
@@ -32,6 +48,7 @@ struct map_view;
 struct map_item;
 struct map_object;
 struct map_location;
+struct map_draw_list;
 
 /* Static map item type */
 enum map_item_type {
@@ -125,6 +142,32 @@ typedef struct map_node {
 	struct map_itemq               items; /* Static items */
 } MAP_Node;
 
+/*
+ * Square block of MAP_CHUNK_SIZE x MAP_CHUNK_SIZE nodes. Chunks are
+ * allocated on first access and may be paged in and out of the map file.
+ */
+typedef struct map_chunk {
+	Uint flags;
+#define MAP_CHUNK_DIRTY   0x01		/* Modified (never paged out) */
+#define MAP_CHUNK_PINNED  0x02		/* Has object locations (never paged out) */
+	Uint idx;			/* Index in map's chunk array */
+	Uint32 tick;			/* Map tick at last access (for LRU) */
+	Uint32 rev;			/* Modification counter */
+	struct map_draw_list *_Nullable dl; /* Cached draw list (MAP_View) */
+	AG_TAILQ_ENTRY(map_chunk) resident; /* In map's resident list */
+	MAP_Node nodes[MAP_CHUNK_NODES];    /* Nodes (row-major) */
+} MAP_Chunk;
+
+/* Node storage and paging statistics. */
+typedef struct map_chunk_stats {
+	Uint nChunks;			/* Total chunks in map */
+	Uint nResident;			/* Chunks in memory */
+	Uint nDirty;			/* Modified or pinned resident chunks */
+	Uint nLoads;			/* Chunks read from the map file */
+	Uint nPrefetched;		/* Loads satisfied by prefetch */
+	Uint nEvictions;		/* Chunks paged out */
+} MAP_ChunkStats;
+
 typedef struct map_layer {
 	char name[MAP_LAYER_NAME_MAX];
 	int visible;				/* Show/hide flag */
@@ -197,7 +240,14 @@ typedef struct map {
 	int xOrigin, yOrigin;			/* Origin node */
 	int layerOrigin;			/* Origin node layer# */
 	Uint nChanges;				/* Changes since last action (for MAP_Tool) */
-	MAP_Node *_Nullable *_Nonnull map;	/* Arrays of nodes */
+	MAP_Chunk *_Nullable *_Nullable chunks;	/* Chunks (NULL = not resident) */
+	Uint wChunks, hChunks;			/* Size of chunk array */
+	Uint nResident;				/* Resident chunk count */
+	Uint nResidentMax;			/* Paging budget (0 = no paging) */
+	Uint32 tick;				/* Access counter (for LRU) */
+	Uint32 _pad1;
+	struct map_pager *_Nullable pager;	/* Paging file (or NULL) */
+	AG_TAILQ_HEAD_(map_chunk) resident;	/* Resident chunks */
 	MAP_Layer *_Nonnull layers;		/* Layer information */
 	Uint               nLayers;		/* Layer count */
 	Uint                nCameras;		/* Camera count */
@@ -238,6 +288,17 @@ MAP *_Nonnull MAP_New(void *_Nullable, const char *_Nonnull);
 
 int  MAP_AllocNodes(MAP *_Nonnull, Uint,Uint);
 void MAP_FreeNodes(MAP *_Nonnull);
+
+MAP_Chunk *_Nonnull MAP_LoadChunk(MAP *_Nonnull, Uint);
+int  MAP_ChunkIsVacant(MAP *_Nonnull, Uint);
+void MAP_EvictChunks(MAP *_Nonnull, Uint);
+void MAP_SetPaging(MAP *_Nonnull, Uint);
+void MAP_Prefetch(MAP *_Nonnull, int,int, int,int);
+void MAP_GetChunkStats(MAP *_Nonnull, MAP_ChunkStats *_Nonnull);
+int  MAP_LoadNodes(MAP *_Nonnull, AG_DataSource *_Nonnull,
+                   const AG_Version *_Nonnull);
+int  MAP_SaveNodes(MAP *_Nonnull, AG_DataSource *_Nonnull);
+
 int  MAP_Resize(MAP *_Nonnull, Uint,Uint);
 void MAP_SetZoom(MAP *_Nonnull, int, Uint);
 int  MAP_PushLayer(MAP *_Nonnull, const char *_Nonnull);
@@ -276,7 +337,8 @@ MAP_Item *_Nullable MAP_ItemLocate(MAP *_Nonnull, int,int, int);
 
 void MAP_NodeInit(MAP_Node *_Nonnull);
 int  MAP_NodeLoad(MAP *_Nonnull, AG_DataSource *_Nonnull, MAP_Node *_Nonnull);
-void MAP_NodeSave(MAP *_Nonnull, AG_DataSource *_Nonnull, MAP_Node *_Nonnull);
+void MAP_NodeSave(MAP *_Nonnull, AG_DataSource *_Nonnull,
+                  const MAP_Node *_Nonnull);
 void MAP_NodeDestroy(MAP *_Nonnull, MAP_Node *_Nonnull);
 void MAP_NodeClear(MAP *_Nonnull, MAP_Node *_Nonnull, int);
 void MAP_NodeCopy(MAP *_Nonnull, MAP_Node *_Nonnull, int, const MAP_Node *, int);
@@ -295,6 +357,49 @@ void MAP_NodeDelItem(MAP *_Nonnull, MAP_Node *_Nonnull, MAP_Item *_Nonnull);
 int  MAP_NodeDelLocation(MAP *_Nonnull, MAP_Node *_Nonnull, struct map_location *_Nonnull);
 int  MAP_NodeDelLocationAtIndex(MAP *_Nonnull, MAP_Node *_Nonnull, int);
 void MAP_NodeSwapLayers(MAP *_Nonnull, MAP_Node *_Nonnull, int,int);
+
+/*
+ * Return the node at x,y for modification, loading its chunk if needed.
+ * The chunk is marked dirty and will not be paged out, and its cached
+ * draw list is invalidated. The coordinates must be inside the map.
+ * The map must be locked.
+ */
+static __inline__ MAP_Node *_Nonnull
+MAP_GetNode(MAP *_Nonnull map, int x, int y)
+{
+	const Uint idx = (Uint)(y >> MAP_CHUNK_SHIFT) * map->wChunks +
+	                 (Uint)(x >> MAP_CHUNK_SHIFT);
+	MAP_Chunk *ch;
+
+	if ((ch = map->chunks[idx]) == NULL) {
+		ch = MAP_LoadChunk(map, idx);
+	}
+	ch->flags |= MAP_CHUNK_DIRTY;
+	ch->tick = map->tick;
+	ch->rev++;
+	return &ch->nodes[((y & MAP_CHUNK_MASK) << MAP_CHUNK_SHIFT) +
+	                   (x & MAP_CHUNK_MASK)];
+}
+
+/*
+ * Return the node at x,y for reading, loading its chunk if needed.
+ * The chunk may be paged out after the map's tick is next incremented
+ * (e.g., by the next MAP_View(3) redraw). The map must be locked.
+ */
+static __inline__ const MAP_Node *_Nonnull
+MAP_GetConstNode(MAP *_Nonnull map, int x, int y)
+{
+	const Uint idx = (Uint)(y >> MAP_CHUNK_SHIFT) * map->wChunks +
+	                 (Uint)(x >> MAP_CHUNK_SHIFT);
+	MAP_Chunk *ch;
+
+	if ((ch = map->chunks[idx]) == NULL) {
+		ch = MAP_LoadChunk(map, idx);
+	}
+	ch->tick = map->tick;
+	return &ch->nodes[((y & MAP_CHUNK_MASK) << MAP_CHUNK_SHIFT) +
+	                   (x & MAP_CHUNK_MASK)];
+}
 __END_DECLS
 
 #include <agar/map/map_object.h>
@@ -0,0 +1,772 @@
+/*
+ * Copyright (c) 2026 Julien Nadeau Carriere <vedge@csoft.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Chunked node storage. The nodes of a map are stored in square chunks of
+ * MAP_CHUNK_SIZE x MAP_CHUNK_SIZE nodes which are allocated on first access.
+ *
+ * Maps are saved as an index of chunk sizes followed by the encoded chunks
+ * (empty chunks are omitted). When paging is enabled with MAP_SetPaging(),
+ * loading a map from a file only reads the index, and chunks are read back
+ * from the file as they are accessed. Unmodified chunks are paged out in
+ * least recently used order to stay within the budget. MAP_Prefetch() reads
+ * the chunks around a camera ahead of time from a separate thread.
+ */
+
+#include <agar/core/core.h>
+
+#include <agar/gui/gui.h>
+#include <agar/gui/widget.h>
+#include <agar/gui/primitive.h>
+#include <agar/gui/icons.h>
+
+#include <agar/map/map.h>
+
+#include <string.h>
+
+/* Paging state of a map loaded from a file. */
+typedef struct map_pager {
+	AG_DataSource *_Nonnull ds;         /* Map file (read-only) */
+	AG_Offset *_Nonnull offs;           /* Chunk data offsets */
+	Uint32 *_Nonnull lens;              /* Chunk data sizes (0 = empty) */
+	void *_Nullable *_Nonnull raw;      /* Prefetched chunk data */
+	Uint rawIdx[MAP_PREFETCH_MAX];      /* Chunks with prefetched data */
+	Uint nRaw;
+	Uint queue[MAP_PREFETCH_MAX];       /* Prefetch requests (FIFO) */
+	Uint nQueue;
+	int debug;                          /* File has debugging information */
+	Uint nLoads;                        /* Statistics */
+	Uint nPrefetched;
+	Uint nEvictions;
+#ifdef AG_THREADS
+	AG_Mutex lock;                      /* Lock on raw[] and queue[] */
+	AG_Cond cond;                       /* Prefetch request queued */
+	AG_Thread thread;                   /* Prefetch thread */
+	int threadState;
+# define MAP_PAGER_THREAD_NONE    0
+# define MAP_PAGER_THREAD_RUNNING 1
+# define MAP_PAGER_THREAD_EXITING 2
+#endif
+} MAP_Pager;
+
+#ifdef AG_THREADS
+# define PAGER_LOCK(pg)   AG_MutexLock(&(pg)->lock)
+# define PAGER_UNLOCK(pg) AG_MutexUnlock(&(pg)->lock)
+#else
+# define PAGER_LOCK(pg)
+# define PAGER_UNLOCK(pg)
+#endif
+
+/* Compute the area of the map covered by a chunk. */
+static void
+GetChunkArea(const MAP *_Nonnull map, Uint idx, int *_Nonnull x0,
+    int *_Nonnull y0, int *_Nonnull w, int *_Nonnull h)
+{
+	*x0 = (int)(idx % map->wChunks) << MAP_CHUNK_SHIFT;
+	*y0 = (int)(idx / map->wChunks) << MAP_CHUNK_SHIFT;
+	*w = MIN(MAP_CHUNK_SIZE, (int)map->w - *x0);
+	*h = MIN(MAP_CHUNK_SIZE, (int)map->h - *y0);
+}
+
+/* Destroy and free a resident chunk. */
+static void
+FreeChunk(MAP *_Nonnull map, MAP_Chunk *_Nonnull ch)
+{
+	Uint i;
+
+	for (i = 0; i < MAP_CHUNK_NODES; i++) {
+		MAP_NodeDestroy(map, &ch->nodes[i]);
+	}
+	if (ch->dl != NULL) {
+		MAP_FreeDrawList(ch->dl);
+	}
+	free(ch);
+}
+
+/* Remove prefetched data from the list. The pager must be locked. */
+static void
+PagerDropRaw(MAP_Pager *_Nonnull pg, Uint i)
+{
+	const Uint idx = pg->rawIdx[i];
+
+	free(pg->raw[idx]);
+	pg->raw[idx] = NULL;
+	pg->rawIdx[i] = pg->rawIdx[--pg->nRaw];
+}
+
+#ifdef AG_THREADS
+/* Read the chunks requested by MAP_Prefetch(). */
+static void *_Nullable
+PrefetchThread(void *_Nonnull arg)
+{
+	MAP_Pager *pg = arg;
+
+	AG_MutexLock(&pg->lock);
+	for (;;) {
+		Uint idx;
+		void *buf;
+
+		while (pg->nQueue == 0 &&
+		       pg->threadState == MAP_PAGER_THREAD_RUNNING) {
+			AG_CondWait(&pg->cond, &pg->lock);
+		}
+		if (pg->threadState != MAP_PAGER_THREAD_RUNNING) {
+			break;
+		}
+		idx = pg->queue[0];
+		memmove(&pg->queue[0], &pg->queue[1],
+		    (--pg->nQueue)*sizeof(Uint));
+		AG_MutexUnlock(&pg->lock);
+
+		if ((buf = TryMalloc(pg->lens[idx])) != NULL &&
+		    AG_ReadAt(pg->ds, buf, pg->lens[idx], pg->offs[idx]) == -1) {
+			free(buf);
+			buf = NULL;
+		}
+
+		AG_MutexLock(&pg->lock);
+		if (buf != NULL) {
+			if (pg->raw[idx] == NULL && pg->nRaw < MAP_PREFETCH_MAX) {
+				pg->raw[idx] = buf;
+				pg->rawIdx[pg->nRaw++] = idx;
+			} else {
+				free(buf);
+			}
+		}
+	}
+	AG_MutexUnlock(&pg->lock);
+	return (NULL);
+}
+#endif /* AG_THREADS */
+
+/*
+ * Open a map file for paging. Takes ownership of lens (the sizes of the
+ * chunks stored consecutively from offset base).
+ */
+static MAP_Pager *_Nullable
+PagerOpen(MAP *_Nonnull map, const char *_Nonnull path, Uint32 *_Nonnull lens,
+    AG_Offset base, int debug)
+{
+	const Uint nChunks = map->wChunks * map->hChunks;
+	MAP_Pager *pg;
+	Uint i;
+
+	if ((pg = TryMalloc(sizeof(MAP_Pager))) == NULL) {
+		return (NULL);
+	}
+	if ((pg->offs = TryMalloc(nChunks*sizeof(AG_Offset))) == NULL) {
+		goto fail;
+	}
+	if ((pg->raw = TryMalloc(nChunks*sizeof(void *))) == NULL) {
+		goto fail_offs;
+	}
+	if ((pg->ds = AG_OpenFile(path, "rb")) == NULL) {
+		goto fail_raw;
+	}
+	for (i = 0; i < nChunks; i++) {
+		pg->offs[i] = base;
+		pg->raw[i] = NULL;
+		base += lens[i];
+	}
+	pg->lens = lens;
+	pg->nRaw = 0;
+	pg->nQueue = 0;
+	pg->debug = debug;
+	pg->nLoads = 0;
+	pg->nPrefetched = 0;
+	pg->nEvictions = 0;
+#ifdef AG_THREADS
+	AG_MutexInit(&pg->lock);
+	AG_CondInit(&pg->cond);
+	pg->threadState = MAP_PAGER_THREAD_NONE;
+#endif
+	return (pg);
+fail_raw:
+	free(pg->raw);
+fail_offs:
+	free(pg->offs);
+fail:
+	free(pg);
+	return (NULL);
+}
+
+/* Stop paging from the map file. */
+static void
+PagerClose(MAP_Pager *_Nonnull pg)
+{
+#ifdef AG_THREADS
+	if (pg->threadState == MAP_PAGER_THREAD_RUNNING) {
+		void *rv;
+
+		AG_MutexLock(&pg->lock);
+		pg->threadState = MAP_PAGER_THREAD_EXITING;
+		AG_CondBroadcast(&pg->cond);
+		AG_MutexUnlock(&pg->lock);
+		AG_ThreadJoin(pg->thread, &rv);
+	}
+	AG_CondDestroy(&pg->cond);
+	AG_MutexDestroy(&pg->lock);
+#endif
+	while (pg->nRaw > 0) {
+		PagerDropRaw(pg, 0);
+	}
+	AG_CloseFile(pg->ds);
+	free(pg->raw);
+	free(pg->lens);
+	free(pg->offs);
+	free(pg);
+}
+
+/*
+ * Allocate the chunk array for a map of w x h nodes, releasing any existing
+ * nodes. Chunks are allocated (and their nodes initialized) on first access.
+ */
+int
+MAP_AllocNodes(MAP *map, Uint w, Uint h)
+{
+	const Uint wChunks = (w + MAP_CHUNK_MASK) >> MAP_CHUNK_SHIFT;
+	const Uint hChunks = (h + MAP_CHUNK_MASK) >> MAP_CHUNK_SHIFT;
+	MAP_Chunk **chunks;
+	AG_Size size;
+
+	if (w > MAP_WIDTH_MAX || h > MAP_HEIGHT_MAX) {
+		AG_SetError(_("%ux%u nodes exceed the limit of %ux%u."),
+		    w,h, MAP_WIDTH_MAX, MAP_HEIGHT_MAX);
+		return (-1);
+	}
+	size = MAX(1, wChunks*hChunks) * sizeof(MAP_Chunk *);
+	if ((chunks = TryMalloc(size)) == NULL) {
+		return (-1);
+	}
+	memset(chunks, 0, size);
+
+	AG_ObjectLock(map);
+	MAP_FreeNodes(map);
+	map->chunks = chunks;
+	map->wChunks = wChunks;
+	map->hChunks = hChunks;
+	map->nResident = 0;
+	map->w = w;
+	map->h = h;
+	AG_ObjectUnlock(map);
+	return (0);
+}
+
+/* Release all nodes and stop paging from the map file. */
+void
+MAP_FreeNodes(MAP *map)
+{
+	MAP_Chunk *ch, *chNext;
+
+	if (map->chunks == NULL) {
+		return;
+	}
+	if (map->pager != NULL) {
+		PagerClose(map->pager);
+		map->pager = NULL;
+	}
+	for (ch = TAILQ_FIRST(&map->resident);
+	     ch != TAILQ_END(&map->resident);
+	     ch = chNext) {
+		chNext = TAILQ_NEXT(ch, resident);
+		FreeChunk(map, ch);
+	}
+	TAILQ_INIT(&map->resident);
+	free(map->chunks);
+	map->chunks = NULL;
+	map->nResident = 0;
+}
+
+/* Decode the nodes of a chunk. */
+static int
+DecodeChunk(MAP *_Nonnull map, AG_DataSource *_Nonnull ds,
+    MAP_Chunk *_Nonnull ch)
+{
+	int x0, y0, w, h, x, y;
+
+	GetChunkArea(map, ch->idx, &x0, &y0, &w, &h);
+
+	for (y = 0; y < h; y++) {
+		for (x = 0; x < w; x++) {
+			MAP_Node *node = &ch->nodes[(y << MAP_CHUNK_SHIFT) + x];
+
+			if (MAP_NodeLoad(map, ds, node) == -1) {
+				goto fail;
+			}
+			if (node->nLocs > 0)
+				ch->flags |= MAP_CHUNK_PINNED;
+		}
+	}
+	return (0);
+fail:
+	for (x = 0; x < MAP_CHUNK_NODES; x++) {
+		MAP_NodeDestroy(map, &ch->nodes[x]);
+		MAP_NodeInit(&ch->nodes[x]);
+	}
+	return (-1);
+}
+
+/*
+ * Return the encoded data of a chunk from the map file (either prefetched
+ * or read now). The caller must free the buffer.
+ */
+static void *_Nullable
+PagerRead(MAP_Pager *_Nonnull pg, Uint idx)
+{
+	void *buf;
+	Uint i;
+
+	PAGER_LOCK(pg);
+	for (i = 0; i < pg->nQueue; i++) {
+		if (pg->queue[i] == idx) {
+			memmove(&pg->queue[i], &pg->queue[i+1],
+			    (--pg->nQueue - i)*sizeof(Uint));
+			break;
+		}
+	}
+	if ((buf = pg->raw[idx]) != NULL) {
+		for (i = 0; i < pg->nRaw; i++) {
+			if (pg->rawIdx[i] == idx)
+				break;
+		}
+		pg->raw[idx] = NULL;
+		pg->rawIdx[i] = pg->rawIdx[--pg->nRaw];
+		pg->nPrefetched++;
+		PAGER_UNLOCK(pg);
+		return (buf);
+	}
+	PAGER_UNLOCK(pg);
+
+	if ((buf = TryMalloc(pg->lens[idx])) == NULL) {
+		return (NULL);
+	}
+	if (AG_ReadAt(pg->ds, buf, pg->lens[idx], pg->offs[idx]) == -1) {
+		free(buf);
+		return (NULL);
+	}
+	return (buf);
+}
+
+/* Read a chunk from the map file. */
+static int
+PagerLoad(MAP *_Nonnull map, MAP_Pager *_Nonnull pg, MAP_Chunk *_Nonnull ch)
+{
+	AG_DataSource *ds;
+	void *buf;
+	int rv;
+
+	if ((buf = PagerRead(pg, ch->idx)) == NULL) {
+		return (-1);
+	}
+	if ((ds = AG_OpenConstCore(buf, pg->lens[ch->idx])) == NULL) {
+		free(buf);
+		return (-1);
+	}
+	AG_SetSourceDebug(ds, pg->debug);
+	rv = DecodeChunk(map, ds, ch);
+	AG_CloseCore(ds);
+	free(buf);
+	pg->nLoads++;
+	return (rv);
+}
+
+/*
+ * Make the chunk at index idx resident, reading it from the map file if the
+ * map is paged (or else creating empty nodes). If the paging budget is
+ * exceeded, page out the least recently used clean chunk. Called by
+ * MAP_GetNode() and MAP_GetConstNode(). The map must be locked.
+ */
+MAP_Chunk *
+MAP_LoadChunk(MAP *map, Uint idx)
+{
+	MAP_Pager *pg = map->pager;
+	MAP_Chunk *ch;
+	Uint i;
+
+#ifdef AG_DEBUG
+	if (idx >= map->wChunks*map->hChunks || map->chunks[idx] != NULL)
+		AG_FatalError("Bad chunk");
+#endif
+	if (pg != NULL && map->nResidentMax > 0 &&
+	    map->nResident >= map->nResidentMax)
+		MAP_EvictChunks(map, map->nResidentMax - 1);
+
+	ch = Malloc(sizeof(MAP_Chunk));
+	ch->flags = 0;
+	ch->idx = idx;
+	ch->tick = map->tick;
+	ch->rev = 0;
+	ch->dl = NULL;
+	for (i = 0; i < MAP_CHUNK_NODES; i++)
+		MAP_NodeInit(&ch->nodes[i]);
+
+	if (pg != NULL && pg->lens[idx] > 0 &&
+	    PagerLoad(map, pg, ch) == -1) {
+		Verbose("%s: Chunk %u: %s\n", OBJECT(map)->name, idx,
+		    AG_GetError());
+		ch->flags |= MAP_CHUNK_PINNED;             /* Don't retry */
+	}
+	map->chunks[idx] = ch;
+	TAILQ_INSERT_HEAD(&map->resident, ch, resident);
+	map->nResident++;
+	return (ch);
+}
+
+/*
+ * Return 1 if the chunk at index idx is neither resident nor stored in the
+ * map file (i.e., its nodes are all empty). Whole-map operations may skip
+ * over vacant chunks instead of loading them. The map must be locked.
+ */
+int
+MAP_ChunkIsVacant(MAP *map, Uint idx)
+{
+	return (map->chunks[idx] == NULL &&
+	        (map->pager == NULL || map->pager->lens[idx] == 0));
+}
+
+/*
+ * Page out least recently used chunks until no more than nMax are resident.
+ * Only unmodified chunks of a paged map which have not been accessed since
+ * the map's tick was last incremented are paged out. The map must be locked.
+ */
+void
+MAP_EvictChunks(MAP *map, Uint nMax)
+{
+	MAP_Pager *pg = map->pager;
+
+	if (pg == NULL) {
+		return;
+	}
+	while (map->nResident > nMax) {
+		MAP_Chunk *ch, *chLRU = NULL;
+
+		TAILQ_FOREACH(ch, &map->resident, resident) {
+			if ((ch->flags & (MAP_CHUNK_DIRTY | MAP_CHUNK_PINNED)) ||
+			    ch->tick == map->tick) {
+				continue;
+			}
+			if (chLRU == NULL ||
+			    (Sint32)(ch->tick - chLRU->tick) < 0)
+				chLRU = ch;
+		}
+		if (chLRU == NULL) {
+			break;
+		}
+		TAILQ_REMOVE(&map->resident, chLRU, resident);
+		map->chunks[chLRU->idx] = NULL;
+		map->nResident--;
+		FreeChunk(map, chLRU);
+		pg->nEvictions++;
+	}
+}
+
+/*
+ * Set the maximum number of chunks kept in memory for a map loaded from a
+ * file. This must be set before loading to enable paging. If 0, loading a
+ * map reads all of its nodes.
+ */
+void
+MAP_SetPaging(MAP *map, Uint nMax)
+{
+	AG_ObjectLock(map);
+	map->nResidentMax = nMax;
+	if (nMax > 0) {
+		MAP_EvictChunks(map, nMax);
+	}
+	AG_ObjectUnlock(map);
+}
+
+/*
+ * Request that the chunks covering nodes x1,y1 to x2,y2 (inclusive) be read
+ * ahead of time, closest to the center first. Previous requests and data
+ * prefetched outside of this area are discarded. This is a no-op unless the
+ * map is paged and threads are available. The map must be locked.
+ */
+void
+MAP_Prefetch(MAP *map, int x1, int y1, int x2, int y2)
+{
+#ifdef AG_THREADS
+	MAP_Pager *pg = map->pager;
+	int cx1, cy1, cx2, cy2, cxMid, cyMid, r, rMax, cx, cy;
+	Uint i;
+
+	if (pg == NULL || map->nResidentMax == 0)
+		return;
+
+	cx1 = MAX(0, x1) >> MAP_CHUNK_SHIFT;
+	cy1 = MAX(0, y1) >> MAP_CHUNK_SHIFT;
+	cx2 = MIN(x2, (int)map->w - 1) >> MAP_CHUNK_SHIFT;
+	cy2 = MIN(y2, (int)map->h - 1) >> MAP_CHUNK_SHIFT;
+	if (cx1 > cx2 || cy1 > cy2) {
+		return;
+	}
+	cxMid = (cx1 + cx2) >> 1;
+	cyMid = (cy1 + cy2) >> 1;
+	rMax = MAX(MAX(cxMid - cx1, cx2 - cxMid), MAX(cyMid - cy1, cy2 - cyMid));
+
+	AG_MutexLock(&pg->lock);
+
+	/* Discard stale requests and data. */
+	pg->nQueue = 0;
+	for (i = 0; i < pg->nRaw; ) {
+		const Uint idx = pg->rawIdx[i];
+
+		cx = (int)(idx % map->wChunks);
+		cy = (int)(idx / map->wChunks);
+		if (cx < cx1 || cx > cx2 || cy < cy1 || cy > cy2 ||
+		    map->chunks[idx] != NULL) {
+			PagerDropRaw(pg, i);
+		} else {
+			i++;
+		}
+	}
+
+	/* Queue the missing chunks, in rings around the center. */
+	for (r = 0; r <= rMax; r++) {
+		for (cy = cyMid - r; cy <= cyMid + r; cy++) {
+			for (cx = cxMid - r; cx <= cxMid + r; cx++) {
+				Uint idx;
+
+				if (cx < cx1 || cx > cx2 || cy < cy1 || cy > cy2 ||
+				    (cx != cxMid - r && cx != cxMid + r &&
+				     cy != cyMid - r && cy != cyMid + r)) {
+					continue;
+				}
+				idx = (Uint)cy * map->wChunks + (Uint)cx;
+				if (map->chunks[idx] != NULL ||
+				    pg->lens[idx] == 0 ||
+				    pg->raw[idx] != NULL) {
+					continue;
+				}
+				if (pg->nQueue + pg->nRaw >= MAP_PREFETCH_MAX) {
+					goto queued;
+				}
+				pg->queue[pg->nQueue++] = idx;
+			}
+		}
+	}
+queued:
+	if (pg->nQueue > 0) {
+		if (pg->threadState == MAP_PAGER_THREAD_NONE) {
+			pg->threadState = MAP_PAGER_THREAD_RUNNING;
+			if (AG_ThreadTryCreate(&pg->thread, PrefetchThread,
+			    pg) != 0) {
+				Verbose("%s: %s\n", OBJECT(map)->name,
+				    AG_GetError());
+				pg->threadState = MAP_PAGER_THREAD_EXITING;
+			}
+		}
+		AG_CondSignal(&pg->cond);
+	}
+	AG_MutexUnlock(&pg->lock);
+#endif /* AG_THREADS */
+}
+
+/* Return node storage and paging statistics. */
+void
+MAP_GetChunkStats(MAP *map, MAP_ChunkStats *st)
+{
+	MAP_Pager *pg;
+	MAP_Chunk *ch;
+
+	AG_ObjectLock(map);
+	st->nChunks = map->wChunks * map->hChunks;
+	st->nResident = map->nResident;
+	st->nDirty = 0;
+	TAILQ_FOREACH(ch, &map->resident, resident) {
+		if (ch->flags & (MAP_CHUNK_DIRTY | MAP_CHUNK_PINNED))
+			st->nDirty++;
+	}
+	if ((pg = map->pager) != NULL) {
+		st->nLoads = pg->nLoads;
+		st->nPrefetched = pg->nPrefetched;
+		st->nEvictions = pg->nEvictions;
+	} else {
+		st->nLoads = 0;
+		st->nPrefetched = 0;
+		st->nEvictions = 0;
+	}
+	AG_ObjectUnlock(map);
+}
+
+/*
+ * Load the nodes of a map. The chunk array must be allocated. If paging is
+ * enabled and ds is a file, only read the index of chunks.
+ */
+int
+MAP_LoadNodes(MAP *map, AG_DataSource *ds, const AG_Version *ver)
+{
+	Uint32 *lens;
+	AG_Offset base;
+	AG_Size total = 0;
+	Uint i, nChunks, shift;
+	int x, y;
+
+	if (ver->major == 12 && ver->minor < 2) {     /* Sequential nodes */
+		for (y = 0; y < (int)map->h; y++) {
+			for (x = 0; x < (int)map->w; x++) {
+				if (MAP_NodeLoad(map, ds,
+				    MAP_GetNode(map, x,y)) == -1)
+					return (-1);
+			}
+		}
+		return (0);
+	}
+
+	if ((shift = (Uint)AG_ReadUint8(ds)) != MAP_CHUNK_SHIFT) {
+		AG_SetError("Unsupported chunk size (%d)", 1 << shift);
+		return (-1);
+	}
+	if ((Uint)AG_ReadUint32(ds) != map->wChunks ||
+	    (Uint)AG_ReadUint32(ds) != map->hChunks) {
+		AG_SetErrorS("Bad chunk count");
+		return (-1);
+	}
+	nChunks = map->wChunks * map->hChunks;
+	if ((lens = TryMalloc(MAX(1,nChunks) * sizeof(Uint32))) == NULL) {
+		return (-1);
+	}
+	for (i = 0; i < nChunks; i++) {
+		lens[i] = AG_ReadUint32(ds);
+		total += lens[i];
+	}
+	base = AG_Tell(ds);
+
+	if (map->nResidentMax > 0 && ds->close == AG_CloseFile &&
+	    AG_FILE_SOURCE(ds)->path != NULL) {
+		MAP_Pager *pg;
+
+		if ((pg = PagerOpen(map, AG_FILE_SOURCE(ds)->path, lens, base,
+		    ds->debug)) != NULL) {
+			map->pager = pg;
+			return AG_Seek(ds, base + total, AG_SEEK_SET);
+		}
+		Verbose("%s: Not paging (%s)\n", OBJECT(map)->name,
+		    AG_GetError());
+	}
+
+	for (i = 0; i < nChunks; i++) {
+		MAP_Chunk *ch;
+		AG_Offset offs;
+
+		if (lens[i] == 0) {
+			continue;
+		}
+		ch = MAP_LoadChunk(map, i);
+		offs = AG_Tell(ds);
+		if (DecodeChunk(map, ds, ch) == -1) {
+			goto fail;
+		}
+		if (AG_Tell(ds) - offs != lens[i]) {
+			AG_SetError("Chunk %u: Bad size", i);
+			goto fail;
+		}
+	}
+	free(lens);
+	return (0);
+fail:
+	free(lens);
+	return (-1);
+}
+
+/* Return 1 if the nodes of a chunk are all empty. */
+static int
+ChunkIsEmpty(const MAP_Chunk *_Nonnull ch)
+{
+	Uint i;
+
+	for (i = 0; i < MAP_CHUNK_NODES; i++) {
+		const MAP_Node *node = &ch->nodes[i];
+
+		if (node->flags != MAP_NODE_VALID || node->nLocs > 0 ||
+		    !TAILQ_EMPTY(&node->items))
+			return (0);
+	}
+	return (1);
+}
+
+/*
+ * Save the nodes of a map. Chunks of a paged map which are not resident are
+ * copied from the map file as-is.
+ */
+int
+MAP_SaveNodes(MAP *map, AG_DataSource *ds)
+{
+	MAP_Pager *pg = map->pager;
+	const Uint nChunks = map->wChunks * map->hChunks;
+	AG_Offset indexOffs;
+	Uint i;
+
+	AG_WriteUint8(ds, MAP_CHUNK_SHIFT);
+	AG_WriteUint32(ds, (Uint32)map->wChunks);
+	AG_WriteUint32(ds, (Uint32)map->hChunks);
+	indexOffs = AG_Tell(ds);
+	for (i = 0; i < nChunks; i++)
+		AG_WriteUint32(ds, 0);
+
+	for (i = 0; i < nChunks; i++) {
+		MAP_Chunk *ch = map->chunks[i];
+		AG_Offset offs = AG_Tell(ds);
+		int x0, y0, w, h, x, y;
+
+		if (ch == NULL) {
+			void *buf;
+			int rv;
+
+			if (pg == NULL || pg->lens[i] == 0) {
+				continue;                          /* Empty */
+			}
+			if (pg->debug != ds->debug) {
+				ch = MAP_LoadChunk(map, i);        /* Re-encode */
+				goto encode;
+			}
+			if ((buf = PagerRead(pg, i)) == NULL) {
+				return (-1);
+			}
+			rv = AG_Write(ds, buf, pg->lens[i]);
+			free(buf);
+			if (rv != 0) {
+				return (-1);
+			}
+			AG_WriteUint32At(ds, pg->lens[i],
+			    indexOffs + i*sizeof(Uint32));
+			continue;
+		}
+encode:
+		if (ChunkIsEmpty(ch)) {
+			continue;
+		}
+		GetChunkArea(map, i, &x0, &y0, &w, &h);
+		for (y = 0; y < h; y++) {
+			for (x = 0; x < w; x++) {
+				MAP_NodeSave(map, ds,
+				    &ch->nodes[(y << MAP_CHUNK_SHIFT) + x]);
+			}
+		}
+		AG_WriteUint32At(ds, (Uint32)(AG_Tell(ds) - offs),
+		    indexOffs + i*sizeof(Uint32));
+	}
+	return (0);
+}
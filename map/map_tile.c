@@ -148,98 +148,90 @@ Save(MAP *map, void *mi, AG_DataSource *ds)
 	AG_WriteUint16(ds, (Uint16)mt->rs.h);
 }
 
-static void
-Draw(MAP_View *_Nonnull mv, MAP_Item *_Nonnull mi, int rx, int ry, int ncam)
+/*
+ * Return the cached variant of the tile referenced by mt (with mt's
+ * transforms applied and scaled for the tile size of mv), and its surface
+ * ID in mv. Return NULL if the tile does not exist. The map must be locked.
+ */
+RG_TileVariant *
+MAP_TileGetVariant(MAP_View *mv, const MAP_Tile *mt, int *texture)
 {
-	MAP_Tile *mt = MAPTILE(mi);
 	RG_Tile *tile;
 	RG_TileVariant *var;
-	RG_Transform *xf, *xf2;
-//	const int tileSz = mv->map->cameras[ncam].tilesz;
 
-	if (RG_LookupTile(mt->obj, mt->id, &tile) != 0) {
+	if (mt->obj == NULL || RG_LookupTile(mt->obj, mt->id, &tile) != 0 ||
+	    (var = RG_TileGetVariant(tile, &MAPITEM(mt)->transforms,
+	     MAP_TILESZ(mv) * RG_SCALE_ONE / MAP_TILESZ_DEF)) == NULL) {
 		Debug(mv, "Tile %s:%u not found\n",
 		    (mt->obj != NULL) ? OBJECT(mt->obj)->name : "NULL",
 		    mt->id);
-		return;
+		return (NULL);
 	}
-	Debug(mv, "Draw %s:%u @ %d,%d cam %d\n",
-	    OBJECT(mt->obj)->name, mt->id, rx,ry, ncam);
-
-	SLIST_FOREACH(var, &tile->vars, vars) {
-		if (var->view != mv) {
-			continue;
-		}
-		for (xf = TAILQ_FIRST(&mi->transforms), xf2 = TAILQ_FIRST(&var->transforms);
-		     xf != TAILQ_END(&mi->transforms) && xf2 != TAILQ_END(&var->transforms);
-		     xf = TAILQ_NEXT(xf, transforms), xf2 = TAILQ_NEXT(xf2, transforms)) {
-			if (!RG_TransformCompare(xf, xf2))
-				break;
-		}
-		if (xf == TAILQ_END(&mi->transforms) &&
-		    xf2 == TAILQ_END(&var->transforms))
-			break;
-	}
-	if (var == NULL) {
-		RG_Transform *xf;
-		const AG_Surface *Stile = tile->su;
-		AG_Surface *Sx;
-		
-		var = Malloc(sizeof(RG_TileVariant));
-		TAILQ_INIT(&var->transforms);
-		RG_TransformChainDup(&mi->transforms, &var->transforms);
-		var->surface = AG_SurfaceRGBA(
-		    Stile->w, Stile->h, Stile->format.BitsPerPixel,
-		    Stile->flags & AG_SURFACE_COLORKEY,
-		    Stile->format.Rmask,
-		    Stile->format.Gmask,
-		    Stile->format.Bmask,
-		    Stile->format.Amask);
-		if (var->surface == NULL) {
-			AG_FatalError(NULL);
-		}
-		var->view = mv;
-		AG_SurfaceCopy(var->surface, Stile);
-
-		TAILQ_FOREACH(xf, &mi->transforms, transforms) {
-			Sx = xf->func(var->surface, xf->nArgs, xf->args);
-			if (Sx != var->surface) {
-				AG_SurfaceFree(var->surface);
-				var->surface = Sx;
-			}
-		}
-
-		var->texture = AG_WidgetMapSurface(mv, var->surface);
-
-		SLIST_INSERT_HEAD(&tile->vars, var, vars);
-
-		Debug(mv, "Draw %s:%u @ %d,%d: New variant %p\n",
-		    OBJECT(mt->obj)->name, mt->id, rx,ry, var);
+	*texture = RG_TileVariantMap(var, mv);
+	return (var);
+}
+
+/*
+ * Render a tile item at rx,ry (the upper-left corner of its node in mv)
+ * using a variant and surface ID returned by MAP_TileGetVariant().
+ */
+void
+MAP_TileBlit(MAP_View *mv, const MAP_Tile *mt, const RG_TileVariant *var,
+    int texture, int rx, int ry)
+{
+	const int tileSz = MAP_TILESZ(mv);
+	AG_Rect rs;
+
+	if (tileSz != MAP_TILESZ_DEF) {
+		rx += (mt->xCenter + mt->xMotion) * tileSz / MAP_TILESZ_DEF;
+		ry += (mt->yCenter + mt->yMotion) * tileSz / MAP_TILESZ_DEF;
+		rs.x = mt->rs.x * tileSz / MAP_TILESZ_DEF;
+		rs.y = mt->rs.y * tileSz / MAP_TILESZ_DEF;
+		rs.w = mt->rs.w * tileSz / MAP_TILESZ_DEF;
+		rs.h = mt->rs.h * tileSz / MAP_TILESZ_DEF;
 	} else {
-		Debug(mv, "Draw %s:%u @ %d,%d: Found variant %p (last drawn %u)\n",
-		    OBJECT(mt->obj)->name, mt->id, rx,ry, var, var->last_drawn);
+		rx += mt->xCenter + mt->xMotion;
+		ry += mt->yCenter + mt->yMotion;
+		rs = mt->rs;
 	}
-	var->last_drawn = AG_GetTicks();
 
-#if 0
-	if (tileSz != MAP_TILESZ_DEF) {
-		x = rx + mi->data.tile.xCenter * tileSz / MAP_TILESZ_DEF +
-		         mi->data.tile.xMotion * tileSz / MAP_TILESZ_DEF;
+	/* Clip to the variant (which may be packed into an atlas). */
+	if (rs.x < 0) { rx -= rs.x; rs.w += rs.x; rs.x = 0; }
+	if (rs.y < 0) { ry -= rs.y; rs.h += rs.y; rs.y = 0; }
+	if (rs.x + rs.w > var->rd.w) { rs.w = var->rd.w - rs.x; }
+	if (rs.y + rs.h > var->rd.h) { rs.h = var->rd.h - rs.y; }
+	if (rs.w <= 0 || rs.h <= 0) {
+		return;
+	}
+	rs.x += var->rd.x;
+	rs.y += var->rd.y;
+	AG_WidgetBlitFrom(mv, texture, &rs, rx, ry);
+}
 
-		y = ry + mi->data.tile.yCenter * tileSz / MAP_TILESZ_DEF +
-		         mi->data.tile.yMotion * tileSz / MAP_TILESZ_DEF;
+/*
+ * Return 1 if the tile lies entirely within its node, such that it cannot
+ * overlap items on other nodes.
+ */
+int
+MAP_TileIsInCell(const MAP_Tile *mt)
+{
+	const int x = mt->xCenter + mt->xMotion;
+	const int y = mt->yCenter + mt->yMotion;
 
-		BlitSurfaceScaled(m, su, &mi->data.tile.rs, x,y, cam);
-	} else {
-		x = rx + mi->data.tile.xCenter + mi->data.tile.xMotion;
-		y = ry + mi->data.tile.yCenter + mi->data.tile.yMotion;
+	return (x >= 0 && y >= 0 &&
+	        x + mt->rs.w <= MAP_TILESZ_DEF &&
+	        y + mt->rs.h <= MAP_TILESZ_DEF);
+}
 
-		AG_WidgetBlit(mv, su, x,y);
-		AG_SurfaceBlit(su,
-		    debug_su ? NULL : &mi->data.tile.rs,
-		    agView->v, x,y);
-	}
-#endif
+static void
+Draw(MAP_View *_Nonnull mv, MAP_Item *_Nonnull mi, int rx, int ry, int ncam)
+{
+	MAP_Tile *mt = MAPTILE(mi);
+	RG_TileVariant *var;
+	int texture;
+
+	if ((var = MAP_TileGetVariant(mv, mt, &texture)) != NULL)
+		MAP_TileBlit(mv, mt, var, texture, rx,ry);
 }
 
 static int
@@ -21,4 +21,11 @@ MAP_Tile *_Nonnull MAP_TileNew(MAP *_Nonnull, MAP_Node *_Nonnull,
 
 void MAP_TileSet(MAP_Tile *_Nonnull, MAP *_Nonnull,
                  RG_Tileset *_Nullable, Uint);
+
+RG_TileVariant *_Nullable MAP_TileGetVariant(struct map_view *_Nonnull,
+                                             const MAP_Tile *_Nonnull,
+                                             int *_Nonnull);
+void MAP_TileBlit(struct map_view *_Nonnull, const MAP_Tile *_Nonnull,
+                  const RG_TileVariant *_Nonnull, int, int,int);
+int  MAP_TileIsInCell(const MAP_Tile *_Nonnull);
 __END_DECLS
@@ -259,6 +259,8 @@ Destroy(void *_Nonnull p)
 	MAP_View *mv = p;
 	MAP_ViewDrawCb *dcb, *ndcb;
 
+	RG_VariantCacheDetach(mv);
+
 	for (dcb = SLIST_FIRST(&mv->draw_cbs);
 	     dcb != SLIST_END(&mv->draw_cbs);
 	     dcb = ndcb) {
@@ -410,16 +412,314 @@ DrawTiling(void *_Nonnull obj, const AG_Rect *_Nonnull r, int tsz, int offs,
 	}
 }
 
+/*
+ * Compute a sort key for a tile, such that tiles rendered from the same
+ * texture are adjacent in draw lists. Untransformed tiles of a tileset
+ * share its atlas (see RG_TileVariantMap(3)), so they share a key.
+ */
+static Uint32
+TileTextureKey(const MAP_Tile *_Nonnull mt)
+{
+	const RG_TransformChain *transforms = &MAPITEM(mt)->transforms;
+	Uint32 h = 2166136261u;
+
+	h = (h ^ (Uint32)((AG_Size)mt->obj >> 4)) * 16777619u;
+	if (TAILQ_EMPTY(transforms)) {
+		return (h);
+	}
+	h = (h ^ (Uint32)mt->id) * 16777619u;
+	return (h ^ RG_TransformChainHash(transforms)) * 16777619u;
+}
+
+/* Return 1 if two tiles are rendered from the same variant. */
+static __inline__ int
+TileVariantEqual(const MAP_Tile *_Nonnull a, const MAP_Tile *_Nonnull b)
+{
+	return (a->obj == b->obj && a->id == b->id &&
+	        RG_TransformChainCompare(&MAPITEM(a)->transforms,
+	                                 &MAPITEM(b)->transforms));
+}
+
+static int
+CompareDrawEnts(const void *_Nonnull p1, const void *_Nonnull p2)
+{
+	const MAP_DrawEnt *e1 = p1;
+	const MAP_DrawEnt *e2 = p2;
+
+	if (e1->depth != e2->depth) {
+		return ((int)e1->depth - (int)e2->depth);
+	}
+	if (e1->key != e2->key) {
+		return (e1->key < e2->key) ? -1 : 1;
+	}
+	return ((int)e1->node - (int)e2->node);
+}
+
+/* Return 1 if an item may be drawn out of node order (see MAP_DrawList). */
+static __inline__ int
+IsBatchable(const MAP_Item *_Nonnull mi)
+{
+	return (mi->type == MAP_ITEM_TILE && MAP_TileIsInCell(MAPTILE(mi)));
+}
+
+/*
+ * Return the draw list of a chunk, rebuilding it if the chunk (or the
+ * map's layers) changed since it was built. The map must be locked.
+ */
+MAP_DrawList *
+MAP_GetDrawList(MAP *map, MAP_Chunk *ch)
+{
+	MAP_DrawList *dl = ch->dl;
+	const Uint nLayers = map->nLayers;
+	Uint cur[MAP_LAYERS_MAX*2];
+	Uint i, l;
+
+	if (dl != NULL) {
+		if (dl->rev == ch->rev && dl->nLayers == nLayers) {
+			return (dl);
+		}
+		MAP_FreeDrawList(dl);
+	}
+	dl = Malloc(sizeof(MAP_DrawList));
+	dl->rev = ch->rev;
+	dl->nLayers = nLayers;
+	dl->offs = Malloc((nLayers + 1) * sizeof(Uint));
+	dl->nBatched = Malloc(nLayers * sizeof(Uint));
+	memset(dl->offs, 0, (nLayers + 1) * sizeof(Uint));
+	memset(dl->nBatched, 0, nLayers * sizeof(Uint));
+
+	/* Count the entries of each layer. */
+	for (i = 0; i < MAP_CHUNK_NODES; i++) {
+		const MAP_Item *mi;
+
+		TAILQ_FOREACH(mi, &ch->nodes[i].items, items) {
+			if (mi->layer >= nLayers) {
+				continue;
+			}
+			if (IsBatchable(mi)) {
+				dl->nBatched[mi->layer]++;
+			}
+			dl->offs[mi->layer + 1]++;
+		}
+	}
+	for (l = 0; l < nLayers; l++) {
+		dl->offs[l + 1] += dl->offs[l];
+		cur[l] = dl->offs[l];
+		cur[MAP_LAYERS_MAX + l] = dl->offs[l] + dl->nBatched[l];
+	}
+	dl->ents = (dl->offs[nLayers] > 0) ?
+	           Malloc(dl->offs[nLayers] * sizeof(MAP_DrawEnt)) : NULL;
+
+	/* Fill in the entries (in node order). */
+	for (i = 0; i < MAP_CHUNK_NODES; i++) {
+		MAP_Item *mi, *miPrev;
+
+		TAILQ_FOREACH(mi, &ch->nodes[i].items, items) {
+			MAP_DrawEnt *e;
+			Uint depth = 0;
+
+			if (mi->layer >= nLayers) {
+				continue;
+			}
+			for (miPrev = TAILQ_FIRST(&ch->nodes[i].items);
+			     miPrev != mi;
+			     miPrev = TAILQ_NEXT(miPrev, items)) {
+				if (miPrev->layer == mi->layer)
+					depth++;
+			}
+			if (IsBatchable(mi)) {
+				e = &dl->ents[cur[mi->layer]++];
+				e->key = TileTextureKey(MAPTILE(mi));
+			} else {
+				e = &dl->ents[cur[MAP_LAYERS_MAX + mi->layer]++];
+				e->key = 0;
+			}
+			e->mi = mi;
+			e->node = (Uint16)i;
+			e->depth = (Uint16)MIN(depth, 0xffff);
+		}
+	}
+
+	/* Sort the batched entries by depth and variant. */
+	for (l = 0; l < nLayers; l++) {
+		if (dl->nBatched[l] > 1)
+			qsort(&dl->ents[dl->offs[l]], dl->nBatched[l],
+			    sizeof(MAP_DrawEnt), CompareDrawEnts);
+	}
+	ch->dl = dl;
+	return (dl);
+}
+
+void
+MAP_FreeDrawList(MAP_DrawList *dl)
+{
+	Free(dl->ents);
+	free(dl->nBatched);
+	free(dl->offs);
+	free(dl);
+}
+
+/* Return a chunk in the visible area, or NULL if it is vacant. */
+static MAP_Chunk *_Nullable
+GetVisibleChunk(MAP *_Nonnull map, Uint idx)
+{
+	MAP_Chunk *ch;
+
+	if ((ch = map->chunks[idx]) == NULL) {
+		if (MAP_ChunkIsVacant(map, idx)) {
+			return (NULL);
+		}
+		ch = MAP_LoadChunk(map, idx);
+	}
+	ch->tick = map->tick;
+	return (ch);
+}
+
+/* Render the editor overlays of a map item. */
+static void
+DrawItemOverlays(MAP_View *_Nonnull mv, MAP *_Nonnull map,
+    const MAP_Item *_Nonnull mi, int rx, int ry, int tileSz)
+{
+	AG_Rect r, rExtent;
+	AG_Color c;
+
+	if ((mi->layer == map->layerCur) &&
+	    (mv->mode == MAP_VIEW_EDIT_ATTRS)) {
+		MAP_ItemAttrColor(mv->edit_attr,
+		    (mi->flags & mv->edit_attr), &c);
+		r.x = rx;
+		r.y = ry;
+		r.w = tileSz;
+		r.h = tileSz;
+		AG_DrawRectBlended(mv, &r, &c,
+		    AG_ALPHA_SRC,
+		    AG_ALPHA_ONE_MINUS_SRC);
+	}
+	if ((mi->flags & MAP_ITEM_SELECTED) &&
+	    MAP_ItemExtent(map, mi, &rExtent, mv->cam) == 0) {
+		r.x = rx + rExtent.x - 1;
+		r.y = ry + rExtent.y - 1;
+		r.w = rExtent.w + 1;
+		r.h = rExtent.h + 1;
+		AG_ColorRGB_8(&c, 60,250,60);
+		AG_DrawRectOutline(mv, &r, &c);
+	}
+}
+
+/*
+ * Render the static items of a layer in the visible area using the draw
+ * lists of the visible chunks. Tiles lying within their node are drawn
+ * first, in runs of tiles sharing a texture (the variant is looked up once
+ * per run of identical tiles). Other items are drawn next, in node order.
+ */
+static void
+DrawLayerItems(MAP_View *_Nonnull mv, MAP *_Nonnull map, Uint layer,
+    int tileSz)
+{
+	const int mx0 = mv->mx, mx1 = MIN(mv->mx + (int)mv->mw, (int)map->w - 1);
+	const int my0 = mv->my, my1 = MIN(mv->my + (int)mv->mh, (int)map->h - 1);
+	int cx, cy, y;
+
+	if (mx0 > mx1 || my0 > my1)
+		return;
+
+	for (cy = my0 >> MAP_CHUNK_SHIFT; cy <= my1 >> MAP_CHUNK_SHIFT; cy++) {
+		for (cx = mx0 >> MAP_CHUNK_SHIFT; cx <= mx1 >> MAP_CHUNK_SHIFT;
+		     cx++) {
+			const int x0 = cx << MAP_CHUNK_SHIFT;
+			const int y0 = cy << MAP_CHUNK_SHIFT;
+			const MAP_Tile *mtPrev = NULL;
+			const RG_TileVariant *var = NULL;
+			const MAP_DrawEnt *e, *eEnd;
+			int texture = -1;
+			MAP_DrawList *dl;
+			MAP_Chunk *ch;
+
+			if ((ch = GetVisibleChunk(map,
+			    (Uint)cy*map->wChunks + (Uint)cx)) == NULL) {
+				continue;
+			}
+			dl = MAP_GetDrawList(map, ch);
+			e = &dl->ents[dl->offs[layer]];
+			eEnd = e + dl->nBatched[layer];
+			for (; e < eEnd; e++) {
+				const MAP_Tile *mt = MAPTILE(e->mi);
+				const int x = x0 + (e->node & MAP_CHUNK_MASK);
+				const int y = y0 + (e->node >> MAP_CHUNK_SHIFT);
+				int rx, ry;
+
+				if (x < mx0 || x > mx1 || y < my0 || y > my1) {
+					continue;
+				}
+				if (mtPrev == NULL || !TileVariantEqual(mt, mtPrev)) {
+					var = MAP_TileGetVariant(mv, mt, &texture);
+					mtPrev = mt;
+				}
+				if (var == NULL) {
+					continue;
+				}
+				rx = mv->xOffs + (x - mx0)*tileSz;
+				ry = mv->yOffs + (y - my0)*tileSz;
+				MAP_TileBlit(mv, mt, var, texture, rx,ry);
+				DrawItemOverlays(mv, map, e->mi, rx,ry, tileSz);
+			}
+		}
+	}
+
+	for (y = my0; y <= my1; y++) {
+		const int ry = mv->yOffs + (y - my0)*tileSz;
+		const int yNode = (y & MAP_CHUNK_MASK) << MAP_CHUNK_SHIFT;
+
+		cy = y >> MAP_CHUNK_SHIFT;
+		for (cx = mx0 >> MAP_CHUNK_SHIFT; cx <= mx1 >> MAP_CHUNK_SHIFT;
+		     cx++) {
+			const MAP_DrawEnt *e, *eEnd;
+			MAP_DrawList *dl;
+			MAP_Chunk *ch;
+
+			if ((ch = GetVisibleChunk(map,
+			    (Uint)cy*map->wChunks + (Uint)cx)) == NULL) {
+				continue;
+			}
+			dl = MAP_GetDrawList(map, ch);
+			e = &dl->ents[dl->offs[layer] + dl->nBatched[layer]];
+			eEnd = &dl->ents[dl->offs[layer + 1]];
+			for (; e < eEnd; e++) {
+				const int x = (cx << MAP_CHUNK_SHIFT) +
+				              (e->node & MAP_CHUNK_MASK);
+				const MAP_ItemClass *miClass;
+				int rx;
+
+				if ((e->node & ~MAP_CHUNK_MASK) < yNode) {
+					continue;
+				}
+				if ((e->node & ~MAP_CHUNK_MASK) > yNode) {
+					break;
+				}
+				if (x < mx0 || x > mx1) {
+					continue;
+				}
+				rx = mv->xOffs + (x - mx0)*tileSz;
+				miClass = mapItemClasses[e->mi->type];
+				if (miClass->draw != NULL) {
+					miClass->draw(mv, e->mi, rx,ry, mv->cam);
+				}
+				DrawItemOverlays(mv, map, e->mi, rx,ry, tileSz);
+			}
+		}
+	}
+}
+
 static void
 Draw(void *_Nonnull obj)
 {
 	MAP_View *mv = obj;
 	MAP_ViewDrawCb *dcb;
 	MAP *map = mv->map;
-	MAP_Node *node;
+	const MAP_Node *node;
 	int mx, my, rx = 0, ry = 0, tileSz;
 	Uint layer = 0;
-	AG_Rect r, rSel, mSel, rExtent;
+	AG_Rect r, rSel, mSel;
 	AG_Color c, c2;
 
 	rSel.x = -1; mSel.x = -1;
@@ -454,14 +754,25 @@ Draw(void *_Nonnull obj)
 
 	AG_ObjectLock(map);
 
-	if (map->map == NULL) {
+	if (map->chunks == NULL) {
 		goto out;
 	}
 	tileSz = MAP_TILESZ(mv);
+
+	/*
+	 * Chunks last accessed before this frame may be paged out. Read ahead
+	 * the chunks within one view's width and height of the visible area.
+	 */
+	map->tick++;
+	MAP_Prefetch(map, mv->mx - (int)mv->mw, mv->my - (int)mv->mh,
+	                  mv->mx + ((int)mv->mw << 1),
+	                  mv->my + ((int)mv->mh << 1));
 draw_layer:
 	if (!map->layers[layer].visible) {
 		goto next_layer;
 	}
+	DrawLayerItems(mv, map, layer, tileSz);
+
 	for (my = mv->my, ry = mv->yOffs;
 	     ((my - mv->my) <= (int)mv->mh) && (my < (int)map->h);
 	     my++, ry += tileSz) {
@@ -469,47 +780,12 @@ draw_layer:
 		for (mx = mv->mx, rx = mv->xOffs;
 	     	     ((mx - mv->mx) <= (int)mv->mw) && (mx < (int)map->w);
 		     mx++, rx += tileSz) {
-			MAP_Item *mi;
 			Uint i;
 
-			node = &map->map[my][mx];
-
-			/*
-			 * Render static MAP_Items.
-			 */
-			TAILQ_FOREACH(mi, &node->items, items) {
-				MAP_ItemClass *miClass;
-
-				if (mi->layer != layer)
-					continue;
-
-				miClass = mapItemClasses[mi->type];
-				if (miClass->draw != NULL) {
-					miClass->draw(mv, mi, rx,ry, mv->cam);
-				}
-				if ((mi->layer == map->layerCur) &&
-				    (mv->mode == MAP_VIEW_EDIT_ATTRS)) {
-					MAP_ItemAttrColor(mv->edit_attr,
-					    (mi->flags & mv->edit_attr), &c);
-					r.x = rx;
-					r.y = ry;
-					r.w = tileSz;
-					r.h = tileSz;
-					AG_DrawRectBlended(mv, &r, &c,
-					    AG_ALPHA_SRC,
-					    AG_ALPHA_ONE_MINUS_SRC);
-				}
-
-				if ((mi->flags & MAP_ITEM_SELECTED) &&
-				    MAP_ItemExtent(map, mi, &rExtent, mv->cam) == 0) {
-					r.x = rx + rExtent.x - 1;
-					r.y = ry + rExtent.y - 1;
-					r.w = rExtent.w + 1;
-					r.h = rExtent.h + 1;
-					AG_ColorRGB_8(&c, 60,250,60);
-					AG_DrawRectOutline(mv, &r, &c);
-				}
+			if (MAP_ChunkIsVacant(map, MAP_CHUNK_INDEX(map, mx,my))) {
+				goto decorations;
 			}
+			node = MAP_GetConstNode(map, mx,my);
 
 			/*
 			 * Render dynamic MAP_Objects.
@@ -530,6 +806,7 @@ draw_layer:
 				    MAP_OBJECT_TOP);
 			}
 
+decorations:
 			if ((mv->flags & MAP_VIEW_EDIT) == 0)
 				continue;
 
@@ -762,6 +1039,28 @@ InsideNodeSelection(MAP_View *_Nonnull mv, int x, int y)
 	     y <  mv->esel.y + mv->esel.h));
 }
 
+/* Clear the selection flag of all items in resident chunks. */
+static void
+DeselectItems(MAP *_Nonnull map)
+{
+	MAP_Chunk *ch;
+
+	TAILQ_FOREACH(ch, &map->resident, resident) {
+		Uint i;
+
+		for (i = 0; i < MAP_CHUNK_NODES; i++) {
+			MAP_Item *mi;
+
+			TAILQ_FOREACH(mi, &ch->nodes[i].items, items) {
+				if (mi->flags & MAP_ITEM_SELECTED) {
+					mi->flags &= ~(MAP_ITEM_SELECTED);
+					ch->flags |= MAP_CHUNK_DIRTY;
+				}
+			}
+		}
+	}
+}
+
 static void
 ToggleAttribute(MAP_View *_Nonnull mv)
 {
@@ -776,7 +1075,7 @@ ToggleAttribute(MAP_View *_Nonnull mv)
 	MAP_BeginRevision(map);
 	MAP_NodeRevision(map, mv->cx, mv->cy, map->undo, map->nUndo);
 
-	node = &map->map[mv->cy][mv->cx];
+	node = MAP_GetNode(map, mv->cx, mv->cy);
 	TAILQ_FOREACH(mi, &node->items, items) {
 		if (mi->layer != map->layerCur) {
 			continue;
@@ -848,7 +1147,7 @@ MouseMotion(void *obj, int x, int y, int dx, int dy)
 			if (mv->curtool != NULL &&
 			    mv->curtool->ops->effect != NULL &&
 			    (rv = mv->curtool->ops->effect(mv->curtool,
-			     &map->map[mv->cy][mv->cx])) != -1) {
+			     MAP_GetNode(map, mv->cx, mv->cy))) != -1) {
 				map->nChanges += rv;
 				goto out;
 			}
@@ -953,7 +1252,7 @@ MouseButtonDown(void *obj, AG_MouseButton button, int x, int y)
 			    mv->curtool->ops->effect != NULL &&
 			    InsideNodeSelection(mv, mv->cx, mv->cy)) {
 				if ((rv = mv->curtool->ops->effect(mv->curtool,
-				     &map->map[mv->cy][mv->cx])) != -1) {
+				     MAP_GetNode(map, mv->cx, mv->cy))) != -1) {
 					mv->map->nChanges = rv;
 					goto out;
 				}
@@ -1008,8 +1307,6 @@ MouseButtonDown(void *obj, AG_MouseButton button, int x, int y)
 			goto out;
 		} else {
 			const AG_KeyMod mod = AG_GetModState(mv);
-			MAP_Item *mi;
-			int nx, ny;
 			
 			if (mv->curtool != NULL &&
 			    mv->curtool->ops == &mapNodeselOps &&
@@ -1017,18 +1314,8 @@ MouseButtonDown(void *obj, AG_MouseButton button, int x, int y)
 				MAP_NodeselBegin(mv);
 				goto out;
 			}
-			if ((mod & AG_KEYMOD_CTRL) == 0) {
-				for (ny = 0; ny < (int)map->h; ny++) {
-					for (nx = 0; nx < (int)map->w; nx++) {
-						MAP_Node *node = &map->map[ny][nx];
-						
-						TAILQ_FOREACH(mi, &node->items, items) {
-							mi->flags &=
-							   ~(MAP_ITEM_SELECTED);
-						}
-					}
-				}
-			}
+			if ((mod & AG_KEYMOD_CTRL) == 0)
+				DeselectItems(map);
 		}
 		if (mv->dblclicked) {
 			AG_PostEvent(mv, "mapview-dblclick", "%i,%i%i,%i%i",
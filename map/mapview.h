@@ -28,6 +28,28 @@ typedef struct map_view_draw_cb {
 	AG_SLIST_ENTRY(map_view_draw_cb) draw_cbs;
 } MAP_ViewDrawCb;
 
+/* Draw list entry (item to render). */
+typedef struct map_draw_ent {
+	MAP_Item *_Nonnull mi;		/* Item */
+	Uint16 node;			/* Node index in chunk */
+	Uint16 depth;			/* Stacking order in node and layer */
+	Uint32 key;			/* Batching key (hash of tile texture) */
+} MAP_DrawEnt;
+
+/*
+ * Cached list of the items of a map chunk, by layer. The entries of each
+ * layer start with the tiles which lie within their node, sorted by depth
+ * and texture such that tiles sharing a texture are drawn consecutively.
+ * Other items follow in node order.
+ */
+typedef struct map_draw_list {
+	Uint32 rev;			/* Chunk revision at build time */
+	Uint nLayers;			/* Map layer count at build time */
+	Uint *_Nonnull offs;		/* Offset of layer entries (nLayers+1) */
+	Uint *_Nonnull nBatched;	/* Number of batched entries by layer */
+	MAP_DrawEnt *_Nullable ents;	/* Entries */
+} MAP_DrawList;
+
 typedef struct map_view {
 	AG_Widget wid;			/* AG_Widget -> MAP_View */
 
@@ -142,6 +164,9 @@ void MAP_ViewRegDrawCb(MAP_View *_Nonnull,
 
 void MAP_ViewUpdateCamera(MAP_View *_Nonnull);
 
+MAP_DrawList *_Nonnull MAP_GetDrawList(MAP *_Nonnull, MAP_Chunk *_Nonnull);
+void MAP_FreeDrawList(MAP_DrawList *_Nonnull);
+
 void MAP_ViewStatus(MAP_View *_Nonnull, const char *_Nonnull, ...);
 void MAP_ViewSetMode(MAP_View *_Nonnull, enum map_view_mode);
 
@@ -188,8 +188,9 @@ RemoveBrush(AG_Event *_Nonnull event)
 }
 
 static void
-Interpolate(MAP *_Nonnull mapSrc, MAP_Node *_Nonnull nodeSrc, MAP_Item *_Nonnull miSrc,
-    MAP *_Nonnull mapDst, MAP_Node *_Nonnull nodeDest, MAP_Item *_Nonnull miDst)
+Interpolate(MAP *_Nonnull mapSrc, const MAP_Node *_Nonnull nodeSrc,
+    MAP_Item *_Nonnull miSrc, MAP *_Nonnull mapDst,
+    MAP_Node *_Nonnull nodeDest, MAP_Item *_Nonnull miDst)
 {
 	/* TODO */
 }
@@ -220,8 +221,9 @@ Effect(MAP_Tool *_Nonnull t, MAP_Node *_Nonnull n)
 			for (sx = 0, dx = mv->cx;
 			     sx < mapSrc->w && dx < map->w;
 			     sx++, dx++) {
-				MAP_Node *nodeSrc = &mapSrc->map[sy][sx];
-				MAP_Node *nodeDst = &map->map[dy][dx];
+				const MAP_Node *nodeSrc = MAP_GetConstNode(mapSrc,
+				    sx,sy);
+				MAP_Node *nodeDst = MAP_GetNode(map, dx,dy);
 				MAP_Item *miSrc, *miDst;
 
 				TAILQ_FOREACH(miSrc, &nodeSrc->items, items) {
@@ -316,7 +318,8 @@ Cursor(MAP_Tool *_Nonnull t, AG_Rect *_Nonnull rd)
 			for (sx = 0, dx = rd->x;
 			     sx < mapSrc->w;
 			     sx++, dx += tileSz) {
-				MAP_Node *nodeSrc = &mapSrc->map[sy][sx];
+				const MAP_Node *nodeSrc = MAP_GetConstNode(mapSrc,
+				    sx,sy);
 				MAP_Item *mi;
 
 				TAILQ_FOREACH(mi, &nodeSrc->items, items) {
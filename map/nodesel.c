@@ -127,11 +127,11 @@ MAP_NodeselMoveBegin(MAP_View *mv)
 		for (xTmp = 0, x = xSel;
 		     xTmp < wSel;
 		     xTmp++, x++) {
-			MAP_Node *nodeSrc = &map->map[y][x];
+			MAP_Node *nodeSrc = MAP_GetNode(map, x,y);
 
 			MAP_NodeRevision(map, x,y, map->undo, map->nUndo);
-			MAP_NodeCopy(mapTmp, &mapTmp->map[yTmp][xTmp], layerCur,
-			             nodeSrc, layerCur);
+			MAP_NodeCopy(mapTmp, MAP_GetNode(mapTmp, xTmp,yTmp),
+			             layerCur, nodeSrc, layerCur);
 			MAP_NodeClear(map, nodeSrc, layerCur);
 		}
 	}
@@ -183,12 +183,12 @@ MAP_NodeselMoveEnd(MAP_View *mv)
 		for (x=0, xDst=xSel;
 		     x < wSel;
 		     x++, xDst++) {
-			MAP_Node *nodeDst = &map->map[yDst][xDst];
+			MAP_Node *nodeDst = MAP_GetNode(map, xDst,yDst);
 
 			MAP_NodeRevision(map, xDst,yDst, map->undo, map->nUndo);
 			MAP_NodeClear(map, nodeDst, layerCur);
 			MAP_NodeCopy(map, nodeDst, layerCur,
-			    &mapTmp->map[y][x], layerCur);
+			    MAP_GetConstNode(mapTmp, x,y), layerCur);
 		}
 	}
 
@@ -221,7 +221,7 @@ MAP_NodeselCopy(MAP_Tool *tool, AG_KeySym key, int state, void *arg)
 		AG_TextMsg(AG_MSG_ERROR, _("There is no selection to copy."));
 		return (0);
 	}
-	if (mapCopy->map != NULL) {
+	if (mapCopy->chunks != NULL) {
 		MAP_FreeNodes(mapCopy);
 	}
 	if (MAP_AllocNodes(mapCopy, wSel,hSel) == -1) {
@@ -235,8 +235,8 @@ MAP_NodeselCopy(MAP_Tool *tool, AG_KeySym key, int state, void *arg)
 		for (xSrc=xSel, x=0;
 		     xSrc < xSel+wSel;
 		     xSrc++, x++)
-			MAP_NodeCopy(map, &map->map[ySrc][xSrc], map->layerCur,
-			    &mapCopy->map[y][x], 0);
+			MAP_NodeCopy(map, MAP_GetNode(map, xSrc,ySrc),
+			    map->layerCur, MAP_GetConstNode(mapCopy, x,y), 0);
 	}
 
 	MAP_ViewStatus(mv, _("Copied (%dx%d) nodes to clipboard."), wSel,hSel);
@@ -257,7 +257,7 @@ MAP_NodeselPaste(MAP_Tool *tool, AG_KeySym key, int state, void *arg)
 	const int ySel = mv->esel.y;
 	int xSrc,ySrc, x,y;
 	
-	if (mapCopy->map == NULL) {
+	if (mapCopy->chunks == NULL) {
 		AG_TextMsg(AG_MSG_ERROR, _("The copy buffer is empty!"));
 		return (0);
 	}
@@ -286,8 +286,8 @@ MAP_NodeselPaste(MAP_Tool *tool, AG_KeySym key, int state, void *arg)
 		     xSrc < wCopy && x < wDst;
 		     xSrc++, x++) {
 			MAP_NodeRevision(map, x,y, map->undo, map->nUndo);
-			MAP_NodeCopy(map, &map->map[y][x], map->layerCur,
-			    &mapCopy->map[ySrc][xSrc], 0);
+			MAP_NodeCopy(map, MAP_GetNode(map, x,y), map->layerCur,
+			    MAP_GetConstNode(mapCopy, xSrc,ySrc), 0);
 		}
 	}
 
@@ -316,7 +316,8 @@ MAP_NodeselClear(MAP_Tool *tool, AG_KeySym key, int state, void *arg)
 	for (y = ySel; y < ySel + hSel; y++) {
 		for (x = xSel; x < xSel + wSel; x++) {
 			MAP_NodeRevision(map, x,y, map->undo, map->nUndo);
-			MAP_NodeClear(map, &map->map[y][x], map->layerCur);
+			MAP_NodeClear(map, MAP_GetNode(map, x,y),
+			    map->layerCur);
 		}
 	}
 	MAP_ViewStatus(mv, _("Cleared (%dx%d) nodes at "
@@ -197,6 +197,8 @@ RG_TileGenerate(RG_Tile *t)
 	RG_Tileset *ts = t->ts;
 	AG_Color c;
 
+	RG_TileFlushVariants(t);
+
 	t->su->alpha = ts->icon->alpha;
 
 	/* TODO check for opaque fill features/pixmaps first */
@@ -638,7 +640,6 @@ void
 RG_TileDestroy(RG_Tile *t)
 {
 	RG_TileElement *tel, *tel_next;
-	RG_TileVariant *var, *var_next;
 
 	Free(t->attrs);
 	Free(t->layers);
@@ -650,12 +651,7 @@ RG_TileDestroy(RG_Tile *t)
 		tel_next = TAILQ_NEXT(tel, elements);
 		Free(tel);
 	}
-	for (var = SLIST_FIRST(&t->vars);
-	     var != SLIST_END(&t->vars);
-	     var = var_next) {
-		var_next = SLIST_NEXT(var, vars);
-		Free(var);
-	}
+	RG_TileFlushVariants(t);
 }
 
 static void
@@ -105,16 +105,59 @@ typedef struct rg_tile {
 	AG_TAILQ_ENTRY(rg_tile) tiles;
 } RG_Tile;
 
-/* Cached, transformed tile variant */
+/* Mapping of a cached surface into a widget (see RG_TileVariantMap()) */
+typedef struct rg_surface_map {
+	void *_Nonnull wid;		/* Widget (e.g., MAP_View(3)) */
+	int id;				/* Surface ID in widget */
+	Uint32 _pad;
+} RG_SurfaceMap;
+
+/* Tiles of a tileset packed into a single surface, at a given scale */
+typedef struct rg_tile_atlas {
+	struct rg_tileset *_Nonnull ts;	/* Source tileset */
+	AG_Surface *_Nonnull surface;	/* Packed tiles */
+	int scale;			/* Scaling factor of packed tiles */
+	Uint nTiles;			/* Number of packed tiles */
+	RG_Tile *_Nonnull *_Nonnull tiles;	/* Packed tiles */
+	AG_Rect *_Nonnull rects;	/* Location of packed tiles */
+	Uint nRefs;			/* Variants referencing the atlas */
+	Uint nMaps;			/* Widget mappings */
+	RG_SurfaceMap *_Nullable maps;
+	AG_TAILQ_ENTRY(rg_tile_atlas) atlases;
+} RG_TileAtlas;
+
+/* Cached, transformed and scaled tile variant */
 typedef struct rg_tile_variant {
 	RG_TransformChain transforms;	/* Applied transforms */
-	AG_Surface *_Nonnull surface;	/* Cached resulting surface */
-	struct map_view *_Nonnull view;	/* Associated MAP_View(3) widget */
-	int texture;			/* Cached texture (surface id) */
+	RG_Tile *_Nonnull tile;		/* Source tile */
+	AG_Surface *_Nonnull surface;	/* Resulting surface (or atlas) */
+	RG_TileAtlas *_Nullable atlas;	/* Atlas containing the variant */
+	AG_Rect rd;			/* Location of variant in surface */
+	Uint32 hash;			/* Fingerprint of tile, transforms, scale */
+	int scale;			/* Scaling factor (see RG_SCALE_ONE) */
+	AG_Size size;			/* Memory cost (bytes) */
 	Uint32 last_drawn;		/* Time of most recent rendering */
-	AG_SLIST_ENTRY(rg_tile_variant) vars;
+	Uint nMaps;			/* Widget mappings (if not in atlas) */
+	RG_SurfaceMap *_Nullable maps;
+	AG_SLIST_ENTRY(rg_tile_variant) vars;	/* In tile */
+	AG_SLIST_ENTRY(rg_tile_variant) bucket;	/* In hash bucket */
+	AG_TAILQ_ENTRY(rg_tile_variant) lru;	/* In cache (LRU order) */
 } RG_TileVariant;
 
+/* Statistics of the variant cache */
+typedef struct rg_variant_cache_stats {
+	Uint nVariants;			/* Cached variants */
+	Uint nAtlases;			/* Tileset atlases in memory */
+	AG_Size size;			/* Total memory cost (bytes) */
+	AG_Size sizeMax;		/* Memory budget (bytes) */
+	Uint nHits, nMisses;		/* Lookups since initialization */
+	Uint nEvictions;		/* Variants evicted */
+} RG_VariantCacheStats;
+
+#define RG_SCALE_ONE		1024		/* Unscaled variant (1:1) */
+#define RG_VARIANT_CACHE_DEF	(32*1024*1024)	/* Default memory budget */
+#define RG_ATLAS_SIZE_MAX	4096		/* Max atlas width/height */
+
 #define RG_TILE_ATTR2(t,x,y) (t)->attrs[(y)*(t)->nw + (x)]
 #define RG_TILE_LAYER2(t,x,y) (t)->layers[(y)*(t)->nw + (x)]
 #define RG_TILE_ATTRS(t) (AG_SPRITE((t)->ts,(t)->s).attrs)
@@ -159,6 +202,18 @@ RG_TileElement *_Nonnull RG_TileAddFeature(RG_Tile *_Nonnull, const char *_Nulla
                                            void *_Nonnull, int,int);
 void                     RG_TileDelFeature(RG_Tile *_Nonnull, void *_Nonnull, int);
 
+RG_TileVariant *_Nullable RG_TileGetVariant(RG_Tile *_Nonnull,
+                                            const RG_TransformChain *_Nonnull,
+                                            int);
+int  RG_TileVariantMap(RG_TileVariant *_Nonnull, void *_Nonnull);
+void RG_TileFlushVariants(RG_Tile *_Nonnull);
+void RG_VariantCacheDetach(void *_Nonnull);
+void RG_SetVariantCacheSize(AG_Size);
+void RG_GetVariantCacheStats(RG_VariantCacheStats *_Nonnull);
+void RG_FlushVariantCache(void);
+void RG_InitVariantCache(void);
+void RG_DestroyVariantCache(void);
+
 #if 0
 RG_TileElement *_Nonnull RG_TileAddSketch(RG_Tile *_Nonnull, const char *_Nullable,
                                           struct rg_sketch *_Nonnull, int,int);
@@ -76,6 +76,7 @@ RG_InitSubsystem(void)
 	AG_RegisterClass(&rgTextureSelectorClass);
 	AG_RegisterClass(&rgTilesetClass);
 
+	RG_InitVariantCache();
 	rgIcon_Init();
 }
 
@@ -85,6 +86,7 @@ RG_DestroySubsystem(void)
 	if (--rgInitedSubsystem > 0) {
 		return;
 	}
+	RG_DestroyVariantCache();
 	AG_UnregisterClass(&rgTileviewClass);
 	AG_UnregisterClass(&rgTextureSelectorClass);
 	AG_UnregisterClass(&rgTilesetClass);
@@ -240,6 +240,26 @@ RG_TransformChainDup(const RG_TransformChain *xc, RG_TransformChain *xc_dup)
 	}
 }
 
+/*
+ * Return a fingerprint of a transform chain, such that equivalent chains
+ * (per RG_TransformCompare()) yield equal fingerprints.
+ */
+Uint32
+RG_TransformChainHash(const RG_TransformChain *xchain)
+{
+	const RG_Transform *xf;
+	Uint32 h = 2166136261u;				/* FNV-1a */
+	Uint i;
+
+	TAILQ_FOREACH(xf, xchain, transforms) {
+		h = (h ^ (Uint32)xf->type) * 16777619u;
+		h = (h ^ (Uint32)xf->nArgs) * 16777619u;
+		for (i = 0; i < xf->nArgs; i++)
+			h = (h ^ xf->args[i]) * 16777619u;
+	}
+	return (h);
+}
+
 int
 RG_TransformCompare(const RG_Transform *xf1, const RG_Transform *xf2)
 {
@@ -249,6 +269,23 @@ RG_TransformCompare(const RG_Transform *xf1, const RG_Transform *xf2)
 		 memcmp(xf1->args, xf2->args, xf1->nArgs*sizeof(Uint32)) == 0));
 }
 
+/* Return 1 if two transform chains are equivalent. */
+int
+RG_TransformChainCompare(const RG_TransformChain *xc1,
+    const RG_TransformChain *xc2)
+{
+	const RG_Transform *xf1, *xf2;
+
+	for (xf1 = TAILQ_FIRST(xc1), xf2 = TAILQ_FIRST(xc2);
+	     xf1 != TAILQ_END(xc1) && xf2 != TAILQ_END(xc2);
+	     xf1 = TAILQ_NEXT(xf1, transforms),
+	     xf2 = TAILQ_NEXT(xf2, transforms)) {
+		if (!RG_TransformCompare(xf1, xf2))
+			return (0);
+	}
+	return (xf1 == TAILQ_END(xc1) && xf2 == TAILQ_END(xc2));
+}
+
 void
 RG_TransformDestroy(RG_Transform *xf)
 {
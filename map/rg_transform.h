@@ -49,6 +49,9 @@ void RG_TransformChainDestroy(RG_TransformChain *_Nonnull);
 void RG_TransformChainPrint(const RG_TransformChain *_Nonnull, char *_Nonnull, AG_Size);
 void RG_TransformChainDup(const RG_TransformChain *_Nonnull,
                           RG_TransformChain *_Nonnull);
+int  RG_TransformChainCompare(const RG_TransformChain *_Nonnull,
+                              const RG_TransformChain *_Nonnull);
+Uint32 RG_TransformChainHash(const RG_TransformChain *_Nonnull) _Pure_Attribute;
 int  RG_TransformCompare(const RG_Transform *_Nonnull,
                          const RG_Transform *_Nonnull);
 __END_DECLS
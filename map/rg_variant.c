@@ -0,0 +1,628 @@
+/*
+ * Copyright (c) 2023 Julien Nadeau Carriere <vedge@csoft.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Cache of transformed and scaled tile variants, shared between widgets.
+ * Variants are hashed by tile, transform chain and scale, and evicted in
+ * LRU order whenever the cache exceeds its memory budget. Untransformed
+ * tiles are packed into a per-tileset atlas surface (one per scale), so a
+ * widget needs a single texture for all plain tiles of a tileset.
+ */
+
+#include <agar/core/core.h>
+
+#include <agar/gui/gui.h>
+#include <agar/gui/widget.h>
+
+#include <agar/map/rg_tileset.h>
+
+#include <string.h>
+
+AG_SLIST_HEAD(rg_variant_bucket, rg_tile_variant);
+AG_TAILQ_HEAD(rg_variantq, rg_tile_variant);
+AG_TAILQ_HEAD(rg_atlasq, rg_tile_atlas);
+
+static _Nonnull_Mutex AG_Mutex rgVariantLock;
+static struct rg_variant_bucket *_Nullable rgVariantBuckets = NULL;
+static Uint rgVariantBucketsMask = 0;
+static struct rg_variantq rgVariants = AG_TAILQ_HEAD_INITIALIZER(rgVariants);
+static struct rg_atlasq rgAtlases = AG_TAILQ_HEAD_INITIALIZER(rgAtlases);
+static RG_VariantCacheStats rgVariantStats = { 0,0, 0, RG_VARIANT_CACHE_DEF,
+                                               0,0, 0 };
+
+#define RG_VARIANT_BUCKETS_INIT 256
+
+static __inline__ Uint32
+VariantHash(const RG_Tile *_Nonnull t, Uint32 xfHash, int scale)
+{
+	Uint32 h = xfHash;
+
+	h = (h ^ (Uint32)((AG_Size)t >> 4)) * 16777619u;
+	h = (h ^ (Uint32)scale) * 16777619u;
+	return (h);
+}
+
+/* Rebuild the hash table with twice as many buckets. */
+static void
+GrowBuckets(void)
+{
+	const Uint nBuckets = (rgVariantBuckets != NULL) ?
+	                      (rgVariantBucketsMask + 1) << 1 :
+	                      RG_VARIANT_BUCKETS_INIT;
+	struct rg_variant_bucket *buckets;
+	RG_TileVariant *var;
+	Uint i;
+
+	if ((buckets = TryMalloc(nBuckets * sizeof(struct rg_variant_bucket)))
+	    == NULL) {
+		return;
+	}
+	for (i = 0; i < nBuckets; i++) {
+		AG_SLIST_INIT(&buckets[i]);
+	}
+	AG_TAILQ_FOREACH(var, &rgVariants, lru) {
+		AG_SLIST_INSERT_HEAD(&buckets[var->hash & (nBuckets - 1)],
+		    var, bucket);
+	}
+	Free(rgVariantBuckets);
+	rgVariantBuckets = buckets;
+	rgVariantBucketsMask = nBuckets - 1;
+}
+
+/*
+ * Generate the surface of a tile with a transform chain applied and
+ * scaled by scale/RG_SCALE_ONE.
+ */
+static AG_Surface *_Nonnull
+GenVariantSurface(const RG_Tile *_Nonnull t,
+    const RG_TransformChain *_Nonnull transforms, int scale)
+{
+	const AG_Surface *Stile = t->su;
+	AG_Surface *S, *Sx;
+	RG_Transform *xf;
+
+	S = AG_SurfaceRGBA(
+	    Stile->w, Stile->h, Stile->format.BitsPerPixel,
+	    Stile->flags & AG_SURFACE_COLORKEY,
+	    Stile->format.Rmask,
+	    Stile->format.Gmask,
+	    Stile->format.Bmask,
+	    Stile->format.Amask);
+	if (S == NULL) {
+		AG_FatalError(NULL);
+	}
+	AG_SurfaceCopy(S, Stile);
+	S->colorkey = Stile->colorkey;
+	S->alpha = Stile->alpha;
+
+	AG_TAILQ_FOREACH(xf, transforms, transforms) {
+		if (xf->func == NULL) {
+			continue;
+		}
+		Sx = xf->func(S, xf->nArgs, xf->args);
+		if (Sx != S) {
+			AG_SurfaceFree(S);
+			S = Sx;
+		}
+	}
+	if (scale != RG_SCALE_ONE) {
+		Uint w = S->w * scale / RG_SCALE_ONE;
+		Uint h = S->h * scale / RG_SCALE_ONE;
+
+		Sx = AG_SurfaceScale(S, (w > 0) ? w : 1, (h > 0) ? h : 1,
+		    AG_SCALE_BILINEAR);
+		AG_SurfaceFree(S);
+		S = Sx;
+	}
+	return (S);
+}
+
+/* Return 1 if tiles can share an atlas (same format and blending). */
+static int
+SameTileFormat(const AG_Surface *_Nonnull S1, const AG_Surface *_Nonnull S2)
+{
+	if (S1->format.BitsPerPixel != S2->format.BitsPerPixel ||
+	    S1->format.Rmask != S2->format.Rmask ||
+	    S1->format.Gmask != S2->format.Gmask ||
+	    S1->format.Bmask != S2->format.Bmask ||
+	    S1->format.Amask != S2->format.Amask ||
+	    S1->alpha != S2->alpha ||
+	    (S1->flags & AG_SURFACE_COLORKEY) !=
+	    (S2->flags & AG_SURFACE_COLORKEY)) {
+		return (0);
+	}
+	return !(S1->flags & AG_SURFACE_COLORKEY) ||
+	        S1->colorkey == S2->colorkey;
+}
+
+static void
+FreeAtlas(RG_TileAtlas *_Nonnull atlas)
+{
+	Uint i;
+
+	for (i = 0; i < atlas->nMaps; i++) {
+		AG_WidgetUnmapSurface(atlas->maps[i].wid, atlas->maps[i].id);
+	}
+	AG_TAILQ_REMOVE(&rgAtlases, atlas, atlases);
+	rgVariantStats.nAtlases--;
+	AG_SurfaceFree(atlas->surface);
+	Free(atlas->maps);
+	free(atlas->rects);
+	free(atlas->tiles);
+	free(atlas);
+}
+
+/*
+ * Pack the tiles of ts which share the format of tRef into a new atlas
+ * (shelf packing, with 1px of padding between tiles). Return NULL if fewer
+ * than two tiles could be packed.
+ */
+static RG_TileAtlas *_Nullable
+BuildAtlas(RG_Tileset *_Nonnull ts, const RG_Tile *_Nonnull tRef, int scale)
+{
+	const AG_Surface *Sref = tRef->su;
+	RG_TransformChain xfNone;
+	RG_TileAtlas *atlas;
+	AG_Surface **Stiles, *S;
+	RG_Tile *t;
+	AG_Size area = 0;
+	Uint nTiles = 0, nPacked = 0, i;
+	int wMax = 0, W, H, x, y, hRow;
+
+	AG_TAILQ_FOREACH(t, &ts->tiles, tiles) {
+		if (t->su != NULL && SameTileFormat(t->su, Sref))
+			nTiles++;
+	}
+	if (nTiles < 2) {
+		return (NULL);
+	}
+	atlas = Malloc(sizeof(RG_TileAtlas));
+	atlas->ts = ts;
+	atlas->scale = scale;
+	atlas->tiles = Malloc(nTiles * sizeof(RG_Tile *));
+	atlas->rects = Malloc(nTiles * sizeof(AG_Rect));
+	atlas->nRefs = 0;
+	atlas->nMaps = 0;
+	atlas->maps = NULL;
+	Stiles = Malloc(nTiles * sizeof(AG_Surface *));
+	AG_TAILQ_INIT(&xfNone);
+
+	AG_TAILQ_FOREACH(t, &ts->tiles, tiles) {
+		if (t->su == NULL || !SameTileFormat(t->su, Sref)) {
+			continue;
+		}
+		S = (scale != RG_SCALE_ONE) ?
+		    GenVariantSurface(t, &xfNone, scale) : t->su;
+		Stiles[nPacked] = S;
+		atlas->tiles[nPacked] = t;
+		atlas->rects[nPacked].w = S->w;
+		atlas->rects[nPacked].h = S->h;
+		area += (S->w + 1) * (S->h + 1);
+		if (S->w + 1 > wMax) { wMax = S->w + 1; }
+		nPacked++;
+	}
+
+	for (W = 64; W < wMax || (AG_Size)W*W < area; W <<= 1) {
+		if (W >= RG_ATLAS_SIZE_MAX)
+			break;
+	}
+	for (i = 0, nTiles = 0, x = 0, y = 0, hRow = 0; i < nPacked; i++) {
+		AG_Rect *r = &atlas->rects[i];
+
+		if (x + r->w > W) {
+			x = 0;
+			y += hRow;
+			hRow = 0;
+		}
+		if (r->w > W || y + r->h > RG_ATLAS_SIZE_MAX) {
+			r->w = 0;				/* Not packed */
+			continue;
+		}
+		r->x = x;
+		r->y = y;
+		x += r->w + 1;
+		if (r->h + 1 > hRow) { hRow = r->h + 1; }
+		nTiles++;
+	}
+	H = y + hRow;
+
+	if (nTiles < 2 ||
+	    (S = AG_SurfaceRGBA(W, H, Sref->format.BitsPerPixel,
+	                        Sref->flags & AG_SURFACE_COLORKEY,
+	                        Sref->format.Rmask,
+	                        Sref->format.Gmask,
+	                        Sref->format.Bmask,
+	                        Sref->format.Amask)) == NULL) {
+		atlas->surface = NULL;
+		goto out;
+	}
+	if (Sref->flags & AG_SURFACE_COLORKEY) {
+		AG_SurfaceSetColorKey(S, AG_SURFACE_COLORKEY, Sref->colorkey);
+		for (y = 0; y < H; y++) {
+			for (x = 0; x < W; x++)
+				AG_SurfacePut32(S, x,y, Sref->colorkey);
+		}
+	} else {
+		memset(S->pixels, 0, S->pitch * H);
+	}
+	S->alpha = Sref->alpha;
+
+	/* Copy the tiles and compact the packed tile array. */
+	for (i = 0, nTiles = 0; i < nPacked; i++) {
+		const AG_Surface *Stile = Stiles[i];
+		const AG_Rect r = atlas->rects[i];
+		const int Bpp = Stile->format.BytesPerPixel;
+
+		if (r.w == 0) {
+			continue;
+		}
+		for (y = 0; y < r.h; y++) {
+			memcpy(S->pixels + (r.y + y)*S->pitch + r.x*Bpp,
+			    Stile->pixels + y*Stile->pitch, r.w*Bpp);
+		}
+		atlas->tiles[nTiles] = atlas->tiles[i];
+		atlas->rects[nTiles] = r;
+		nTiles++;
+	}
+	atlas->surface = S;
+	atlas->nTiles = nTiles;
+out:
+	if (scale != RG_SCALE_ONE) {
+		for (i = 0; i < nPacked; i++)
+			AG_SurfaceFree(Stiles[i]);
+	}
+	free(Stiles);
+
+	if (atlas->surface == NULL) {
+		free(atlas->rects);
+		free(atlas->tiles);
+		free(atlas);
+		return (NULL);
+	}
+	AG_TAILQ_INSERT_TAIL(&rgAtlases, atlas, atlases);
+	rgVariantStats.nAtlases++;
+	return (atlas);
+}
+
+/* Look up (or create) the atlas of ts at scale containing tile t. */
+static RG_TileAtlas *_Nullable
+GetAtlas(RG_Tile *_Nonnull t, int scale, AG_Rect *_Nonnull rd)
+{
+	RG_TileAtlas *atlas;
+	Uint i;
+
+	AG_TAILQ_FOREACH(atlas, &rgAtlases, atlases) {
+		if (atlas->ts == t->ts && atlas->scale == scale &&
+		    SameTileFormat(atlas->tiles[0]->su, t->su))
+			break;
+	}
+	if (atlas == NULL &&
+	    (atlas = BuildAtlas(t->ts, t, scale)) == NULL) {
+		return (NULL);
+	}
+	for (i = 0; i < atlas->nTiles; i++) {
+		if (atlas->tiles[i] == t) {
+			*rd = atlas->rects[i];
+			return (atlas);
+		}
+	}
+	if (atlas->nRefs == 0) {			/* Did not fit */
+		FreeAtlas(atlas);
+	}
+	return (NULL);
+}
+
+static void
+FreeVariant(RG_TileVariant *_Nonnull var)
+{
+	struct rg_variant_bucket *bucket;
+	Uint i;
+
+	bucket = &rgVariantBuckets[var->hash & rgVariantBucketsMask];
+	AG_SLIST_REMOVE(bucket, var, rg_tile_variant, bucket);
+	AG_SLIST_REMOVE(&var->tile->vars, var, rg_tile_variant, vars);
+	AG_TAILQ_REMOVE(&rgVariants, var, lru);
+	rgVariantStats.nVariants--;
+	rgVariantStats.size -= var->size;
+
+	if (var->atlas != NULL) {
+		if (--var->atlas->nRefs == 0)
+			FreeAtlas(var->atlas);
+	} else {
+		for (i = 0; i < var->nMaps; i++) {
+			AG_WidgetUnmapSurface(var->maps[i].wid,
+			    var->maps[i].id);
+		}
+		AG_SurfaceFree(var->surface);
+		Free(var->maps);
+	}
+	RG_TransformChainDestroy(&var->transforms);
+	free(var);
+}
+
+/* Evict variants (in LRU order) until size more bytes fit in the budget. */
+static void
+Evict(AG_Size size)
+{
+	RG_TileVariant *var;
+
+	while (rgVariantStats.size + size > rgVariantStats.sizeMax &&
+	       (var = AG_TAILQ_FIRST(&rgVariants)) != NULL) {
+		FreeVariant(var);
+		rgVariantStats.nEvictions++;
+	}
+}
+
+/*
+ * Return the variant of tile t with the given transforms applied and scaled
+ * by scale/RG_SCALE_ONE, generating it if it is not in the cache. Return
+ * NULL if the tile has no surface. The pointer is valid until the next
+ * call to RG_TileGetVariant() or until the tile is modified.
+ */
+RG_TileVariant *
+RG_TileGetVariant(RG_Tile *t, const RG_TransformChain *transforms, int scale)
+{
+	const Uint32 hash = VariantHash(t, RG_TransformChainHash(transforms),
+	                                scale);
+	RG_TileVariant *var;
+	RG_TileAtlas *atlas = NULL;
+	AG_Rect rd;
+
+	AG_MutexLock(&rgVariantLock);
+	if (rgVariantBuckets == NULL) {
+		GrowBuckets();
+	}
+	AG_SLIST_FOREACH(var, &rgVariantBuckets[hash & rgVariantBucketsMask],
+	    bucket) {
+		if (var->hash == hash && var->tile == t &&
+		    var->scale == scale &&
+		    RG_TransformChainCompare(&var->transforms, transforms))
+			break;
+	}
+	if (var != NULL) {
+		rgVariantStats.nHits++;
+		if (var != AG_TAILQ_LAST(&rgVariants, rg_variantq)) {
+			AG_TAILQ_REMOVE(&rgVariants, var, lru);
+			AG_TAILQ_INSERT_TAIL(&rgVariants, var, lru);
+		}
+		goto out;
+	}
+	rgVariantStats.nMisses++;
+	if (t->su == NULL) {
+		goto out;
+	}
+	var = Malloc(sizeof(RG_TileVariant));
+	AG_TAILQ_INIT(&var->transforms);
+	RG_TransformChainDup(transforms, &var->transforms);
+	var->tile = t;
+	var->hash = hash;
+	var->scale = scale;
+	var->nMaps = 0;
+	var->maps = NULL;
+
+	if (AG_TAILQ_EMPTY(transforms) &&
+	    (atlas = GetAtlas(t, scale, &rd)) != NULL) {
+		atlas->nRefs++;
+		var->atlas = atlas;
+		var->surface = atlas->surface;
+		var->rd = rd;
+		var->size = rd.w * rd.h * atlas->surface->format.BytesPerPixel;
+	} else {
+		var->atlas = NULL;
+		var->surface = GenVariantSurface(t, transforms, scale);
+		var->rd.x = 0;
+		var->rd.y = 0;
+		var->rd.w = var->surface->w;
+		var->rd.h = var->surface->h;
+		var->size = var->surface->pitch * var->surface->h;
+	}
+	var->size += sizeof(RG_TileVariant);
+
+	Evict(var->size);
+
+	if (rgVariantStats.nVariants > (rgVariantBucketsMask + 1) << 1) {
+		GrowBuckets();
+	}
+	AG_SLIST_INSERT_HEAD(&rgVariantBuckets[hash & rgVariantBucketsMask],
+	    var, bucket);
+	AG_SLIST_INSERT_HEAD(&t->vars, var, vars);
+	AG_TAILQ_INSERT_TAIL(&rgVariants, var, lru);
+	rgVariantStats.nVariants++;
+	rgVariantStats.size += var->size;
+out:
+	if (var != NULL) {
+		var->last_drawn = AG_GetTicks();
+	}
+	AG_MutexUnlock(&rgVariantLock);
+	return (var);
+}
+
+/*
+ * Return the surface ID of a variant's surface (or atlas) in widget wid,
+ * mapping it (without duplication) if needed. The mapping is undone when
+ * the variant is evicted.
+ */
+int
+RG_TileVariantMap(RG_TileVariant *var, void *wid)
+{
+	RG_SurfaceMap **maps;
+	Uint *nMaps, i;
+	int id;
+
+	AG_MutexLock(&rgVariantLock);
+	if (var->atlas != NULL) {
+		maps = &var->atlas->maps;
+		nMaps = &var->atlas->nMaps;
+	} else {
+		maps = &var->maps;
+		nMaps = &var->nMaps;
+	}
+	for (i = 0; i < *nMaps; i++) {
+		if ((*maps)[i].wid == wid) {
+			id = (*maps)[i].id;
+			goto out;
+		}
+	}
+	id = AG_WidgetMapSurfaceNODUP(wid, var->surface);
+	*maps = Realloc(*maps, (*nMaps + 1) * sizeof(RG_SurfaceMap));
+	(*maps)[*nMaps].wid = wid;
+	(*maps)[*nMaps].id = id;
+	(*nMaps)++;
+out:
+	AG_MutexUnlock(&rgVariantLock);
+	return (id);
+}
+
+static void
+DetachMaps(RG_SurfaceMap *_Nullable maps, Uint *_Nonnull nMaps, void *wid)
+{
+	Uint i;
+
+	for (i = 0; i < *nMaps; ) {
+		if (maps[i].wid == wid) {
+			memmove(&maps[i], &maps[i + 1],
+			    (*nMaps - i - 1) * sizeof(RG_SurfaceMap));
+			(*nMaps)--;
+		} else {
+			i++;
+		}
+	}
+}
+
+/*
+ * Forget all surface mappings into widget wid. This must be called when
+ * a widget using RG_TileVariantMap() is destroyed.
+ */
+void
+RG_VariantCacheDetach(void *wid)
+{
+	RG_TileVariant *var;
+	RG_TileAtlas *atlas;
+
+	AG_MutexLock(&rgVariantLock);
+	AG_TAILQ_FOREACH(var, &rgVariants, lru) {
+		DetachMaps(var->maps, &var->nMaps, wid);
+	}
+	AG_TAILQ_FOREACH(atlas, &rgAtlases, atlases) {
+		DetachMaps(atlas->maps, &atlas->nMaps, wid);
+	}
+	AG_MutexUnlock(&rgVariantLock);
+}
+
+/* Free all variants packed into an atlas (and thus the atlas itself). */
+static void
+FlushAtlas(RG_TileAtlas *_Nonnull atlas)
+{
+	RG_TileVariant *var, *varNext;
+
+	for (var = AG_TAILQ_FIRST(&rgVariants);
+	     var != AG_TAILQ_END(&rgVariants);
+	     var = varNext) {
+		varNext = AG_TAILQ_NEXT(var, lru);
+		if (var->atlas == atlas)
+			FreeVariant(var);
+	}
+}
+
+/*
+ * Free the cached variants of a tile, and any atlas containing it.
+ * This must be called whenever the tile's surface is modified.
+ */
+void
+RG_TileFlushVariants(RG_Tile *t)
+{
+	RG_TileAtlas *atlas, *atlasNext;
+	RG_TileVariant *var;
+	Uint i;
+
+	AG_MutexLock(&rgVariantLock);
+	for (atlas = AG_TAILQ_FIRST(&rgAtlases);
+	     atlas != AG_TAILQ_END(&rgAtlases);
+	     atlas = atlasNext) {
+		atlasNext = AG_TAILQ_NEXT(atlas, atlases);
+		if (atlas->ts != t->ts) {
+			continue;
+		}
+		for (i = 0; i < atlas->nTiles; i++) {
+			if (atlas->tiles[i] == t)
+				break;
+		}
+		if (i < atlas->nTiles) {
+			FlushAtlas(atlas);		/* Frees the atlas */
+			atlasNext = AG_TAILQ_FIRST(&rgAtlases);
+		}
+	}
+	while ((var = AG_SLIST_FIRST(&t->vars)) != NULL) {
+		FreeVariant(var);
+	}
+	AG_MutexUnlock(&rgVariantLock);
+}
+
+/* Set the memory budget of the variant cache (in bytes). */
+void
+RG_SetVariantCacheSize(AG_Size size)
+{
+	AG_MutexLock(&rgVariantLock);
+	rgVariantStats.sizeMax = size;
+	Evict(0);
+	AG_MutexUnlock(&rgVariantLock);
+}
+
+void
+RG_GetVariantCacheStats(RG_VariantCacheStats *st)
+{
+	AG_MutexLock(&rgVariantLock);
+	memcpy(st, &rgVariantStats, sizeof(RG_VariantCacheStats));
+	AG_MutexUnlock(&rgVariantLock);
+}
+
+/* Free all cached variants and atlases. */
+void
+RG_FlushVariantCache(void)
+{
+	RG_TileVariant *var;
+
+	AG_MutexLock(&rgVariantLock);
+	while ((var = AG_TAILQ_FIRST(&rgVariants)) != NULL) {
+		FreeVariant(var);
+	}
+	AG_MutexUnlock(&rgVariantLock);
+}
+
+void
+RG_InitVariantCache(void)
+{
+	AG_MutexInitRecursive(&rgVariantLock);
+}
+
+void
+RG_DestroyVariantCache(void)
+{
+	RG_FlushVariantCache();
+	Free(rgVariantBuckets);
+	rgVariantBuckets = NULL;
+	rgVariantBucketsMask = 0;
+	AG_MutexDestroy(&rgVariantLock);
+}
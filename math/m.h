@@ -14,6 +14,8 @@
 #include <agar/math/m_coordinates.h>
 #include <agar/math/m_color.h>
 #include <agar/math/m_geometry.h>
+#include <agar/math/m_sort.h>
+#include <agar/math/m_spatial.h>
 
 #include <agar/math/close.h>
 
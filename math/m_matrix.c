@@ -39,6 +39,7 @@ M_MatrixInitEngine(void)
 {
 	mMatOps = &mMatOps_FPU;
 	mMatOps44 = &mMatOps44_FPU;
+	M_MatrixInitEngine_BLK();
 #ifdef HAVE_SSE
 	if (agCPU.ext & AG_EXT_SSE) {
 		mMatOps44 = &mMatOps44_SSE;
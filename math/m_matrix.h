@@ -128,9 +128,11 @@ extern const M_MatrixOps44 *_Nullable mMatOps44;
 __END_DECLS
 
 #include <agar/math/m_matrix_fpu.h>
+#include <agar/math/m_matrix_blk.h>
 #include <agar/math/m_matrix44_fpu.h>
 #include <agar/math/m_matrix44_sse.h>
 #include <agar/math/m_matrix_sparse.h>
+#include <agar/math/m_matrix_csr.h>
 
 /* Operations on m*n matrices. */
 #define M_New			mMatOps->NewMatrix
@@ -0,0 +1,1333 @@
+/*
+ * Copyright (c) 2026 Julien Nadeau Carriere <vedge@csoft.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Operations on m*n matrices (cache-blocked version).
+ *
+ * Entries are stored contiguously with an aligned row stride. Products are
+ * computed by a packed GEMM: blocks of A (MC*KC) and B (KC*NC) are copied
+ * into contiguous panels sized for the caches, and an MR*NR register-blocked
+ * micro-kernel accumulates each tile of C. Portable, SSE2 and AVX kernels
+ * are selected at runtime from AG_GetCPUInfo(3). Large products have the
+ * rows (or columns) of C split between worker threads.
+ *
+ * LU factorization is right-looking and blocked, so most of its work is
+ * done by the same GEMM.
+ */
+
+#include <agar/core/core.h>
+#include <agar/math/m.h>
+
+#include <string.h>
+
+#include <agar/config/have_sse2.h>
+#if defined(DOUBLE_PRECISION) && defined(HAVE_SSE2) && \
+    defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define USE_SSE2
+# if defined(__clang__) || (__GNUC__ > 4) || \
+    (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#  define USE_AVX
+# endif
+# include <immintrin.h>
+#endif
+
+#define BLK_MC           128            /* Rows of A per packed block */
+#define BLK_KC           256            /* Depth of packed panels */
+#define BLK_NC           2048           /* Columns of B per packed block */
+#define BLK_MR_MAX       4              /* Largest micro-tile (rows) */
+#define BLK_NR_MAX       8              /* Largest micro-tile (columns) */
+#define BLK_NB           64             /* LU panel width */
+#define BLK_TILE         32             /* Transpose tile size */
+#define BLK_SMALL        (8*8*8)        /* Below this m*n*k, skip packing */
+#define BLK_PARALLEL_MIN (128.0*128.0*128.0) /* m*n*k to go parallel */
+#define BLK_SPLIT_MIN    32             /* Rows or columns per thread */
+#define BLK_THREADS_MAX  16             /* Worker threads per product */
+
+#undef SWAP
+#define SWAP(a,b) { tmp=(a); (a)=(b); (b)=tmp; }
+
+/* Micro-kernel: C[mr x nr] += alpha * Ap[mr x kc] * Bp[kc x nr]. */
+typedef void (*BlkKernelFn)(Uint, const M_Real *_Nonnull,
+                            const M_Real *_Nonnull, M_Real *_Nonnull, Uint,
+                            M_Real);
+
+typedef struct blk_kernel {
+	const char *_Nonnull name;      /* Kernel name */
+	Uint32 ext;                     /* Required AG_EXT_* extensions */
+	Uint mr, nr;                    /* Micro-tile size */
+	Uint32 _pad;
+	BlkKernelFn _Nonnull fn;
+} BlkKernel;
+
+/* A product C += alpha*A*B computed by one thread. */
+typedef struct blk_gemm {
+	const BlkKernel *_Nonnull K;
+	const M_Real *_Nonnull A;
+	const M_Real *_Nonnull B;
+	M_Real *_Nonnull C;
+	Uint m, n, k;
+	Uint lda, ldb, ldc;
+	M_Real alpha;
+	int rv;                         /* 0 = Success, -1 = Out of memory */
+	Uint32 _pad;
+} BlkGemm;
+
+const M_MatrixOps mMatOps_BLK = {
+	"blocked",
+	M_GetElement_BLK,
+	M_Get_BLK,
+	M_MatrixResize_BLK,
+	M_MatrixFree_BLK,
+	M_MatrixNew_BLK,
+	M_MatrixSetIdentity_BLK,
+	M_MatrixSetZero_BLK,
+	M_MatrixTranspose_BLK,
+	M_MatrixCopy_BLK,
+	M_MatrixDup_BLK,
+	M_MatrixAdd_BLK,
+	M_MatrixAddv_BLK,
+	M_MatrixDirectSum_BLK,
+	M_MatrixMul_BLK,
+	M_MatrixMulv_BLK,
+	M_MatrixEntMul_BLK,
+	M_MatrixEntMulv_BLK,
+	M_MatrixCompare_BLK,
+	M_MatrixTrace_BLK,
+	M_MatrixRead_BLK,
+	M_MatrixWrite_BLK,
+	M_MatrixToFloats_BLK,
+	M_MatrixToDoubles_BLK,
+	M_MatrixFromFloats_BLK,
+	M_MatrixFromDoubles_BLK,
+	M_GaussJordan_BLK,
+	M_FactorizeLU_BLK,
+	M_BacksubstLU_BLK,
+	M_MNAPreorder_BLK,
+	M_AddToDiag_BLK
+};
+
+/*
+ * Portable 4x4 micro-kernel.
+ */
+static void
+Kernel4x4(Uint kc, const M_Real *_Nonnull A, const M_Real *_Nonnull B,
+    M_Real *_Nonnull C, Uint ldc, M_Real alpha)
+{
+	M_Real c[4][4];
+	Uint i, j, p;
+
+	for (i = 0; i < 4; i++) {
+		for (j = 0; j < 4; j++)
+			c[i][j] = 0.0;
+	}
+	for (p = 0; p < kc; p++) {
+		for (i = 0; i < 4; i++) {
+			const M_Real a = A[i];
+
+			c[i][0] += a*B[0];
+			c[i][1] += a*B[1];
+			c[i][2] += a*B[2];
+			c[i][3] += a*B[3];
+		}
+		A += 4;
+		B += 4;
+	}
+	for (i = 0; i < 4; i++) {
+		for (j = 0; j < 4; j++)
+			C[i*ldc + j] += alpha*c[i][j];
+	}
+}
+
+#ifdef USE_SSE2
+/*
+ * SSE2 4x4 micro-kernel (8 accumulators of 2 doubles).
+ */
+static void
+Kernel4x4_SSE2(Uint kc, const M_Real *_Nonnull A, const M_Real *_Nonnull B,
+    M_Real *_Nonnull C, Uint ldc, M_Real alpha)
+{
+	__m128d c00 = _mm_setzero_pd(), c01 = _mm_setzero_pd();
+	__m128d c10 = _mm_setzero_pd(), c11 = _mm_setzero_pd();
+	__m128d c20 = _mm_setzero_pd(), c21 = _mm_setzero_pd();
+	__m128d c30 = _mm_setzero_pd(), c31 = _mm_setzero_pd();
+	__m128d a, b0, b1, al;
+	Uint p;
+
+	for (p = 0; p < kc; p++) {
+		b0 = _mm_load_pd(&B[0]);
+		b1 = _mm_load_pd(&B[2]);
+		a = _mm_set1_pd(A[0]);
+		c00 = _mm_add_pd(c00, _mm_mul_pd(a, b0));
+		c01 = _mm_add_pd(c01, _mm_mul_pd(a, b1));
+		a = _mm_set1_pd(A[1]);
+		c10 = _mm_add_pd(c10, _mm_mul_pd(a, b0));
+		c11 = _mm_add_pd(c11, _mm_mul_pd(a, b1));
+		a = _mm_set1_pd(A[2]);
+		c20 = _mm_add_pd(c20, _mm_mul_pd(a, b0));
+		c21 = _mm_add_pd(c21, _mm_mul_pd(a, b1));
+		a = _mm_set1_pd(A[3]);
+		c30 = _mm_add_pd(c30, _mm_mul_pd(a, b0));
+		c31 = _mm_add_pd(c31, _mm_mul_pd(a, b1));
+		A += 4;
+		B += 4;
+	}
+	al = _mm_set1_pd(alpha);
+# define STORE_ROW_SSE2(i, r0, r1) \
+	_mm_storeu_pd(&C[(i)*ldc], \
+	    _mm_add_pd(_mm_loadu_pd(&C[(i)*ldc]), _mm_mul_pd(al, (r0)))); \
+	_mm_storeu_pd(&C[(i)*ldc + 2], \
+	    _mm_add_pd(_mm_loadu_pd(&C[(i)*ldc + 2]), _mm_mul_pd(al, (r1))))
+	STORE_ROW_SSE2(0, c00, c01);
+	STORE_ROW_SSE2(1, c10, c11);
+	STORE_ROW_SSE2(2, c20, c21);
+	STORE_ROW_SSE2(3, c30, c31);
+# undef STORE_ROW_SSE2
+}
+#endif /* USE_SSE2 */
+
+#ifdef USE_AVX
+/*
+ * AVX 4x8 micro-kernel (8 accumulators of 4 doubles).
+ */
+__attribute__((target("avx")))
+static void
+Kernel4x8_AVX(Uint kc, const M_Real *_Nonnull A, const M_Real *_Nonnull B,
+    M_Real *_Nonnull C, Uint ldc, M_Real alpha)
+{
+	__m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+	__m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+	__m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+	__m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+	__m256d a, b0, b1, al;
+	Uint p;
+
+	for (p = 0; p < kc; p++) {
+		b0 = _mm256_load_pd(&B[0]);
+		b1 = _mm256_load_pd(&B[4]);
+		a = _mm256_broadcast_sd(&A[0]);
+		c00 = _mm256_add_pd(c00, _mm256_mul_pd(a, b0));
+		c01 = _mm256_add_pd(c01, _mm256_mul_pd(a, b1));
+		a = _mm256_broadcast_sd(&A[1]);
+		c10 = _mm256_add_pd(c10, _mm256_mul_pd(a, b0));
+		c11 = _mm256_add_pd(c11, _mm256_mul_pd(a, b1));
+		a = _mm256_broadcast_sd(&A[2]);
+		c20 = _mm256_add_pd(c20, _mm256_mul_pd(a, b0));
+		c21 = _mm256_add_pd(c21, _mm256_mul_pd(a, b1));
+		a = _mm256_broadcast_sd(&A[3]);
+		c30 = _mm256_add_pd(c30, _mm256_mul_pd(a, b0));
+		c31 = _mm256_add_pd(c31, _mm256_mul_pd(a, b1));
+		A += 4;
+		B += 8;
+	}
+	al = _mm256_set1_pd(alpha);
+# define STORE_ROW_AVX(i, r0, r1) \
+	_mm256_storeu_pd(&C[(i)*ldc], \
+	    _mm256_add_pd(_mm256_loadu_pd(&C[(i)*ldc]), \
+	                  _mm256_mul_pd(al, (r0)))); \
+	_mm256_storeu_pd(&C[(i)*ldc + 4], \
+	    _mm256_add_pd(_mm256_loadu_pd(&C[(i)*ldc + 4]), \
+	                  _mm256_mul_pd(al, (r1))))
+	STORE_ROW_AVX(0, c00, c01);
+	STORE_ROW_AVX(1, c10, c11);
+	STORE_ROW_AVX(2, c20, c21);
+	STORE_ROW_AVX(3, c30, c31);
+# undef STORE_ROW_AVX
+}
+#endif /* USE_AVX */
+
+static const BlkKernel blkKernelScalar = { "scalar", 0, 4,4, 0, Kernel4x4 };
+#ifdef USE_SSE2
+static const BlkKernel blkKernelSSE2 = {
+	"sse2", AG_EXT_SSE2, 4,4, 0, Kernel4x4_SSE2
+};
+#endif
+#ifdef USE_AVX
+static const BlkKernel blkKernelAVX = {
+	"avx", AG_EXT_AVX, 4,8, 0, Kernel4x8_AVX
+};
+#endif
+
+/* Available kernels in order of preference. */
+static const BlkKernel *_Nonnull blkKernels[] = {
+#ifdef USE_AVX
+	&blkKernelAVX,
+#endif
+#ifdef USE_SSE2
+	&blkKernelSSE2,
+#endif
+	&blkKernelScalar
+};
+static const int blkKernelCount = sizeof(blkKernels) / sizeof(blkKernels[0]);
+
+static const BlkKernel *_Nonnull blkKernel = &blkKernelScalar;
+static Uint blkThreads = 0;                     /* 0 = One per processor */
+
+/* Select the fastest micro-kernel supported by the CPU. */
+void
+M_MatrixInitEngine_BLK(void)
+{
+	int i;
+
+	for (i = 0; i < blkKernelCount; i++) {
+		if ((blkKernels[i]->ext & agCPU.ext) == blkKernels[i]->ext) {
+			blkKernel = blkKernels[i];
+			break;
+		}
+	}
+}
+
+/* Return the name of the micro-kernel in use. */
+const char *
+M_MatrixGetKernel_BLK(void)
+{
+	return (blkKernel->name);
+}
+
+/*
+ * Select a micro-kernel by name ("scalar", "sse2" or "avx").
+ * Fail if it is not compiled in or not supported by the CPU.
+ */
+int
+M_MatrixSetKernel_BLK(const char *name)
+{
+	int i;
+
+	for (i = 0; i < blkKernelCount; i++) {
+		const BlkKernel *K = blkKernels[i];
+
+		if (strcmp(K->name, name) != 0) {
+			continue;
+		}
+		if ((K->ext & agCPU.ext) != K->ext) {
+			AG_SetError("%s: Not supported by CPU", name);
+			return (-1);
+		}
+		blkKernel = K;
+		return (0);
+	}
+	AG_SetError("%s: No such kernel", name);
+	return (-1);
+}
+
+/*
+ * Set the maximum number of threads used by a single operation
+ * (0 = one per processor, 1 = no threads).
+ */
+void
+M_MatrixSetThreads_BLK(Uint nThreads)
+{
+	blkThreads = nThreads;
+}
+
+/* Allocate size bytes aligned to M_MATRIX_BLK_ALIGN. */
+static void *_Nullable
+TryMallocAligned(AG_Size size, void *_Nullable *_Nonnull mem)
+{
+	AG_Size addr;
+
+	if ((*mem = AG_TryMalloc(size + M_MATRIX_BLK_ALIGN - 1)) == NULL) {
+		return (NULL);
+	}
+	addr = ((AG_Size)*mem + M_MATRIX_BLK_ALIGN - 1) &
+	       ~(AG_Size)(M_MATRIX_BLK_ALIGN - 1);
+	return (void *)addr;
+}
+
+/* Allocate matrix entries. */
+static int
+AllocEnts(M_MatrixBLK *_Nonnull A, Uint m, Uint n)
+{
+	const Uint align = M_MATRIX_BLK_ALIGN / sizeof(M_Real);
+	Uint i, ld;
+
+	A->v = NULL;
+	A->data = NULL;
+	A->mem = NULL;
+	A->ld = 0;
+	MROWS(A) = 0;
+	MCOLS(A) = 0;
+	if (m == 0 || n == 0) {
+		return (0);
+	}
+	ld = (align > 1) ? ((n + align-1) / align) * align : n;
+	if ((A->v = (M_Real **)AG_TryMalloc(m*sizeof(M_Real *))) == NULL) {
+		return (-1);
+	}
+	if ((A->data = TryMallocAligned((AG_Size)m * ld * sizeof(M_Real),
+	    &A->mem)) == NULL) {
+		AG_Free(A->v);
+		A->v = NULL;
+		return (-1);
+	}
+	for (i = 0; i < m; i++) {
+		A->v[i] = &A->data[(AG_Size)i * ld];
+	}
+	A->ld = ld;
+	MROWS(A) = m;
+	MCOLS(A) = n;
+	return (0);
+}
+
+/* Free matrix entries. */
+static void
+FreeEnts(M_MatrixBLK *_Nonnull A)
+{
+	if (A->v != NULL) {
+		AG_Free(A->v);
+		A->v = NULL;
+	}
+	if (A->mem != NULL) {
+		AG_Free(A->mem);
+		A->mem = NULL;
+	}
+	A->data = NULL;
+	A->ld = 0;
+	MROWS(A) = 0;
+	MCOLS(A) = 0;
+}
+
+/* Free the LU factorization of A. */
+static void
+FreeLU(M_MatrixBLK *_Nonnull A)
+{
+	if (A->LU != NULL) {
+		M_MatrixFree_BLK(A->LU);
+		A->LU = NULL;
+	}
+	if (A->ivec != NULL) {
+		M_VectorFreeZ(A->ivec);
+		A->ivec = NULL;
+	}
+}
+
+/* Return pointer to element at i,j */
+M_Real *
+M_GetElement_BLK(void *pM, Uint i, Uint j)
+{
+	M_MatrixBLK *M = pM;
+	return &(M->v[i][j]);
+}
+
+/* Return element at i,j */
+M_Real
+M_Get_BLK(void *pM, Uint i, Uint j)
+{
+	M_MatrixBLK *M = pM;
+	return (M->v[i][j]);
+}
+
+/* Resize a matrix to m*n without initializing new elements. */
+int
+M_MatrixResize_BLK(void *pA, Uint m, Uint n)
+{
+	M_MatrixBLK *A = pA;
+
+	FreeEnts(A);
+	return AllocEnts(A, m,n);
+}
+
+/* Free a Matrix object. */
+void
+M_MatrixFree_BLK(void *pA)
+{
+	M_MatrixBLK *A = pA;
+
+	FreeLU(A);
+	FreeEnts(A);
+	AG_Free(A);
+}
+
+/* Create a new m*n matrix. */
+void *
+M_MatrixNew_BLK(Uint m, Uint n)
+{
+	M_MatrixBLK *A;
+
+	A = (M_MatrixBLK *)AG_Malloc(sizeof(M_MatrixBLK));
+	MMATRIX(A)->ops = &mMatOps_BLK;
+	A->LU = NULL;
+	A->ivec = NULL;
+	if (AllocEnts(A, m,n) == -1) {
+		AG_Free(A);
+		return (NULL);
+	}
+	return (A);
+}
+
+/* Initialize A as the identity matrix. */
+void
+M_MatrixSetIdentity_BLK(void *pA)
+{
+	M_MatrixBLK *A = pA;
+	Uint i;
+
+	M_MatrixSetZero_BLK(A);
+	for (i = 0; i < MROWS(A) && i < MCOLS(A); i++)
+		A->v[i][i] = 1.0;
+}
+
+/* Initialize A as the zero matrix. */
+void
+M_MatrixSetZero_BLK(void *pA)
+{
+	M_MatrixBLK *A = pA;
+	Uint i, j;
+
+	for (i = 0; i < MROWS(A); i++) {
+		M_Real *row = A->v[i];
+
+		for (j = 0; j < MCOLS(A); j++)
+			row[j] = 0.0;
+	}
+}
+
+/* Return the transpose of matrix A (in tiles of BLK_TILE). */
+void *
+M_MatrixTranspose_BLK(const void *pA)
+{
+	const M_MatrixBLK *A = pA;
+	M_MatrixBLK *At;
+	Uint i0, j0, i, j, i1, j1;
+
+	if ((At = M_MatrixNew_BLK(MCOLS(A), MROWS(A))) == NULL) {
+		return (NULL);
+	}
+	for (i0 = 0; i0 < MROWS(A); i0 += BLK_TILE) {
+		i1 = MIN(i0 + BLK_TILE, MROWS(A));
+		for (j0 = 0; j0 < MCOLS(A); j0 += BLK_TILE) {
+			j1 = MIN(j0 + BLK_TILE, MCOLS(A));
+			for (i = i0; i < i1; i++) {
+				for (j = j0; j < j1; j++)
+					At->v[j][i] = A->v[i][j];
+			}
+		}
+	}
+	return (At);
+}
+
+/* Copy the contents of a matrix into another. */
+int
+M_MatrixCopy_BLK(void *pB, const void *pA)
+{
+	M_MatrixBLK *B = pB;
+	const M_MatrixBLK *A = pA;
+	Uint i;
+
+	M_ASSERT_COMPAT_MATRICES(A,B, -1);
+	for (i = 0; i < MROWS(A); i++) {
+		memcpy(B->v[i], A->v[i], MCOLS(A)*sizeof(M_Real));
+	}
+	return (0);
+}
+
+/* Return the duplicate of a matrix. */
+void *
+M_MatrixDup_BLK(const void *pA)
+{
+	const M_MatrixBLK *A = pA;
+	M_MatrixBLK *B;
+
+	if ((B = M_MatrixNew_BLK(MROWS(A), MCOLS(A))) == NULL) {
+		return (NULL);
+	}
+	M_MatrixCopy_BLK(B, A);
+	return (B);
+}
+
+/* Add the individual elements of two m-by-n matrices. */
+void *
+M_MatrixAdd_BLK(const void *pA, const void *pB)
+{
+	const M_MatrixBLK *A = pA;
+	M_MatrixBLK *P;
+
+	M_ASSERT_COMPAT_MATRICES(A,pB, NULL);
+	if ((P = M_MatrixDup_BLK(A)) == NULL) {
+		AG_FatalError(NULL);
+	}
+	M_MatrixAddv_BLK(P, pB);
+	return (P);
+}
+
+/* Add the individual elements of A and B into A. */
+int
+M_MatrixAddv_BLK(void *pA, const void *pB)
+{
+	M_MatrixBLK *A = pA;
+	const M_MatrixBLK *B = pB;
+	Uint i, j;
+
+	M_ASSERT_COMPAT_MATRICES(A,B, -1);
+	for (i = 0; i < MROWS(A); i++) {
+		M_Real *a = A->v[i];
+		const M_Real *b = B->v[i];
+
+		for (j = 0; j < MCOLS(A); j++)
+			a[j] += b[j];
+	}
+	return (0);
+}
+
+/* Compute the direct sum of two matrices. */
+void *
+M_MatrixDirectSum_BLK(const void *pA, const void *pB)
+{
+	const M_MatrixBLK *A = pA;
+	const M_MatrixBLK *B = pB;
+	M_MatrixBLK *P;
+	Uint i;
+
+	P = M_MatrixNew_BLK(MROWS(A)+MROWS(B), MCOLS(A)+MCOLS(B));
+	if (P == NULL) {
+		AG_FatalError(NULL);
+	}
+	M_MatrixSetZero_BLK(P);
+	for (i = 0; i < MROWS(A); i++) {
+		memcpy(P->v[i], A->v[i], MCOLS(A)*sizeof(M_Real));
+	}
+	for (i = 0; i < MROWS(B); i++) {
+		memcpy(&P->v[MROWS(A)+i][MCOLS(A)], B->v[i],
+		    MCOLS(B)*sizeof(M_Real));
+	}
+	return (P);
+}
+
+/*
+ * Copy an mc*kc block of A (row stride lda) into row panels of mr rows.
+ * Each panel stores its kc columns consecutively (mr entries each), and
+ * rows past mc are zero-filled.
+ */
+static void
+PackA(M_Real *_Nonnull Ap, const M_Real *_Nonnull A, Uint lda, Uint mc,
+    Uint kc, Uint mr)
+{
+	Uint i0, i, p;
+
+	for (i0 = 0; i0 < mc; i0 += mr) {
+		const Uint nRows = MIN(mr, mc - i0);
+
+		for (p = 0; p < kc; p++) {
+			for (i = 0; i < nRows; i++) {
+				Ap[i] = A[(AG_Size)(i0+i)*lda + p];
+			}
+			for (; i < mr; i++) {
+				Ap[i] = 0.0;
+			}
+			Ap += mr;
+		}
+	}
+}
+
+/*
+ * Copy a kc*nc block of B (row stride ldb) into column panels of nr
+ * columns. Each panel stores its kc rows consecutively (nr entries each),
+ * and columns past nc are zero-filled.
+ */
+static void
+PackB(M_Real *_Nonnull Bp, const M_Real *_Nonnull B, Uint ldb, Uint kc,
+    Uint nc, Uint nr)
+{
+	Uint j0, j, p;
+
+	for (j0 = 0; j0 < nc; j0 += nr) {
+		const Uint nCols = MIN(nr, nc - j0);
+
+		for (p = 0; p < kc; p++) {
+			const M_Real *b = &B[(AG_Size)p*ldb + j0];
+
+			for (j = 0; j < nCols; j++) {
+				Bp[j] = b[j];
+			}
+			for (; j < nr; j++) {
+				Bp[j] = 0.0;
+			}
+			Bp += nr;
+		}
+	}
+}
+
+/* Compute C += alpha*A*B for one job, without threads. */
+static void *_Nullable
+GemmWorker(void *_Nonnull p)
+{
+	BlkGemm *g = p;
+	const BlkKernel *K = g->K;
+	const Uint mr = K->mr, nr = K->nr;
+	M_Real edge[BLK_MR_MAX*BLK_NR_MAX];
+	const AG_Size kMax = MIN(BLK_KC, g->k);
+	const AG_Size mMax = (MIN(BLK_MC, g->m) + mr-1) / mr * mr;
+	const AG_Size nMax = (MIN(BLK_NC, g->n) + nr-1) / nr * nr;
+	M_Real *Ap, *Bp;
+	void *memA, *memB;
+	Uint jc, pc, ic, jr, ir, nc, kc, mc, i, j;
+
+	if ((Ap = TryMallocAligned(mMax*kMax*sizeof(M_Real), &memA)) == NULL) {
+		g->rv = -1;
+		return (NULL);
+	}
+	if ((Bp = TryMallocAligned(kMax*nMax*sizeof(M_Real), &memB)) == NULL) {
+		AG_Free(memA);
+		g->rv = -1;
+		return (NULL);
+	}
+	for (jc = 0; jc < g->n; jc += BLK_NC) {
+		nc = MIN(BLK_NC, g->n - jc);
+
+		for (pc = 0; pc < g->k; pc += BLK_KC) {
+			kc = MIN(BLK_KC, g->k - pc);
+			PackB(Bp, &g->B[(AG_Size)pc*g->ldb + jc], g->ldb,
+			    kc, nc, nr);
+
+			for (ic = 0; ic < g->m; ic += BLK_MC) {
+				mc = MIN(BLK_MC, g->m - ic);
+				PackA(Ap, &g->A[(AG_Size)ic*g->lda + pc], g->lda,
+				    mc, kc, mr);
+
+				for (jr = 0; jr < nc; jr += nr) {
+					const Uint nCols = MIN(nr, nc - jr);
+
+					for (ir = 0; ir < mc; ir += mr) {
+						const Uint nRows = MIN(mr, mc - ir);
+						M_Real *C = &g->C[(AG_Size)(ic+ir)*g->ldc +
+						                  jc+jr];
+
+						if (nRows == mr && nCols == nr) {
+							K->fn(kc, &Ap[ir*kc],
+							    &Bp[jr*kc], C, g->ldc,
+							    g->alpha);
+							continue;
+						}
+						/* Partial tile */
+						for (i = 0; i < mr*nr; i++) {
+							edge[i] = 0.0;
+						}
+						K->fn(kc, &Ap[ir*kc], &Bp[jr*kc],
+						    edge, nr, g->alpha);
+						for (i = 0; i < nRows; i++) {
+							for (j = 0; j < nCols; j++)
+								C[(AG_Size)i*g->ldc + j] +=
+								    edge[i*nr + j];
+						}
+					}
+				}
+			}
+		}
+	}
+	AG_Free(memB);
+	AG_Free(memA);
+	g->rv = 0;
+	return (NULL);
+}
+
+/* Compute C += alpha*A*B directly, for products too small to pack. */
+static void
+GemmSmall(Uint m, Uint n, Uint k, const M_Real *_Nonnull A, Uint lda,
+    const M_Real *_Nonnull B, Uint ldb, M_Real *_Nonnull C, Uint ldc,
+    M_Real alpha)
+{
+	Uint i, j, p;
+
+	for (i = 0; i < m; i++) {
+		M_Real *c = &C[(AG_Size)i*ldc];
+		const M_Real *a = &A[(AG_Size)i*lda];
+
+		for (p = 0; p < k; p++) {
+			const M_Real ap = alpha*a[p];
+			const M_Real *b = &B[(AG_Size)p*ldb];
+
+			for (j = 0; j < n; j++)
+				c[j] += ap*b[j];
+		}
+	}
+}
+
+/*
+ * Compute C += alpha*A*B, where A is m*k, B is k*n and C is m*n (with row
+ * strides lda, ldb and ldc). Large products are split between threads
+ * along the larger dimension of C.
+ */
+static int
+Gemm(Uint m, Uint n, Uint k, const M_Real *_Nonnull A, Uint lda,
+    const M_Real *_Nonnull B, Uint ldb, M_Real *_Nonnull C, Uint ldc,
+    M_Real alpha)
+{
+	const BlkKernel *K = blkKernel;
+	BlkGemm jobs[BLK_THREADS_MAX];
+	const int byRows = (m >= n);
+	const Uint split = byRows ? m : n;
+	const Uint unit = byRows ? K->mr : K->nr;
+	Uint nUnits, nJobs = 1;
+	Uint i;
+
+	if (m == 0 || n == 0 || k == 0) {
+		return (0);
+	}
+	if ((double)m*n*k <= BLK_SMALL) {
+		GemmSmall(m,n,k, A,lda, B,ldb, C,ldc, alpha);
+		return (0);
+	}
+	nUnits = (split + unit-1) / unit;
+#ifdef AG_THREADS
+	if ((double)m*n*k >= BLK_PARALLEL_MIN) {
+		nJobs = (blkThreads > 0) ? blkThreads : AG_GetProcessorCount();
+		nJobs = MIN(nJobs, BLK_THREADS_MAX);
+		nJobs = MIN(nJobs, split / BLK_SPLIT_MIN);
+		if (nJobs < 1)
+			nJobs = 1;
+	}
+#endif
+	for (i = 0; i < nJobs; i++) {
+		BlkGemm *g = &jobs[i];
+		const Uint x1 = (nUnits*i / nJobs) * unit;
+		const Uint x2 = MIN((nUnits*(i+1) / nJobs) * unit, split);
+
+		g->K = K;
+		g->k = k;
+		g->lda = lda;
+		g->ldb = ldb;
+		g->ldc = ldc;
+		g->alpha = alpha;
+		g->rv = 0;
+		if (byRows) {
+			g->m = x2 - x1;
+			g->n = n;
+			g->A = &A[(AG_Size)x1*lda];
+			g->B = B;
+			g->C = &C[(AG_Size)x1*ldc];
+		} else {
+			g->m = m;
+			g->n = x2 - x1;
+			g->A = A;
+			g->B = &B[x1];
+			g->C = &C[x1];
+		}
+	}
+	AG_RunJobs(GemmWorker, jobs, sizeof(BlkGemm), nJobs);
+
+	for (i = 0; i < nJobs; i++) {
+		if (jobs[i].rv != 0) {
+			AG_SetError("Out of memory");
+			return (-1);
+		}
+	}
+	return (0);
+}
+
+/* Return the product of matrices A and B. */
+void *
+M_MatrixMul_BLK(const void *pA, const void *pB)
+{
+	const M_MatrixBLK *A = pA;
+	const M_MatrixBLK *B = pB;
+	M_MatrixBLK *AB;
+
+	if ((AB = M_MatrixNew_BLK(MROWS(A), MCOLS(B))) == NULL) {
+		return (NULL);
+	}
+	if (M_MatrixMulv_BLK(A, B, AB) == -1) {
+		M_MatrixFree_BLK(AB);
+		return (NULL);
+	}
+	return (AB);
+}
+
+/* Return the product of matrices A and B into C. */
+int
+M_MatrixMulv_BLK(const void *pA, const void *pB, void *pC)
+{
+	const M_MatrixBLK *A = pA;
+	const M_MatrixBLK *B = pB;
+	M_MatrixBLK *C = pC;
+
+	if (MCOLS(A) != MROWS(B) ||
+	    MROWS(C) != MROWS(A) || MCOLS(C) != MCOLS(B)) {
+		AG_SetError("Incompatible matrices");
+		return (-1);
+	}
+	M_MatrixSetZero_BLK(C);
+	if (MROWS(C) == 0 || MCOLS(C) == 0 || MCOLS(A) == 0) {
+		return (0);
+	}
+	return Gemm(MROWS(A), MCOLS(B), MCOLS(A),
+	    A->data, A->ld,
+	    B->data, B->ld,
+	    C->data, C->ld, 1.0);
+}
+
+/* Return the Hadamard (entrywise) product of m*n matrices A and B. */
+void *
+M_MatrixEntMul_BLK(const void *pA, const void *pB)
+{
+	const M_MatrixBLK *A = pA;
+	M_MatrixBLK *AB;
+
+	M_ASSERT_COMPAT_MATRICES(A,pB, NULL);
+	if ((AB = M_MatrixNew_BLK(MROWS(A), MCOLS(A))) == NULL) {
+		AG_FatalError(NULL);
+	}
+	M_MatrixEntMulv_BLK(A, pB, AB);
+	return (AB);
+}
+
+/* Return the Hadamard (entrywise) product of m*n matrices A and B into AB. */
+int
+M_MatrixEntMulv_BLK(const void *pA, const void *pB, void *pAB)
+{
+	const M_MatrixBLK *A = pA;
+	const M_MatrixBLK *B = pB;
+	M_MatrixBLK *AB = pAB;
+	Uint i, j;
+
+	M_ASSERT_COMPAT_MATRICES(A,B, -1);
+	M_ASSERT_COMPAT_MATRICES(A,AB, -1);
+	for (i = 0; i < MROWS(A); i++) {
+		const M_Real *a = A->v[i], *b = B->v[i];
+		M_Real *ab = AB->v[i];
+
+		for (j = 0; j < MCOLS(A); j++)
+			ab[j] = a[j]*b[j];
+	}
+	return (0);
+}
+
+/* Compare two matrices entrywise and return the largest difference. */
+int
+M_MatrixCompare_BLK(const void *pA, const void *pB, M_Real *diff)
+{
+	const M_MatrixBLK *A = pA, *B = pB;
+	M_Real d;
+	Uint i, j;
+
+	M_ASSERT_COMPAT_MATRICES(A,B, -1);
+	*diff = 0.0;
+	for (i = 0; i < MROWS(A); i++) {
+		for (j = 0; j < MCOLS(A); j++) {
+			d = M_Fabs(A->v[i][j] - B->v[i][j]);
+			if (d > *diff) { *diff = d; }
+		}
+	}
+	return (0);
+}
+
+/* Return the trace of matrix A. */
+int
+M_MatrixTrace_BLK(M_Real *sum, const void *pA)
+{
+	const M_MatrixBLK *A = pA;
+	Uint i;
+
+	M_ASSERT_SQUARE_MATRIX(A, -1);
+	*sum = 0.0;
+	for (i = 0; i < MCOLS(A); i++) {
+		(*sum) += A->v[i][i];
+	}
+	return (0);
+}
+
+void *
+M_MatrixRead_BLK(AG_DataSource *buf)
+{
+	M_MatrixBLK *A;
+	Uint m,n, i,j;
+
+	m = (Uint)AG_ReadUint32(buf);
+	n = (Uint)AG_ReadUint32(buf);
+	if ((A = M_MatrixNew_BLK(m,n)) == NULL) {
+		AG_FatalError(NULL);
+	}
+	for (i = 0; i < m; i++) {
+		for (j = 0; j < n; j++)
+			A->v[i][j] = M_ReadReal(buf);
+	}
+	return (A);
+}
+
+void
+M_MatrixWrite_BLK(AG_DataSource *buf, const void *pA)
+{
+	const M_MatrixBLK *A = pA;
+	Uint i, j;
+
+	AG_WriteUint32(buf, (Uint32)MROWS(A));
+	AG_WriteUint32(buf, (Uint32)MCOLS(A));
+	for (i = 0; i < MROWS(A); i++) {
+		for (j = 0; j < MCOLS(A); j++)
+			M_WriteReal(buf, A->v[i][j]);
+	}
+}
+
+/* Convert matrix A to an array of m*n floats (in row-major order). */
+void
+M_MatrixToFloats_BLK(float *fv, const void *pA)
+{
+	const M_MatrixBLK *A = pA;
+	Uint i, j;
+
+	for (i = 0; i < MROWS(A); i++) {
+		for (j = 0; j < MCOLS(A); j++)
+			*fv++ = (float)A->v[i][j];
+	}
+}
+
+/* Convert matrix A to an array of m*n doubles (in row-major order). */
+void
+M_MatrixToDoubles_BLK(double *dv, const void *pA)
+{
+	const M_MatrixBLK *A = pA;
+	Uint i, j;
+
+	for (i = 0; i < MROWS(A); i++) {
+		for (j = 0; j < MCOLS(A); j++)
+			*dv++ = (double)A->v[i][j];
+	}
+}
+
+/* Load matrix A from an array of m*n floats (in row-major order). */
+void
+M_MatrixFromFloats_BLK(void *pA, const float *fv)
+{
+	M_MatrixBLK *A = pA;
+	Uint i, j;
+
+	for (i = 0; i < MROWS(A); i++) {
+		for (j = 0; j < MCOLS(A); j++)
+			A->v[i][j] = (M_Real)*fv++;
+	}
+}
+
+/* Load matrix A from an array of m*n doubles (in row-major order). */
+void
+M_MatrixFromDoubles_BLK(void *pA, const double *dv)
+{
+	M_MatrixBLK *A = pA;
+	Uint i, j;
+
+	for (i = 0; i < MROWS(A); i++) {
+		for (j = 0; j < MCOLS(A); j++)
+			A->v[i][j] = (M_Real)*dv++;
+	}
+}
+
+/*
+ * Factorize the kb columns of A starting at column k0 (rows k0 to n-1)
+ * with partial pivoting. Interchanges are applied to whole rows and
+ * recorded in piv.
+ */
+static void
+FactorizePanel(M_MatrixBLK *_Nonnull A, int *_Nonnull piv, Uint k0, Uint kb)
+{
+	const Uint n = MROWS(A), k1 = k0 + kb;
+	M_Real big, a, tmp, d;
+	Uint i, j, c, iMax;
+
+	for (j = k0; j < k1; j++) {
+		/* Search for the pivot element of this column. */
+		iMax = j;
+		big = M_Fabs(A->v[j][j]);
+		for (i = j+1; i < n; i++) {
+			if ((a = M_Fabs(A->v[i][j])) > big) {
+				big = a;
+				iMax = i;
+			}
+		}
+		piv[j] = (int)iMax;
+
+		/* Interchange rows if necessary. */
+		if (iMax != j) {
+			M_Real *r1 = A->v[iMax], *r2 = A->v[j];
+
+			for (c = 0; c < n; c++)
+				SWAP(r1[c], r2[c]);
+		}
+		if (M_Fabs(A->v[j][j]) <= M_MACHEP)
+			A->v[j][j] = M_TINYVAL;
+
+		/* Divide by the pivot element and update the panel. */
+		d = 1.0/A->v[j][j];
+		for (i = j+1; i < n; i++) {
+			M_Real *row = A->v[i];
+			const M_Real *rowPivot = A->v[j];
+			const M_Real l = row[j]*d;
+
+			row[j] = l;
+			for (c = j+1; c < k1; c++)
+				row[c] -= l*rowPivot[c];
+		}
+	}
+}
+
+/*
+ * LU Factorization -
+ * Decompose a square matrix A into a product of the upper-triangular
+ * matrix U and the unit lower-triangular matrix L, following a row-wise
+ * permutation. The partial pivoting information is recorded in ivec.
+ *
+ * Columns are factorized in panels of BLK_NB. After each panel, the
+ * corresponding rows of U are solved for and the trailing submatrix is
+ * updated with a single GEMM.
+ */
+int
+M_FactorizeLU_BLK(void *pA)
+{
+	M_MatrixBLK *Aorig = pA, *A;
+	Uint n, k0, kb, k1, i, p, c;
+	M_Real big;
+
+	M_ASSERT_SQUARE_MATRIX(Aorig, -1);
+	n = MROWS(Aorig);
+
+	/* Initialize LU structure if not previously used (or resized). */
+	if (Aorig->ivec != NULL && Aorig->ivec->n != n) {
+		FreeLU(Aorig);
+	}
+	if (Aorig->LU != NULL && MROWS(Aorig->LU) != n) {
+		FreeLU(Aorig);
+	}
+	if (Aorig->ivec == NULL) {
+		Aorig->ivec = M_VectorNewZ(n);
+	}
+	if (Aorig->LU == NULL &&
+	    (Aorig->LU = M_MatrixNew_BLK(n, n)) == NULL) {
+		return (-1);
+	}
+	A = Aorig->LU;
+	M_MatrixCopy_BLK(A, Aorig);
+
+	for (i = 0; i < n; i++) {
+		const M_Real *row = A->v[i];
+
+		for (big = 0.0, c = 0; c < n; c++) {
+			if (M_Fabs(row[c]) > big)
+				big = M_Fabs(row[c]);
+		}
+		if (big <= M_MACHEP) {
+			AG_SetError("Singular matrix (no pivot in row %u)", i);
+			return (-1);
+		}
+	}
+
+	for (k0 = 0; k0 < n; k0 += BLK_NB) {
+		kb = MIN(BLK_NB, n - k0);
+		k1 = k0 + kb;
+
+		FactorizePanel(A, Aorig->ivec->v, k0, kb);
+		if (k1 == n)
+			break;
+
+		/* Solve L11*U12 = A12 (unit lower-triangular). */
+		for (i = k0+1; i < k1; i++) {
+			M_Real *row = A->v[i];
+
+			for (p = k0; p < i; p++) {
+				const M_Real l = row[p];
+				const M_Real *rowP = A->v[p];
+
+				for (c = k1; c < n; c++)
+					row[c] -= l*rowP[c];
+			}
+		}
+
+		/* Update the trailing submatrix: A22 -= L21*U12. */
+		if (Gemm(n-k1, n-k1, kb,
+		    &A->v[k1][k0], A->ld,
+		    &A->v[k0][k1], A->ld,
+		    &A->v[k1][k1], A->ld, -1.0) == -1)
+			return (-1);
+	}
+	return (0);
+}
+
+/*
+ * Solve a (LU-factorized) system Ax=b by forward and backsubstitution.
+ */
+void
+M_BacksubstLU_BLK(void *pA, void *pb)
+{
+	const M_MatrixBLK *A = pA;
+	const M_MatrixBLK *LU = A->LU;
+	M_Vector *b = pb;
+	const int *piv;
+	M_Real sum;
+	int i, j, n;
+
+	if (LU == NULL) {
+		return;
+	}
+	piv = A->ivec->v;
+	n = (int)MROWS(LU);
+
+	for (i = 0; i < n; i++) {
+		const M_Real *row = LU->v[i];
+
+		sum = b->v[piv[i]];
+		b->v[piv[i]] = b->v[i];
+		for (j = 0; j < i; j++) {
+			sum -= row[j]*b->v[j];
+		}
+		b->v[i] = sum;
+	}
+	for (i = n-1; i >= 0; i--) {
+		const M_Real *row = LU->v[i];
+
+		sum = b->v[i];
+		for (j = i+1; j < n; j++) {
+			sum -= row[j]*b->v[j];
+		}
+		b->v[i] = sum/row[i];
+	}
+}
+
+/*
+ * Perform Gauss-Jordan elimination on a matrix A and a right-hand side b.
+ * The original contents of A are destroyed, as it is replaced by the matrix
+ * inverse. The solution vectors are returned in b.
+ */
+static int
+GaussJordanv(M_MatrixBLK *_Nonnull A, M_MatrixBLK *_Nonnull b)
+{
+	const int n = (int)MCOLS(A), nb = (int)MCOLS(b);
+	M_VectorZ *iCol, *iRow, *iPivot;
+	int col = 0, row = 0;
+	int i, j, k, l, m;
+	M_Real big, dum, pivinv, tmp;
+
+	M_ASSERT_SQUARE_MATRIX(A, -1);
+	iRow = M_VectorNewZ(n);
+	iCol = M_VectorNewZ(n);
+	iPivot = M_VectorNewZ(n);
+	M_VectorSetZ(iPivot, 0);
+
+	for (i = 0; i < n; i++) {
+		big = 0.0;
+
+		/* Search for the pivot element of this column. */
+		for (j = 0; j < n; j++) {
+			if (iPivot->v[j] == 1) {
+				continue;
+			}
+			for (k = 0; k < n; k++) {
+				if (iPivot->v[k] == 0) {
+					if (M_Fabs(A->v[j][k]) >= big) {
+						big = M_Fabs(A->v[j][k]);
+						row = j;
+						col = k;
+					}
+				} else if (iPivot->v[k] > 1) {
+					AG_SetError("Singular matrix");
+					goto fail;
+				}
+			}
+		}
+		iPivot->v[col]++;
+
+		/* Move the pivot to the diagonal and record the interchange. */
+		if (row != col) {
+			for (l = 0; l < n; l++)
+				SWAP(A->v[row][l], A->v[col][l]);
+			for (l = 0; l < nb; l++)
+				SWAP(b->v[row][l], b->v[col][l]);
+		}
+		iRow->v[i] = row;
+		iCol->v[i] = col;
+
+		if (M_Fabs(A->v[col][col]) < M_MACHEP) {
+			AG_SetError("Matrix singular to machine precision");
+			goto fail;
+		}
+		pivinv = 1.0/A->v[col][col];
+		A->v[col][col] = 1.0;
+
+		for (l = 0; l < n; l++) { A->v[col][l] *= pivinv; }
+		for (l = 0; l < nb; l++) { b->v[col][l] *= pivinv; }
+
+		/* Reduce the rows except for the pivot one. */
+		for (m = 0; m < n; m++) {
+			M_Real *rA = A->v[m], *rB = b->v[m];
+			const M_Real *pA = A->v[col], *pB = b->v[col];
+
+			if (m == col) {
+				continue;
+			}
+			dum = rA[col];
+			rA[col] = 0.0;
+
+			for (l = 0; l < n; l++)
+				rA[l] -= pA[l]*dum;
+			for (l = 0; l < nb; l++)
+				rB[l] -= pB[l]*dum;
+		}
+	}
+
+	for (l = n-1; l >= 0; l--) {
+		if (iRow->v[l] != iCol->v[l]) {
+			for (k = 0; k < n; k++)
+				SWAP(A->v[k][iRow->v[l]],
+				     A->v[k][iCol->v[l]]);
+		}
+	}
+
+	M_VectorFreeZ(iRow);
+	M_VectorFreeZ(iCol);
+	M_VectorFreeZ(iPivot);
+	return (0);
+fail:
+	M_VectorFreeZ(iRow);
+	M_VectorFreeZ(iCol);
+	M_VectorFreeZ(iPivot);
+	return (-1);
+}
+
+void *
+M_GaussJordan_BLK(const void *pA, void *pb)
+{
+	M_MatrixBLK *Ainv;
+
+	if ((Ainv = M_MatrixDup_BLK(pA)) == NULL) {
+		return (NULL);
+	}
+	if (GaussJordanv(Ainv, pb) == -1) {
+		M_MatrixFree_BLK(Ainv);
+		return (NULL);
+	}
+	return (Ainv);
+}
+
+void
+M_MNAPreorder_BLK(void *A)
+{
+	/* silence unused parameter warning */
+	(void)(A);
+}
+
+void
+M_AddToDiag_BLK(void *pA, M_Real g)
+{
+	M_MatrixBLK *A = pA;
+	Uint i, N;
+
+	N = M_Min(MROWS(A), MCOLS(A));
+	for (i = 0; i < N; i++)
+		A->v[i][i] += g;
+}
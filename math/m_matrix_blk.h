@@ -0,0 +1,69 @@
+/*
+ * Public domain.
+ * Operations on m*n matrices (cache-blocked version).
+ */
+
+/*
+ * Entries are stored in one contiguous, M_MATRIX_BLK_ALIGN-aligned block
+ * with a row stride of ld elements. The row pointers in v are compatible
+ * with M_MatrixFPU(3).
+ */
+#define M_MATRIX_BLK_ALIGN 64
+
+typedef struct m_matrix_blk {
+	struct m_matrix _inherit;		/* M_Matrix(3) -> M_MatrixBLK */
+	M_Real *_Nullable *_Nonnull v;		/* Row pointers into data */
+	struct m_matrix_blk *_Nullable LU;	/* LU factorization */
+	M_VectorZ *_Nullable ivec;		/* For LU factorization */
+	M_Real *_Nullable data;			/* Aligned entries */
+	void *_Nullable mem;			/* Allocated block */
+	Uint ld;				/* Row stride (in entries) */
+	Uint32 _pad;
+} M_MatrixBLK;
+
+__BEGIN_DECLS
+extern const M_MatrixOps mMatOps_BLK;
+
+M_Real *_Nonnull M_GetElement_BLK(void *_Nonnull, Uint, Uint);
+M_Real           M_Get_BLK(void *_Nonnull, Uint, Uint);
+int              M_MatrixResize_BLK(void *_Nonnull, Uint, Uint);
+void             M_MatrixFree_BLK(void *_Nonnull);
+void *_Nullable  M_MatrixNew_BLK(Uint, Uint);
+void             M_MatrixSetIdentity_BLK(void *_Nonnull);
+void             M_MatrixSetZero_BLK(void *_Nonnull);
+void *_Nullable  M_MatrixTranspose_BLK(const void *_Nonnull);
+int              M_MatrixCopy_BLK(void *_Nonnull, const void *_Nonnull);
+void *_Nullable  M_MatrixDup_BLK(const void *_Nonnull);
+void *_Nullable  M_MatrixAdd_BLK(const void *_Nonnull, const void *_Nonnull);
+int              M_MatrixAddv_BLK(void *_Nonnull, const void *_Nonnull);
+void *_Nonnull   M_MatrixDirectSum_BLK(const void *_Nonnull,
+                                       const void *_Nonnull);
+void *_Nullable  M_MatrixMul_BLK(const void *_Nonnull, const void *_Nonnull);
+int              M_MatrixMulv_BLK(const void *_Nonnull, const void *_Nonnull,
+                                  void *_Nonnull);
+void *_Nullable  M_MatrixEntMul_BLK(const void *_Nonnull, const void *_Nonnull);
+int              M_MatrixEntMulv_BLK(const void *_Nonnull, const void *_Nonnull,
+                                     void *_Nonnull);
+int  M_MatrixCompare_BLK(const void *_Nonnull, const void *_Nonnull,
+                         M_Real *_Nonnull);
+int  M_MatrixTrace_BLK(M_Real *_Nonnull, const void *_Nonnull);
+
+void *_Nonnull M_MatrixRead_BLK(AG_DataSource *_Nonnull);
+void           M_MatrixWrite_BLK(AG_DataSource *_Nonnull, const void *_Nonnull);
+
+void M_MatrixToFloats_BLK(float *_Nonnull, const void *_Nonnull);
+void M_MatrixToDoubles_BLK(double *_Nonnull, const void *_Nonnull);
+void M_MatrixFromFloats_BLK(void *_Nonnull, const float *_Nonnull);
+void M_MatrixFromDoubles_BLK(void *_Nonnull, const double *_Nonnull);
+
+void *_Nullable M_GaussJordan_BLK(const void *_Nonnull, void *_Nonnull);
+int             M_FactorizeLU_BLK(void *_Nonnull);
+void            M_BacksubstLU_BLK(void *_Nonnull, void *_Nonnull);
+void            M_MNAPreorder_BLK(void *_Nonnull);
+void            M_AddToDiag_BLK(void *_Nonnull, M_Real);
+
+void                  M_MatrixInitEngine_BLK(void);
+const char *_Nonnull  M_MatrixGetKernel_BLK(void);
+int                   M_MatrixSetKernel_BLK(const char *_Nonnull);
+void                  M_MatrixSetThreads_BLK(Uint);
+__END_DECLS
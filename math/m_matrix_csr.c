@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2026 Julien Nadeau Carriere <vedge@csoft.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Sparse matrices in compressed sparse row (CSR) format. Entries of a row
+ * are contiguous, so products with vectors stream through memory instead
+ * of following the element lists of M_MatrixSP(3). Products of large
+ * matrices are split across threads by ranges of rows holding about the
+ * same number of entries.
+ */
+
+#include <agar/core/core.h>
+#include <agar/math/m.h>
+#include <agar/math/m_sparse.h>
+
+#include <string.h>
+
+#define CSR_PARALLEL_MIN  262144	/* Minimum entries for threaded Mulv */
+#define CSR_THREADS_MAX   32		/* Maximum threads per product */
+
+typedef struct csr_mulv {
+	const M_MatrixCSR *_Nonnull A;
+	const M_Real *_Nonnull x;
+	M_Real *_Nonnull y;
+	Uint i1, i2;			/* Range of rows */
+} CSR_Mulv;
+
+static Uint csrThreads = 0;		/* Maximum threads (0 = auto) */
+
+/*
+ * Allocate an m*n matrix with room for nnz entries. The row pointers are
+ * initialized to an empty matrix.
+ */
+M_MatrixCSR *
+M_MatrixNew_CSR(Uint m, Uint n, Uint nnz)
+{
+	M_MatrixCSR *A;
+
+	if ((A = TryMalloc(sizeof(M_MatrixCSR))) == NULL) {
+		return (NULL);
+	}
+	A->m = m;
+	A->n = n;
+	A->nnz = 0;
+	A->_pad = 0;
+	if ((A->rowPtr = TryMalloc((m+1)*sizeof(Uint))) == NULL) {
+		goto fail;
+	}
+	if ((A->colIdx = TryMalloc((nnz > 0 ? nnz : 1)*sizeof(Uint))) == NULL) {
+		Free(A->rowPtr);
+		goto fail;
+	}
+	if ((A->val = TryMalloc((nnz > 0 ? nnz : 1)*sizeof(M_Real))) == NULL) {
+		Free(A->colIdx);
+		Free(A->rowPtr);
+		goto fail;
+	}
+	memset(A->rowPtr, 0, (m+1)*sizeof(Uint));
+	return (A);
+fail:
+	Free(A);
+	return (NULL);
+}
+
+void
+M_MatrixFree_CSR(M_MatrixCSR *A)
+{
+	Free(A->val);
+	Free(A->colIdx);
+	Free(A->rowPtr);
+	Free(A);
+}
+
+/*
+ * Convert an unfactored M_MatrixSP(3) to CSR format. External row and
+ * column numbers 1..n (0 being the ground node) become CSR indices 0..n-1.
+ * Stored zeros are preserved.
+ */
+M_MatrixCSR *
+M_MatrixToCSR_SP(const void *pA)
+{
+	const M_MatrixSP *S = pA;
+	MatrixPtr Matrix = (MatrixPtr)S->d;
+	ElementPtr e;
+	M_MatrixCSR *A;
+	Uint *rowPtr;
+	Uint i, n, nnz;
+	int extCol, intCol;
+
+	if (Matrix->Factored) {
+		AG_SetError("Matrix is factored");
+		return (NULL);
+	}
+	if (Matrix->Complex) {
+		AG_SetError("Complex matrices are not supported");
+		return (NULL);
+	}
+	n = (Uint)Matrix->ExtSize;
+	for (nnz = 0, intCol = 1; intCol <= Matrix->Size; intCol++) {
+		for (e = Matrix->FirstInCol[intCol]; e != NULL; e = e->NextInCol)
+			nnz++;
+	}
+	if ((A = M_MatrixNew_CSR(n, n, nnz)) == NULL) {
+		return (NULL);
+	}
+	rowPtr = A->rowPtr;
+
+	/* Count the entries of each row. */
+	for (intCol = 1; intCol <= Matrix->Size; intCol++) {
+		for (e = Matrix->FirstInCol[intCol]; e != NULL; e = e->NextInCol)
+			rowPtr[Matrix->IntToExtRowMap[e->Row]]++;
+	}
+	for (i = 0; i < n; i++) {
+		rowPtr[i+1] += rowPtr[i];
+	}
+
+	/*
+	 * Fill the rows in order of external column, so that the columns
+	 * of each row come out sorted. rowPtr[i] is used as the insertion
+	 * point of row i (shifted by one row from its final value).
+	 */
+	for (extCol = 1; extCol <= Matrix->ExtSize; extCol++) {
+		if ((intCol = Matrix->ExtToIntColMap[extCol]) <= 0) {
+			continue;
+		}
+		for (e = Matrix->FirstInCol[intCol]; e != NULL; e = e->NextInCol) {
+			const Uint k = rowPtr[Matrix->IntToExtRowMap[e->Row] - 1]++;
+
+			A->colIdx[k] = (Uint)(extCol - 1);
+			A->val[k] = e->Real;
+		}
+	}
+	for (i = n; i > 0; i--) {
+		rowPtr[i] = rowPtr[i-1];
+	}
+	rowPtr[0] = 0;
+	A->nnz = rowPtr[n];
+	return (A);
+}
+
+/*
+ * Set the maximum number of threads used by a single product
+ * (0 = one per processor, 1 = no threads).
+ */
+void
+M_MatrixSetThreads_CSR(Uint nThreads)
+{
+	csrThreads = nThreads;
+}
+
+/* Compute y = Ax over one range of rows. */
+static void *_Nullable
+MulvWorker(void *_Nonnull p)
+{
+	const CSR_Mulv *job = p;
+	const M_MatrixCSR *A = job->A;
+	const Uint *rowPtr = A->rowPtr, *colIdx = A->colIdx;
+	const M_Real *val = A->val, *x = job->x;
+	M_Real *y = job->y;
+	Uint i, k;
+
+	for (i = job->i1; i < job->i2; i++) {
+		const Uint kEnd = rowPtr[i+1];
+		M_Real sum = 0.0;
+
+		for (k = rowPtr[i]; k < kEnd; k++) {
+			sum += val[k] * x[colIdx[k]];
+		}
+		y[i] = sum;
+	}
+	return (NULL);
+}
+
+/* Compute y = Ax. The vector y must not overlap x. */
+void
+M_MatrixMulv_CSR(const M_MatrixCSR *A, const M_Real *x, M_Real *y)
+{
+	CSR_Mulv jobs[CSR_THREADS_MAX];
+	Uint i, nJobs = 1, row = 0;
+
+#ifdef AG_THREADS
+	if (A->nnz >= CSR_PARALLEL_MIN) {
+		nJobs = (csrThreads > 0) ? csrThreads : AG_GetProcessorCount();
+		nJobs = MIN(nJobs, CSR_THREADS_MAX);
+		nJobs = MIN(nJobs, A->m);
+		if (nJobs < 1)
+			nJobs = 1;
+	}
+#endif
+	for (i = 0; i < nJobs; i++) {
+		CSR_Mulv *job = &jobs[i];
+		const Uint kEnd = (Uint)(((Uint64)A->nnz * (i+1)) / nJobs);
+
+		job->A = A;
+		job->x = x;
+		job->y = y;
+		job->i1 = row;
+		if (i == nJobs-1) {
+			row = A->m;
+		} else {
+			while (row < A->m && A->rowPtr[row+1] <= kEnd)
+				row++;
+		}
+		job->i2 = row;
+	}
+	AG_RunJobs(MulvWorker, jobs, sizeof(CSR_Mulv), nJobs);
+}
@@ -0,0 +1,69 @@
+/*	Public domain	*/
+/*
+ * Sparse matrices in compressed sparse row (CSR) format, and iterative
+ * solvers for large sparse systems.
+ */
+
+/*
+ * Row i has nonzero entries val[rowPtr[i]..rowPtr[i+1]-1] in columns
+ * colIdx[rowPtr[i]..rowPtr[i+1]-1], sorted in increasing order.
+ * Indices are 0-based.
+ */
+typedef struct m_matrix_csr {
+	Uint m, n;			/* Rows, columns */
+	Uint nnz;			/* Number of stored entries */
+	Uint32 _pad;
+	Uint *_Nonnull rowPtr;		/* Start of each row (m+1 entries) */
+	Uint *_Nonnull colIdx;		/* Column of each entry */
+	M_Real *_Nonnull val;		/* Value of each entry */
+} M_MatrixCSR;
+
+/* Preconditioner for the iterative solvers. */
+enum m_precond_type {
+	M_PRECOND_NONE,			/* Identity */
+	M_PRECOND_JACOBI,		/* Inverse of diagonal */
+	M_PRECOND_ILU0			/* Incomplete LU without fill-in */
+};
+
+typedef struct m_precond {
+	enum m_precond_type type;
+	Uint n;				/* Size of system */
+	M_Real *_Nullable invDiag;	/* Inverse diagonal (JACOBI) */
+	M_MatrixCSR *_Nullable LU;	/* Unit L and U factors (ILU0) */
+	Uint *_Nullable diagIdx;	/* Index of diagonal in LU rows */
+} M_Precond;
+
+/* Convergence statistics returned by the iterative solvers. */
+typedef struct m_iter_stats {
+	Uint iter;			/* Iterations performed */
+	Uint32 _pad;
+	M_Real resid;			/* Final ||b - Ax|| / ||b|| */
+} M_IterStats;
+
+#define M_GMRES_RESTART_DEFAULT 30
+
+__BEGIN_DECLS
+M_MatrixCSR *_Nullable M_MatrixNew_CSR(Uint, Uint, Uint);
+void                   M_MatrixFree_CSR(M_MatrixCSR *_Nonnull);
+M_MatrixCSR *_Nullable M_MatrixToCSR_SP(const void *_Nonnull);
+void                   M_MatrixMulv_CSR(const M_MatrixCSR *_Nonnull,
+                                        const M_Real *_Nonnull,
+                                        M_Real *_Nonnull);
+void                   M_MatrixSetThreads_CSR(Uint);
+
+int  M_PrecondInit(M_Precond *_Nonnull, const M_MatrixCSR *_Nonnull,
+                   enum m_precond_type);
+void M_PrecondApply(const M_Precond *_Nonnull, const M_Real *_Nonnull,
+                    M_Real *_Nonnull);
+void M_PrecondFree(M_Precond *_Nonnull);
+
+int M_SolveCG(const M_MatrixCSR *_Nonnull, const M_Precond *_Nullable,
+              const M_Real *_Nonnull, M_Real *_Nonnull, M_Real, Uint,
+              M_IterStats *_Nullable);
+int M_SolveBiCGSTAB(const M_MatrixCSR *_Nonnull, const M_Precond *_Nullable,
+                    const M_Real *_Nonnull, M_Real *_Nonnull, M_Real, Uint,
+                    M_IterStats *_Nullable);
+int M_SolveGMRES(const M_MatrixCSR *_Nonnull, const M_Precond *_Nullable,
+                 const M_Real *_Nonnull, M_Real *_Nonnull, Uint, M_Real,
+                 Uint, M_IterStats *_Nullable);
+__END_DECLS
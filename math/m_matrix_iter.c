@@ -0,0 +1,557 @@
+/*
+ * Copyright (c) 2026 Julien Nadeau Carriere <vedge@csoft.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Preconditioned iterative solvers (conjugate gradient, BiCGSTAB and
+ * restarted GMRES) for large sparse systems in M_MatrixCSR format, with
+ * Jacobi and ILU(0) preconditioners. Unlike the LU factorization of
+ * M_MatrixSP(3), memory usage does not grow with fill-in.
+ */
+
+#include <agar/core/core.h>
+#include <agar/math/m.h>
+
+#include <string.h>
+
+#define ILU_NONE 0xffffffffU		/* No entry at this column */
+
+static M_Real
+Dot(const M_Real *_Nonnull a, const M_Real *_Nonnull b, Uint n)
+{
+	M_Real sum = 0.0;
+	Uint i;
+
+	for (i = 0; i < n; i++) {
+		sum += a[i]*b[i];
+	}
+	return (sum);
+}
+
+static M_Real
+Norm(const M_Real *_Nonnull a, Uint n)
+{
+	return M_Sqrt(Dot(a, a, n));
+}
+
+/* Compute r = b - Ax. */
+static void
+Residual(const M_MatrixCSR *_Nonnull A, const M_Real *_Nonnull b,
+    const M_Real *_Nonnull x, M_Real *_Nonnull r)
+{
+	Uint i;
+
+	M_MatrixMulv_CSR(A, x, r);
+	for (i = 0; i < A->m; i++)
+		r[i] = b[i] - r[i];
+}
+
+/* Allocate nVecs vectors of n entries in one block. */
+static M_Real *_Nullable
+AllocVectors(Uint n, Uint nVecs)
+{
+	return TryMalloc((AG_Size)n*nVecs*sizeof(M_Real));
+}
+
+/*
+ * Initialize a preconditioner for the square matrix A. ILU(0) computes
+ * incomplete L and U factors on the sparsity pattern of A. Return -1 if
+ * A has a zero (or missing) diagonal entry, or a zero pivot occurs.
+ */
+int
+M_PrecondInit(M_Precond *P, const M_MatrixCSR *A, enum m_precond_type type)
+{
+	const Uint n = A->m;
+	M_MatrixCSR *LU;
+	Uint *iw = NULL, *diagIdx;
+	M_Real *a;
+	Uint i, k, kk, c;
+
+	P->type = type;
+	P->n = n;
+	P->invDiag = NULL;
+	P->LU = NULL;
+	P->diagIdx = NULL;
+
+	if (A->m != A->n) {
+		AG_SetError("Matrix is not square");
+		return (-1);
+	}
+	switch (type) {
+	case M_PRECOND_NONE:
+		return (0);
+	case M_PRECOND_JACOBI:
+		if ((P->invDiag = TryMalloc(n*sizeof(M_Real))) == NULL) {
+			return (-1);
+		}
+		for (i = 0; i < n; i++) {
+			for (k = A->rowPtr[i]; k < A->rowPtr[i+1]; k++) {
+				if (A->colIdx[k] == i)
+					break;
+			}
+			if (k == A->rowPtr[i+1] || A->val[k] == 0.0) {
+				AG_SetError("Zero diagonal at row %u", i);
+				goto fail;
+			}
+			P->invDiag[i] = 1.0 / A->val[k];
+		}
+		return (0);
+	case M_PRECOND_ILU0:
+		break;
+	default:
+		AG_SetError("Bad preconditioner");
+		return (-1);
+	}
+
+	if ((LU = P->LU = M_MatrixNew_CSR(n, n, A->nnz)) == NULL ||
+	    (diagIdx = P->diagIdx = TryMalloc((n > 0 ? n : 1)*sizeof(Uint))) == NULL ||
+	    (iw = TryMalloc((n > 0 ? n : 1)*sizeof(Uint))) == NULL) {
+		goto fail;
+	}
+	memcpy(LU->rowPtr, A->rowPtr, (n+1)*sizeof(Uint));
+	memcpy(LU->colIdx, A->colIdx, A->nnz*sizeof(Uint));
+	memcpy(LU->val, A->val, A->nnz*sizeof(M_Real));
+	LU->nnz = A->nnz;
+	a = LU->val;
+
+	for (i = 0; i < n; i++) {
+		for (k = LU->rowPtr[i]; k < LU->rowPtr[i+1]; k++) {
+			if (LU->colIdx[k] >= i)
+				break;
+		}
+		if (k == LU->rowPtr[i+1] || LU->colIdx[k] != i) {
+			AG_SetError("Zero diagonal at row %u", i);
+			goto fail;
+		}
+		diagIdx[i] = k;
+		iw[i] = ILU_NONE;
+	}
+
+	/* IKJ variant of Gaussian elimination restricted to the pattern. */
+	for (i = 0; i < n; i++) {
+		const Uint kBeg = LU->rowPtr[i], kEnd = LU->rowPtr[i+1];
+
+		for (k = kBeg; k < kEnd; k++) {
+			iw[LU->colIdx[k]] = k;
+		}
+		for (k = kBeg; k < diagIdx[i]; k++) {
+			c = LU->colIdx[k];
+			a[k] /= a[diagIdx[c]];
+			for (kk = diagIdx[c]+1; kk < LU->rowPtr[c+1]; kk++) {
+				const Uint jw = iw[LU->colIdx[kk]];
+
+				if (jw != ILU_NONE)
+					a[jw] -= a[k]*a[kk];
+			}
+		}
+		for (k = kBeg; k < kEnd; k++) {
+			iw[LU->colIdx[k]] = ILU_NONE;
+		}
+		if (a[diagIdx[i]] == 0.0) {
+			AG_SetError("Zero pivot at row %u", i);
+			goto fail;
+		}
+	}
+	Free(iw);
+	return (0);
+fail:
+	Free(iw);
+	M_PrecondFree(P);
+	return (-1);
+}
+
+/* Compute z = M^-1 r, where M is the preconditioner. */
+void
+M_PrecondApply(const M_Precond *P, const M_Real *r, M_Real *z)
+{
+	const Uint n = P->n;
+	const M_MatrixCSR *LU;
+	const Uint *rowPtr, *colIdx, *diagIdx;
+	const M_Real *a;
+	M_Real sum;
+	Uint i, k;
+
+	switch (P->type) {
+	case M_PRECOND_JACOBI:
+		for (i = 0; i < n; i++) {
+			z[i] = P->invDiag[i] * r[i];
+		}
+		return;
+	case M_PRECOND_ILU0:
+		break;
+	default:
+		if (z != r) {
+			memcpy(z, r, n*sizeof(M_Real));
+		}
+		return;
+	}
+
+	LU = P->LU;
+	rowPtr = LU->rowPtr;
+	colIdx = LU->colIdx;
+	diagIdx = P->diagIdx;
+	a = LU->val;
+
+	for (i = 0; i < n; i++) {				/* Solve Ly = r */
+		for (sum = r[i], k = rowPtr[i]; k < diagIdx[i]; k++) {
+			sum -= a[k]*z[colIdx[k]];
+		}
+		z[i] = sum;
+	}
+	for (i = n; i > 0; i--) {				/* Solve Uz = y */
+		const Uint row = i-1;
+
+		sum = z[row];
+		for (k = diagIdx[row]+1; k < rowPtr[row+1]; k++) {
+			sum -= a[k]*z[colIdx[k]];
+		}
+		z[row] = sum / a[diagIdx[row]];
+	}
+}
+
+void
+M_PrecondFree(M_Precond *P)
+{
+	if (P->LU != NULL) {
+		M_MatrixFree_CSR(P->LU);
+		P->LU = NULL;
+	}
+	Free(P->diagIdx);
+	Free(P->invDiag);
+	P->diagIdx = NULL;
+	P->invDiag = NULL;
+	P->type = M_PRECOND_NONE;
+}
+
+/* Apply an optional preconditioner. */
+static __inline__ void
+Precond(const M_Precond *_Nullable P, const M_Real *_Nonnull r,
+    M_Real *_Nonnull z, Uint n)
+{
+	if (P != NULL) {
+		M_PrecondApply(P, r, z);
+	} else {
+		memcpy(z, r, n*sizeof(M_Real));
+	}
+}
+
+static void
+SetStats(M_IterStats *_Nullable stats, Uint iter, M_Real resid)
+{
+	if (stats != NULL) {
+		stats->iter = iter;
+		stats->_pad = 0;
+		stats->resid = resid;
+	}
+}
+
+/*
+ * Solve Ax=b for a symmetric positive-definite A using the preconditioned
+ * conjugate gradient method, starting from the initial guess in x. Iterate
+ * until ||b - Ax|| <= tol*||b|| or for at most maxIter iterations. Return
+ * 0 on convergence, or -1 on failure.
+ */
+int
+M_SolveCG(const M_MatrixCSR *A, const M_Precond *P, const M_Real *b,
+    M_Real *x, M_Real tol, Uint maxIter, M_IterStats *stats)
+{
+	const Uint n = A->m;
+	M_Real *mem, *r, *z, *p, *q;
+	M_Real bNorm, resid, rz, rzNew, pq, alpha, beta;
+	Uint i, iter = 0;
+	int rv = -1;
+
+	if ((mem = AllocVectors(n, 4)) == NULL) {
+		return (-1);
+	}
+	r = &mem[0];
+	z = &mem[n];
+	p = &mem[2*n];
+	q = &mem[3*n];
+
+	if ((bNorm = Norm(b,n)) == 0.0) {
+		memset(x, 0, n*sizeof(M_Real));
+		SetStats(stats, 0, 0.0);
+		Free(mem);
+		return (0);
+	}
+	Residual(A, b, x, r);
+	resid = Norm(r,n) / bNorm;
+	Precond(P, r, z, n);
+	memcpy(p, z, n*sizeof(M_Real));
+	rz = Dot(r,z,n);
+
+	while (resid > tol) {
+		if (iter >= maxIter) {
+			AG_SetError("CG: No convergence in %u iterations "
+			            "(residual %g)", iter, (double)resid);
+			goto out;
+		}
+		M_MatrixMulv_CSR(A, p, q);
+		if ((pq = Dot(p,q,n)) == 0.0) {
+			AG_SetError("CG: Breakdown at iteration %u", iter);
+			goto out;
+		}
+		alpha = rz / pq;
+		for (i = 0; i < n; i++) {
+			x[i] += alpha*p[i];
+			r[i] -= alpha*q[i];
+		}
+		resid = Norm(r,n) / bNorm;
+		iter++;
+
+		Precond(P, r, z, n);
+		rzNew = Dot(r,z,n);
+		beta = rzNew / rz;
+		rz = rzNew;
+		for (i = 0; i < n; i++)
+			p[i] = z[i] + beta*p[i];
+	}
+	rv = 0;
+out:
+	SetStats(stats, iter, resid);
+	Free(mem);
+	return (rv);
+}
+
+/*
+ * Solve Ax=b for a general A using the right-preconditioned BiCGSTAB
+ * method (see M_SolveCG() for arguments).
+ */
+int
+M_SolveBiCGSTAB(const M_MatrixCSR *A, const M_Precond *P, const M_Real *b,
+    M_Real *x, M_Real tol, Uint maxIter, M_IterStats *stats)
+{
+	const Uint n = A->m;
+	M_Real *mem, *r, *rt, *p, *v, *s, *t, *ph, *sh;
+	M_Real bNorm, resid, rho, rhoPrev = 1.0, alpha = 1.0, omega = 1.0;
+	M_Real beta, tt;
+	Uint i, iter = 0;
+	int rv = -1;
+
+	if ((mem = AllocVectors(n, 8)) == NULL) {
+		return (-1);
+	}
+	r = &mem[0];
+	rt = &mem[n];
+	p = &mem[2*n];
+	v = &mem[3*n];
+	s = &mem[4*n];
+	t = &mem[5*n];
+	ph = &mem[6*n];
+	sh = &mem[7*n];
+
+	if ((bNorm = Norm(b,n)) == 0.0) {
+		memset(x, 0, n*sizeof(M_Real));
+		SetStats(stats, 0, 0.0);
+		Free(mem);
+		return (0);
+	}
+	Residual(A, b, x, r);
+	resid = Norm(r,n) / bNorm;
+	memcpy(rt, r, n*sizeof(M_Real));
+	memset(p, 0, n*sizeof(M_Real));
+	memset(v, 0, n*sizeof(M_Real));
+
+	while (resid > tol) {
+		if (iter >= maxIter) {
+			AG_SetError("BiCGSTAB: No convergence in %u iterations "
+			            "(residual %g)", iter, (double)resid);
+			goto out;
+		}
+		if ((rho = Dot(rt,r,n)) == 0.0 || omega == 0.0) {
+			AG_SetError("BiCGSTAB: Breakdown at iteration %u", iter);
+			goto out;
+		}
+		beta = (rho/rhoPrev) * (alpha/omega);
+		for (i = 0; i < n; i++) {
+			p[i] = r[i] + beta*(p[i] - omega*v[i]);
+		}
+		Precond(P, p, ph, n);
+		M_MatrixMulv_CSR(A, ph, v);
+		if ((tt = Dot(rt,v,n)) == 0.0) {
+			AG_SetError("BiCGSTAB: Breakdown at iteration %u", iter);
+			goto out;
+		}
+		alpha = rho / tt;
+		for (i = 0; i < n; i++) {
+			s[i] = r[i] - alpha*v[i];
+		}
+		iter++;
+		if (Norm(s,n) / bNorm <= tol) {
+			for (i = 0; i < n; i++) {
+				x[i] += alpha*ph[i];
+			}
+			memcpy(r, s, n*sizeof(M_Real));
+			resid = Norm(r,n) / bNorm;
+			break;
+		}
+		Precond(P, s, sh, n);
+		M_MatrixMulv_CSR(A, sh, t);
+		tt = Dot(t,t,n);
+		omega = (tt != 0.0) ? Dot(t,s,n) / tt : 0.0;
+		for (i = 0; i < n; i++) {
+			x[i] += alpha*ph[i] + omega*sh[i];
+			r[i] = s[i] - omega*t[i];
+		}
+		resid = Norm(r,n) / bNorm;
+		rhoPrev = rho;
+	}
+	rv = 0;
+out:
+	SetStats(stats, iter, resid);
+	Free(mem);
+	return (rv);
+}
+
+/*
+ * Solve Ax=b for a general A using the right-preconditioned GMRES method,
+ * restarted every m iterations (see M_SolveCG() for other arguments). The
+ * Krylov basis takes (m+1)*n entries of memory.
+ */
+int
+M_SolveGMRES(const M_MatrixCSR *A, const M_Precond *P, const M_Real *b,
+    M_Real *x, Uint m, M_Real tol, Uint maxIter, M_IterStats *stats)
+{
+	const Uint n = A->m;
+	M_Real *V = NULL, *H = NULL, *w, *z, *cs, *sn, *g, *y;
+	M_Real bNorm, beta, resid, h, d, tmp;
+	Uint i, j, k, iter = 0;
+	int rv = -1;
+
+	if (m == 0) {
+		m = M_GMRES_RESTART_DEFAULT;
+	}
+	if ((V = AllocVectors(n, m+3)) == NULL ||
+	    (H = AllocVectors(m+1, m+4)) == NULL) {
+		goto out_free;
+	}
+	w = &V[(AG_Size)(m+1)*n];		/* Work vectors */
+	z = &V[(AG_Size)(m+2)*n];
+	cs = &H[(m+1)*m];			/* Givens rotations */
+	sn = &cs[m+1];
+	g = &sn[m+1];				/* Rotated residual */
+	y = &g[m+1];
+
+	if ((bNorm = Norm(b,n)) == 0.0) {
+		memset(x, 0, n*sizeof(M_Real));
+		resid = 0.0;
+		rv = 0;
+		goto out;
+	}
+	for (;;) {
+		Residual(A, b, x, &V[0]);
+		beta = Norm(&V[0], n);
+		if ((resid = beta / bNorm) <= tol) {
+			rv = 0;
+			break;
+		}
+		if (iter >= maxIter) {
+			AG_SetError("GMRES: No convergence in %u iterations "
+			            "(residual %g)", iter, (double)resid);
+			break;
+		}
+		for (i = 0; i < n; i++) {
+			V[i] /= beta;
+		}
+		memset(g, 0, (m+1)*sizeof(M_Real));
+		g[0] = beta;
+
+		/* Arnoldi process with modified Gram-Schmidt. */
+		for (j = 0; j < m && iter < maxIter; ) {
+			M_Real *vj = &V[(AG_Size)j*n];
+
+			Precond(P, vj, z, n);
+			M_MatrixMulv_CSR(A, z, w);
+			for (k = 0; k <= j; k++) {
+				const M_Real *vk = &V[(AG_Size)k*n];
+
+				h = Dot(w, vk, n);
+				H[k*m + j] = h;
+				for (i = 0; i < n; i++)
+					w[i] -= h*vk[i];
+			}
+			h = Norm(w,n);
+			H[(j+1)*m + j] = h;
+			if (h != 0.0) {
+				M_Real *vNext = &V[(AG_Size)(j+1)*n];
+
+				for (i = 0; i < n; i++)
+					vNext[i] = w[i] / h;
+			}
+
+			/* Reduce H to upper triangular form. */
+			for (k = 0; k < j; k++) {
+				tmp = cs[k]*H[k*m + j] + sn[k]*H[(k+1)*m + j];
+				H[(k+1)*m + j] = -sn[k]*H[k*m + j] +
+				                 cs[k]*H[(k+1)*m + j];
+				H[k*m + j] = tmp;
+			}
+			d = M_Sqrt(H[j*m + j]*H[j*m + j] + h*h);
+			if (d == 0.0) {
+				AG_SetError("GMRES: Breakdown at iteration %u",
+				    iter);
+				goto out;
+			}
+			cs[j] = H[j*m + j] / d;
+			sn[j] = h / d;
+			H[j*m + j] = d;
+			H[(j+1)*m + j] = 0.0;
+			g[j+1] = -sn[j]*g[j];
+			g[j] = cs[j]*g[j];
+
+			iter++;
+			j++;
+			if (M_Fabs(g[j]) / bNorm <= tol || h == 0.0)
+				break;
+		}
+
+		/* Solve Hy = g and update x += M^-1 (V y). */
+		for (k = j; k > 0; k--) {
+			const Uint row = k-1;
+
+			tmp = g[row];
+			for (i = row+1; i < j; i++) {
+				tmp -= H[row*m + i]*y[i];
+			}
+			y[row] = tmp / H[row*m + row];
+		}
+		memset(w, 0, n*sizeof(M_Real));
+		for (k = 0; k < j; k++) {
+			const M_Real *vk = &V[(AG_Size)k*n];
+
+			for (i = 0; i < n; i++)
+				w[i] += y[k]*vk[i];
+		}
+		Precond(P, w, z, n);
+		for (i = 0; i < n; i++)
+			x[i] += z[i];
+	}
+out:
+	SetStats(stats, iter, resid);
+out_free:
+	Free(H);
+	Free(V);
+	return (rv);
+}
@@ -58,7 +58,8 @@ M_MatviewSetMatrix(M_Matview *mv, M_Matrix *M)
 {
 	M_MatrixFPU *MFPU = (void *)M;
 
-	if (strcmp(M->ops->name, "scalar") != 0) {
+	if (strcmp(M->ops->name, "scalar") != 0 &&
+	    strcmp(M->ops->name, "blocked") != 0) {
 		AG_TextError("Cannot display %s matrices", M->ops->name);
 		return;
 	}
@@ -94,6 +94,8 @@ M_MergeSort(void *base, AG_Size nmemb, AG_Size size,
 		AG_SetError("size < %d/2", (int)PSIZE);
 		return (-1);
 	}
+	if (nmemb == 0)
+		return (0);
 
 	/*
 	 * XXX
@@ -136,120 +136,16 @@ M_PointSetCopy3i(M_PointSet3i *D, const M_PointSet3i *S)
 	return (0);
 }
 
-/*
- * Point comparison routines for sort.
- */
-static M_Real
-ComparePoints2_XY(const void *_Nonnull p1, const void *_Nonnull p2)
-{
-	const M_Vector2 *v1 = p1, *v2 = p2;
-	return (Fabs(v2->x - v1->x) <= M_MACHEP) ?
-	       (v2->y - v1->y) : (v1->x - v2->x);
-}
-static M_Real
-ComparePoints2_YX(const void *_Nonnull p1, const void *_Nonnull p2)
-{
-	const M_Vector2 *v1 = p1, *v2 = p2;
-	return (Fabs(v2->y - v1->y) <= M_MACHEP) ?
-	       (v2->x - v1->x) : (v1->y - v2->y);
-}
-static M_Real
-ComparePoints3_XYZ(const void *_Nonnull p1, const void *_Nonnull p2)
-{
-	const M_Vector3 *v1 = p1, *v2 = p2;
-	return (Fabs(v2->x - v1->x) <= M_MACHEP) ?
-	       (Fabs(v2->y - v1->y) <= M_MACHEP) ?
-	       (v2->z - v1->z) :
-	       (v1->y - v2->y) :
-	       (v1->x - v2->x);
-}
-static M_Real
-ComparePoints3_XZY(const void *_Nonnull p1, const void *_Nonnull p2)
-{
-	const M_Vector3 *v1 = p1, *v2 = p2;
-	return (Fabs(v2->x - v1->x) <= M_MACHEP) ?
-	       (Fabs(v2->z - v1->z) <= M_MACHEP) ?
-	       (v2->y - v1->y) :
-	       (v1->z - v2->z) :
-	       (v1->x - v2->x);
-}
-static M_Real
-ComparePoints3_YXZ(const void *_Nonnull p1, const void *_Nonnull p2)
-{
-	const M_Vector3 *v1 = p1, *v2 = p2;
-	return (Fabs(v2->y - v1->y) <= M_MACHEP) ?
-	       (Fabs(v2->x - v1->x) <= M_MACHEP) ?
-	       (v2->z - v1->z) :
-	       (v1->x - v2->x) :
-	       (v1->y - v2->y);
-}
-static M_Real
-ComparePoints3_YZX(const void *_Nonnull p1, const void *_Nonnull p2)
-{
-	const M_Vector3 *v1 = p1, *v2 = p2;
-	return (Fabs(v2->y - v1->y) <= M_MACHEP) ?
-	       (Fabs(v2->z - v1->z) <= M_MACHEP) ?
-	       (v2->x - v1->x) :
-	       (v1->z - v2->z) :
-	       (v1->y - v2->y);
-}
-static M_Real
-ComparePoints3_ZXY(const void *_Nonnull p1, const void *_Nonnull p2)
-{
-	const M_Vector3 *v1 = p1, *v2 = p2;
-	return (Fabs(v2->z - v1->z) <= M_MACHEP) ?
-	       (Fabs(v2->x - v1->z) <= M_MACHEP) ?
-	       (v2->y - v1->y) :
-	       (v1->x - v2->x) :
-	       (v1->z - v2->z);
-}
-static M_Real
-ComparePoints3_ZYX(const void *_Nonnull p1, const void *_Nonnull p2)
-{
-	const M_Vector3 *v1 = p1, *v2 = p2;
-	return (Fabs(v2->z - v1->z) <= M_MACHEP) ?
-	       (Fabs(v2->y - v1->y) <= M_MACHEP) ?
-	       (v2->x - v1->x) :
-	       (v1->y - v2->y) :
-	       (v1->z - v2->z);
-}
-
 /* Sort points in R2 by their X or Y coordinates. */
 void
 M_PointSetSort2(M_PointSet2 *P, enum m_point_set_sort_mode2 mode)
 {
-	switch (mode) {
-	case M_POINT_SET_SORT_XY:
-		M_QSort(P->p, P->n, sizeof(M_Vector2), ComparePoints2_XY);
-		break;
-	case M_POINT_SET_SORT_YX:
-		M_QSort(P->p, P->n, sizeof(M_Vector2), ComparePoints2_YX);
-		break;
-	}
+	M_SortVector2(P->p, P->n, mode);
 }
 
 /* Sort points in R3 by their X, Y or Z coordinates. */
 void
 M_PointSetSort3(M_PointSet3 *P, enum m_point_set_sort_mode3 mode)
 {
-	switch (mode) {
-	case M_POINT_SET_SORT_XYZ:
-		M_QSort(P->p, P->n, sizeof(M_Vector3), ComparePoints3_XYZ);
-		break;
-	case M_POINT_SET_SORT_XZY:
-		M_QSort(P->p, P->n, sizeof(M_Vector3), ComparePoints3_XZY);
-		break;
-	case M_POINT_SET_SORT_YXZ:
-		M_QSort(P->p, P->n, sizeof(M_Vector3), ComparePoints3_YXZ);
-		break;
-	case M_POINT_SET_SORT_YZX:
-		M_QSort(P->p, P->n, sizeof(M_Vector3), ComparePoints3_YZX);
-		break;
-	case M_POINT_SET_SORT_ZXY:
-		M_QSort(P->p, P->n, sizeof(M_Vector3), ComparePoints3_ZXY);
-		break;
-	case M_POINT_SET_SORT_ZYX:
-		M_QSort(P->p, P->n, sizeof(M_Vector3), ComparePoints3_ZYX);
-		break;
-	}
+	M_SortVector3(P->p, P->n, mode);
 }
@@ -0,0 +1,696 @@
+/*
+ * Copyright (c) 2026 Julien Nadeau Carriere <vedge@csoft.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Sorting routines specialized for integers, floating-point numbers and
+ * points, and a parallel merge sort for arbitrary elements.
+ *
+ * Fixed-width keys are sorted with an LSD radix sort (one pass per byte,
+ * skipping passes where all keys share the same byte). Points, and short
+ * arrays of any type, use an introsort with an inlined comparison. Large
+ * arrays are split into one chunk per thread, and the sorted chunks are
+ * merged in log2(nThreads) rounds, with each merge split across all
+ * threads by binary search (so every round uses every thread).
+ */
+
+#include <agar/core/core.h>
+#include <agar/math/m.h>
+
+#include <string.h>
+
+#define SORT_INS_MAX      16		/* Insertion sort below this size */
+#define SORT_RADIX_MIN    256		/* Radix sort from this size */
+#define SORT_PARALLEL_MIN 65536		/* Sort in parallel from this size */
+#define SORT_CHUNK_MIN    16384		/* Minimum elements per thread */
+#define SORT_THREADS_MAX  32		/* Maximum threads per sort */
+
+typedef struct sort_ctx {
+	AG_Size size;					/* Element size */
+	int (*_Nullable cmp)(const void *_Nonnull,	/* Comparison function */
+	                     const void *_Nonnull);
+} SortCtx;
+
+/* Sort routines for one element type. */
+typedef struct sort_ops {
+	/* Sort in place (or NULL). */
+	void (*_Nullable SortInPlace)(void *_Nonnull, AG_Size);
+
+	/* Sort using a scratch array of the same size (or NULL). */
+	int (*_Nullable Sort)(void *_Nonnull, void *_Nonnull, AG_Size,
+	                      const SortCtx *_Nonnull);
+
+	/* Merge two sorted runs into dst (stable). */
+	void (*_Nonnull Merge)(void *_Nonnull, const void *_Nonnull, AG_Size,
+	                       const void *_Nonnull, AG_Size,
+			       const SortCtx *_Nonnull);
+
+	/*
+	 * Return the number of elements of the first run which precede
+	 * output position k in a merge.
+	 */
+	AG_Size (*_Nonnull CoRank)(AG_Size, const void *_Nonnull, AG_Size,
+	                           const void *_Nonnull, AG_Size,
+				   const SortCtx *_Nonnull);
+} SortOps;
+
+/* Chunk sort or merge job for one thread. */
+typedef struct sort_job {
+	const SortOps *_Nonnull ops;
+	const SortCtx *_Nonnull ctx;
+	Uint8 *_Nonnull dst;		/* Array (sort) or output run (merge) */
+	Uint8 *_Nullable tmp;		/* Scratch array (sort) */
+	const Uint8 *_Nullable a;	/* First run (merge) */
+	const Uint8 *_Nullable b;	/* Second run (merge) */
+	AG_Size n;			/* Elements (sort) */
+	AG_Size na, nb;			/* Run lengths (merge) */
+	AG_Size k0, k1;			/* Output range (merge) */
+	int merge;			/* Merge (1) or sort (0) */
+	int rv;				/* Return value of sort */
+} SortJob;
+
+static Uint sortThreads = 0;		/* Maximum threads (0 = auto) */
+
+/*
+ * Instantiate an introsort, a stable merge and a merge partitioning
+ * routine for elements of type TYPE ordered by LESS(x,y).
+ */
+#define SORT_SWAP(TYPE, x, y) { TYPE t_ = (x); (x) = (y); (y) = t_; }
+
+#define SORT_TEMPLATE(NAME, TYPE, LESS)					\
+static int								\
+IsSorted_##NAME(const TYPE *_Nonnull a, AG_Size n)			\
+{									\
+	AG_Size i;							\
+									\
+	for (i = 1; i < n; i++) {					\
+		if (LESS(a[i], a[i-1]))					\
+			return (0);					\
+	}								\
+	return (1);							\
+}									\
+									\
+static void								\
+InsertionSort_##NAME(TYPE *_Nonnull a, AG_Size n)			\
+{									\
+	AG_Size i, j;							\
+	TYPE t;								\
+									\
+	for (i = 1; i < n; i++) {					\
+		t = a[i];						\
+		for (j = i; j > 0 && LESS(t, a[j-1]); j--) {		\
+			a[j] = a[j-1];					\
+		}							\
+		a[j] = t;						\
+	}								\
+}									\
+									\
+static void								\
+SiftDown_##NAME(TYPE *_Nonnull a, AG_Size i, AG_Size n)		\
+{									\
+	TYPE t = a[i];							\
+	AG_Size c;							\
+									\
+	while ((c = 2*i + 1) < n) {					\
+		if (c+1 < n && LESS(a[c], a[c+1])) {			\
+			c++;						\
+		}							\
+		if (!LESS(t, a[c])) {					\
+			break;						\
+		}							\
+		a[i] = a[c];						\
+		i = c;							\
+	}								\
+	a[i] = t;							\
+}									\
+									\
+static void								\
+HeapSort_##NAME(TYPE *_Nonnull a, AG_Size n)				\
+{									\
+	AG_Size i;							\
+									\
+	for (i = n/2; i > 0; i--) {					\
+		SiftDown_##NAME(a, i-1, n);				\
+	}								\
+	for (i = n-1; i > 0; i--) {					\
+		SORT_SWAP(TYPE, a[0], a[i]);				\
+		SiftDown_##NAME(a, 0, i);				\
+	}								\
+}									\
+									\
+static void								\
+IntroSort_##NAME(TYPE *_Nonnull a, AG_Size n, int depth)		\
+{									\
+	AG_Offset i, j;							\
+	AG_Size m;							\
+	TYPE p;								\
+									\
+	while (n > SORT_INS_MAX) {					\
+		if (depth-- == 0) {					\
+			HeapSort_##NAME(a, n);				\
+			return;						\
+		}							\
+		m = n/2;						\
+		if (LESS(a[m], a[0]))					\
+			SORT_SWAP(TYPE, a[m], a[0]);			\
+		if (LESS(a[n-1], a[m])) {				\
+			SORT_SWAP(TYPE, a[n-1], a[m]);			\
+			if (LESS(a[m], a[0]))				\
+				SORT_SWAP(TYPE, a[m], a[0]);		\
+		}							\
+		SORT_SWAP(TYPE, a[0], a[m]);				\
+		p = a[0];						\
+		i = -1;							\
+		j = (AG_Offset)n;					\
+		for (;;) {						\
+			do { i++; } while (LESS(a[i], p));		\
+			do { j--; } while (LESS(p, a[j]));		\
+			if (i >= j) {					\
+				break;					\
+			}						\
+			SORT_SWAP(TYPE, a[i], a[j]);			\
+		}							\
+		m = (AG_Size)j + 1;					\
+		if (m < n-m) {						\
+			IntroSort_##NAME(a, m, depth);			\
+			a += m;						\
+			n -= m;						\
+		} else {						\
+			IntroSort_##NAME(&a[m], n-m, depth);		\
+			n = m;						\
+		}							\
+	}								\
+	InsertionSort_##NAME(a, n);					\
+}									\
+									\
+static void								\
+SortInPlace_##NAME(void *_Nonnull base, AG_Size n)			\
+{									\
+	AG_Size i;							\
+	int depth = 0;							\
+									\
+	if (IsSorted_##NAME(base, n)) {					\
+		return;							\
+	}								\
+	for (i = n; i > 1; i >>= 1) {					\
+		depth += 2;						\
+	}								\
+	IntroSort_##NAME(base, n, depth);				\
+}									\
+									\
+static void								\
+Merge_##NAME(void *_Nonnull pDst, const void *_Nonnull pA, AG_Size na,	\
+    const void *_Nonnull pB, AG_Size nb, const SortCtx *_Nonnull ctx)	\
+{									\
+	TYPE *dst = pDst;						\
+	const TYPE *a = pA, *aEnd = a + na;				\
+	const TYPE *b = pB, *bEnd = b + nb;				\
+									\
+	while (a < aEnd && b < bEnd) {					\
+		*dst++ = LESS(*b, *a) ? *b++ : *a++;			\
+	}								\
+	while (a < aEnd) { *dst++ = *a++; }				\
+	while (b < bEnd) { *dst++ = *b++; }				\
+}									\
+									\
+static AG_Size								\
+CoRank_##NAME(AG_Size k, const void *_Nonnull pA, AG_Size na,		\
+    const void *_Nonnull pB, AG_Size nb, const SortCtx *_Nonnull ctx)	\
+{									\
+	const TYPE *a = pA, *b = pB;					\
+	AG_Size lo = (k > nb) ? k - nb : 0;				\
+	AG_Size hi = MIN(k, na), i;					\
+									\
+	while (lo < hi) {						\
+		i = lo + (hi - lo)/2;					\
+		if (!LESS(b[k-i-1], a[i])) {				\
+			lo = i+1;					\
+		} else {						\
+			hi = i;						\
+		}							\
+	}								\
+	return (lo);							\
+}
+
+/*
+ * Instantiate an LSD radix sort of elements of type TYPE by the NBYTES-byte
+ * unsigned key KEY(x), for a type already instantiated by SORT_TEMPLATE().
+ */
+#define RADIX_TEMPLATE(NAME, TYPE, KTYPE, NBYTES, KEY)			\
+static int								\
+RadixSort_##NAME(void *_Nonnull base, void *_Nonnull tmp, AG_Size n,	\
+    const SortCtx *_Nonnull ctx)					\
+{									\
+	AG_Size count[NBYTES][256], sum, c, i;				\
+	TYPE *src = base, *dst = tmp, *t;				\
+	KTYPE k;							\
+	int b, shift;							\
+									\
+	if (IsSorted_##NAME(base, n)) {					\
+		return (0);						\
+	}								\
+	memset(count, 0, sizeof(count));				\
+	for (i = 0; i < n; i++) {					\
+		k = KEY(src[i]);					\
+		for (b = 0; b < NBYTES; b++)				\
+			count[b][(k >> (b*8)) & 0xff]++;		\
+	}								\
+	for (b = 0; b < NBYTES; b++) {					\
+		AG_Size *cnt = count[b];				\
+									\
+		shift = b*8;						\
+		if (cnt[(KEY(src[0]) >> shift) & 0xff] == n) {		\
+			continue;			/* Trivial pass */ \
+		}							\
+		for (sum = 0, i = 0; i < 256; i++) {			\
+			c = cnt[i];					\
+			cnt[i] = sum;					\
+			sum += c;					\
+		}							\
+		for (i = 0; i < n; i++) {				\
+			dst[cnt[(KEY(src[i]) >> shift) & 0xff]++] = src[i]; \
+		}							\
+		t = src;						\
+		src = dst;						\
+		dst = t;						\
+	}								\
+	if (src != base) {						\
+		memcpy(base, src, n*sizeof(TYPE));			\
+	}								\
+	return (0);							\
+}
+
+/*
+ * Map floating-point numbers to unsigned keys in the same order (with -0
+ * before +0, and NaNs at either end according to their sign).
+ */
+static __inline__ Uint32
+FloatKey(float f)
+{
+	union { float f; Uint32 u; } v;
+
+	v.f = f;
+	return (v.u & 0x80000000) ? ~v.u : (v.u | 0x80000000);
+}
+#ifdef AG_HAVE_64BIT
+static __inline__ Uint64
+DoubleKey(double d)
+{
+	union { double d; Uint64 u; } v;
+
+	v.d = d;
+	return (v.u >> 63) ? ~v.u : (v.u | ((Uint64)1 << 63));
+}
+#endif
+
+#define LESS_SCALAR(x,y) ((x) < (y))
+#define LESS_FLOAT(x,y)  (FloatKey(x) < FloatKey(y))
+#define LESS_DOUBLE(x,y) (DoubleKey(x) < DoubleKey(y))
+
+#define KEY_UINT32(x)	(x)
+#define KEY_SINT32(x)	((Uint32)(x) ^ 0x80000000)
+#define KEY_UINT64(x)	(x)
+#define KEY_SINT64(x)	((Uint64)(x) ^ ((Uint64)1 << 63))
+
+/*
+ * Point orderings, equivalent to the comparison functions formerly used by
+ * M_PointSetSort2() and M_PointSetSort3(): components which are equal up to
+ * machine precision are skipped, and the last component is descending.
+ */
+#define LESS_PT2(P,S,x,y)						\
+	(((y).P - (x).P > M_MACHEP) ? 1 :				\
+	 ((x).P - (y).P > M_MACHEP) ? 0 :				\
+	 ((y).S < (x).S))
+#define LESS_PT3(P,S,T,x,y)						\
+	(((y).P - (x).P > M_MACHEP) ? 1 :				\
+	 ((x).P - (y).P > M_MACHEP) ? 0 :				\
+	 ((y).S - (x).S > M_MACHEP) ? 1 :				\
+	 ((x).S - (y).S > M_MACHEP) ? 0 :				\
+	 ((y).T < (x).T))
+
+#define LESS_XY(a,b)	LESS_PT2(x,y,a,b)
+#define LESS_YX(a,b)	LESS_PT2(y,x,a,b)
+#define LESS_XYZ(a,b)	LESS_PT3(x,y,z,a,b)
+#define LESS_XZY(a,b)	LESS_PT3(x,z,y,a,b)
+#define LESS_YXZ(a,b)	LESS_PT3(y,x,z,a,b)
+#define LESS_YZX(a,b)	LESS_PT3(y,z,x,a,b)
+#define LESS_ZXY(a,b)	LESS_PT3(z,x,y,a,b)
+#define LESS_ZYX(a,b)	LESS_PT3(z,y,x,a,b)
+
+SORT_TEMPLATE(Uint32, Uint32, LESS_SCALAR)
+SORT_TEMPLATE(Sint32, Sint32, LESS_SCALAR)
+SORT_TEMPLATE(Float, float, LESS_FLOAT)
+RADIX_TEMPLATE(Uint32, Uint32, Uint32, 4, KEY_UINT32)
+RADIX_TEMPLATE(Sint32, Sint32, Uint32, 4, KEY_SINT32)
+RADIX_TEMPLATE(Float, float, Uint32, 4, FloatKey)
+#ifdef AG_HAVE_64BIT
+SORT_TEMPLATE(Uint64, Uint64, LESS_SCALAR)
+SORT_TEMPLATE(Sint64, Sint64, LESS_SCALAR)
+SORT_TEMPLATE(Double, double, LESS_DOUBLE)
+RADIX_TEMPLATE(Uint64, Uint64, Uint64, 8, KEY_UINT64)
+RADIX_TEMPLATE(Sint64, Sint64, Uint64, 8, KEY_SINT64)
+RADIX_TEMPLATE(Double, double, Uint64, 8, DoubleKey)
+#endif
+SORT_TEMPLATE(XY, M_Vector2, LESS_XY)
+SORT_TEMPLATE(YX, M_Vector2, LESS_YX)
+SORT_TEMPLATE(XYZ, M_Vector3, LESS_XYZ)
+SORT_TEMPLATE(XZY, M_Vector3, LESS_XZY)
+SORT_TEMPLATE(YXZ, M_Vector3, LESS_YXZ)
+SORT_TEMPLATE(YZX, M_Vector3, LESS_YZX)
+SORT_TEMPLATE(ZXY, M_Vector3, LESS_ZXY)
+SORT_TEMPLATE(ZYX, M_Vector3, LESS_ZYX)
+
+#define SORT_OPS_RADIX(NAME) \
+	{ SortInPlace_##NAME, RadixSort_##NAME, Merge_##NAME, CoRank_##NAME }
+#define SORT_OPS(NAME) \
+	{ SortInPlace_##NAME, NULL, Merge_##NAME, CoRank_##NAME }
+
+static const SortOps sortOpsUint32 = SORT_OPS_RADIX(Uint32);
+static const SortOps sortOpsSint32 = SORT_OPS_RADIX(Sint32);
+static const SortOps sortOpsFloat = SORT_OPS_RADIX(Float);
+#ifdef AG_HAVE_64BIT
+static const SortOps sortOpsUint64 = SORT_OPS_RADIX(Uint64);
+static const SortOps sortOpsSint64 = SORT_OPS_RADIX(Sint64);
+static const SortOps sortOpsDouble = SORT_OPS_RADIX(Double);
+#endif
+static const SortOps sortOpsVector2[] = {
+	SORT_OPS(XY),			/* M_POINT_SET_SORT_XY */
+	SORT_OPS(YX)			/* M_POINT_SET_SORT_YX */
+};
+static const SortOps sortOpsVector3[] = {
+	SORT_OPS(XYZ),			/* M_POINT_SET_SORT_XYZ */
+	SORT_OPS(XZY),			/* M_POINT_SET_SORT_XZY */
+	SORT_OPS(YXZ),			/* M_POINT_SET_SORT_YXZ */
+	SORT_OPS(YZX),			/* M_POINT_SET_SORT_YZX */
+	SORT_OPS(ZXY),			/* M_POINT_SET_SORT_ZXY */
+	SORT_OPS(ZYX)			/* M_POINT_SET_SORT_ZYX */
+};
+
+/*
+ * Generic routines for M_ParallelSort(), using a comparison function.
+ */
+static int
+MergeSortGeneric(void *base, void *tmp, AG_Size n, const SortCtx *ctx)
+{
+	return M_MergeSort(base, n, ctx->size, ctx->cmp);
+}
+
+static void
+MergeGeneric(void *pDst, const void *pA, AG_Size na, const void *pB,
+    AG_Size nb, const SortCtx *ctx)
+{
+	const AG_Size size = ctx->size;
+	Uint8 *dst = pDst;
+	const Uint8 *a = pA, *b = pB;
+
+	while (na > 0 && nb > 0) {
+		if (ctx->cmp(b, a) < 0) {
+			memcpy(dst, b, size);
+			b += size;
+			nb--;
+		} else {
+			memcpy(dst, a, size);
+			a += size;
+			na--;
+		}
+		dst += size;
+	}
+	memcpy(dst, a, na*size);
+	memcpy(dst + na*size, b, nb*size);
+}
+
+static AG_Size
+CoRankGeneric(AG_Size k, const void *pA, AG_Size na, const void *pB,
+    AG_Size nb, const SortCtx *ctx)
+{
+	const AG_Size size = ctx->size;
+	const Uint8 *a = pA, *b = pB;
+	AG_Size lo = (k > nb) ? k - nb : 0;
+	AG_Size hi = MIN(k, na), i;
+
+	while (lo < hi) {
+		i = lo + (hi - lo)/2;
+		if (ctx->cmp(&b[(k-i-1)*size], &a[i*size]) >= 0) {
+			lo = i+1;
+		} else {
+			hi = i;
+		}
+	}
+	return (lo);
+}
+
+static const SortOps sortOpsGeneric = {
+	NULL,
+	MergeSortGeneric,
+	MergeGeneric,
+	CoRankGeneric
+};
+
+/*
+ * Set the maximum number of threads used by a single sort
+ * (0 = one per processor, 1 = no threads).
+ */
+void
+M_SortSetThreads(Uint nThreads)
+{
+	sortThreads = nThreads;
+}
+
+/* Return the number of chunks (a power of two) to sort n elements. */
+static Uint
+GetSortChunks(AG_Size n)
+{
+	Uint nChunks = 1;
+#ifdef AG_THREADS
+	Uint nThreads;
+
+	if (n < SORT_PARALLEL_MIN) {
+		return (1);
+	}
+	nThreads = (sortThreads > 0) ? sortThreads : AG_GetProcessorCount();
+	nThreads = MIN(nThreads, SORT_THREADS_MAX);
+	while (nChunks*2 <= nThreads && n/(nChunks*2) >= SORT_CHUNK_MIN)
+		nChunks <<= 1;
+#endif
+	return (nChunks);
+}
+
+/* Sort one chunk, or merge one part of two runs. */
+static void *_Nullable
+SortWorker(void *_Nonnull p)
+{
+	SortJob *job = p;
+	const SortOps *ops = job->ops;
+	const AG_Size size = job->ctx->size;
+	AG_Size i0, i1;
+
+	if (job->merge) {
+		i0 = ops->CoRank(job->k0, job->a, job->na, job->b, job->nb,
+		    job->ctx);
+		i1 = ops->CoRank(job->k1, job->a, job->na, job->b, job->nb,
+		    job->ctx);
+		ops->Merge(&job->dst[job->k0*size],
+		    &job->a[i0*size], i1 - i0,
+		    &job->b[(job->k0 - i0)*size], (job->k1 - i1) - (job->k0 - i0),
+		    job->ctx);
+	} else if (ops->Sort != NULL) {
+		job->rv = ops->Sort(job->dst, job->tmp, job->n, job->ctx);
+	} else {
+		ops->SortInPlace(job->dst, job->n);
+	}
+	return (NULL);
+}
+
+/*
+ * Sort n elements in nChunks chunks (a power of two), then merge the
+ * chunks pairwise, alternating between base and tmp.
+ */
+static int
+SortParallel(const SortOps *_Nonnull ops, const SortCtx *_Nonnull ctx,
+    void *_Nonnull base, void *_Nonnull tmp, AG_Size n, Uint nChunks)
+{
+	SortJob jobs[SORT_THREADS_MAX];
+	AG_Size bounds[SORT_THREADS_MAX+1];
+	const AG_Size size = ctx->size;
+	Uint8 *src = base, *dst = tmp, *t;
+	Uint i, w;
+
+	for (i = 0; i < nChunks; i++) {
+		bounds[i] = (n / nChunks) * i;
+	}
+	bounds[nChunks] = n;
+
+	for (i = 0; i < nChunks; i++) {
+		SortJob *job = &jobs[i];
+
+		memset(job, 0, sizeof(SortJob));
+		job->ops = ops;
+		job->ctx = ctx;
+		job->dst = &src[bounds[i]*size];
+		job->tmp = &dst[bounds[i]*size];
+		job->n = bounds[i+1] - bounds[i];
+	}
+	AG_RunJobs(SortWorker, jobs, sizeof(SortJob), nChunks);
+	for (i = 0; i < nChunks; i++) {
+		if (jobs[i].rv != 0)
+			return (-1);
+	}
+
+	for (w = 1; w < nChunks; w <<= 1) {
+		for (i = 0; i < nChunks; i++) {
+			SortJob *job = &jobs[i];
+			const Uint c = (i / (2*w)) * (2*w);
+			const Uint part = i % (2*w);
+			const AG_Size lo = bounds[c];
+			const AG_Size mid = bounds[c+w];
+			const AG_Size len = bounds[c + 2*w] - lo;
+
+			job->merge = 1;
+			job->a = &src[lo*size];
+			job->na = mid - lo;
+			job->b = &src[mid*size];
+			job->nb = bounds[c + 2*w] - mid;
+			job->dst = &dst[lo*size];
+			job->k0 = (len / (2*w)) * part;
+			job->k1 = (part == 2*w - 1) ? len :
+			          (len / (2*w)) * (part+1);
+		}
+		AG_RunJobs(SortWorker, jobs, sizeof(SortJob), nChunks);
+		t = src;
+		src = dst;
+		dst = t;
+	}
+	if (src != (Uint8 *)base) {
+		memcpy(base, src, n*size);
+	}
+	return (0);
+}
+
+/* Sort an array of a type with specialized routines. */
+static void
+SortTyped(const SortOps *_Nonnull ops, AG_Size size, void *_Nonnull base,
+    AG_Size n)
+{
+	SortCtx ctx;
+	void *tmp;
+	Uint nChunks;
+
+	nChunks = GetSortChunks(n);
+	if ((nChunks == 1 && (ops->Sort == NULL || n < SORT_RADIX_MIN)) ||
+	    (tmp = TryMalloc(n*size)) == NULL) {
+		ops->SortInPlace(base, n);
+		return;
+	}
+	ctx.size = size;
+	ctx.cmp = NULL;
+	if (nChunks > 1) {
+		SortParallel(ops, &ctx, base, tmp, n, nChunks);
+	} else {
+		ops->Sort(base, tmp, n, &ctx);
+	}
+	Free(tmp);
+}
+
+/* Sort an array of integers in ascending order. */
+void
+M_SortSint32(Sint32 *a, AG_Size n)
+{
+	SortTyped(&sortOpsSint32, sizeof(Sint32), a, n);
+}
+void
+M_SortUint32(Uint32 *a, AG_Size n)
+{
+	SortTyped(&sortOpsUint32, sizeof(Uint32), a, n);
+}
+#ifdef AG_HAVE_64BIT
+void
+M_SortSint64(Sint64 *a, AG_Size n)
+{
+	SortTyped(&sortOpsSint64, sizeof(Sint64), a, n);
+}
+void
+M_SortUint64(Uint64 *a, AG_Size n)
+{
+	SortTyped(&sortOpsUint64, sizeof(Uint64), a, n);
+}
+#endif
+
+/*
+ * Sort an array of floating-point numbers in ascending order (-0 sorts
+ * before +0, and NaNs are placed at the end, or at the beginning if their
+ * sign bit is set).
+ */
+void
+M_SortFloat(float *a, AG_Size n)
+{
+	SortTyped(&sortOpsFloat, sizeof(float), a, n);
+}
+#ifdef AG_HAVE_64BIT
+void
+M_SortDouble(double *a, AG_Size n)
+{
+	SortTyped(&sortOpsDouble, sizeof(double), a, n);
+}
+#endif
+
+/* Sort an array of points in R^2 (see M_PointSetSort2()). */
+void
+M_SortVector2(M_Vector2 *p, AG_Size n, enum m_point_set_sort_mode2 mode)
+{
+	SortTyped(&sortOpsVector2[mode], sizeof(M_Vector2), p, n);
+}
+
+/* Sort an array of points in R^3 (see M_PointSetSort3()). */
+void
+M_SortVector3(M_Vector3 *p, AG_Size n, enum m_point_set_sort_mode3 mode)
+{
+	SortTyped(&sortOpsVector3[mode], sizeof(M_Vector3), p, n);
+}
+
+/*
+ * Stable sort of n elements of the given size with a comparison function,
+ * like M_MergeSort(), using multiple threads for large arrays. The
+ * comparison function must be safe to call from multiple threads.
+ */
+int
+M_ParallelSort(void *base, AG_Size n, AG_Size size,
+    int (*cmp)(const void *, const void *))
+{
+	SortCtx ctx;
+	void *tmp;
+	Uint nChunks;
+	int rv;
+
+	if ((nChunks = GetSortChunks(n)) == 1) {
+		return M_MergeSort(base, n, size, cmp);
+	}
+	if ((tmp = TryMalloc(n*size)) == NULL) {
+		return (-1);
+	}
+	ctx.size = size;
+	ctx.cmp = cmp;
+	rv = SortParallel(&sortOpsGeneric, &ctx, base, tmp, n, nChunks);
+	Free(tmp);
+	return (rv);
+}
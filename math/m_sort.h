@@ -0,0 +1,21 @@
+/*	Public domain	*/
+/*
+ * Typed and parallel sorting routines.
+ */
+
+__BEGIN_DECLS
+void M_SortSint32(Sint32 *_Nonnull, AG_Size);
+void M_SortUint32(Uint32 *_Nonnull, AG_Size);
+void M_SortFloat(float *_Nonnull, AG_Size);
+#ifdef AG_HAVE_64BIT
+void M_SortSint64(Sint64 *_Nonnull, AG_Size);
+void M_SortUint64(Uint64 *_Nonnull, AG_Size);
+void M_SortDouble(double *_Nonnull, AG_Size);
+#endif
+void M_SortVector2(M_Vector2 *_Nonnull, AG_Size, enum m_point_set_sort_mode2);
+void M_SortVector3(M_Vector3 *_Nonnull, AG_Size, enum m_point_set_sort_mode3);
+
+int  M_ParallelSort(void *_Nonnull, AG_Size, AG_Size,
+                    int (*_Nonnull)(const void *_Nonnull, const void *_Nonnull));
+void M_SortSetThreads(Uint);
+__END_DECLS
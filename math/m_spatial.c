@@ -0,0 +1,1167 @@
+/*
+ * Copyright (c) 2026 Julien Nadeau Carriere <vedge@csoft.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Spatial indices for proximity, radius and ray queries.
+ *
+ * M_KDTree is a k-d tree over a set of points, built by recursive median
+ * splits on the axis of largest extent. M_BVH is a bounding volume
+ * hierarchy over the axis-aligned bounds of arbitrary primitives (line
+ * segments, triangles, polygons or user-defined), built using either a
+ * binned surface area heuristic or median splits. A BVH can be refit
+ * in linear time after its primitives have moved, without rebuilding.
+ */
+
+#include <agar/core/core.h>
+#include <agar/math/m.h>
+
+#include <string.h>
+
+#define BVH_BINS	16	/* Bins for SAH evaluation */
+#define BVH_LEAF_MAX	4	/* Maximum primitives per leaf */
+#define BVH_SAH_DEPTH	40	/* Use median splits below this depth */
+#define BVH_STACK	128	/* Size of traversal stacks */
+#define BVH_COST_TRAV	1.0	/* Cost of a traversal step (SAH) */
+
+typedef struct bvh_stack_ent {
+	M_Real t;		/* Distance to node (lower bound) */
+	Uint node;
+	Uint32 _pad;
+} BVH_StackEnt;
+
+/*
+ * Reorder idx[0..n-1] such that the element at k along the axis has
+ * all smaller elements before it and all larger elements after it.
+ */
+static void
+Select(const M_Real *_Nonnull c, Uint stride, Uint *_Nonnull idx, Uint n,
+    Uint k)
+{
+	long lo = 0, hi = (long)n - 1, i, j;
+	M_Real pivot;
+	Uint tmp;
+
+	while (lo < hi) {
+		pivot = c[idx[(lo+hi)/2]*stride];
+		i = lo;
+		j = hi;
+		do {
+			while (c[idx[i]*stride] < pivot) { i++; }
+			while (pivot < c[idx[j]*stride]) { j--; }
+			if (i <= j) {
+				tmp = idx[i];
+				idx[i] = idx[j];
+				idx[j] = tmp;
+				i++;
+				j--;
+			}
+		} while (i <= j);
+		if (j < (long)k) { lo = i; }
+		if ((long)k < i) { hi = j; }
+	}
+}
+
+/*
+ * K-D TREE
+ */
+
+void
+M_KDTreeInit(M_KDTree *T)
+{
+	T->dim = 2;
+	T->n = 0;
+	T->nNodes = 0;
+	T->_pad = 0;
+	T->pts = NULL;
+	T->idx = NULL;
+	T->nodes = NULL;
+}
+
+void
+M_KDTreeFree(M_KDTree *T)
+{
+	Free(T->nodes);
+	Free(T->idx);
+	Free(T->pts);
+	T->nodes = NULL;
+	T->idx = NULL;
+	T->pts = NULL;
+	T->n = 0;
+	T->nNodes = 0;
+}
+
+static Uint
+KDBuildNode(M_KDTree *_Nonnull T, const M_Real *_Nonnull c, Uint first,
+    Uint count)
+{
+	const Uint dim = T->dim;
+	const Uint node = T->nNodes++;
+	M_KDNode *N = &T->nodes[node];
+	M_Real min[3], max[3], ext, extMax;
+	Uint i, a, axis, mid;
+
+	N->first = first;
+	N->count = count;
+	N->right = 0;
+	if (count <= M_KD_LEAF_SIZE) {
+		N->axis = M_KD_LEAF;
+		N->split = 0.0;
+		return (node);
+	}
+	for (a = 0; a < dim; a++) {
+		min[a] = max[a] = c[T->idx[first]*dim + a];
+	}
+	for (i = first+1; i < first+count; i++) {
+		const M_Real *p = &c[T->idx[i]*dim];
+
+		for (a = 0; a < dim; a++) {
+			if (p[a] < min[a]) { min[a] = p[a]; }
+			if (p[a] > max[a]) { max[a] = p[a]; }
+		}
+	}
+	for (axis = 0, extMax = -1.0, a = 0; a < dim; a++) {
+		if ((ext = max[a] - min[a]) > extMax) {
+			extMax = ext;
+			axis = a;
+		}
+	}
+	mid = count/2;
+	Select(&c[axis], dim, &T->idx[first], count, mid);
+	N->axis = axis;
+	N->split = c[T->idx[first+mid]*dim + axis];
+
+	KDBuildNode(T, c, first, mid);
+	i = KDBuildNode(T, c, first+mid, count-mid);
+	T->nodes[node].right = i;
+	return (node);
+}
+
+/* Build a k-d tree over points with dim coordinates each in c. */
+static int
+KDBuild(M_KDTree *_Nonnull T, M_Real *_Nonnull c, Uint n, Uint dim)
+{
+	Uint i, a;
+
+	T->dim = dim;
+	T->n = n;
+	T->nNodes = 0;
+	if ((T->idx = TryMalloc((n > 0 ? n : 1)*sizeof(Uint))) == NULL ||
+	    (T->nodes = TryMalloc((n/2 + 1)*sizeof(M_KDNode))) == NULL) {
+		M_KDTreeFree(T);
+		return (-1);
+	}
+	for (i = 0; i < n; i++) {
+		T->idx[i] = i;
+	}
+	if (n > 0)
+		KDBuildNode(T, c, 0, n);
+
+	/* Store the coordinates in tree order for locality. */
+	if ((T->pts = TryMalloc((n > 0 ? n : 1)*dim*sizeof(M_Real))) == NULL) {
+		M_KDTreeFree(T);
+		return (-1);
+	}
+	for (i = 0; i < n; i++) {
+		for (a = 0; a < dim; a++)
+			T->pts[i*dim + a] = c[T->idx[i]*dim + a];
+	}
+	return (0);
+}
+
+/*
+ * Build a k-d tree over an array of n points, replacing any existing
+ * contents of the tree. Return -1 if insufficient memory is available.
+ */
+int
+M_KDTreeBuild2(M_KDTree *T, const M_Vector2 *p, Uint n)
+{
+	M_Real *c;
+	Uint i;
+	int rv;
+
+	M_KDTreeFree(T);
+	if ((c = TryMalloc((n > 0 ? n : 1)*2*sizeof(M_Real))) == NULL) {
+		return (-1);
+	}
+	for (i = 0; i < n; i++) {
+		c[i*2] = p[i].x;
+		c[i*2 + 1] = p[i].y;
+	}
+	rv = KDBuild(T, c, n, 2);
+	Free(c);
+	return (rv);
+}
+
+int
+M_KDTreeBuild3(M_KDTree *T, const M_Vector3 *p, Uint n)
+{
+	M_Real *c;
+	Uint i;
+	int rv;
+
+	M_KDTreeFree(T);
+	if ((c = TryMalloc((n > 0 ? n : 1)*3*sizeof(M_Real))) == NULL) {
+		return (-1);
+	}
+	for (i = 0; i < n; i++) {
+		c[i*3] = p[i].x;
+		c[i*3 + 1] = p[i].y;
+		c[i*3 + 2] = p[i].z;
+	}
+	rv = KDBuild(T, c, n, 3);
+	Free(c);
+	return (rv);
+}
+
+static void
+KDNearest(const M_KDTree *_Nonnull T, Uint node, const M_Real *_Nonnull q,
+    M_Real *_Nonnull best, Uint *_Nonnull bestIdx)
+{
+	const M_KDNode *N = &T->nodes[node];
+	M_Real diff;
+	Uint i;
+
+	if (N->axis == M_KD_LEAF) {
+		const Uint end = N->first + N->count;
+
+		if (T->dim == 2) {
+			for (i = N->first; i < end; i++) {
+				const M_Real *p = &T->pts[i*2];
+				const M_Real dx = p[0]-q[0], dy = p[1]-q[1];
+				const M_Real d = dx*dx + dy*dy;
+
+				if (d < *best) {
+					*best = d;
+					*bestIdx = i;
+				}
+			}
+		} else {
+			for (i = N->first; i < end; i++) {
+				const M_Real *p = &T->pts[i*3];
+				const M_Real dx = p[0]-q[0], dy = p[1]-q[1],
+				             dz = p[2]-q[2];
+				const M_Real d = dx*dx + dy*dy + dz*dz;
+
+				if (d < *best) {
+					*best = d;
+					*bestIdx = i;
+				}
+			}
+		}
+		return;
+	}
+	diff = q[N->axis] - N->split;
+	if (diff <= 0.0) {
+		KDNearest(T, node+1, q, best, bestIdx);
+		if (diff*diff < *best)
+			KDNearest(T, N->right, q, best, bestIdx);
+	} else {
+		KDNearest(T, N->right, q, best, bestIdx);
+		if (diff*diff < *best)
+			KDNearest(T, node+1, q, best, bestIdx);
+	}
+}
+
+static void
+KDRadius(const M_KDTree *_Nonnull T, Uint node, const M_Real *_Nonnull q,
+    M_Real r, Uint *_Nullable out, Uint maxOut, Uint *_Nonnull count)
+{
+	const M_KDNode *N = &T->nodes[node];
+	const Uint dim = T->dim;
+	const M_Real r2 = r*r;
+	Uint i, a;
+
+	if (N->axis == M_KD_LEAF) {
+		for (i = N->first; i < N->first + N->count; i++) {
+			const M_Real *p = &T->pts[i*dim];
+			M_Real d = 0.0;
+
+			for (a = 0; a < dim; a++) {
+				d += (p[a]-q[a])*(p[a]-q[a]);
+			}
+			if (d <= r2) {
+				if (*count < maxOut) {
+					out[*count] = T->idx[i];
+				}
+				(*count)++;
+			}
+		}
+		return;
+	}
+	if (q[N->axis] - r <= N->split) {
+		KDRadius(T, node+1, q, r, out, maxOut, count);
+	}
+	if (q[N->axis] + r >= N->split)
+		KDRadius(T, N->right, q, r, out, maxOut, count);
+}
+
+/*
+ * Return the index of the point nearest to q, or -1 if the tree is empty.
+ * If dist is not NULL, return the distance to the point in it.
+ */
+int
+M_KDTreeNearest2(const M_KDTree *T, M_Vector2 q, M_Real *dist)
+{
+	M_Real c[2], best = M_INFINITY;
+	Uint bestIdx = 0;
+
+	if (T->n == 0) {
+		return (-1);
+	}
+	c[0] = q.x;
+	c[1] = q.y;
+	KDNearest(T, 0, c, &best, &bestIdx);
+	if (dist != NULL) {
+		*dist = M_Sqrt(best);
+	}
+	return (int)T->idx[bestIdx];
+}
+
+int
+M_KDTreeNearest3(const M_KDTree *T, M_Vector3 q, M_Real *dist)
+{
+	M_Real c[3], best = M_INFINITY;
+	Uint bestIdx = 0;
+
+	if (T->n == 0) {
+		return (-1);
+	}
+	c[0] = q.x;
+	c[1] = q.y;
+	c[2] = q.z;
+	KDNearest(T, 0, c, &best, &bestIdx);
+	if (dist != NULL) {
+		*dist = M_Sqrt(best);
+	}
+	return (int)T->idx[bestIdx];
+}
+
+/*
+ * Find the points within distance r of q. Return the number of points
+ * found, and write the indices of up to maxOut of them to out (in no
+ * particular order).
+ */
+Uint
+M_KDTreeRadius2(const M_KDTree *T, M_Vector2 q, M_Real r, Uint *out,
+    Uint maxOut)
+{
+	M_Real c[2];
+	Uint count = 0;
+
+	if (T->n > 0) {
+		c[0] = q.x;
+		c[1] = q.y;
+		KDRadius(T, 0, c, r, out, maxOut, &count);
+	}
+	return (count);
+}
+
+Uint
+M_KDTreeRadius3(const M_KDTree *T, M_Vector3 q, M_Real r, Uint *out,
+    Uint maxOut)
+{
+	M_Real c[3];
+	Uint count = 0;
+
+	if (T->n > 0) {
+		c[0] = q.x;
+		c[1] = q.y;
+		c[2] = q.z;
+		KDRadius(T, 0, c, r, out, maxOut, &count);
+	}
+	return (count);
+}
+
+/*
+ * BOUNDING VOLUME HIERARCHY
+ */
+
+static __inline__ void
+BoundsEmpty(M_BVHBounds *_Nonnull b)
+{
+	b->min[0] = b->min[1] = b->min[2] = M_NUMMAX;
+	b->max[0] = b->max[1] = b->max[2] = -M_NUMMAX;
+}
+
+static __inline__ void
+BoundsUnion(M_BVHBounds *_Nonnull b, const M_BVHBounds *_Nonnull a, Uint dim)
+{
+	Uint i;
+
+	for (i = 0; i < dim; i++) {
+		if (a->min[i] < b->min[i]) { b->min[i] = a->min[i]; }
+		if (a->max[i] > b->max[i]) { b->max[i] = a->max[i]; }
+	}
+}
+
+/* Return the half surface area (or in R^2, the half perimeter). */
+static __inline__ M_Real
+BoundsArea(const M_BVHBounds *_Nonnull b, Uint dim)
+{
+	const M_Real ex = b->max[0] - b->min[0];
+	const M_Real ey = b->max[1] - b->min[1];
+	const M_Real ez = b->max[2] - b->min[2];
+
+	if (ex < 0.0) {
+		return (0.0);
+	}
+	return (dim == 2) ? (ex + ey) : (ex*ey + ey*ez + ez*ex);
+}
+
+static __inline__ int
+BoundsOverlap(const M_BVHBounds *_Nonnull a, const M_BVHBounds *_Nonnull b,
+    Uint dim)
+{
+	Uint i;
+
+	for (i = 0; i < dim; i++) {
+		if (a->min[i] > b->max[i] || a->max[i] < b->min[i])
+			return (0);
+	}
+	return (1);
+}
+
+/* Return the squared distance from point q to the bounds. */
+static __inline__ M_Real
+BoundsDist2(const M_BVHBounds *_Nonnull b, const M_Real *_Nonnull q, Uint dim)
+{
+	M_Real d = 0.0, e;
+	Uint i;
+
+	for (i = 0; i < dim; i++) {
+		if (q[i] < b->min[i]) {
+			e = b->min[i] - q[i];
+			d += e*e;
+		} else if (q[i] > b->max[i]) {
+			e = q[i] - b->max[i];
+			d += e*e;
+		}
+	}
+	return (d);
+}
+
+/*
+ * Intersect the ray o + t*d, tMin <= t <= tMax with the bounds (slab test).
+ * On success, return 1 and the entry distance in tNear.
+ */
+static __inline__ int
+BoundsRay(const M_BVHBounds *_Nonnull b, const M_Real *_Nonnull o,
+    const M_Real *_Nonnull dInv, const M_Real *_Nonnull d, Uint dim,
+    M_Real tMax, M_Real *_Nonnull tNear)
+{
+	M_Real t0 = 0.0, t1 = tMax, tA, tB, tmp;
+	Uint i;
+
+	for (i = 0; i < dim; i++) {
+		if (d[i] == 0.0) {
+			if (o[i] < b->min[i] || o[i] > b->max[i]) {
+				return (0);
+			}
+			continue;
+		}
+		tA = (b->min[i] - o[i]) * dInv[i];
+		tB = (b->max[i] - o[i]) * dInv[i];
+		if (tA > tB) {
+			tmp = tA;
+			tA = tB;
+			tB = tmp;
+		}
+		if (tA > t0) { t0 = tA; }
+		if (tB < t1) { t1 = tB; }
+		if (t0 > t1)
+			return (0);
+	}
+	*tNear = t0;
+	return (1);
+}
+
+void
+M_BVHInit(M_BVH *B, Uint dim)
+{
+	B->dim = (dim == 3) ? 3 : 2;
+	B->n = 0;
+	B->nNodes = 0;
+	B->_pad = 0;
+	B->bounds = NULL;
+	B->idx = NULL;
+	B->leaf = NULL;
+	B->nodes = NULL;
+}
+
+void
+M_BVHFree(M_BVH *B)
+{
+	Free(B->nodes);
+	Free(B->leaf);
+	Free(B->idx);
+	Free(B->bounds);
+	B->nodes = NULL;
+	B->leaf = NULL;
+	B->idx = NULL;
+	B->bounds = NULL;
+	B->n = 0;
+	B->nNodes = 0;
+}
+
+/* Split a node's primitives at the median centroid along an axis. */
+static Uint
+BVHSplitMedian(M_BVH *_Nonnull B, const M_Real *_Nonnull cent, Uint first,
+    Uint count, Uint axis)
+{
+	const Uint mid = count/2;
+
+	Select(&cent[axis], 3, &B->idx[first], count, mid);
+	return (mid);
+}
+
+/*
+ * Evaluate the binned SAH along the axis. Return the number of primitives
+ * in the left child, or 0 if a leaf is cheaper.
+ */
+static Uint
+BVHSplitSAH(M_BVH *_Nonnull B, const M_Real *_Nonnull cent, Uint first,
+    Uint count, Uint axis, M_Real cMin, M_Real cExt, M_Real area)
+{
+	M_BVHBounds bins[BVH_BINS], acc;
+	M_Real areaL[BVH_BINS], cost, costBest = M_INFINITY;
+	Uint nBin[BVH_BINS], nL[BVH_BINS], n, i, j, split = 0;
+	const M_Real scale = (M_Real)BVH_BINS / cExt;
+	const Uint dim = B->dim;
+
+	for (i = 0; i < BVH_BINS; i++) {
+		BoundsEmpty(&bins[i]);
+		nBin[i] = 0;
+	}
+	for (i = first; i < first+count; i++) {
+		const Uint p = B->idx[i];
+
+		j = (Uint)((cent[p*3 + axis] - cMin) * scale);
+		if (j >= BVH_BINS) {
+			j = BVH_BINS-1;
+		}
+		BoundsUnion(&bins[j], &B->bounds[p], dim);
+		nBin[j]++;
+	}
+
+	/* Sweep from the left, then evaluate the cost from the right. */
+	BoundsEmpty(&acc);
+	for (n = 0, i = 0; i < BVH_BINS-1; i++) {
+		BoundsUnion(&acc, &bins[i], dim);
+		n += nBin[i];
+		areaL[i] = BoundsArea(&acc, dim);
+		nL[i] = n;
+	}
+	BoundsEmpty(&acc);
+	for (n = 0, i = BVH_BINS-1; i > 0; i--) {
+		BoundsUnion(&acc, &bins[i], dim);
+		n += nBin[i];
+		if (nL[i-1] == 0 || n == 0) {
+			continue;
+		}
+		cost = BVH_COST_TRAV + (areaL[i-1]*nL[i-1] +
+		                        BoundsArea(&acc, dim)*n) / area;
+		if (cost < costBest) {
+			costBest = cost;
+			split = i;
+		}
+	}
+	if (split == 0 || (costBest >= (M_Real)count && count <= BVH_LEAF_MAX))
+		return (0);
+
+	/* Partition the primitives on the chosen bin boundary. */
+	for (i = first, j = first+count; i < j; ) {
+		const Uint p = B->idx[i];
+		Uint bin = (Uint)((cent[p*3 + axis] - cMin) * scale);
+
+		if (bin >= BVH_BINS) {
+			bin = BVH_BINS-1;
+		}
+		if (bin < split) {
+			i++;
+		} else {
+			B->idx[i] = B->idx[--j];
+			B->idx[j] = p;
+		}
+	}
+	return (i - first);
+}
+
+static void
+BVHBuildNode(M_BVH *_Nonnull B, const M_Real *_Nonnull cent, Uint node,
+    Uint depth, enum m_bvh_build_mode mode)
+{
+	M_BVHNode *N = &B->nodes[node];
+	const Uint first = N->left, count = N->count, dim = B->dim;
+	M_Real cMin[3], cMax[3], ext, extMax, area;
+	Uint i, a, axis, nLeft, left;
+
+	BoundsEmpty(&N->b);
+	for (a = 0; a < dim; a++) {
+		cMin[a] = M_NUMMAX;
+		cMax[a] = -M_NUMMAX;
+	}
+	for (i = first; i < first+count; i++) {
+		const Uint p = B->idx[i];
+
+		BoundsUnion(&N->b, &B->bounds[p], dim);
+		for (a = 0; a < dim; a++) {
+			const M_Real c = cent[p*3 + a];
+
+			if (c < cMin[a]) { cMin[a] = c; }
+			if (c > cMax[a]) { cMax[a] = c; }
+		}
+	}
+	if (dim == 2) {
+		N->b.min[2] = N->b.max[2] = 0.0;
+	}
+	if (count <= 1) {
+		return;
+	}
+	for (axis = 0, extMax = -1.0, a = 0; a < dim; a++) {
+		if ((ext = cMax[a] - cMin[a]) > extMax) {
+			extMax = ext;
+			axis = a;
+		}
+	}
+	area = BoundsArea(&N->b, dim);
+	if (extMax <= 0.0) {
+		/* Coincident centroids; split arbitrarily if too many. */
+		if (count <= BVH_LEAF_MAX) {
+			return;
+		}
+		nLeft = count/2;
+	} else if (mode == M_BVH_SAH && depth < BVH_SAH_DEPTH && area > 0.0) {
+		nLeft = BVHSplitSAH(B, cent, first, count, axis, cMin[axis],
+		    extMax, area);
+		if (nLeft == 0)
+			return;
+	} else {
+		if (count <= BVH_LEAF_MAX) {
+			return;
+		}
+		nLeft = BVHSplitMedian(B, cent, first, count, axis);
+	}
+
+	left = B->nNodes;
+	B->nNodes += 2;
+	N->left = left;
+	N->count = 0;
+	B->nodes[left].left = first;
+	B->nodes[left].count = nLeft;
+	B->nodes[left].parent = node;
+	B->nodes[left+1].left = first + nLeft;
+	B->nodes[left+1].count = count - nLeft;
+	B->nodes[left+1].parent = node;
+	BVHBuildNode(B, cent, left, depth+1, mode);
+	BVHBuildNode(B, cent, left+1, depth+1, mode);
+}
+
+/*
+ * Build a BVH over the bounds of n primitives, replacing any existing
+ * contents. Return -1 if insufficient memory is available.
+ */
+int
+M_BVHBuild(M_BVH *B, const M_BVHBounds *bounds, Uint n,
+    enum m_bvh_build_mode mode)
+{
+	const Uint dim = B->dim;
+	const Uint nAlloc = (n > 0) ? n : 1;
+	M_Real *cent;
+	Uint i, k, a;
+
+	M_BVHFree(B);
+	if ((B->bounds = TryMalloc(nAlloc*sizeof(M_BVHBounds))) == NULL ||
+	    (B->idx = TryMalloc(nAlloc*sizeof(Uint))) == NULL ||
+	    (B->leaf = TryMalloc(nAlloc*sizeof(Uint))) == NULL ||
+	    (B->nodes = TryMalloc((2*nAlloc - 1)*sizeof(M_BVHNode))) == NULL ||
+	    (cent = TryMalloc(nAlloc*3*sizeof(M_Real))) == NULL) {
+		M_BVHFree(B);
+		return (-1);
+	}
+	if (n > 0) {
+		memcpy(B->bounds, bounds, n*sizeof(M_BVHBounds));
+	}
+	for (i = 0; i < n; i++) {
+		B->idx[i] = i;
+		for (a = 0; a < 3; a++)
+			cent[i*3 + a] = (a < dim) ?
+			    0.5*(bounds[i].min[a] + bounds[i].max[a]) : 0.0;
+	}
+	B->n = n;
+	B->nNodes = 1;
+	B->nodes[0].left = 0;
+	B->nodes[0].count = n;
+	B->nodes[0].parent = 0;
+	B->nodes[0]._pad = 0;
+	BVHBuildNode(B, cent, 0, 0, mode);
+	Free(cent);
+
+	for (i = 0; i < B->nNodes; i++) {
+		const M_BVHNode *N = &B->nodes[i];
+
+		for (k = N->left; N->count > 0 && k < N->left + N->count; k++)
+			B->leaf[B->idx[k]] = i;
+	}
+	return (0);
+}
+
+/* Recompute the bounds of a node from its primitives or children. */
+static void
+BVHRefitNode(M_BVH *_Nonnull B, Uint node)
+{
+	M_BVHNode *N = &B->nodes[node];
+	const Uint dim = B->dim;
+	Uint k;
+
+	if (N->count > 0) {
+		BoundsEmpty(&N->b);
+		for (k = N->left; k < N->left + N->count; k++)
+			BoundsUnion(&N->b, &B->bounds[B->idx[k]], dim);
+	} else {
+		N->b = B->nodes[N->left].b;
+		BoundsUnion(&N->b, &B->nodes[N->left + 1].b, dim);
+	}
+	if (dim == 2)
+		N->b.min[2] = N->b.max[2] = 0.0;
+}
+
+/*
+ * Update the bounds of all primitives and refit the hierarchy in O(n)
+ * time, keeping its topology. Query performance degrades if primitives
+ * move far from their original neighbors, in which case the BVH should
+ * be rebuilt.
+ */
+void
+M_BVHRefit(M_BVH *B, const M_BVHBounds *bounds)
+{
+	Uint i;
+
+	if (B->n == 0) {
+		return;
+	}
+	memcpy(B->bounds, bounds, B->n*sizeof(M_BVHBounds));
+
+	/* Children always follow their parent. */
+	for (i = B->nNodes; i > 0; i--)
+		BVHRefitNode(B, i-1);
+}
+
+/* Update the bounds of primitive i and refit its ancestors. */
+void
+M_BVHUpdate(M_BVH *B, Uint i, const M_BVHBounds *b)
+{
+	M_BVHBounds prev;
+	Uint node;
+
+#ifdef AG_DEBUG
+	if (i >= B->n) { AG_FatalError("Bad primitive"); }
+#endif
+	B->bounds[i] = *b;
+	for (node = B->leaf[i]; ; node = B->nodes[node].parent) {
+		prev = B->nodes[node].b;
+		BVHRefitNode(B, node);
+		if (node == 0 ||
+		    memcmp(&prev, &B->nodes[node].b, sizeof(M_BVHBounds)) == 0)
+			break;
+	}
+}
+
+/*
+ * Find the primitives whose bounds overlap the given bounds. Return the
+ * number of primitives found, and write the indices of up to maxOut of
+ * them to out.
+ */
+Uint
+M_BVHQueryBox(const M_BVH *B, const M_BVHBounds *q, Uint *out, Uint maxOut)
+{
+	const Uint dim = B->dim;
+	Uint stack[BVH_STACK], sp = 0, count = 0, k, node;
+
+	if (B->n == 0) {
+		return (0);
+	}
+	stack[sp++] = 0;
+	while (sp > 0) {
+		const M_BVHNode *N = &B->nodes[stack[--sp]];
+
+		if (!BoundsOverlap(&N->b, q, dim)) {
+			continue;
+		}
+		if (N->count == 0) {
+			stack[sp++] = N->left;
+			stack[sp++] = N->left + 1;
+			continue;
+		}
+		for (k = N->left; k < N->left + N->count; k++) {
+			node = B->idx[k];
+			if (BoundsOverlap(&B->bounds[node], q, dim)) {
+				if (count < maxOut) {
+					out[count] = node;
+				}
+				count++;
+			}
+		}
+	}
+	return (count);
+}
+
+static Uint
+BVHQueryRadius(const M_BVH *_Nonnull B, const M_Real *_Nonnull q, M_Real r,
+    Uint *_Nullable out, Uint maxOut)
+{
+	const Uint dim = B->dim;
+	const M_Real r2 = r*r;
+	Uint stack[BVH_STACK], sp = 0, count = 0, k, p;
+
+	if (B->n == 0) {
+		return (0);
+	}
+	stack[sp++] = 0;
+	while (sp > 0) {
+		const M_BVHNode *N = &B->nodes[stack[--sp]];
+
+		if (BoundsDist2(&N->b, q, dim) > r2) {
+			continue;
+		}
+		if (N->count == 0) {
+			stack[sp++] = N->left;
+			stack[sp++] = N->left + 1;
+			continue;
+		}
+		for (k = N->left; k < N->left + N->count; k++) {
+			p = B->idx[k];
+			if (BoundsDist2(&B->bounds[p], q, dim) <= r2) {
+				if (count < maxOut) {
+					out[count] = p;
+				}
+				count++;
+			}
+		}
+	}
+	return (count);
+}
+
+/*
+ * Find the primitives whose bounds lie within distance r of q (see
+ * M_BVHQueryBox() for the return value).
+ */
+Uint
+M_BVHQueryRadius2(const M_BVH *B, M_Vector2 q, M_Real r, Uint *out,
+    Uint maxOut)
+{
+	M_Real c[3];
+
+	c[0] = q.x;
+	c[1] = q.y;
+	c[2] = 0.0;
+	return BVHQueryRadius(B, c, r, out, maxOut);
+}
+
+Uint
+M_BVHQueryRadius3(const M_BVH *B, M_Vector3 q, M_Real r, Uint *out,
+    Uint maxOut)
+{
+	M_Real c[3];
+
+	c[0] = q.x;
+	c[1] = q.y;
+	c[2] = q.z;
+	return BVHQueryRadius(B, c, r, out, maxOut);
+}
+
+static int
+BVHNearest(const M_BVH *_Nonnull B, const M_Real *_Nonnull q,
+    M_BVHPrimFn _Nonnull fn, void *_Nullable arg, M_Real *_Nullable dist)
+{
+	const Uint dim = B->dim;
+	BVH_StackEnt stack[BVH_STACK];
+	M_Real best = M_INFINITY, best2 = M_INFINITY, d, dL, dR;
+	Uint sp = 0, k;
+	int bestIdx = -1;
+
+	if (B->n == 0) {
+		goto out;
+	}
+	stack[0].node = 0;
+	stack[0].t = BoundsDist2(&B->nodes[0].b, q, dim);
+	sp = 1;
+	while (sp > 0) {
+		const BVH_StackEnt *ent = &stack[--sp];
+		const M_BVHNode *N = &B->nodes[ent->node];
+
+		if (ent->t >= best2) {
+			continue;
+		}
+		if (N->count > 0) {
+			for (k = N->left; k < N->left + N->count; k++) {
+				const Uint p = B->idx[k];
+
+				if (BoundsDist2(&B->bounds[p], q, dim) >= best2)
+					continue;
+				if ((d = fn(arg, p)) < best) {
+					best = d;
+					best2 = d*d;
+					bestIdx = (int)p;
+				}
+			}
+			continue;
+		}
+		dL = BoundsDist2(&B->nodes[N->left].b, q, dim);
+		dR = BoundsDist2(&B->nodes[N->left + 1].b, q, dim);
+		if (dL <= dR) {				/* Nearest on top */
+			stack[sp].node = N->left + 1;	stack[sp++].t = dR;
+			stack[sp].node = N->left;	stack[sp++].t = dL;
+		} else {
+			stack[sp].node = N->left;	stack[sp++].t = dL;
+			stack[sp].node = N->left + 1;	stack[sp++].t = dR;
+		}
+	}
+out:
+	if (dist != NULL) {
+		*dist = best;
+	}
+	return (bestIdx);
+}
+
+/*
+ * Return the index of the primitive nearest to q, or -1 if none was found.
+ * fn is called with arg to return the exact distance from q to a candidate
+ * primitive. If dist is not NULL, return the distance in it.
+ */
+int
+M_BVHNearest2(const M_BVH *B, M_Vector2 q, M_BVHPrimFn fn, void *arg,
+    M_Real *dist)
+{
+	M_Real c[3];
+
+	c[0] = q.x;
+	c[1] = q.y;
+	c[2] = 0.0;
+	return BVHNearest(B, c, fn, arg, dist);
+}
+
+int
+M_BVHNearest3(const M_BVH *B, M_Vector3 q, M_BVHPrimFn fn, void *arg,
+    M_Real *dist)
+{
+	M_Real c[3];
+
+	c[0] = q.x;
+	c[1] = q.y;
+	c[2] = q.z;
+	return BVHNearest(B, c, fn, arg, dist);
+}
+
+static int
+BVHRayCast(const M_BVH *_Nonnull B, const M_Real *_Nonnull o,
+    const M_Real *_Nonnull d, M_Real tMax, M_BVHPrimFn _Nonnull fn,
+    void *_Nullable arg, M_Real *_Nullable tHit)
+{
+	const Uint dim = B->dim;
+	BVH_StackEnt stack[BVH_STACK];
+	M_Real dInv[3], best = tMax, t, tL, tR;
+	Uint sp = 0, a, k;
+	int bestIdx = -1, hitL, hitR;
+
+	for (a = 0; a < 3; a++) {
+		dInv[a] = (d[a] != 0.0) ? 1.0/d[a] : 0.0;
+	}
+	if (B->n == 0 ||
+	    !BoundsRay(&B->nodes[0].b, o, dInv, d, dim, best, &t)) {
+		goto out;
+	}
+	stack[0].node = 0;
+	stack[0].t = t;
+	sp = 1;
+	while (sp > 0) {
+		const BVH_StackEnt *ent = &stack[--sp];
+		const M_BVHNode *N = &B->nodes[ent->node];
+
+		if (ent->t > best) {
+			continue;
+		}
+		if (N->count > 0) {
+			for (k = N->left; k < N->left + N->count; k++) {
+				const Uint p = B->idx[k];
+
+				if (!BoundsRay(&B->bounds[p], o, dInv, d, dim,
+				    best, &t)) {
+					continue;
+				}
+				if ((t = fn(arg, p)) >= 0.0 && t <= best) {
+					best = t;
+					bestIdx = (int)p;
+				}
+			}
+			continue;
+		}
+		hitL = BoundsRay(&B->nodes[N->left].b, o, dInv, d, dim, best,
+		    &tL);
+		hitR = BoundsRay(&B->nodes[N->left + 1].b, o, dInv, d, dim, best,
+		    &tR);
+		if (hitL && hitR) {
+			if (tL <= tR) {			/* Nearest on top */
+				stack[sp].node = N->left + 1;	stack[sp++].t = tR;
+				stack[sp].node = N->left;	stack[sp++].t = tL;
+			} else {
+				stack[sp].node = N->left;	stack[sp++].t = tL;
+				stack[sp].node = N->left + 1;	stack[sp++].t = tR;
+			}
+		} else if (hitL) {
+			stack[sp].node = N->left;	stack[sp++].t = tL;
+		} else if (hitR) {
+			stack[sp].node = N->left + 1;	stack[sp++].t = tR;
+		}
+	}
+out:
+	if (tHit != NULL) {
+		*tHit = (bestIdx != -1) ? best : M_INFINITY;
+	}
+	return (bestIdx);
+}
+
+/*
+ * Return the index of the first primitive hit by the ray (or segment) L,
+ * or -1 if none was hit. fn is called with arg to return the exact distance
+ * along L of the intersection with a candidate primitive (or M_INFINITY).
+ * If tHit is not NULL, return the distance to the hit in it.
+ */
+int
+M_BVHRayCast2(const M_BVH *B, M_Line2 L, M_BVHPrimFn fn, void *arg,
+    M_Real *tHit)
+{
+	M_Real o[3], d[3];
+
+	o[0] = L.p.x;	d[0] = L.d.x;
+	o[1] = L.p.y;	d[1] = L.d.y;
+	o[2] = 0.0;	d[2] = 0.0;
+	return BVHRayCast(B, o, d, L.t, fn, arg, tHit);
+}
+
+int
+M_BVHRayCast3(const M_BVH *B, M_Line3 L, M_BVHPrimFn fn, void *arg,
+    M_Real *tHit)
+{
+	M_Real o[3], d[3];
+
+	o[0] = L.p.x;	d[0] = L.d.x;
+	o[1] = L.p.y;	d[1] = L.d.y;
+	o[2] = L.p.z;	d[2] = L.d.z;
+	return BVHRayCast(B, o, d, L.t, fn, arg, tHit);
+}
+
+/*
+ * POLYGONS
+ */
+
+/* Return the bounds of a polygon. */
+M_BVHBounds
+M_BVHBoundsPolygon(const M_Polygon *P)
+{
+	M_BVHBounds b;
+	Uint i;
+
+	if (P->n == 0) {
+		memset(&b, 0, sizeof(b));
+		return (b);
+	}
+	b = M_BVHBoundsPoint2(P->v[0]);
+	for (i = 1; i < P->n; i++) {
+		M_BVHBoundsAdd2(&b, P->v[i]);
+	}
+	return (b);
+}
+
+/*
+ * Build a 2D BVH over the edges of a polygon, where edge i joins vertex i
+ * to vertex i+1. The BVH must have been initialized by M_BVHInit().
+ */
+int
+M_BVHFromPolygon(M_BVH *B, const M_Polygon *P)
+{
+	M_BVHBounds *bounds;
+	Uint i;
+	int rv;
+
+	if ((bounds = TryMalloc((P->n > 0 ? P->n : 1)*sizeof(M_BVHBounds)))
+	    == NULL) {
+		return (-1);
+	}
+	for (i = 0; i < P->n; i++) {
+		bounds[i] = M_BVHBoundsPoint2(P->v[i]);
+		M_BVHBoundsAdd2(&bounds[i], P->v[(i+1) % P->n]);
+	}
+	B->dim = 2;
+	rv = M_BVHBuild(B, bounds, P->n, M_BVH_SAH);
+	Free(bounds);
+	return (rv);
+}
+
+/*
+ * Test whether point p lies inside the polygon, using a BVH built over
+ * its edges by M_BVHFromPolygon(). This gives the same result as
+ * M_PointInPolygon(), in logarithmic rather than linear time.
+ */
+int
+M_PointInPolygonBVH(const M_Polygon *P, const M_BVH *B, M_Vector2 p)
+{
+	Uint stack[BVH_STACK], sp = 0, k, i, count = 0;
+	M_Vector2 p1, p2;
+	M_Real ix;
+
+	if (P->n < 3 || B->n != P->n) {
+		return (0);
+	}
+	stack[sp++] = 0;
+	while (sp > 0) {
+		const M_BVHNode *N = &B->nodes[stack[--sp]];
+
+		/* Only edges crossing the ray from p along +X can count. */
+		if (p.y < N->b.min[1] || p.y > N->b.max[1] ||
+		    p.x > N->b.max[0]) {
+			continue;
+		}
+		if (N->count == 0) {
+			stack[sp++] = N->left;
+			stack[sp++] = N->left + 1;
+			continue;
+		}
+		for (k = N->left; k < N->left + N->count; k++) {
+			i = B->idx[k];
+			p1 = P->v[i];
+			p2 = P->v[(i+1) % P->n];
+			if (p.y >  MIN(p1.y, p2.y) &&
+			    p.y <= MAX(p1.y, p2.y) &&
+			    p.x <= MAX(p1.x, p2.x) &&
+			    p1.y != p2.y) {
+				ix = (p.y - p1.y)*(p2.x - p1.x) /
+				     (p2.y - p1.y) + p1.x;
+				if (p1.x == p2.x || p.x <= ix)
+					count++;
+			}
+		}
+	}
+	return (count % 2);
+}
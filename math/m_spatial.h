@@ -0,0 +1,199 @@
+/*	Public domain	*/
+/*
+ * Spatial indices: k-d trees over point sets and bounding volume
+ * hierarchies (BVH) over the bounds of arbitrary primitives.
+ */
+
+#define M_KD_LEAF_SIZE	8		/* Maximum points per k-d tree leaf */
+#define M_KD_LEAF	0xffffffffU	/* Axis of a k-d tree leaf node */
+
+/* Node of a k-d tree. The left child of an inner node is the next node. */
+typedef struct m_kd_node {
+	M_Real split;			/* Splitting coordinate */
+	Uint axis;			/* Splitting axis (or M_KD_LEAF) */
+	Uint first;			/* First point in subtree */
+	Uint count;			/* Number of points in subtree */
+	Uint right;			/* Right child (inner nodes) */
+} M_KDNode;
+
+/* k-d tree over a set of points in R^2 or R^3. */
+typedef struct m_kd_tree {
+	Uint dim;			/* Dimension (2 or 3) */
+	Uint n;				/* Number of points */
+	Uint nNodes;			/* Number of nodes */
+	Uint32 _pad;
+	M_Real *_Nullable pts;		/* Coordinates (dim*n) in tree order */
+	Uint *_Nullable idx;		/* Original index of each point */
+	M_KDNode *_Nullable nodes;	/* Nodes (root is first) */
+} M_KDTree;
+
+/* Axis-aligned bounds of a primitive (in R^2, the Z bounds are unused). */
+typedef struct m_bvh_bounds {
+	M_Real min[3];
+	M_Real max[3];
+} M_BVHBounds;
+
+/* Construction method for M_BVHBuild(). */
+enum m_bvh_build_mode {
+	M_BVH_SAH,			/* Binned surface area heuristic */
+	M_BVH_MEDIAN			/* Median split on the longest axis */
+};
+
+/* Node of a BVH. The children of an inner node are adjacent. */
+typedef struct m_bvh_node {
+	M_BVHBounds b;			/* Bounds of subtree */
+	Uint left;			/* Left child, or first primitive (leaf) */
+	Uint count;			/* Primitives in leaf (0 = inner node) */
+	Uint parent;			/* Parent node (root is its own parent) */
+	Uint32 _pad;
+} M_BVHNode;
+
+/* Bounding volume hierarchy over n primitives in R^2 or R^3. */
+typedef struct m_bvh {
+	Uint dim;			/* Dimension (2 or 3) */
+	Uint n;				/* Number of primitives */
+	Uint nNodes;			/* Number of nodes */
+	Uint32 _pad;
+	M_BVHBounds *_Nullable bounds;	/* Primitive bounds (original order) */
+	Uint *_Nullable idx;		/* Primitive indices in tree order */
+	Uint *_Nullable leaf;		/* Leaf node of each primitive */
+	M_BVHNode *_Nullable nodes;	/* Nodes (root is first) */
+} M_BVH;
+
+/*
+ * Callback for ray and nearest primitive queries. Return the distance
+ * along the ray (or to the query point) of primitive i, or M_INFINITY.
+ */
+typedef M_Real (*M_BVHPrimFn)(void *_Nullable, Uint);
+
+__BEGIN_DECLS
+void M_KDTreeInit(M_KDTree *_Nonnull);
+int  M_KDTreeBuild2(M_KDTree *_Nonnull, const M_Vector2 *_Nullable, Uint);
+int  M_KDTreeBuild3(M_KDTree *_Nonnull, const M_Vector3 *_Nullable, Uint);
+void M_KDTreeFree(M_KDTree *_Nonnull);
+int  M_KDTreeNearest2(const M_KDTree *_Nonnull, M_Vector2, M_Real *_Nullable);
+int  M_KDTreeNearest3(const M_KDTree *_Nonnull, M_Vector3, M_Real *_Nullable);
+Uint M_KDTreeRadius2(const M_KDTree *_Nonnull, M_Vector2, M_Real,
+                     Uint *_Nullable, Uint);
+Uint M_KDTreeRadius3(const M_KDTree *_Nonnull, M_Vector3, M_Real,
+                     Uint *_Nullable, Uint);
+
+void M_BVHInit(M_BVH *_Nonnull, Uint);
+int  M_BVHBuild(M_BVH *_Nonnull, const M_BVHBounds *_Nullable, Uint,
+                enum m_bvh_build_mode);
+void M_BVHRefit(M_BVH *_Nonnull, const M_BVHBounds *_Nonnull);
+void M_BVHUpdate(M_BVH *_Nonnull, Uint, const M_BVHBounds *_Nonnull);
+void M_BVHFree(M_BVH *_Nonnull);
+Uint M_BVHQueryBox(const M_BVH *_Nonnull, const M_BVHBounds *_Nonnull,
+                   Uint *_Nullable, Uint);
+Uint M_BVHQueryRadius2(const M_BVH *_Nonnull, M_Vector2, M_Real,
+                       Uint *_Nullable, Uint);
+Uint M_BVHQueryRadius3(const M_BVH *_Nonnull, M_Vector3, M_Real,
+                       Uint *_Nullable, Uint);
+int  M_BVHNearest2(const M_BVH *_Nonnull, M_Vector2, M_BVHPrimFn _Nonnull,
+                   void *_Nullable, M_Real *_Nullable);
+int  M_BVHNearest3(const M_BVH *_Nonnull, M_Vector3, M_BVHPrimFn _Nonnull,
+                   void *_Nullable, M_Real *_Nullable);
+int  M_BVHRayCast2(const M_BVH *_Nonnull, M_Line2, M_BVHPrimFn _Nonnull,
+                   void *_Nullable, M_Real *_Nullable);
+int  M_BVHRayCast3(const M_BVH *_Nonnull, M_Line3, M_BVHPrimFn _Nonnull,
+                   void *_Nullable, M_Real *_Nullable);
+
+M_BVHBounds M_BVHBoundsPolygon(const M_Polygon *_Nonnull);
+int         M_BVHFromPolygon(M_BVH *_Nonnull, const M_Polygon *_Nonnull);
+int         M_PointInPolygonBVH(const M_Polygon *_Nonnull,
+                                const M_BVH *_Nonnull, M_Vector2);
+
+/* Build a k-d tree over a point set. */
+static __inline__ int
+M_KDTreeFromPointSet2(M_KDTree *_Nonnull T, const M_PointSet2 *_Nonnull S)
+{
+	return M_KDTreeBuild2(T, S->p, S->n);
+}
+static __inline__ int
+M_KDTreeFromPointSet3(M_KDTree *_Nonnull T, const M_PointSet3 *_Nonnull S)
+{
+	return M_KDTreeBuild3(T, S->p, S->n);
+}
+
+/* Return the bounds of a point. */
+static __inline__ M_BVHBounds
+M_BVHBoundsPoint2(M_Vector2 p)
+{
+	M_BVHBounds b;
+
+	b.min[0] = b.max[0] = p.x;
+	b.min[1] = b.max[1] = p.y;
+	b.min[2] = b.max[2] = 0.0;
+	return (b);
+}
+static __inline__ M_BVHBounds
+M_BVHBoundsPoint3(M_Vector3 p)
+{
+	M_BVHBounds b;
+
+	b.min[0] = b.max[0] = p.x;
+	b.min[1] = b.max[1] = p.y;
+	b.min[2] = b.max[2] = p.z;
+	return (b);
+}
+
+/* Extend bounds to include a point. */
+static __inline__ void
+M_BVHBoundsAdd2(M_BVHBounds *_Nonnull b, M_Vector2 p)
+{
+	if (p.x < b->min[0]) { b->min[0] = p.x; }
+	if (p.x > b->max[0]) { b->max[0] = p.x; }
+	if (p.y < b->min[1]) { b->min[1] = p.y; }
+	if (p.y > b->max[1]) { b->max[1] = p.y; }
+}
+static __inline__ void
+M_BVHBoundsAdd3(M_BVHBounds *_Nonnull b, M_Vector3 p)
+{
+	if (p.x < b->min[0]) { b->min[0] = p.x; }
+	if (p.x > b->max[0]) { b->max[0] = p.x; }
+	if (p.y < b->min[1]) { b->min[1] = p.y; }
+	if (p.y > b->max[1]) { b->max[1] = p.y; }
+	if (p.z < b->min[2]) { b->min[2] = p.z; }
+	if (p.z > b->max[2]) { b->max[2] = p.z; }
+}
+
+/* Return the bounds of a line segment (which must not be a ray). */
+static __inline__ M_BVHBounds
+M_BVHBoundsLine2(M_Line2 L)
+{
+	M_BVHBounds b = M_BVHBoundsPoint2(L.p);
+
+	M_BVHBoundsAdd2(&b, M_VECTOR2(L.p.x + L.d.x*L.t, L.p.y + L.d.y*L.t));
+	return (b);
+}
+static __inline__ M_BVHBounds
+M_BVHBoundsLine3(M_Line3 L)
+{
+	M_BVHBounds b = M_BVHBoundsPoint3(L.p);
+
+	M_BVHBoundsAdd3(&b, M_VECTOR3(L.p.x + L.d.x*L.t, L.p.y + L.d.y*L.t,
+	                              L.p.z + L.d.z*L.t));
+	return (b);
+}
+
+/* Return the bounds of a triangle. */
+static __inline__ M_BVHBounds
+M_BVHBoundsTriangle2(M_Triangle2 T)
+{
+	M_BVHBounds b = M_BVHBoundsPoint2(T.a);
+
+	M_BVHBoundsAdd2(&b, T.b);
+	M_BVHBoundsAdd2(&b, T.c);
+	return (b);
+}
+static __inline__ M_BVHBounds
+M_BVHBoundsTriangle3(M_Triangle3 T)
+{
+	M_BVHBounds b = M_BVHBoundsPoint3(T.a);
+
+	M_BVHBoundsAdd3(&b, T.b);
+	M_BVHBoundsAdd3(&b, T.c);
+	return (b);
+}
+__END_DECLS
@@ -75,6 +75,7 @@ M_VectorInitEngine(void)
 	}
 # endif
 #endif /* HAVE_SSE */
+	M_VectorInitEngineSoA3();
 }
 
 M_Vector2
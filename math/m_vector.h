@@ -256,6 +256,7 @@ __END_DECLS
 #include <agar/math/m_vector3_fpu.h>
 #include <agar/math/m_vector4_fpu.h>
 #include <agar/math/m_vector3_sse.h>
+#include <agar/math/m_vector_soa.h>
 
 __BEGIN_DECLS
 void       M_VectorInitEngine(void);
@@ -0,0 +1,589 @@
+/*
+ * Copyright (c) 2026 Julien Nadeau Carriere <vedge@csoft.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Batched operations on streams of vectors in R^3 (M_VectorSoA3).
+ *
+ * Components are stored in separate aligned arrays, so each SIMD lane
+ * processes a different vector and no shuffling is needed. Portable, SSE
+ * (4 lanes) and AVX (8 lanes) versions are selected at runtime from the
+ * architecture extensions reported by AG_GetCPUInfo(3). The SIMD versions
+ * process any remainder with the portable code.
+ */
+
+#include <agar/core/core.h>
+#include <agar/math/m.h>
+
+#include <string.h>
+
+#ifdef HAVE_SSE
+# if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (__GNUC__ > 4) || \
+     (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#  define USE_AVX
+#  include <immintrin.h>
+# endif
+#endif
+
+const M_VectorOpsSoA3 *mVecOpsSoA3 = NULL;
+
+/*
+ * Portable versions (operating on the range [i0, n) of the streams).
+ */
+static void
+TransformRange(M_VectorSoA3 *_Nonnull out, const M_Matrix44 *_Nonnull T,
+    const M_VectorSoA3 *_Nonnull in, Uint i0, M_SoAReal w)
+{
+	const M_SoAReal m00 = T->m[0][0], m01 = T->m[0][1], m02 = T->m[0][2];
+	const M_SoAReal m10 = T->m[1][0], m11 = T->m[1][1], m12 = T->m[1][2];
+	const M_SoAReal m20 = T->m[2][0], m21 = T->m[2][1], m22 = T->m[2][2];
+	const M_SoAReal t0 = T->m[0][3]*w, t1 = T->m[1][3]*w, t2 = T->m[2][3]*w;
+	Uint i;
+
+	for (i = i0; i < in->n; i++) {
+		const M_SoAReal x = in->x[i], y = in->y[i], z = in->z[i];
+
+		out->x[i] = m00*x + m01*y + m02*z + t0;
+		out->y[i] = m10*x + m11*y + m12*z + t1;
+		out->z[i] = m20*x + m21*y + m22*z + t2;
+	}
+	out->n = in->n;
+}
+
+static void
+DotRange(M_SoAReal *_Nonnull d, const M_VectorSoA3 *_Nonnull A,
+    const M_VectorSoA3 *_Nonnull B, Uint i0)
+{
+	Uint i;
+
+	for (i = i0; i < A->n; i++)
+		d[i] = A->x[i]*B->x[i] + A->y[i]*B->y[i] + A->z[i]*B->z[i];
+}
+
+static void
+LenRange(M_SoAReal *_Nonnull len, const M_VectorSoA3 *_Nonnull A, Uint i0)
+{
+	Uint i;
+
+	for (i = i0; i < A->n; i++) {
+		len[i] = (M_SoAReal)M_Sqrt(A->x[i]*A->x[i] + A->y[i]*A->y[i] +
+		                           A->z[i]*A->z[i]);
+	}
+}
+
+static void
+NormRange(M_VectorSoA3 *_Nonnull out, const M_VectorSoA3 *_Nonnull A, Uint i0)
+{
+	M_SoAReal len;
+	Uint i;
+
+	for (i = i0; i < A->n; i++) {
+		len = (M_SoAReal)M_Sqrt(A->x[i]*A->x[i] + A->y[i]*A->y[i] +
+		                        A->z[i]*A->z[i]);
+		if (len == 0.0) {
+			out->x[i] = A->x[i];
+			out->y[i] = A->y[i];
+			out->z[i] = A->z[i];
+		} else {
+			out->x[i] = A->x[i]/len;
+			out->y[i] = A->y[i]/len;
+			out->z[i] = A->z[i]/len;
+		}
+	}
+	out->n = A->n;
+}
+
+static void
+CrossRange(M_VectorSoA3 *_Nonnull out, const M_VectorSoA3 *_Nonnull A,
+    const M_VectorSoA3 *_Nonnull B, Uint i0)
+{
+	Uint i;
+
+	for (i = i0; i < A->n; i++) {
+		const M_SoAReal ax = A->x[i], ay = A->y[i], az = A->z[i];
+		const M_SoAReal bx = B->x[i], by = B->y[i], bz = B->z[i];
+
+		out->x[i] = ay*bz - az*by;
+		out->y[i] = az*bx - ax*bz;
+		out->z[i] = ax*by - ay*bx;
+	}
+	out->n = A->n;
+}
+
+static void
+Transform_FPU(M_VectorSoA3 *out, const M_Matrix44 *T, const M_VectorSoA3 *in)
+{
+	TransformRange(out, T, in, 0, 1.0);
+}
+static void
+TransformDir_FPU(M_VectorSoA3 *out, const M_Matrix44 *T,
+    const M_VectorSoA3 *in)
+{
+	TransformRange(out, T, in, 0, 0.0);
+}
+static void
+Dot_FPU(M_SoAReal *d, const M_VectorSoA3 *A, const M_VectorSoA3 *B)
+{
+	DotRange(d, A, B, 0);
+}
+static void
+Len_FPU(M_SoAReal *len, const M_VectorSoA3 *A)
+{
+	LenRange(len, A, 0);
+}
+static void
+Norm_FPU(M_VectorSoA3 *out, const M_VectorSoA3 *A)
+{
+	NormRange(out, A, 0);
+}
+static void
+Cross_FPU(M_VectorSoA3 *out, const M_VectorSoA3 *A, const M_VectorSoA3 *B)
+{
+	CrossRange(out, A, B, 0);
+}
+
+const M_VectorOpsSoA3 mVecOpsSoA3_FPU = {
+	"scalar",
+	0, 0,
+	Transform_FPU,
+	TransformDir_FPU,
+	Dot_FPU,
+	Len_FPU,
+	Norm_FPU,
+	Cross_FPU
+};
+
+#ifdef HAVE_SSE
+/*
+ * SSE versions (4 vectors per iteration).
+ */
+static void
+TransformRange_SSE(M_VectorSoA3 *_Nonnull out, const M_Matrix44 *_Nonnull T,
+    const M_VectorSoA3 *_Nonnull in, float w)
+{
+	const __m128 m00 = _mm_set1_ps(T->m[0][0]), m01 = _mm_set1_ps(T->m[0][1]);
+	const __m128 m02 = _mm_set1_ps(T->m[0][2]), t0 = _mm_set1_ps(T->m[0][3]*w);
+	const __m128 m10 = _mm_set1_ps(T->m[1][0]), m11 = _mm_set1_ps(T->m[1][1]);
+	const __m128 m12 = _mm_set1_ps(T->m[1][2]), t1 = _mm_set1_ps(T->m[1][3]*w);
+	const __m128 m20 = _mm_set1_ps(T->m[2][0]), m21 = _mm_set1_ps(T->m[2][1]);
+	const __m128 m22 = _mm_set1_ps(T->m[2][2]), t2 = _mm_set1_ps(T->m[2][3]*w);
+	Uint i;
+
+	for (i = 0; i+4 <= in->n; i += 4) {
+		const __m128 x = _mm_load_ps(&in->x[i]);
+		const __m128 y = _mm_load_ps(&in->y[i]);
+		const __m128 z = _mm_load_ps(&in->z[i]);
+
+		_mm_store_ps(&out->x[i], _mm_add_ps(_mm_add_ps(
+		    _mm_mul_ps(m00,x), _mm_mul_ps(m01,y)),
+		    _mm_add_ps(_mm_mul_ps(m02,z), t0)));
+		_mm_store_ps(&out->y[i], _mm_add_ps(_mm_add_ps(
+		    _mm_mul_ps(m10,x), _mm_mul_ps(m11,y)),
+		    _mm_add_ps(_mm_mul_ps(m12,z), t1)));
+		_mm_store_ps(&out->z[i], _mm_add_ps(_mm_add_ps(
+		    _mm_mul_ps(m20,x), _mm_mul_ps(m21,y)),
+		    _mm_add_ps(_mm_mul_ps(m22,z), t2)));
+	}
+	TransformRange(out, T, in, i, w);
+}
+
+static void
+Transform_SSE(M_VectorSoA3 *out, const M_Matrix44 *T, const M_VectorSoA3 *in)
+{
+	TransformRange_SSE(out, T, in, 1.0f);
+}
+
+static void
+TransformDir_SSE(M_VectorSoA3 *out, const M_Matrix44 *T,
+    const M_VectorSoA3 *in)
+{
+	TransformRange_SSE(out, T, in, 0.0f);
+}
+
+static __inline__ __m128
+Dot4_SSE(const M_VectorSoA3 *_Nonnull A, const M_VectorSoA3 *_Nonnull B,
+    Uint i)
+{
+	return _mm_add_ps(_mm_add_ps(
+	    _mm_mul_ps(_mm_load_ps(&A->x[i]), _mm_load_ps(&B->x[i])),
+	    _mm_mul_ps(_mm_load_ps(&A->y[i]), _mm_load_ps(&B->y[i]))),
+	    _mm_mul_ps(_mm_load_ps(&A->z[i]), _mm_load_ps(&B->z[i])));
+}
+
+static void
+Dot_SSE(M_SoAReal *d, const M_VectorSoA3 *A, const M_VectorSoA3 *B)
+{
+	Uint i;
+
+	for (i = 0; i+4 <= A->n; i += 4) {
+		_mm_storeu_ps(&d[i], Dot4_SSE(A,B,i));
+	}
+	DotRange(d, A, B, i);
+}
+
+static void
+Len_SSE(M_SoAReal *len, const M_VectorSoA3 *A)
+{
+	Uint i;
+
+	for (i = 0; i+4 <= A->n; i += 4) {
+		_mm_storeu_ps(&len[i], _mm_sqrt_ps(Dot4_SSE(A,A,i)));
+	}
+	LenRange(len, A, i);
+}
+
+static void
+Norm_SSE(M_VectorSoA3 *out, const M_VectorSoA3 *A)
+{
+	const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+	Uint i;
+
+	for (i = 0; i+4 <= A->n; i += 4) {
+		const __m128 len = _mm_sqrt_ps(Dot4_SSE(A,A,i));
+		const __m128 isZero = _mm_cmpeq_ps(len, zero);
+		const __m128 s = _mm_or_ps(_mm_and_ps(isZero, one),
+		                  _mm_andnot_ps(isZero, _mm_div_ps(one, len)));
+
+		_mm_store_ps(&out->x[i], _mm_mul_ps(_mm_load_ps(&A->x[i]), s));
+		_mm_store_ps(&out->y[i], _mm_mul_ps(_mm_load_ps(&A->y[i]), s));
+		_mm_store_ps(&out->z[i], _mm_mul_ps(_mm_load_ps(&A->z[i]), s));
+	}
+	NormRange(out, A, i);
+}
+
+static void
+Cross_SSE(M_VectorSoA3 *out, const M_VectorSoA3 *A, const M_VectorSoA3 *B)
+{
+	Uint i;
+
+	for (i = 0; i+4 <= A->n; i += 4) {
+		const __m128 ax = _mm_load_ps(&A->x[i]);
+		const __m128 ay = _mm_load_ps(&A->y[i]);
+		const __m128 az = _mm_load_ps(&A->z[i]);
+		const __m128 bx = _mm_load_ps(&B->x[i]);
+		const __m128 by = _mm_load_ps(&B->y[i]);
+		const __m128 bz = _mm_load_ps(&B->z[i]);
+
+		_mm_store_ps(&out->x[i],
+		    _mm_sub_ps(_mm_mul_ps(ay,bz), _mm_mul_ps(az,by)));
+		_mm_store_ps(&out->y[i],
+		    _mm_sub_ps(_mm_mul_ps(az,bx), _mm_mul_ps(ax,bz)));
+		_mm_store_ps(&out->z[i],
+		    _mm_sub_ps(_mm_mul_ps(ax,by), _mm_mul_ps(ay,bx)));
+	}
+	CrossRange(out, A, B, i);
+}
+
+const M_VectorOpsSoA3 mVecOpsSoA3_SSE = {
+	"sse",
+	AG_EXT_SSE, 0,
+	Transform_SSE,
+	TransformDir_SSE,
+	Dot_SSE,
+	Len_SSE,
+	Norm_SSE,
+	Cross_SSE
+};
+#endif /* HAVE_SSE */
+
+#ifdef USE_AVX
+/*
+ * AVX versions (8 vectors per iteration).
+ */
+__attribute__((target("avx")))
+static void
+TransformRange_AVX(M_VectorSoA3 *_Nonnull out, const M_Matrix44 *_Nonnull T,
+    const M_VectorSoA3 *_Nonnull in, float w)
+{
+	const __m256 m00 = _mm256_set1_ps(T->m[0][0]);
+	const __m256 m01 = _mm256_set1_ps(T->m[0][1]);
+	const __m256 m02 = _mm256_set1_ps(T->m[0][2]);
+	const __m256 t0 = _mm256_set1_ps(T->m[0][3]*w);
+	const __m256 m10 = _mm256_set1_ps(T->m[1][0]);
+	const __m256 m11 = _mm256_set1_ps(T->m[1][1]);
+	const __m256 m12 = _mm256_set1_ps(T->m[1][2]);
+	const __m256 t1 = _mm256_set1_ps(T->m[1][3]*w);
+	const __m256 m20 = _mm256_set1_ps(T->m[2][0]);
+	const __m256 m21 = _mm256_set1_ps(T->m[2][1]);
+	const __m256 m22 = _mm256_set1_ps(T->m[2][2]);
+	const __m256 t2 = _mm256_set1_ps(T->m[2][3]*w);
+	Uint i;
+
+	for (i = 0; i+8 <= in->n; i += 8) {
+		const __m256 x = _mm256_load_ps(&in->x[i]);
+		const __m256 y = _mm256_load_ps(&in->y[i]);
+		const __m256 z = _mm256_load_ps(&in->z[i]);
+
+		_mm256_store_ps(&out->x[i], _mm256_add_ps(_mm256_add_ps(
+		    _mm256_mul_ps(m00,x), _mm256_mul_ps(m01,y)),
+		    _mm256_add_ps(_mm256_mul_ps(m02,z), t0)));
+		_mm256_store_ps(&out->y[i], _mm256_add_ps(_mm256_add_ps(
+		    _mm256_mul_ps(m10,x), _mm256_mul_ps(m11,y)),
+		    _mm256_add_ps(_mm256_mul_ps(m12,z), t1)));
+		_mm256_store_ps(&out->z[i], _mm256_add_ps(_mm256_add_ps(
+		    _mm256_mul_ps(m20,x), _mm256_mul_ps(m21,y)),
+		    _mm256_add_ps(_mm256_mul_ps(m22,z), t2)));
+	}
+	TransformRange(out, T, in, i, w);
+}
+
+static void
+Transform_AVX(M_VectorSoA3 *out, const M_Matrix44 *T, const M_VectorSoA3 *in)
+{
+	TransformRange_AVX(out, T, in, 1.0f);
+}
+
+static void
+TransformDir_AVX(M_VectorSoA3 *out, const M_Matrix44 *T,
+    const M_VectorSoA3 *in)
+{
+	TransformRange_AVX(out, T, in, 0.0f);
+}
+
+__attribute__((target("avx")))
+static __inline__ __m256
+Dot8_AVX(const M_VectorSoA3 *_Nonnull A, const M_VectorSoA3 *_Nonnull B,
+    Uint i)
+{
+	return _mm256_add_ps(_mm256_add_ps(
+	    _mm256_mul_ps(_mm256_load_ps(&A->x[i]), _mm256_load_ps(&B->x[i])),
+	    _mm256_mul_ps(_mm256_load_ps(&A->y[i]), _mm256_load_ps(&B->y[i]))),
+	    _mm256_mul_ps(_mm256_load_ps(&A->z[i]), _mm256_load_ps(&B->z[i])));
+}
+
+__attribute__((target("avx")))
+static void
+Dot_AVX(M_SoAReal *d, const M_VectorSoA3 *A, const M_VectorSoA3 *B)
+{
+	Uint i;
+
+	for (i = 0; i+8 <= A->n; i += 8) {
+		_mm256_storeu_ps(&d[i], Dot8_AVX(A,B,i));
+	}
+	DotRange(d, A, B, i);
+}
+
+__attribute__((target("avx")))
+static void
+Len_AVX(M_SoAReal *len, const M_VectorSoA3 *A)
+{
+	Uint i;
+
+	for (i = 0; i+8 <= A->n; i += 8) {
+		_mm256_storeu_ps(&len[i], _mm256_sqrt_ps(Dot8_AVX(A,A,i)));
+	}
+	LenRange(len, A, i);
+}
+
+__attribute__((target("avx")))
+static void
+Norm_AVX(M_VectorSoA3 *out, const M_VectorSoA3 *A)
+{
+	const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+	Uint i;
+
+	for (i = 0; i+8 <= A->n; i += 8) {
+		const __m256 len = _mm256_sqrt_ps(Dot8_AVX(A,A,i));
+		const __m256 s = _mm256_blendv_ps(_mm256_div_ps(one, len), one,
+		    _mm256_cmp_ps(len, zero, _CMP_EQ_OQ));
+
+		_mm256_store_ps(&out->x[i],
+		    _mm256_mul_ps(_mm256_load_ps(&A->x[i]), s));
+		_mm256_store_ps(&out->y[i],
+		    _mm256_mul_ps(_mm256_load_ps(&A->y[i]), s));
+		_mm256_store_ps(&out->z[i],
+		    _mm256_mul_ps(_mm256_load_ps(&A->z[i]), s));
+	}
+	NormRange(out, A, i);
+}
+
+__attribute__((target("avx")))
+static void
+Cross_AVX(M_VectorSoA3 *out, const M_VectorSoA3 *A, const M_VectorSoA3 *B)
+{
+	Uint i;
+
+	for (i = 0; i+8 <= A->n; i += 8) {
+		const __m256 ax = _mm256_load_ps(&A->x[i]);
+		const __m256 ay = _mm256_load_ps(&A->y[i]);
+		const __m256 az = _mm256_load_ps(&A->z[i]);
+		const __m256 bx = _mm256_load_ps(&B->x[i]);
+		const __m256 by = _mm256_load_ps(&B->y[i]);
+		const __m256 bz = _mm256_load_ps(&B->z[i]);
+
+		_mm256_store_ps(&out->x[i],
+		    _mm256_sub_ps(_mm256_mul_ps(ay,bz), _mm256_mul_ps(az,by)));
+		_mm256_store_ps(&out->y[i],
+		    _mm256_sub_ps(_mm256_mul_ps(az,bx), _mm256_mul_ps(ax,bz)));
+		_mm256_store_ps(&out->z[i],
+		    _mm256_sub_ps(_mm256_mul_ps(ax,by), _mm256_mul_ps(ay,bx)));
+	}
+	CrossRange(out, A, B, i);
+}
+
+static const M_VectorOpsSoA3 mVecOpsSoA3_AVX = {
+	"avx",
+	AG_EXT_AVX, 0,
+	Transform_AVX,
+	TransformDir_AVX,
+	Dot_AVX,
+	Len_AVX,
+	Norm_AVX,
+	Cross_AVX
+};
+#endif /* USE_AVX */
+
+/* Available backends in order of preference (NULL-terminated). */
+const M_VectorOpsSoA3 *mVecOpsSoA3List[] = {
+#ifdef USE_AVX
+	&mVecOpsSoA3_AVX,
+#endif
+#ifdef HAVE_SSE
+	&mVecOpsSoA3_SSE,
+#endif
+	&mVecOpsSoA3_FPU,
+	NULL
+};
+
+/* Select the fastest backend supported by the CPU. */
+void
+M_VectorInitEngineSoA3(void)
+{
+	const M_VectorOpsSoA3 **ops;
+
+	for (ops = &mVecOpsSoA3List[0]; *ops != NULL; ops++) {
+		if (((*ops)->ext & agCPU.ext) == (*ops)->ext)
+			break;
+	}
+	mVecOpsSoA3 = (*ops != NULL) ? *ops : &mVecOpsSoA3_FPU;
+}
+
+/* Initialize a stream of n vectors (undefined contents). */
+int
+M_VectorSoAInit3(M_VectorSoA3 *S, Uint n)
+{
+	S->n = 0;
+	S->maxN = 0;
+	S->x = NULL;
+	S->y = NULL;
+	S->z = NULL;
+	S->mem = NULL;
+	return M_VectorSoAResize3(S, n);
+}
+
+/*
+ * Resize a stream to n vectors, preserving existing entries. Component
+ * arrays are padded to a multiple of M_VECTOR_SOA_PAD entries, and
+ * aligned on M_VECTOR_SOA_ALIGN bytes.
+ */
+int
+M_VectorSoAResize3(M_VectorSoA3 *S, Uint n)
+{
+	AG_Size len, addr;
+	M_SoAReal *x;
+	void *mem;
+	Uint maxN;
+
+	if (n <= S->maxN) {
+		S->n = n;
+		return (0);
+	}
+	maxN = (n + M_VECTOR_SOA_PAD-1) / M_VECTOR_SOA_PAD * M_VECTOR_SOA_PAD;
+	len = (AG_Size)maxN * sizeof(M_SoAReal);
+	len = (len + M_VECTOR_SOA_ALIGN-1) & ~(AG_Size)(M_VECTOR_SOA_ALIGN-1);
+	if ((mem = TryMalloc(len*3 + M_VECTOR_SOA_ALIGN-1)) == NULL) {
+		return (-1);
+	}
+	addr = ((AG_Size)mem + M_VECTOR_SOA_ALIGN-1) &
+	       ~(AG_Size)(M_VECTOR_SOA_ALIGN-1);
+	x = (M_SoAReal *)addr;
+	if (S->n > 0) {
+		memcpy(x, S->x, S->n*sizeof(M_SoAReal));
+		memcpy((Uint8 *)x + len, S->y, S->n*sizeof(M_SoAReal));
+		memcpy((Uint8 *)x + len*2, S->z, S->n*sizeof(M_SoAReal));
+	}
+	Free(S->mem);
+	S->mem = mem;
+	S->x = x;
+	S->y = (M_SoAReal *)((Uint8 *)x + len);
+	S->z = (M_SoAReal *)((Uint8 *)x + len*2);
+	S->maxN = maxN;
+	S->n = n;
+	return (0);
+}
+
+/* Release the arrays of a stream. */
+void
+M_VectorSoAFree3(M_VectorSoA3 *S)
+{
+	Free(S->mem);
+	S->mem = NULL;
+	S->x = NULL;
+	S->y = NULL;
+	S->z = NULL;
+	S->n = 0;
+	S->maxN = 0;
+}
+
+/*
+ * Load a stream from n M_Vector3 structures, stride bytes apart, starting
+ * at v (e.g., the positions in an array of vertices).
+ */
+int
+M_VectorSoAGather3(M_VectorSoA3 *S, const void *v, AG_Size stride, Uint n)
+{
+	const Uint8 *p = v;
+	Uint i;
+
+	if (M_VectorSoAResize3(S, n) == -1) {
+		return (-1);
+	}
+	for (i = 0; i < n; i++) {
+		const M_Vector3 *pv = (const M_Vector3 *)p;
+
+		S->x[i] = pv->x;
+		S->y[i] = pv->y;
+		S->z[i] = pv->z;
+		p += stride;
+	}
+	return (0);
+}
+
+/* Store the vectors of a stream into M_Vector3 structures, stride apart. */
+void
+M_VectorSoAScatter3(void *v, AG_Size stride, const M_VectorSoA3 *S)
+{
+	Uint8 *p = v;
+	Uint i;
+
+	for (i = 0; i < S->n; i++) {
+		M_Vector3 *pv = (M_Vector3 *)p;
+
+		pv->x = S->x[i];
+		pv->y = S->y[i];
+		pv->z = S->z[i];
+		p += stride;
+	}
+}
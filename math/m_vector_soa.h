@@ -0,0 +1,99 @@
+/*	Public domain	*/
+/*
+ * Batched operations on streams of vectors in R^3, stored as a structure
+ * of arrays (one array per component).
+ */
+
+#define M_VECTOR_SOA_ALIGN 32		/* Alignment of component arrays */
+#define M_VECTOR_SOA_PAD   8		/* Arrays are padded to a multiple */
+
+#ifdef HAVE_SSE
+typedef float M_SoAReal;		/* Same as M_Vector3 components */
+#else
+typedef M_Real M_SoAReal;
+#endif
+
+typedef struct m_vector_soa3 {
+	Uint n;				/* Number of vectors */
+	Uint maxN;			/* Allocated entries per array */
+	M_SoAReal *_Nullable x;		/* X components (aligned) */
+	M_SoAReal *_Nullable y;		/* Y components (aligned) */
+	M_SoAReal *_Nullable z;		/* Z components (aligned) */
+	void *_Nullable mem;		/* Allocated block */
+} M_VectorSoA3;
+
+/*
+ * Batched operations on M_VectorSoA3 streams. Outputs must be allocated
+ * for at least as many vectors as the inputs, and may be the same as
+ * an input.
+ */
+typedef struct m_vector_ops_soa3 {
+	const char *_Nonnull name;
+	Uint32 ext;			/* Required AG_EXT_* extensions */
+	Uint32 _pad;
+
+	void (*_Nonnull Transform)(M_VectorSoA3 *_Nonnull,
+	                           const M_Matrix44 *_Nonnull,
+	                           const M_VectorSoA3 *_Nonnull);
+	void (*_Nonnull TransformDir)(M_VectorSoA3 *_Nonnull,
+	                              const M_Matrix44 *_Nonnull,
+	                              const M_VectorSoA3 *_Nonnull);
+	void (*_Nonnull Dot)(M_SoAReal *_Nonnull, const M_VectorSoA3 *_Nonnull,
+	                     const M_VectorSoA3 *_Nonnull);
+	void (*_Nonnull Len)(M_SoAReal *_Nonnull, const M_VectorSoA3 *_Nonnull);
+	void (*_Nonnull Norm)(M_VectorSoA3 *_Nonnull,
+	                      const M_VectorSoA3 *_Nonnull);
+	void (*_Nonnull Cross)(M_VectorSoA3 *_Nonnull,
+	                       const M_VectorSoA3 *_Nonnull,
+	                       const M_VectorSoA3 *_Nonnull);
+} M_VectorOpsSoA3;
+
+__BEGIN_DECLS
+extern const M_VectorOpsSoA3 *_Nullable mVecOpsSoA3;
+extern const M_VectorOpsSoA3 mVecOpsSoA3_FPU;
+#ifdef HAVE_SSE
+extern const M_VectorOpsSoA3 mVecOpsSoA3_SSE;
+#endif
+extern const M_VectorOpsSoA3 *_Nonnull mVecOpsSoA3List[];
+
+void M_VectorInitEngineSoA3(void);
+
+int  M_VectorSoAInit3(M_VectorSoA3 *_Nonnull, Uint);
+int  M_VectorSoAResize3(M_VectorSoA3 *_Nonnull, Uint);
+void M_VectorSoAFree3(M_VectorSoA3 *_Nonnull);
+int  M_VectorSoAGather3(M_VectorSoA3 *_Nonnull, const void *_Nonnull,
+                        AG_Size, Uint);
+void M_VectorSoAScatter3(void *_Nonnull, AG_Size,
+                         const M_VectorSoA3 *_Nonnull);
+
+/* Return vector i of a stream. */
+static __inline__ M_Vector3
+M_VectorSoAGet3(const M_VectorSoA3 *_Nonnull S, Uint i)
+{
+	M_Vector3 v;
+
+	v.x = S->x[i];
+	v.y = S->y[i];
+	v.z = S->z[i];
+#ifdef HAVE_SSE
+	v._pad = 0.0f;
+#endif
+	return (v);
+}
+
+/* Set vector i of a stream. */
+static __inline__ void
+M_VectorSoASet3(M_VectorSoA3 *_Nonnull S, Uint i, M_Vector3 v)
+{
+	S->x[i] = v.x;
+	S->y[i] = v.y;
+	S->z[i] = v.z;
+}
+__END_DECLS
+
+#define M_VecSoATransform3	mVecOpsSoA3->Transform
+#define M_VecSoATransformDir3	mVecOpsSoA3->TransformDir
+#define M_VecSoADot3		mVecOpsSoA3->Dot
+#define M_VecSoALen3		mVecOpsSoA3->Len
+#define M_VecSoANorm3		mVecOpsSoA3->Norm
+#define M_VecSoACross3		mVecOpsSoA3->Cross
@@ -88,6 +88,8 @@ SelectNode(AG_Event *_Nonnull event)
 
 		AG_ObjectLock(f->obj);
 		AG_SETFLAGS(f->flags, SG_FACET_SELECTED, state);
+		if (state)
+			f->obj->va.flags |= SG_OBJECT_ARRAYS_FSEL;
 		AG_ObjectUnlock(f->obj);
 	}
 }
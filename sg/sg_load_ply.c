@@ -846,6 +846,7 @@ SG_ObjectLoadPLY(void *obj, const char *path, Uint flags)
 		}
 		break;
 	}
+	SG_ObjectDirtyVertices(so, 0, so->nVtx);
 	AG_ObjectUnlock(so);
 
 	fclose(f);
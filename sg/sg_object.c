@@ -142,6 +142,18 @@ Init(void *_Nonnull obj)
 	so->tex = NULL;
 	so->bsp = NULL;
 
+	so->va.flags = SG_OBJECT_ARRAYS_IDX;
+	so->va.vtxMin = 0;
+	so->va.vtxMax = 0;
+	so->va.nVtx = 0;
+	so->va.maxVtx = 0;
+	so->va.nIdx = 0;
+	so->va.maxIdx = 0;
+	so->va.idxSerial = 0;
+	so->va.vtx = NULL;
+	so->va.idx = NULL;
+	TAILQ_INIT(&so->va.vbuf);
+
 	AG_SetEvent(so, "edit-list-poll", EditListPoll, NULL);
 }
 
@@ -221,6 +233,7 @@ SG_VertexNewv(void *obj, const M_Vector3 *vNew)
 	vtx->v.z = vNew->z;
 	rv = (int)(so->nVtx++);
 out:
+	SG_ObjectDirtyVertices(so, (Uint)rv, 1);
 	AG_ObjectUnlock(so);
 	return (rv);
 }
@@ -458,7 +471,8 @@ SG_FacetDelete(SG_Facet *f)
 	fe = &so->facetTbl[SG_HashFacet(so,f)];
 	SLIST_REMOVE(&fe->facets, f, sg_facet, facets);
 	Free(f);
-	
+
+	so->va.flags |= SG_OBJECT_ARRAYS_IDX;
 	AG_ObjectUnlock(so);
 }
 
@@ -501,6 +515,7 @@ SG_FacetFromTri3(void *obj, int v1, int v2, int v3)
 	fe = &so->facetTbl[SG_HashTriangle(so, v1,v2,v3)];
 	SLIST_INSERT_HEAD(&fe->facets, f, facets);
 
+	so->va.flags |= SG_OBJECT_ARRAYS_IDX;
 	AG_ObjectUnlock(so);
 	return (f);
 }
@@ -536,7 +551,8 @@ SG_FacetFromQuad4(void *obj, int v1, int v2, int v3, int v4)
 	
 	fe = &so->facetTbl[SG_HashQuad(so, v1,v2,v3,v4)];
 	SLIST_INSERT_HEAD(&fe->facets, f, facets);
-	
+
+	so->va.flags |= SG_OBJECT_ARRAYS_IDX;
 	AG_ObjectUnlock(so);
 	return (f);
 }
@@ -693,6 +709,7 @@ SG_ObjectNormalize(void *obj)
 			FACET_N(so,f,i) = n;
 		}
 	}
+	SG_ObjectDirtyVertices(so, 0, so->nVtx);
 	AG_ObjectUnlock(so);
 	return (0);
 }
@@ -950,7 +967,131 @@ SG_ObjectFreeGeometry(void *p)
 	/* Free the vertices */
 	so->vtx = Realloc(so->vtx, sizeof(SG_Vertex));
 	so->nVtx = 1;
-	
+
+	SG_ObjectFreeArrays(so);
+
+	AG_ObjectUnlock(so);
+}
+
+static __inline__ void
+DirtyRange(Uint *_Nonnull min, Uint *_Nonnull max, Uint first, Uint last)
+{
+	if (*min >= *max) {
+		*min = first;
+		*max = last;
+	} else {
+		if (first < *min) { *min = first; }
+		if (last > *max)  { *max = last; }
+	}
+}
+
+/*
+ * Mark count vertices starting at first as modified, so that the retained
+ * vertex arrays and buffer objects are updated before the next draw. This
+ * must be called after writing to the vtx[] array directly.
+ */
+void
+SG_ObjectDirtyVertices(void *obj, Uint first, Uint count)
+{
+	SG_Object *so = obj;
+	SG_ViewBuffer *vb;
+	const Uint last = first + count;
+
+	if (count == 0)
+		return;
+
+	AG_ObjectLock(so);
+	DirtyRange(&so->va.vtxMin, &so->va.vtxMax, first, last);
+	TAILQ_FOREACH(vb, &so->va.vbuf, buffers) {
+		DirtyRange(&vb->vtxMin, &vb->vtxMax, first, last);
+	}
+	AG_ObjectUnlock(so);
+}
+
+/*
+ * Request a rebuild of the retained index array before the next draw.
+ * This must be called after modifying the facet tables directly.
+ */
+void
+SG_ObjectDirtyFacets(void *obj)
+{
+	SG_Object *so = obj;
+
+	AG_ObjectLock(so);
+	so->va.flags |= SG_OBJECT_ARRAYS_IDX;
+	AG_ObjectUnlock(so);
+}
+
+/* Queue the buffer objects of a view for deletion and free the entry. */
+static void
+FreeViewBuffer(SG_ViewBuffer *_Nonnull vb)
+{
+	SG_View *sv = vb->sv;
+
+	AG_ObjectLock(sv);
+	sv->bufGC = Realloc(sv->bufGC, (sv->nBufGC + 2)*sizeof(Uint));
+	if (vb->vbo != 0) { sv->bufGC[sv->nBufGC++] = vb->vbo; }
+	if (vb->ibo != 0) { sv->bufGC[sv->nBufGC++] = vb->ibo; }
+	AG_ObjectUnlock(sv);
+
+	Free(vb);
+}
+
+/*
+ * Release the retained vertex and index arrays, and queue any per-view
+ * buffer objects for deletion. The arrays are regenerated on the next draw.
+ */
+void
+SG_ObjectFreeArrays(void *obj)
+{
+	SG_Object *so = obj;
+	SG_ObjectArrays *va = &so->va;
+	SG_ViewBuffer *vb, *vbNext;
+
+	AG_ObjectLock(so);
+
+	for (vb = TAILQ_FIRST(&va->vbuf);
+	     vb != TAILQ_END(&va->vbuf);
+	     vb = vbNext) {
+		vbNext = TAILQ_NEXT(vb, buffers);
+		FreeViewBuffer(vb);
+	}
+	TAILQ_INIT(&va->vbuf);
+
+	Free(va->vtx);
+	Free(va->idx);
+	va->vtx = NULL;
+	va->idx = NULL;
+	va->flags = SG_OBJECT_ARRAYS_IDX | SG_OBJECT_ARRAYS_FSEL;
+	va->vtxMin = 0;
+	va->vtxMax = 0;
+	va->nVtx = 0;
+	va->maxVtx = 0;
+	va->nIdx = 0;
+	va->maxIdx = 0;
+
+	AG_ObjectUnlock(so);
+}
+
+/*
+ * Forget about the buffer objects associated with a view which is being
+ * destroyed (the GL context goes away along with the buffer objects).
+ */
+void
+SG_ObjectReleaseView(void *obj, SG_View *sv)
+{
+	SG_Object *so = obj;
+	SG_ViewBuffer *vb;
+
+	AG_ObjectLock(so);
+	TAILQ_FOREACH(vb, &so->va.vbuf, buffers) {
+		if (vb->sv == sv)
+			break;
+	}
+	if (vb != NULL) {
+		TAILQ_REMOVE(&so->va.vbuf, vb, buffers);
+		Free(vb);
+	}
 	AG_ObjectUnlock(so);
 }
 
@@ -1303,17 +1444,13 @@ DrawObjectVertices(SG_Object *_Nonnull so)
 	GL_PointSize(pointSize);
 }
 
+/* Render the facets in immediate mode (one primitive per facet). */
 static void
-Draw(void *_Nonnull p, SG_View *_Nonnull view)
+DrawImmediate(SG_Object *_Nonnull so)
 {
-	SG_Object *so = p;
-	SG *sg = view->sg;
 	SG_Facet *f;
-	Uint fi, j;
+	Uint fi;
 
-	if (so->tex != NULL) {
-		SG_TextureBind(so->tex, view);
-	}
 	SG_FOREACH_FACET(f, fi, so) {
 		switch (f->n) {
 		case 3:
@@ -1332,6 +1469,17 @@ Draw(void *_Nonnull p, SG_View *_Nonnull view)
 			GL_End();
 			break;
 		}
+	}
+}
+
+/* Draw facet normals and selected facet outlines. */
+static void
+DrawFacetOverlays(SG_Object *_Nonnull so, SG *_Nonnull sg)
+{
+	SG_Facet *f;
+	Uint fi, j, nSel = 0;
+
+	SG_FOREACH_FACET(f, fi, so) {
 		if (sg->flags & SG_OVERLAY_FNORMALS)
 			DrawFacetNormals(so, f);
 
@@ -1346,11 +1494,246 @@ Draw(void *_Nonnull p, SG_View *_Nonnull view)
 			GL_End();
 			glLineWidth(1.0);
 			glEnable(GL_LIGHTING);
+			nSel++;
 		}
 	}
+	if (nSel == 0)
+		so->va.flags &= ~(SG_OBJECT_ARRAYS_FSEL);
+}
+
+/* Convert a vertex to the GL_T2F_C4F_N3F_V3F interleaved format. */
+static __inline__ void
+ConvVertex(float *_Nonnull d, const SG_Vertex *_Nonnull v)
+{
+	d[0] = (float)v->st.x;
+	d[1] = (float)v->st.y;
+	d[2] = (float)v->c.r;
+	d[3] = (float)v->c.g;
+	d[4] = (float)v->c.b;
+	d[5] = (float)v->c.a;
+	d[6] = (float)v->n.x;
+	d[7] = (float)v->n.y;
+	d[8] = (float)v->n.z;
+	d[9] = (float)v->v.x;
+	d[10] = (float)v->v.y;
+	d[11] = (float)v->v.z;
+}
+
+/*
+ * Bring the retained vertex and index arrays up to date. Only vertices in
+ * the dirty range (and vertices appended since the last update) are
+ * converted. The index array is rebuilt only if the facets have changed.
+ */
+static int
+UpdateArrays(SG_Object *_Nonnull so)
+{
+	SG_ObjectArrays *va = &so->va;
+	SG_Facet *f;
+	Uint i, fi, last, nIdx;
+
+	if (so->nVtx > va->maxVtx) {
+		Uint maxNew = (va->maxVtx > 0) ? va->maxVtx : 64;
+		float *vtxNew;
+
+		while (maxNew < so->nVtx) {
+			maxNew <<= 1;
+		}
+		vtxNew = TryRealloc(va->vtx,
+		    maxNew*SG_OBJECT_ARRAYS_STRIDE*sizeof(float));
+		if (vtxNew == NULL) {
+			return (-1);
+		}
+		va->vtx = vtxNew;
+		va->maxVtx = maxNew;
+	}
+	if (so->nVtx > va->nVtx) {
+		SG_ObjectDirtyVertices(so, va->nVtx, so->nVtx - va->nVtx);
+	}
+	va->nVtx = so->nVtx;
+
+	last = MIN(va->vtxMax, va->nVtx);
+	for (i = va->vtxMin; i < last; i++) {
+		ConvVertex(&va->vtx[i*SG_OBJECT_ARRAYS_STRIDE], &so->vtx[i]);
+	}
+	va->vtxMin = 0;
+	va->vtxMax = 0;
+
+	if ((va->flags & SG_OBJECT_ARRAYS_IDX) == 0)
+		return (0);
+
+	nIdx = 0;
+	SG_FOREACH_FACET(f, fi, so) {
+		nIdx += (f->n == 4) ? 6 : 3;
+	}
+	if (nIdx > va->maxIdx) {
+		Uint *idxNew;
+
+		if ((idxNew = TryRealloc(va->idx, nIdx*sizeof(Uint))) == NULL) {
+			return (-1);
+		}
+		va->idx = idxNew;
+		va->maxIdx = nIdx;
+	}
+	i = 0;
+	SG_FOREACH_FACET(f, fi, so) {
+		Uint *idx = &va->idx[i];
+
+		idx[0] = (Uint)f->e[0]->v;
+		idx[1] = (Uint)f->e[1]->v;
+		idx[2] = (Uint)f->e[2]->v;
+		if (f->n == 4) {
+			idx[3] = (Uint)f->e[0]->v;
+			idx[4] = (Uint)f->e[2]->v;
+			idx[5] = (Uint)f->e[3]->v;
+			i += 6;
+		} else {
+			i += 3;
+		}
+	}
+	va->nIdx = nIdx;
+	va->idxSerial++;
+	va->flags &= ~(SG_OBJECT_ARRAYS_IDX);
+	return (0);
+}
+
+#if defined(HAVE_GLEXT) && defined(GL_ARRAY_BUFFER)
+/* Test whether buffer objects are usable in the GL context of a view. */
+static int
+HaveBuffers(SG_View *_Nonnull sv)
+{
+	if (sv->haveBuffers == -1) {
+		const char *s = (const char *)glGetString(GL_VERSION);
+		const char *dot;
+		int major, minor;
+
+		if (s == NULL || (dot = strchr(s, '.')) == NULL) {
+			sv->haveBuffers = 0;
+			return (0);
+		}
+		major = atoi(s);
+		minor = atoi(&dot[1]);
+		sv->haveBuffers = (major > 1 || (major == 1 && minor >= 5));
+	}
+	return (sv->haveBuffers);
+}
+
+/*
+ * Render from vertex and index buffer objects private to the view,
+ * uploading the modified vertex range and the index array if needed.
+ */
+static int
+DrawBuffers(SG_Object *_Nonnull so, SG_View *_Nonnull sv)
+{
+	SG_ObjectArrays *va = &so->va;
+	SG_ViewBuffer *vb;
+	const GLenum usage = (so->flags & SG_OBJECT_STATIC) ? GL_STATIC_DRAW :
+	                                                      GL_DYNAMIC_DRAW;
+	const GLsizeiptr vtxSize = SG_OBJECT_ARRAYS_STRIDE*sizeof(float);
+
+	TAILQ_FOREACH(vb, &va->vbuf, buffers) {
+		if (vb->sv == sv)
+			break;
+	}
+	if (vb == NULL) {
+		if ((vb = TryMalloc(sizeof(SG_ViewBuffer))) == NULL) {
+			return (-1);
+		}
+		vb->node = so;
+		vb->sv = sv;
+		glGenBuffers(1, (GLuint *)&vb->vbo);
+		glGenBuffers(1, (GLuint *)&vb->ibo);
+		vb->maxVtx = 0;
+		vb->nIdx = 0;
+		vb->idxSerial = va->idxSerial - 1;
+		vb->vtxMin = 0;
+		vb->vtxMax = 0;
+		TAILQ_INSERT_TAIL(&va->vbuf, vb, buffers);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, vb->vbo);
+	if (va->nVtx > vb->maxVtx) {
+		glBufferData(GL_ARRAY_BUFFER, va->maxVtx*vtxSize, NULL, usage);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, va->nVtx*vtxSize, va->vtx);
+		vb->maxVtx = va->maxVtx;
+		vb->vtxMin = 0;
+		vb->vtxMax = 0;
+	} else if (vb->vtxMin < vb->vtxMax) {
+		const Uint last = MIN(vb->vtxMax, va->nVtx);
+
+		if (vb->vtxMin < last) {
+			glBufferSubData(GL_ARRAY_BUFFER,
+			    vb->vtxMin*vtxSize,
+			    (last - vb->vtxMin)*vtxSize,
+			    &va->vtx[vb->vtxMin*SG_OBJECT_ARRAYS_STRIDE]);
+		}
+		vb->vtxMin = 0;
+		vb->vtxMax = 0;
+	}
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vb->ibo);
+	if (vb->idxSerial != va->idxSerial) {
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, va->nIdx*sizeof(GLuint),
+		    va->idx, usage);
+		vb->nIdx = va->nIdx;
+		vb->idxSerial = va->idxSerial;
+	}
+
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+	glInterleavedArrays(GL_T2F_C4F_N3F_V3F, 0, NULL);
+	glDrawElements(GL_TRIANGLES, vb->nIdx, GL_UNSIGNED_INT, NULL);
+	glPopClientAttrib();
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return (0);
+}
+#endif /* HAVE_GLEXT and GL_ARRAY_BUFFER */
+
+/* Render the facets from the retained arrays. */
+static void
+DrawArrays(SG_Object *_Nonnull so, SG_View *_Nonnull view)
+{
+	if (UpdateArrays(so) == -1) {
+		DrawImmediate(so);
+		return;
+	}
+	if (so->va.nIdx == 0)
+		return;
+
+#if defined(HAVE_GLEXT) && defined(GL_ARRAY_BUFFER)
+	if ((so->flags & SG_OBJECT_NO_BUFFERS) == 0 && HaveBuffers(view) &&
+	    DrawBuffers(so, view) == 0)
+		return;
+#endif
+	/* Fall back to client-side arrays. */
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+	glInterleavedArrays(GL_T2F_C4F_N3F_V3F, 0, so->va.vtx);
+	glDrawElements(GL_TRIANGLES, so->va.nIdx, GL_UNSIGNED_INT, so->va.idx);
+	glPopClientAttrib();
+}
+
+static void
+Draw(void *_Nonnull p, SG_View *_Nonnull view)
+{
+	SG_Object *so = p;
+	SG *sg = view->sg;
+
+	AG_ObjectLock(so);
+
+	if (so->tex != NULL) {
+		SG_TextureBind(so->tex, view);
+	}
+	if (so->flags & SG_OBJECT_IMMEDIATE) {
+		DrawImmediate(so);
+	} else {
+		DrawArrays(so, view);
+	}
 	if (so->tex != NULL) {
 		SG_TextureUnbind(so->tex, view);
 	}
+	if ((sg->flags & SG_OVERLAY_FNORMALS) ||
+	    (so->va.flags & SG_OBJECT_ARRAYS_FSEL))
+		DrawFacetOverlays(so, sg);
 	if (SGNODE_SELECTED(so))
 		DrawObjectSilouhette(so, view);
 	if (sg->flags & SG_OVERLAY_WIREFRAME)
@@ -1359,13 +1742,8 @@ Draw(void *_Nonnull p, SG_View *_Nonnull view)
 		DrawObjectVertices(so);
 	if (sg->flags & SG_OVERLAY_VNORMALS)
 		DrawVertexNormals(so);
-#if 0
-	glInterleavedArrays(GL_T2F_N3F_V3F, SG_VERTEX_STRIDE,
-	    (const GLvoid *)so->vtx);
-	SLIST_FOREACH(prim, &so->prims, prims) {
-		glDrawArrays(prim->type, 0, prim->n);
-	}
-#endif
+
+	AG_ObjectUnlock(so);
 }
 
 static int
@@ -56,6 +56,26 @@ typedef struct sg_bsp_node {
 	AG_TAILQ_ENTRY(sg_bsp_node) bsp;	/* In parent node */
 } SG_BSPNode;
 
+/*
+ * Retained vertex and index arrays. The vertex array mirrors vtx[] in the
+ * GL_T2F_C4F_N3F_V3F interleaved format and the index array lists the
+ * facets as triangles. Both are updated lazily from Draw().
+ */
+typedef struct sg_object_arrays {
+	Uint flags;
+#define SG_OBJECT_ARRAYS_IDX	0x01	/* Index array must be rebuilt */
+#define SG_OBJECT_ARRAYS_FSEL	0x02	/* Some facets may be selected */
+	Uint vtxMin, vtxMax;		/* Dirty vertex range (first, last+1) */
+	Uint nVtx, maxVtx;		/* Converted / allocated vertices */
+	Uint nIdx, maxIdx;		/* Triangle indices / allocated */
+	Uint idxSerial;			/* Incremented on index rebuild */
+	float *_Nullable vtx;		/* Interleaved vertex array */
+	Uint  *_Nullable idx;		/* Triangle index array */
+	AG_TAILQ_HEAD_(sg_view_buffer) vbuf;	/* Per-view buffer objects */
+} SG_ObjectArrays;
+
+#define SG_OBJECT_ARRAYS_STRIDE	12	/* Floats per vertex (T2F_C4F_N3F_V3F) */
+
 typedef struct sg_object {
 	struct sg_node _inherit;	/* SG_Node -> SG_Object */
 
@@ -63,6 +83,8 @@ typedef struct sg_object {
 #define SG_OBJECT_STATIC	0x01	/* Geometry is unchanging */
 #define SG_OBJECT_NODUPVERTEX	0x02	/* Check for duplicate vertices in
 					   SG_VertexNew*() */
+#define SG_OBJECT_NO_BUFFERS	0x04	/* Render from client-side arrays */
+#define SG_OBJECT_IMMEDIATE	0x08	/* Render in immediate mode */
 	Uint               nVtx;
 	SG_Vertex *_Nonnull vtx;	/* Vertex array */
 	SG_EdgeEnt *_Nonnull edgeTbl;	/* Edge table */
@@ -71,6 +93,7 @@ typedef struct sg_object {
 	SG_FacetEnt *_Nonnull facetTbl;	/* Facet table */
 	SG_Texture *_Nullable tex;	/* Associated texture */
 	SG_BSPNode *_Nullable bsp;	/* Root BSP node */
+	SG_ObjectArrays va;		/* Retained vertex/index arrays */
 	Uint8 _pad[8];
 } SG_Object;
 
@@ -140,6 +163,10 @@ int  SG_ObjectCheckConnectivity(void *_Nonnull, struct ag_console *_Nonnull);
 int  SG_ObjectNormalize(void *_Nonnull);
 Uint SG_ObjectConvQuadsToTriangles(void *_Nonnull);
 void SG_ObjectFreeGeometry(void *_Nonnull);
+void SG_ObjectDirtyVertices(void *_Nonnull, Uint, Uint);
+void SG_ObjectDirtyFacets(void *_Nonnull);
+void SG_ObjectFreeArrays(void *_Nonnull);
+void SG_ObjectReleaseView(void *_Nonnull, struct sg_view *_Nonnull);
 void SG_ObjectMenuInstance(void *_Nonnull, struct ag_menu_item *_Nonnull,
                            struct sg_view *_Nonnull);
 
@@ -309,6 +309,12 @@ Draw(void *_Nonnull obj)
 
 #ifdef AG_DEBUG
 /*	Debug(sv, "Draw %s(%s)\n", sg ? OBJECT(sg)->name : "NULL", sv->cam ? OBJECT(sv->cam)->name : ""); */
+#endif
+#if defined(HAVE_GLEXT) && defined(GL_ARRAY_BUFFER)
+	if (sv->nBufGC > 0) {			/* Deferred buffer deletion */
+		glDeleteBuffers(sv->nBufGC, (GLuint *)sv->bufGC);
+		sv->nBufGC = 0;
+	}
 #endif
 	GL_PushAttrib(GL_ENABLE_BIT | GL_POLYGON_BIT);
 
@@ -783,6 +789,9 @@ Init(void *_Nonnull obj)
 	sv->transDuration = 500;
 	sv->pmView = NULL;
 	sv->pmNode = NULL;
+	sv->haveBuffers = -1;
+	sv->nBufGC = 0;
+	sv->bufGC = NULL;
 	AG_InitTimer(&sv->toTransFade, "transFade", 0);
 	AG_InitTimer(&sv->toRefresh, "refresh", 0);
 
@@ -817,11 +826,37 @@ Init(void *_Nonnull obj)
 /*	AG_RedrawOnTick(sv, 1000); */
 }
 
+/*
+ * Detach the per-view buffer objects of the nodes of a scene from a view
+ * that is being destroyed.
+ */
+static void
+ReleaseBuffers(SG_View *_Nonnull sv, SG *_Nullable sg)
+{
+	SG_Node *node;
+
+	if (sg == NULL)
+		return;
+
+	AG_ObjectLock(sg);
+	SG_FOREACH_NODE(node, sg) {
+		if (AG_OfClass(node, "SG_Node:SG_Object:*"))
+			SG_ObjectReleaseView(node, sv);
+	}
+	AG_ObjectUnlock(sg);
+}
+
 static void
 Destroy(void *_Nonnull obj)
 {
 	SG_View *sv = obj;
-	
+
+	ReleaseBuffers(sv, sv->sg);
+	if (sv->sgTrans != sv->sg) {
+		ReleaseBuffers(sv, sv->sgTrans);
+	}
+	Free(sv->bufGC);
+
 	if (sv->pmView != NULL)
 		AG_PopupDestroy(sv->pmView);
 	if (sv->pmNode != NULL)
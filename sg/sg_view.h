@@ -29,6 +29,18 @@ typedef struct sg_view_list {
 	AG_TAILQ_ENTRY(sg_view_list) lists;
 } SG_ViewList;
 
+/* Managed per-view vertex and index buffer objects. */
+typedef struct sg_view_buffer {
+	void *_Nonnull node;			/* Pointer to parent node */
+	struct sg_view *_Nonnull sv;		/* Pointer to SG_View */
+	Uint vbo, ibo;				/* GL buffer object handles */
+	Uint maxVtx;				/* Vertex capacity of vbo */
+	Uint nIdx;				/* Indices uploaded to ibo */
+	Uint idxSerial;				/* Index array generation */
+	Uint vtxMin, vtxMax;			/* Dirty vertex range */
+	AG_TAILQ_ENTRY(sg_view_buffer) buffers;
+} SG_ViewBuffer;
+
 typedef struct sg_view_cam_action {
 	M_Real incr;			/* Increment */
 	Uint32 vMin, vAccel, vMax;	/* Repeat delays */
@@ -88,6 +100,9 @@ typedef struct sg_view {
 	AG_PopupMenu *_Nonnull pmView;	/* Popup menu per view */
 	AG_PopupMenu *_Nonnull pmNode;	/* Popup menu per node */
 	AG_Timer toRefresh;		/* View refresh timer */
+	int haveBuffers;		/* GL buffer objects (-1 = unknown) */
+	Uint nBufGC;			/* Buffer objects queued for deletion */
+	Uint *_Nullable bufGC;
 } SG_View;
 
 #define SGVIEW(obj)            ((SG_View *)(obj))
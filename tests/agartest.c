@@ -16,6 +16,7 @@
 #include <agar/core/agsi.h>
 
 #include "config/have_agar_au.h"
+#include "config/have_agar_map.h"
 #include "config/have_agar_math.h"
 #include "config/datadir.h"
 
@@ -28,6 +29,7 @@ extern const AG_TestCase fixedresTest;
 extern const AG_TestCase focusingTest;
 extern const AG_TestCase fontsTest;
 extern const AG_TestCase fspathsTest;
+extern const AG_TestCase glyphsTest;
 extern const AG_TestCase imageloadingTest;
 extern const AG_TestCase keyeventsTest;
 extern const AG_TestCase loaderTest;
@@ -35,15 +37,20 @@ extern const AG_TestCase maximizedTest;
 extern const AG_TestCase minimalTest;
 extern const AG_TestCase paletteTest;
 extern const AG_TestCase paneTest;
+extern const AG_TestCase perfTest;
 extern const AG_TestCase radioTest;
 extern const AG_TestCase rendertosurfaceTest;
 extern const AG_TestCase scrollbarTest;
 extern const AG_TestCase scrollviewTest;
 extern const AG_TestCase socketsTest;
+extern const AG_TestCase stylesheetTest;
+extern const AG_TestCase surfaceTest;
 extern const AG_TestCase tableTest;
+extern const AG_TestCase tblTest;
 extern const AG_TestCase textboxTest;
 extern const AG_TestCase textdlgTest;
 extern const AG_TestCase threadsTest;
+extern const AG_TestCase tlistTest;
 extern const AG_TestCase unitconvTest;
 extern const AG_TestCase widgetsTest;
 extern const AG_TestCase windowsTest;
@@ -66,6 +73,9 @@ extern const AG_TestCase timeoutsTest;
 #ifdef AG_USER
 extern const AG_TestCase userTest;
 #endif
+#ifdef HAVE_AGAR_MAP
+extern const AG_TestCase mapTest;
+#endif
 #ifdef HAVE_AGAR_MATH
 extern const AG_TestCase bezierTest;
 extern const AG_TestCase mathTest;
@@ -86,6 +96,7 @@ const AG_TestCase *testCases[] = {
 	&focusingTest,
 	&fontsTest,
 	&fspathsTest,
+	&glyphsTest,
 	&imageloadingTest,
 	&keyeventsTest,
 	&loaderTest,
@@ -93,15 +104,20 @@ const AG_TestCase *testCases[] = {
 	&minimalTest,
 	&paletteTest,
 	&paneTest,
+	&perfTest,
 	&radioTest,
 	&rendertosurfaceTest,
 	&scrollbarTest,
 	&scrollviewTest,
 	&socketsTest,
+	&stylesheetTest,
+	&surfaceTest,
 	&tableTest,
+	&tblTest,
 	&textboxTest,
 	&textdlgTest,
 	&threadsTest,
+	&tlistTest,
 	&unitconvTest,
 	&widgetsTest,
 	&windowsTest,
@@ -124,6 +140,9 @@ const AG_TestCase *testCases[] = {
 #ifdef AG_USER
 	&userTest,
 #endif
+#ifdef HAVE_AGAR_MAP
+	&mapTest,
+#endif
 #ifdef HAVE_AGAR_MATH
 	&bezierTest,
 	&mathTest,
@@ -5,6 +5,8 @@
 
 #include "agartest.h"
 
+#include <string.h>
+
 static void
 AppendLine(AG_Event *event)
 {
@@ -105,6 +107,338 @@ ClearLines(AG_Event *event)
 	AG_ConsoleClear(cons);
 }
 
+static int
+CheckLine(void *obj, AG_Console *cons, Uint i, const char *text)
+{
+	const AG_ConsoleLine *ln;
+
+	if (i >= cons->nLines) {
+		TestMsg(obj, "Line %u: no such line (%u lines)", i, cons->nLines);
+		return (-1);
+	}
+	ln = AG_ConsoleGetLine(cons, i);
+	if (strcmp(ln->text, text) != 0 || ln->len != strlen(text)) {
+		TestMsg(obj, "Line %u: \"%s\" (expected \"%s\")", i, ln->text,
+		    text);
+		return (-1);
+	}
+	return (0);
+}
+
+static void
+DrawConsole(AG_Console *cons)
+{
+	AG_Driver *drv = AGWIDGET(cons)->drv;
+
+	AG_ObjectLock(cons);
+	AG_BeginRendering(drv);
+	AG_WidgetDraw(cons);
+	AG_EndRendering(drv);
+	AG_ObjectUnlock(cons);
+}
+
+#ifndef _WIN32
+/* Write n lines (and an unterminated line if partial) to a file. */
+static int
+WriteLines(const char *path, const char *mode, int first, int n,
+    const char *partial)
+{
+	FILE *f;
+	int i;
+
+	if ((f = fopen(path, mode)) == NULL) {
+		AG_SetError("%s: fopen failed", path);
+		return (-1);
+	}
+	for (i = first; i < first+n; i++) {
+		fprintf(f, "Mapped line %d\n", i);
+	}
+	if (partial != NULL) {
+		fputs(partial, f);
+	}
+	fclose(f);
+	return (0);
+}
+
+/* Run the mapped file's scan timer until the whole file is indexed. */
+static void
+ScanMapped(AG_Console *cons, AG_ConsoleFile *cf)
+{
+	AG_Timer *to = &cf->toScan;
+	int i;
+
+	AG_ObjectLock(cons);
+	for (i = 0; i < 100; i++) {
+		(void)to->fn(to, &to->fnEvent);
+		if (cf->scanned == cf->size)
+			break;
+	}
+	AG_ObjectUnlock(cons);
+}
+
+static int
+CheckMapped(void *obj, AG_Console *cons, int i, const char *text)
+{
+	char *s;
+	int rv;
+
+	cons->pos = i;
+	cons->sel = 0;
+	if ((s = AG_ConsoleExportText(cons, AG_NEWLINE_LF)) == NULL) {
+		TestMsg(obj, "Mapped line %d: %s", i, AG_GetError());
+		return (-1);
+	}
+	if ((rv = strcmp(s, text)) != 0) {
+		TestMsg(obj, "Mapped line %d: \"%s\" (expected \"%s\")", i, s,
+		    text);
+	}
+	Free(s);
+	return (rv == 0 ? 0 : -1);
+}
+
+/*
+ * Truncate a mapped file below its indexed range (as with copytruncate),
+ * then regrow it past the indexed range with a single unterminated line.
+ */
+static int
+TestMappedTruncate(void *obj, AG_Console *cons, AG_ConsoleFile *cf,
+    const char *path)
+{
+	char *s, *longLine;
+	const AG_Size longLen = cf->scanned + 1024;
+
+	if (WriteLines(path, "w", 0, 100, NULL) == -1) {
+		TestMsg(obj, "%s", AG_GetError());
+		return (-1);
+	}
+	cons->pos = 10000;
+	cons->sel = 0;
+	if ((s = AG_ConsoleExportText(cons, AG_NEWLINE_LF)) != NULL) {
+		TestMsg(obj, "Read past truncation: \"%s\"", s);
+		Free(s);
+		return (-1);
+	}
+	DrawConsole(cons);
+	ScanMapped(cons, cf);
+	if (cf->nLines != 100 ||
+	    CheckMapped(obj, cons, 99, "Mapped line 99\n") == -1) {
+		TestMsg(obj, "Truncated file: %u lines", cf->nLines);
+		return (-1);
+	}
+
+	longLine = Malloc(longLen + 1);
+	memset(longLine, 'x', longLen);
+	longLine[longLen] = '\0';
+	if (WriteLines(path, "w", 0, 0, longLine) == -1) {
+		TestMsg(obj, "%s", AG_GetError());
+		Free(longLine);
+		return (-1);
+	}
+	Free(longLine);
+	cons->rOffs = 10;
+	DrawConsole(cons);                       /* Must discard the index */
+	if (cf->scanned != 0) {
+		TestMsgS(obj, "Stale index not discarded");
+		return (-1);
+	}
+	ScanMapped(cons, cf);
+	if (cf->nLines != 1 || cf->scanned != longLen) {
+		TestMsg(obj, "Regrown file: %u lines", cf->nLines);
+		return (-1);
+	}
+	DrawConsole(cons);
+	return (0);
+}
+
+/* Display a large file from a memory mapping and follow it as it grows. */
+static int
+TestMapped(void *obj, AG_Console *cons)
+{
+	char path[AG_PATHNAME_MAX];
+	AG_ConsoleFile *cf;
+	int rv = -1;
+
+	AG_ConfigGetPath(AG_CONFIG_PATH_TEMP, 0, path, sizeof(path));
+	Strlcat(path, AG_PATHSEP, sizeof(path));
+	Strlcat(path, "agartest-console.txt", sizeof(path));
+
+	if (WriteLines(path, "w", 0, 10000, "Partial") == -1) {
+		TestMsg(obj, "%s", AG_GetError());
+		return (-1);
+	}
+	cf = AG_ConsoleOpenFile(cons, NULL, path, AG_NEWLINE_LF,
+	    AG_CONSOLE_FILE_MMAP);
+	if (cf == NULL) {
+		TestMsg(obj, "AG_ConsoleOpenFile: %s", AG_GetError());
+		goto out_unlink;
+	}
+	ScanMapped(cons, cf);
+	if (cf->nLines != 10001 || cf->nNewlines != 10000 ||
+	    cf->nIndex > 10000 / AG_CONSOLE_FILE_STRIDE + 1) {
+		TestMsg(obj, "Mapped file: %u lines, %u index entries",
+		    cf->nLines, cf->nIndex);
+		goto out;
+	}
+	if (CheckMapped(obj, cons, 0, "Mapped line 0\n") == -1 ||
+	    CheckMapped(obj, cons, 6543, "Mapped line 6543\n") == -1 ||
+	    CheckMapped(obj, cons, 10000, "Partial\n") == -1)
+		goto out;
+
+	cons->rOffs = 5000;
+	DrawConsole(cons);
+	if (cons->wMax <= 0) {
+		TestMsgS(obj, "Mapped lines not rendered");
+		goto out;
+	}
+
+	/* Complete the partial line and append more lines. */
+	if (WriteLines(path, "a", 10000, 500, NULL) == -1) {
+		TestMsg(obj, "%s", AG_GetError());
+		goto out;
+	}
+	ScanMapped(cons, cf);
+	if (cf->nLines != 10500 ||
+	    CheckMapped(obj, cons, 10000, "PartialMapped line 10000\n") == -1 ||
+	    CheckMapped(obj, cons, 10499, "Mapped line 10499\n") == -1) {
+		TestMsg(obj, "Followed file: %u lines", cf->nLines);
+		goto out;
+	}
+	DrawConsole(cons);
+	if (TestMappedTruncate(obj, cons, cf, path) == -1) {
+		goto out;
+	}
+	rv = 0;
+out:
+	AG_ConsoleClose(cons, cf);
+	if (cons->mapFile != NULL) {
+		TestMsgS(obj, "Mapped file not closed");
+		rv = -1;
+	}
+out_unlink:
+	AG_FileDelete(path);
+	return (rv);
+}
+#endif /* !_WIN32 */
+
+static int
+Test(void *obj)
+{
+	char lineBuf[100][32];
+	const char *lines[100];
+	AG_Window *win;
+	AG_Console *cons;
+	AG_ConsoleLine *ln;
+	AG_ConsoleChunk *ch;
+	AG_SizeAlloc a;
+	AG_Size chunkSize;
+	int i, j, rv = -1;
+
+	if ((win = AG_WindowNew(0)) == NULL) {
+		TestMsg(obj, "AG_WindowNew: %s", AG_GetError());
+		return (-1);
+	}
+	cons = AG_ConsoleNew(win, AG_CONSOLE_EXPAND);
+	AG_ConsoleSetMaxLines(cons, 1000);
+
+	for (i = 0; i < 100; i++) {
+		lines[i] = lineBuf[i];
+	}
+	for (i = 0; i < 50; i++) {                   /* Bulk append 5000 lines */
+		for (j = 0; j < 100; j++) {
+			Snprintf(lineBuf[j], sizeof(lineBuf[j]), "Line %d",
+			    i*100 + j);
+		}
+		AG_ConsoleAppendLines(cons, lines, 100);
+	}
+	if (cons->nLines != 1000 || cons->lineCap != 1000 ||
+	    CheckLine(obj, cons, 0, "Line 4000") == -1 ||
+	    CheckLine(obj, cons, 999, "Line 4999") == -1) {
+		TestMsg(obj, "Ring buffer: %u lines", cons->nLines);
+		goto out;
+	}
+	for (ch = cons->chunkHead, chunkSize = 0; ch != NULL; ch = ch->next) {
+		chunkSize += ch->size;
+	}
+	if (chunkSize > 2*AG_CONSOLE_CHUNK_SIZE +
+	    1000*(sizeof(AG_ConsoleLine) + 16)) {
+		TestMsg(obj, "Arena holds %lu bytes", (Ulong)chunkSize);
+		goto out;
+	}
+
+	/* Multi-line groups. */
+	ln = AG_ConsoleMsgS(cons, "Parent\nChild 1\nChild 2");
+	if (CheckLine(obj, cons, 997, "Parent") == -1 ||
+	    CheckLine(obj, cons, 998, "Child 1") == -1 ||
+	    CheckLine(obj, cons, 999, "Child 2") == -1 ||
+	    AG_ConsoleGetLine(cons, 999)->parent != ln) {
+		TestMsgS(obj, "Bad multi-line group");
+		goto out;
+	}
+	AG_ConsoleMsgEdit(ln, "Edited");                /* In place */
+	AG_ConsoleMsgCatS(ln, " parent");               /* Off the arena */
+	if (CheckLine(obj, cons, 997, "Edited parent") == -1)
+		goto out;
+
+	for (i = 0; i < 998; i++) {          /* Discard the parent line */
+		AG_ConsoleMsg(cons, "More %d", i);
+	}
+	if (CheckLine(obj, cons, 0, "Child 1") == -1 ||
+	    AG_ConsoleGetLine(cons, 0)->parent != NULL) {
+		TestMsgS(obj, "Child line not orphaned");
+		goto out;
+	}
+
+	/* Buffers with CR-LF newlines. */
+	AG_ConsoleAppendBuffer(cons, "one\r\n\r\ntwo\r\nthree", 17,
+	    AG_NEWLINE_CR_LF);
+	if (CheckLine(obj, cons, 996, "one") == -1 ||
+	    CheckLine(obj, cons, 997, "") == -1 ||
+	    CheckLine(obj, cons, 998, "two") == -1 ||
+	    CheckLine(obj, cons, 999, "three") == -1)
+		goto out;
+
+	/* Cached surfaces are released as lines scroll out of view. */
+	a.x = 0;
+	a.y = 0;
+	a.w = 400;
+	a.h = 200;
+	AG_WidgetSizeAlloc(cons, &a);
+	AG_WidgetUpdateCoords(cons, 0, 0);
+	AG_WidgetShowAll(cons);
+	for (i = 0; i < 1000; i += 100) {
+		cons->rOffs = i;
+		DrawConsole(cons);
+		if (cons->nMapped == 0 ||
+		    cons->nMapped > a.h / cons->lineskip + 1) {
+			TestMsg(obj, "%u cached surfaces (%u visible)",
+			    cons->nMapped, cons->rVisible);
+			goto out;
+		}
+	}
+
+#ifndef _WIN32
+	if (TestMapped(obj, cons) == -1)
+		goto out;
+#endif
+	AG_ConsoleSetMaxLines(cons, 10);
+	if (cons->nLines != 10 ||
+	    CheckLine(obj, cons, 9, "three") == -1) {
+		TestMsg(obj, "Line limit: %u lines", cons->nLines);
+		goto out;
+	}
+	AG_ConsoleClear(cons);
+	if (cons->nLines != 0 || cons->nMapped != 0 ||
+	    cons->chunkHead != NULL) {
+		TestMsgS(obj, "Console not cleared");
+		goto out;
+	}
+	TestMsgS(obj, "AG_Console tests OK");
+	rv = 0;
+out:
+	AG_ObjectDetach(win);
+	return (rv);
+}
+
 static int
 TestGUI(void *obj, AG_Window *win)
 {
@@ -181,7 +515,7 @@ const AG_TestCase consoleTest = {
 	sizeof(AG_TestInstance),
 	NULL,		/* init */
 	NULL,		/* destroy */
-	NULL,		/* test */
+	Test,
 	TestGUI,
 	NULL		/* bench */
 };
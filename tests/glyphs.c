@@ -0,0 +1,170 @@
+/*	Public domain	*/
+
+/*
+ * This program tests the colorization of cached glyphs by the drivers.
+ */
+
+#include "agartest.h"
+
+#include <string.h>
+
+/* Check AG_GlyphAlpha() against the exact product over the component range. */
+static int
+CheckGlyphAlpha(void *obj)
+{
+	Uint32 m, fg;
+
+	if (AG_GlyphAlpha(AG_OPAQUE, AG_OPAQUE) != AG_OPAQUE) {
+		TestMsg(obj, "Opaque glyph on opaque FG: alpha %u (expected %u)",
+		    (Uint)AG_GlyphAlpha(AG_OPAQUE, AG_OPAQUE), (Uint)AG_OPAQUE);
+		return (-1);
+	}
+	for (m = 0; m <= AG_OPAQUE; m += AG_OPAQUE/255) {
+		for (fg = 0; fg <= AG_OPAQUE; fg += AG_OPAQUE/255) {
+			const Uint32 a = AG_GlyphAlpha((AG_Component)m,
+			                               (AG_Component)fg);
+
+			if (a != (Uint32)((double)m * (double)fg /
+			                  (double)AG_OPAQUE)) {
+				TestMsg(obj, "AG_GlyphAlpha(%u,%u) = %u",
+				    (Uint)m, (Uint)fg, (Uint)a);
+				return (-1);
+			}
+		}
+	}
+	TestMsgS(obj, "AG_GlyphAlpha(): OK");
+	return (0);
+}
+
+/*
+ * Compare the pixels of a glyph drawn by drawGlyph() against its coverage
+ * mask. Fully covered pixels must be exactly the foreground pixel and
+ * uncovered pixels exactly the (opaque) background pixel.
+ */
+static int
+CompareGlyph(void *obj, const AG_Glyph *G, const AG_Surface *S, int x,
+    Uint32 pxBg, Uint32 pxFg, Uint *nOpaque)
+{
+	const AG_Surface *M = G->su;
+	int sx, sy;
+
+	for (sy = 0; sy < M->h && sy < S->h; sy++) {
+		for (sx = 0; sx < M->w && x+sx < S->w; sx++) {
+			const Uint32 px = AG_SurfaceGet32(S, x+sx, sy);
+			AG_Color cMask;
+
+			AG_GetColor(&cMask, AG_SurfaceGet(M, sx,sy), &M->format);
+			if (cMask.a == AG_OPAQUE) {
+				if (px != pxFg) {
+					TestMsg(obj, "'%c' at %d,%d: 0x%08x "
+					             "(expected FG 0x%08x)",
+					    (char)G->ch, sx,sy, px, pxFg);
+					return (-1);
+				}
+				(*nOpaque)++;
+			} else if (cMask.a == AG_TRANSPARENT && px != pxBg) {
+				TestMsg(obj, "'%c' at %d,%d: 0x%08x "
+				             "(expected BG 0x%08x)",
+				    (char)G->ch, sx,sy, px, pxBg);
+				return (-1);
+			}
+		}
+	}
+	return (0);
+}
+
+/*
+ * Render a line of text with the headless driver, onto a surface of our
+ * own, in an opaque color over an opaque background.
+ */
+static int
+CheckHeadless(void *obj)
+{
+	static const AG_Char text[] = { 'A','g','a','r','!', '\0' };
+	AG_DriverClass **pd;
+	AG_Driver *drv;
+	AG_Surface *S;
+	AG_Color cBg, cFg;
+	Uint32 pxBg, pxFg;
+	Uint nOpaque = 0;
+	int i, x, rv = -1;
+
+	if (agDefaultFont == NULL) {
+		TestMsgS(obj, "Headless: no default font (skipping)");
+		return (0);
+	}
+	for (pd = &agDriverList[0]; *pd != NULL; pd++) {
+		if (strcmp((*pd)->name, "headless") == 0)
+			break;
+	}
+	if (*pd == NULL) {
+		TestMsgS(obj, "Headless: driver not available (skipping)");
+		return (0);
+	}
+	AG_LockVFS(&agDrivers);
+	if ((drv = AG_DriverOpen(*pd, "headless")) == NULL) {
+		TestMsg(obj, "Headless: %s (skipping)", AG_GetError());
+		AG_UnlockVFS(&agDrivers);
+		return (0);
+	}
+	S = AG_SurfaceStdRGB(256, 64);
+	if (AGDRIVER_SW_CLASS(drv)->openVideoContext(drv, S, 0) == -1) {
+		TestMsg(obj, "Headless: %s", AG_GetError());
+		goto out;
+	}
+	AG_ColorRGB_8(&cBg, 240, 230, 200);
+	AG_ColorRGB_8(&cFg, 10, 40, 120);
+	pxBg = (Uint32)AG_MapPixel(&S->format, &cBg);
+	pxFg = (Uint32)AG_MapPixel(&S->format, &cFg);
+
+	for (i = 0, x = 0; text[i] != '\0'; i++) {
+		AG_Glyph *G;
+
+		G = AG_TextRenderGlyph(drv, agDefaultFont, &cBg, &cFg, text[i]);
+		if (G->flags & AG_GLYPH_COLORED) {
+			TestMsgS(obj, "Headless: bitmap font (skipping)");
+			rv = 0;
+			goto out;
+		}
+		AGDRIVER_CLASS(drv)->drawGlyph(drv, G, x, 0);
+		if (CompareGlyph(obj, G, S, x, pxBg, pxFg, &nOpaque) == -1) {
+			goto out;
+		}
+		x += G->advance;
+	}
+	if (nOpaque == 0) {
+		TestMsgS(obj, "Headless: no fully covered glyph pixels");
+		goto out;
+	}
+	TestMsg(obj, "Headless: OK (%u opaque pixels)", nOpaque);
+	rv = 0;
+out:
+	AG_DriverClose(drv);
+	AG_UnlockVFS(&agDrivers);
+	AG_SurfaceFree(S);
+	return (rv);
+}
+
+static int
+Test(void *obj)
+{
+	if (CheckGlyphAlpha(obj) == -1 ||
+	    CheckHeadless(obj) == -1) {
+		return (-1);
+	}
+	return (0);
+}
+
+const AG_TestCase glyphsTest = {
+	AGSI_IDEOGRAM AGSI_TYPOGRAPHY AGSI_RST,
+	"glyphs",
+	N_("Test the colorization of cached glyphs"),
+	"1.7.0",
+	0,
+	sizeof(AG_TestInstance),
+	NULL,		/* init */
+	NULL,		/* destroy */
+	Test,
+	NULL,		/* testGUI */
+	NULL		/* bench */
+};
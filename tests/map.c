@@ -0,0 +1,255 @@
+/*	Public domain	*/
+
+/*
+ * This program tests the loading and saving of MAP(3) maps, including the
+ * conversion of maps in the sequential node format (12.1) and reloading a
+ * map with paging enabled.
+ */
+
+#include "agartest.h"
+
+#include <agar/map/map.h>
+
+#define MAPTEST_W	100			/* 4x3 chunks */
+#define MAPTEST_H	70
+#define MAPTEST_RESIDENT 2			/* Paging budget */
+
+static int
+Init(void *obj)
+{
+	MAP_InitSubsystem();
+	return (0);
+}
+
+static void
+Destroy(void *obj)
+{
+	MAP_DestroySubsystem();
+}
+
+/* Create a map where every node holds a link to its own coordinates. */
+static MAP *
+CreateMap(const char *name)
+{
+	MAP *map;
+	int x, y;
+
+	map = MAP_New(NULL, name);
+	if (MAP_AllocNodes(map, MAPTEST_W, MAPTEST_H) == -1) {
+		AG_FatalError(NULL);
+	}
+	AG_ObjectLock(map);
+	for (y = 0; y < MAPTEST_H; y++) {
+		for (x = 0; x < MAPTEST_W; x++)
+			MAP_LinkNew(map, MAP_GetNode(map, x,y), "self", x,y, 0);
+	}
+	AG_ObjectUnlock(map);
+	return (map);
+}
+
+/* Check the nodes in the chunk at x0,y0 of a map created by CreateMap(). */
+static int
+VerifyChunk(void *obj, MAP *map, int x0, int y0, const char *what)
+{
+	const int x1 = AG_MIN(x0 + MAP_CHUNK_SIZE, (int)map->w);
+	const int y1 = AG_MIN(y0 + MAP_CHUNK_SIZE, (int)map->h);
+	int x, y;
+
+	for (y = y0; y < y1; y++) {
+		for (x = x0; x < x1; x++) {
+			const MAP_Node *node = MAP_GetConstNode(map, x,y);
+			const MAP_Item *mi = TAILQ_FIRST(&node->items);
+
+			if (mi == NULL || mi->type != MAP_ITEM_LINK ||
+			    MAPLINK(mi)->x != x || MAPLINK(mi)->y != y ||
+			    TAILQ_NEXT(mi, items) != NULL) {
+				TestMsg(obj, "%s: Bad node at %d,%d", what, x,y);
+				return (-1);
+			}
+		}
+	}
+	return (0);
+}
+
+/*
+ * Check a map created by CreateMap(), one chunk at a time. Advance the
+ * tick between chunks (as MAP_View(3) does between redraws) so that the
+ * chunks of a paged map can be evicted.
+ */
+static int
+VerifyMap(void *obj, MAP *map, const char *what)
+{
+	int x0, y0, rv = 0;
+
+	if (map->w != MAPTEST_W || map->h != MAPTEST_H) {
+		TestMsg(obj, "%s: Map is %ux%u", what, map->w, map->h);
+		return (-1);
+	}
+	AG_ObjectLock(map);
+	for (y0 = 0; y0 < MAPTEST_H && rv == 0; y0 += MAP_CHUNK_SIZE) {
+		for (x0 = 0; x0 < MAPTEST_W && rv == 0; x0 += MAP_CHUNK_SIZE) {
+			rv = VerifyChunk(obj, map, x0, y0, what);
+			map->tick++;
+		}
+	}
+	AG_ObjectUnlock(map);
+	return (rv);
+}
+
+/*
+ * Save a map in the sequential node format of version 12.1. Serialize an
+ * empty map of the same size as 12.1 and replace its empty chunk index by
+ * the nodes of map, in row-major order.
+ */
+static int
+SaveLegacy(MAP *map, const char *path)
+{
+	const AG_Version verSave = mapClass.ver;
+	const AG_Size indexSize = 1 + 4 + 4 + 4*map->wChunks*map->hChunks;
+	AG_DataSource *ds, *dsFile;
+	MAP *mapEmpty;
+	int x, y, rv = -1;
+
+	mapEmpty = MAP_New(NULL, "empty");
+	if (MAP_AllocNodes(mapEmpty, map->w, map->h) == -1 ||
+	    (ds = AG_OpenAutoCore()) == NULL) {
+		goto out;
+	}
+	mapClass.ver.minor = 1;
+	if (AG_ObjectSerialize(mapEmpty, ds) == -1) {
+		mapClass.ver = verSave;
+		goto out_close;
+	}
+	mapClass.ver = verSave;
+
+	if ((dsFile = AG_OpenFile(path, "wb")) == NULL) {
+		goto out_close;
+	}
+	if (AG_Write(dsFile, AG_CORE_SOURCE(ds)->data,
+	    AG_CORE_SOURCE(ds)->size - indexSize) != 0) {
+		AG_CloseFile(dsFile);
+		goto out_close;
+	}
+	AG_ObjectLock(map);
+	for (y = 0; y < (int)map->h; y++) {
+		for (x = 0; x < (int)map->w; x++)
+			MAP_NodeSave(map, dsFile, MAP_GetConstNode(map, x,y));
+	}
+	AG_ObjectUnlock(map);
+	AG_CloseFile(dsFile);
+	rv = 0;
+out_close:
+	AG_CloseAutoCore(ds);
+out:
+	AG_ObjectDestroy(mapEmpty);
+	return (rv);
+}
+
+static void
+TempPath(char *path, AG_Size size, const char *file)
+{
+	AG_ConfigGetPath(AG_CONFIG_PATH_TEMP, 0, path, size);
+	Strlcat(path, AG_PATHSEP, size);
+	Strlcat(path, file, size);
+}
+
+static int
+Test(void *obj)
+{
+	char pathOld[AG_PATHNAME_MAX];
+	char pathNew[AG_PATHNAME_MAX];
+	char pathCopy[AG_PATHNAME_MAX];
+	MAP_ChunkStats st;
+	MAP *map;
+	int rv = -1;
+
+	TempPath(pathOld, sizeof(pathOld), "agartest-map-12.1.map");
+	TempPath(pathNew, sizeof(pathNew), "agartest-map-12.2.map");
+	TempPath(pathCopy, sizeof(pathCopy), "agartest-map-copy.map");
+
+	map = CreateMap("source");
+	if (SaveLegacy(map, pathOld) == -1) {
+		TestMsg(obj, "%s: %s", pathOld, AG_GetError());
+		AG_ObjectDestroy(map);
+		return (-1);
+	}
+	AG_ObjectDestroy(map);
+
+	/* Convert from the sequential node format. */
+	map = MAP_New(NULL, "converted");
+	if (AG_ObjectLoadFromFile(map, pathOld) == -1) {
+		TestMsg(obj, "%s: %s", pathOld, AG_GetError());
+		goto out;
+	}
+	if (VerifyMap(obj, map, "12.1") == -1) {
+		goto out;
+	}
+	if (AG_ObjectSaveToFile(map, pathNew) == -1) {
+		TestMsg(obj, "%s: %s", pathNew, AG_GetError());
+		goto out;
+	}
+	AG_ObjectDestroy(map);
+	TestMsgS(obj, "Converted 12.1 map: OK");
+
+	/* Reload with paging, then save it from the paged map. */
+	map = MAP_New(NULL, "paged");
+	MAP_SetPaging(map, MAPTEST_RESIDENT);
+	if (AG_ObjectLoadFromFile(map, pathNew) == -1) {
+		TestMsg(obj, "%s: %s", pathNew, AG_GetError());
+		goto out;
+	}
+	if (map->pager == NULL) {
+		TestMsgS(obj, "Map is not paged");
+		goto out;
+	}
+	if (VerifyMap(obj, map, "Paged") == -1) {
+		goto out;
+	}
+	MAP_GetChunkStats(map, &st);
+	if (st.nLoads < st.nChunks || st.nEvictions == 0 || st.nDirty > 0 ||
+	    st.nResident > MAPTEST_RESIDENT) {
+		TestMsg(obj, "Paged: %u loads, %u evictions, %u dirty, "
+		             "%u/%u resident",
+		    st.nLoads, st.nEvictions, st.nDirty, st.nResident,
+		    st.nChunks);
+		goto out;
+	}
+	if (AG_ObjectSaveToFile(map, pathCopy) == -1) {
+		TestMsg(obj, "%s: %s", pathCopy, AG_GetError());
+		goto out;
+	}
+	AG_ObjectDestroy(map);
+	TestMsg(obj, "Paged reload: OK (%u loads, %u evictions)",
+	    st.nLoads, st.nEvictions);
+
+	map = MAP_New(NULL, "copy");
+	if (AG_ObjectLoadFromFile(map, pathCopy) == -1) {
+		TestMsg(obj, "%s: %s", pathCopy, AG_GetError());
+		goto out;
+	}
+	if (VerifyMap(obj, map, "Copy of paged") == -1) {
+		goto out;
+	}
+	TestMsgS(obj, "Save of paged map: OK");
+	rv = 0;
+out:
+	AG_ObjectDestroy(map);
+	AG_FileDelete(pathOld);
+	AG_FileDelete(pathNew);
+	AG_FileDelete(pathCopy);
+	return (rv);
+}
+
+const AG_TestCase mapTest = {
+	AGSI_IDEOGRAM AGSI_FILESYSTEM AGSI_RST,
+	"map",
+	N_("Test loading and saving of MAP(3) maps"),
+	"1.7.0",
+	0,
+	sizeof(AG_TestInstance),
+	Init,
+	Destroy,
+	Test,
+	NULL,		/* testGUI */
+	NULL		/* bench */
+};
@@ -30,6 +30,18 @@
 #define NREALS 10000
 #define NVECTORS 1000
 #define NMATRICES 100
+#define MATBENCH_MIN 16		/* Smallest M_Matrix benchmark size */
+#define MATBENCH_MAX 2048	/* Largest M_Matrix benchmark size */
+#define MATBENCH_NS  200000000	/* Minimum time per size (ns) */
+#define SOABENCH_N   1000000	/* Vectors per M_VectorSoA3 benchmark */
+#define SOABENCH_NS  200000000	/* Minimum time per operation (ns) */
+#define SORTBENCH_N  1000000	/* Elements per sort benchmark */
+#define SPBENCH_MIN  32		/* Smallest sparse benchmark grid */
+#define SPBENCH_MAX  256	/* Largest sparse benchmark grid */
+#define SPBENCH_DIRECT_MAX 64	/* Largest grid for the direct solver */
+#define KDBENCH_MIN  10000	/* Fewest primitives in spatial benchmark */
+#define KDBENCH_MAX  10000000	/* Most primitives in spatial benchmark */
+#define KDBENCH_NQ   100000	/* Queries per spatial benchmark */
 
 typedef struct {
 	AG_TestInstance _inherit;
@@ -232,6 +244,933 @@ TestMatrix(AG_TestInstance *ti)
 	M_Free(M);
 }
 
+/* Fill an m*n matrix using the given backend. */
+static void
+FillMatrix(const M_MatrixOps *ops, void *M, Uint m, Uint n, int seed)
+{
+	Uint i, j;
+
+	for (i = 0; i < m; i++) {
+		for (j = 0; j < n; j++)
+			*ops->GetElement(M, i,j) =
+			    (M_Real)((i*31 + j*17 + seed) % 23) - 11.0;
+	}
+}
+
+/*
+ * Compare products and LU solutions of the blocked backend against
+ * the scalar backend, with each available micro-kernel.
+ */
+static int
+TestMatrixBlocked(AG_TestInstance *ti)
+{
+	static const Uint sizes[][3] = {
+		{ 1,1,1 }, { 3,5,7 }, { 17,13,29 }, { 64,64,64 },
+		{ 129,300,77 }, { 257,130,300 }, { 40,600,33 }
+	};
+	static const char *kernels[] = { "scalar", "sse2", "avx" };
+	const int nSizes = sizeof(sizes) / sizeof(sizes[0]);
+	M_MatrixBLK *A, *B, *C;
+	void *Af, *Bf, *Cf;
+	M_Vector *x, *b;
+	M_Real diff, d;
+	Uint i, j, m, n, k;
+	const int nKernels = sizeof(kernels) / sizeof(kernels[0]);
+	int s, iKernel, rv = 0, rvKernel;
+
+	for (iKernel = 0; iKernel < nKernels; iKernel++) {
+		if (M_MatrixSetKernel_BLK(kernels[iKernel]) == -1) {
+			continue;
+		}
+		rvKernel = 0;
+		for (s = 0; s < nSizes; s++) {
+			m = sizes[s][0];
+			k = sizes[s][1];
+			n = sizes[s][2];
+			A = M_MatrixNew_BLK(m,k);
+			B = M_MatrixNew_BLK(k,n);
+			Af = mMatOps_FPU.NewMatrix(m,k);
+			Bf = mMatOps_FPU.NewMatrix(k,n);
+			FillMatrix(&mMatOps_BLK, A, m,k, s);
+			FillMatrix(&mMatOps_FPU, Af, m,k, s);
+			FillMatrix(&mMatOps_BLK, B, k,n, s+1);
+			FillMatrix(&mMatOps_FPU, Bf, k,n, s+1);
+			C = M_MatrixMul_BLK(A, B);
+			Cf = mMatOps_FPU.Mul(Af, Bf);
+			for (diff = 0.0, i = 0; i < m; i++) {
+				for (j = 0; j < n; j++) {
+					d = M_Fabs(C->v[i][j] -
+					           mMatOps_FPU.Get(Cf, i,j));
+					if (d > diff) { diff = d; }
+				}
+			}
+			if (diff != 0.0) {
+				TestMsg(ti, "\t%s: %ux%ux%u product differs "
+				            "(%f)", kernels[iKernel], m,k,n,
+					    (double)diff);
+				rvKernel = -1;
+			}
+			M_MatrixFree_BLK(A);
+			M_MatrixFree_BLK(B);
+			M_MatrixFree_BLK(C);
+			mMatOps_FPU.FreeMatrix(Af);
+			mMatOps_FPU.FreeMatrix(Bf);
+			mMatOps_FPU.FreeMatrix(Cf);
+		}
+		if (rvKernel == 0) {
+			TestMsg(ti, "\t%s kernel: OK", kernels[iKernel]);
+		} else {
+			rv = -1;
+		}
+	}
+	M_MatrixInitEngine_BLK();
+
+	/* Solve Ax=b for a known x, across several LU panels. */
+	n = 150;
+	A = M_MatrixNew_BLK(n,n);
+	x = M_VecNew(n);
+	b = M_VecNew(n);
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < n; j++) {
+			A->v[i][j] = (i == j) ? 4.0 :
+			             (M_Real)((i*7 + j*3) % 5) / 5.0;
+		}
+		x->v[i] = (M_Real)(i % 9) - 4.0;
+	}
+	for (i = 0; i < n; i++) {
+		for (b->v[i] = 0.0, j = 0; j < n; j++)
+			b->v[i] += A->v[i][j] * x->v[j];
+	}
+	if (M_FactorizeLU_BLK(A) == -1) {
+		TestMsg(ti, "\tLU: %s", AG_GetError());
+		rv = -1;
+	} else {
+		M_BacksubstLU_BLK(A, b);
+		for (diff = 0.0, i = 0; i < n; i++) {
+			d = M_Fabs(b->v[i] - x->v[i]);
+			if (d > diff) { diff = d; }
+		}
+		TestMsg(ti, "\tLU %ux%u: max. error %g", n,n, (double)diff);
+		if (diff > 1e-4)
+			rv = -1;
+	}
+	M_VecFree(b);
+	M_VecFree(x);
+	M_MatrixFree_BLK(A);
+	return (rv);
+}
+
+/* Fill a stream of n vectors (every 16th vector is zero). */
+static void
+FillVectorSoA3(M_VectorSoA3 *S, Uint n, int seed)
+{
+	Uint i;
+
+	for (i = 0; i < n; i++) {
+		if ((i % 16) == 15) {
+			S->x[i] = S->y[i] = S->z[i] = 0.0;
+			continue;
+		}
+		S->x[i] = (M_SoAReal)((int)((i*31 + seed) % 29) - 14) / 7.0;
+		S->y[i] = (M_SoAReal)((int)((i*17 + seed) % 23) - 11) / 5.0;
+		S->z[i] = (M_SoAReal)((int)((i*13 + seed) % 19) - 9) / 3.0;
+	}
+}
+
+/* Return the largest difference between two streams. */
+static M_Real
+DiffVectorSoA3(const M_VectorSoA3 *A, const M_VectorSoA3 *B)
+{
+	M_Real diff = 0.0, d;
+	Uint i;
+
+	for (i = 0; i < A->n; i++) {
+		d = M_Fabs(A->x[i] - B->x[i]);	if (d > diff) { diff = d; }
+		d = M_Fabs(A->y[i] - B->y[i]);	if (d > diff) { diff = d; }
+		d = M_Fabs(A->z[i] - B->z[i]);	if (d > diff) { diff = d; }
+	}
+	return (diff);
+}
+
+/*
+ * Compare the batched M_VectorSoA3 operations of each available backend
+ * against the scalar backend, with a stream length which is not a multiple
+ * of the SIMD width.
+ */
+static int
+TestVectorSoA3(AG_TestInstance *ti)
+{
+	const Uint n = 1003;
+	const M_VectorOpsSoA3 **pOps, *ops;
+	const M_VectorOpsSoA3 *fpu = &mVecOpsSoA3_FPU;
+	M_VectorSoA3 A, B, R, C;
+	M_SoAReal *dR, *d;
+	M_Vector3 *aos;
+	M_Matrix44 T;
+	M_Real diff, e;
+	Uint i;
+	int rv = 0;
+
+	M_VectorSoAInit3(&A, n);
+	M_VectorSoAInit3(&B, n);
+	M_VectorSoAInit3(&R, n);
+	M_VectorSoAInit3(&C, n);
+	dR = Malloc(n*sizeof(M_SoAReal));
+	d = Malloc(n*sizeof(M_SoAReal));
+	aos = Malloc(n*sizeof(M_Vector3));
+	FillVectorSoA3(&A, n, 1);
+	FillVectorSoA3(&B, n, 2);
+
+	M_MatIdentity44v(&T);
+	M_MatRotateAxis44(&T, M_Radians(33.0),
+	    M_VecNorm3(M_VECTOR3(11.6, 4.51, 8.5)));
+	M_MatTranslate44v(&T, M_VECTOR3(1.5, -2.0, 3.25));
+
+	for (pOps = &mVecOpsSoA3List[0]; *pOps != NULL; pOps++) {
+		ops = *pOps;
+		if ((ops->ext & agCPU.ext) != ops->ext) {
+			continue;
+		}
+		diff = 0.0;
+
+		fpu->Transform(&R, &T, &A);
+		ops->Transform(&C, &T, &A);
+		if ((e = DiffVectorSoA3(&R, &C)) > diff) { diff = e; }
+		fpu->TransformDir(&R, &T, &A);
+		ops->TransformDir(&C, &T, &A);
+		if ((e = DiffVectorSoA3(&R, &C)) > diff) { diff = e; }
+		fpu->Norm(&R, &A);
+		ops->Norm(&C, &A);
+		if ((e = DiffVectorSoA3(&R, &C)) > diff) { diff = e; }
+		fpu->Cross(&R, &A, &B);
+		ops->Cross(&C, &A, &B);
+		if ((e = DiffVectorSoA3(&R, &C)) > diff) { diff = e; }
+
+		fpu->Dot(dR, &A, &B);
+		ops->Dot(d, &A, &B);
+		for (i = 0; i < n; i++) {
+			if ((e = M_Fabs(dR[i] - d[i])) > diff) { diff = e; }
+		}
+		fpu->Len(dR, &A);
+		ops->Len(d, &A);
+		for (i = 0; i < n; i++) {
+			if ((e = M_Fabs(dR[i] - d[i])) > diff) { diff = e; }
+		}
+
+		/* In-place operation and round trip through M_Vector3. */
+		M_VectorSoAScatter3(aos, sizeof(M_Vector3), &A);
+		M_VectorSoAGather3(&C, aos, sizeof(M_Vector3), n);
+		ops->Norm(&C, &C);
+		fpu->Norm(&R, &A);
+		if ((e = DiffVectorSoA3(&R, &C)) > diff) { diff = e; }
+
+		if (diff > 1e-4) {
+			TestMsg(ti, "\t%s: results differ (%g)", ops->name,
+			    (double)diff);
+			rv = -1;
+		} else {
+			TestMsg(ti, "\t%s: OK (max. error %g)", ops->name,
+			    (double)diff);
+		}
+	}
+
+	Free(aos);
+	Free(d);
+	Free(dR);
+	M_VectorSoAFree3(&C);
+	M_VectorSoAFree3(&R);
+	M_VectorSoAFree3(&B);
+	M_VectorSoAFree3(&A);
+	return (rv);
+}
+
+/* Deterministic pseudo-random numbers for the sort tests (xorshift32). */
+static Uint32
+SortRandom(Uint32 *state)
+{
+	Uint32 x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return (*state = x);
+}
+
+/*
+ * Fill an array of n keys: random (0), already sorted (1), reversed (2)
+ * or with only 16 distinct values (3).
+ */
+static void
+FillSortKeys(Uint32 *a, Uint n, int pattern)
+{
+	Uint32 state = 0x9e3779b9;
+	Uint i;
+
+	for (i = 0; i < n; i++) {
+		switch (pattern) {
+		case 0:	a[i] = SortRandom(&state);		break;
+		case 1:	a[i] = i*3;				break;
+		case 2:	a[i] = (n-i)*3;				break;
+		case 3:	a[i] = SortRandom(&state) % 16;		break;
+		}
+	}
+}
+
+typedef struct {
+	Uint32 key;
+	Uint32 seq;
+} SortRecord;
+
+static int
+CompareRecords(const void *p1, const void *p2)
+{
+	const SortRecord *r1 = p1, *r2 = p2;
+
+	return (r1->key < r2->key) ? -1 : (r1->key > r2->key) ? 1 : 0;
+}
+
+/*
+ * Check the typed sorts and M_ParallelSort() against the expected order
+ * and contents, with and without threads.
+ */
+static int
+TestSort(AG_TestInstance *ti)
+{
+	static const Uint sizes[] = { 0, 1, 2, 17, 300, 5000, 200003 };
+	const int nSizes = sizeof(sizes) / sizeof(sizes[0]);
+	const Uint nMax = 200003;
+	Uint32 *keys, *u32, sum, sumRef;
+	Sint32 *s32;
+	float *f;
+#ifdef AG_HAVE_64BIT
+	Sint64 *s64;
+	double *d;
+#endif
+	M_Vector3 *pts;
+	SortRecord *rec;
+	Uint i, n, nThreads;
+	int s, pattern, rv = 0;
+
+	keys = Malloc(nMax*sizeof(Uint32));
+	u32 = Malloc(nMax*sizeof(Uint32));
+	s32 = Malloc(nMax*sizeof(Sint32));
+	f = Malloc(nMax*sizeof(float));
+#ifdef AG_HAVE_64BIT
+	s64 = Malloc(nMax*sizeof(Sint64));
+	d = Malloc(nMax*sizeof(double));
+#endif
+	pts = Malloc(nMax*sizeof(M_Vector3));
+	rec = Malloc(nMax*sizeof(SortRecord));
+
+	for (nThreads = 1; nThreads <= 4; nThreads += 3) {
+		M_SortSetThreads(nThreads);
+		for (s = 0; s < nSizes; s++) {
+			n = sizes[s];
+			for (pattern = 0; pattern < 4; pattern++) {
+				int ok = 1;
+
+				FillSortKeys(keys, n, pattern);
+				for (sumRef = 0, i = 0; i < n; i++) {
+					u32[i] = keys[i];
+					s32[i] = (Sint32)keys[i];
+					f[i] = (float)s32[i] / 3.0f;
+#ifdef AG_HAVE_64BIT
+					s64[i] = (Sint64)s32[i] * 5000000000LL;
+					d[i] = -(double)keys[i];
+#endif
+					pts[i] = M_VECTOR3((M_Real)(keys[i] % 7),
+					    (M_Real)(keys[i] % 5), (M_Real)i);
+					rec[i].key = keys[i] % 100;
+					rec[i].seq = i;
+					sumRef += keys[i];
+				}
+				M_SortUint32(u32, n);
+				M_SortSint32(s32, n);
+				M_SortFloat(f, n);
+#ifdef AG_HAVE_64BIT
+				M_SortSint64(s64, n);
+				M_SortDouble(d, n);
+#endif
+				M_SortVector3(pts, n, M_POINT_SET_SORT_XYZ);
+				if (M_ParallelSort(rec, n, sizeof(SortRecord),
+				    CompareRecords) == -1) {
+					TestMsg(ti, "\tM_ParallelSort: %s",
+					    AG_GetError());
+					ok = 0;
+				}
+				for (sum = 0, i = 0; i < n; i++) {
+					sum += u32[i];
+				}
+				if (sum != sumRef) {
+					ok = 0;
+				}
+				for (i = 1; i < n && ok; i++) {
+					if (u32[i] < u32[i-1] ||
+					    s32[i] < s32[i-1] ||
+					    f[i] < f[i-1] ||
+#ifdef AG_HAVE_64BIT
+					    s64[i] < s64[i-1] ||
+					    d[i] < d[i-1] ||
+#endif
+					    pts[i].x < pts[i-1].x ||
+					    (pts[i].x == pts[i-1].x &&
+					     (pts[i].y < pts[i-1].y ||
+					      (pts[i].y == pts[i-1].y &&
+					       pts[i].z > pts[i-1].z))) ||
+					    rec[i].key < rec[i-1].key ||
+					    (rec[i].key == rec[i-1].key &&
+					     rec[i].seq < rec[i-1].seq))
+						ok = 0;
+				}
+				if (!ok) {
+					TestMsg(ti, "\t%u elements (input %d, "
+					            "%u threads): wrong order",
+						    n, pattern, nThreads);
+					rv = -1;
+				}
+			}
+		}
+	}
+	M_SortSetThreads(0);
+	if (rv == 0)
+		TestMsg(ti, "\tOK");
+
+	Free(rec);
+	Free(pts);
+#ifdef AG_HAVE_64BIT
+	Free(d);
+	Free(s64);
+#endif
+	Free(f);
+	Free(s32);
+	Free(u32);
+	Free(keys);
+	return (rv);
+}
+
+/*
+ * Build the 5-point finite difference operator on a g*g grid, with an
+ * optional first-order convection term (which makes it nonsymmetric).
+ * Unknown (i,j) is row i*g + j + 1 of the M_MatrixSP.
+ */
+static void *
+BuildGridMatrix(Uint g, M_Real conv)
+{
+	const Uint n = g*g;
+	void *A;
+	Uint i, j, k;
+
+	A = M_MatrixNew_SP(n, n);
+	for (i = 0; i < g; i++) {
+		for (j = 0; j < g; j++) {
+			k = i*g + j + 1;
+			*M_GetElement_SP(A, k, k) += 4.0;
+			if (i > 0)   { *M_GetElement_SP(A, k, k-g) -= 1.0; }
+			if (i < g-1) { *M_GetElement_SP(A, k, k+g) -= 1.0; }
+			if (j > 0)   { *M_GetElement_SP(A, k, k-1) -= 1.0 + conv; }
+			if (j < g-1) { *M_GetElement_SP(A, k, k+1) -= 1.0 - conv; }
+		}
+	}
+	return (A);
+}
+
+/*
+ * Check the CSR conversion, SpMV and the iterative solvers against the
+ * direct solution computed by M_FactorizeLU_SP().
+ */
+static int
+TestSparseIterative(AG_TestInstance *ti)
+{
+	static const char *precNames[] = { "none", "Jacobi", "ILU(0)" };
+	static const char *solverNames[] = { "CG", "BiCGSTAB", "GMRES" };
+	const Uint g = 20, n = g*g, gBig = 250;
+	M_MatrixCSR *A;
+	M_Precond P;
+	M_IterStats st;
+	M_Vector *xd;
+	M_Real *b, *x, *y, err, nrm;
+	void *S;
+	Uint i;
+	int c, prec, solver, rv = 0;
+
+	b = Malloc(gBig*gBig*sizeof(M_Real));
+	x = Malloc(gBig*gBig*sizeof(M_Real));
+	y = Malloc(gBig*gBig*sizeof(M_Real));
+
+	for (c = 0; c < 2; c++) {
+		S = BuildGridMatrix(g, (c == 0) ? 0.0 : 0.3);
+		if ((A = M_MatrixToCSR_SP(S)) == NULL) {
+			TestMsg(ti, "\tM_MatrixToCSR_SP: %s", AG_GetError());
+			M_MatrixFree_SP(S);
+			rv = -1;
+			break;
+		}
+		if (A->m != n || A->n != n || A->nnz != 5*n - 4*g) {
+			TestMsg(ti, "\tWrong CSR size (%ux%u, %u entries)",
+			    A->m, A->n, A->nnz);
+			rv = -1;
+		}
+
+		/* Direct solution (indices are 1-based). */
+		xd = M_VecNew(n+1);
+		for (i = 0; i < n; i++) {
+			b[i] = M_Sin((M_Real)i*0.1) + 1.0;
+			xd->v[i+1] = b[i];
+		}
+		if (M_FactorizeLU_SP(S) == -1) {
+			TestMsg(ti, "\tM_FactorizeLU_SP failed");
+			rv = -1;
+			goto next;
+		}
+		M_BacksubstLU_SP(S, xd);
+
+		/* SpMV applied to the direct solution must give b. */
+		M_MatrixMulv_CSR(A, &xd->v[1], y);
+		for (err = 0.0, i = 0; i < n; i++) {
+			if (M_Fabs(y[i] - b[i]) > err)
+				err = M_Fabs(y[i] - b[i]);
+		}
+		if (err > 1e-8) {
+			TestMsg(ti, "\tSpMV: error %g", (double)err);
+			rv = -1;
+		}
+
+		for (prec = M_PRECOND_NONE; prec <= M_PRECOND_ILU0; prec++) {
+			if (M_PrecondInit(&P, A, prec) == -1) {
+				TestMsg(ti, "\tM_PrecondInit(%s): %s",
+				    precNames[prec], AG_GetError());
+				rv = -1;
+				continue;
+			}
+			for (solver = (c == 0) ? 0 : 1; solver < 3; solver++) {
+				int status = 0;
+
+				memset(x, 0, n*sizeof(M_Real));
+				switch (solver) {
+				case 0:
+					status = M_SolveCG(A, &P, b, x,
+					    1e-10, 1000, &st);
+					break;
+				case 1:
+					status = M_SolveBiCGSTAB(A, &P, b, x,
+					    1e-10, 1000, &st);
+					break;
+				case 2:
+					status = M_SolveGMRES(A, &P, b, x, 20,
+					    1e-10, 2000, &st);
+					break;
+				}
+				for (err = 0.0, nrm = 0.0, i = 0; i < n; i++) {
+					if (M_Fabs(x[i] - xd->v[i+1]) > err) {
+						err = M_Fabs(x[i] - xd->v[i+1]);
+					}
+					if (M_Fabs(xd->v[i+1]) > nrm)
+						nrm = M_Fabs(xd->v[i+1]);
+				}
+				if (status == -1 || err > 1e-7*nrm) {
+					TestMsg(ti, "\t%s (%s, %s): error %g "
+					            "after %u iterations%s%s",
+					    solverNames[solver], precNames[prec],
+					    (c == 0) ? "symmetric" : "nonsymmetric",
+					    (double)err, st.iter,
+					    (status == -1) ? ": " : "",
+					    (status == -1) ? AG_GetError() : "");
+					rv = -1;
+				}
+			}
+			M_PrecondFree(&P);
+		}
+next:
+		M_VecFree(xd);
+		M_MatrixFree_CSR(A);
+		M_MatrixFree_SP(S);
+	}
+
+	/* Multithreaded SpMV must match the single-threaded result. */
+	S = BuildGridMatrix(gBig, 0.3);
+	if ((A = M_MatrixToCSR_SP(S)) != NULL) {
+		for (i = 0; i < A->m; i++) {
+			b[i] = (M_Real)(i % 17) - 8.0;
+		}
+		M_MatrixSetThreads_CSR(1);
+		M_MatrixMulv_CSR(A, b, x);
+		M_MatrixSetThreads_CSR(4);
+		M_MatrixMulv_CSR(A, b, y);
+		M_MatrixSetThreads_CSR(0);
+		if (memcmp(x, y, A->m*sizeof(M_Real)) != 0) {
+			TestMsg(ti, "\tMultithreaded SpMV differs");
+			rv = -1;
+		}
+		M_MatrixFree_CSR(A);
+	} else {
+		TestMsg(ti, "\tM_MatrixToCSR_SP: %s", AG_GetError());
+		rv = -1;
+	}
+	M_MatrixFree_SP(S);
+
+	if (rv == 0)
+		TestMsg(ti, "\tOK");
+
+	Free(y);
+	Free(x);
+	Free(b);
+	return (rv);
+}
+
+/* Return a pseudo-random number in [0,1). */
+static M_Real
+SpatialRandom(Uint32 *state)
+{
+	return (M_Real)(SortRandom(state) >> 8) / 16777216.0;
+}
+
+/* Fill an array of n random boxes of up to size sz in the unit square/cube. */
+static void
+FillSpatialBounds(M_BVHBounds *b, Uint n, Uint dim, M_Real sz, Uint32 *state)
+{
+	Uint i, a;
+
+	for (i = 0; i < n; i++) {
+		for (a = 0; a < 3; a++) {
+			if (a < dim) {
+				b[i].min[a] = SpatialRandom(state);
+				b[i].max[a] = b[i].min[a] + sz*SpatialRandom(state);
+			} else {
+				b[i].min[a] = b[i].max[a] = 0.0;
+			}
+		}
+	}
+}
+
+typedef struct {
+	const M_BVHBounds *b;		/* Primitives (boxes) */
+	Uint dim;
+	Uint32 _pad;
+	M_Real o[3];			/* Query point or ray origin */
+	M_Real d[3];			/* Ray direction */
+} SpatialQuery;
+
+/* Return the entry distance of the query ray into box i (or M_INFINITY). */
+static M_Real
+SpatialRayBox(void *arg, Uint i)
+{
+	const SpatialQuery *Q = arg;
+	const M_BVHBounds *b = &Q->b[i];
+	M_Real t0 = 0.0, t1 = M_INFINITY, tA, tB, tmp;
+	Uint a;
+
+	for (a = 0; a < Q->dim; a++) {
+		if (Q->d[a] == 0.0) {
+			if (Q->o[a] < b->min[a] || Q->o[a] > b->max[a]) {
+				return (M_INFINITY);
+			}
+			continue;
+		}
+		tA = (b->min[a] - Q->o[a]) / Q->d[a];
+		tB = (b->max[a] - Q->o[a]) / Q->d[a];
+		if (tA > tB) { tmp = tA; tA = tB; tB = tmp; }
+		if (tA > t0) { t0 = tA; }
+		if (tB < t1) { t1 = tB; }
+		if (t0 > t1)
+			return (M_INFINITY);
+	}
+	return (t0);
+}
+
+/* Return the distance from the query point to box i. */
+static M_Real
+SpatialDistBox(void *arg, Uint i)
+{
+	const SpatialQuery *Q = arg;
+	const M_BVHBounds *b = &Q->b[i];
+	M_Real d = 0.0, e;
+	Uint a;
+
+	for (a = 0; a < Q->dim; a++) {
+		e = 0.0;
+		if (Q->o[a] < b->min[a]) {
+			e = b->min[a] - Q->o[a];
+		} else if (Q->o[a] > b->max[a]) {
+			e = Q->o[a] - b->max[a];
+		}
+		d += e*e;
+	}
+	return M_Sqrt(d);
+}
+
+/* Check the BVH queries on the given primitives against brute force. */
+static int
+TestBVHQueries(AG_TestInstance *ti, const M_BVH *B, SpatialQuery *Q, Uint n,
+    Uint32 *state)
+{
+	M_BVHBounds q;
+	M_Real t, tRef, len, r;
+	Uint i, j, a, count, countRef;
+	int k;
+
+	for (j = 0; j < 200; j++) {
+		FillSpatialBounds(&q, 1, Q->dim, 0.1, state);
+		for (a = 0; a < Q->dim; a++) {
+			Q->o[a] = SpatialRandom(state)*1.2 - 0.1;
+			Q->d[a] = SpatialRandom(state) - 0.5;
+		}
+		for (len = 0.0, a = 0; a < Q->dim; a++) {
+			len += Q->d[a]*Q->d[a];
+		}
+		for (len = M_Sqrt(len), a = 0; a < Q->dim; a++) {
+			Q->d[a] /= len;
+		}
+		r = 0.05*SpatialRandom(state);
+
+		countRef = 0;
+		for (i = 0; i < n; i++) {
+			for (a = 0; a < Q->dim; a++) {
+				if (q.min[a] > Q->b[i].max[a] ||
+				    q.max[a] < Q->b[i].min[a])
+					break;
+			}
+			if (a == Q->dim)
+				countRef++;
+		}
+		if ((count = M_BVHQueryBox(B, &q, NULL, 0)) != countRef) {
+			TestMsg(ti, "\tM_BVHQueryBox: %u != %u", count, countRef);
+			return (-1);
+		}
+
+		countRef = 0;
+		for (i = 0; i < n; i++) {
+			if (SpatialDistBox(Q, i) <= r)
+				countRef++;
+		}
+		count = (Q->dim == 2) ?
+		    M_BVHQueryRadius2(B, M_VECTOR2(Q->o[0], Q->o[1]), r, NULL,0) :
+		    M_BVHQueryRadius3(B, M_VECTOR3(Q->o[0], Q->o[1], Q->o[2]), r,
+		                      NULL, 0);
+		if (count != countRef) {
+			TestMsg(ti, "\tM_BVHQueryRadius: %u != %u", count,
+			    countRef);
+			return (-1);
+		}
+
+		for (tRef = M_INFINITY, i = 0; i < n; i++) {
+			if ((t = SpatialRayBox(Q, i)) < tRef)
+				tRef = t;
+		}
+		if (Q->dim == 2) {
+			M_Line2 L = M_LineFromPtDir2(M_VECTOR2(Q->o[0], Q->o[1]),
+			    M_VECTOR2(Q->d[0], Q->d[1]), M_INFINITY);
+
+			k = M_BVHRayCast2(B, L, SpatialRayBox, Q, &t);
+		} else {
+			M_Line3 L = M_LineFromPtDir3(
+			    M_VECTOR3(Q->o[0], Q->o[1], Q->o[2]),
+			    M_VECTOR3(Q->d[0], Q->d[1], Q->d[2]), M_INFINITY);
+
+			k = M_BVHRayCast3(B, L, SpatialRayBox, Q, &t);
+		}
+		if (t != tRef || (k == -1) != (tRef == M_INFINITY)) {
+			TestMsg(ti, "\tM_BVHRayCast: %g != %g", (double)t,
+			    (double)tRef);
+			return (-1);
+		}
+
+		for (tRef = M_INFINITY, i = 0; i < n; i++) {
+			if ((t = SpatialDistBox(Q, i)) < tRef)
+				tRef = t;
+		}
+		k = (Q->dim == 2) ?
+		    M_BVHNearest2(B, M_VECTOR2(Q->o[0], Q->o[1]),
+		                  SpatialDistBox, Q, &t) :
+		    M_BVHNearest3(B, M_VECTOR3(Q->o[0], Q->o[1], Q->o[2]),
+		                  SpatialDistBox, Q, &t);
+		if (k == -1 || t != tRef) {
+			TestMsg(ti, "\tM_BVHNearest: %g != %g", (double)t,
+			    (double)tRef);
+			return (-1);
+		}
+	}
+	return (0);
+}
+
+/*
+ * Check the k-d tree, BVH and polygon queries against brute force, in
+ * R^2 and R^3.
+ */
+static int
+TestSpatial(AG_TestInstance *ti)
+{
+	const Uint n = 5000, nBoxes = 3000, nPoly = 1000;
+	Uint32 state = 0x2545f491;
+	M_KDTree T;
+	M_BVH B;
+	M_BVHBounds *b;
+	M_Vector2 *p2;
+	M_Vector3 *p3;
+	M_Polygon P;
+	SpatialQuery Q;
+	M_Real d, dRef, r, e;
+	Uint i, j, a, dim, count, countRef, *out;
+	int k, mode, rv = 0;
+
+	p2 = Malloc(n*sizeof(M_Vector2));
+	p3 = Malloc(n*sizeof(M_Vector3));
+	out = Malloc(n*sizeof(Uint));
+	b = Malloc(nBoxes*sizeof(M_BVHBounds));
+
+	/* k-d trees (with duplicate points). */
+	for (i = 0; i < n; i++) {
+		if (i % 10 == 9) {
+			p2[i] = p2[i-1];
+			p3[i] = p3[i-1];
+			continue;
+		}
+		p2[i] = M_VECTOR2(SpatialRandom(&state), SpatialRandom(&state));
+		p3[i] = M_VECTOR3(SpatialRandom(&state), SpatialRandom(&state),
+		                  SpatialRandom(&state));
+	}
+	M_KDTreeInit(&T);
+	if (M_KDTreeBuild2(&T, p2, 0) == -1 ||
+	    M_KDTreeNearest2(&T, M_VECTOR2(0.5, 0.5), NULL) != -1) {
+		TestMsg(ti, "\tEmpty k-d tree failed");
+		rv = -1;
+	}
+	for (dim = 2; dim <= 3; dim++) {
+		if (((dim == 2) ? M_KDTreeBuild2(&T, p2, n) :
+		                  M_KDTreeBuild3(&T, p3, n)) == -1) {
+			TestMsg(ti, "\tM_KDTreeBuild: %s", AG_GetError());
+			rv = -1;
+			break;
+		}
+		for (j = 0; j < 500 && rv == 0; j++) {
+			M_Vector2 q2 = M_VECTOR2(SpatialRandom(&state)*1.2 - 0.1,
+			                         SpatialRandom(&state)*1.2 - 0.1);
+			M_Vector3 q3 = M_VECTOR3(q2.x, q2.y,
+			                         SpatialRandom(&state)*1.2 - 0.1);
+
+			r = 0.08*SpatialRandom(&state);
+			dRef = M_INFINITY;
+			countRef = 0;
+			for (i = 0; i < n; i++) {
+				M_Real dx, dy, dz;
+
+				if (dim == 2) {
+					dx = p2[i].x - q2.x;
+					dy = p2[i].y - q2.y;
+					dz = 0.0;
+				} else {
+					dx = (M_Real)p3[i].x - (M_Real)q3.x;
+					dy = (M_Real)p3[i].y - (M_Real)q3.y;
+					dz = (M_Real)p3[i].z - (M_Real)q3.z;
+				}
+				e = dx*dx + dy*dy + dz*dz;
+				if (e < dRef) { dRef = e; }
+				if (e <= r*r) { countRef++; }
+			}
+			dRef = M_Sqrt(dRef);
+			if (dim == 2) {
+				k = M_KDTreeNearest2(&T, q2, &d);
+				count = M_KDTreeRadius2(&T, q2, r, out, n);
+				e = (k >= 0) ? M_VecDistance2(p2[k], q2) : 0.0;
+			} else {
+				k = M_KDTreeNearest3(&T, q3, &d);
+				count = M_KDTreeRadius3(&T, q3, r, out, n);
+				e = (k >= 0) ? M_VecDistance3(p3[k], q3) : 0.0;
+			}
+			if (k < 0 || d != dRef || M_Fabs(e - dRef) > 1e-5 ||
+			    count != countRef) {
+				TestMsg(ti, "\tM_KDTree (R^%u): nearest %g != %g, "
+				            "radius %u != %u", dim, (double)d,
+					    (double)dRef, count, countRef);
+				rv = -1;
+			}
+		}
+	}
+	M_KDTreeFree(&T);
+
+	/* BVH over boxes, built with each method, then refit and updated. */
+	for (dim = 2; dim <= 3 && rv == 0; dim++) {
+		for (mode = M_BVH_SAH; mode <= M_BVH_MEDIAN; mode++) {
+			FillSpatialBounds(b, nBoxes, dim, 0.05, &state);
+			M_BVHInit(&B, dim);
+			if (M_BVHBuild(&B, b, nBoxes, mode) == -1) {
+				TestMsg(ti, "\tM_BVHBuild: %s", AG_GetError());
+				rv = -1;
+				break;
+			}
+			Q.b = b;
+			Q.dim = dim;
+			Q.o[2] = Q.d[2] = 0.0;
+			if (TestBVHQueries(ti, &B, &Q, nBoxes, &state) == -1) {
+				rv = -1;
+			}
+			for (i = 0; i < nBoxes; i++) {
+				for (a = 0; a < dim; a++) {
+					e = 0.2*SpatialRandom(&state) - 0.1;
+					b[i].min[a] += e;
+					b[i].max[a] += e;
+				}
+			}
+			M_BVHRefit(&B, b);
+			if (TestBVHQueries(ti, &B, &Q, nBoxes, &state) == -1) {
+				TestMsg(ti, "\t(after M_BVHRefit)");
+				rv = -1;
+			}
+			for (i = 0; i < nBoxes; i += 7) {
+				FillSpatialBounds(&b[i], 1, dim, 0.05, &state);
+				M_BVHUpdate(&B, i, &b[i]);
+			}
+			if (TestBVHQueries(ti, &B, &Q, nBoxes, &state) == -1) {
+				TestMsg(ti, "\t(after M_BVHUpdate)");
+				rv = -1;
+			}
+			M_BVHFree(&B);
+		}
+	}
+
+	/* Point in polygon over a star-shaped polygon. */
+	M_PolygonInit(&P);
+	for (i = 0; i < nPoly; i++) {
+		M_Real th = 2.0*M_PI*(M_Real)i/(M_Real)nPoly;
+
+		r = 0.1 + 0.4*SpatialRandom(&state);
+		M_PolygonAddVertex(&P, M_VECTOR2(0.5 + r*M_Cos(th),
+		                                 0.5 + r*M_Sin(th)));
+	}
+	M_BVHInit(&B, 2);
+	if (M_BVHFromPolygon(&B, &P) == -1) {
+		TestMsg(ti, "\tM_BVHFromPolygon: %s", AG_GetError());
+		rv = -1;
+	} else {
+		for (j = 0; j < 5000; j++) {
+			M_Vector2 q = M_VECTOR2(SpatialRandom(&state),
+			                        SpatialRandom(&state));
+
+			if (j % 100 == 0) {
+				q = P.v[j % nPoly];		/* On a vertex */
+			}
+			if (M_PointInPolygonBVH(&P, &B, q) !=
+			    M_PointInPolygon(&P, q)) {
+				TestMsg(ti, "\tM_PointInPolygonBVH(%g,%g) "
+				            "differs", (double)q.x,
+					    (double)q.y);
+				rv = -1;
+				break;
+			}
+		}
+	}
+	M_BVHFree(&B);
+	M_PolygonFree(&P);
+
+	if (rv == 0)
+		TestMsg(ti, "\tOK");
+
+	Free(b);
+	Free(out);
+	Free(p3);
+	Free(p2);
+	return (rv);
+}
+
 static void
 TestMatrix44(AG_TestInstance *ti)
 {
@@ -267,6 +1206,7 @@ Test(void *obj)
 	AG_TestInstance *ti = obj;
 	const M_VectorOps3 *prevVecOps3 = mVecOps3;
 	const M_MatrixOps44 *prevMatOps44 = mMatOps44;
+	int rv = 0;
 
 	TestMsg(ti, "Agar-Math settings:");
 
@@ -305,6 +1245,7 @@ Test(void *obj)
 	TestMsg(ti, "\tM_Vector4 engine: %s", mVecOps4->name);
 	TestMsg(ti, "\tM_Matrix engine: %s", mMatOps->name);
 	TestMsg(ti, "\tM_Matrix44 engine: %s", mMatOps44->name);
+	TestMsg(ti, "\tM_VectorSoA3 engine: %s", mVecOpsSoA3->name);
 	TestMsgS(ti, "");
 	
 	mVecOps3 = &mVecOps3_FPU;
@@ -312,7 +1253,27 @@ Test(void *obj)
 	TestMsg(ti, "M_Complex Test (FPU):");	TestComplex(ti);
 	TestMsg(ti, "M_Vector Test (FPU):");	TestVector(ti);
 	TestMsg(ti, "M_Matrix Test (FPU):");	TestMatrix(ti);
+	TestMsg(ti, "M_Matrix Test (blocked, %s):", M_MatrixGetKernel_BLK());
+	if (TestMatrixBlocked(ti) == -1) {
+		rv = -1;
+	}
 	TestMsg(ti, "M_Vector3 Test (FPU):");	TestVector3(ti);
+	TestMsg(ti, "M_VectorSoA3 Test:");
+	if (TestVectorSoA3(ti) == -1) {
+		rv = -1;
+	}
+	TestMsg(ti, "Sort Test:");
+	if (TestSort(ti) == -1) {
+		rv = -1;
+	}
+	TestMsg(ti, "Sparse Iterative Solver Test:");
+	if (TestSparseIterative(ti) == -1) {
+		rv = -1;
+	}
+	TestMsg(ti, "Spatial Index Test:");
+	if (TestSpatial(ti) == -1) {
+		rv = -1;
+	}
 	TestMsg(ti, "M_Matrix44 Test (FPU):");	TestMatrix44(ti);
 
 #if defined(HAVE_SSE)
@@ -328,7 +1289,463 @@ Test(void *obj)
 
 	mMatOps44 = prevMatOps44;
 	mVecOps3 = prevVecOps3;
-	return (0);
+	return (rv);
+}
+
+/*
+ * Report the throughput of n*n matrix products in GFLOP/s (2*n^3 floating
+ * point operations per product), repeating each product for at least
+ * MATBENCH_NS.
+ */
+static void
+BenchMatrixMul(AG_TestInstance *ti, const M_MatrixOps *ops)
+{
+	void *A, *B, *C;
+	Uint64 t0, t;
+	Uint n, nRuns;
+
+	for (n = MATBENCH_MIN; n <= MATBENCH_MAX; n <<= 1) {
+		if ((A = ops->NewMatrix(n,n)) == NULL ||
+		    (B = ops->NewMatrix(n,n)) == NULL ||
+		    (C = ops->NewMatrix(n,n)) == NULL) {
+			TestMsg(ti, "\t%ux%u: %s", n,n, AG_GetError());
+			return;
+		}
+		FillMatrix(ops, A, n,n, 1);
+		FillMatrix(ops, B, n,n, 2);
+		nRuns = 0;
+		t0 = AG_PerfTime();
+		do {
+			ops->Mulv(A, B, C);
+			nRuns++;
+		} while ((t = AG_PerfTime() - t0) < MATBENCH_NS);
+
+		TestMsg(ti, "\t%4ux%-4u %8.2f GFLOP/s", n,n,
+		    2.0*(double)n*n*n*nRuns / (double)t);
+
+		ops->FreeMatrix(C);
+		ops->FreeMatrix(B);
+		ops->FreeMatrix(A);
+	}
+}
+
+/*
+ * Report the throughput of the batched M_VectorSoA3 operations in millions
+ * of vectors per second and in GB/s of stream data read and written.
+ */
+static void
+BenchVectorSoA3(AG_TestInstance *ti, const M_VectorOpsSoA3 *ops)
+{
+	const Uint n = SOABENCH_N;
+	M_VectorSoA3 A, B, C;
+	M_SoAReal *d;
+	M_Matrix44 T;
+	Uint64 t0, t;
+	Uint nRuns, op, nWords;
+
+	if (M_VectorSoAInit3(&A, n) == -1 ||
+	    M_VectorSoAInit3(&B, n) == -1 ||
+	    M_VectorSoAInit3(&C, n) == -1 ||
+	    (d = TryMalloc(n*sizeof(M_SoAReal))) == NULL) {
+		TestMsg(ti, "\t%s", AG_GetError());
+		return;
+	}
+	FillVectorSoA3(&A, n, 1);
+	FillVectorSoA3(&B, n, 2);
+	M_MatIdentity44v(&T);
+	M_MatRotateAxis44(&T, M_Radians(33.0),
+	    M_VecNorm3(M_VECTOR3(11.6, 4.51, 8.5)));
+
+	for (op = 0; op < 6; op++) {
+		static const char *opNames[] = {
+			"Transform", "TransformDir", "Dot", "Len", "Norm", "Cross"
+		};
+		static const Uint opWords[] = { 6, 6, 7, 4, 6, 9 };
+
+		nRuns = 0;
+		t0 = AG_PerfTime();
+		do {
+			switch (op) {
+			case 0:	ops->Transform(&C, &T, &A);	break;
+			case 1:	ops->TransformDir(&C, &T, &A);	break;
+			case 2:	ops->Dot(d, &A, &B);		break;
+			case 3:	ops->Len(d, &A);		break;
+			case 4:	ops->Norm(&C, &A);		break;
+			case 5:	ops->Cross(&C, &A, &B);		break;
+			}
+			nRuns++;
+		} while ((t = AG_PerfTime() - t0) < SOABENCH_NS);
+
+		nWords = opWords[op];
+		TestMsg(ti, "\t%-12s %8.1f Mvec/s %7.2f GB/s", opNames[op],
+		    1e3*(double)n*nRuns / (double)t,
+		    (double)n*nRuns*nWords*sizeof(M_SoAReal) / (double)t);
+	}
+
+	Free(d);
+	M_VectorSoAFree3(&C);
+	M_VectorSoAFree3(&B);
+	M_VectorSoAFree3(&A);
+}
+
+static M_Real
+CompareKeysReal(const void *p1, const void *p2)
+{
+	const Uint32 *k1 = p1, *k2 = p2;
+
+	return (M_Real)*k1 - (M_Real)*k2;
+}
+
+static int
+CompareKeys(const void *p1, const void *p2)
+{
+	const Uint32 k1 = *(const Uint32 *)p1, k2 = *(const Uint32 *)p2;
+
+	return (k1 < k2) ? -1 : (k1 > k2) ? 1 : 0;
+}
+
+/*
+ * Report the throughput of the sorting routines in millions of elements
+ * per second, for random, sorted and duplicate-heavy Uint32 keys.
+ */
+static void
+BenchSort(AG_TestInstance *ti)
+{
+	static const char *patterns[] = { "random", "sorted", "reversed",
+	                                  "16 values" };
+	static const char *algs[] = { "M_QSort", "M_MergeSort",
+	                              "M_ParallelSort", "M_SortUint32",
+	                              "M_SortFloat", "M_SortVector3" };
+	const int nAlgs = sizeof(algs) / sizeof(algs[0]);
+	const Uint n = SORTBENCH_N;
+	Uint32 *keys, *a;
+	float *f;
+	M_Vector3 *pts;
+	Uint64 t0, t;
+	Uint i;
+	int pattern, alg;
+
+	keys = Malloc(n*sizeof(Uint32));
+	a = Malloc(n*sizeof(Uint32));
+	f = Malloc(n*sizeof(float));
+	pts = Malloc(n*sizeof(M_Vector3));
+
+	for (pattern = 0; pattern < 4; pattern++) {
+		FillSortKeys(keys, n, pattern);
+		TestMsg(ti, "\t%s:", patterns[pattern]);
+		for (alg = 0; alg < nAlgs; alg++) {
+			for (i = 0; i < n; i++) {
+				a[i] = keys[i];
+				f[i] = (float)keys[i];
+				pts[i] = M_VECTOR3((M_Real)(keys[i] & 0xff),
+				    (M_Real)(keys[i] >> 8), (M_Real)i);
+			}
+			t0 = AG_PerfTime();
+			switch (alg) {
+			case 0:
+				M_QSort(a, n, sizeof(Uint32), CompareKeysReal);
+				break;
+			case 1:
+				M_MergeSort(a, n, sizeof(Uint32), CompareKeys);
+				break;
+			case 2:
+				M_ParallelSort(a, n, sizeof(Uint32), CompareKeys);
+				break;
+			case 3:
+				M_SortUint32(a, n);
+				break;
+			case 4:
+				M_SortFloat(f, n);
+				break;
+			case 5:
+				M_SortVector3(pts, n, M_POINT_SET_SORT_XYZ);
+				break;
+			}
+			t = AG_PerfTime() - t0;
+			TestMsg(ti, "\t\t%-16s %8.2f Melem/s", algs[alg],
+			    1e3*(double)n / (double)t);
+		}
+	}
+
+	Free(pts);
+	Free(f);
+	Free(a);
+	Free(keys);
+}
+
+/*
+ * Compare the direct sparse LU solver with the iterative solvers on the
+ * 2D Poisson problem, for increasing grid sizes. Report the total time
+ * (including factorization or preconditioner setup) and iteration counts.
+ */
+static void
+BenchSparse(AG_TestInstance *ti)
+{
+	static const char *names[] = { "CG+Jacobi", "CG+ILU(0)",
+	                               "BiCGSTAB+ILU(0)", "GMRES(30)+ILU(0)" };
+	static const enum m_precond_type precs[] = {
+		M_PRECOND_JACOBI, M_PRECOND_ILU0, M_PRECOND_ILU0, M_PRECOND_ILU0
+	};
+	M_MatrixCSR *A;
+	M_Precond P;
+	M_IterStats st;
+	M_Vector *xd;
+	M_Real *b, *x;
+	void *S;
+	Uint64 t0, t;
+	Uint g, n, i;
+	int alg, status;
+
+	for (g = SPBENCH_MIN; g <= SPBENCH_MAX; g <<= 1) {
+		n = g*g;
+		S = BuildGridMatrix(g, 0.0);
+		b = Malloc(n*sizeof(M_Real));
+		x = Malloc(n*sizeof(M_Real));
+		for (i = 0; i < n; i++)
+			b[i] = 1.0;
+
+		t0 = AG_PerfTime();
+		A = M_MatrixToCSR_SP(S);
+		t = AG_PerfTime() - t0;
+		if (A == NULL) {
+			TestMsg(ti, "\t%s", AG_GetError());
+			goto next;
+		}
+		TestMsg(ti, "\t%ux%u grid (%u unknowns, %u nonzeros):",
+		    g, g, n, A->nnz);
+		TestMsg(ti, "\t\t%-18s %10.2f ms", "CSR conversion",
+		    (double)t / 1e6);
+
+		if (g <= SPBENCH_DIRECT_MAX) {
+			xd = M_VecNew(n+1);
+			for (i = 0; i < n; i++) {
+				xd->v[i+1] = b[i];
+			}
+			t0 = AG_PerfTime();
+			status = M_FactorizeLU_SP(S);
+			if (status == 0) {
+				M_BacksubstLU_SP(S, xd);
+			}
+			t = AG_PerfTime() - t0;
+			TestMsg(ti, "\t\t%-18s %10.2f ms%s", "Sparse LU",
+			    (double)t / 1e6, (status == 0) ? "" : " (failed)");
+			M_VecFree(xd);
+		}
+
+		for (alg = 0; alg < 4; alg++) {
+			memset(x, 0, n*sizeof(M_Real));
+			t0 = AG_PerfTime();
+			if (M_PrecondInit(&P, A, precs[alg]) == -1) {
+				TestMsg(ti, "\t\t%-18s %s", names[alg],
+				    AG_GetError());
+				continue;
+			}
+			switch (alg) {
+			case 0:
+			case 1:
+				status = M_SolveCG(A, &P, b, x, 1e-8, 10000, &st);
+				break;
+			case 2:
+				status = M_SolveBiCGSTAB(A, &P, b, x, 1e-8,
+				    10000, &st);
+				break;
+			default:
+				status = M_SolveGMRES(A, &P, b, x, 30, 1e-8,
+				    10000, &st);
+				break;
+			}
+			t = AG_PerfTime() - t0;
+			M_PrecondFree(&P);
+			TestMsg(ti, "\t\t%-18s %10.2f ms %6u iterations "
+			            "(residual %.1e)%s", names[alg],
+			    (double)t / 1e6, st.iter, (double)st.resid,
+			    (status == 0) ? "" : " (no convergence)");
+		}
+		M_MatrixFree_CSR(A);
+next:
+		Free(x);
+		Free(b);
+		M_MatrixFree_SP(S);
+	}
+}
+
+/* Return the rate of n operations over t ns, per second. */
+static double
+SpatialRate(Uint n, Uint64 t)
+{
+	return (t > 0) ? 1e9*(double)n / (double)t : 0.0;
+}
+
+/*
+ * Report the construction time and query throughput of k-d trees, BVHs
+ * and indexed point-in-polygon tests for 10^4 to 10^7 primitives in R^2,
+ * against linear scans. Linear scans are limited to about 10^8 steps.
+ */
+static void
+BenchSpatial(AG_TestInstance *ti)
+{
+	const Uint nQ = KDBENCH_NQ;
+	Uint32 state = 0x2545f491;
+	M_KDTree T;
+	M_BVH B;
+	M_BVHBounds *b;
+	M_Vector2 *p, *q;
+	M_Polygon P;
+	SpatialQuery Q;
+	Uint64 t0, t;
+	M_Real d, r, best;
+	Uint n, i, j, nScan, hits;
+
+	q = Malloc(nQ*sizeof(M_Vector2));
+	for (j = 0; j < nQ; j++)
+		q[j] = M_VECTOR2(SpatialRandom(&state), SpatialRandom(&state));
+
+	for (n = KDBENCH_MIN; n <= KDBENCH_MAX; n *= 10) {
+		nScan = (100000000 / n < nQ) ? 100000000 / n : nQ;
+		r = 3.0 / M_Sqrt((M_Real)n);
+		TestMsg(ti, "\t%u primitives:", n);
+
+		/* k-d tree over random points. */
+		if ((p = TryMalloc(n*sizeof(M_Vector2))) == NULL) {
+			TestMsg(ti, "\t\t%s", AG_GetError());
+			break;
+		}
+		for (i = 0; i < n; i++) {
+			p[i] = M_VECTOR2(SpatialRandom(&state),
+			                 SpatialRandom(&state));
+		}
+		M_KDTreeInit(&T);
+		t0 = AG_PerfTime();
+		if (M_KDTreeBuild2(&T, p, n) == 0) {
+			t = AG_PerfTime() - t0;
+			TestMsg(ti, "\t\tM_KDTreeBuild2      %10.2f ms",
+			    (double)t / 1e6);
+			t0 = AG_PerfTime();
+			for (j = 0; j < nQ; j++) {
+				M_KDTreeNearest2(&T, q[j], &d);
+			}
+			t = AG_PerfTime() - t0;
+			TestMsg(ti, "\t\tM_KDTreeNearest2    %10.0f q/s",
+			    SpatialRate(nQ, t));
+			t0 = AG_PerfTime();
+			for (j = 0; j < nQ; j++) {
+				M_KDTreeRadius2(&T, q[j], r, NULL, 0);
+			}
+			t = AG_PerfTime() - t0;
+			TestMsg(ti, "\t\tM_KDTreeRadius2     %10.0f q/s",
+			    SpatialRate(nQ, t));
+			t0 = AG_PerfTime();
+			for (j = 0; j < nScan; j++) {
+				for (best = M_INFINITY, i = 0; i < n; i++) {
+					if ((d = M_VecDistance2(p[i], q[j])) < best)
+						best = d;
+				}
+			}
+			t = AG_PerfTime() - t0;
+			TestMsg(ti, "\t\tLinear nearest      %10.0f q/s",
+			    SpatialRate(nScan, t));
+		} else {
+			TestMsg(ti, "\t\tM_KDTreeBuild2: %s", AG_GetError());
+		}
+		M_KDTreeFree(&T);
+		Free(p);
+
+		/* BVH over small random boxes. */
+		if ((b = TryMalloc(n*sizeof(M_BVHBounds))) == NULL) {
+			TestMsg(ti, "\t\t%s", AG_GetError());
+			break;
+		}
+		FillSpatialBounds(b, n, 2, 2.0*r/3.0, &state);
+		M_BVHInit(&B, 2);
+		t0 = AG_PerfTime();
+		if (M_BVHBuild(&B, b, n, M_BVH_MEDIAN) == 0) {
+			t = AG_PerfTime() - t0;
+			TestMsg(ti, "\t\tM_BVHBuild (median) %10.2f ms",
+			    (double)t / 1e6);
+		}
+		t0 = AG_PerfTime();
+		if (M_BVHBuild(&B, b, n, M_BVH_SAH) == 0) {
+			t = AG_PerfTime() - t0;
+			TestMsg(ti, "\t\tM_BVHBuild (SAH)    %10.2f ms",
+			    (double)t / 1e6);
+
+			t0 = AG_PerfTime();
+			M_BVHRefit(&B, b);
+			t = AG_PerfTime() - t0;
+			TestMsg(ti, "\t\tM_BVHRefit          %10.2f ms",
+			    (double)t / 1e6);
+
+			Q.b = b;
+			Q.dim = 2;
+			Q.o[2] = Q.d[2] = 0.0;
+			t0 = AG_PerfTime();
+			for (hits = 0, j = 0; j < nQ; j++) {
+				M_Line2 L;
+
+				d = 2.0*M_PI*(M_Real)j / (M_Real)nQ;
+				L = M_LineFromPtDir2(q[j],
+				    M_VECTOR2(M_Cos(d), M_Sin(d)), M_INFINITY);
+				Q.o[0] = q[j].x;	Q.d[0] = L.d.x;
+				Q.o[1] = q[j].y;	Q.d[1] = L.d.y;
+				if (M_BVHRayCast2(&B, L, SpatialRayBox, &Q,
+				    NULL) != -1)
+					hits++;
+			}
+			t = AG_PerfTime() - t0;
+			TestMsg(ti, "\t\tM_BVHRayCast2       %10.0f q/s "
+			            "(%u hits)", SpatialRate(nQ, t), hits);
+			t0 = AG_PerfTime();
+			for (j = 0; j < nQ; j++) {
+				M_BVHQueryRadius2(&B, q[j], r, NULL, 0);
+			}
+			t = AG_PerfTime() - t0;
+			TestMsg(ti, "\t\tM_BVHQueryRadius2   %10.0f q/s",
+			    SpatialRate(nQ, t));
+		} else {
+			TestMsg(ti, "\t\tM_BVHBuild: %s", AG_GetError());
+		}
+		M_BVHFree(&B);
+		Free(b);
+
+		/* Point in a smooth star-shaped polygon with n vertices. */
+		M_PolygonInit(&P);
+		if ((P.v = TryMalloc(n*sizeof(M_Vector2))) == NULL) {
+			TestMsg(ti, "\t\t%s", AG_GetError());
+			break;
+		}
+		for (P.n = 0; P.n < n; P.n++) {
+			d = 2.0*M_PI*(M_Real)P.n / (M_Real)n;
+			r = 0.3 + 0.15*M_Sin(7.0*d);
+			P.v[P.n] = M_VECTOR2(0.5 + r*M_Cos(d),
+			                     0.5 + r*M_Sin(d));
+		}
+		M_BVHInit(&B, 2);
+		t0 = AG_PerfTime();
+		if (M_BVHFromPolygon(&B, &P) == 0) {
+			t = AG_PerfTime() - t0;
+			TestMsg(ti, "\t\tM_BVHFromPolygon    %10.2f ms",
+			    (double)t / 1e6);
+			t0 = AG_PerfTime();
+			for (hits = 0, j = 0; j < nQ; j++) {
+				hits += M_PointInPolygonBVH(&P, &B, q[j]);
+			}
+			t = AG_PerfTime() - t0;
+			TestMsg(ti, "\t\tM_PointInPolygonBVH %10.0f q/s",
+			    SpatialRate(nQ, t));
+			t0 = AG_PerfTime();
+			for (hits = 0, j = 0; j < nScan; j++) {
+				hits += M_PointInPolygon(&P, q[j]);
+			}
+			t = AG_PerfTime() - t0;
+			TestMsg(ti, "\t\tM_PointInPolygon    %10.0f q/s",
+			    SpatialRate(nScan, t));
+		} else {
+			TestMsg(ti, "\t\tM_BVHFromPolygon: %s", AG_GetError());
+		}
+		M_BVHFree(&B);
+		M_PolygonFree(&P);
+	}
+	Free(q);
 }
 
 static int
@@ -337,6 +1754,7 @@ Bench(void *obj)
 	AG_TestInstance *ti = obj;
 	const M_VectorOps3 *prevVecOps3 = mVecOps3;
 	const M_MatrixOps44 *prevMatOps44 = mMatOps44;
+	const M_VectorOpsSoA3 **pOps;
 
 #if defined(INLINE_SSE)
 	TestMsg(ti, "M_Vector3 Microbenchmark (INLINE SSE):");
@@ -358,6 +1776,29 @@ Bench(void *obj)
 # endif
 #endif /* !INLINE_SSE */
 
+	TestMsg(ti, "M_Matrix Multiply (FPU):");
+	BenchMatrixMul(ti, &mMatOps_FPU);
+	TestMsg(ti, "M_Matrix Multiply (blocked, %s):", M_MatrixGetKernel_BLK());
+	BenchMatrixMul(ti, &mMatOps_BLK);
+
+	for (pOps = &mVecOpsSoA3List[0]; *pOps != NULL; pOps++) {
+		if (((*pOps)->ext & agCPU.ext) != (*pOps)->ext) {
+			continue;
+		}
+		TestMsg(ti, "M_VectorSoA3 Throughput (%s, %u vectors):",
+		    (*pOps)->name, SOABENCH_N);
+		BenchVectorSoA3(ti, *pOps);
+	}
+
+	TestMsg(ti, "Sorting (%u elements):", SORTBENCH_N);
+	BenchSort(ti);
+
+	TestMsg(ti, "Sparse Solvers (2D Poisson):");
+	BenchSparse(ti);
+
+	TestMsg(ti, "Spatial Indices (%u queries):", KDBENCH_NQ);
+	BenchSpatial(ti);
+
 	mMatOps44 = prevMatOps44;
 	mVecOps3 = prevVecOps3;
 	return (0);
@@ -10,9 +10,16 @@
 #include "objsystem_animal.h"
 #include "objsystem_mammal.h"
 
+#define NBENCHOBJS 4
+
 typedef struct {
 	AG_TestInstance _inherit;
 	AG_Object vfsRoot;			/* Our test VFS */
+	AG_Object benchObj[NBENCHOBJS];		/* For event/variable benchmarks */
+	AG_VariableHandle benchVar[NBENCHOBJS];	/* For variable benchmark */
+	int nPosted;
+	int sum;
+	AG_Event *evUnset;			/* For TestUnsetNext() */
 } MyTestInstance;
 
 static int inited = 0;
@@ -77,6 +84,205 @@ TestGUI(void *obj, AG_Window *win)
 	return (0);
 }
 
+static void
+CountHandler(AG_Event *event)
+{
+	MyTestInstance *ti = AG_PTR(1);
+
+	ti->nPosted++;
+}
+
+static void
+UnsetNextHandler(AG_Event *event)
+{
+	MyTestInstance *ti = AG_PTR(1);
+
+	AG_UnsetEventByPtr(AG_SELF(), ti->evUnset);
+	ti->nPosted++;
+}
+
+static void
+UnsetHandler(AG_Event *event)
+{
+	MyTestInstance *ti = AG_PTR(1);
+
+	ti->sum++;				/* Should not be reached */
+}
+
+/*
+ * Post (or forward) an event whose first handler deletes the second one.
+ * The second handler must not run and the third one must. With nOther
+ * other handlers, the object uses the hashed index of event handlers.
+ */
+static int
+TestUnsetNext(void *obj, int nOther, int forward)
+{
+	MyTestInstance *ti = obj;
+	AG_Object ob;
+	int i, rv;
+
+	AG_ObjectInitStatic(&ob, NULL);
+	for (i = 0; i < nOther; i++) {
+		AG_SetEvent(&ob, AG_Printf("other-%d", i),
+		    CountHandler, "%p", ti);
+	}
+	AG_AddEvent(&ob, "unset-next", UnsetNextHandler, "%p", ti);
+	ti->evUnset = AG_AddEvent(&ob, "unset-next", UnsetHandler, "%p", ti);
+	AG_AddEvent(&ob, "unset-next", CountHandler, "%p", ti);
+
+	ti->nPosted = 0;
+	ti->sum = 0;
+	if (forward) {
+		AG_Event ev;
+
+		AG_EventArgs(&ev, "%p", ti);
+		AG_Strlcpy(ev.name, "unset-next", sizeof(ev.name));
+		AG_ForwardEvent(&ob, &ev);
+	} else {
+		AG_PostEvent(&ob, "unset-next", NULL);
+	}
+	if (ti->nPosted != 2 || ti->sum != 0) {
+		TestMsg(obj, "%s with %d handlers: %d invoked, %d deleted",
+		    forward ? "ForwardEvent" : "PostEvent", nOther + 3,
+		    ti->nPosted, ti->sum);
+		rv = -1;
+	} else {
+		rv = 0;
+	}
+	AG_ObjectDestroy(&ob);
+	return (rv);
+}
+
+static int
+Test(void *obj)
+{
+	if (TestUnsetNext(obj, 0, 0) == -1 ||
+	    TestUnsetNext(obj, 0, 1) == -1 ||
+	    TestUnsetNext(obj, AG_EVENT_INDEX_MIN, 0) == -1 ||
+	    TestUnsetNext(obj, AG_EVENT_INDEX_MIN, 1) == -1) {
+		return (-1);
+	}
+	TestMsgS(obj, "Deleting the next handler from an event handler: OK");
+	return (0);
+}
+
+static void
+BenchHandler(AG_Event *event)
+{
+	MyTestInstance *ti = AG_PTR(1);
+
+	ti->nPosted++;
+}
+
+/*
+ * Post an event to the handler registered last (worst case for a linear
+ * search of the event handler list).
+ */
+static __inline__ void
+BenchPost(MyTestInstance *ti, int nObj)
+{
+	int i;
+
+	for (i = 0; i < 100; i++)
+		AG_PostEvent(&ti->benchObj[nObj], "bench-last", "%i", i);
+}
+static void PostEvent_1(void *ti)    { BenchPost(ti, 0); }
+static void PostEvent_10(void *ti)   { BenchPost(ti, 1); }
+static void PostEvent_100(void *ti)  { BenchPost(ti, 2); }
+static void PostEvent_1000(void *ti) { BenchPost(ti, 3); }
+
+static struct ag_benchmark_fn eventBenchFns[] = {
+	{ "PostEvent (1 handler)",     PostEvent_1 },
+	{ "PostEvent (10 handlers)",   PostEvent_10 },
+	{ "PostEvent (100 handlers)",  PostEvent_100 },
+	{ "PostEvent (1000 handlers)", PostEvent_1000 },
+};
+static struct ag_benchmark eventBench = {
+	"Events",
+	&eventBenchFns[0],
+	sizeof(eventBenchFns) / sizeof(eventBenchFns[0]),
+	10, 100, 2000000000
+};
+
+/*
+ * Read the variable created last (worst case for a linear search of the
+ * variable list), by name or through a handle.
+ */
+static __inline__ void
+BenchGetInt(MyTestInstance *ti, int nObj)
+{
+	int i;
+
+	for (i = 0; i < 100; i++)
+		ti->sum += AG_GetInt(&ti->benchObj[nObj], "bench-last");
+}
+static __inline__ void
+BenchGetIntH(MyTestInstance *ti, int nObj)
+{
+	int i;
+
+	for (i = 0; i < 100; i++)
+		ti->sum += AG_GetIntH(&ti->benchVar[nObj]);
+}
+static void GetInt_1(void *ti)     { BenchGetInt(ti, 0); }
+static void GetInt_10(void *ti)    { BenchGetInt(ti, 1); }
+static void GetInt_100(void *ti)   { BenchGetInt(ti, 2); }
+static void GetInt_1000(void *ti)  { BenchGetInt(ti, 3); }
+static void GetIntH_1(void *ti)    { BenchGetIntH(ti, 0); }
+static void GetIntH_1000(void *ti) { BenchGetIntH(ti, 3); }
+
+static struct ag_benchmark_fn varBenchFns[] = {
+	{ "GetInt (1 variable)",      GetInt_1 },
+	{ "GetInt (10 variables)",    GetInt_10 },
+	{ "GetInt (100 variables)",   GetInt_100 },
+	{ "GetInt (1000 variables)",  GetInt_1000 },
+	{ "GetIntH (1 variable)",     GetIntH_1 },
+	{ "GetIntH (1000 variables)", GetIntH_1000 },
+};
+static struct ag_benchmark varBench = {
+	"Variables",
+	&varBenchFns[0],
+	sizeof(varBenchFns) / sizeof(varBenchFns[0]),
+	10, 100, 2000000000
+};
+
+static int
+Bench(void *obj)
+{
+	MyTestInstance *ti = obj;
+	const int nHandlers[NBENCHOBJS] = { 1, 10, 100, 1000 };
+	int i, j;
+
+	for (i = 0; i < NBENCHOBJS; i++) {
+		AG_Object *ob = &ti->benchObj[i];
+
+		AG_ObjectInitStatic(ob, NULL);
+		for (j = 0; j < nHandlers[i]-1; j++) {
+			AG_SetEvent(ob, AG_Printf("bench-%d", j),
+			    BenchHandler, "%p", ti);
+		}
+		AG_SetEvent(ob, "bench-last", BenchHandler, "%p", ti);
+
+		for (j = 0; j < nHandlers[i]-1; j++) {
+			AG_SetInt(ob, AG_Printf("bench-%d", j), j);
+		}
+		AG_SetInt(ob, "bench-last", 1);
+		AG_InitVariableHandle(&ti->benchVar[i], ob, "bench-last");
+	}
+	ti->nPosted = 0;
+	ti->sum = 0;
+
+	TestExecBenchmark(obj, &eventBench);
+	TestMsg(obj, "Posted %d events", ti->nPosted);
+	TestExecBenchmark(obj, &varBench);
+	TestMsg(obj, "Read %d variables", ti->sum);
+
+	for (i = 0; i < NBENCHOBJS; i++) {
+		AG_ObjectDestroy(&ti->benchObj[i]);
+	}
+	return (0);
+}
+
 const AG_TestCase objsystemTest = {
 	AGSI_IDEOGRAM AGSI_SMALL_SPHERE AGSI_RST,
 	"objsystem",
@@ -86,8 +292,8 @@ const AG_TestCase objsystemTest = {
 	sizeof(MyTestInstance),
 	Init,
 	Destroy,
-	NULL,		/* test */
+	Test,
 	TestGUI,
-	NULL		/* bench */
+	Bench
 };
 #endif /* AG_TIMERS */
@@ -0,0 +1,204 @@
+/*	Public domain	*/
+/*
+ * Test the AG_Perf(3) counters and histograms.
+ */
+
+#include "agartest.h"
+
+#include <string.h>
+
+static int
+TestHist(void *obj)
+{
+	AG_PerfHist h;
+	Uint64 p;
+	int i;
+
+	memset(&h, 0, sizeof(h));
+	for (i = 0; i < 90; i++) {
+		AG_PerfHistAdd(&h, 500);		/* Bin 0 */
+	}
+	for (i = 0; i < 10; i++) {
+		AG_PerfHistAdd(&h, 3000);		/* Bin 2 */
+	}
+	if (h.n != 100 || h.tMin != 500 || h.tMax != 3000 ||
+	    h.tSum != 90*500 + 10*3000) {
+		TestMsgS(obj, "Bad histogram totals");
+		return (-1);
+	}
+	if (h.bins[0] != 90 || h.bins[2] != 10) {
+		TestMsgS(obj, "Bad histogram bins");
+		return (-1);
+	}
+	if ((p = AG_PerfHistPercentile(&h, 50)) != AG_PerfBinMax(0)) {
+		TestMsg(obj, "p50 = %lu (expected %lu)", (Ulong)p,
+		    (Ulong)AG_PerfBinMax(0));
+		return (-1);
+	}
+	if ((p = AG_PerfHistPercentile(&h, 95)) != 3000) {
+		TestMsg(obj, "p95 = %lu (expected 3000)", (Ulong)p);
+		return (-1);
+	}
+	return (0);
+}
+
+static const AG_PerfHist *
+FindKeyed(const AG_PerfKeyed *kt, const void *key)
+{
+	int i;
+
+	for (i = 0; i < AG_PERF_KEYED_MAX; i++) {
+		if (kt->ents[i] != NULL && kt->ents[i]->key == key)
+			return (kt->ents[i]);
+	}
+	return (NULL);
+}
+
+/*
+ * Check that a forgotten key does not retain its entry (as when the address
+ * of a destroyed window is reused), and that transient keys do not fill
+ * the table or break the probe sequences of the remaining entries.
+ */
+static int
+TestForget(void *obj)
+{
+	static Uint8 keys[128][16];
+	static const int key = 0;
+	const AG_PerfKeyed *kt = &agPerf.keyed[AG_PERF_BY_WINDOW];
+	const AG_PerfHist *h;
+	Uint nDropped = kt->nDropped;
+	int i, cycle;
+
+	AG_PerfKeyedAdd(AG_PERF_BY_WINDOW, &key, "perf-old", 1000);
+	AG_PerfKeyedAdd(AG_PERF_BY_WINDOW, &key, "perf-old", 1000);
+	AG_PerfForget(AG_PERF_BY_WINDOW, &key);
+	if (FindKeyed(kt, &key) != NULL) {
+		TestMsgS(obj, "Forgotten key still in table");
+		return (-1);
+	}
+	AG_PerfKeyedAdd(AG_PERF_BY_WINDOW, &key, "perf-new", 2000);
+	if ((h = FindKeyed(kt, &key)) == NULL || h->n != 1 ||
+	    h->tSum != 2000 || strcmp(h->name, "perf-new") != 0) {
+		TestMsgS(obj, "Reused key inherited the old entry");
+		return (-1);
+	}
+	AG_PerfForget(AG_PERF_BY_WINDOW, &key);
+
+	for (cycle = 0; cycle < 4; cycle++) {
+		for (i = 0; i < 128; i++) {
+			AG_PerfKeyedAdd(AG_PERF_BY_WINDOW, keys[i],
+			    "perf-transient", (Uint64)i);
+		}
+		for (i = 0; i < 128; i += 2) {
+			AG_PerfForget(AG_PERF_BY_WINDOW, keys[i]);
+		}
+		for (i = 0; i < 128; i++) {
+			h = FindKeyed(kt, keys[i]);
+			if ((i & 1) == 0 && h != NULL) {
+				TestMsg(obj, "Key %d not forgotten", i);
+				return (-1);
+			}
+			if ((i & 1) == 1 && (h == NULL || h->n != 1 ||
+			    h->tSum != (Uint64)i)) {
+				TestMsg(obj, "Key %d lost after removals", i);
+				return (-1);
+			}
+		}
+		for (i = 1; i < 128; i += 2)
+			AG_PerfForget(AG_PERF_BY_WINDOW, keys[i]);
+	}
+	if (kt->nDropped != nDropped) {
+		TestMsg(obj, "%u samples dropped",
+		    (Uint)(kt->nDropped - nDropped));
+		return (-1);
+	}
+	return (0);
+}
+
+static int
+TestKeyed(void *obj)
+{
+	static const int key = 0;
+	const AG_PerfHist *h;
+	Uint64 t0;
+	int i;
+
+	if (TestForget(obj) == -1) {
+		return (-1);
+	}
+	if (!agPerf.enabled) {
+		TestMsgS(obj, "AG_Perf is disabled; skipping keyed test");
+		return (0);
+	}
+	for (i = 0; i < 3; i++) {
+		t0 = AG_PerfBegin();
+		AG_PerfEndKeyed(AG_PERF_BY_WINDOW, &key, "perf-test", t0);
+	}
+	h = FindKeyed(&agPerf.keyed[AG_PERF_BY_WINDOW], &key);
+	if (h == NULL || h->n < 3 || strcmp(h->name, "perf-test") != 0) {
+		TestMsgS(obj, "Keyed histogram not found");
+		return (-1);
+	}
+	return (0);
+}
+
+static int
+Test(void *obj)
+{
+	char *s;
+
+	if (TestHist(obj) == -1 ||
+	    TestKeyed(obj) == -1) {
+		return (-1);
+	}
+	if ((s = AG_PerfExportJSON()) == NULL) {
+		TestMsg(obj, "AG_PerfExportJSON: %s", AG_GetError());
+		return (-1);
+	}
+	if (strstr(s, "\"counters\"") == NULL ||
+	    strstr(s, "\"perf-test\"") == NULL) {
+		TestMsgS(obj, "Unexpected JSON output");
+		Free(s);
+		return (-1);
+	}
+	TestMsg(obj, "JSON export OK (%lu bytes)", (Ulong)strlen(s));
+	Free(s);
+	return (0);
+}
+
+#if defined(AG_TIMERS) && defined(AG_ENABLE_STRING)
+static void
+OpenPerfMonitor(AG_Event *event)
+{
+	AG_Window *win;
+
+	if ((win = AG_DEV_PerfMonitor()) != NULL)
+		AG_WindowShow(win);
+}
+
+static int
+TestGUI(void *obj, AG_Window *win)
+{
+	AG_ButtonNewFn(win, 0, "Open Performance Monitor", OpenPerfMonitor,
+	    NULL);
+	return (0);
+}
+#endif /* AG_TIMERS and AG_ENABLE_STRING */
+
+const AG_TestCase perfTest = {
+	AGSI_IDEOGRAM AGSI_EMPTY_HOURGLASS AGSI_RST,
+	"perf",
+	N_("Test the AG_Perf(3) counters and histograms"),
+	"1.7.0",
+	0,
+	sizeof(AG_TestInstance),
+	NULL,		/* init */
+	NULL,		/* destroy */
+	Test,
+#if defined(AG_TIMERS) && defined(AG_ENABLE_STRING)
+	TestGUI,
+#else
+	NULL,		/* testGUI */
+#endif
+	NULL		/* bench */
+};
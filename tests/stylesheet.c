@@ -0,0 +1,182 @@
+/*	Public domain	*/
+/*
+ * Test and benchmark the style compiler of AG_StyleSheet(3): the compiled
+ * class/key index and the cache of computed styles shared by identical
+ * widgets.
+ */
+
+#include "agartest.h"
+
+#include <string.h>
+
+#define NBOXES   50			/* Boxes in benchmark window */
+#define NBUTTONS 40			/* Buttons per box */
+
+typedef struct {
+	AG_TestInstance _inherit;
+	AG_Window *_Nullable win;	/* Benchmark window */
+} MyTestInstance;
+
+static int
+Init(void *obj)
+{
+	MyTestInstance *ti = obj;
+
+	ti->win = NULL;
+	return (0);
+}
+
+static void
+Destroy(void *obj)
+{
+	MyTestInstance *ti = obj;
+
+	if (ti->win != NULL)
+		AG_ObjectDetach(ti->win);
+}
+
+/* Create a window with NBOXES boxes of NBUTTONS buttons and labels. */
+static AG_Window *
+CreateWindow(void)
+{
+	AG_Window *win;
+	int i, j;
+
+	if ((win = AG_WindowNew(0)) == NULL) {
+		return (NULL);
+	}
+	for (i = 0; i < NBOXES; i++) {
+		AG_Box *box = AG_BoxNewHoriz(win, AG_BOX_HFILL);
+
+		for (j = 0; j < NBUTTONS; j++) {
+			AG_ButtonNewS(box, 0, "Button");
+			AG_LabelNewS(box, 0, "Label");
+		}
+	}
+	return (win);
+}
+
+static int
+Test(void *obj)
+{
+	AG_StyleSheet *css = &agDefaultCSS;
+	AG_Window *win;
+	AG_Box *box;
+	AG_Button *btn[3];
+	AG_Label *lbl;
+	char *s;
+	int rv = -1;
+
+	if ((win = CreateWindow()) == NULL) {
+		TestMsg(obj, "AG_WindowNew: %s", AG_GetError());
+		return (-1);
+	}
+	box = AG_BoxNewHoriz(win, AG_BOX_HFILL);
+	btn[0] = AG_ButtonNewS(box, 0, "Plain");
+	btn[1] = AG_ButtonNewS(box, 0, "Spacing");
+	btn[2] = AG_ButtonNewS(box, 0, "Red");
+	lbl = AG_LabelNewS(box, 0, "Label");
+	AG_SetStyle(btn[1], "spacing", "0");     /* Uncached, same palette */
+	AG_SetStyle(btn[2], "color", "#f00");
+
+	AG_StyleSheetClearComputed(css);
+	AG_WidgetCompileStyle(win);
+
+	/* Window, box, button and label for each distinct parent style. */
+	if (css->nComputed == 0 || css->nComputed > 16) {
+		TestMsg(obj, "%u computed styles cached", css->nComputed);
+		goto out;
+	}
+	if (memcmp(&AGWIDGET(btn[0])->pal, &AGWIDGET(btn[1])->pal,
+	    sizeof(AG_WidgetPalette)) != 0) {
+		TestMsgS(obj, "Cached and compiled palettes differ");
+		goto out;
+	}
+	if (AG_ColorCompare(&AGWIDGET(btn[2])->pal.c[0][AG_FG_COLOR],
+	    &AGWIDGET(btn[0])->pal.c[0][AG_FG_COLOR]) == 0 ||
+	    AGWIDGET(btn[2])->pal.c[0][AG_FG_COLOR].r != AG_COLOR_LAST) {
+		TestMsgS(obj, "Per-instance color not applied");
+		goto out;
+	}
+	if (AGWIDGET(btn[0])->paddingTop != 5 ||
+	    AGWIDGET(btn[0])->paddingLeft != 10 ||
+	    AGWIDGET(lbl)->paddingLeft != 6) {
+		TestMsg(obj, "Bad padding (%d,%d)", AGWIDGET(btn[0])->paddingTop,
+		    AGWIDGET(btn[0])->paddingLeft);
+		goto out;
+	}
+
+	/* Class index: exact name, case-insensitive key, missing key. */
+	if (!AG_LookupStyleSheet(css, btn[0], "PADDING", &s) ||
+	    strcmp(s, "5 10 5 10") != 0 ||
+	    !AG_LookupStyleSheet(css, btn[0], "color#hover", &s) ||
+	    AG_LookupStyleSheet(css, btn[0], "no-such-key", &s) ||
+	    AG_LookupStyleSheet(css, btn[0], "spacing", &s)) {
+		TestMsgS(obj, "Bad stylesheet lookup");
+		goto out;
+	}
+	TestMsg(obj, "%u computed styles, %u classes indexed", css->nComputed,
+	    css->nClasses);
+	rv = 0;
+out:
+	AG_ObjectDetach(win);
+	return (rv);
+}
+
+static void
+CompileCached(void *obj)
+{
+	MyTestInstance *ti = obj;
+
+	AG_WidgetCompileStyle(ti->win);
+}
+
+static void
+CompileUncached(void *obj)
+{
+	MyTestInstance *ti = obj;
+
+	AG_StyleSheetClearComputed(&agDefaultCSS);
+	AG_WidgetCompileStyle(ti->win);
+}
+
+static struct ag_benchmark_fn styleBenchFns[] = {
+	{ "Compile (cached)", CompileCached },
+	{ "Compile (uncached)", CompileUncached },
+};
+static struct ag_benchmark styleBench = {
+	"AG_StyleSheet",
+	&styleBenchFns[0],
+	sizeof(styleBenchFns) / sizeof(styleBenchFns[0]),
+	4, 10, 0
+};
+
+static int
+Bench(void *obj)
+{
+	MyTestInstance *ti = obj;
+
+	if ((ti->win = CreateWindow()) == NULL) {
+		return (-1);
+	}
+	TestMsg(obj, "Compiling styles of %d widgets:",
+	    NBOXES*(2*NBUTTONS + 1) + 1);
+	TestExecBenchmark(obj, &styleBench);
+	AG_ObjectDetach(ti->win);
+	ti->win = NULL;
+	return (0);
+}
+
+const AG_TestCase stylesheetTest = {
+	AGSI_IDEOGRAM AGSI_ARTISTS_PALETTE AGSI_RST,
+	"stylesheet",
+	N_("Test the AG_StyleSheet(3) style compiler"),
+	"1.7.0",
+	0,
+	sizeof(MyTestInstance),
+	Init,
+	Destroy,
+	Test,
+	NULL,		/* testGUI */
+	Bench
+};
@@ -0,0 +1,559 @@
+/*	Public domain	*/
+/*
+ * Test and benchmark the packed 32-bit pixel kernels used by AG_FillRect(),
+ * AG_SurfaceCopy() and AG_SurfaceBlit(), and the filters and cache of
+ * AG_SurfaceScale() (see AG_Surface(3)).
+ */
+
+#include "agartest.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NPIXELS    (1024*1024)		/* Pixels per benchmark run */
+#define NRUNS      20			/* Benchmark runs per kernel */
+#define NSCALERUNS 5			/* Benchmark runs per scale filter */
+
+static const char *kernelNames[] = { "scalar", "sse2", "avx2" };
+static const int nKernelNames = sizeof(kernelNames) / sizeof(kernelNames[0]);
+
+static const struct {
+	const char *name;
+	Uint filter;
+} scaleFilters[] = {
+	{ "nearest",  AG_SCALE_NEAREST },
+	{ "box",      AG_SCALE_BOX },
+	{ "bilinear", AG_SCALE_BILINEAR },
+	{ "lanczos3", AG_SCALE_LANCZOS3 },
+};
+static const int nScaleFilters = sizeof(scaleFilters) /
+                                 sizeof(scaleFilters[0]);
+
+static Uint32 rngState = 0x12345678;
+
+static Uint32
+Random32(void)
+{
+	rngState ^= rngState << 13;
+	rngState ^= rngState >> 17;
+	rngState ^= rngState << 5;
+	return (rngState);
+}
+
+static void
+RandomPixels(Uint32 *buf, Uint n)
+{
+	Uint i;
+
+	for (i = 0; i < n; i++) {
+		buf[i] = Random32();
+		if ((i & 7) == 0) {
+			buf[i] |= 0xff000000;		/* Some opaque */
+		} else if ((i & 7) == 1) {
+			buf[i] &= 0x00ffffff;		/* Some transparent */
+		}
+	}
+}
+
+/* Compare the kernels of K against the portable ones on random data. */
+static int
+CompareKernels(void *obj, const AG_SurfaceKernels *K,
+    const AG_SurfaceKernels *R)
+{
+	static const Sint8 maps[][4] = {
+		{ 2, 1, 0, 3 },				/* RGBA <-> BGRA */
+		{ 1, 2, 3, 0 },				/* ARGB -> RGBA */
+		{ 0, 1, 2, -1 },			/* RGBA -> RGBX */
+	};
+	const Uint nMax = 300;
+	Uint32 *src, *d1, *d2;
+	Uint n, off, i;
+	int aByte, rv = -1;
+
+	src = Malloc(nMax * sizeof(Uint32));
+	d1 = Malloc(nMax * sizeof(Uint32));
+	d2 = Malloc(nMax * sizeof(Uint32));
+
+	for (n = 0; n < nMax - 3; n += 7) {
+		for (off = 0; off < 3; off++) {
+			RandomPixels(src, nMax);
+			RandomPixels(d1, nMax);
+			memcpy(d2, d1, nMax * sizeof(Uint32));
+
+			K->fill32(&d1[off], n, src[0]);
+			R->fill32(&d2[off], n, src[0]);
+			if (memcmp(d1, d2, nMax*sizeof(Uint32)) != 0) {
+				TestMsg(obj, "%s: fill32 differs (n=%u)",
+				    K->name, n);
+				goto out;
+			}
+			K->copy32(&d1[off], &src[1], n);
+			R->copy32(&d2[off], &src[1], n);
+			if (memcmp(d1, d2, nMax*sizeof(Uint32)) != 0) {
+				TestMsg(obj, "%s: copy32 differs (n=%u)",
+				    K->name, n);
+				goto out;
+			}
+			src[off+5] = src[off+2] = 0x11223344;
+			K->colorkey32(&d1[off], &src[off], n, 0x11223344);
+			R->colorkey32(&d2[off], &src[off], n, 0x11223344);
+			if (memcmp(d1, d2, nMax*sizeof(Uint32)) != 0) {
+				TestMsg(obj, "%s: colorkey32 differs (n=%u)",
+				    K->name, n);
+				goto out;
+			}
+			for (i = 0; i < sizeof(maps)/sizeof(maps[0]); i++) {
+				K->convert32(&d1[off], &src[1], n, maps[i],
+				    0xff000000 * (maps[i][3] == -1));
+				R->convert32(&d2[off], &src[1], n, maps[i],
+				    0xff000000 * (maps[i][3] == -1));
+				if (memcmp(d1, d2, nMax*sizeof(Uint32)) != 0) {
+					TestMsg(obj, "%s: convert32 differs "
+					             "(n=%u, map=%u)",
+					    K->name, n, i);
+					goto out;
+				}
+			}
+			for (aByte = 0; aByte < 4; aByte++) {
+				const Uint8 aMax = (n & 1) ? 0xff : (Uint8)n;
+
+				K->blend32(&d1[off], &src[2], n, aByte, aMax);
+				R->blend32(&d2[off], &src[2], n, aByte, aMax);
+				if (memcmp(d1, d2, nMax*sizeof(Uint32)) != 0) {
+					TestMsg(obj, "%s: blend32 differs "
+					             "(n=%u, aByte=%d)",
+					    K->name, n, aByte);
+					goto out;
+				}
+			}
+		}
+	}
+	rv = 0;
+out:
+	Free(src);
+	Free(d1);
+	Free(d2);
+	return (rv);
+}
+
+/* Check the portable blend against the exact result. */
+static int
+CheckBlend(void *obj, const AG_SurfaceKernels *R)
+{
+	Uint32 s, d;
+	Uint a, c;
+
+	for (a = 0; a < 256; a += 5) {
+		for (c = 0; c < 256; c += 3) {
+			const Uint dc = 255 - c;
+			const double exact = (double)dc +
+			    ((double)c - (double)dc) * (double)a / 255.0;
+			const Uint da = 100;
+			Uint rv;
+
+			s = c | (a << 24);
+			d = dc | (da << 24);
+			R->blend32(&d, &s, 1, 3, 0xff);
+			rv = d & 0xff;
+			if ((double)rv < exact - 0.5001 ||
+			    (double)rv > exact + 0.5001) {
+				TestMsg(obj, "blend(%u,%u,%u) = %u (expected "
+				             "%.2f)", c, dc, a, rv, exact);
+				return (-1);
+			}
+			if ((d >> 24) != AG_MIN(da + a, 255)) {
+				TestMsg(obj, "blend alpha %u (expected %u)",
+				    d >> 24, AG_MIN(da + a, 255));
+				return (-1);
+			}
+		}
+	}
+	return (0);
+}
+
+/* Test the surface operations which use the kernels. */
+static int
+CheckSurfaces(void *obj)
+{
+	AG_Surface *S, *D, *B;
+	AG_Color c, cOut;
+	AG_Rect r;
+	int x, y, rv = -1;
+
+	/* Map/extract round trip. */
+	S = AG_SurfaceRGBA(16, 16, 32, 0,
+	    0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+	AG_ColorRGBA_8(&c, 200, 100, 50, 128);
+	if (AG_MapPixel32(&S->format, &c) != 0x803264c8) {
+		TestMsg(obj, "AG_MapPixel32() = %x",
+		    (Uint)AG_MapPixel32(&S->format, &c));
+		goto out_S;
+	}
+
+	/* Fill a rectangle overlapping the left and top edges. */
+	AG_ColorRGBA_8(&c, 0, 0, 0, 0);
+	AG_FillRect(S, NULL, &c);
+	AG_ColorRGBA_8(&c, 255, 0, 0, 255);
+	r.x = -4;
+	r.y = -4;
+	r.w = 10;
+	r.h = 8;
+	AG_FillRect(S, &r, &c);
+	for (y = 0; y < S->h; y++) {
+		for (x = 0; x < S->w; x++) {
+			const Uint32 px = AG_SurfaceGet32(S, x,y);
+			const Uint32 pxExp = (x < 6 && y < 4) ? 0xff0000ff : 0;
+
+			if (px != pxExp) {
+				TestMsg(obj, "AG_FillRect: %x at %d,%d", px,
+				    x, y);
+				goto out_S;
+			}
+		}
+	}
+
+	/* Convert RGBA to BGRA and back. */
+	for (y = 0; y < S->h; y++) {
+		for (x = 0; x < S->w; x++)
+			AG_SurfacePut32(S, x,y, Random32());
+	}
+	D = AG_SurfaceRGBA(16, 16, 32, 0,
+	    0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+	AG_SurfaceCopy(D, S);
+	B = AG_SurfaceConvert(D, &S->format);
+	if (memcmp(B->pixels, S->pixels, S->h * S->pitch) != 0) {
+		TestMsgS(obj, "RGBA -> BGRA -> RGBA conversion differs");
+		goto out_B;
+	}
+	AG_GetColor32(&cOut, AG_SurfaceGet32(D, 3,3), &D->format);
+	AG_GetColor32(&c, AG_SurfaceGet32(S, 3,3), &S->format);
+	if (AG_ColorCompare(&c, &cOut) != 0) {
+		TestMsgS(obj, "BGRA pixel differs");
+		goto out_B;
+	}
+
+	/* Blend a half-transparent BGRA surface over an opaque RGBA one. */
+	AG_ColorRGBA_8(&c, 0, 0, 255, 255);
+	AG_FillRect(B, NULL, &c);
+	AG_ColorRGBA_8(&c, 255, 0, 0, 128);
+	AG_FillRect(D, NULL, &c);
+	AG_SurfaceBlit(D, NULL, B, 8, 8);
+	AG_GetColor32(&cOut, AG_SurfaceGet32(B, 10,10), &B->format);
+	if (AG_Hto8(cOut.r) != 128 || AG_Hto8(cOut.g) != 0 ||
+	    AG_Hto8(cOut.b) != 127 || AG_Hto8(cOut.a) != 255) {
+		TestMsg(obj, "AG_SurfaceBlit: [%u,%u,%u,%u]",
+		    AG_Hto8(cOut.r), AG_Hto8(cOut.g), AG_Hto8(cOut.b),
+		    AG_Hto8(cOut.a));
+		goto out_B;
+	}
+	if (AG_SurfaceGet32(B, 7,7) != AG_SurfaceGet32(B, 0,0)) {
+		TestMsgS(obj, "AG_SurfaceBlit: wrote outside of target");
+		goto out_B;
+	}
+	rv = 0;
+out_B:
+	AG_SurfaceFree(B);
+	AG_SurfaceFree(D);
+out_S:
+	AG_SurfaceFree(S);
+	return (rv);
+}
+
+/* Return 0 if every pixel of S is within tol of color c (8-bit). */
+static int
+CheckUniform(const AG_Surface *S, const AG_Color *c, int tol)
+{
+	AG_Color cOut;
+	int x, y;
+
+	for (y = 0; y < S->h; y++) {
+		for (x = 0; x < S->w; x++) {
+			AG_GetColor32(&cOut, AG_SurfaceGet32(S, x,y), &S->format);
+			if (abs(AG_Hto8(cOut.r) - AG_Hto8(c->r)) > tol ||
+			    abs(AG_Hto8(cOut.g) - AG_Hto8(c->g)) > tol ||
+			    abs(AG_Hto8(cOut.b) - AG_Hto8(c->b)) > tol ||
+			    abs(AG_Hto8(cOut.a) - AG_Hto8(c->a)) > tol)
+				return (-1);
+		}
+	}
+	return (0);
+}
+
+static int
+CheckScale(void *obj)
+{
+	static const Uint sizes[][2] = { { 17,13 }, { 150,100 }, { 1,1 } };
+	AG_Surface *S, *D, *D2;
+	AG_Color c;
+	Uint nEnts, nHits;
+	int i, j, x, y;
+
+	/* A uniform surface must scale to the same color with any filter. */
+	S = AG_SurfaceRGBA(64, 48, 32, 0,
+	    0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+	AG_ColorRGBA_8(&c, 200, 100, 50, 160);
+	AG_FillRect(S, NULL, &c);
+	for (i = 0; i < nScaleFilters; i++) {
+		for (j = 0; j < 3; j++) {
+			D = AG_SurfaceScale(S, sizes[j][0], sizes[j][1],
+			    scaleFilters[i].filter);
+			if (D->w != sizes[j][0] || D->h != sizes[j][1] ||
+			    CheckUniform(D, &c, 1) != 0) {
+				TestMsg(obj, "%s: %ux%u not uniform",
+				    scaleFilters[i].name, sizes[j][0],
+				    sizes[j][1]);
+				AG_SurfaceFree(D);
+				goto out_S;
+			}
+			AG_SurfaceFree(D);
+		}
+	}
+
+	/* A 2:1 box reduction of a checkerboard averages to gray. */
+	for (y = 0; y < S->h; y++) {
+		for (x = 0; x < S->w; x++)
+			AG_SurfacePut32(S, x,y, ((x+y) & 1) ? 0xffffffff :
+			                                      0xff000000);
+	}
+	D = AG_SurfaceScale(S, S->w >> 1, S->h >> 1, AG_SCALE_BOX);
+	AG_ColorRGBA_8(&c, 128, 128, 128, 255);
+	if (CheckUniform(D, &c, 1) != 0) {
+		TestMsgS(obj, "box: checkerboard does not average to gray");
+		AG_SurfaceFree(D);
+		goto out_S;
+	}
+	AG_SurfaceFree(D);
+
+	/* Threaded and single-threaded results must be identical. */
+	AG_SurfaceFree(S);
+	S = AG_SurfaceRGBA(600, 400, 32, 0,
+	    0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+	RandomPixels((Uint32 *)S->pixels, S->w * S->h);
+	for (i = 1; i < nScaleFilters; i++) {
+		D = AG_SurfaceScale(S, 350, 500, scaleFilters[i].filter);
+		D2 = AG_SurfaceScale(S, 350, 500, scaleFilters[i].filter |
+		                                  AG_SCALE_NO_THREADS);
+		j = memcmp(D->pixels, D2->pixels, D->h * D->pitch);
+		AG_SurfaceFree(D2);
+		AG_SurfaceFree(D);
+		if (j != 0) {
+			TestMsg(obj, "%s: threaded result differs",
+			    scaleFilters[i].name);
+			goto out_S;
+		}
+	}
+
+	/* Cache hit, invalidation and cleanup by AG_SurfaceFree(). */
+	AG_SurfaceScaleCacheClear();
+	D = AG_SurfaceScale(S, 32, 32, AG_SCALE_BILINEAR | AG_SCALE_CACHE);
+	D2 = AG_SurfaceScale(S, 32, 32, AG_SCALE_BILINEAR | AG_SCALE_CACHE);
+	AG_SurfaceScaleCacheStats(&nEnts, NULL, &nHits, NULL);
+	j = memcmp(D->pixels, D2->pixels, D->h * D->pitch);
+	AG_SurfaceFree(D2);
+	AG_SurfaceFree(D);
+	if (nEnts != 1 || nHits != 1 || j != 0) {
+		TestMsg(obj, "Scale cache: %u entries, %u hits", nEnts, nHits);
+		goto out_S;
+	}
+	AG_SurfaceScaleCacheInvalidate(S);
+	AG_SurfaceScaleCacheStats(&nEnts, NULL, NULL, NULL);
+	if (nEnts != 0) {
+		TestMsgS(obj, "Scale cache: invalidation failed");
+		goto out_S;
+	}
+	D = AG_SurfaceScale(S, 16, 16, AG_SCALE_BOX | AG_SCALE_CACHE);
+	AG_SurfaceFree(D);
+	AG_SurfaceFree(S);
+	AG_SurfaceScaleCacheStats(&nEnts, NULL, NULL, NULL);
+	if (nEnts != 0) {
+		TestMsgS(obj, "Scale cache: entry outlived its source");
+		return (-1);
+	}
+	return (0);
+out_S:
+	AG_SurfaceFree(S);
+	return (-1);
+}
+
+static int
+Test(void *obj)
+{
+	const AG_SurfaceKernels *R, *K;
+	int i;
+
+	if ((R = AG_SurfaceGetKernels("scalar")) == NULL) {
+		TestMsgS(obj, "No scalar kernels");
+		return (-1);
+	}
+	if (CheckBlend(obj, R) == -1) {
+		return (-1);
+	}
+	for (i = 1; i < nKernelNames; i++) {
+		if ((K = AG_SurfaceGetKernels(kernelNames[i])) == NULL) {
+			TestMsg(obj, "%s: unavailable", kernelNames[i]);
+			continue;
+		}
+		if (CompareKernels(obj, K, R) == -1)
+			return (-1);
+
+		TestMsg(obj, "%s: OK", K->name);
+	}
+	if (CheckSurfaces(obj) == -1 ||
+	    CheckScale(obj) == -1) {
+		return (-1);
+	}
+	TestMsg(obj, "Using %s kernels", agSurfaceKernels->name);
+	return (0);
+}
+
+/*
+ * Report the throughput of a kernel in GB/s, counting the bytes read and
+ * written per pixel (nStreams * 4).
+ */
+static void
+ReportRate(void *obj, const char *set, const char *name, Uint64 t, int nStreams)
+{
+	const double bytes = (double)NPIXELS * 4.0 * nStreams * NRUNS;
+
+	TestMsg(obj, "%-8s %-14s %7.2f GB/s", set, name,
+	    (t > 0) ? bytes / (double)t : 0.0);
+}
+
+static void
+BenchKernels(void *obj, const AG_SurfaceKernels *K, Uint32 *src, Uint32 *dst)
+{
+	static const Sint8 map[4] = { 2, 1, 0, 3 };
+	Uint64 t0;
+	int i;
+
+	t0 = AG_PerfTime();
+	for (i = 0; i < NRUNS; i++) { K->fill32(dst, NPIXELS, 0x11223344); }
+	ReportRate(obj, K->name, "fill32", AG_PerfTime() - t0, 1);
+
+	t0 = AG_PerfTime();
+	for (i = 0; i < NRUNS; i++) { K->copy32(dst, src, NPIXELS); }
+	ReportRate(obj, K->name, "copy32", AG_PerfTime() - t0, 2);
+
+	t0 = AG_PerfTime();
+	for (i = 0; i < NRUNS; i++) { K->blend32(dst, src, NPIXELS, 3, 0xff); }
+	ReportRate(obj, K->name, "blend32", AG_PerfTime() - t0, 3);
+
+	t0 = AG_PerfTime();
+	for (i = 0; i < NRUNS; i++) { K->colorkey32(dst, src, NPIXELS, 0); }
+	ReportRate(obj, K->name, "colorkey32", AG_PerfTime() - t0, 3);
+
+	t0 = AG_PerfTime();
+	for (i = 0; i < NRUNS; i++) { K->convert32(dst, src, NPIXELS, map, 0); }
+	ReportRate(obj, K->name, "convert32", AG_PerfTime() - t0, 2);
+}
+
+static void
+BenchSurfaces(void *obj)
+{
+	AG_Surface *S, *D, *B;
+	AG_Color c;
+	Uint64 t0;
+	int i;
+
+	S = AG_SurfaceRGBA(1024, 1024, 32, 0,
+	    0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+	D = AG_SurfaceRGBA(1024, 1024, 32, 0,
+	    0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+	RandomPixels((Uint32 *)S->pixels, NPIXELS);
+	AG_ColorRGBA_8(&c, 10, 20, 30, 255);
+
+	t0 = AG_PerfTime();
+	for (i = 0; i < NRUNS; i++) { AG_FillRect(D, NULL, &c); }
+	ReportRate(obj, "surface", "FillRect", AG_PerfTime() - t0, 1);
+
+	t0 = AG_PerfTime();
+	for (i = 0; i < NRUNS; i++) { AG_SurfaceCopy(D, S); }
+	ReportRate(obj, "surface", "Copy (convert)", AG_PerfTime() - t0, 2);
+
+	t0 = AG_PerfTime();
+	for (i = 0; i < NRUNS; i++) { AG_SurfaceBlit(S, NULL, D, 0,0); }
+	ReportRate(obj, "surface", "Blit (blend)", AG_PerfTime() - t0, 3);
+
+	t0 = AG_PerfTime();
+	for (i = 0; i < NRUNS; i++) {
+		B = AG_SurfaceConvert(S, &D->format);
+		AG_SurfaceFree(B);
+	}
+	ReportRate(obj, "surface", "Convert", AG_PerfTime() - t0, 2);
+
+	AG_SurfaceFree(D);
+	AG_SurfaceFree(S);
+}
+
+/* Report the time taken to scale S to w x h with each filter. */
+static void
+BenchScale(void *obj, const AG_Surface *S, Uint w, Uint h, Uint flags)
+{
+	AG_Surface *D;
+	Uint64 t0, t;
+	int i, j;
+
+	for (i = 0; i < nScaleFilters; i++) {
+		t0 = AG_PerfTime();
+		for (j = 0; j < NSCALERUNS; j++) {
+			D = AG_SurfaceScale(S, w,h, scaleFilters[i].filter |
+			                            flags);
+			AG_SurfaceFree(D);
+		}
+		t = (AG_PerfTime() - t0) / NSCALERUNS;
+		TestMsg(obj, "%4ux%-4u -> %4ux%-4u %-8s %-7s %8.2f ms",
+		    S->w, S->h, w, h, scaleFilters[i].name,
+		    (flags & AG_SCALE_NO_THREADS) ? "1 thr" : "threads",
+		    (double)t / 1e6);
+	}
+}
+
+static int
+Bench(void *obj)
+{
+	const AG_SurfaceKernels *K;
+	AG_Surface *S;
+	Uint32 *src, *dst;
+	int i;
+
+	src = Malloc(NPIXELS * sizeof(Uint32));
+	dst = Malloc(NPIXELS * sizeof(Uint32));
+	RandomPixels(src, NPIXELS);
+	RandomPixels(dst, NPIXELS);
+
+	TestMsg(obj, "Throughput over %d runs of %d pixels (bytes read and "
+	             "written):", NRUNS, NPIXELS);
+	for (i = 0; i < nKernelNames; i++) {
+		if ((K = AG_SurfaceGetKernels(kernelNames[i])) != NULL)
+			BenchKernels(obj, K, src, dst);
+	}
+	BenchSurfaces(obj);
+
+	S = AG_SurfaceRGBA(1024, 1024, 32, 0,
+	    0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+	RandomPixels((Uint32 *)S->pixels, NPIXELS);
+	TestMsg(obj, "AG_SurfaceScale() (average of %d runs):", NSCALERUNS);
+	BenchScale(obj, S, 640, 480, AG_SCALE_NO_THREADS);
+	BenchScale(obj, S, 640, 480, 0);
+	BenchScale(obj, S, 2048, 1536, AG_SCALE_NO_THREADS);
+	BenchScale(obj, S, 2048, 1536, 0);
+	AG_SurfaceFree(S);
+
+	Free(src);
+	Free(dst);
+	return (0);
+}
+
+const AG_TestCase surfaceTest = {
+	AGSI_IDEOGRAM AGSI_ARTISTS_PALETTE AGSI_RST,
+	"surface",
+	N_("Test and benchmark the AG_Surface(3) pixel kernels and scaler"),
+	"1.7.0",
+	0,
+	sizeof(AG_TestInstance),
+	NULL,		/* init */
+	NULL,		/* destroy */
+	Test,
+	NULL,		/* testGUI */
+	Bench
+};
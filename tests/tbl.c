@@ -0,0 +1,280 @@
+/*	Public domain	*/
+/*
+ * Test and benchmark the AG_Tbl(3) hash table, comparing the default
+ * (chained, fixed bucket count) table against AG_TBL_OPENADDR.
+ */
+
+#include "agartest.h"
+
+#define NSIZES 4			/* 1e3, 1e4, 1e5, 1e6 keys */
+#define NKEYS_MAX 1000000
+#define CHAINED_FIXED_BUCKETS 1024	/* Fixed-size chained table */
+
+enum tbl_kind {
+	TBL_CHAINED_FIXED,		/* Chained, 1024 buckets */
+	TBL_CHAINED_SIZED,		/* Chained, one bucket per key */
+	TBL_OPENADDR,			/* Open addressing (auto-resizing) */
+	TBL_LAST
+};
+
+typedef struct {
+	AG_TestInstance _inherit;
+	char *_Nullable keyBuf;		/* Key strings */
+	char *_Nullable *_Nullable keys;
+	AG_Tbl *_Nullable tbl[TBL_LAST]; /* Tables for the current size */
+	Uint nKeys;			/* Current benchmark size */
+	Uint nFound;
+} MyTestInstance;
+
+static const Uint benchSizes[NSIZES] = { 1000, 10000, 100000, 1000000 };
+
+static int
+Init(void *obj)
+{
+	MyTestInstance *ti = obj;
+	int i;
+
+	ti->keyBuf = NULL;
+	ti->keys = NULL;
+	for (i = 0; i < TBL_LAST; i++) {
+		ti->tbl[i] = NULL;
+	}
+	ti->nKeys = 0;
+	ti->nFound = 0;
+	return (0);
+}
+
+static void
+Destroy(void *obj)
+{
+	MyTestInstance *ti = obj;
+
+	Free(ti->keys);
+	Free(ti->keyBuf);
+}
+
+static AG_Tbl *
+NewTable(enum tbl_kind kind, Uint nKeys)
+{
+	switch (kind) {
+	case TBL_CHAINED_FIXED:
+		return AG_TblNew(CHAINED_FIXED_BUCKETS, 0);
+	case TBL_CHAINED_SIZED:
+		return AG_TblNew(nKeys, 0);
+	default:
+		return AG_TblNew(8, AG_TBL_OPENADDR);
+	}
+}
+
+static void
+FreeTable(AG_Tbl *tbl)
+{
+	AG_TblDestroy(tbl);
+	Free(tbl);
+}
+
+/* Check basic operations on a table of nKeys entries. */
+static int
+TestTable(MyTestInstance *ti, AG_Tbl *tbl, Uint nKeys)
+{
+	AG_Variable V, *pV;
+	Uint i, j, nEnts = 0;
+
+	for (i = 0; i < nKeys; i++) {
+		AG_InitInt(&V, (int)i);
+		if (AG_TblInsert(tbl, ti->keys[i], &V) == -1) {
+			TestMsg(ti, "Insert(%s): %s", ti->keys[i], AG_GetError());
+			return (-1);
+		}
+	}
+	if (AG_TblInsert(tbl, ti->keys[0], &V) == 0) {
+		TestMsgS(ti, "Insert of duplicate key succeeded");
+		return (-1);
+	}
+	for (i = 0; i < nKeys; i += 2) {
+		if (AG_TblDelete(tbl, ti->keys[i]) == -1) {
+			TestMsg(ti, "Delete(%s): %s", ti->keys[i], AG_GetError());
+			return (-1);
+		}
+	}
+	for (i = 0; i < nKeys; i++) {
+		pV = AG_TblLookup(tbl, ti->keys[i]);
+		if ((i & 1) && (pV == NULL || pV->data.i != (int)i)) {
+			TestMsg(ti, "Lookup(%s) failed", ti->keys[i]);
+			return (-1);
+		}
+		if (!(i & 1) && pV != NULL) {
+			TestMsg(ti, "Lookup(%s) found deleted entry", ti->keys[i]);
+			return (-1);
+		}
+	}
+	AG_TBL_FOREACH(pV, i,j, tbl) {
+		nEnts++;
+	}
+	if (nEnts != nKeys/2) {
+		TestMsg(ti, "FOREACH: %u entries (expected %u)", nEnts, nKeys/2);
+		return (-1);
+	}
+	return (0);
+}
+
+static int
+GenKeys(MyTestInstance *ti, Uint nKeys)
+{
+	char *s;
+	Uint i;
+
+	if ((ti->keyBuf = TryMalloc(nKeys*12)) == NULL ||
+	    (ti->keys = TryMalloc(nKeys*sizeof(char *))) == NULL) {
+		return (-1);
+	}
+	for (i = 0, s = ti->keyBuf; i < nKeys; i++, s += 12) {
+		Snprintf(s, 12, "key-%u", i);
+		ti->keys[i] = s;
+	}
+	return (0);
+}
+
+static int
+Test(void *obj)
+{
+	MyTestInstance *ti = obj;
+	int kind;
+
+	if (ti->keys == NULL && GenKeys(ti, NKEYS_MAX) == -1) {
+		return (-1);
+	}
+	for (kind = 0; kind < TBL_LAST; kind++) {
+		AG_Tbl *tbl = NewTable(kind, 10000);
+		int rv;
+
+		rv = TestTable(ti, tbl, 10000);
+		FreeTable(tbl);
+		if (rv != 0) {
+			return (-1);
+		}
+	}
+	TestMsgS(ti, "AG_Tbl tests OK");
+	return (0);
+}
+
+/* Insert all keys into a new table and destroy it. */
+static __inline__ void
+BenchInsert(MyTestInstance *ti, enum tbl_kind kind)
+{
+	AG_Tbl *tbl;
+	AG_Variable V;
+	Uint i;
+
+	tbl = NewTable(kind, ti->nKeys);
+	AG_InitInt(&V, 0);
+	for (i = 0; i < ti->nKeys; i++) {
+		AG_TblInsert(tbl, ti->keys[i], &V);
+	}
+	FreeTable(tbl);
+}
+
+/* Look up all keys in a prebuilt table. */
+static __inline__ void
+BenchLookup(MyTestInstance *ti, enum tbl_kind kind)
+{
+	AG_Tbl *tbl = ti->tbl[kind];
+	Uint i;
+
+	for (i = 0; i < ti->nKeys; i++) {
+		if (AG_TblLookup(tbl, ti->keys[i]) != NULL)
+			ti->nFound++;
+	}
+}
+
+/* Delete all keys from a prebuilt table (and insert them back). */
+static __inline__ void
+BenchDelete(MyTestInstance *ti, enum tbl_kind kind)
+{
+	AG_Tbl *tbl = ti->tbl[kind];
+	AG_Variable V;
+	Uint i;
+
+	for (i = 0; i < ti->nKeys; i++) {
+		AG_TblDelete(tbl, ti->keys[i]);
+	}
+	AG_InitInt(&V, 0);
+	for (i = 0; i < ti->nKeys; i++) {
+		AG_TblInsert(tbl, ti->keys[i], &V);
+	}
+}
+
+static void InsertChainedFixed(void *ti) { BenchInsert(ti, TBL_CHAINED_FIXED); }
+static void InsertChainedSized(void *ti) { BenchInsert(ti, TBL_CHAINED_SIZED); }
+static void InsertOpenAddr(void *ti)     { BenchInsert(ti, TBL_OPENADDR); }
+static void LookupChainedFixed(void *ti) { BenchLookup(ti, TBL_CHAINED_FIXED); }
+static void LookupChainedSized(void *ti) { BenchLookup(ti, TBL_CHAINED_SIZED); }
+static void LookupOpenAddr(void *ti)     { BenchLookup(ti, TBL_OPENADDR); }
+static void DeleteChainedFixed(void *ti) { BenchDelete(ti, TBL_CHAINED_FIXED); }
+static void DeleteChainedSized(void *ti) { BenchDelete(ti, TBL_CHAINED_SIZED); }
+static void DeleteOpenAddr(void *ti)     { BenchDelete(ti, TBL_OPENADDR); }
+
+static struct ag_benchmark_fn tblBenchFns[] = {
+	{ "Insert+Destroy (chained, 1024 buckets)",    InsertChainedFixed },
+	{ "Insert+Destroy (chained, N buckets)",       InsertChainedSized },
+	{ "Insert+Destroy (open addressing)",          InsertOpenAddr },
+	{ "Lookup (chained, 1024 buckets)",            LookupChainedFixed },
+	{ "Lookup (chained, N buckets)",               LookupChainedSized },
+	{ "Lookup (open addressing)",                  LookupOpenAddr },
+	{ "Delete+Reinsert (chained, 1024 buckets)",   DeleteChainedFixed },
+	{ "Delete+Reinsert (chained, N buckets)",      DeleteChainedSized },
+	{ "Delete+Reinsert (open addressing)",         DeleteOpenAddr },
+};
+static struct ag_benchmark tblBench = {
+	"AG_Tbl",
+	&tblBenchFns[0],
+	sizeof(tblBenchFns) / sizeof(tblBenchFns[0]),
+	2, 1, 0
+};
+
+static int
+Bench(void *obj)
+{
+	MyTestInstance *ti = obj;
+	AG_Variable V;
+	Uint i, sz;
+	int kind;
+
+	if (ti->keys == NULL && GenKeys(ti, NKEYS_MAX) == -1) {
+		return (-1);
+	}
+	AG_InitInt(&V, 0);
+
+	for (sz = 0; sz < NSIZES; sz++) {
+		ti->nKeys = benchSizes[sz];
+		for (kind = 0; kind < TBL_LAST; kind++) {
+			ti->tbl[kind] = NewTable(kind, ti->nKeys);
+			for (i = 0; i < ti->nKeys; i++)
+				AG_TblInsert(ti->tbl[kind], ti->keys[i], &V);
+		}
+		TestMsg(ti, "%u keys (clks per %u operations):", ti->nKeys,
+		    ti->nKeys);
+		TestExecBenchmark(obj, &tblBench);
+
+		for (kind = 0; kind < TBL_LAST; kind++) {
+			FreeTable(ti->tbl[kind]);
+			ti->tbl[kind] = NULL;
+		}
+	}
+	TestMsg(ti, "Found %u entries", ti->nFound);
+	return (0);
+}
+
+const AG_TestCase tblTest = {
+	AGSI_IDEOGRAM AGSI_FILESYSTEM AGSI_RST,
+	"tbl",
+	N_("Test and benchmark the AG_Tbl(3) hash table"),
+	"1.7.0",
+	0,
+	sizeof(MyTestInstance),
+	Init,
+	Destroy,
+	Test,
+	NULL,		/* testGUI */
+	Bench
+};
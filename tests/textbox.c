@@ -294,6 +294,185 @@ TestGUI(void *obj, AG_Window *win)
 	return (0);
 }
 
+/*
+ * Verify that the line index of AG_Editable(3), as updated incrementally
+ * following edits, agrees with the line index rebuilt from scratch.
+ */
+static int
+CheckLines(void *obj, AG_Editable *ed, const char *what)
+{
+	AG_EditableBuffer *buf;
+	int *pos, i, nLines, p;
+
+	if ((buf = AG_EditableGetBuffer(ed)) == NULL) {
+		return (-1);
+	}
+	AG_EditableMapPosition(ed, buf, 0, 1, &p);        /* Update index */
+	nLines = (int)ed->idx.n;
+	pos = Malloc(nLines*sizeof(int));
+	for (i = 0; i < nLines; i++) {
+		AG_EditableMapPosition(ed, buf, 0, i*ed->lineSkip + 1, &pos[i]);
+	}
+	ed->idx.n = 0;                                     /* Force rebuild */
+	AG_EditableMapPosition(ed, buf, 0, 1, &p);
+	if ((int)ed->idx.n != nLines) {
+		TestMsg(obj, "%s: %d lines (expected %u)", what, nLines,
+		    ed->idx.n);
+		goto fail;
+	}
+	for (i = 0; i < nLines; i++) {
+		AG_EditableMapPosition(ed, buf, 0, i*ed->lineSkip + 1, &p);
+		if (p != pos[i]) {
+			TestMsg(obj, "%s: line %d starts at %d (expected %d)",
+			    what, i, pos[i], p);
+			goto fail;
+		}
+	}
+	AG_EditableReleaseBuffer(ed, buf);
+	Free(pos);
+	return (0);
+fail:
+	AG_EditableReleaseBuffer(ed, buf);
+	Free(pos);
+	return (-1);
+}
+
+/* Paste s at position pos through an internal clipboard. */
+static void
+PasteAt(AG_Editable *ed, AG_EditableClipboard *cb, int pos, const char *s)
+{
+	AG_EditableBuffer *buf;
+	AG_Char *ucs;
+	AG_Size len;
+
+	if ((ucs = AG_ImportUnicode("UTF-8", s, &len, NULL)) == NULL) {
+		return;
+	}
+	if ((buf = AG_EditableGetBuffer(ed)) != NULL) {
+		AG_EditableCopyChunk(ed, cb, ucs, len);
+		AG_EditableSetCursorPos(ed, buf, pos);
+		AG_EditablePaste(ed, buf, cb, 1);
+		AG_EditableReleaseBuffer(ed, buf);
+	}
+	Free(ucs);
+}
+
+/* Delete the characters in [start,end). */
+static void
+DeleteRange(AG_Editable *ed, int start, int end)
+{
+	AG_EditableBuffer *buf;
+
+	if ((buf = AG_EditableGetBuffer(ed)) != NULL) {
+		ed->selStart = start;
+		ed->selEnd = end;
+		AG_EditableDelete(ed, buf);
+		AG_EditableReleaseBuffer(ed, buf);
+	}
+}
+
+static int
+TestEdits(void *obj, AG_Editable *ed, AG_EditableClipboard *cb,
+    const char *sOrig, const char *what)
+{
+	char sUndo[16384];
+	AG_EditableBuffer *buf;
+	char msg[64];
+	int i;
+
+	PasteAt(ed, cb, 0, "Inserted first line\n");
+	PasteAt(ed, cb, 500, "XYZ\nlonger inserted words ");
+	PasteAt(ed, cb, 1000, "\x1b[31mred\n\nmore red\x1b[0m plain ");
+	PasteAt(ed, cb, -1, "\nAppended\n");
+	DeleteRange(ed, 200, 300);
+	DeleteRange(ed, 10, 11);
+	Snprintf(msg, sizeof(msg), "%s (edits)", what);
+	if (CheckLines(obj, ed, msg) == -1)
+		return (-1);
+
+	if ((buf = AG_EditableGetBuffer(ed)) == NULL) {
+		return (-1);
+	}
+	for (i = 0; i < 6; i++) {
+		AG_EditableUndo(ed, buf);
+	}
+	AG_ExportUnicode("UTF-8", sUndo, buf->s, sizeof(sUndo));
+	AG_EditableReleaseBuffer(ed, buf);
+	if (strcmp(sUndo, sOrig) != 0) {
+		TestMsg(obj, "%s: Undo did not restore the original text", what);
+		return (-1);
+	}
+	Snprintf(msg, sizeof(msg), "%s (undo)", what);
+	return CheckLines(obj, ed, msg);
+}
+
+static int
+Test(void *obj)
+{
+	AG_EditableClipboard cb;
+	AG_EditableBuffer *buf;
+	AG_Window *win;
+	AG_Textbox *tb;
+	AG_Editable *ed;
+	char *text, *s, *sOrig;
+	const AG_Size size = 64000;
+	AG_Char ch;
+	int i, rv = -1;
+
+	if ((win = AG_WindowNew(0)) == NULL) {
+		TestMsg(obj, "AG_WindowNew: %s", AG_GetError());
+		return (-1);
+	}
+	text = Malloc(size);
+	for (i = 0, s = text; i < 300; i++) {
+		s += Snprintf(s, 80, "Line %d: the quick brown fox jumps\n", i);
+	}
+	sOrig = Strdup(text);
+
+	memset(&cb, 0, sizeof(cb));
+	AG_MutexInitRecursive(&cb.lock);
+
+	tb = AG_TextboxNew(win, AG_TEXTBOX_MULTILINE | AG_TEXTBOX_EXPAND, NULL);
+	AG_TextboxBindUTF8(tb, text, size);
+	ed = tb->ed;
+
+	if (CheckLines(obj, ed, "initial") == -1 ||
+	    TestEdits(obj, ed, &cb, sOrig, "no wrap") == -1)
+		goto out;
+
+	Strlcpy(text, "Changed externally\nby the application",
+	    (AG_Size)size);
+	if (CheckLines(obj, ed, "external change") == -1 ||
+	    ed->idx.n != 2) {
+		TestMsgS(obj, "External change was not detected");
+		goto out;
+	}
+	text[0] = 'X';                      /* Change preserving the length */
+	if ((buf = AG_EditableGetBuffer(ed)) == NULL) {
+		goto out;
+	}
+	ch = buf->s[0];
+	AG_EditableReleaseBuffer(ed, buf);
+	if (ch != 'X') {
+		TestMsgS(obj, "External change of same length was not detected");
+		goto out;
+	}
+	Strlcpy(text, sOrig, size);
+	AG_TextboxSetWordWrap(tb, 1);
+	if (CheckLines(obj, ed, "word wrap") == -1 ||
+	    TestEdits(obj, ed, &cb, sOrig, "word wrap") == -1)
+		goto out;
+
+	rv = 0;
+out:
+	AG_ObjectDetach(win);
+	AG_MutexDestroy(&cb.lock);
+	Free(cb.s);
+	Free(sOrig);
+	Free(text);
+	return (rv);
+}
+
 const AG_TestCase textboxTest = {
 	AGSI_IDEOGRAM AGSI_TEXTBOX AGSI_RST,
 	"textbox",
@@ -303,7 +482,7 @@ const AG_TestCase textboxTest = {
 	sizeof(AG_TestInstance),
 	NULL,		/* init */
 	NULL,		/* destroy */
-	NULL,		/* test */
+	Test,
 	TestGUI,
 	NULL		/* bench */
 };
@@ -5,11 +5,16 @@
 #include "agartest.h"
 #ifdef AG_TIMERS
 
+#define NTESTTIMERS 64
+
 typedef struct {
 	AG_TestInstance _inherit;
 	AG_Timer to[3], toReg;
 	AG_Window *win;
 	Uint tick, period;
+	AG_Timer toTest[NTESTTIMERS];		/* For Test() */
+	int fired[NTESTTIMERS];			/* Expired timers (in order) */
+	int nFired;
 } MyTestInstance;
 
 static Uint32
@@ -80,6 +85,242 @@ StopPeriodic(AG_Event *event)
 	AG_DelTimer(ti->win, &ti->toReg);
 }
 
+/*
+ * The non-interactive test runs the software timer heap on a simulated
+ * clock. It starts 2^30 ticks behind the real clock, so the test timers
+ * expire before any other timer in the heap (and those never expire).
+ */
+static Uint32 fakeTicks;
+
+static Uint32 FakeGetTicks(void) { return (fakeTicks); }
+static void   FakeDelay(Uint32 t) { fakeTicks += t; }
+
+static const AG_TimeOps fakeTimeOps = {
+	"fake",
+	NULL,		/* init */
+	NULL,		/* destroy */
+	FakeGetTicks,
+	FakeDelay
+};
+
+static Uint32
+RecordExpiration(AG_Timer *to, AG_Event *event)
+{
+	MyTestInstance *ti = AG_PTR(1);
+	const int i = AG_INT(2);
+
+	ti->fired[ti->nFired++] = i;
+	return (0);
+}
+
+static Uint32
+RecordPeriodic(AG_Timer *to, AG_Event *event)
+{
+	MyTestInstance *ti = AG_PTR(1);
+	const int i = AG_INT(2);
+
+	ti->fired[ti->nFired++] = i;
+	return (to->ival);
+}
+
+/* Start test timer i to expire in ival ticks. */
+static int
+StartTestTimer(MyTestInstance *ti, AG_Object *ob, int i, Uint32 ival,
+    AG_TimerFn fn)
+{
+	if (AG_AddTimer(ob, &ti->toTest[i], ival, fn, "%p,%i", ti, i) == -1) {
+		TestMsg(ti, "AddTimer: %s", AG_GetError());
+		return (-1);
+	}
+	return (0);
+}
+
+/* Advance the clock by t ticks and process expired timers. */
+static void
+Advance(MyTestInstance *ti, Uint32 t)
+{
+	fakeTicks += t;
+	AG_ProcessTimeouts(fakeTicks);
+}
+
+/*
+ * Check that the timers which expired since the last call are exactly
+ * those in order[] (in order) and that the next one is due in tNext ticks.
+ */
+static int
+CheckFired(MyTestInstance *ti, const char *what, const int *order, int n,
+    Uint32 tNext)
+{
+	Uint32 tNextActual = AG_NextTimeout(fakeTicks);
+	int i;
+
+	if (tNextActual > NTESTTIMERS*2) {
+		tNextActual = AG_TIMEOUT_NONE;    /* Timers not under test */
+	}
+	for (i = 0; i < n; i++) {
+		if (i >= ti->nFired || ti->fired[i] != order[i])
+			break;
+	}
+	if (i < n || ti->nFired != n || tNextActual != tNext) {
+		TestMsg(ti, "%s: %d timers expired (expected %d, first "
+		            "mismatch at %d); next in %u ticks (expected %u)",
+		    what, ti->nFired, n, i, (Uint)tNextActual, (Uint)tNext);
+		return (-1);
+	}
+	ti->nFired = 0;
+	return (0);
+}
+
+/* Timers expire in order of their expiration times. */
+static int
+TestOrder(MyTestInstance *ti, AG_Object *ob)
+{
+	int order[NTESTTIMERS];
+	int i;
+
+	for (i = 0; i < NTESTTIMERS; i++) {     /* Start in shuffled order */
+		const int ival = 1 + (i*37) % NTESTTIMERS;
+
+		if (StartTestTimer(ti, ob, i, ival, RecordExpiration) == -1) {
+			return (-1);
+		}
+		order[ival-1] = i;
+	}
+	if (CheckFired(ti, "Order", NULL, 0, 1) == -1) {
+		return (-1);
+	}
+	Advance(ti, NTESTTIMERS/2);
+	if (CheckFired(ti, "Order", &order[0], NTESTTIMERS/2, 1) == -1) {
+		return (-1);
+	}
+	Advance(ti, NTESTTIMERS/2);
+	return CheckFired(ti, "Order", &order[NTESTTIMERS/2], NTESTTIMERS/2,
+	    AG_TIMEOUT_NONE);
+}
+
+/* AG_ResetTimer() can move a timer earlier or later. */
+static int
+TestReset(MyTestInstance *ti, AG_Object *ob)
+{
+	static const int order[] = { 2, 1, 0 };
+
+	if (StartTestTimer(ti, ob, 0, 10, RecordExpiration) == -1 ||
+	    StartTestTimer(ti, ob, 1, 20, RecordExpiration) == -1 ||
+	    StartTestTimer(ti, ob, 2, 30, RecordExpiration) == -1) {
+		return (-1);
+	}
+	AG_ResetTimer(ob, &ti->toTest[2], 5);               /* Earlier */
+	AG_ResetTimer(ob, &ti->toTest[0], 40);              /* Later */
+	if (CheckFired(ti, "Reset", NULL, 0, 5) == -1) {
+		return (-1);
+	}
+	Advance(ti, 5);
+	if (CheckFired(ti, "Reset", &order[0], 1, 15) == -1) {
+		return (-1);
+	}
+	Advance(ti, 35);
+	return CheckFired(ti, "Reset", &order[1], 2, AG_TIMEOUT_NONE);
+}
+
+/* AG_DelTimer() cancels timers other than the next one to expire. */
+static int
+TestDelete(MyTestInstance *ti, AG_Object *ob)
+{
+	static const int order[] = { 0, 2 };
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		if (StartTestTimer(ti, ob, i, (i+1)*10, RecordExpiration) == -1)
+			return (-1);
+	}
+	AG_DelTimer(ob, &ti->toTest[1]);
+	AG_DelTimer(ob, &ti->toTest[3]);
+	if (AG_TimerIsRunning(ob, &ti->toTest[1]) ||
+	    AG_TimerIsRunning(ob, &ti->toTest[3]) ||
+	    !AG_TimerIsRunning(ob, &ti->toTest[2])) {
+		TestMsgS(ti, "Delete: Bad timer state");
+		return (-1);
+	}
+	if (CheckFired(ti, "Delete", NULL, 0, 10) == -1) {
+		return (-1);
+	}
+	Advance(ti, 40);
+	return CheckFired(ti, "Delete", order, 2, AG_TIMEOUT_NONE);
+}
+
+/* Periodic timers restart until stopped and may be started again. */
+static int
+TestStartStop(MyTestInstance *ti, AG_Object *ob)
+{
+	static const int order[] = { 0, 0, 0 };
+
+	if (StartTestTimer(ti, ob, 0, 10, RecordPeriodic) == -1) {
+		return (-1);
+	}
+	Advance(ti, 10);
+	Advance(ti, 10);
+	Advance(ti, 10);
+	if (CheckFired(ti, "Periodic", order, 3, 10) == -1) {
+		return (-1);
+	}
+	AG_DelTimer(ob, &ti->toTest[0]);
+	Advance(ti, 20);
+	if (CheckFired(ti, "Stopped", NULL, 0, AG_TIMEOUT_NONE) == -1) {
+		return (-1);
+	}
+	if (StartTestTimer(ti, ob, 0, 10, RecordExpiration) == -1) {
+		return (-1);
+	}
+	Advance(ti, 10);
+	if (CheckFired(ti, "Restarted", order, 1, AG_TIMEOUT_NONE) == -1) {
+		return (-1);
+	}
+	if (AG_TimerIsRunning(ob, &ti->toTest[0])) {
+		TestMsgS(ti, "Restarted: One-shot timer still running");
+		return (-1);
+	}
+	return (0);
+}
+
+static int
+Test(void *obj)
+{
+	MyTestInstance *ti = obj;
+	const AG_TimeOps *timeOpsSave;
+	AG_Object ob;
+	int i, rv;
+
+	if (AG_GetEventSource()->caps[AG_SINK_TIMER]) {
+		TestMsgS(ti, "Not using software timers (run agartest -W)");
+		return (0);
+	}
+	for (i = 0; i < NTESTTIMERS; i++) {
+		AG_InitTimer(&ti->toTest[i], "testTimer", 0);
+	}
+	ti->nFired = 0;
+	AG_ObjectInitStatic(&ob, NULL);
+
+	AG_LockTiming();
+	timeOpsSave = agTimeOps;
+	fakeTicks = AG_GetTicks() - (1U << 30);
+	agTimeOps = &fakeTimeOps;
+
+	rv = (TestOrder(ti, &ob) == 0 &&
+	      TestReset(ti, &ob) == 0 &&
+	      TestDelete(ti, &ob) == 0 &&
+	      TestStartStop(ti, &ob) == 0) ? 0 : -1;
+
+	AG_DelTimers(&ob);
+	agTimeOps = timeOpsSave;
+	AG_UnlockTiming();
+
+	AG_ObjectDestroy(&ob);
+	if (rv == 0) {
+		TestMsgS(ti, "Software timers: OK");
+	}
+	return (rv);
+}
+
 static int
 Init(void *obj)
 {
@@ -143,7 +384,7 @@ const AG_TestCase timeoutsTest = {
 	sizeof(MyTestInstance),
 	Init,
 	NULL,
-	NULL,		/* test */
+	Test,
 	TestGUI,
 	NULL		/* bench */
 };
@@ -0,0 +1,368 @@
+/*	Public domain	*/
+/*
+ * Test and benchmark the AG_Tlist(3) draw path, comparing the default
+ * mode against AG_TLIST_VIRTUAL on lists of 1e3 to 1e6 items, and the
+ * repopulation of polled lists (AG_TlistBegin() / AG_TlistEnd()) with
+ * and without a hash function.
+ */
+
+#include "agartest.h"
+
+#define NSIZES 4			/* 1e3, 1e4, 1e5, 1e6 items */
+#define TLIST_W 320			/* Size of the benchmarked lists (px) */
+#define TLIST_H 480
+#define NSIZES_POLL 3			/* 1e3, 1e4, 1e5 items */
+#define POLL_LINEAR_MAX 10000		/* Largest list for unhashed restore */
+
+typedef struct {
+	AG_TestInstance _inherit;
+	AG_Window *_Nullable win;	/* Offscreen parent window */
+	AG_Tlist *_Nullable tl;		/* Default list */
+	AG_Tlist *_Nullable tlVirt;	/* VIRTUAL list */
+	int nItems;			/* Current benchmark size */
+	int scroll;			/* Scroll on every redraw */
+	int *_Nullable data;		/* Objects referenced by polled items */
+} MyTestInstance;
+
+static const int benchSizes[NSIZES] = { 1000, 10000, 100000, 1000000 };
+static const int benchSizesPoll[NSIZES_POLL] = { 1000, 10000, 100000 };
+
+static int
+Init(void *obj)
+{
+	MyTestInstance *ti = obj;
+
+	ti->win = NULL;
+	ti->tl = NULL;
+	ti->tlVirt = NULL;
+	ti->nItems = 0;
+	ti->scroll = 0;
+	ti->data = NULL;
+	return (0);
+}
+
+static void
+Destroy(void *obj)
+{
+	MyTestInstance *ti = obj;
+
+	if (ti->win != NULL) {
+		AG_ObjectDetach(ti->win);
+	}
+	Free(ti->data);
+}
+
+/*
+ * Repopulate a list the way a "tlist-poll" handler would, with items
+ * referencing the objects in ti->data.
+ */
+static void
+Repopulate(MyTestInstance *ti, AG_Tlist *tl)
+{
+	int i;
+
+	AG_TlistBegin(tl);
+	for (i = 0; i < ti->nItems; i++) {
+		AG_TlistAddPtr(tl, NULL, "Object", &ti->data[i]);
+	}
+	AG_TlistEnd(tl);
+}
+
+/* Test the restore of the selection state in polled lists. */
+static int
+TestPolled(MyTestInstance *ti, AG_TlistHashFn hashFn)
+{
+	AG_Tlist *tl;
+	AG_TlistItem *it, *itFirst;
+	int i, rv = -1;
+
+	ti->nItems = 1000;
+	ti->data = Malloc(ti->nItems * sizeof(int));
+	tl = AG_TlistNew(NULL, AG_TLIST_MULTI);
+	AG_TlistSetHashFn(tl, hashFn);
+	Repopulate(ti, tl);
+	i = 0;
+	AG_TLIST_FOREACH(it, tl) {
+		it->selected = ((i++ % 10) == 0);
+	}
+	itFirst = AG_TlistFirstItem(tl);
+	Repopulate(ti, tl);
+	if (AG_TlistFirstItem(tl) != itFirst) {
+		TestMsgS(ti, "Items were not recycled");
+		goto out;
+	}
+	i = 0;
+	AG_TLIST_FOREACH(it, tl) {
+		if (it->selected != ((i % 10) == 0)) {
+			TestMsg(ti, "Selection of item %d not restored", i);
+			goto out;
+		}
+		i++;
+	}
+	if (i != ti->nItems || !AG_TAILQ_EMPTY(&tl->pool)) {
+		TestMsg(ti, "Repopulated list has %d items", i);
+		goto out;
+	}
+	ti->nItems = 100;                            /* Shrink the list */
+	Repopulate(ti, tl);
+	if (tl->nItems != 100 || !AG_TAILQ_EMPTY(&tl->pool)) {
+		TestMsgS(ti, "Shrunk list has leftover items");
+		goto out;
+	}
+	rv = 0;
+out:
+	AG_ObjectDestroy(tl);
+	Free(ti->data);
+	ti->data = NULL;
+	return (rv);
+}
+
+/* Create a list of nItems items in the offscreen window. */
+static AG_Tlist *
+CreateList(MyTestInstance *ti, Uint flags, int nItems)
+{
+	AG_Tlist *tl;
+	AG_SizeAlloc a;
+	int i;
+
+	tl = AG_TlistNew(ti->win, flags);
+	for (i = 0; i < nItems; i++) {
+		AG_TlistAdd(tl, NULL, "Item #%d", i);
+	}
+	a.x = 0;
+	a.y = 0;
+	a.w = TLIST_W;
+	a.h = TLIST_H;
+	AG_WidgetSizeAlloc(tl, &a);
+	AG_WidgetUpdateCoords(tl, 0, 0);
+	AG_WidgetShowAll(tl);         /* The parent window remains hidden */
+	return (tl);
+}
+
+static void
+DrawList(AG_Tlist *tl)
+{
+	AG_Driver *drv = AGWIDGET(tl)->drv;
+
+	AG_ObjectLock(tl);
+	AG_BeginRendering(drv);
+	AG_WidgetDraw(tl);
+	AG_EndRendering(drv);
+	AG_ObjectUnlock(tl);
+}
+
+/* Return the number of items which have a label surface. */
+static int
+CountLabels(AG_Tlist *tl)
+{
+	AG_TlistItem *it;
+	int nLabels = 0;
+
+	AG_TLIST_FOREACH(it, tl) {
+		if (it->label[0] != -1 || it->label[1] != -1 ||
+		    it->label[2] != -1)
+			nLabels++;
+	}
+	return (nLabels);
+}
+
+static int
+Test(void *obj)
+{
+	MyTestInstance *ti = obj;
+	AG_Tlist *tl, *tlVirt;
+	AG_TlistItem *it;
+	int i, nLabels;
+
+	ti->win = AG_WindowNew(0);
+	tl = CreateList(ti, 0, 1000);
+	tlVirt = CreateList(ti, AG_TLIST_VIRTUAL, 1000);
+
+	for (i = 1; i <= 1000; i += 37) {
+		if ((it = AG_TlistFindByIndex(tlVirt, i)) == NULL ||
+		    strcmp(it->text, AG_TlistFindByIndex(tl, i)->text) != 0) {
+			TestMsg(ti, "FindByIndex(%d) failed", i);
+			goto fail;
+		}
+	}
+	tlVirt->rOffs = 500;
+	DrawList(tlVirt);
+	tlVirt->rOffs = 600;
+	DrawList(tlVirt);
+	nLabels = CountLabels(tlVirt);
+	if (nLabels == 0 || nLabels > tlVirt->nVisible + 1) {
+		TestMsg(ti, "VIRTUAL list has %d labels (%d visible)",
+		    nLabels, tlVirt->nVisible);
+		goto fail;
+	}
+	if ((it = AG_TlistFindByIndex(tlVirt, 601)) == NULL ||
+	    it->label[1] == -1) {
+		TestMsgS(ti, "First visible item has no label");
+		goto fail;
+	}
+	AG_TlistDel(tlVirt, AG_TlistFindByIndex(tlVirt, 1));
+	AG_TlistSort(tlVirt);
+	DrawList(tlVirt);
+	if (CountLabels(tlVirt) > tlVirt->nVisible + 1) {
+		TestMsgS(ti, "Labels not released after index rebuild");
+		goto fail;
+	}
+	if (AG_TlistFindByIndex(tlVirt, 1000) != NULL ||
+	    AG_TlistFindByIndex(tlVirt, 999) == NULL) {
+		TestMsgS(ti, "FindByIndex() past the end");
+		goto fail;
+	}
+	AG_ObjectDetach(ti->win);
+	ti->win = NULL;
+
+	if (TestPolled(ti, AG_TlistHashPtrs) == -1 ||
+	    TestPolled(ti, NULL) == -1) {
+		return (-1);
+	}
+	TestMsgS(ti, "AG_Tlist tests OK");
+	return (0);
+fail:
+	AG_ObjectDetach(ti->win);
+	ti->win = NULL;
+	return (-1);
+}
+
+/* Draw the list, scrolling by one page at every call if requested. */
+static __inline__ void
+BenchDraw(MyTestInstance *ti, AG_Tlist *tl)
+{
+	if (ti->scroll) {
+		tl->rOffs += tl->nVisible;
+		if (tl->rOffs + tl->nVisible > tl->nItems)
+			tl->rOffs = 0;
+	}
+	DrawList(tl);
+}
+
+static void DrawDefault(void *ti) { BenchDraw(ti, ((MyTestInstance *)ti)->tl); }
+static void DrawVirtual(void *ti) { BenchDraw(ti, ((MyTestInstance *)ti)->tlVirt); }
+
+static struct ag_benchmark_fn tlistBenchFns[] = {
+	{ "Draw (default)", DrawDefault },
+	{ "Draw (VIRTUAL)", DrawVirtual },
+};
+static struct ag_benchmark tlistBench = {
+	"AG_Tlist",
+	&tlistBenchFns[0],
+	sizeof(tlistBenchFns) / sizeof(tlistBenchFns[0]),
+	4, 10, 0
+};
+
+static void
+RepopulateHashed(void *obj)
+{
+	MyTestInstance *ti = obj;
+
+	Repopulate(ti, ti->tl);
+}
+
+static void
+RepopulateLinear(void *obj)
+{
+	MyTestInstance *ti = obj;
+
+	Repopulate(ti, ti->tlVirt);
+}
+
+static struct ag_benchmark_fn tlistPollBenchFns[] = {
+	{ "Repopulate (hashed)", RepopulateHashed },
+	{ "Repopulate (linear)", RepopulateLinear },
+};
+static struct ag_benchmark tlistPollBench = {
+	"AG_Tlist (polled)",
+	&tlistPollBenchFns[0],
+	sizeof(tlistPollBenchFns) / sizeof(tlistPollBenchFns[0]),
+	4, 10, 0
+};
+static struct ag_benchmark tlistPollBenchHashed = {
+	"AG_Tlist (polled, hashed only)",
+	&tlistPollBenchFns[0],
+	1,
+	4, 10, 0
+};
+
+/*
+ * Repopulate lists with 10% of the items selected, restoring the selection
+ * through the hash index (ti->tl) or by comparisons (ti->tlVirt).
+ */
+static int
+BenchPolled(MyTestInstance *ti)
+{
+	AG_TlistItem *it;
+	int sz, i;
+
+	for (sz = 0; sz < NSIZES_POLL; sz++) {
+		ti->nItems = benchSizesPoll[sz];
+		ti->data = Malloc(ti->nItems * sizeof(int));
+		ti->tl = AG_TlistNew(NULL, AG_TLIST_MULTI);
+		ti->tlVirt = AG_TlistNew(NULL, AG_TLIST_MULTI);
+		AG_TlistSetHashFn(ti->tlVirt, NULL);
+		Repopulate(ti, ti->tl);
+		Repopulate(ti, ti->tlVirt);
+		i = 0;
+		AG_TLIST_FOREACH(it, ti->tl) {
+			it->selected = ((i++ % 10) == 0);
+		}
+		i = 0;
+		AG_TLIST_FOREACH(it, ti->tlVirt) {
+			it->selected = ((i++ % 10) == 0);
+		}
+		TestMsg(ti, "%d items, %d selected (clks per repopulation):",
+		    ti->nItems, ti->nItems/10);
+		TestExecBenchmark(ti, (ti->nItems > POLL_LINEAR_MAX) ?
+		    &tlistPollBenchHashed : &tlistPollBench);
+
+		AG_ObjectDestroy(ti->tl);
+		AG_ObjectDestroy(ti->tlVirt);
+		Free(ti->data);
+		ti->data = NULL;
+	}
+	return (0);
+}
+
+static int
+Bench(void *obj)
+{
+	MyTestInstance *ti = obj;
+	int sz;
+
+	ti->win = AG_WindowNew(0);
+
+	for (sz = 0; sz < NSIZES; sz++) {
+		ti->nItems = benchSizes[sz];
+		ti->tl = CreateList(ti, 0, ti->nItems);
+		ti->tlVirt = CreateList(ti, AG_TLIST_VIRTUAL, ti->nItems);
+
+		for (ti->scroll = 0; ti->scroll < 2; ti->scroll++) {
+			TestMsg(ti, "%d items%s (clks per redraw):", ti->nItems,
+			    ti->scroll ? ", scrolling" : "");
+			TestExecBenchmark(obj, &tlistBench);
+		}
+		AG_ObjectDetach(ti->tl);
+		AG_ObjectDestroy(ti->tl);
+		AG_ObjectDetach(ti->tlVirt);
+		AG_ObjectDestroy(ti->tlVirt);
+	}
+	AG_ObjectDetach(ti->win);
+	ti->win = NULL;
+	return BenchPolled(ti);
+}
+
+const AG_TestCase tlistTest = {
+	AGSI_IDEOGRAM AGSI_FILESYSTEM AGSI_RST,
+	"tlist",
+	N_("Test and benchmark the AG_Tlist(3) draw path and polled mode"),
+	"1.7.0",
+	0,
+	sizeof(MyTestInstance),
+	Init,
+	Destroy,
+	Test,
+	NULL,		/* testGUI */
+	Bench
+};
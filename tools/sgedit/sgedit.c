@@ -27,9 +27,12 @@
  * General-purpose editor application for FreeSG objects.
  */
 
+#define _USE_SG_GL				/* For glFinish() */
+
 #include <agar/core.h>
 #include <agar/gui.h>
 #include <agar/sg.h>
+#include <agar/sg/sg_load_ply.h>
 
 #include <agar/config/have_pthreads.h>
 #include <agar/config/have_clock_gettime.h>
@@ -51,15 +54,153 @@ Quit(AG_Event *event)
 static void
 PrintUsage(void)
 {
-	printf("%s [-3SRTEMvDs] [-d agardrv] [-t font] [-e eyesep] [file ...]\n",
-	    agProgName);
+	printf("%s [-3SRTEMvDsB] [-d agardrv] [-t font] [-e eyesep] "
+	       "[-n frames] [file ...]\n", agProgName);
+}
+
+/* SG_Object rendering modes compared by the benchmark. */
+static const struct {
+	const char *name;
+	Uint flags;
+} benchModes[] = {
+	{ "immediate",     SG_OBJECT_IMMEDIATE },
+	{ "client arrays", SG_OBJECT_NO_BUFFERS },
+	{ "buffers",       0 }
+};
+
+static void
+BenchProcessEvents(void)
+{
+	AG_DriverEvent dev;
+
+	while (AG_PendingEvents(NULL) > 0) {
+		if (AG_GetNextEvent(NULL, &dev) == 1)
+			AG_ProcessEvent(NULL, &dev);
+	}
+	AG_WindowProcessQueued();
+}
+
+/* Render one frame of a window and return the rendering time in ns. */
+static Uint64
+BenchFrame(AG_Window *win)
+{
+	AG_Driver *drv = AGWIDGET(win)->drv;
+	Uint64 t0, t;
+
+	AG_LockVFS(&agDrivers);
+	AG_ObjectLock(win);
+	AG_BeginRendering(drv);
+	t0 = AG_PerfTime();
+	AG_WindowDraw(win);
+	glFinish();
+	t = AG_PerfTime() - t0;
+	AG_EndRendering(drv);
+	AG_ObjectUnlock(win);
+	AG_UnlockVFS(&agDrivers);
+	return (t);
+}
+
+/*
+ * Frame-time benchmark. Import a PLY mesh and render it nFrames times
+ * in each of the SG_Object rendering modes. The buffer swap is excluded
+ * from the measurement so that the results are not bound to vsync.
+ */
+static int
+Benchmark(const char *path, int nFrames)
+{
+	SG *sg;
+	SG_Object *so;
+	SG_View *sv;
+	AG_Window *win;
+	M_Vector3 vMin, vMax, c;
+	M_Real r;
+	Uint64 t0, tSum, tMin, tMax, t;
+	Uint i, nTris = 0, fi;
+	SG_Facet *f;
+	int m, frame;
+
+	sg = SG_New(NULL, "benchmark", 0);
+	so = SG_ObjectNew(sg->root, "mesh");
+	so->flags |= SG_OBJECT_STATIC;
+
+	t0 = AG_PerfTime();
+	if (SG_ObjectLoadPLY(so, path, SG_PLY_LOAD_VTX_NORMALS |
+	                               SG_PLY_LOAD_VTX_COLORS) == -1) {
+		AG_ObjectDetach(so);
+		AG_ObjectDestroy(so);
+		return (-1);
+	}
+	SG_FOREACH_FACET(f, fi, so) {
+		nTris += (f->n == 4) ? 2 : 1;
+	}
+	printf("%s: %u vertices, %u triangles (loaded in %.1f ms)\n", path,
+	    so->nVtx - 1, nTris, (double)(AG_PerfTime() - t0) / 1e6);
+
+	/* Fit the mesh into the view of the default camera. */
+	if (so->nVtx > 1) {
+		vMin = vMax = so->vtx[1].v;
+		for (i = 2; i < so->nVtx; i++) {
+			const M_Vector3 *v = &so->vtx[i].v;
+
+			if (v->x < vMin.x) { vMin.x = v->x; }
+			if (v->y < vMin.y) { vMin.y = v->y; }
+			if (v->z < vMin.z) { vMin.z = v->z; }
+			if (v->x > vMax.x) { vMax.x = v->x; }
+			if (v->y > vMax.y) { vMax.y = v->y; }
+			if (v->z > vMax.z) { vMax.z = v->z; }
+		}
+		c = M_VecLERP3(vMin, vMax, 0.5);
+		r = M_VecDistance3(vMin, vMax) / 2.0;
+		if (r > 0.0) {
+			SG_Scale(so, 3.0 / r);
+			SG_Translatev(so, M_VecScale3(c, -1.0));
+		}
+	}
+
+	win = AG_WindowNew(AG_WINDOW_MAIN);
+	AG_WindowSetCaption(win, "sgedit: %s", path);
+	sv = SG_ViewNew(win, sg, SG_VIEW_EXPAND);
+	AG_WindowSetGeometryAligned(win, AG_WINDOW_MC, 800, 600);
+	AG_WindowShow(win);
+	BenchProcessEvents();
+
+	for (m = 0; m < (int)(sizeof(benchModes)/sizeof(benchModes[0])); m++) {
+		so->flags &= ~(SG_OBJECT_IMMEDIATE | SG_OBJECT_NO_BUFFERS);
+		so->flags |= benchModes[m].flags;
+
+		t = BenchFrame(win);			/* Warm up (and upload) */
+		tSum = 0;
+		tMin = (Uint64)-1;
+		tMax = 0;
+		for (frame = 0; frame < nFrames; frame++) {
+			t = BenchFrame(win);
+			tSum += t;
+			if (t < tMin) { tMin = t; }
+			if (t > tMax) { tMax = t; }
+			BenchProcessEvents();
+		}
+		printf("%-16s %8.2f ms/frame (min %.2f, max %.2f)\n",
+		    benchModes[m].name,
+		    (double)tSum / nFrames / 1e6,
+		    (double)tMin / 1e6,
+		    (double)tMax / 1e6);
+	}
+	(void)sv;
+	AG_ObjectDetach(win);
+	while (!AG_TAILQ_EMPTY(&agWindowDetachQ)) {	/* Hide, then detach */
+		AG_WindowProcessDetachQueue();
+	}
+	AG_ObjectDetach(so);
+	AG_ObjectDestroy(so);
+	return (0);
 }
 
 int
 main(int argc, char *argv[])
 {
 	char driverSpec[128];
-	int i, j, debug = 0, forceScalar = 0, forceStereo = 0;
+	int i, j, debug = 0, forceScalar = 0, forceStereo = 0, bench = 0;
+	int benchFrames = 100;
 	const char *fontSpec = NULL;
 	char *optArg = NULL;
 	int optInd, c;
@@ -77,7 +218,7 @@ main(int argc, char *argv[])
 		fprintf(stderr, "%s\n", AG_GetError());
 		return (1);
 	}
-	while ((c = AG_Getopt(argc, argv, "3SRTEMvDsd:t:e:?hp:", &optArg, &optInd)) != -1) {
+	while ((c = AG_Getopt(argc, argv, "3SRTEMvDsBd:t:e:n:?hp:", &optArg, &optInd)) != -1) {
 		switch (c) {
 		case '3':
 			forceStereo = 1;
@@ -107,6 +248,13 @@ main(int argc, char *argv[])
 		case 'e':
 			sgEyeSeparation = (M_Real)strtod(optArg, NULL);
 			break;
+		case 'B':
+			bench = 1;
+			break;
+		case 'n':
+			benchFrames = atoi(optArg);
+			if (benchFrames < 1) { benchFrames = 1; }
+			break;
 		case 'p':
 			break;
 		default:
@@ -156,6 +304,22 @@ main(int argc, char *argv[])
 		mMatOps44 = &mMatOps44_FPU;
 	}
 
+	if (bench) {
+		if (optInd == argc) {
+			AG_Verbose("-B: no input mesh (*.ply) specified\n");
+			goto fail;
+		}
+		for (i = optInd; i < argc; i++) {
+			if (Benchmark(argv[i], benchFrames) == -1) {
+				AG_Verbose("%s: %s\n", argv[i], AG_GetError());
+				goto fail;
+			}
+		}
+		AG_DestroyGraphics();
+		AG_Destroy();
+		return (0);
+	}
+
 	if (newObj != '\0') {
 		void *cls = NULL;
 